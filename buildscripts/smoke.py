@@ -666,6 +666,7 @@ at the end of testing:"""
 suiteGlobalConfig = {"js": ("[!_]*.js", True),
                      "quota": ("quota/*.js", True),
                      "jsPerf": ("perf/*.js", True),
+                     "benchmarks": ("benchmarks/*.js", False),
                      "disk": ("disk/*.js", True),
                      "jsSlowNightly": ("slowNightly/*.js", True),
                      "jsSlowWeekly": ("slowWeekly/*.js", False),
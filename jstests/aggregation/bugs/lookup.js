@@ -0,0 +1,63 @@
+// $lookup joins documents to those of another collection; the hash join and the index lookups
+// it falls back to for a large indexed foreign side give the same results.
+
+load('jstests/aggregation/extras/utils.js');
+
+var orders = db.lookup_orders;
+var items = db.lookup_items;
+orders.drop();
+items.drop();
+
+for (var i = 0; i < 20; i++) {
+    items.save({ _id: i, sku: i % 5, status: (i % 2 == 0 ? "active" : "retired"), pad: "x" });
+}
+items.save({ _id: 20, status: "active" });
+orders.save({ _id: 0, sku: 1 });
+orders.save({ _id: 1, sku: 4 });
+orders.save({ _id: 2, sku: 7 });
+orders.save({ _id: 3 });
+
+function joined(spec) {
+    var res = orders.aggregate({ $lookup: spec }, { $sort: { _id: 1 } });
+    assert.commandWorked(res);
+    return res.result.map(function(doc) {
+        return doc.items.map(function(item) { return item._id; }).sort(function(a, b) {
+            return a - b;
+        });
+    });
+}
+
+function check() {
+    assert.eq([[1, 6, 11, 16], [4, 9, 14, 19], [], [20]],
+              joined({ from: "lookup_items", localField: "sku", foreignField: "sku",
+                       as: "items" }));
+
+    // filtered and projected foreign side
+    var spec = { from: "lookup_items", localField: "sku", foreignField: "sku", as: "items",
+                 query: { status: "active" }, fields: { status: 1 } };
+    assert.eq([[6, 16], [4, 14], [], [20]], joined(spec));
+    var res = orders.aggregate({ $match: { _id: 1 } }, { $lookup: spec });
+    assert.eq([{ _id: 4, sku: 4, status: "active" }, { _id: 14, sku: 4, status: "active" }],
+              res.result[0].items);
+}
+
+check();
+
+// too big for a hash join, and no index to look up by
+assert.commandWorked(db.adminCommand({ setParameter: 1, internalLookupHashJoinMaxBytes: 100 }));
+assertErrorCode(orders, { $lookup: { from: "lookup_items", localField: "sku",
+                                     foreignField: "sku", as: "items" } }, 17026);
+
+items.ensureIndex({ sku: 1 });
+check();
+assert.commandWorked(db.adminCommand({ setParameter: 1,
+                                       internalLookupHashJoinMaxBytes: 32 * 1024 * 1024 }));
+check();
+
+// bad specs
+assertErrorCode(orders, { $lookup: "lookup_items" }, 17021);
+assertErrorCode(orders, { $lookup: { from: "lookup_items", localField: "sku", as: "items" } },
+                17022);
+assertErrorCode(orders, { $lookup: { from: "lookup_items", localField: "sku",
+                                     foreignField: "sku", as: "items", fields: { sku: 0 } } },
+                17025);
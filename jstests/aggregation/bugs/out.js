@@ -0,0 +1,41 @@
+// $out replaces a collection with the pipeline's documents, keeping the collection's indexes.
+
+load('jstests/aggregation/extras/utils.js');
+
+var input = db.out_input;
+var output = db.out_output;
+input.drop();
+output.drop();
+
+for (var i = 0; i < 1000; i++) {
+    input.save({ _id: i, a: i % 10, pad: "x" });
+}
+
+// creates the output collection
+var res = input.aggregate({ $group: { _id: "$a", n: { $sum: 1 } } }, { $out: "out_output" });
+assert.commandWorked(res);
+assert.eq([], res.result);
+assert.eq(10, output.count());
+assert.eq({ _id: 3, n: 100 }, output.findOne({ _id: 3 }));
+
+// replaces its documents, keeping its indexes
+output.ensureIndex({ n: 1 });
+output.save({ _id: "stale" });
+res = input.aggregate({ $match: { a: 1 } }, { $project: { n: "$_id" } }, { $out: "out_output" });
+assert.commandWorked(res);
+assert.eq(100, output.count());
+assert.eq(null, output.findOne({ _id: "stale" }));
+assert.eq(2, output.getIndexes().length);
+assert.eq(1, output.find({ n: 51 }).hint({ n: 1 }).itcount());
+
+// a failed $out leaves the output collection as it was
+assertErrorCode(input, [{ $project: { _id: "$a" } }, { $out: "out_output" }], 17033);
+assert.eq(100, output.count());
+assert.eq(0, db.getCollectionNames().filter(function(name) {
+    return name.indexOf("tmp.agg_out.") == 0;
+}).length);
+
+// bad specs
+assertErrorCode(input, [{ $out: "out_output" }, { $match: {} }], 17030);
+assertErrorCode(input, { $out: 1 }, 17031);
+assertErrorCode(input, { $out: "system.out" }, 17031);
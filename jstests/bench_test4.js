@@ -0,0 +1,30 @@
+// benchRun latency percentiles, open loop rate and warmup
+
+t = db.bench_test4;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } )
+
+ops = [
+    { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } } ,
+    { op : "update" , ns : t.getFullName() , query : { _id : 1 } , update : { $inc : { x : 1 } } }
+]
+
+benchArgs = { ops : ops , parallel : 2 , seconds : 1 , warmupSeconds : .5 ,
+              opsPerSecond : 200 , host : db.getMongo().host };
+
+if (jsTest.options().auth) {
+    benchArgs['db'] = 'admin';
+    benchArgs['username'] = jsTest.options().adminUser;
+    benchArgs['password'] = jsTest.options().adminPassword;
+}
+res = benchRun( benchArgs );
+
+assert( res.findOneLatencyMicros , "A1 " + tojson( res ) )
+assert( res.updateLatencyMicros , "A2 " + tojson( res ) )
+assert.lte( res.findOneLatencyMicros.p50 , res.findOneLatencyMicros.p99 , "A3" )
+assert.lte( res.findOneLatencyMicros.p99 , res.findOneLatencyMicros.p999 , "A4" )
+
+// 200 ops a second between the two op types, over a second once warmup is done
+assert.lte( res.findOneLatencyMicros.ops + res.updateLatencyMicros.ops , 250 , "B1" )
+assert.gte( t.findOne( { _id : 1 } ).x , res.updateLatencyMicros.ops , "B2" )
@@ -0,0 +1,157 @@
+/**
+ * Regression benchmark suite.  Runs a fixed set of workloads through benchRun against mongods
+ * it starts itself, and prints the results as a single line of JSON, prefixed with
+ * "BENCHMARK_RESULTS ", that can be kept and compared against the same run on another build.
+ *
+ * The workloads use the documents loadgen and docgen generate: a fixed blob and md5seed
+ * string next to an increasing counter, 176 bytes in all.
+ *
+ *   insert         inserts with getLastError into an empty collection
+ *   updateInPlace  $inc of a random document by _id, which never grows it
+ *   rangeQuery     100 document ranges of an indexed field, spread over the collection
+ *   aggregate      $match and $group over a tenth of the collection
+ *   secondaryLag   inserts into a two node replica set, with the lag of the secondary
+ *                  sampled while they run and the time it takes to catch up after
+ *
+ * Run with "scons smokeBenchmarks", or on its own with "mongo --nodb regression.js".
+ */
+
+var seconds = 10;
+var warmupSeconds = 2;
+var parallel = 8;
+var numDocs = 100000;
+
+var blob = "MongoDB is an open source document-oriented database system.";
+
+function makeDoc( i ) {
+    return { _id : i , blob : blob , md5seed : "newyork" , counterUp : i ,
+             counterDown : numDocs - i , group : i % 100 };
+}
+
+function load( coll ) {
+    coll.drop();
+    for ( var i = 0; i < numDocs; i++ ) {
+        coll.insert( makeDoc( i ) );
+    }
+    assert.eq( null , coll.getDB().getLastError() , "load " + coll );
+}
+
+/**
+ * Runs 'ops' against 'conn' and returns the ops/sec and latencies of the ones counted as
+ * 'type' (findOne, insert, update, delete, query or command).
+ */
+function runWorkload( conn , type , ops ) {
+    var res = benchRun( { ops : ops , host : conn.host , parallel : parallel ,
+                          seconds : seconds , warmupSeconds : warmupSeconds } );
+    assert.eq( 0 , res.errCount , "errors in " + type + " workload: " + tojson( res ) );
+
+    var latencies = res[type + "LatencyMicros"];
+    assert( latencies , "no " + type + " ops ran: " + tojson( res ) );
+    return { opsPerSecond : latencies.ops / seconds , latencyMicros : latencies };
+}
+
+var results = { suite : "regression" ,
+                config : { seconds : seconds , warmupSeconds : warmupSeconds ,
+                           parallel : parallel , numDocs : numDocs } ,
+                workloads : {} };
+
+var conn = MongoRunner.runMongod( {} );
+var testDB = conn.getDB( "benchmarks" );
+
+if ( testDB.adminCommand( "buildInfo" ).debug ) {
+    numDocs = 10000;
+    results.config.numDocs = numDocs;
+}
+
+var buildInfo = testDB.adminCommand( "buildInfo" );
+results.build = { version : buildInfo.version , gitVersion : buildInfo.gitVersion ,
+                  debug : buildInfo.debug };
+
+// insert
+testDB.insert.drop();
+results.workloads.insert = runWorkload( conn , "insert" ,
+    [ { op : "insert" , ns : testDB.insert.getFullName() , safe : true ,
+        doc : { blob : blob , md5seed : "newyork" ,
+                counterUp : { "#RAND_INT" : [ 0 , numDocs ] } } } ] );
+
+// updateInPlace
+load( testDB.update );
+results.workloads.updateInPlace = runWorkload( conn , "update" ,
+    [ { op : "update" , ns : testDB.update.getFullName() , safe : true ,
+        query : { _id : { "#RAND_INT" : [ 0 , numDocs ] } } ,
+        update : { $inc : { counterUp : 1 } } } ] );
+
+// rangeQuery: the same ranges on every run
+load( testDB.range );
+testDB.range.ensureIndex( { counterUp : 1 } );
+Random.srand( 17 );
+var rangeOps = [];
+for ( var i = 0; i < 100; i++ ) {
+    var low = Random.randInt( numDocs - 100 );
+    rangeOps.push( { op : "find" , ns : testDB.range.getFullName() ,
+                     query : { counterUp : { $gte : low , $lt : low + 100 } } } );
+}
+results.workloads.rangeQuery = runWorkload( conn , "query" , rangeOps );
+
+// aggregate
+load( testDB.agg );
+testDB.agg.ensureIndex( { group : 1 } );
+results.workloads.aggregate = runWorkload( conn , "command" ,
+    [ { op : "command" , ns : testDB.getName() ,
+        command : { aggregate : "agg" ,
+                    pipeline : [ { $match : { group : { $lt : 10 } } } ,
+                                 { $group : { _id : "$group" ,
+                                              total : { $sum : "$counterUp" } } } ] } } ] );
+
+MongoRunner.stopMongod( conn.port );
+
+// secondaryLag
+var replTest = new ReplSetTest( { name : "benchmarks" , nodes : 2 } );
+replTest.startSet();
+replTest.initiate();
+var primary = replTest.getPrimary();
+replTest.awaitSecondaryNodes();
+var secondary = replTest.liveNodes.slaves[0];
+
+function lastOpTime( node ) {
+    return node.getDB( "local" ).oplog.rs.find().sort( { $natural : -1 } ).limit( 1 ).next().ts;
+}
+
+var lagColl = primary.getDB( "benchmarks" ).lag;
+var oid = benchStart( { ops : [ { op : "insert" , ns : lagColl.getFullName() ,
+                                  doc : { blob : blob , md5seed : "newyork" ,
+                                          counterUp : { "#RAND_INT" : [ 0 , numDocs ] } } } ] ,
+                        host : primary.host , parallel : parallel ,
+                        seconds : seconds , warmupSeconds : warmupSeconds } );
+
+var maxLagSeconds = 0;
+var totalLagSeconds = 0;
+var samples = 0;
+var end = new Date().getTime() + seconds * 1000;
+while ( new Date().getTime() < end ) {
+    var lag = lastOpTime( primary ).t - lastOpTime( secondary ).t;
+    maxLagSeconds = Math.max( maxLagSeconds , lag );
+    totalLagSeconds += lag;
+    samples++;
+    sleep( 100 );
+}
+var lagRes = benchFinish( oid );
+
+// how long the secondary takes to apply what's left once the load stops
+var caughtUpTo = lastOpTime( primary );
+var catchUpStart = new Date().getTime();
+assert.soon( function() {
+    var ts = lastOpTime( secondary );
+    return ts.t > caughtUpTo.t || ( ts.t == caughtUpTo.t && ts.i >= caughtUpTo.i );
+} , "secondary never caught up" , 10 * 60 * 1000 , 10 );
+
+results.workloads.secondaryLag = {
+    opsPerSecond : lagRes.insertLatencyMicros ? lagRes.insertLatencyMicros.ops / seconds : 0 ,
+    maxLagSeconds : maxLagSeconds ,
+    averageLagSeconds : samples ? totalLagSeconds / samples : 0 ,
+    catchUpMillis : new Date().getTime() - catchUpStart
+};
+
+replTest.stopSet();
+
+print( "BENCHMARK_RESULTS " + tojson( results , "" , true ) );
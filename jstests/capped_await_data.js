@@ -0,0 +1,19 @@
+// An awaitData getMore on a capped collection returns a document inserted while it waits.
+
+var t = db.capped_await_data;
+t.drop();
+db.createCollection( t.getName(), { capped : true, size : 4096 } );
+t.insert( { x : 0 } );
+db.getLastError();
+
+var cursor = t.find().addOption( DBQuery.Option.tailable ).addOption( DBQuery.Option.awaitData );
+assert.eq( 0, cursor.next().x );
+
+var insert = startParallelShell( "sleep( 500 ); db.capped_await_data.insert( { x : 1 } ); db.getLastError();" );
+
+var start = new Date();
+assert.soon( function() { return cursor.hasNext(); }, "awaitData getMore didn't see the insert" );
+assert.eq( 1, cursor.next().x );
+assert.gt( 5000, new Date() - start );
+
+insert();
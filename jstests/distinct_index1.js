@@ -34,10 +34,12 @@ assert.eq( 1000 , x.stats.nscannedObjects , "AC3" )
 
 t.ensureIndex( { a : 1 } )
 
+// no query, so the index is skip scanned, one key per value
 x = d( "a" );
-assert.eq( 1000 , x.stats.n , "BA1" )
-assert.eq( 1000 , x.stats.nscanned , "BA2" )
+assert.eq( 10 , x.stats.n , "BA1" )
+assert.eq( 10 , x.stats.nscanned , "BA2" )
 assert.eq( 0 , x.stats.nscannedObjects , "BA3" )
+assert.eq( [ 0 , 1 , 2 , 3 , 4 , 5 , 6 , 7 , 8 , 9 ] , x.values , "BA4" )
 
 x = d( "a" , { a : { $gt : 5 } } );
 assert.eq( 398 , x.stats.n , "BB1" )
@@ -58,3 +60,17 @@ assert.eq( 171 , x.stats.n )
 assert.eq( 275 , x.stats.nscanned )
 // Disable temporarily - exact value doesn't matter.
 // assert.eq( 266 , x.stats.nscannedObjects )
+
+// skip scans of compound and descending indexes
+t.dropIndexes();
+t.ensureIndex( { a : -1, b : 1 } );
+x = d( "a" );
+assert.eq( 10 , x.stats.nscanned , "DA1" )
+assert.eq( [ 9 , 8 , 7 , 6 , 5 , 4 , 3 , 2 , 1 , 0 ] , x.values , "DA2" )
+
+// ... but not of indexes that can leave documents out
+t.dropIndexes();
+t.ensureIndex( { a : 1 } , { sparse : true } );
+x = d( "a" );
+assert.eq( 1000 , x.stats.nscanned , "EA1" )
+assert.eq( 10 , x.values.length , "EA2" )
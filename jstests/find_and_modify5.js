@@ -0,0 +1,65 @@
+// findAndModify updates the document it located without looking it up again, in place or not,
+// with either update framework.
+
+t = db.find_and_modify5;
+
+function check() {
+    t.drop();
+    t.ensureIndex({ status: 1 });
+    for (var i = 0; i < 5; i++) {
+        t.insert({ _id: i, status: "ready", pri: i, tags: [ { n: "a", c: 0 }, { n: "b", c: 0 } ] });
+    }
+
+    // an indexed field, changed in place; the old image is returned by default
+    var job = t.findAndModify({ query: { status: "ready", pri: 4 },
+                                update: { $set: { status: "busy" } } });
+    assert.eq(4, job._id, "A1");
+    assert.eq("ready", job.status, "A2");
+    job = t.findAndModify({ query: { status: "ready" }, update: { $set: { status: "busy" } },
+                            'new': true });
+    assert.eq("busy", job.status, "A3");
+    assert.eq(3, t.find({ status: "ready" }).itcount(), "A4");
+    assert.eq(2, t.find({ status: "busy" }).hint({ status: 1 }).itcount(), "A5");
+
+    // a positional update, with the element the query matched
+    job = t.findAndModify({ query: { _id: 1, "tags.n": "b" }, update: { $inc: { "tags.$.c": 5 } },
+                            'new': true });
+    assert.eq([ { n: "a", c: 0 }, { n: "b", c: 5 } ], job.tags, "B1");
+    job = t.findAndModify({ query: { "tags.n": "b", pri: 1 }, update: { $inc: { "tags.$.c": 1 } },
+                            fields: { tags: 1 } });
+    assert.eq({ _id: 1, tags: [ { n: "a", c: 0 }, { n: "b", c: 5 } ] }, job, "B2");
+    assert.eq(6, t.findOne({ _id: 1 }).tags[1].c, "B3");
+
+    // growing the document moves it
+    var big = new Array(4096).toString();
+    job = t.findAndModify({ query: { pri: 2 }, update: { $set: { pad: big } }, 'new': true });
+    assert.eq(big, job.pad, "C1");
+    assert.eq(big, t.findOne({ _id: 2 }).pad, "C2");
+
+    // a replacement keeps the _id
+    job = t.findAndModify({ query: { pri: 3 }, update: { status: "done" }, 'new': true });
+    assert.eq({ _id: 3, status: "done" }, job, "D1");
+    assert.eq(1, t.find({ status: "done" }).itcount(), "D2");
+
+    // a match that changes nothing is still found
+    var res = db.runCommand({ findAndModify: t.getName(), query: { _id: 0 },
+                              update: { $set: { status: "ready" } }, 'new': true });
+    assert.eq({ _id: 0, status: "ready", pri: 0, tags: [ { n: "a", c: 0 }, { n: "b", c: 0 } ] },
+              res.value, "E1");
+    assert(res.lastErrorObject.updatedExisting, "E2");
+    assert.eq(1, res.lastErrorObject.n, "E3");
+
+    // and upserts still go the usual way
+    job = t.findAndModify({ query: { _id: 9 }, update: { $set: { status: "new" } }, upsert: true,
+                            'new': true });
+    assert.eq({ _id: 9, status: "new" }, job, "F1");
+}
+
+check();
+assert.commandWorked(db.adminCommand({ setParameter: 1, newUpdateFrameworkEnabled: true }));
+try {
+    check();
+}
+finally {
+    assert.commandWorked(db.adminCommand({ setParameter: 1, newUpdateFrameworkEnabled: false }));
+}
@@ -0,0 +1,61 @@
+// findAndModify's queue mode hands out the documents matching a query in turn, resuming after the
+// last one instead of scanning from the start, and starts over once it runs out.
+
+t = db.find_and_modify_queue;
+
+function claim(query) {
+    var res = db.runCommand({ findAndModify: t.getName(), query: query, queue: true,
+                              update: { $set: { status: "busy" } }, 'new': true });
+    assert.commandWorked(res);
+    return res.value;
+}
+
+function check(indexed) {
+    t.drop();
+    if (indexed) {
+        t.ensureIndex({ status: 1 });
+    }
+    for (var i = 0; i < 10; i++) {
+        t.insert({ _id: i, status: "ready" });
+    }
+
+    var ids = [];
+    for (var i = 0; i < 5; i++) {
+        ids.push(claim({ status: "ready" })._id);
+    }
+    assert.eq([0, 1, 2, 3, 4], ids, "A1");
+
+    // a document behind the cursor is only found once it runs out
+    t.update({ _id: 1 }, { $set: { status: "ready" } });
+    t.remove({ _id: 5 });
+    ids = [];
+    for (var i = 0; i < 5; i++) {
+        ids.push(claim({ status: "ready" })._id);
+    }
+    assert.eq([6, 7, 8, 9, 1], ids, "B1");
+    assert.eq(null, claim({ status: "ready" }), "B2");
+    assert.eq(0, t.count({ status: "ready" }), "B3");
+
+    // each query has a cursor of its own, and removes hand out documents in turn too
+    t.update({}, { $set: { status: "ready" } }, false, true);
+    assert.eq(0, claim({ status: "ready", other: null })._id, "C1");
+    var res = db.runCommand({ findAndModify: t.getName(), query: { status: "ready" },
+                              queue: true, remove: true });
+    assert.eq(1, res.value._id, "C2");
+    res = db.runCommand({ findAndModify: t.getName(), query: { status: "ready" },
+                          queue: true, remove: true });
+    assert.eq(2, res.value._id, "C3");
+    assert.eq(3, claim({ status: "ready", other: null })._id, "C4");
+}
+
+check(false);
+check(true);
+
+// dropping the collection kills its queue cursors
+t.drop();
+t.insert({ _id: 0, status: "ready" });
+assert.eq(0, claim({ status: "ready" })._id, "D1");
+
+res = db.runCommand({ findAndModify: t.getName(), query: {}, queue: true, sort: { _id: 1 },
+                      update: { $set: { status: "busy" } } });
+assert.commandFailed(res, "E1");
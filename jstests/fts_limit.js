@@ -0,0 +1,30 @@
+// A single term search stops once it has 'limit' matches; they must still be the best scoring ones.
+load( "jstests/libs/fts.js" );
+
+t = db.text_limit;
+t.drop();
+
+for ( var i = 0; i < 100; i++ ) {
+    var text = "";
+    for ( var j = 0; j <= i % 10; j++ )
+        text += "apple ";
+    t.save( { _id : i , text : text + "pie" , n : i } );
+}
+t.ensureIndex( { text : "text" } );
+
+all = t.runCommand( "text" , { search : "apple" } );
+assert.eq( 100, all.results.length );
+
+top = t.runCommand( "text" , { search : "apple" , limit : 10 } );
+assert.eq( 10, top.results.length );
+for ( var k = 0; k < 10; k++ )
+    assert.eq( all.results[k].score, top.results[k].score );
+
+// the filter and negated terms are applied before a match counts toward the limit
+filtered = t.runCommand( "text" , { search : "apple" , limit : 5 , filter : { n : { $lt : 50 } } } );
+assert.eq( 5, filtered.results.length );
+filtered.results.forEach( function( r ) { assert.lt( r.obj.n, 50 ); } );
+assert.eq( all.results[0].score, filtered.results[0].score );
+
+negated = t.runCommand( "text" , { search : "apple -pie" , limit : 5 } );
+assert.eq( 0, negated.results.length );
@@ -0,0 +1,54 @@
+// $within $box on a 2d index scans the cells of a cover of the box, and finds what a scan
+// without the index finds.
+
+var indexed = db.geo_box_cover;
+var plain = db.geo_box_cover_noindex;
+indexed.drop();
+plain.drop();
+
+Random.srand(1234);
+for (var i = 0; i < 3000; i++) {
+    var doc = { _id: i, loc: [ Random.rand() * 360 - 180, Random.rand() * 360 - 180 ],
+                k: i % 3 };
+    if (i % 100 == 0) {
+        // and documents with several points
+        doc.loc = [ doc.loc, [ -doc.loc[0], doc.loc[1] ] ];
+    }
+    indexed.insert(doc);
+    plain.insert(doc);
+}
+indexed.ensureIndex({ loc: "2d", k: 1 });
+assert.isnull(db.getLastError());
+
+function ids(coll, query) {
+    return coll.find(query, { _id: 1 }).batchSize(50).toArray().map(function(doc) {
+        return doc._id;
+    }).sort(function(a, b) { return a - b; });
+}
+
+function check(box, extra) {
+    var query = { loc: { $within: { $box: box } } };
+    for (var f in extra) {
+        query[f] = extra[f];
+    }
+    var expected = ids(plain, query);
+    assert.eq(expected, ids(indexed, query), tojson(query));
+    assert.eq(expected.length, indexed.find(query).count(), tojson(query));
+}
+
+// across the middle of the space, where the top cells meet
+check([ [ -10, -10 ], [ 10, 10 ] ]);
+check([ [ -0.5, -30 ], [ 0.5, 30 ] ]);
+check([ [ 5, 5 ], [ 60, 7 ] ]);
+check([ [ 5, 5 ], [ 60, 7 ] ], { k: 1 });
+check([ [ 100, -170 ], [ 180, -100 ] ]);
+check([ [ -180, -180 ], [ 180, 180 ] ]);
+check([ [ -300, -300 ], [ 300, 300 ] ]);
+check([ [ 33.3, 44.4 ], [ 33.30001, 44.40001 ] ]);
+check([ [ 20, 20 ], [ 120, 120 ] ], { k: 2 });
+
+// a document exactly on a corner
+indexed.insert({ _id: "corner", loc: [ 10, 10 ] });
+plain.insert({ _id: "corner", loc: [ 10, 10 ] });
+assert.eq(1, indexed.find({ _id: "corner", loc: { $within: { $box: [ [ 0, 0 ], [ 10, 10 ] ] } } })
+                 .itcount());
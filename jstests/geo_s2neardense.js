@@ -0,0 +1,38 @@
+// A $near search over a dense area narrows its shells rather than holding every result in one;
+// everything must still come back exactly once, in order.
+t = db.geo_s2neardense
+t.drop()
+
+for (var i = 0; i < 5000; ++i) {
+    var x = (i % 100) * 0.0001;
+    var y = Math.floor(i / 100) * 0.0001;
+    t.insert({_id: i, geo: { "type" : "Point", "coordinates" : [ x, y ] }});
+}
+// Many points at the same spot must not be split across shells.
+for (var j = 0; j < 2500; ++j) {
+    t.insert({_id: 5000 + j, geo: { "type" : "Point", "coordinates" : [ 0.005, 0.0025 ] }});
+}
+t.ensureIndex({geo: "2dsphere"});
+
+origin = { "type" : "Point", "coordinates" : [ 0.005, 0.0025 ] };
+near = { "geo" : { "$near" : { "$geometry" : origin } } };
+
+function distance(doc) {
+    var dx = doc.geo.coordinates[0] - origin.coordinates[0];
+    var dy = doc.geo.coordinates[1] - origin.coordinates[1];
+    return dx * dx + dy * dy;
+}
+
+res = t.find(near).toArray();
+assert.eq(7500, res.length);
+seen = {};
+for (var k = 0; k < res.length; ++k) {
+    assert(!seen[res[k]._id], "returned twice: " + res[k]._id);
+    seen[res[k]._id] = true;
+    if (k > 0) {
+        // Allow for the difference between planar and spherical distance at this scale.
+        assert.lte(distance(res[k - 1]), distance(res[k]) * 1.01 + 1e-12);
+    }
+}
+
+assert.eq(10, t.find(near).limit(10).itcount());
@@ -0,0 +1,35 @@
+// Points well inside a $within / $geoIntersects region are accepted without an exact test; make
+// sure the index still returns exactly what an unindexed scan does, holes included.
+t = db.geo_s2withininterior
+t.drop()
+
+poly = { "type" : "Polygon",
+         "coordinates" : [ [ [0,0], [0,10], [10,10], [10,0], [0,0] ],
+                           [ [4,4], [6,4], [6,6], [4,6], [4,4] ] ] }
+
+for (var x = -1; x <= 11; x += 0.25) {
+    for (var y = -1; y <= 11; y += 0.25) {
+        t.insert({geo: { "type" : "Point", "coordinates" : [ x, y ] }});
+    }
+}
+
+function count(query) {
+    return t.find(query).itcount();
+}
+
+within = { "geo" : { "$within" : { "$geometry" : poly } } };
+intersects = { "geo" : { "$geoIntersects" : { "$geometry" : poly } } };
+unindexedWithin = count(within);
+unindexedIntersects = count(intersects);
+assert.gt(unindexedWithin, 0);
+
+t.ensureIndex({geo: "2dsphere"})
+assert.eq(unindexedWithin, count(within));
+assert.eq(unindexedIntersects, count(intersects));
+
+// Nothing in the hole.
+hole = { "type" : "Polygon",
+         "coordinates" : [ [ [4.1,4.1], [5.9,4.1], [5.9,5.9], [4.1,5.9], [4.1,4.1] ] ] };
+holeIds = t.find({ "geo" : { "$within" : { "$geometry" : hole } } }).map(function(d) { return d._id; });
+assert.gt(holeIds.length, 0);
+assert.eq(0, t.find({ "$and" : [ within, { _id : { "$in" : holeIds } } ] }).itcount());
@@ -0,0 +1,34 @@
+// getMore replies prepared ahead of the request must hold every document once, in order, and
+// the last one must close the cursor.
+
+var t = db.getmore_prefetch;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ ) {
+    t.insert( { _id : i, x : i } );
+}
+db.getLastError();
+
+assert.commandWorked( db.adminCommand( { setParameter : 1, getMorePrefetchMaxMB : 16 } ) );
+
+function check( batchSize ) {
+    var cursor = t.find().sort( { _id : 1 } ).batchSize( batchSize );
+    var n = 0;
+    while ( cursor.hasNext() ) {
+        assert.eq( n, cursor.next()._id );
+        n++;
+    }
+    assert.eq( 1000, n );
+}
+
+check( 10 );
+check( 7 );
+check( 1000 );
+
+// A cursor left with a prepared batch can still be killed.
+var open = t.find().batchSize( 5 );
+open.next();
+open.close();
+
+assert.commandWorked( db.adminCommand( { setParameter : 1, getMorePrefetchMaxMB : 0 } ) );
+check( 10 );
@@ -0,0 +1,50 @@
+// group runs reduce functions it recognizes without JavaScript, with the results JavaScript
+// would give.
+
+t = db.group8;
+t.drop();
+
+for ( var i = 0; i < 100; i++ ) {
+    t.save( { a : i % 3 , b : i , c : ( i % 10 == 0 ? null : i / 2 ) , s : "x" + i } );
+}
+t.save( { a : 1 , b : true } );      // a missing c is undefined, so NaN
+t.save( { a : "z" , c : NumberInt( 4 ) } );
+
+function run( p , nativeReduce ) {
+    assert.commandWorked( db.adminCommand( { setParameter : 1 ,
+                                              groupNativeReduce : nativeReduce } ) );
+    p.ns = t.getName();
+    var res = db.runCommand( { group : p } );
+    assert.commandWorked( res );
+    delete res.ok;
+    return res;
+}
+
+function check( p ) {
+    assert.eq( tojson( run( p , false ) ) , tojson( run( p , true ) ) , tojson( p ) );
+}
+
+check( { key : { a : 1 } , $reduce : function( obj , prev ) { prev.count++; } ,
+         initial : { count : 0 } } );
+check( { key : { a : 1 } ,
+         $reduce : function( doc , out ) {
+             out.total += doc.b;
+             out.n += 1;
+             out.low = Math.min( out.low , doc.c );
+             out.high = Math.max( doc.c , out.high );
+         } ,
+         initial : { total : 0 , n : 0 , low : 1000 , high : -1000 } ,
+         cond : { b : { $ne : true } } } );
+check( { key : {} , $reduce : "function(obj, prev) { ++prev.x; prev.y += obj.c }" ,
+         initial : { x : 0 , y : 0.5 } } );
+
+// ... and those it doesn't, or values '+' would concatenate, still run in JavaScript
+check( { key : { a : 1 } , $reduce : function( obj , prev ) { prev.s += obj.s; } ,
+         initial : { s : 0 } } );
+check( { key : { a : 1 } , $reduce : function( obj , prev ) { if ( obj.b ) prev.n++; } ,
+         initial : { n : 0 } } );
+check( { key : { a : 1 } , $reduce : function( obj , prev ) { prev.n++; } ,
+         initial : { n : 0 } , finalize : function( out ) { out.n *= 2; } } );
+
+assert.eq( 100 , run( { key : {} , $reduce : function( obj , prev ) { prev.n++; } ,
+                        initial : { n : 0 } , cond : { s : /x/ } } , true ).retval[ 0 ].n );
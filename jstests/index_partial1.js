@@ -0,0 +1,56 @@
+// Partial indexes hold only the documents matching their partialFilterExpression, and are only
+// used for queries that imply it.
+
+t = db.index_partial1;
+t.drop();
+
+for ( var i = 0; i < 100; i++ ) {
+    t.insert( { _id : i , x : i , status : ( i % 10 == 0 ? "active" : "done" ) } );
+}
+
+t.ensureIndex( { x : 1 } , { partialFilterExpression : { status : "active" } } );
+assert.isnull( db.getLastError() , "A1" );
+assert.eq( 10 , t.validate().keysPerIndex[ t.getFullName() + ".$x_1" ] , "A2" );
+
+// the query implies the filter
+var explain = t.find( { x : { $gt : 15 } , status : "active" } ).explain();
+assert.eq( "BtreeCursor x_1" , explain.cursor , "B1" );
+assert.eq( 8 , explain.n , "B2" );
+assert.eq( 8 , explain.nscannedObjects , "B3" );
+
+// ... or doesn't, and the index would miss documents
+explain = t.find( { x : { $gt : 15 } } ).explain();
+assert.eq( "BasicCursor" , explain.cursor , "C1" );
+assert.eq( 84 , explain.n , "C2" );
+assert.eq( 100 , t.find().sort( { x : 1 } ).itcount() , "C3" );
+assert.eq( 84 , t.find( { x : { $gt : 15 } , status : { $in : [ "active" , "done" ] } } ).itcount() ,
+           "C4" );
+
+// documents move in and out of the index as they change
+t.update( { _id : 11 } , { $set : { status : "active" } } );
+t.update( { _id : 20 } , { $set : { status : "done" } } );
+assert.eq( 10 , t.validate().keysPerIndex[ t.getFullName() + ".$x_1" ] , "D1" );
+assert.eq( [ 0 , 10 , 11 , 30 ] ,
+           t.find( { x : { $lt : 35 } , status : "active" } , { _id : 1 } ).sort( { x : 1 } )
+            .map( function( doc ) { return doc._id; } ) , "D2" );
+
+// uniqueness only holds among the indexed documents
+t.drop();
+t.ensureIndex( { x : 1 } , { unique : true , partialFilterExpression : { x : { $gt : 5 } } } );
+t.insert( { x : 1 } );
+t.insert( { x : 1 } );
+assert.isnull( db.getLastError() , "E1" );
+t.insert( { x : 6 } );
+t.insert( { x : 6 } );
+assert( db.getLastError() , "E2" );
+assert.eq( 3 , t.count() , "E3" );
+
+// filters the planner couldn't reason about are refused
+t.drop();
+t.ensureIndex( { x : 1 } , { partialFilterExpression : { status : { $ne : "done" } } } );
+assert( db.getLastError() , "F1" );
+t.ensureIndex( { x : 1 } , { partialFilterExpression : 1 } );
+assert( db.getLastError() , "F2" );
+t.ensureIndex( { x : "hashed" } , { partialFilterExpression : { status : "active" } } );
+assert( db.getLastError() , "F3" );
+assert.eq( 1 , t.getIndexes().length , "F4" );
@@ -0,0 +1,51 @@
+// indexUsage counts, per index, the seeks and keys scanned by the cursors that used it, and
+// starts over for an index dropped and made again, or on reset.
+
+t = db.index_usage;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i, a: i, b: i % 10 });
+}
+t.ensureIndex({ a: 1 });
+t.ensureIndex({ b: 1 });
+assert.isnull(db.getLastError());
+
+function usage(name, reset) {
+    var res = t.indexUsage(reset);
+    assert.commandWorked(res);
+    for (var i = 0; i < res.indexes.length; i++) {
+        if (res.indexes[i].name == name) {
+            return res.indexes[i];
+        }
+    }
+    assert(false, "no index " + name + " in " + tojson(res));
+}
+
+assert.eq(0, usage("b_1").seeks, "A1");
+assert.eq(0, usage("b_1").keysScanned, "A2");
+assert.eq(undefined, usage("b_1").lastUsed, "A3");
+
+assert.eq(10, t.find({ a: { $gte: 10, $lt: 20 } }).hint({ a: 1 }).itcount(), "B1");
+var a = usage("a_1");
+assert.gte(a.seeks, 1, "B2");
+assert.gte(a.keysScanned, 10, "B3");
+assert(a.lastUsed instanceof Date, "B4");
+assert.eq(0, usage("b_1").seeks, "B5");
+
+// counts add up across queries
+assert.eq(1, t.find({ a: 50 }).hint({ a: 1 }).itcount(), "C1");
+assert.gt(usage("a_1").seeks, a.seeks, "C2");
+
+// reset reports the counts, then starts over
+assert.gte(usage("a_1", true).seeks, 2, "D1");
+assert.eq(0, usage("a_1").seeks, "D2");
+
+// a dropped index forgets its counts
+assert.eq(10, t.find({ b: 3 }).hint({ b: 1 }).itcount(), "E1");
+assert.gt(usage("b_1").seeks, 0, "E2");
+t.dropIndex({ b: 1 });
+t.ensureIndex({ b: 1 });
+assert.eq(0, usage("b_1").seeks, "E3");
+
+assert.commandFailed(db.runCommand({ indexUsage: "index_usage_missing" }), "F1");
@@ -0,0 +1,24 @@
+// serverStatus lockContention section: lock wait histograms and the longest waits
+
+t = db.jstests_lock_contention;
+t.drop();
+
+for ( var i = 0; i < 20; i++ ) {
+    t.insert( { x : i } );
+    t.findOne( { x : i } );
+}
+assert.isnull( db.getLastError() );
+
+var status = db.serverStatus( { lockContention : 1 } );
+assert( status.lockContention, tojson( status ) );
+
+var waits = status.lockContention.waits;
+assert( waits.w.insert, tojson( waits ) );
+assert.lte( 20, waits.w.insert.ops, tojson( waits ) );
+assert( waits.r.query, tojson( waits ) );
+assert.lte( waits.w.insert.p50, waits.w.insert.p99 );
+
+assert( Array.isArray( status.lockContention.longestWaits ) );
+
+// Not included unless asked for.
+assert.isnull( db.serverStatus().lockContention );
@@ -0,0 +1,36 @@
+// maxTimeMS interrupts a query or command once it has run for that long.
+
+t = db.max_time_ms;
+t.drop();
+for (var i = 0; i < 100; i++) {
+    t.insert({ _id: i });
+}
+db.getLastError();
+
+// each document takes 10ms, so a scan of them all takes a second
+var slow = { $where: "sleep(10); return true;" };
+
+// a query
+var e = assert.throws(function() { t.find(slow).maxTimeMS(200).itcount(); });
+assert(/exceeded time limit/.test(e), tojson(e));
+assert.eq(100, t.find(slow).maxTimeMS(60 * 1000).itcount());
+assert.eq(100, t.find(slow).maxTimeMS(0).itcount());
+assert.throws(function() { t.find().maxTimeMS(-1).itcount(); });
+
+// a command
+var res = db.runCommand({ count: t.getName(), query: slow, maxTimeMS: 200 });
+assert.commandFailed(res);
+assert(/exceeded time limit/.test(res.errmsg), tojson(res));
+res = db.runCommand({ count: t.getName(), query: slow, maxTimeMS: 60 * 1000 });
+assert.commandWorked(res);
+assert.eq(100, res.n);
+assert.commandFailed(db.runCommand({ count: t.getName(), maxTimeMS: "soon" }));
+
+// an aggregation accepts one too
+res = db.runCommand({ aggregate: t.getName(), pipeline: [ { $match: { _id: 1 } } ],
+                      maxTimeMS: 60 * 1000 });
+assert.commandWorked(res);
+assert.eq([ { _id: 1 } ], res.result);
+
+// the limit is the query's own, not the connection's
+assert.eq(100, t.find().itcount());
@@ -0,0 +1,31 @@
+// maxOpMemoryMB limits the memory one op's sort and $group buffers hold: a $group spills to disk
+// when it may, and fails when it may not, as does a sort without an index.
+
+t = db.op_memory_limit;
+t.drop();
+
+var big = new Array(10 * 1024).toString();
+for (var i = 0; i < 500; i++) {
+    t.insert({ _id: i, k: i, big: big });
+}
+assert.isnull(db.getLastError());
+
+var pipeline = [ { $group: { _id: "$k", big: { $first: "$big" } } } ];
+assert.eq(500, t.aggregate(pipeline).result.length, "A1");
+assert.eq(500, t.find().sort({ big: 1, k: 1 }).itcount(), "A2");
+
+assert.commandWorked(db.adminCommand({ setParameter: 1, maxOpMemoryMB: 1 }));
+try {
+    assert.commandFailed(db.runCommand({ aggregate: t.getName(), pipeline: pipeline }), "B1");
+    var res = db.runCommand({ aggregate: t.getName(), pipeline: pipeline, allowDiskUsage: true });
+    assert.commandWorked(res, "B2");
+    assert.eq(500, res.result.length, "B3");
+
+    assert.throws(function() { t.find().sort({ big: 1, k: 1 }).itcount(); }, [], "C1");
+}
+finally {
+    assert.commandWorked(db.adminCommand({ setParameter: 1, maxOpMemoryMB: 0 }));
+}
+
+// nothing stays charged once the ops are done
+assert.eq(0, db.serverStatus().metrics.operationMemory.bytes, "D1");
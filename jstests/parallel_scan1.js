@@ -0,0 +1,45 @@
+// Counts and aggregations that scan a whole collection on several threads get the same answers
+// as on one.
+
+t = db.parallel_scan1;
+t.drop();
+
+// enough documents for several extents
+var pad = new Array( 200 ).join( "x" );
+for ( var i = 0; i < 20000; i++ ) {
+    t.insert( { _id : i , a : i % 7 , b : [ i % 3 , i % 5 ] , pad : pad } );
+}
+t.remove( { _id : { $mod : [ 11 , 0 ] } } );
+assert.isnull( db.getLastError() , "A1" );
+assert.lt( 2 , t.stats().numExtents , "A2" );
+
+function results() {
+    var sorted = function( res ) {
+        assert.commandWorked( res );
+        return res.result.sort( function( x , y ) { return x._id - y._id; } );
+    };
+    return {
+        count : t.count( { a : { $gt : 2 } } ) ,
+        countSkip : t.find( { a : 3 } ).skip( 100 ).limit( 1000 ).count( true ) ,
+        group : sorted( t.aggregate( { $match : { a : { $ne : 4 } } } ,
+                                     { $group : { _id : "$a" , n : { $sum : 1 } ,
+                                                  avg : { $avg : "$_id" } ,
+                                                  max : { $max : "$_id" } } } ) ) ,
+        unwound : sorted( t.aggregate( { $project : { b : 1 } } , { $unwind : "$b" } ,
+                                       { $group : { _id : "$b" , n : { $sum : 1 } ,
+                                                    min : { $min : { $mod : [ "$_id" , 4 ] } } } } ,
+                                       { $sort : { n : -1 } } ) ) ,
+        // order dependent, so these stay on one thread
+        first : sorted( t.aggregate( { $group : { _id : "$a" , first : { $first : "$_id" } } } ) )
+    };
+}
+
+var serial = results();
+assert.eq( 20000 - 1819 , t.count() , "B1" );
+
+assert.commandWorked( db.adminCommand( { setParameter : 1 , parallelScanThreads : 4 ,
+                                         parallelScanMinMB : 0 } ) );
+assert.eq( serial , results() , "C1" );
+
+assert.commandWorked( db.adminCommand( { setParameter : 1 , parallelScanThreads : 1 ,
+                                         parallelScanMinMB : 64 } ) );
@@ -0,0 +1,53 @@
+// The in memory profile buffer, used instead of system.profile when profileRingBufferMB is set
+
+var stddb = db;
+var db = db.getSisterDB("profile_buffer");
+var admin = stddb.getSisterDB("admin");
+
+t = db.profile_buffer;
+t.drop();
+
+function readBuffer( drain ) {
+    var res = db.runCommand( { profileBuffer : 1, drain : drain } );
+    assert.commandWorked( res );
+    return res.docs;
+}
+
+try {
+    db.setProfilingLevel(0);
+    assert.commandWorked( admin.runCommand( { setParameter : 1, profileRingBufferMB : 1 } ) );
+    readBuffer( true );
+    db.system.profile.drop();
+
+    db.setProfilingLevel(2);
+    for ( var i = 0; i < 10; i++ ) {
+        t.insert( { x : i } );
+        t.findOne( { x : i } );
+    }
+    db.setProfilingLevel(0);
+
+    var docs = readBuffer( false );
+    assert.lte( 20, docs.length, tojson( docs ) );
+    assert.eq( 0, db.system.profile.count(), "profiled ops went to system.profile" );
+
+    // Draining returns the same documents and empties the buffer.
+    assert.eq( docs.length, readBuffer( true ).length );
+    assert.eq( 0, readBuffer( true ).length );
+
+    // With sampling only some of the ops are kept.
+    assert.commandWorked( admin.runCommand( { setParameter : 1, profileSampleEvery : 4 } ) );
+    db.setProfilingLevel(2);
+    for ( var i = 0; i < 40; i++ ) {
+        t.findOne( { x : i } );
+    }
+    db.setProfilingLevel(0);
+    var sampled = readBuffer( true ).length;
+    assert.lt( 5, sampled );
+    assert.gt( 20, sampled );
+}
+finally {
+    db.setProfilingLevel(0);
+    admin.runCommand( { setParameter : 1, profileSampleEvery : 1 } );
+    admin.runCommand( { setParameter : 1, profileRingBufferMB : 0 } );
+    db = stddb;
+}
@@ -0,0 +1,52 @@
+// With a short heartbeatIntervalMillis and a heartbeatSuspicionThreshold, a member that stops
+// answering heartbeats is taken down well before heartbeatTimeoutSecs runs out.
+
+load("jstests/replsets/rslib.js");
+
+var getHostStateAccordingToNode = function (nodes, subject, pov) {
+    var status = nodes[pov].getDB("admin").runCommand({replSetGetStatus: 1});
+    for (var i = 0; i < status.members.length; i++) {
+        if (nodes[subject].host === status.members[i].name) {
+            return status.members[i].state;
+        }
+    }
+    throw "subject host " + nodes[subject].host + " not found in " + tojson(status);
+}
+
+var replTest = new ReplSetTest({ name: 'heartbeatSuspicion', nodes: 3, oplogSize: 1 });
+var nodes = replTest.startSet();
+
+var config = replTest.getReplSetConfig();
+config.settings = { heartbeatTimeoutSecs: 10,
+                    heartbeatIntervalMillis: 500,
+                    heartbeatSuspicionThreshold: 8 };
+replTest.initiate(config);
+
+var master = replTest.waitForMaster();
+waitForAllMembers(master.getDB('admin'));
+
+var saved = master.getDB("local").system.replset.findOne().settings;
+assert.eq(500, saved.heartbeatIntervalMillis, tojson(saved));
+assert.eq(8, saved.heartbeatSuspicionThreshold, tojson(saved));
+
+// let X see enough of Y's heartbeats to judge by
+sleep(5000);
+assert.contains(getHostStateAccordingToNode(nodes, 1, 0), [1, 2], 'X considers Y to be up');
+
+assert.commandWorked(nodes[1].getDB("admin").runCommand({
+    configureFailPoint: 'rsDelayHeartbeatResponse',
+    mode: 'alwaysOn',
+    data: { delay: 30 }
+}));
+
+// The suspicion level passes 8 within a couple of seconds of regular half-second heartbeats,
+// instead of the 10 the timeout would take.
+sleep(5000);
+assert.eq(8, getHostStateAccordingToNode(nodes, 1, 0), 'X considers Y to be down');
+
+assert.commandWorked(nodes[1].getDB("admin").runCommand({
+    configureFailPoint: 'rsDelayHeartbeatResponse',
+    mode: 'off'
+}));
+
+replTest.stopSet();
@@ -0,0 +1,55 @@
+// With replIndexBuildsInBackground on, a secondary builds the indexes the primary built in the
+// foreground in the background instead, and a collMod of an index still building waits for it.
+
+var replTest = new ReplSetTest( {name: 'indexBuildBackground', nodes: 2} );
+var nodes = replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+replTest.awaitSecondaryNodes();
+var slave = replTest.liveNodes.slaves[0];
+slave.setSlaveOk();
+assert.commandWorked(slave.getDB("admin").runCommand(
+    { setParameter: 1, replIndexBuildsInBackground: true }));
+
+var mdb = master.getDB("test");
+var sdb = slave.getDB("test");
+
+var N = 20000;
+for (var i = 0; i < N; i++) {
+    mdb.foo.insert({ _id: i, a: i, t: new Date() });
+}
+replTest.awaitReplication();
+
+mdb.foo.ensureIndex({ a: 1 });
+mdb.foo.ensureIndex({ t: 1 }, { expireAfterSeconds: 100000 });
+assert.isnull(mdb.getLastError());
+assert.eq(false, !!mdb.system.indexes.findOne({ name: "a_1" }).background);
+
+// writes made after the build replicate while it runs
+for (var i = N; i < N + 100; i++) {
+    mdb.foo.insert({ _id: i, a: i, t: new Date() });
+}
+assert.commandWorked(mdb.runCommand({ collMod: "foo",
+                                      index: { keyPattern: { t: 1 },
+                                               expireAfterSeconds: 200000 } }));
+var gle = mdb.runCommand({ getLastError: 1, w: 2, wtimeout: 120000 });
+assert.eq(null, gle.err, tojson(gle));
+
+assert.eq(N + 100, sdb.foo.count());
+var spec = sdb.system.indexes.findOne({ name: "a_1" });
+assert(spec, "secondary has no a_1 index");
+assert(spec.background, tojson(spec));
+assert.eq(200000, sdb.system.indexes.findOne({ name: "t_1" }).expireAfterSeconds);
+
+// the index is finished and usable once the build is through
+assert.soon(function() {
+    try {
+        return sdb.foo.find({ a: { $gt: N - 10 } }).hint({ a: 1 }).itcount() == 109;
+    }
+    catch (e) {
+        return false;
+    }
+});
+
+replTest.stopSet();
@@ -0,0 +1,51 @@
+// A batch insert lays its oplog entries down together; they must still come out one per
+// document, in insert order, and replicate like any others.
+
+var replTest = new ReplSetTest( {name: 'insertOplogBatch', nodes: 2} );
+var nodes = replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+replTest.awaitSecondaryNodes();
+var slave = replTest.liveNodes.slaves[0];
+
+var mdb = master.getDB("test");
+var sdb = slave.getDB("test");
+var oplog = master.getDB("local").oplog.rs;
+
+mdb.foo.ensureIndex({ a: 1 });
+replTest.awaitReplication();
+
+function checkInsert(first, n, padLength) {
+    var start = oplog.find().sort({ $natural: -1 }).limit(1).next().ts;
+
+    var docs = [];
+    for (var i = first; i < first + n; i++) {
+        docs.push({ _id: i, a: i, pad: new Array(padLength).join("x") });
+    }
+    mdb.foo.insert(docs);
+    var gle = mdb.runCommand({ getLastError: 1, w: 2, wtimeout: 60000 });
+    assert.eq(null, gle.err);
+
+    var entries = oplog.find({ ts: { $gt: start } }).sort({ $natural: 1 }).toArray();
+    assert.eq(n, entries.length);
+    for (var i = 0; i < n; i++) {
+        assert.eq("i", entries[i].op);
+        assert.eq("test.foo", entries[i].ns);
+        assert.eq(first + i, entries[i].o._id);
+        if (i > 0) {
+            var prev = entries[i - 1].ts, ts = entries[i].ts;
+            assert(prev.t < ts.t || (prev.t == ts.t && prev.i < ts.i), "ts out of order at " + i);
+            assert.neq(entries[i - 1].h, entries[i].h);
+        }
+    }
+
+    assert.eq(mdb.foo.find().sort({ _id: 1 }).toArray(),
+              sdb.foo.find().sort({ _id: 1 }).toArray());
+}
+
+checkInsert(0, 500, 1);
+// big enough that the batch goes in over several allocations
+checkInsert(500, 200, 4000);
+
+replTest.stopSet(15);
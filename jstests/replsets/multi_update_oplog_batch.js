@@ -0,0 +1,45 @@
+// A multi-update logs its documents in batches; the secondary must still see every change,
+// in order, whether or not batching is on.
+
+var replTest = new ReplSetTest( {name: 'multiUpdateBatch', nodes: 2} );
+var nodes = replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+replTest.awaitSecondaryNodes();
+var slave = replTest.liveNodes.slaves[0];
+
+var mdb = master.getDB("test");
+var sdb = slave.getDB("test");
+var oplog = master.getDB("local").oplog.rs;
+
+var N = 1000;
+for (var i = 0; i < N; i++) {
+    mdb.foo.insert({ _id: i, a: i, pad: "x" });
+}
+mdb.foo.ensureIndex({ a: 1 });
+replTest.awaitReplication();
+
+function checkUpdate(batchSize, step) {
+    assert.commandWorked(master.getDB("admin").runCommand(
+        { setParameter: 1, multiUpdateOplogBatchSize: batchSize }));
+
+    var start = oplog.find().sort({ $natural: -1 }).limit(1).next().ts;
+
+    // Moves some documents and changes an indexed field on all of them.
+    mdb.foo.update({}, { $inc: { a: step }, $set: { pad: new Array(step * 10).join("y") } },
+                   false, true);
+    var gle = mdb.runCommand({ getLastError: 1, w: 2, wtimeout: 60000 });
+    assert.eq(null, gle.err);
+    assert.eq(N, gle.n);
+
+    assert.eq(N, oplog.count({ ts: { $gt: start }, op: "u", ns: "test.foo" }));
+    assert.eq(mdb.foo.find().sort({ _id: 1 }).toArray(),
+              sdb.foo.find().sort({ _id: 1 }).toArray());
+}
+
+checkUpdate(64, 1);
+checkUpdate(1, 2);
+checkUpdate(7, 3);
+
+replTest.stopSet(15);
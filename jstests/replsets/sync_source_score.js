@@ -0,0 +1,49 @@
+// A secondary leaves a sync source that has fallen behind for one that scores better, well before
+// the source is the 30 seconds behind that used to be needed for a change.
+
+var replSet = new ReplSetTest({name: 'syncSourceScore', nodes: 3});
+replSet.startSet();
+replSet.initiate(
+    {
+        _id: 'syncSourceScore',
+        members:
+        [
+            {_id: 0, host: getHostName()+":"+replSet.ports[0]},
+            {_id: 1, host: getHostName()+":"+replSet.ports[1], priority: 0},
+            {_id: 2, host: getHostName()+":"+replSet.ports[2], priority: 0}
+        ]
+    }
+);
+
+var master = replSet.getMaster();
+var primary = master.getDB("foo");
+primary.bar.insert({x: -1});
+replSet.awaitReplication();
+
+var member2 = replSet.nodes[1].getDB("admin");
+var member3 = replSet.nodes[2].getDB("admin");
+var primaryHost = getHostName()+":"+replSet.ports[0];
+var member2Host = getHostName()+":"+replSet.ports[1];
+
+assert.commandWorked(member3.runCommand({setParameter: 1, syncSourceMinSecs: 1}));
+member3.adminCommand({replSetSyncFrom: member2Host});
+assert.soon(function() {
+    return member3.adminCommand({replSetGetStatus: 1}).syncingTo == member2Host;
+});
+
+// 2 stops applying, so its optime stays put while the primary's moves on
+member2.runCommand({configureFailPoint: 'rsSyncApplyStop', mode: 'alwaysOn'});
+
+var start = new Date();
+var switched = false;
+for (var i = 0; i < 50 && !switched; i++) {
+    primary.bar.insert({x: i});
+    sleep(500);
+    switched = member3.adminCommand({replSetGetStatus: 1}).syncingTo == primaryHost;
+}
+assert(switched, "3 never left 2");
+assert.lt(new Date() - start, 25000, "3 only left 2 once it was 30 seconds behind");
+
+member2.runCommand({configureFailPoint: 'rsSyncApplyStop', mode: 'off'});
+replSet.awaitReplication();
+replSet.stopSet();
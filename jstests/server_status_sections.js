@@ -0,0 +1,15 @@
+// serverStatus with defaultSections : false only has the sections asked for
+
+var full = db.serverStatus();
+assert( full.opcounters , "opcounters by default" );
+assert( full.metrics , "metrics by default" );
+
+var some = db.serverStatus( { defaultSections : false , connections : 1 } );
+assert( some.connections , "connections asked for" );
+assert.eq( null , some.opcounters , "opcounters not asked for" );
+assert.eq( null , some.metrics , "metrics not asked for" );
+assert( some.uptimeMillis , "global fields are always there" );
+
+var withMetrics = db.serverStatus( { defaultSections : false , metrics : 1 } );
+assert( withMetrics.metrics , "metrics asked for" );
+assert( withMetrics.mem , "mem comes with the metric tree" );
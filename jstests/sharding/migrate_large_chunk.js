@@ -0,0 +1,42 @@
+// Chunks too large to move either come back with keys to split them at or, when they hold a
+// single shard key value and can't be split, are cloned off the shard key index.
+
+var s = new ShardingTest( "migrate_large_chunk" , 2 /* numShards */, 1 /* verboseLevel */,
+                          1 /* numMongos */, { chunksize : 1 } );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+s.adminCommand( { shardcollection : "test.bar" , key : { x : 1 } } );
+s.stopBalancer();
+
+var db = s.getDB( "test" );
+
+var big = "";
+while ( big.length < 10000 )
+    big += ".";
+
+// ~5MB in one chunk, over many shard key values
+for ( var i = 0; i < 500; i++ )
+    db.foo.insert( { x : i , big : big } );
+
+// ~5MB in one chunk, all with the same shard key value
+for ( var i = 0; i < 500; i++ )
+    db.bar.insert( { x : 1 , big : big } );
+
+db.getLastError();
+
+var other = s.getOther( s.getServer( "test" ) ).name;
+
+var res = s.getDB( "admin" ).runCommand( { moveChunk : "test.foo" , find : { x : 0 } , to : other } );
+printjson( res );
+assert( ! res.ok , "large chunk moved" );
+assert( res.cause.chunkTooBig , "chunk not reported too big" );
+assert( res.cause.splitKeys && res.cause.splitKeys.length > 0 , "no split keys for a divisible chunk" );
+
+res = s.getDB( "admin" ).runCommand( { moveChunk : "test.bar" , find : { x : 1 } , to : other } );
+printjson( res );
+assert( res.ok , "single key chunk didn't move" );
+assert.eq( 500 , s.shard1.getDB( "test" ).bar.count() + s.shard0.getDB( "test" ).bar.count() );
+assert.eq( 500 , db.bar.find().itcount() );
+
+s.stop();
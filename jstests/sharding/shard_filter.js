@@ -0,0 +1,61 @@
+// Queries on a shard leave out orphans, the documents it holds outside the chunks it owns, whether
+// they're checked from an index on the shard key or from the documents themselves.
+
+var s = new ShardingTest("shard_filter", 2, 0, 1);
+var admin = s.getDB("admin");
+
+assert.commandWorked(admin.runCommand({ enablesharding: "test" }));
+assert.commandWorked(admin.runCommand({ shardcollection: "test.foo", key: { x: 1 } }));
+var coll = s.getDB("test").foo;
+for (var i = 0; i < 100; i++) {
+    coll.insert({ _id: i, x: i, y: i % 10 });
+}
+coll.ensureIndex({ x: 1, y: 1 });
+coll.ensureIndex({ y: 1 });
+assert.isnull(s.getDB("test").getLastError());
+
+var primary = s.getServer("test");
+var other = s.getOther(primary);
+assert.commandWorked(admin.runCommand({ split: "test.foo", middle: { x: 50 } }));
+assert.commandWorked(admin.runCommand({ moveChunk: "test.foo", find: { x: 50 },
+                                        to: other.name, _waitForDelete: true }));
+
+// orphans in the chunk the primary gave away
+var direct = primary.getDB("test").foo;
+for (var i = 0; i < 5; i++) {
+    direct.insert({ _id: "orphan" + i, x: 60 + i, y: 3 });
+}
+assert.isnull(primary.getDB("test").getLastError());
+assert.eq(55, direct.count());
+
+function check(query, hint, expected) {
+    var cursor = coll.find(query);
+    if (hint) {
+        cursor = cursor.hint(hint);
+    }
+    assert.eq(expected, cursor.itcount(), tojson(query) + " " + tojson(hint));
+}
+
+check({}, null, 100);
+check({ x: { $gte: 40, $lt: 70 } }, { x: 1, y: 1 }, 30);
+check({ x: { $gte: 40, $lt: 70 } }, { $natural: 1 }, 30);
+check({ y: 3 }, { y: 1 }, 10);
+check({ y: 3 }, { $natural: 1 }, 10);
+assert.eq(10, coll.find({ x: { $gte: 55 }, y: 3 }, { _id: 0, x: 1, y: 1 })
+                  .hint({ x: 1, y: 1 }).itcount());
+
+// and the stage, run on the shard
+var res = primary.getDB("test").runCommand({ stageDebug: {
+    shardFilter: { args: { name: "foo", node: {
+        ixscan: { args: { name: "foo", indexKeyPattern: { x: 1, y: 1 }, start: { x: 0, y: 0 },
+                          stop: { x: 100, y: 100 }, endInclusive: true, direction: 1,
+                          needKeyData: true } } } } } } });
+assert.commandWorked(res);
+assert.eq(50, res.results.length, tojson(res));
+
+res = primary.getDB("test").runCommand({ stageDebug: {
+    shardFilter: { args: { name: "foo", node: { cscan: { args: { name: "foo" } } } } } } });
+assert.commandWorked(res);
+assert.eq(50, res.results.length, tojson(res));
+
+s.stop();
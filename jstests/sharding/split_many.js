@@ -0,0 +1,34 @@
+// The split command's middles option splits at many keys with one commit per chunk they fall in,
+// here against three config servers.
+
+var s = new ShardingTest("split_many", 1, 0, 1, { sync: true });
+var admin = s.getDB("admin");
+
+assert.commandWorked(admin.runCommand({ enablesharding: "test" }));
+assert.commandWorked(admin.runCommand({ shardcollection: "test.foo", key: { x: 1 } }));
+assert.commandWorked(admin.runCommand({ split: "test.foo", middle: { x: 500 } }));
+assert.eq(2, s.config.chunks.count({ ns: "test.foo" }));
+
+// keys in both chunks, out of order, with a repeat and an existing bound
+var middles = [ { x: 500 } ];
+for (var i = 999; i > 0; i -= 10) {
+    middles.push({ x: i });
+}
+middles.push({ x: 9 });
+var res = admin.runCommand({ split: "test.foo", middles: middles });
+assert.commandWorked(res);
+assert.eq(100, res.splits, tojson(res));
+assert.eq(102, s.config.chunks.count({ ns: "test.foo" }));
+assert.eq(1, s.config.chunks.count({ ns: "test.foo", min: { x: 489 }, max: { x: 499 } }));
+assert.eq(1, s.config.chunks.count({ ns: "test.foo", min: { x: 499 }, max: { x: 500 } }));
+
+// a second run has nothing left to do
+res = admin.runCommand({ split: "test.foo", middles: middles });
+assert.commandWorked(res);
+assert.eq(0, res.splits);
+
+assert.commandFailed(admin.runCommand({ split: "test.foo", middles: [ { y: 1 } ] }));
+assert.commandFailed(admin.runCommand({ split: "test.foo", middle: { x: 1 },
+                                         middles: [ { x: 2 } ] }));
+
+s.stop();
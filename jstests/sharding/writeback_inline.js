@@ -0,0 +1,50 @@
+//
+// Tests that writes sent through a stale mongos with inlineWritebacks set are replayed from
+// getLastError and land on the right shard
+//
+
+var st = new ShardingTest({ shards : 2,
+                            mongos : 2,
+                            other : { separateConfig : true,
+                                      mongosOptions : { setParameter : "inlineWritebacks=1" } } })
+
+st.stopBalancer()
+
+var mongosA = st.s0
+var mongosB = st.s1
+var admin = mongosA.getDB( "admin" )
+
+var collA = mongosA.getCollection( jsTestName() + ".coll" )
+var collB = mongosB.getCollection( "" + collA )
+
+printjson( admin.runCommand({ enableSharding : "" + collA.getDB() }) )
+printjson( admin.runCommand({ movePrimary : "" + collA.getDB(), to : st.shard0.shardName }) )
+printjson( admin.runCommand({ shardCollection : "" + collA, key : { _id : 1 } }) )
+printjson( admin.runCommand({ split : "" + collA, middle : { _id : 0 } }) )
+
+// Make mongosB learn the current version, then move a chunk behind its back
+collB.insert({ _id : -1 })
+assert.eq( null, collB.getDB().getLastError() )
+
+printjson( admin.runCommand({ moveChunk : "" + collA,
+                              find : { _id : 0 },
+                              to : st.shard1.shardName,
+                              _waitForDelete : true }) )
+
+jsTest.log( "Writing through the stale mongos..." )
+
+for ( var i = 0; i < 10; i++ ) {
+    collB.insert({ _id : i })
+    assert.eq( null, collB.getDB().getLastError() )
+}
+
+collB.update({ _id : 5 }, { $set : { updated : true } })
+var gle = collB.getDB().getLastErrorObj()
+assert.eq( null, gle.err, tojson( gle ) )
+assert.eq( 1, gle.n, tojson( gle ) )
+
+assert.eq( 11, collA.find().itcount() )
+assert.eq( 10, st.shard1.getCollection( "" + collA ).find().itcount() )
+assert( collA.findOne({ _id : 5 }).updated )
+
+st.stop()
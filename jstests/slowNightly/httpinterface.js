@@ -14,3 +14,12 @@ assert.neq(null,
            mongo, 
            "the web interface should be running on " + (conn.port + 1000));
 MongoRunner.stopMongod(conn);
+
+// and with its requests served by a pool of threads
+conn = MongoRunner.runMongod({ port:port, smallfiles: "", httpinterface: "",
+                               setParameter: "httpWorkerThreads=4" });
+mongo = new Mongo('localhost:'+(conn.port+1000))
+assert.neq(null,
+           mongo,
+           "the pooled web interface should be running on " + (conn.port + 1000));
+MongoRunner.stopMongod(conn);
@@ -0,0 +1,38 @@
+/**
+ * Checks that the TTL monitor deletes all expired documents when it has to take several
+ * batches to do so.  Sets ttlDeleteBatchSize well below the number of expired documents,
+ * waits for a pass (the TTL monitor runs every 60 seconds) and checks that every expired
+ * document went, over more than one batch.
+ */
+
+var t = db.ttl_batches;
+t.drop();
+
+var batchSize = 10;
+assert.commandWorked( db.adminCommand( { setParameter : 1, ttlDeleteBatchSize : batchSize } ) );
+
+var now = (new Date()).getTime();
+var old = new Date( now - 3600 * 1000 );
+for ( i = 0; i < 95; i++ ) {
+    t.insert( { x : old } );
+}
+for ( i = 0; i < 5; i++ ) {
+    t.insert( { x : new Date( now + 3600 * 1000 ) } );
+}
+db.getLastError();
+assert.eq( 100 , t.count() );
+
+var batchesBefore = db.serverStatus().metrics.ttl.deleteBatches;
+
+t.ensureIndex( { x : 1 } , { expireAfterSeconds : 60 } );
+
+assert.soon(
+    function() {
+        return t.count() == 5;
+    }, "TTL index on x didn't delete every expired document" , 130 * 1000
+);
+
+assert.lte( batchesBefore + 95 / batchSize,
+            db.serverStatus().metrics.ttl.deleteBatches );
+
+assert.commandWorked( db.adminCommand( { setParameter : 1, ttlDeleteBatchSize : 1000 } ) );
@@ -32,3 +32,15 @@ assert.eq(res.ok, 1);
 assert.eq(res.results.length, 16);
 assert.eq(res.results[0].foo, 15);
 assert.eq(res.results[res.results.length - 1].foo, 0);
+
+// With explain the reply carries the stats of both stages.
+res = db.runCommand({stageDebug: limit1, explain: true});
+assert.eq(res.ok, 1);
+assert.eq(res.results.length, 5);
+assert.eq(res.stats.type, "LIMIT");
+assert.eq(res.stats.advanced, 5);
+assert(res.stats.isEOF);
+assert.eq(res.stats.children.length, 1);
+assert.eq(res.stats.children[0].type, "IXSCAN");
+assert.eq(res.stats.children[0].advanced, 5);
+assert.eq(res.stats.children[0].works, res.stats.works);
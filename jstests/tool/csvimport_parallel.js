@@ -0,0 +1,20 @@
+// csvimport_parallel.js: --numWorkers imports the same documents as a single threaded import
+
+t = new ToolTest( "csvimport_parallel" )
+
+c = t.startDB( "foo" );
+
+assert.eq( 0 , c.count() , "setup" );
+
+t.runTool( "import" , "--file" , "jstests/tool/data/csvimport1.csv" , "-d" , t.baseName , "-c" , "serial" , "--type" , "csv" , "--headerline" );
+serial = c.getDB().serial.find( {} , { _id : 0 } ).sort( { a : 1 } ).toArray();
+assert.eq( 5 , serial.length , "serial import" );
+
+t.runTool( "import" , "--file" , "jstests/tool/data/csvimport1.csv" , "-d" , t.baseName , "-c" , "foo" , "--type" , "csv" , "--headerline" , "--numWorkers" , "4" );
+assert.eq( tojson( serial ) , tojson( c.find( {} , { _id : 0 } ).sort( { a : 1 } ).toArray() ) , "ordered parallel import" );
+
+c.drop();
+t.runTool( "import" , "--file" , "jstests/tool/data/csvimport1.csv" , "-d" , t.baseName , "-c" , "foo" , "--type" , "csv" , "--headerline" , "--numWorkers" , "4" , "--unordered" );
+assert.eq( tojson( serial ) , tojson( c.find( {} , { _id : 0 } ).sort( { a : 1 } ).toArray() ) , "unordered parallel import" );
+
+t.stop()
@@ -0,0 +1,38 @@
+// the touch command, over whole collections and over index key ranges
+
+t = db.touch1;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ ) {
+    t.insert( { _id : i, a : i % 100, s : "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx" } );
+}
+t.ensureIndex( { a : 1 } );
+
+res = db.runCommand( { touch : "touch1" } );
+assert( !res.ok, "needs data or index" );
+
+res = db.runCommand( { touch : "touch1", data : true, index : true, threads : 3 } );
+assert( res.ok, tojson( res ) );
+assert.lt( 0, res.bytesTouched, tojson( res ) );
+
+res = db.runCommand( { touch : "touch1", indexes : [ { a : 1 }, "_id_" ] } );
+assert( res.ok, tojson( res ) );
+assert.lt( 0, res.bytesTouched, tojson( res ) );
+
+res = db.runCommand( { touch : "touch1", indexes : [ "b_1" ] } );
+assert( !res.ok, "no such index" );
+
+res = db.runCommand( { touch : "touch1", indexes : [ "a_1" ], min : { a : 10 }, max : { a : 19 },
+                       data : true } );
+assert( res.ok, tojson( res ) );
+assert.eq( 100, res.keysTouched, tojson( res ) );
+
+res = db.runCommand( { touch : "touch1", indexes : [ "a_1" ], min : { a : 95 } } );
+assert( res.ok, tojson( res ) );
+assert.eq( 50, res.keysTouched, tojson( res ) );
+
+res = db.runCommand( { touch : "touch1", index : true, min : { a : 10 } } );
+assert( !res.ok, "a range needs one index" );
+
+res = db.runCommand( { touch : "touch1", data : true, threads : 0 } );
+assert( !res.ok, "bad thread count" );
@@ -0,0 +1,48 @@
+// Updates that touch an indexed field but leave every index key as it was stay in place.
+// Only the new update framework applies updates in place.
+
+var stddb = db;
+var db = db.getSisterDB( "update_inplace_indexed" );
+var admin = stddb.getSisterDB( "admin" );
+
+t = db.update_inplace_indexed;
+t.drop();
+
+function getLastOp() {
+    var cursor = db.system.profile.find( { ns : t.getFullName() , op : "update" } );
+    return cursor.sort( { $natural : -1 } ).limit( 1 )[0];
+}
+
+var was = admin.runCommand( { getParameter : 1, newUpdateFrameworkEnabled : 1 } );
+assert.commandWorked( admin.runCommand( { setParameter : 1, newUpdateFrameworkEnabled : true } ) );
+
+try {
+    t.ensureIndex( { "a.b" : 1 } );
+    t.insert( { _id : 1, a : [ { b : 1 }, { b : 2 }, { b : 2 } ] } );
+
+    db.setProfilingLevel( 2 );
+
+    // The keys stay { 1, 2 }.
+    t.update( { _id : 1 }, { $set : { "a.2.b" : 1 } } );
+    assert.isnull( db.getLastError() );
+    assert( getLastOp().fastmod, tojson( getLastOp() ) );
+    assert.eq( 1, t.findOne().a[2].b );
+
+    // The keys become { 1, 3 }, so the index has to change.
+    t.update( { _id : 1 }, { $set : { "a.1.b" : 3 } } );
+    assert.isnull( db.getLastError() );
+    assert( !getLastOp().fastmod, tojson( getLastOp() ) );
+
+    db.setProfilingLevel( 0 );
+
+    assert.eq( 1, t.find( { "a.b" : 3 } ).hint( { "a.b" : 1 } ).itcount() );
+    assert.eq( 0, t.find( { "a.b" : 2 } ).hint( { "a.b" : 1 } ).itcount() );
+    assert.eq( 1, t.find( { "a.b" : 1 } ).hint( { "a.b" : 1 } ).itcount() );
+    assert( t.validate().valid );
+}
+finally {
+    db.setProfilingLevel( 0 );
+    admin.runCommand( { setParameter : 1,
+                        newUpdateFrameworkEnabled : was.newUpdateFrameworkEnabled } );
+    db = stddb;
+}
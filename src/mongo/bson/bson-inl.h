@@ -263,11 +263,19 @@ dodouble:
     }
 
     inline BSONElement BSONObj::getField(const StringData& name) const {
-        BSONObjIterator i(*this);
-        while ( i.more() ) {
-            BSONElement e = i.next();
-            if ( name == e.fieldName() )
+        // Each field name is measured once: the length rejects most names without comparing
+        // them, and is kept in the element so stepping past it doesn't measure it again.
+        const char* pos = objdata() + 4;
+        const char* const end = objdata() + objsize() - 1;
+        while ( pos < end ) {
+            BSONElement e( pos );
+            if ( e.eoo() )
+                break;
+            const size_t len = strlen( e.fieldName() );
+            e.fieldNameSize_ = static_cast<int>( len ) + 1;
+            if ( len == name.size() && memcmp( e.fieldName(), name.rawData(), len ) == 0 )
                 return e;
+            pos += e.size();
         }
         return BSONElement();
     }
@@ -27,4 +27,18 @@ namespace {
         ASSERT_EQUALS(text, o1_str);
     }
 
+    TEST(GetField, MatchesWholeName) {
+        mongo::BSONObj obj = mongo::fromjson("{ab: 1, a: 2, abc: 3, '': 4}");
+        ASSERT_EQUALS(2, obj.getField("a").numberInt());
+        ASSERT_EQUALS(1, obj.getField("ab").numberInt());
+        ASSERT_EQUALS(3, obj.getField("abc").numberInt());
+        ASSERT_EQUALS(4, obj.getField("").numberInt());
+        ASSERT(obj.getField("abcd").eoo());
+        ASSERT(obj.getField("b").eoo());
+        ASSERT(mongo::BSONObj().getField("a").eoo());
+
+        // The element found can still be stepped past.
+        ASSERT_EQUALS(obj.getField("a").size(), obj.getField("a").fieldNameSize() + 5);
+    }
+
 } // unnamed namespace
@@ -15,7 +15,7 @@
  *    limitations under the License.
  */
 
-#include <deque>
+#include <vector>
 
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
@@ -127,6 +127,40 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * A stack of frames that only allocates once objects nest deeper than kInlineFrames.
+         * Pointers to the top frame stay valid until the next push().
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size(0) { }
+
+            void push() {
+                if (_size >= kInlineFrames)
+                    _spilled.push_back(ValidationObjectFrame());
+                ++_size;
+            }
+
+            void pop() {
+                if (_size > kInlineFrames)
+                    _spilled.pop_back();
+                --_size;
+            }
+
+            ValidationObjectFrame* top() {
+                return _size > kInlineFrames ? &_spilled.back() : &_inline[_size - 1];
+            }
+
+            bool empty() const { return 0 == _size; }
+
+        private:
+            static const size_t kInlineFrames = 16;
+
+            ValidationObjectFrame _inline[kInlineFrames];
+            std::vector<ValidationObjectFrame> _spilled;
+            size_t _size;
+        };
+
         Status validateElementInfo(Buffer* buffer, ValidationState::State* nextState) {
             Status status = Status::OK();
 
@@ -222,15 +256,15 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
             while (state != ValidationState::Done) {
                 switch (state) {
                 case ValidationState::BeginObj:
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    frames.push();
+                    curr = frames.top();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(false);
                     if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -251,12 +285,12 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty()) {
                         state = ValidationState::Done;
                     }
                     else {
-                        curr = &frames.back();
+                        curr = frames.top();
                         if (curr->isCodeWithScope())
                             state = ValidationState::EndCodeWScope;
                         else
@@ -265,8 +299,8 @@ namespace mongo {
                     break;
                 }
                 case ValidationState::BeginCodeWScope: {
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    frames.push();
+                    curr = frames.top();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(true);
                     if ( !buffer->readNumber<int>( &curr->expectedSize ) )
@@ -283,10 +317,10 @@ namespace mongo {
                         return Status( ErrorCodes::InvalidBSON,
                                        "bson length for CodeWScope doesn't match what we found" );
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty())
                         return Status(ErrorCodes::InvalidBSON, "unnested CodeWScope");
-                    curr = &frames.back();
+                    curr = frames.top();
                     state = ValidationState::WithinObj;
                     break;
                 }
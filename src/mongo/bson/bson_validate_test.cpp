@@ -213,4 +213,13 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    TEST(BSONValidateFast, DeeplyNested) {
+        BSONObj x = BSON("x" << 1);
+        for (int i = 0; i < 40; ++i) {
+            x = BSON("a" << x << "b" << BSON_ARRAY(i));
+        }
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+        ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() - 1));
+    }
+
 }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <iosfwd>
 #include <string.h> // strlen
 #include <string>
 #include <vector>
@@ -105,6 +106,9 @@ namespace mongo {
         std::string toString( bool includeFieldName = true, bool full=false) const;
         void toString(StringBuilder& s, bool includeFieldName = true, bool full=false, int depth=0) const;
         std::string jsonString( JsonStringFormat format, bool includeFieldNames = true, int pretty = 0 ) const;
+        /** as jsonString(), but written to 's' rather than built up and returned */
+        void jsonStringStream( JsonStringFormat format, bool includeFieldNames, int pretty,
+                               std::ostream& s ) const;
         operator std::string() const { return toString(); }
 
         /** Returns the type of the element */
@@ -152,6 +152,10 @@ namespace mongo {
         */
         std::string jsonString( JsonStringFormat format = Strict, int pretty = 0 ) const;
 
+        /** as jsonString(), but written to 's' rather than built up and returned; nested
+            objects and arrays are written in place rather than as strings of their own */
+        void jsonStringStream( JsonStringFormat format, int pretty, std::ostream& s ) const;
+
         /** note: addFields always adds _id even if not specified */
         int addFields(BSONObj& from, std::set<std::string>& fields); /* returns n added */
 
@@ -586,6 +586,31 @@ namespace mutablebson {
 
         }
 
+        // Drop all elements and objects, keeping the capacity of the containers, and go back
+        // to the state of a newly constructed Impl.
+        void reset(Document::InPlaceMode inPlaceMode) {
+            _elements.clear();
+            _objects.clear();
+            _fieldNames.clear();
+
+            // The leaf builder was created over an empty buffer and never done(), so emptying
+            // the buffer and skipping the size again puts it back where its constructor left
+            // it.
+            _leafBuf.reset();
+            _leafBuf.skip(4);
+            _objects.push_back(_leafBuilder.asTempObj());
+
+            if (inPlaceMode == Document::kInPlaceEnabled) {
+                if (_damages)
+                    _damages->clear();
+                else
+                    _damages.reset(new DamageVector);
+            }
+            else {
+                _damages.reset();
+            }
+        }
+
         // Obtain the ElementRep for the given rep id.
         ElementRep& getElementRep(Element::RepIdx id) {
             dassert(id < _elements.size());
@@ -828,6 +853,31 @@ namespace mutablebson {
             return rep->sibling.right;
         }
 
+        // If the right siblings of the Element with index 'index' have never been resolved,
+        // they are an untouched run of the BSON its parent was built from: every change that
+        // could affect a sibling resolves it first. Sets 'begin' and 'size' to that run, which
+        // ends just before the parent's EOO, and returns true. Returns false if the right
+        // sibling is not opaque.
+        bool getOpaqueRightSiblings(Element::RepIdx index,
+                                    const char** begin, size_t* size) const {
+            const ElementRep& rep = getElementRep(index);
+            if (rep.sibling.right != kOpaqueRepIdx)
+                return false;
+
+            // Only the root has no element of its own, and its object is stored directly.
+            const ElementRep& parentRep = getElementRep(rep.parent);
+            const BSONObj parentObj = (rep.parent == kRootRepIdx) ?
+                getObject(parentRep.objIdx) :
+                getSerializedElement(parentRep).embeddedObject();
+
+            const BSONElement elt = getSerializedElement(rep);
+            *begin = elt.rawdata() + elt.size();
+            const char* const end = parentObj.objdata() + parentObj.objsize() - 1;
+            dassert(*begin <= end);
+            *size = end - *begin;
+            return true;
+        }
+
         // Find the ElementRep at index 'index', and mark it and all of its currently
         // serialized parents as non-serialized.
         void deserialize(Element::RepIdx index) {
@@ -2100,6 +2150,18 @@ namespace mutablebson {
             BufBuilder& buffer;
         };
 
+        // Another helper for Element::writeChildren below: appends a run of complete BSON
+        // elements verbatim. Only objects can take one; the elements of an array would need
+        // their field names renumbered unless the run started at the same index.
+        inline bool appendElementRun(BSONObjBuilder* builder, const char* begin, size_t size) {
+            builder->bb().appendBuf(begin, size);
+            return true;
+        }
+
+        inline bool appendElementRun(BSONArrayBuilder*, const char*, size_t) {
+            return false;
+        }
+
     } // namespace
 
     template<typename Builder>
@@ -2140,21 +2202,25 @@ namespace mutablebson {
         // No need to verify(ok()) since we are only called from methods that have done so.
         dassert(ok());
 
-        // TODO: In theory, I think we can walk rightwards building a write region from all
-        // serialized embedded children that share an obj id and form a contiguous memory
-        // region. For arrays we would need to know something about how many elements we wrote
-        // that way so that the indexes would come out right.
+        // Siblings that were never resolved are still contiguous in the original BSON, so
+        // once we reach one we can copy all of them at once, without making ElementReps for
+        // them. That turns an update to one field of a large document into a copy of the
+        // runs around the change, rather than a walk of every field.
         //
-        // Also in theory instead of walking all the way right, we can walk right until we hit
-        // an opaque node. Then we can bulk copy the opaque region, maybe? Probably that
-        // doesn't work for arrays.
-        //
-        // However, both of the above ideas involve walking the memory twice: once two build
-        // the copy region, and another time to actually copy it. It is unclear if this is
-        // better than just walking it once with the recursive solution.
+        // Resolved siblings that happen to be unchanged are still written one at a time;
+        // finding the contiguous runs among them would mean walking them twice.
+        const Document::Impl& impl = getDocument().getImpl();
+
         Element current = leftChild();
         while (current.ok()) {
             current.writeElement(builder);
+
+            const char* begin = NULL;
+            size_t size = 0;
+            if (impl.getOpaqueRightSiblings(current._repIdx, &begin, &size) &&
+                appendElementRun(builder, begin, size))
+                break;
+
             current = current.rightSibling();
         }
     }
@@ -2173,6 +2239,19 @@ namespace mutablebson {
 
     Document::~Document() {}
 
+    void Document::reset() {
+        getImpl().reset(Document::kInPlaceDisabled);
+        // The new root takes the same rep as the old one, so '_root' still refers to it.
+        const StringData rootName(kRootFieldName, StringData::LiteralTag());
+        verify(makeElementObject(rootName)._repIdx == kRootRepIdx);
+    }
+
+    void Document::reset(const BSONObj& value, InPlaceMode inPlaceMode) {
+        getImpl().reset(inPlaceMode);
+        const StringData rootName(kRootFieldName, StringData::LiteralTag());
+        verify(makeElementObject(rootName, value)._repIdx == kRootRepIdx);
+    }
+
     void Document::reserveDamageEvents(size_t expectedEvents) {
         return getImpl().reserveDamageEvents(expectedEvents);
     }
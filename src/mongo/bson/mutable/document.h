@@ -246,6 +246,15 @@ namespace mutablebson {
 
         ~Document();
 
+        /** Makes this an empty document, as if newly constructed, but keeps the storage it
+         *  has grown so reusing one Document for many objects doesn't reallocate it. All
+         *  existing Elements of this document, other than root(), become invalid.
+         */
+        void reset();
+
+        /** As above, but for the given BSONObj, as if constructed with these arguments. */
+        void reset(const BSONObj& value, InPlaceMode inPlaceMode = kInPlaceEnabled);
+
 
         //
         // Comparison API
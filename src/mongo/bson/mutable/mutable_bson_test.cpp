@@ -2875,4 +2875,77 @@ namespace {
         ASSERT_NOT_EQUALS(mmb::ignoreFieldOrder(d1), mmb::ignoreFieldOrder(d2));
     }
 
+    TEST(Document, ResetToNewObject) {
+        const mongo::BSONObj first = mongo::fromjson("{ a : 1, b : { c : 'x' } }");
+        const mongo::BSONObj second = mongo::fromjson("{ z : [ 1, 2 ] }");
+
+        mmb::Document doc(first);
+        ASSERT_OK(doc.root().appendInt("d", 4));
+        ASSERT_EQUALS(4, doc.root()["d"].getValueInt());
+
+        doc.reset(second);
+        ASSERT_EQUALS(second, doc.getObject());
+        ASSERT_FALSE(doc.root()["a"].ok());
+        ASSERT_EQUALS(mmb::Document::kInPlaceEnabled, doc.getCurrentInPlaceMode());
+
+        ASSERT_OK(doc.root().appendString("s", "value"));
+        ASSERT_EQUALS(mongo::fromjson("{ z : [ 1, 2 ], s : 'value' }"), doc.getObject());
+
+        doc.reset();
+        ASSERT_EQUALS(mongo::BSONObj(), doc.getObject());
+        ASSERT_EQUALS(mmb::Document::kInPlaceDisabled, doc.getCurrentInPlaceMode());
+    }
+
+    TEST(Document, ResetKeepsInPlaceUpdatesWorking) {
+        const mongo::BSONObj first = mongo::fromjson("{ a : 1 }");
+        const mongo::BSONObj second = mongo::fromjson("{ a : 2, b : 3 }");
+
+        mmb::Document doc(first);
+        ASSERT_OK(doc.root()["a"].setValueInt(5));
+
+        doc.reset(second);
+        mmb::DamageVector damages;
+        const char* source = NULL;
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        ASSERT_TRUE(damages.empty());
+
+        ASSERT_OK(doc.root()["b"].setValueInt(7));
+        ASSERT_TRUE(doc.getInPlaceUpdates(&damages, &source));
+        ASSERT_EQUALS(1U, damages.size());
+        ASSERT_EQUALS(mongo::fromjson("{ a : 2, b : 7 }"), doc.getObject());
+    }
+
+    TEST(Serialization, UntouchedSiblingsAroundADeepChange) {
+        const mongo::BSONObj original = mongo::fromjson(
+            "{ a : 1, b : { x : 1, y : 2, z : { q : 1 }, w : 4 }, c : [ 1, 2, 3 ], d : 's' }");
+
+        mmb::Document doc(original, mmb::Document::kInPlaceDisabled);
+        ASSERT_EQUALS(original, doc.getObject());
+
+        ASSERT_OK(doc.root()["b"]["y"].setValueInt(20));
+        ASSERT_EQUALS(mongo::fromjson(
+                          "{ a : 1, b : { x : 1, y : 20, z : { q : 1 }, w : 4 }, "
+                          "c : [ 1, 2, 3 ], d : 's' }"),
+                      doc.getObject());
+
+        // Arrays don't take runs, but their untouched elements must still come out.
+        ASSERT_OK(doc.root()["c"][0].setValueInt(10));
+        ASSERT_EQUALS(mongo::fromjson(
+                          "{ a : 1, b : { x : 1, y : 20, z : { q : 1 }, w : 4 }, "
+                          "c : [ 10, 2, 3 ], d : 's' }"),
+                      doc.getObject());
+
+        ASSERT_OK(doc.root()["b"]["x"].remove());
+        ASSERT_EQUALS(mongo::fromjson(
+                          "{ a : 1, b : { y : 20, z : { q : 1 }, w : 4 }, "
+                          "c : [ 10, 2, 3 ], d : 's' }"),
+                      doc.getObject());
+
+        ASSERT_OK(doc.root()["a"].addSiblingRight(doc.makeElementInt("e", 5)));
+        ASSERT_EQUALS(mongo::fromjson(
+                          "{ a : 1, e : 5, b : { y : 20, z : { q : 1 }, w : 4 }, "
+                          "c : [ 10, 2, 3 ], d : 's' }"),
+                      doc.getObject());
+    }
+
 } // namespace
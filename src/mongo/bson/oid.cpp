@@ -25,6 +25,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/oid.h"
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/util/concurrency/threadlocal.h"
 
 #define verify MONGO_verify
 
@@ -96,12 +97,51 @@ namespace mongo {
         ourMachineAndPid = x;
     }
 
-    void OID::init() {
-        static AtomicUInt inc = static_cast<unsigned>(
-            scoped_ptr<SecureRandom>(SecureRandom::create())->nextInt64());
+    namespace {
+        // incs are handed to threads in blocks of this many, so that threads generating ids
+        // don't all increment one counter
+        const unsigned kIncBlockSize = 128;
+
+        AtomicUInt32& incSequence() {
+            static AtomicUInt32 inc( static_cast<unsigned>(
+                scoped_ptr<SecureRandom>(SecureRandom::create())->nextInt64()) );
+            return inc;
+        }
+
+        /**
+         * The rest of the block of incs a thread last took.  A block is only used within the
+         * second it was taken in, so ids only collide if the counter goes through all 2^24
+         * incs in one second, as without blocks.
+         */
+        struct IncBlock {
+            IncBlock() : next( 0 ), left( 0 ), time( 0 ) { }
+            unsigned next;
+            unsigned left;
+            unsigned time;
+        };
+    }
 
+    TSP_DECLARE(IncBlock, currentIncBlock)
+    TSP_DEFINE(IncBlock, currentIncBlock)
+
+    unsigned OID::_takeIncs( unsigned n, unsigned t ) {
+        if ( n > kIncBlockSize )
+            return incSequence().fetchAndAdd( n );
+
+        IncBlock* block = currentIncBlock.getMake();
+        if ( block->left < n || block->time != t ) {
+            block->next = incSequence().fetchAndAdd( kIncBlockSize );
+            block->left = kIncBlockSize;
+            block->time = t;
+        }
+        const unsigned first = block->next;
+        block->next += n;
+        block->left -= n;
+        return first;
+    }
+
+    void OID::_init( unsigned t, unsigned inc ) {
         {
-            unsigned t = (unsigned) time(0);
             unsigned char *T = (unsigned char *) &t;
             _time[0] = T[3]; // big endian order because we use memcmp() to compare OID's
             _time[1] = T[2];
@@ -112,14 +152,26 @@ namespace mongo {
         _machineAndPid = ourMachineAndPid;
 
         {
-            int new_inc = inc++;
-            unsigned char *T = (unsigned char *) &new_inc;
+            unsigned char *T = (unsigned char *) &inc;
             _inc[0] = T[2];
             _inc[1] = T[1];
             _inc[2] = T[0];
         }
     }
 
+    void OID::init() {
+        const unsigned t = (unsigned) time(0);
+        _init( t, _takeIncs( 1, t ) );
+    }
+
+    void OID::initBatch( OID* oids, size_t n ) {
+        const unsigned t = (unsigned) time(0);
+        unsigned inc = _takeIncs( static_cast<unsigned>( n ), t );
+        for ( size_t i = 0; i < n; i++ ) {
+            oids[i]._init( t, inc++ );
+        }
+    }
+
     static AtomicUInt64 _initSequential_sequence;
     void OID::initSequential() {
 
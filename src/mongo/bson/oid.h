@@ -75,9 +75,20 @@ namespace mongo {
 
         static OID gen() { OID o; o.init(); return o; }
 
-        /** sets the contents to a new oid / randomized value */
+        /**
+         * sets the contents to a new oid / randomized value
+         *
+         * Ids from one thread increase; ids from different threads generated in the same
+         * second needn't be in the order they were generated in.
+         */
         void init();
 
+        /**
+         * Sets each of 'n' oids to a new one, as init() would.  They increase in the order
+         * they are in, and take at most one increment of the process wide counter.
+         */
+        static void initBatch( OID* oids, size_t n );
+
         /** sets the contents to a new oid
          * guaranteed to be sequential
          * NOT guaranteed to be globally unique
@@ -137,6 +148,10 @@ namespace mongo {
             unsigned char data[kOIDSize];
         };
 
+        /** @return the first of 'n' consecutive incs for ids made at time 't' */
+        static unsigned _takeIncs( unsigned n, unsigned t );
+        void _init( unsigned t, unsigned inc );
+
         static void foldInPid(MachineAndPid& x);
         static MachineAndPid genMachineAndPid();
     };
@@ -0,0 +1,134 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/bson/util/builder.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace mongo {
+
+    namespace {
+        class BufBuilderBufferCache : boost::noncopyable {
+        public:
+            enum {
+                MIN_BUFFER_BYTES = 512, // the default BufBuilder size
+                NUM_BUFFER_SIZES = 8, // 512 bytes through 64KB
+                MAX_PER_SIZE = 4,
+                MAX_CACHED_BYTES = 128 * 1024,
+            };
+
+            BufBuilderBufferCache() : _cachedBytes(0) {
+                for (int i = 0; i < NUM_BUFFER_SIZES; i++)
+                    _counts[i] = 0;
+            }
+
+            ~BufBuilderBufferCache() { clear(); }
+
+            void* get(size_t bytes) {
+                const int size = sizeIndex(bytes);
+                if (size < 0)
+                    return NULL;
+                // Buffers in a slot are anywhere from its size to twice that, so look for one
+                // big enough; most recently freed first.
+                for (int i = _counts[size] - 1; i >= 0; i--) {
+                    Entry& entry = _entries[size][i];
+                    if (entry.bytes < bytes)
+                        continue;
+                    void* out = entry.buffer;
+                    _cachedBytes -= entry.bytes;
+                    entry = _entries[size][--_counts[size]];
+                    return out;
+                }
+                return NULL;
+            }
+
+            bool put(void* buffer, size_t bytes) {
+                const int size = sizeIndex(bytes);
+                if (size < 0
+                        || _counts[size] >= MAX_PER_SIZE
+                        || _cachedBytes + bytes > size_t(MAX_CACHED_BYTES))
+                    return false;
+                Entry& entry = _entries[size][_counts[size]++];
+                entry.buffer = buffer;
+                entry.bytes = bytes;
+                _cachedBytes += bytes;
+                return true;
+            }
+
+            void clear() {
+                for (int size = 0; size < NUM_BUFFER_SIZES; size++) {
+                    for (int i = 0; i < _counts[size]; i++)
+                        free(_entries[size][i].buffer);
+                    _counts[size] = 0;
+                }
+                _cachedBytes = 0;
+            }
+
+        private:
+            struct Entry {
+                void* buffer;
+                size_t bytes;
+            };
+
+            /// Returns the slot for buffers of 'bytes' up to twice that, or -1 if they aren't cached.
+            static int sizeIndex(size_t bytes) {
+                size_t slotBytes = MIN_BUFFER_BYTES;
+                for (int size = 0; size < NUM_BUFFER_SIZES; size++, slotBytes *= 2) {
+                    if (bytes < slotBytes * 2)
+                        return bytes >= slotBytes ? size : -1;
+                }
+                return -1;
+            }
+
+            Entry _entries[NUM_BUFFER_SIZES][MAX_PER_SIZE];
+            int _counts[NUM_BUFFER_SIZES];
+            size_t _cachedBytes;
+        };
+    }
+
+    namespace {
+        // Not the TSP macros: their fast pointer is left dangling once the cache is destroyed
+        // at thread exit, and builders are still destroyed after that.  thread_specific_ptr
+        // gives back NULL then, and a cache made that late is cleaned up in turn.  Made on
+        // first use, since builders run in static initializers, and never destroyed.
+        boost::thread_specific_ptr<BufBuilderBufferCache>& bufBuilderBufferCache() {
+            static boost::thread_specific_ptr<BufBuilderBufferCache>* caches =
+                new boost::thread_specific_ptr<BufBuilderBufferCache>();
+            return *caches;
+        }
+
+        BufBuilderBufferCache* getCache() {
+            BufBuilderBufferCache* cache = bufBuilderBufferCache().get();
+            if (!cache)
+                bufBuilderBufferCache().reset(cache = new BufBuilderBufferCache());
+            return cache;
+        }
+    }
+
+    void* BufBuilderCache::get(size_t sz) {
+        return getCache()->get(sz);
+    }
+
+    bool BufBuilderCache::put(void* p, size_t sz) {
+        return getCache()->put(p, sz);
+    }
+
+    void BufBuilderCache::clear() {
+        if (BufBuilderBufferCache* cache = bufBuilderBufferCache().get())
+            cache->clear();
+    }
+
+}  // namespace mongo
@@ -62,11 +62,35 @@ namespace mongo {
     template <typename Allocator>
     class StringBuilderImpl;
 
+    /**
+     * Recently freed BufBuilder buffers of 512 bytes to 64KB, kept per thread so that the next
+     * builder of about the same size can take one instead of going to malloc.  Buffers come
+     * from malloc and may be handed on with decouple() and freed with free() like any other.
+     */
+    class BufBuilderCache {
+    public:
+        /** @return a cached buffer of at least 'sz' bytes, or NULL if there's none */
+        static void* get(size_t sz);
+
+        /** Caches 'p', of 'sz' bytes, if there's room; @return false if the caller must free it */
+        static bool put(void* p, size_t sz);
+
+        /** Frees every buffer the calling thread has cached. */
+        static void clear();
+    };
+
     class TrivialAllocator { 
     public:
-        void* Malloc(size_t sz) { return malloc(sz); }
+        void* Malloc(size_t sz) {
+            if (void* cached = BufBuilderCache::get(sz))
+                return cached;
+            return malloc(sz);
+        }
         void* Realloc(void *p, size_t sz) { return realloc(p, sz); }
-        void Free(void *p) { free(p); }
+        void Free(void *p, size_t sz) {
+            if (!BufBuilderCache::put(p, sz))
+                free(p);
+        }
     };
 
     class StackAllocator {
@@ -87,7 +111,7 @@ namespace mongo {
             }
             return realloc(p, sz); 
         }
-        void Free(void *p) { 
+        void Free(void *p, size_t sz) { 
             if( p != buf )
                 free(p); 
         }
@@ -117,7 +141,7 @@ namespace mongo {
 
         void kill() {
             if ( data ) {
-                al.Free(data);
+                al.Free(data, size);
                 data = 0;
             }
         }
@@ -128,7 +152,7 @@ namespace mongo {
         void reset( int maxSize ) {
             l = 0;
             if ( maxSize && size > maxSize ) {
-                al.Free(data);
+                al.Free(data, size);
                 data = (char*)al.Malloc(maxSize);
                 if ( data == 0 )
                     msgasserted( 15913 , "out of memory BufBuilder::reset" );
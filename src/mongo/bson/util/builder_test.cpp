@@ -31,4 +31,47 @@ namespace mongo {
         ASSERT_EQUALS( 0, strcmp( bb.buf(), "eliot" ) );
         ASSERT_EQUALS( 0, strcmp( "eliot", bb.buf() ) );
     }
+
+    TEST( Builder, ReusesFreedBuffers ) {
+        BufBuilderCache::clear();
+        const char* first;
+        {
+            BufBuilder bb;
+            bb.appendStr( "eliot" );
+            first = bb.buf();
+        }
+        {
+            BufBuilder bb;
+            ASSERT_EQUALS( first, bb.buf() );
+
+            // taken out of the cache, so the next one gets a buffer of its own
+            BufBuilder other;
+            ASSERT_NOT_EQUALS( first, other.buf() );
+        }
+
+        {
+            BufBuilder big( 40 * 1024 );
+            first = big.buf();
+        }
+        {
+            // too small for the buffer just freed
+            BufBuilder bb;
+            ASSERT_NOT_EQUALS( first, bb.buf() );
+            BufBuilder big( 33 * 1024 );
+            ASSERT_EQUALS( first, big.buf() );
+        }
+        BufBuilderCache::clear();
+    }
+
+    TEST( Builder, DecouplesCachedBuffers ) {
+        BufBuilderCache::clear();
+        { BufBuilder bb; }
+        BufBuilder bb;
+        bb.appendStr( "eliot" );
+        char* decoupled = bb.buf();
+        bb.decouple();
+        ASSERT_EQUALS( 0, strcmp( decoupled, "eliot" ) );
+        free( decoupled );
+        BufBuilderCache::clear();
+    }
 }
@@ -23,6 +23,7 @@
 #include "syncclusterconnection.h"
 #include "../s/shard.h"
 #include "mongo/client/dbclient_rs.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -41,6 +42,8 @@ namespace mongo {
     }
 
     void PoolForHost::done( DBConnectionPool * pool, DBClientBase * c ) {
+        noteGone();
+
         if (c->isFailed()) {
             reportBadConnectionAt(c->getSockCreationMicroSec());
             pool->onDestroy(c);
@@ -88,6 +91,7 @@ namespace mongo {
             
             verify( sc.conn->getSoTimeout() == socketTimeout );
 
+            _checkedOut++;
             return sc.conn;
 
         }
@@ -137,8 +141,17 @@ namespace mongo {
                 stale.push_back( c.conn );
         }
 
-        for ( size_t i=0; i<all.size(); i++ ) {
-            _pool.push( all[i] );
+        size_t canReap = all.size() > _minIdlePerHost ? all.size() - _minIdlePerHost : 0;
+
+        // put back in the same order, reaping idle ones on the way
+        for ( size_t i = all.size(); i > 0; i-- ) {
+            const StoredConnection& c = all[i - 1];
+            if ( canReap > 0 && _maxIdleSecs > 0 && now - c.when > (time_t)_maxIdleSecs ) {
+                stale.push_back( c.conn );
+                canReap--;
+                continue;
+            }
+            _pool.push( c );
         }
     }
 
@@ -166,6 +179,10 @@ namespace mongo {
     }
 
     unsigned PoolForHost::_maxPerHost = 50;
+    unsigned PoolForHost::_maxInUsePerHost = 0;
+    unsigned PoolForHost::_maxWaitMillis = 30 * 1000;
+    unsigned PoolForHost::_minIdlePerHost = 0;
+    unsigned PoolForHost::_maxIdleSecs = 0;
 
     // ------ DBConnectionPool ------
 
@@ -182,7 +199,42 @@ namespace mongo {
         scoped_lock L(_mutex);
         PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
         p.initializeHostName(ident);
-        return p.get( this , socketTimeout );
+
+        Timer waitTimer;
+        bool waited = false;
+        while ( true ) {
+            DBClientBase* c = p.get( this , socketTimeout );
+            if ( ! c && p.canOpenMore() ) {
+                // the caller opens a new one, in the slot reserved here
+                p.reserveNew();
+            }
+            else if ( ! c ) {
+                long long remaining = static_cast<long long>( PoolForHost::getMaxWaitMillis() )
+                                     - waitTimer.millis();
+                if ( remaining > 0 ) {
+                    waited = true;
+                    _connectionFreed.timed_wait( L.boost(),
+                                                 boost::posix_time::milliseconds( remaining ) );
+                    continue;
+                }
+
+                p.noteWait( waitTimer.micros() );
+                uasserted( 16987, str::stream() << _name << ": timed out after "
+                                                << waitTimer.millis() << "ms waiting for one of "
+                                                << PoolForHost::getMaxInUsePerHost()
+                                                << " connections to " << ident );
+            }
+
+            if ( waited )
+                p.noteWait( waitTimer.micros() );
+            return c;
+        }
+    }
+
+    void DBConnectionPool::_cancelCreate( const string& host , double socketTimeout ) {
+        scoped_lock L(_mutex);
+        _pools[PoolKey(host,socketTimeout)].noteGone();
+        _connectionFreed.notify_all();
     }
 
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
@@ -199,6 +251,7 @@ namespace mongo {
         }
         catch ( std::exception & ) {
             delete conn;
+            _cancelCreate( host , socketTimeout );
             throw;
         }
 
@@ -213,13 +266,22 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _cancelCreate( url.toString() , socketTimeout );
                 throw;
             }
             return c;
         }
 
         string errmsg;
-        c = url.connect( errmsg, socketTimeout );
+        try {
+            c = url.connect( errmsg, socketTimeout );
+        }
+        catch ( std::exception& ) {
+            _cancelCreate( url.toString() , socketTimeout );
+            throw;
+        }
+        if ( ! c )
+            _cancelCreate( url.toString() , socketTimeout );
         uassert( 13328 ,  _name + ": connect failed " + url.toString() + " : " + errmsg , c );
 
         return _finishCreate( url.toString() , socketTimeout , c );
@@ -233,6 +295,7 @@ namespace mongo {
             }
             catch ( std::exception& ) {
                 delete c;
+                _cancelCreate( host , socketTimeout );
                 throw;
             }
             return c;
@@ -240,9 +303,19 @@ namespace mongo {
 
         string errmsg;
         ConnectionString cs = ConnectionString::parse( host , errmsg );
+        if ( ! cs.isValid() )
+            _cancelCreate( host , socketTimeout );
         uassert( 13071 , (string)"invalid hostname [" + host + "]" + errmsg , cs.isValid() );
 
-        c = cs.connect( errmsg, socketTimeout );
+        try {
+            c = cs.connect( errmsg, socketTimeout );
+        }
+        catch ( std::exception& ) {
+            _cancelCreate( host , socketTimeout );
+            throw;
+        }
+        if ( ! c )
+            _cancelCreate( host , socketTimeout );
         if ( ! c )
             throw SocketException( SocketException::CONNECT_ERROR , host , 11002 , str::stream() << _name << " error: " << errmsg );
         return _finishCreate( host , socketTimeout , c );
@@ -251,6 +324,13 @@ namespace mongo {
     void DBConnectionPool::release(const string& host, DBClientBase *c) {
         scoped_lock L(_mutex);
         _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        _connectionFreed.notify_all();
+    }
+
+    void DBConnectionPool::decrementEgressConnectionCount(const string& host, DBClientBase* conn) {
+        scoped_lock L(_mutex);
+        _pools[PoolKey(host,conn->getSoTimeout())].noteGone();
+        _connectionFreed.notify_all();
     }
 
 
@@ -321,6 +401,9 @@ namespace mongo {
 
         int avail = 0;
         long long created = 0;
+        int inUse = 0;
+        long long waits = 0;
+        long long waitMicros = 0;
 
 
         map<ConnectionString::ConnectionType,long long> createdByType;
@@ -339,10 +422,16 @@ namespace mongo {
                 BSONObjBuilder temp( bb.subobjStart( s ) );
                 temp.append( "available" , i->second.numAvailable() );
                 temp.appendNumber( "created" , i->second.numCreated() );
+                temp.append( "inUse" , i->second.numInUse() );
+                temp.appendNumber( "waits" , i->second.numWaits() );
+                temp.appendNumber( "waitMillis" , i->second.waitMicros() / 1000 );
                 temp.done();
 
                 avail += i->second.numAvailable();
                 created += i->second.numCreated();
+                inUse += i->second.numInUse();
+                waits += i->second.numWaits();
+                waitMicros += i->second.waitMicros();
 
                 long long& x = createdByType[i->second.type()];
                 x += i->second.numCreated();
@@ -378,6 +467,9 @@ namespace mongo {
 
         b.append( "totalAvailable" , avail );
         b.appendNumber( "totalCreated" , created );
+        b.append( "totalInUse" , inUse );
+        b.appendNumber( "totalWaits" , waits );
+        b.appendNumber( "totalWaitMillis" , waitMicros / 1000 );
     }
 
     bool DBConnectionPool::serverNameCompare::operator()( const string& a , const string& b ) const{
@@ -457,6 +549,66 @@ namespace mongo {
                 // we don't care if there was a socket error
             }
         }
+
+        _prewarm();
+    }
+
+    void DBConnectionPool::_prewarm() {
+        unsigned minIdle = PoolForHost::getMinIdlePerHost();
+        if ( minIdle == 0 )
+            return;
+
+        // reserve the slots inside the lock, but connect outside it
+        vector<PoolKey> toOpen;
+        {
+            scoped_lock lk( _mutex );
+            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
+                PoolForHost& p = i->second;
+
+                // only hosts that have been used
+                if ( p.numCreated() == 0 )
+                    continue;
+
+                for ( unsigned n = p.numAvailable(); n < minIdle && p.canOpenMore(); n++ ) {
+                    p.reserveNew();
+                    toOpen.push_back( i->first );
+                }
+            }
+        }
+
+        for ( size_t i=0; i<toOpen.size(); i++ ) {
+            const PoolKey& key = toOpen[i];
+            DBClientBase* conn = NULL;
+            try {
+                string errmsg;
+                ConnectionString cs = ConnectionString::parse( key.ident , errmsg );
+                if ( cs.isValid() )
+                    conn = cs.connect( errmsg , key.timeout );
+                if ( conn )
+                    onCreate( conn );
+                else
+                    LOG(1) << _name << ": couldn't prewarm connection to " << key.ident
+                           << causedBy( errmsg ) << endl;
+            }
+            catch ( std::exception& e ) {
+                LOG(1) << _name << ": couldn't prewarm connection to " << key.ident
+                       << causedBy( e ) << endl;
+                delete conn;
+                conn = NULL;
+            }
+
+            scoped_lock lk( _mutex );
+            PoolForHost& p = _pools[key];
+            if ( conn ) {
+                p.createdOne( conn );
+                // hands back the reserved slot and puts the connection with the idle ones
+                p.done( this , conn );
+            }
+            else {
+                p.noteGone();
+            }
+            _connectionFreed.notify_all();
+        }
     }
 
     // ------ ScopedDbConnection ------
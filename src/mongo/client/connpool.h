@@ -35,13 +35,18 @@ namespace mongo {
     class PoolForHost {
     public:
         PoolForHost()
-            : _created(0), _minValidCreationTimeMicroSec(0) {}
+            : _created(0), _minValidCreationTimeMicroSec(0), _checkedOut(0), _waits(0),
+              _waitMicros(0) {}
 
         PoolForHost( const PoolForHost& other ) {
             verify(other._pool.size() == 0);
             _created = other._created;
             _minValidCreationTimeMicroSec = other._minValidCreationTimeMicroSec;
+            _checkedOut = other._checkedOut;
+            _waits = other._waits;
+            _waitMicros = other._waitMicros;
             verify( _created == 0 );
+            verify( _checkedOut == 0 );
         }
 
         ~PoolForHost();
@@ -51,10 +56,44 @@ namespace mongo {
         void createdOne( DBClientBase * base );
         long long numCreated() const { return _created; }
 
+        /**
+         * Connections handed out, plus ones being opened, that haven't come back yet.
+         */
+        int numInUse() const { return _checkedOut; }
+
+        /**
+         * @return true if the per host limit allows opening another connection
+         */
+        bool canOpenMore() const {
+            return _maxInUsePerHost == 0 || numAvailable() + _checkedOut < _maxInUsePerHost;
+        }
+
+        /**
+         * Counts a connection about to be opened for a caller as in use, so concurrent
+         * callers can't go over the limit while it connects.
+         */
+        void reserveNew() { _checkedOut++; }
+
+        /**
+         * A connection counted by numInUse() went away without going through done().
+         */
+        void noteGone() {
+            if ( _checkedOut > 0 )
+                _checkedOut--;
+        }
+
+        void noteWait( long long micros ) {
+            _waits++;
+            _waitMicros += micros;
+        }
+        long long numWaits() const { return _waits; }
+        long long waitMicros() const { return _waitMicros; }
+
         ConnectionString::ConnectionType type() const { verify(_created); return _type; }
 
         /**
-         * gets a connection or return NULL
+         * gets a connection or return NULL. A connection returned counts as in use until
+         * done() or noteGone().
          */
         DBClientBase * get( DBConnectionPool * pool , double socketTimeout );
 
@@ -65,6 +104,10 @@ namespace mongo {
 
         void flush();
         
+        /**
+         * Removes connections that are broken, or that have been idle longer than the max
+         * idle time and aren't needed for the min idle count.
+         */
         void getStaleConnections( vector<DBClientBase*>& stale );
 
         /**
@@ -86,6 +129,23 @@ namespace mongo {
 
         static void setMaxPerHost( unsigned max ) { _maxPerHost = max; }
         static unsigned getMaxPerHost() { return _maxPerHost; }
+
+        // Most connections open to a host, idle or not, 0 for no limit. Callers over the
+        // limit wait for a connection to come back.
+        static void setMaxInUsePerHost( unsigned max ) { _maxInUsePerHost = max; }
+        static unsigned getMaxInUsePerHost() { return _maxInUsePerHost; }
+
+        // How long to wait when the max in use limit is reached
+        static void setMaxWaitMillis( unsigned millis ) { _maxWaitMillis = millis; }
+        static unsigned getMaxWaitMillis() { return _maxWaitMillis; }
+
+        // Idle connections kept open, and opened ahead of time, for hosts already in use
+        static void setMinIdlePerHost( unsigned min ) { _minIdlePerHost = min; }
+        static unsigned getMinIdlePerHost() { return _minIdlePerHost; }
+
+        // Idle connections beyond the minimum are closed after this long, 0 to keep them
+        static void setMaxIdleSecs( unsigned secs ) { _maxIdleSecs = secs; }
+        static unsigned getMaxIdleSecs() { return _maxIdleSecs; }
     private:
 
         struct StoredConnection {
@@ -104,7 +164,15 @@ namespace mongo {
         uint64_t _minValidCreationTimeMicroSec;
         ConnectionString::ConnectionType _type;
 
+        unsigned _checkedOut;
+        long long _waits;
+        long long _waitMicros;
+
         static unsigned _maxPerHost;
+        static unsigned _maxInUsePerHost;
+        static unsigned _maxWaitMillis;
+        static unsigned _minIdlePerHost;
+        static unsigned _maxIdleSecs;
     };
 
     class DBConnectionHook {
@@ -151,6 +219,12 @@ namespace mongo {
 
         void release(const string& host, DBClientBase *c);
 
+        /**
+         * Call when a connection from get() is destroyed instead of released, so it stops
+         * counting against the host's limit.
+         */
+        void decrementEgressConnectionCount(const string& host, DBClientBase* conn);
+
         void addHook( DBConnectionHook * hook ); // we take ownership
         void appendInfo( BSONObjBuilder& b );
 
@@ -187,6 +261,12 @@ namespace mongo {
         DBClientBase* _get( const string& ident , double socketTimeout );
 
         DBClientBase* _finishCreate( const string& ident , double socketTimeout, DBClientBase* conn );
+
+        /** Gives back the slot _get() reserved for a connection that couldn't be opened */
+        void _cancelCreate( const string& ident , double socketTimeout );
+
+        /** Opens connections to hosts that have fewer idle ones than the minimum */
+        void _prewarm();
         
         struct PoolKey {
             PoolKey( const std::string& i , double t ) : ident( i ) , timeout( t ) {}
@@ -205,6 +285,9 @@ namespace mongo {
         
         PoolMap _pools;
 
+        // notified when a connection comes back or goes away, for _get() callers at the limit
+        boost::condition _connectionFreed;
+
         // pointers owned by me, right now they leak on shutdown
         // _hooks itself also leaks because it creates a shutdown race condition
         list<DBConnectionHook*> * _hooks; 
@@ -290,6 +373,8 @@ namespace mongo {
             a bad state.  Destructor will do this too, but it is verbose.
         */
         void kill() {
+            if ( _conn )
+                pool.decrementEgressConnectionCount( _host, _conn );
             delete _conn;
             _conn = 0;
         }
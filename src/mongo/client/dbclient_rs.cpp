@@ -30,6 +30,7 @@
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/platform/random.h"
 #include "mongo/util/background.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/timer.h"
@@ -103,6 +104,89 @@ namespace mongo {
         return false;
     }
 
+    // draws the two candidates for _selectNodeByLatency
+    SimpleMutex _selectNodeRandomMutex("selectNodeRandom");
+    PseudoRandom _selectNodeRandom(static_cast<int64_t>(curTimeMicros64()));
+
+    /**
+     * Like _selectNode, but instead of taking the next eligible node round robin, draws two of
+     * the eligible local nodes (or of all the eligible nodes when none is local) at random
+     * and returns the one with the lower expectedWaitMillis.  A near node that is slow to
+     * answer or has a lot of requests queued loses to a less busy one, without every reader
+     * piling onto whichever node looked best last.
+     */
+    HostAndPort _selectNodeByLatency(const vector<ReplicaSetMonitor::Node>& nodes,
+                                     const BSONObj& readPreferenceTag,
+                                     bool secOnly,
+                                     int localThresholdMillis,
+                                     HostAndPort* lastHost /* in/out */,
+                                     bool* isPrimarySelected) {
+        vector<size_t> eligible;
+        vector<size_t> local;
+
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const ReplicaSetMonitor::Node& node = nodes[i];
+
+            if (!node.ok) {
+                LOG(2) << "dbclient_rs not selecting " << node << ", not currently ok" << endl;
+                continue;
+            }
+
+            if (secOnly && !node.okForSecondaryQueries()) {
+                LOG(3) << "dbclient_rs not selecting " << node
+                                  << ", not ok for secondary queries ("
+                                  << ( !node.secondary ? "not secondary" : "hidden" ) << ")"
+                                  << endl;
+                continue;
+            }
+
+            if (!node.matchesTag(readPreferenceTag)) {
+                continue;
+            }
+
+            eligible.push_back(i);
+            if (node.isLocalSecondary(localThresholdMillis)) {
+                local.push_back(i);
+            }
+        }
+
+        const vector<size_t>& candidates = local.empty() ? eligible : local;
+        if (candidates.empty()) {
+            LOG(3) << "dbclient_rs no node selected for tag " << readPreferenceTag << endl;
+            return HostAndPort();
+        }
+
+        size_t chosen = candidates[0];
+        if (candidates.size() > 1) {
+            size_t first;
+            size_t second;
+            {
+                SimpleMutex::scoped_lock lk(_selectNodeRandomMutex);
+                first = static_cast<uint32_t>(_selectNodeRandom.nextInt32()) % candidates.size();
+                second = static_cast<uint32_t>(_selectNodeRandom.nextInt32())
+                         % (candidates.size() - 1);
+            }
+            if (second >= first) {
+                second++;
+            }
+
+            chosen = candidates[first];
+            if (nodes[candidates[second]].expectedWaitMillis()
+                    < nodes[chosen].expectedWaitMillis()) {
+                chosen = candidates[second];
+            }
+        }
+
+        const ReplicaSetMonitor::Node& node = nodes[chosen];
+        LOG(2) << "dbclient_rs selecting " << node.addr << " by latency, "
+                          << node.latencyMillis << "ms with " << node.inFlight
+                          << " requests in flight" << endl;
+
+        *isPrimarySelected = node.ismaster;
+        *lastHost = node.addr;
+        return node.addr;
+    }
+
     /**
      * Selects the right node given the nodes to pick from and the preference.
      * This method does strict tag matching, and will not implicitly fallback
@@ -119,6 +203,7 @@ namespace mongo {
      *     never be NULL.
      * @param isPrimarySelected out parameter that is set to true if the returned host
      *     is a primary.
+     * @param latencyAware choose using _selectNodeByLatency instead.
      *
      * @return the host object of the node selected. If none of the nodes are
      *     eligible, returns an empty host. Cannot be NULL and valid only if returned
@@ -129,7 +214,13 @@ namespace mongo {
                             bool secOnly,
                             int localThresholdMillis,
                             HostAndPort* lastHost /* in/out */,
-                            bool* isPrimarySelected) {
+                            bool* isPrimarySelected,
+                            bool latencyAware) {
+        if (latencyAware) {
+            return _selectNodeByLatency(nodes, readPreferenceTag, secOnly, localThresholdMillis,
+                                        lastHost, isPrimarySelected);
+        }
+
         HostAndPort fallbackHost;
 
         // Implicit: start from index 0 if lastHost doesn't exist anymore
@@ -191,6 +282,35 @@ namespace mongo {
         return fallbackHost;
     }
 
+    /**
+     * Counts a read as in flight on a replica set member while in scope, and reports its
+     * round trip time to the monitor when done() is called.
+     */
+    class NodeRequestTracker : boost::noncopyable {
+    public:
+        NodeRequestTracker(ReplicaSetMonitorPtr monitor, const HostAndPort& host) :
+            _monitor(monitor), _host(host), _done(false) {
+            _monitor->notifyRequestStart(_host);
+        }
+
+        ~NodeRequestTracker() {
+            if (!_done) {
+                DESTRUCTOR_GUARD( _monitor->notifyRequestDone(_host, -1); )
+            }
+        }
+
+        void done() {
+            _done = true;
+            _monitor->notifyRequestDone(_host, _timer.millis());
+        }
+
+    private:
+        ReplicaSetMonitorPtr _monitor;
+        HostAndPort _host;
+        Timer _timer;
+        bool _done;
+    };
+
     /**
      * Extracts the read preference settings from the query document. Note that this method
      * assumes that the query is ok for secondaries so it defaults to
@@ -358,6 +478,7 @@ namespace mongo {
     }
 
     const double ReplicaSetMonitor::SOCKET_TIMEOUT_SECS = 5;
+    const double ReplicaSetMonitor::LATENCY_EWMA_WEIGHT = 0.25;
 
     // Must already be in _setsLock when constructing a new ReplicaSetMonitor. This is why you
     // should only create ReplicaSetMonitors from ReplicaSetMonitor::get and
@@ -366,7 +487,8 @@ namespace mongo {
         : _lock( "ReplicaSetMonitor instance" ),
           _checkConnectionLock( "ReplicaSetMonitor check connection lock" ),
           _name( name ), _master(-1),
-          _nextSlave(0), _failedChecks(0), _localThresholdMillis(cmdLine.defaultLocalThresholdMillis) {
+          _nextSlave(0), _failedChecks(0), _localThresholdMillis(cmdLine.defaultLocalThresholdMillis),
+          _latencyAwareReads(cmdLine.latencyAwareReads) {
 
         uassert( 13642 , "need at least 1 node for a replica set" , servers.size() > 0 );
 
@@ -837,6 +959,7 @@ namespace mongo {
                     // update ping time with smoothed moving averaged (1/4th the delta)
                     node.pingTimeMillis += (commandTime - node.pingTimeMillis) / 4;
                 }
+                node.noteLatency(commandTime);
 
                 node.hidden = o["hidden"].trueValue();
                 node.secondary = o["secondary"].trueValue();
@@ -1011,6 +1134,8 @@ namespace mongo {
             builder.append("hidden", node.hidden);
             builder.append("secondary", node.secondary);
             builder.append("pingTimeMillis", node.pingTimeMillis);
+            builder.append("latencyMillis", node.latencyMillis);
+            builder.append("inFlight", node.inFlight);
 
             const BSONElement& tagElem = node.lastIsMaster["tags"];
             if (tagElem.ok() && tagElem.isABSONObj()) {
@@ -1042,7 +1167,8 @@ namespace mongo {
         {
             scoped_lock lk(_lock);
             candidate = ReplicaSetMonitor::selectNode(_nodes, preference, tags,
-                    _localThresholdMillis, &_lastReadPrefHost, isPrimarySelected);
+                    _localThresholdMillis, &_lastReadPrefHost, isPrimarySelected,
+                    _latencyAwareReads);
         }
 
         if (candidate.empty()) {
@@ -1056,7 +1182,7 @@ namespace mongo {
             tags->reset();
             scoped_lock lk(_lock);
             return ReplicaSetMonitor::selectNode(_nodes, preference, tags, _localThresholdMillis,
-                    &_lastReadPrefHost, isPrimarySelected);
+                    &_lastReadPrefHost, isPrimarySelected, _latencyAwareReads);
         }
 
         return candidate;
@@ -1068,7 +1194,8 @@ namespace mongo {
                                               TagSet* tags,
                                               int localThresholdMillis,
                                               HostAndPort* lastHost,
-                                              bool* isPrimarySelected) {
+                                              bool* isPrimarySelected,
+                                              bool latencyAware) {
         *isPrimarySelected = false;
 
         switch (preference) {
@@ -1085,14 +1212,14 @@ namespace mongo {
         case ReadPreference_PrimaryPreferred:
         {
             HostAndPort candidatePri = selectNode(nodes, ReadPreference_PrimaryOnly, tags,
-                    localThresholdMillis, lastHost, isPrimarySelected);
+                    localThresholdMillis, lastHost, isPrimarySelected, latencyAware);
 
             if (!candidatePri.empty()) {
                 return candidatePri;
             }
 
             return selectNode(nodes, ReadPreference_SecondaryOnly, tags,
-                              localThresholdMillis, lastHost, isPrimarySelected);
+                              localThresholdMillis, lastHost, isPrimarySelected, latencyAware);
         }
 
         case ReadPreference_SecondaryOnly:
@@ -1101,7 +1228,7 @@ namespace mongo {
 
             while (!tags->isExhausted()) {
                 candidate = _selectNode(nodes, tags->getCurrentTag(), true, localThresholdMillis,
-                        lastHost, isPrimarySelected);
+                        lastHost, isPrimarySelected, latencyAware);
 
                 if (candidate.empty()) {
                     tags->next();
@@ -1117,14 +1244,14 @@ namespace mongo {
         case ReadPreference_SecondaryPreferred:
         {
             HostAndPort candidateSec = selectNode(nodes, ReadPreference_SecondaryOnly, tags,
-                    localThresholdMillis, lastHost, isPrimarySelected);
+                    localThresholdMillis, lastHost, isPrimarySelected, latencyAware);
 
             if (!candidateSec.empty()) {
                 return candidateSec;
             }
 
             return selectNode(nodes, ReadPreference_PrimaryOnly, tags,
-                    localThresholdMillis, lastHost, isPrimarySelected);
+                    localThresholdMillis, lastHost, isPrimarySelected, latencyAware);
         }
 
         case ReadPreference_Nearest:
@@ -1133,7 +1260,7 @@ namespace mongo {
 
             while (!tags->isExhausted()) {
                 candidate = _selectNode(nodes, tags->getCurrentTag(), false, localThresholdMillis,
-                        lastHost, isPrimarySelected);
+                        lastHost, isPrimarySelected, latencyAware);
 
                 if (candidate.empty()) {
                     tags->next();
@@ -1226,6 +1353,31 @@ namespace mongo {
         return false;
     }
 
+    void ReplicaSetMonitor::notifyRequestStart(const HostAndPort& host) {
+        scoped_lock lk(_lock);
+        int x = _find_inlock(host.toString());
+        if (x >= 0) {
+            _nodes[x].inFlight++;
+        }
+    }
+
+    void ReplicaSetMonitor::notifyRequestDone(const HostAndPort& host, int millis) {
+        scoped_lock lk(_lock);
+        int x = _find_inlock(host.toString());
+        if (x < 0) {
+            return;
+        }
+
+        // the node list may have been rebuilt while the request was out
+        Node& node = _nodes[x];
+        if (node.inFlight > 0) {
+            node.inFlight--;
+        }
+        if (millis >= 0) {
+            node.noteLatency(millis);
+        }
+    }
+
     bool ReplicaSetMonitor::Node::matchesTag(const BSONObj& tag) const {
         if (tag.isEmpty()) {
             return true;
@@ -1561,9 +1713,11 @@ namespace mongo {
                         break;
                     }
 
+                    NodeRequestTracker tracker(_getMonitor(), _lastSlaveOkHost);
                     auto_ptr<DBClientCursor> cursor = conn->query(ns, query,
                             nToReturn, nToSkip, fieldsToReturn, queryOptions,
                             batchSize);
+                    tracker.done();
 
                     return checkSlaveQueryResult(cursor);
                 }
@@ -1611,7 +1765,11 @@ namespace mongo {
                         break;
                     }
 
-                    return conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    NodeRequestTracker tracker(_getMonitor(), _lastSlaveOkHost);
+                    BSONObj result = conn->findOne(ns,query,fieldsToReturn,queryOptions);
+                    tracker.done();
+
+                    return result;
                 }
                 catch ( const DBException &dbExcep ) {
                     LOG(1) << "can't findone replica set node " << _lastSlaveOkHost << ": "
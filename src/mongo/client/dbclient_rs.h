@@ -62,7 +62,9 @@ namespace mongo {
                 ismaster(false),
                 secondary( false ),
                 hidden( false ),
-                pingTimeMillis( 0 ) {
+                pingTimeMillis( 0 ),
+                latencyMillis( 0 ),
+                inFlight( 0 ) {
             }
 
             bool okForSecondaryQueries() const {
@@ -98,6 +100,25 @@ namespace mongo {
                 return pingTimeMillis < threshold;
             }
 
+            /**
+             * Folds a ping or request round trip time into latencyMillis.
+             */
+            void noteLatency( int millis ) {
+                if ( latencyMillis == 0 )
+                    latencyMillis = millis;
+                else
+                    latencyMillis += ( millis - latencyMillis ) * LATENCY_EWMA_WEIGHT;
+            }
+
+            /**
+             * @return how long a new request sent here can expect to take, used to pick the
+             *     less busy of two nodes.  The extra millisecond keeps idle nodes that answer
+             *     in under a millisecond from all tying at zero.
+             */
+            double expectedWaitMillis() const {
+                return ( latencyMillis + 1 ) * ( inFlight + 1 );
+            }
+
             /**
              * Checks whether this nodes is compatible with the given readPreference and
              * tag. Compatibility check is strict in the sense that secondary preferred
@@ -131,10 +152,19 @@ namespace mongo {
 
             int pingTimeMillis;
 
+            // moving average of ping and request round trip times, see noteLatency
+            double latencyMillis;
+
+            // requests sent through a DBClientReplicaSet and not yet answered
+            int inFlight;
+
         };
 
         static const double SOCKET_TIMEOUT_SECS;
 
+        // weight a new sample gets in Node::latencyMillis
+        static const double LATENCY_EWMA_WEIGHT;
+
         /**
          * Selects the right node given the nodes to pick from and the preference.
          *
@@ -151,6 +181,8 @@ namespace mongo {
          *     is not Nearest.
          * @param isPrimarySelected out parameter that is set to true if the returned host
          *     is a primary. Cannot be NULL and valid only if returned host is not empty.
+         * @param latencyAware instead of round robin, pick the node with the lower
+         *     expectedWaitMillis of two drawn at random from the eligible local nodes.
          *
          * @return the host object of the node selected. If none of the nodes are
          *     eligible, returns an empty host.
@@ -160,7 +192,8 @@ namespace mongo {
                                       TagSet* tags,
                                       int localThresholdMillis,
                                       HostAndPort* lastHost,
-                                      bool* isPrimarySelected);
+                                      bool* isPrimarySelected,
+                                      bool latencyAware = false);
 
         /**
          * Selects the right node given the nodes to pick from and the preference. This
@@ -282,6 +315,18 @@ namespace mongo {
          */
         bool isAnyNodeOk() const;
 
+        /**
+         * Counts a request as in flight on the given host until the matching
+         * notifyRequestDone.
+         */
+        void notifyRequestStart( const HostAndPort& host );
+
+        /**
+         * @param millis the request's round trip time, or -1 if it failed and so says
+         *     nothing about the node's latency
+         */
+        void notifyRequestDone( const HostAndPort& host, int millis );
+
     private:
         /**
          * This populates a list of hosts from the list of seeds (discarding the
@@ -394,6 +439,7 @@ namespace mongo {
 
         static ConfigChangeHook _hook;
         int _localThresholdMillis; // local ping latency threshold (protected by _lock)
+        bool _latencyAwareReads; // see selectNode
 
         static int _maxFailedChecks;
     };
@@ -185,6 +185,10 @@ namespace mongo {
             // if it's a tailable cursor
             cursorId = qr->cursorId;
         }
+        else if ( qr->cursorId == 0 && ( opts & QueryOption_Exhaust ) ) {
+            // the server stops streaming an exhaust cursor once it replies with no cursor id
+            cursorId = 0;
+        }
 
         batch.nReturned = qr->nReturned;
         batch.pos = 0;
@@ -219,7 +223,11 @@ namespace mongo {
         if ( cursorId == 0 )
             return false;
 
-        requestMore();
+        // an exhaust cursor's server sends the next batch without being asked
+        if ( ( opts & QueryOption_Exhaust ) && _client )
+            exhaustReceiveMore();
+        else
+            requestMore();
         return batch.pos < batch.nReturned;
     }
 
@@ -101,6 +101,10 @@ namespace mongo {
                                                << " (sleeping for " << sleepTime << "ms)" << endl;
 
             static int loops = 0;
+
+            // How often the pinger looks for old lockpings entries to remove.
+            const int pingsPerCleanup = 10;
+
             while( ! inShutdown() && ! shouldKill( addr, process ) ) {
 
                 LOG( DistributedLock::logLvl + 2 ) << "distributed lock pinger '" << pingId << "' about to ping." << endl;
@@ -133,31 +137,34 @@ namespace mongo {
                     // (this may happen if an instance of a process was taken down and no new instance came up to
                     // replace it for a quite a while)
                     // if the lock is taken, the take-over mechanism should handle the situation
-                    auto_ptr<DBClientCursor> c = conn->query( LocksType::ConfigNS , BSONObj() );
-                    // TODO:  Would be good to make clear whether query throws or returns empty on errors
-                    uassert( 16060, str::stream() << "cannot query locks collection on config server " << conn.getHost(), c.get() );
-
-                    set<string> pids;
-                    while ( c->more() ) {
-                        BSONObj lock = c->next();
-                        if ( ! lock[LocksType::process()].eoo() ) {
-                            pids.insert( lock[LocksType::process()].valuestrsafe() );
+                    // Such entries are days old, so this only needs doing every few pings.
+                    if ( loops % pingsPerCleanup == 0 ) {
+                        auto_ptr<DBClientCursor> c = conn->query( LocksType::ConfigNS , BSONObj() );
+                        // TODO:  Would be good to make clear whether query throws or returns empty on errors
+                        uassert( 16060, str::stream() << "cannot query locks collection on config server " << conn.getHost(), c.get() );
+
+                        set<string> pids;
+                        while ( c->more() ) {
+                            BSONObj lock = c->next();
+                            if ( ! lock[LocksType::process()].eoo() ) {
+                                pids.insert( lock[LocksType::process()].valuestrsafe() );
+                            }
                         }
-                    }
-
-                    Date_t fourDays = pingTime - ( 4 * 86400 * 1000 ); // 4 days
-                    conn->remove( LockpingsType::ConfigNS,
-                                  BSON( LockpingsType::process() << NIN << pids <<
-                                        LockpingsType::ping() << LT << fourDays ) );
-                    err = conn->getLastError();
-                    if ( ! err.empty() ) {
-                        warning() << "ping cleanup for distributed lock pinger '" << pingId << " failed."
-                                  << causedBy( err ) << endl;
-                        conn.done();
 
-                        // Sleep for normal ping time
-                        sleepmillis(sleepTime);
-                        continue;
+                        Date_t fourDays = pingTime - ( 4 * 86400 * 1000 ); // 4 days
+                        conn->remove( LockpingsType::ConfigNS,
+                                      BSON( LockpingsType::process() << NIN << pids <<
+                                            LockpingsType::ping() << LT << fourDays ) );
+                        err = conn->getLastError();
+                        if ( ! err.empty() ) {
+                            warning() << "ping cleanup for distributed lock pinger '" << pingId << " failed."
+                                      << causedBy( err ) << endl;
+                            conn.done();
+
+                            // Sleep for normal ping time
+                            sleepmillis(sleepTime);
+                            continue;
+                        }
                     }
 
                     // create index so remove is fast even with a lot of servers
@@ -625,56 +632,72 @@ namespace mongo {
                     return false;
                 }
 
-                BSONObj lastPing = conn->findOne( LockpingsType::ConfigNS, o[LocksType::process()].wrap( LockpingsType::process() ) );
-                if ( lastPing.isEmpty() ) {
-                    LOG( logLvl ) << "empty ping found for process in lock '" << lockName << "'" << endl;
-                    // TODO:  Using 0 as a "no time found" value Will fail if dates roll over, but then, so will a lot.
-                    lastPing = BSON( LockpingsType::process(o[LocksType::process()].String()) <<
-                                     LockpingsType::ping((Date_t) 0) );
-                }
+                // A finalized lock of ours that we gave up on and scheduled for late unlock isn't
+                // held by anyone, so there's no need to wait for it to time out.
+                bool abandoned = o[LocksType::process()].String() == _processId &&
+                                 o[LocksType::state()].numberInt() == 2 &&
+                                 distLockPinger.willUnlockOID( o[LocksType::lockID()].OID() );
 
                 unsigned long long elapsed = 0;
                 unsigned long long takeover = _lockTimeout;
-                PingData _lastPingCheck = getLastPing();
 
-                LOG( logLvl ) << "checking last ping for lock '" << lockName << "'" << " against process " << _lastPingCheck.id << " and ping " << _lastPingCheck.lastPing << endl;
+                if ( abandoned ) {
+                    LOG( logLvl - 1 ) << "lock '" << lockName << "' has ts "
+                                      << o[LocksType::lockID()].OID()
+                                      << " scheduled for late unlock, not waiting for it to "
+                                      << "time out" << endl;
+                    elapsed = takeover + 1;
+                }
+                else {
+                    BSONObj lastPing = conn->findOne( LockpingsType::ConfigNS, o[LocksType::process()].wrap( LockpingsType::process() ) );
+                    if ( lastPing.isEmpty() ) {
+                        LOG( logLvl ) << "empty ping found for process in lock '" << lockName << "'" << endl;
+                        // TODO:  Using 0 as a "no time found" value Will fail if dates roll over, but then, so will a lot.
+                        lastPing = BSON( LockpingsType::process(o[LocksType::process()].String()) <<
+                                         LockpingsType::ping((Date_t) 0) );
+                    }
 
-                try {
+                    PingData _lastPingCheck = getLastPing();
 
-                    Date_t remote = remoteTime( _conn );
-
-                    // Timeout the elapsed time using comparisons of remote clock
-                    // For non-finalized locks, timeout 15 minutes since last seen (ts)
-                    // For finalized locks, timeout 15 minutes since last ping
-                    bool recPingChange = o[LocksType::state()].numberInt() == 2 &&
-                                         ( _lastPingCheck.id != lastPing[LockpingsType::process()].String() ||
-                                           _lastPingCheck.lastPing != lastPing[LockpingsType::ping()].Date() );
-                    bool recTSChange = _lastPingCheck.ts != o[LocksType::lockID()].OID();
-
-                    if( recPingChange || recTSChange ) {
-                        // If the ping has changed since we last checked, mark the current date and time
-                        setLastPing( PingData( lastPing[LockpingsType::process()].String().c_str(),
-                                               lastPing[LockpingsType::ping()].Date(),
-                                               remote, o[LocksType::lockID()].OID() ) );
-                    }
-                    else {
+                    LOG( logLvl ) << "checking last ping for lock '" << lockName << "'" << " against process " << _lastPingCheck.id << " and ping " << _lastPingCheck.lastPing << endl;
 
-                        // GOTCHA!  Due to network issues, it is possible that the current time
-                        // is less than the remote time.  We *have* to check this here, otherwise
-                        // we overflow and our lock breaks.
-                        if(_lastPingCheck.remote >= remote)
-                            elapsed = 0;
-                        else
-                            elapsed = remote - _lastPingCheck.remote;
+                    try {
+
+                        Date_t remote = remoteTime( _conn );
+
+                        // Timeout the elapsed time using comparisons of remote clock
+                        // For non-finalized locks, timeout 15 minutes since last seen (ts)
+                        // For finalized locks, timeout 15 minutes since last ping
+                        bool recPingChange = o[LocksType::state()].numberInt() == 2 &&
+                                             ( _lastPingCheck.id != lastPing[LockpingsType::process()].String() ||
+                                               _lastPingCheck.lastPing != lastPing[LockpingsType::ping()].Date() );
+                        bool recTSChange = _lastPingCheck.ts != o[LocksType::lockID()].OID();
+
+                        if( recPingChange || recTSChange ) {
+                            // If the ping has changed since we last checked, mark the current date and time
+                            setLastPing( PingData( lastPing[LockpingsType::process()].String().c_str(),
+                                                   lastPing[LockpingsType::ping()].Date(),
+                                                   remote, o[LocksType::lockID()].OID() ) );
+                        }
+                        else {
+
+                            // GOTCHA!  Due to network issues, it is possible that the current time
+                            // is less than the remote time.  We *have* to check this here, otherwise
+                            // we overflow and our lock breaks.
+                            if(_lastPingCheck.remote >= remote)
+                                elapsed = 0;
+                            else
+                                elapsed = remote - _lastPingCheck.remote;
+                        }
                     }
-                }
-                catch( LockException& e ) {
+                    catch( LockException& e ) {
 
-                    // Remote server cannot be found / is not responsive
-                    warning() << "Could not get remote time from " << _conn << causedBy( e );
-                    // If our config server is having issues, forget all the pings until we can see it again
-                    resetLastPing();
+                        // Remote server cannot be found / is not responsive
+                        warning() << "Could not get remote time from " << _conn << causedBy( e );
+                        // If our config server is having issues, forget all the pings until we can see it again
+                        resetLastPing();
 
+                    }
                 }
 
                 if ( elapsed <= takeover && ! canReenter ) {
@@ -705,7 +728,8 @@ namespace mongo {
                         // and after the lock times out, we can be pretty sure the time is
                         // increasing at the same rate on all servers and therefore our
                         // timeout is accurate
-                        uassert( 14023, str::stream() << "remote time in cluster " << _conn.toString() << " is now skewed, cannot force lock.", !isRemoteTimeSkewed() );
+                        // (An abandoned lock of ours didn't time out, so there's nothing to check.)
+                        uassert( 14023, str::stream() << "remote time in cluster " << _conn.toString() << " is now skewed, cannot force lock.", abandoned || !isRemoteTimeSkewed() );
 
                         // Make sure we break the lock with the correct "ts" (OID) value, otherwise
                         // we can overwrite a new lock inserted in the meantime.
@@ -831,10 +855,9 @@ namespace mongo {
             BSONObj err = conn->getLastErrorDetailed();
             string errMsg = DBClientWithCommands::getLastErrorString(err);
 
-            currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
-
             if ( !errMsg.empty() || !err["n"].type() || err["n"].numberInt() < 1 ) {
                 logErrMsgOrWarn("could not acquire lock", lockName, errMsg, "(another update won");
+                currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
                 *other = currLock;
                 other->getOwned();
                 gotLock = false;
@@ -949,21 +972,26 @@ namespace mongo {
                         finalLockDetails.append( LocksType::state(), 2 );
                     else finalLockDetails.append( el );
                 }
+                BSONObj finalLock = finalLockDetails.obj();
 
-                conn->update( LocksType::ConfigNS , BSON( LocksType::name(_name) ) , BSON( "$set" << finalLockDetails.obj() ) );
+                conn->update( LocksType::ConfigNS , BSON( LocksType::name(_name) ) , BSON( "$set" << finalLock ) );
 
                 BSONObj err = conn->getLastErrorDetailed();
                 string errMsg = DBClientWithCommands::getLastErrorString(err);
 
-                currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
-
                 if ( !errMsg.empty() || !err["n"].type() || err["n"].numberInt() < 1 ) {
                     warning() << "could not finalize winning lock " << lockName
                               << ( !errMsg.empty() ? causedBy( errMsg ) : " (did not update lock) " ) << endl;
+                    currLock = conn->findOne( LocksType::ConfigNS , BSON( LocksType::name(_name) ) );
                     gotLock = false;
                 }
                 else {
-                    // SUCCESS!
+                    // SUCCESS!  The update set every field but the name, so there's no need to
+                    // read the lock back.
+                    BSONObjBuilder b;
+                    b.append( LocksType::name() , _name );
+                    b.appendElements( finalLock );
+                    currLock = b.obj();
                     gotLock = true;
                 }
 
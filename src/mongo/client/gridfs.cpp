@@ -24,6 +24,7 @@
 
 #include "mongo/client/gridfs.h"
 #include "mongo/client/dbclientcursor.h"
+#include "mongo/util/md5.hpp"
 
 #if defined(_WIN32)
 #include <io.h>
@@ -75,23 +76,9 @@ namespace mongo {
     }
 
     BSONObj GridFS::storeFile( const char* data , size_t length , const string& remoteName , const string& contentType) {
-        char const * const end = data + length;
-
-        OID id;
-        id.init();
-        BSONObj idObj = BSON("_id" << id);
-
-        int chunkNumber = 0;
-        while (data < end) {
-            int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
-            GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
-
-            chunkNumber++;
-            data += chunkLen;
-        }
-
-        return insertFile(remoteName, id, length, contentType);
+        GridFileBuilder builder( this );
+        builder.append( data , length );
+        return builder.buildFile( remoteName , contentType );
     }
 
 
@@ -105,40 +92,21 @@ namespace mongo {
             fd = fopen( fileName.c_str() , "rb" );
         uassert( 10013 , "error opening file", fd);
 
-        OID id;
-        id.init();
-        BSONObj idObj = BSON("_id" << id);
-
-        int chunkNumber = 0;
-        gridfs_offset length = 0;
+        GridFileBuilder builder( this );
+        boost::scoped_array<char> buf( new char[_chunkSize] );
         while (!feof(fd)) {
-            //boost::scoped_array<char>buf (new char[_chunkSize+1]);
-            char * buf = new char[_chunkSize+1];
-            char* bufPos = buf;//.get();
-            unsigned int chunkLen = 0; // how much in the chunk now
-            while(chunkLen != _chunkSize && !feof(fd)) {
-                int readLen = fread(bufPos, 1, _chunkSize - chunkLen, fd);
-                chunkLen += readLen;
-                bufPos += readLen;
-
-                verify(chunkLen <= _chunkSize);
-            }
-
-            GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
-
-            length += chunkLen;
-            chunkNumber++;
-            delete[] buf;
+            size_t readLen = fread(buf.get(), 1, _chunkSize, fd);
+            builder.append( buf.get() , readLen );
         }
 
         if (fd != stdin)
             fclose( fd );
 
-        return insertFile((remoteName.empty() ? fileName : remoteName), id, length, contentType);
+        return builder.buildFile( remoteName.empty() ? fileName : remoteName , contentType );
     }
 
-    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType) {
+    BSONObj GridFS::insertFile(const string& name, const OID& id, gridfs_offset length,
+                               const string& contentType, const string& md5) {
         // Wait for any pending writebacks to finish
         BSONObj errObj = _client.getLastErrorDetailed();
         uassert( 16428,
@@ -146,16 +114,12 @@ namespace mongo {
                                << ", error: " << errObj,
                  DBClientWithCommands::getLastErrorString(errObj) == "" );
 
-        BSONObj res;
-        if ( ! _client.runCommand( _dbName.c_str() , BSON( "filemd5" << id << "root" << _prefix ) , res ) )
-            throw UserException( 9008 , "filemd5 failed" );
-
         BSONObjBuilder file;
         file << "_id" << id
              << "filename" << name
              << "chunkSize" << _chunkSize
              << "uploadDate" << DATENOW
-             << "md5" << res["md5"]
+             << "md5" << md5
              ;
 
         if (length < 1024*1024*1024) { // 2^30
@@ -174,6 +138,62 @@ namespace mongo {
         return ret;
     }
 
+    GridFileBuilder::GridFileBuilder( GridFS* grid )
+        : _grid( grid ),
+          _chunkSize( grid->getChunkSize() ),
+          _chunkNumber( 0 ),
+          _length( 0 ),
+          _pending( new char[_chunkSize] ),
+          _pendingLength( 0 ) {
+        _id.init();
+        _idObj = BSON( "_id" << _id );
+        md5_init( &_md5 );
+    }
+
+    void GridFileBuilder::append( const char* data , size_t length ) {
+        _length += length;
+
+        if ( _pendingLength > 0 ) {
+            size_t n = MIN( _chunkSize - _pendingLength , length );
+            memcpy( _pending.get() + _pendingLength , data , n );
+            _pendingLength += n;
+            data += n;
+            length -= n;
+
+            if ( _pendingLength < _chunkSize )
+                return;
+            insertChunk( _pending.get() , _chunkSize );
+            _pendingLength = 0;
+        }
+
+        // whole chunks go straight from the caller's data
+        while ( length >= _chunkSize ) {
+            insertChunk( data , _chunkSize );
+            data += _chunkSize;
+            length -= _chunkSize;
+        }
+
+        memcpy( _pending.get() , data , length );
+        _pendingLength = length;
+    }
+
+    BSONObj GridFileBuilder::buildFile( const string& remoteName , const string& contentType ) {
+        if ( _pendingLength > 0 ) {
+            insertChunk( _pending.get() , _pendingLength );
+            _pendingLength = 0;
+        }
+
+        md5digest d;
+        md5_finish( &_md5 , d );
+        return _grid->insertFile( remoteName , _id , _length , contentType , digestToString( d ) );
+    }
+
+    void GridFileBuilder::insertChunk( const char* data , size_t length ) {
+        md5_append( &_md5 , reinterpret_cast<const md5_byte_t*>( data ) , length );
+        GridFSChunk c( _idObj , _chunkNumber++ , data , length );
+        _grid->_client.insert( _grid->_chunksNS.c_str() , c._data );
+    }
+
     void GridFS::removeFile( const string& fileName ) {
         auto_ptr<DBClientCursor> files = _client.query( _filesNS , BSON( "filename" << fileName ) );
         while (files->more()) {
@@ -228,18 +248,64 @@ namespace mongo {
 
     gridfs_offset GridFile::write( ostream & out ) const {
         _exists();
+        return write( out , 0 , getContentLength() );
+    }
+
+    gridfs_offset GridFile::write( ostream & out ,
+                                   gridfs_offset offset ,
+                                   gridfs_offset length ) const {
+        _exists();
+
+        const gridfs_offset size = getContentLength();
+        if ( offset >= size || length == 0 )
+            return 0;
+        length = MIN( length , size - offset );
+
+        const gridfs_offset chunkSize = getChunkSize();
+        const int first = offset / chunkSize;
+        const int last = ( offset + length - 1 ) / chunkSize;
+
+        // the whole file is checked against its MD5 on the way out
+        const bool checkMD5 = length == size && !getMD5().empty();
+        md5_state_t st;
+        md5_init( &st );
 
-        const int num = getNumChunks();
+        // one query for all the chunks, rather than a round trip for each
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        b.append( "n" , BSON( "$gte" << first << "$lte" << last ) );
+        auto_ptr<DBClientCursor> cursor =
+            _grid->_client.query( _grid->_chunksNS , Query( b.obj() ).sort( BSON( "n" << 1 ) ) );
+        uassert( 10014 ,  "chunk is empty!" , cursor.get() );
 
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        for ( int n = first; n <= last; n++ ) {
+            BSONObj o = cursor->more() ? cursor->nextSafe() : BSONObj();
+            uassert( 10014 ,  "chunk is empty!" , ! o.isEmpty() && o["n"].numberInt() == n );
+            GridFSChunk c( o );
 
             int len;
             const char * data = c.data( len );
-            out.write( data , len );
+            if ( checkMD5 )
+                md5_append( &st , reinterpret_cast<const md5_byte_t*>( data ) , len );
+
+            // the part of [offset, offset + length) in this chunk
+            const gridfs_offset start = n * chunkSize;
+            const gridfs_offset from = offset > start ? offset - start : 0;
+            const gridfs_offset to = MIN( (gridfs_offset)len , offset + length - start );
+            if ( to > from )
+                out.write( data + from , to - from );
+        }
+
+        if ( checkMD5 ) {
+            md5digest d;
+            md5_finish( &st , d );
+            uassert( 17034 ,
+                     str::stream() << "md5 of GridFS file " << getFilename() << " is "
+                                   << digestToString( d ) << ", expected " << getMD5() ,
+                     digestToString( d ) == getMD5() );
         }
 
-        return getContentLength();
+        return length;
     }
 
     gridfs_offset GridFile::write( const string& where ) const {
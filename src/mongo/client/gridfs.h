@@ -17,9 +17,12 @@
 
 #pragma once
 
+#include <boost/scoped_array.hpp>
+
 #include "mongo/bson/bsonelement.h"
 #include "mongo/bson/bsonobj.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/util/md5.h"
 
 namespace mongo {
 
@@ -27,6 +30,7 @@ namespace mongo {
 
     class GridFS;
     class GridFile;
+    class GridFileBuilder;
 
     class GridFSChunk {
     public:
@@ -46,6 +50,7 @@ namespace mongo {
     private:
         BSONObj _data;
         friend class GridFS;
+        friend class GridFileBuilder;
     };
 
 
@@ -129,9 +134,52 @@ namespace mongo {
         unsigned int _chunkSize;
 
         // insert fileobject. All chunks must be in DB.
-        BSONObj insertFile(const string& name, const OID& id, gridfs_offset length, const string& contentType);
+        BSONObj insertFile(const string& name, const OID& id, gridfs_offset length,
+                           const string& contentType, const string& md5);
 
         friend class GridFile;
+        friend class GridFileBuilder;
+    };
+
+    /**
+     * Stores a file in GridFS from data handed over a piece at a time, so that the whole file
+     * never has to be in memory.  Chunks are inserted as soon as they fill up, and the file's
+     * MD5 is worked out along the way instead of by having the server read the chunks back.
+     */
+    class GridFileBuilder {
+    public:
+        /**
+         * @param grid - the GridFS to store the file in, which has to outlive the builder
+         */
+        GridFileBuilder( GridFS* grid );
+
+        /**
+         * adds the next 'length' bytes of the file
+         */
+        void append( const char* data , size_t length );
+
+        /**
+         * inserts what's left of the data and the file object; the builder can't be used after
+         * @param remoteName filename to use for the file stored in GridFS
+         * @param contentType optional MIME type for this object
+         * @return the file object
+         */
+        BSONObj buildFile( const string& remoteName , const string& contentType="" );
+
+    private:
+        void insertChunk( const char* data , size_t length );
+
+        GridFS* _grid;
+        const size_t _chunkSize;
+        OID _id;
+        BSONObj _idObj;
+        int _chunkNumber;
+        gridfs_offset _length;
+        md5_state_t _md5;
+
+        // the start of a chunk that isn't full yet
+        boost::scoped_array<char> _pending;
+        size_t _pendingLength;
     };
 
     /**
@@ -184,10 +232,17 @@ namespace mongo {
         GridFSChunk getChunk( int n ) const;
 
         /**
-           write the file to the output stream
+           write the file to the output stream, checking it against its MD5 on the way
          */
         gridfs_offset write( ostream & out ) const;
 
+        /**
+           write up to 'length' bytes of the file, starting 'offset' bytes in, to the output
+           stream, reading only the chunks that hold them
+           @return how many bytes were written
+         */
+        gridfs_offset write( ostream & out , gridfs_offset offset , gridfs_offset length ) const;
+
         /**
            write the file to this filename
          */
@@ -307,6 +307,111 @@ namespace mongo {
 
     }
 
+    // --------  ParallelCursorPrefetcher -----------
+
+    ParallelCursorPrefetcher::ParallelCursorPrefetcher( DBClientCursor* cursor , NotifyAll* arrival )
+        : _cursor( cursor ) , _arrival( arrival ) , _mutex( "ParallelCursorPrefetcher" ) ,
+          _posInBatch( 0 ) , _exhausted( false ) , _stopRequested( false ) , _failed( false ) ,
+          _errorCode( 0 ) {
+        verify( _cursor );
+        _thread.reset( new boost::thread( boost::bind( &ParallelCursorPrefetcher::_run , this ) ) );
+    }
+
+    ParallelCursorPrefetcher::~ParallelCursorPrefetcher() {
+        stop();
+    }
+
+    bool ParallelCursorPrefetcher::ready() {
+        scoped_lock lk( _mutex );
+        return ! _batches.empty() || _exhausted || _failed;
+    }
+
+    bool ParallelCursorPrefetcher::next( BSONObj* obj ) {
+        scoped_lock lk( _mutex );
+        while ( _batches.empty() && ! _exhausted && ! _failed )
+            _changed.wait( lk.boost() );
+
+        if ( ! _batches.empty() ) {
+            *obj = _batches.front()[ _posInBatch++ ];
+            if ( _posInBatch == _batches.front().size() ) {
+                _batches.pop_front();
+                _posInBatch = 0;
+                _changed.notify_all();
+            }
+            return true;
+        }
+
+        if ( _failed )
+            uasserted( _errorCode , _errorMsg );
+        return false;
+    }
+
+    void ParallelCursorPrefetcher::stop() {
+        {
+            scoped_lock lk( _mutex );
+            _stopRequested = true;
+            _changed.notify_all();
+        }
+
+        if ( _thread ) {
+            _thread->join();
+            _thread.reset();
+        }
+    }
+
+    void ParallelCursorPrefetcher::_run() {
+        bool exhausted = false;
+        while ( ! exhausted ) {
+            {
+                scoped_lock lk( _mutex );
+                while ( _batches.size() >= MaxBatchesAhead && ! _stopRequested )
+                    _changed.wait( lk.boost() );
+                if ( _stopRequested )
+                    return;
+            }
+
+            // The cursor is only used by this thread, so it is read outside the lock.
+            vector<BSONObj> batch;
+            try {
+                if ( _cursor->more() ) {
+                    do {
+                        batch.push_back( _cursor->next().getOwned() );
+                    } while ( _cursor->moreInCurrentBatch() );
+                }
+                else {
+                    exhausted = true;
+                }
+            }
+            catch ( DBException& e ) {
+                scoped_lock lk( _mutex );
+                _failed = true;
+                _errorCode = e.getCode();
+                _errorMsg = e.what();
+                exhausted = true;
+            }
+            catch ( std::exception& e ) {
+                scoped_lock lk( _mutex );
+                _failed = true;
+                _errorCode = 16986;
+                _errorMsg = str::stream() << "error reading shard cursor: " << e.what();
+                exhausted = true;
+            }
+
+            {
+                scoped_lock lk( _mutex );
+                if ( ! batch.empty() ) {
+                    _batches.push_back( vector<BSONObj>() );
+                    _batches.back().swap( batch );
+                }
+                _exhausted = exhausted && ! _failed;
+                _changed.notify_all();
+            }
+
+            if ( _arrival )
+                _arrival->notifyAll( _arrival->now() );
+        }
+    }
+
     // --------  FilteringClientCursor -----------
     FilteringClientCursor::FilteringClientCursor( const BSONObj filter )
         : _matcher( filter ) , _pcmData( NULL ), _done( true ) {
@@ -341,6 +446,19 @@ namespace mongo {
     }
 
 
+    void FilteringClientCursor::prefetch( NotifyAll* arrival ) {
+        verify( ! _prefetcher );
+        if ( ! _cursor.get() || _done )
+            return;
+        _prefetcher.reset( new ParallelCursorPrefetcher( _cursor.get() , arrival ) );
+    }
+
+    bool FilteringClientCursor::ready() {
+        if ( ! _next.isEmpty() || _done || ! _prefetcher )
+            return true;
+        return _prefetcher->ready();
+    }
+
     bool FilteringClientCursor::more() {
         if ( ! _next.isEmpty() )
             return true;
@@ -358,7 +476,10 @@ namespace mongo {
 
         BSONObj ret = _next;
         _next = BSONObj();
-        _advance();
+        // a prefetched cursor advances lazily in more(), so taking the last buffered
+        // document doesn't wait on the next batch
+        if ( ! _prefetcher )
+            _advance();
         return ret;
     }
 
@@ -373,6 +494,17 @@ namespace mongo {
         if ( ! _cursor.get() || _done )
             return;
 
+        if ( _prefetcher ) {
+            // documents from the prefetcher are already owned
+            while ( _prefetcher->next( &_next ) ) {
+                if ( _matcher.matches( _next ) )
+                    return;
+            }
+            _next = BSONObj();
+            _done = true;
+            return;
+        }
+
         while ( _cursor->more() ) {
             _next = _cursor->next();
             if ( _matcher.matches( _next ) ) {
@@ -477,6 +609,8 @@ namespace mongo {
         _numServers = _servers.size();
         _lastFrom = 0;
         _cursors = 0;
+        _asyncFetch = false;
+        _prefetchStarted = false;
 
         if( ! _qSpec.isEmpty() ){
 
@@ -1581,8 +1715,47 @@ namespace mongo {
         _cursorMap.clear();
     }
 
+    void ParallelSortClusteredCursor::_startPrefetch() {
+        if ( ! _asyncFetch || _prefetchStarted )
+            return;
+
+        _prefetchStarted = true;
+        for ( int i = 0; i < _numServers; i++ )
+            _cursors[i].prefetch( &_arrival );
+    }
+
+    int ParallelSortClusteredCursor::_waitForReadyCursor() {
+        while ( true ) {
+            NotifyAll::When lastSeen = _arrival.now();
+            bool waiting = false;
+
+            // Start one past the last server we used, so a fast shard can't starve the others
+            for ( int j = 0; j < _numServers; j++ ) {
+                int i = ( j + _lastFrom + 1 ) % _numServers;
+
+                if ( ! _cursors[i].ready() ) {
+                    waiting = true;
+                    continue;
+                }
+
+                if ( _cursors[i].more() )
+                    return i;
+
+                if( _cursors[i].rawMData() )
+                    _cursors[i].rawMData()->pcState->done = true;
+            }
+
+            if ( ! waiting )
+                return -1;
+
+            _arrival.waitFor( lastSeen );
+        }
+    }
+
     bool ParallelSortClusteredCursor::more() {
 
+        _startPrefetch();
+
         if ( _needToSkip > 0 ) {
             int n = _needToSkip;
             _needToSkip = 0;
@@ -1595,6 +1768,9 @@ namespace mongo {
             _needToSkip = n;
         }
 
+        if ( _prefetchStarted && _sortKey.isEmpty() )
+            return _waitForReadyCursor() >= 0;
+
         for ( int i=0; i<_numServers; i++ ) {
             if ( _cursors[i].more() )
                 return true;
@@ -1603,6 +1779,20 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
+        _startPrefetch();
+
+        if ( _prefetchStarted && _sortKey.isEmpty() ) {
+            // Unsorted, so take from whichever shard has something
+            int from = _waitForReadyCursor();
+            uassert( 10019 ,  "no more elements" , from >= 0 );
+            _lastFrom = from;
+
+            if( _cursors[from].rawMData() )
+                _cursors[from].rawMData()->pcState->count++;
+
+            return _cursors[from].next();
+        }
+
         BSONObj best = BSONObj();
         int bestFrom = -1;
 
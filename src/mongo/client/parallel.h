@@ -21,12 +21,16 @@
 
 #pragma once
 
+#include <boost/thread/thread.hpp>
+#include <deque>
+
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/matcher.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/stale_exception.h"  // for StaleConfigException
 #include "mongo/util/concurrency/mvar.h"
+#include "mongo/util/concurrency/synchronization.h"
 
 namespace mongo {
 
@@ -124,6 +128,60 @@ namespace mongo {
     class ParallelConnectionMetadata;
 
     // TODO:  We probably don't really need this as a separate class.
+    /**
+     * Reads a DBClientCursor on a background thread, so its getMores go out while the
+     * consumer is still busy with earlier batches.  Holds at most MaxBatchesAhead batches.
+     * Once started, the cursor must only be read through this class.
+     */
+    class ParallelCursorPrefetcher : boost::noncopyable {
+    public:
+        static const size_t MaxBatchesAhead = 2;
+
+        /**
+         * 'arrival', if set, is notified every time a batch, the end or an error comes in.
+         */
+        ParallelCursorPrefetcher( DBClientCursor* cursor , NotifyAll* arrival );
+
+        // Calls stop()
+        ~ParallelCursorPrefetcher();
+
+        /**
+         * @return true if next() would return without waiting on the network
+         */
+        bool ready();
+
+        /**
+         * Waits for the next document. Returns false once the cursor is exhausted, and
+         * rethrows anything the background thread caught.
+         */
+        bool next( BSONObj* obj );
+
+        /**
+         * Waits for the background thread to exit, which may take as long as a getMore in
+         * flight.
+         */
+        void stop();
+
+    private:
+        void _run();
+
+        DBClientCursor* _cursor;
+        NotifyAll* _arrival;
+
+        // Protects everything below
+        mongo::mutex _mutex;
+        boost::condition _changed;
+        std::deque< std::vector<BSONObj> > _batches;
+        size_t _posInBatch;
+        bool _exhausted;
+        bool _stopRequested;
+        bool _failed;
+        int _errorCode;
+        string _errorMsg;
+
+        scoped_ptr<boost::thread> _thread;
+    };
+
     class FilteringClientCursor {
     public:
         FilteringClientCursor( const BSONObj filter = BSONObj() );
@@ -142,8 +200,20 @@ namespace mongo {
         DBClientCursor* raw() { return _cursor.get(); }
         ParallelConnectionMetadata* rawMData(){ return _pcmData; }
 
+        /**
+         * Reads the cursor ahead on a background thread from now on.  raw() must not be
+         * used after this.
+         */
+        void prefetch( NotifyAll* arrival );
+
+        /**
+         * @return true if more() won't wait on the network to find out
+         */
+        bool ready();
+
         // Required for new PCursor
         void release(){
+            _prefetcher.reset();
             _cursor.release();
             _pcmData = NULL;
         }
@@ -153,6 +223,7 @@ namespace mongo {
 
         Matcher _matcher;
         auto_ptr<DBClientCursor> _cursor;
+        scoped_ptr<ParallelCursorPrefetcher> _prefetcher;
         ParallelConnectionMetadata* _pcmData;
 
         BSONObj _next;
@@ -363,8 +434,25 @@ namespace mongo {
 
         virtual void explain(BSONObjBuilder& b);
 
+        /**
+         * Reads every shard cursor ahead on its own thread once iteration starts, instead of
+         * issuing a shard's getMore only when the merge runs out of its documents.  Unsorted
+         * results are then returned in the order shards deliver them.  Must be set before the
+         * first more() or next().
+         */
+        void setAsyncFetch( bool asyncFetch ) { _asyncFetch = asyncFetch; }
+
     protected:
         void _finishCons();
+
+        /** Starts the prefetchers the first time through, if async fetching is on */
+        void _startPrefetch();
+
+        /**
+         * Unsorted async iteration: waits until some shard has a document or all are done.
+         * @return the index of a shard cursor with more(), or -1 if they're all exhausted
+         */
+        int _waitForReadyCursor();
         void _init();
         void _oldInit();
 
@@ -392,6 +480,10 @@ namespace mongo {
         FilteringClientCursor * _cursors;
         int _needToSkip;
 
+        bool _asyncFetch;
+        bool _prefetchStarted;
+        NotifyAll _arrival;
+
     private:
         /**
          * Setups the shard version of the connection. When using a replica
@@ -0,0 +1,195 @@
+// @file pipelined_connection.cpp
+
+/*
+ *    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "pch.h"
+
+#include "mongo/client/pipelined_connection.h"
+
+#include <boost/bind.hpp>
+
+#include "mongo/db/dbmessage.h"
+#include "mongo/util/net/message_port.h"
+
+namespace mongo {
+
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip, const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
+    class PipelinedConnection::Request : boost::noncopyable {
+    public:
+        Request() : done( false ) { }
+
+        // set, with 'response' filled if it came, once the request is no longer pending
+        bool done;
+        Message response;
+    };
+
+    PipelinedConnection::PipelinedConnection( DBClientConnection* conn )
+        : _conn( conn ),
+          _serverAddress( conn->getServerAddress() ),
+          _sendMutex( "PipelinedConnection send" ),
+          _mutex( "PipelinedConnection" ),
+          _failed( conn->isFailed() ) {
+
+        // the reader sits in recv() whenever nothing is pending, that can't time out;
+        // timeouts are per request, in wait()
+        _conn->port().setSocketTimeout( 0 );
+        _reader = boost::thread( boost::bind( &PipelinedConnection::_readReplies, this ) );
+    }
+
+    PipelinedConnection::~PipelinedConnection() {
+        _conn->port().shutdown();
+        _reader.join();
+    }
+
+    PipelinedConnection::RequestPtr PipelinedConnection::send( Message& toSend ) {
+        RequestPtr request( new Request() );
+
+        // register before sending, the reply can be read before send() returns
+        const unsigned id = nextMessageId().get();
+        toSend.header()->id = id;
+        toSend.header()->responseTo = -1;
+        {
+            scoped_lock lk( _mutex );
+            if ( _failed ) {
+                request->done = true;
+                return request;
+            }
+            _pending[id] = request;
+        }
+
+        try {
+            scoped_lock lk( _sendMutex );
+            toSend.send( _conn->port() , "pipelined" );
+        }
+        catch ( SocketException& e ) {
+            LOG(1) << "pipelined send to " << _serverAddress << " failed" << causedBy( e ) << endl;
+            scoped_lock lk( _mutex );
+            _fail_inlock();
+        }
+
+        return request;
+    }
+
+    bool PipelinedConnection::wait( const RequestPtr& request , Message& response ,
+                                    double timeoutSecs ) {
+        boost::xtime xt;
+        if ( timeoutSecs > 0 ) {
+            boost::xtime_get( &xt, MONGO_BOOST_TIME_UTC );
+            xt.sec += static_cast<int>( timeoutSecs );
+            xt.nsec += static_cast<int>( ( timeoutSecs - static_cast<int>( timeoutSecs ) ) * 1e9 );
+            if ( xt.nsec >= 1000000000 ) {
+                xt.nsec -= 1000000000;
+                xt.sec++;
+            }
+        }
+
+        scoped_lock lk( _mutex );
+        while ( ! request->done ) {
+            if ( timeoutSecs <= 0 ) {
+                _replied.wait( lk.boost() );
+            }
+            else if ( ! _replied.timed_wait( lk.boost(), xt ) ) {
+                if ( request->done )
+                    break;
+
+                for ( RequestMap::iterator i = _pending.begin(); i != _pending.end(); ++i ) {
+                    if ( i->second == request ) {
+                        _pending.erase( i );
+                        break;
+                    }
+                }
+                request->done = true;
+                LOG(1) << "timed out waiting for pipelined reply from " << _serverAddress << endl;
+                return false;
+            }
+        }
+
+        if ( request->response.empty() )
+            return false;
+
+        response = request->response;
+        return true;
+    }
+
+    bool PipelinedConnection::runCommand( const string& dbname , const BSONObj& cmd ,
+                                          BSONObj& info , double timeoutSecs ) {
+        Message toSend;
+        assembleRequest( dbname + ".$cmd" , cmd , -1 , 0 , NULL , 0 , toSend );
+
+        Message response;
+        if ( ! wait( send( toSend ) , response , timeoutSecs ) ) {
+            info = BSON( "ok" << 0 << "errmsg" << ( "no reply from " + _serverAddress ) );
+            return false;
+        }
+
+        QueryResult* qr = reinterpret_cast<QueryResult*>( response.singleData() );
+        if ( qr->nReturned != 1 ) {
+            info = BSON( "ok" << 0 << "errmsg" << ( "bad command reply from " + _serverAddress ) );
+            return false;
+        }
+
+        info = BSONObj( qr->data() ).getOwned();
+        return info["ok"].trueValue();
+    }
+
+    bool PipelinedConnection::isFailed() const {
+        scoped_lock lk( _mutex );
+        return _failed;
+    }
+
+    size_t PipelinedConnection::numPending() const {
+        scoped_lock lk( _mutex );
+        return _pending.size();
+    }
+
+    void PipelinedConnection::_readReplies() {
+        while ( true ) {
+            Message m;
+            if ( ! _conn->port().recv( m ) ) {
+                scoped_lock lk( _mutex );
+                _fail_inlock();
+                return;
+            }
+
+            scoped_lock lk( _mutex );
+            const unsigned responseTo = m.header()->responseTo.get();
+            RequestMap::iterator i = _pending.find( responseTo );
+            if ( i == _pending.end() ) {
+                // the waiter gave up on it
+                LOG(2) << "dropping pipelined reply from " << _serverAddress
+                       << " to request " << responseTo << endl;
+                continue;
+            }
+
+            i->second->response = m;
+            i->second->done = true;
+            _pending.erase( i );
+            _replied.notify_all();
+        }
+    }
+
+    void PipelinedConnection::_fail_inlock() {
+        _failed = true;
+        for ( RequestMap::iterator i = _pending.begin(); i != _pending.end(); ++i ) {
+            i->second->done = true;
+        }
+        _pending.clear();
+        _replied.notify_all();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,117 @@
+// @file pipelined_connection.h
+
+/*
+ *    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <map>
+#include <string>
+
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    /**
+     * Lets any number of threads have requests outstanding on one connection at a time.
+     * Requests are written to the socket as they come, without waiting for the reply to the
+     * one before, and a dedicated thread reads the replies and hands each to the request
+     * whose id it is in responseTo.
+     *
+     * The server still runs a connection's requests one after the other, so this saves
+     * connections and round trips, not server side concurrency.  Only use it for queries
+     * and commands that stand alone: getLastError, setShardVersion and anything else that
+     * depends on what was last done on the connection means nothing here.
+     *
+     * Thread safe.
+     */
+    class PipelinedConnection : boost::noncopyable {
+    public:
+        class Request;
+        typedef boost::shared_ptr<Request> RequestPtr;
+
+        /**
+         * @param conn an already connected (and authenticated) connection, which is owned
+         *     from here on and must not be used directly any more.
+         */
+        explicit PipelinedConnection( DBClientConnection* conn );
+
+        /**
+         * Closes the connection; requests still waiting fail.
+         */
+        ~PipelinedConnection();
+
+        /**
+         * Sends 'toSend' (which gets its message id assigned here) and returns the handle
+         * to wait on for the reply.  If sending fails the connection is marked failed and the
+         * request fails when waited on.
+         */
+        RequestPtr send( Message& toSend );
+
+        /**
+         * Waits for the reply to 'request', for at most 'timeoutSecs' if positive.
+         *
+         * @return false if the connection failed or the wait timed out before the reply
+         *     came.  A reply that comes after a timeout is dropped.
+         */
+        bool wait( const RequestPtr& request , Message& response , double timeoutSecs = 0 );
+
+        /**
+         * Runs a command through send() and wait().
+         *
+         * @return true if the command ran and returned ok
+         */
+        bool runCommand( const std::string& dbname , const BSONObj& cmd , BSONObj& info ,
+                         double timeoutSecs = 0 );
+
+        bool isFailed() const;
+
+        /**
+         * @return the number of requests sent and not yet replied to or given up on
+         */
+        size_t numPending() const;
+
+        std::string getServerAddress() const { return _serverAddress; }
+
+    private:
+        // by message id
+        typedef std::map<unsigned, RequestPtr> RequestMap;
+
+        void _readReplies();
+        void _fail_inlock();
+
+        boost::scoped_ptr<DBClientConnection> _conn;
+        const std::string _serverAddress;
+
+        // serializes writes to the socket
+        mongo::mutex _sendMutex;
+
+        // protects all below
+        mutable mongo::mutex _mutex;
+        boost::condition _replied;
+        RequestMap _pending;
+        bool _failed;
+
+        boost::thread _reader;
+    };
+
+}  // namespace mongo
@@ -20,6 +20,8 @@
 
 #include "mongo/client/syncclusterconnection.h"
 
+#include <boost/scoped_array.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
@@ -29,6 +31,9 @@
 
 namespace mongo {
 
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip,
+                          const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
     SyncClusterConnection::SyncClusterConnection( const list<HostAndPort> & L, double socketTimeout) : _mutex("SyncClusterConnection"), _socketTimeout( socketTimeout ) {
         {
             stringstream s;
@@ -79,50 +84,81 @@ namespace mongo {
     }
 
     bool SyncClusterConnection::fsync( string& errmsg ) {
+        vector<BSONObj> replies;
+        vector<string> errors;
+        _commandOnAll( BSON( "resetError" << 1 ) , &replies , &errors );
+
+        // this is fsync=true
+        // which with journalling on is a journal commit
+        // without journalling, is a full fsync
+        _commandOnAll( BSON( "getlasterror" << 1 << "fsync" << 1 ) , &replies , &errors );
+
         bool ok = true;
         errmsg = "";
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            string singleErr;
-            try {
-                // this is fsync=true
-                // which with journalling on is a journal commit
-                // without journalling, is a full fsync
-                _conns[i]->simpleCommand( "admin", NULL, "resetError" );
-                singleErr = _conns[i]->getLastError( true );
-
-                if ( singleErr.size() == 0 )
-                    continue;
-
-            }
-            catch ( DBException& e ) {
-                singleErr = e.toString();
-            }
+            string singleErr = replies[i].isEmpty() ? errors[i] : getLastErrorString( replies[i] );
+            if ( singleErr.size() == 0 )
+                continue;
             ok = false;
             errmsg += " " + _conns[i]->toString() + ":" + singleErr;
         }
         return ok;
     }
 
-    void SyncClusterConnection::_checkLast() {
-        _lastErrors.clear();
-        vector<string> errors;
+    void SyncClusterConnection::_commandOnAll( const BSONObj& cmd ,
+                                               vector<BSONObj>* replies ,
+                                               vector<string>* errors ) {
+        replies->assign( _conns.size() , BSONObj() );
+        errors->assign( _conns.size() , "" );
+
+        // Send to every server before reading any reply, so that their fsyncs overlap instead
+        // of each one waiting for the one before it.
+        boost::scoped_array<Message> toSend( new Message[_conns.size()] );
+        for ( size_t i=0; i<_conns.size(); i++ ) {
+            try {
+                assembleRequest( "admin.$cmd" , cmd , -1 , 0 , NULL , 0 , toSend[i] );
+                _conns[i]->say( toSend[i] );
+            }
+            catch ( std::exception& e ) {
+                (*errors)[i] = e.what();
+            }
+            catch ( ... ) {
+                (*errors)[i] = "unknown failure";
+            }
+        }
 
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            BSONObj res;
-            string err;
+            if ( ! (*errors)[i].empty() )
+                continue;
+
             try {
-                if ( ! _conns[i]->runCommand( "admin" , BSON( "getlasterror" << 1 << "fsync" << 1 ) , res ) )
-                    err = "cmd failed: ";
+                Message response;
+                if ( ! _conns[i]->recv( response ) ) {
+                    (*errors)[i] = "no reply";
+                    continue;
+                }
+                QueryResult* qr = reinterpret_cast<QueryResult*>( response.singleData() );
+                if ( response.header()->responseTo != toSend[i].header()->id ||
+                     qr->nReturned != 1 ) {
+                    (*errors)[i] = "bad reply";
+                    continue;
+                }
+                (*replies)[i] = BSONObj( qr->data() ).getOwned();
+                if ( ! isOk( (*replies)[i] ) )
+                    (*errors)[i] = "cmd failed: ";
             }
             catch ( std::exception& e ) {
-                err += e.what();
+                (*errors)[i] = e.what();
             }
             catch ( ... ) {
-                err += "unknown failure";
+                (*errors)[i] = "unknown failure";
             }
-            _lastErrors.push_back( res.getOwned() );
-            errors.push_back( err );
         }
+    }
+
+    void SyncClusterConnection::_checkLast() {
+        vector<string> errors;
+        _commandOnAll( BSON( "getlasterror" << 1 << "fsync" << 1 ) , &_lastErrors , &errors );
 
         verify( _lastErrors.size() == errors.size() && _lastErrors.size() == _conns.size() );
 
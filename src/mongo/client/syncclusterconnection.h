@@ -123,6 +123,14 @@ namespace mongo {
                                                 const BSONObj *fieldsToReturn, int queryOptions, int batchSize );
         int _lockType( const string& name );
         void _checkLast();
+
+        /**
+         * Runs 'cmd' against the admin database of every server at once.  (*replies)[i] is
+         * server i's reply, and (*errors)[i] is empty unless it failed or couldn't be reached.
+         */
+        void _commandOnAll( const BSONObj& cmd ,
+                            vector<BSONObj>* replies ,
+                            vector<string>* errors );
         void _connect( const std::string& host );
 
         string _address;
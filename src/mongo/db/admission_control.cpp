@@ -0,0 +1,174 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/admission_control.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+    // Off by default: with it on, reads and writes beyond the current limits wait in
+    // assembleResponse before going for locks.
+    MONGO_EXPORT_SERVER_PARAMETER(admissionControl, bool, false);
+
+    // The average lock wait the limits are adjusted to stay under.
+    MONGO_EXPORT_SERVER_PARAMETER(admissionTargetLockWaitMicros, int, 2000);
+
+    // Bounds on each of the read and write limits.
+    MONGO_EXPORT_SERVER_PARAMETER(admissionMinConcurrency, int, 4);
+    MONGO_EXPORT_SERVER_PARAMETER(admissionMaxConcurrency, int, 128);
+
+    namespace {
+
+        AdmissionQueue readQueue(128);
+        AdmissionQueue writeQueue(128);
+
+        class AdmissionServerStatusSection : public ServerStatusSection {
+        public:
+            AdmissionServerStatusSection() : ServerStatusSection( "admission" ) { }
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+                b.appendBool( "enabled", admissionControl );
+                {
+                    BSONObjBuilder read( b.subobjStart( "read" ) );
+                    readQueue.append( &read );
+                    read.doneFast();
+                }
+                {
+                    BSONObjBuilder write( b.subobjStart( "write" ) );
+                    writeQueue.append( &write );
+                    write.doneFast();
+                }
+                return b.obj();
+            }
+        } admissionServerStatusSection;
+
+    }  // namespace
+
+    AdmissionQueue::AdmissionQueue(int initialLimit) : _tickets(initialLimit) {
+    }
+
+    void AdmissionQueue::admit() {
+        _admitted.fetchAndAdd(1);
+        if (_tickets.tryAcquire()) {
+            return;
+        }
+
+        _queued.fetchAndAdd(1);
+        _sampleQueued.store(1);
+        const unsigned long long start = curTimeMicros64();
+        _tickets.waitForTicket();
+        _queueMicros.fetchAndAdd(curTimeMicros64() - start);
+    }
+
+    void AdmissionQueue::release(long long lockWaitMicros, long long targetLockWaitMicros,
+                                 int minLimit, int maxLimit) {
+        _sampleLockWaitMicros.fetchAndAdd(lockWaitMicros);
+        if (_sampleCount.addAndFetch(1) == kSampleSize) {
+            const long long sampleLockWait = _sampleLockWaitMicros.swap(0);
+            const bool queued = _sampleQueued.swap(0);
+            _sampleCount.store(0);
+
+            const int current = _tickets.outof();
+            const int next = adjustedLimit(current, sampleLockWait / kSampleSize,
+                                           targetLockWaitMicros, queued, minLimit, maxLimit);
+            if (next != current) {
+                LOG(2) << "admission limit " << current << " -> " << next << endl;
+                _tickets.setLimit(next);
+            }
+        }
+        _tickets.release();
+    }
+
+    void AdmissionQueue::cancel() {
+        _tickets.release();
+    }
+
+    void AdmissionQueue::append(BSONObjBuilder* b) const {
+        b->append("limit", _tickets.outof());
+        b->append("inUse", _tickets.used());
+        b->append("waiting", _tickets.waiting());
+        b->appendNumber("admitted", _admitted.load());
+        b->appendNumber("queued", _queued.load());
+        b->appendNumber("queueMicros", _queueMicros.load());
+    }
+
+    int AdmissionQueue::adjustedLimit(int current, long long avgLockWaitMicros,
+                                      long long targetLockWaitMicros, bool queued,
+                                      int minLimit, int maxLimit) {
+        int next = current;
+        if (avgLockWaitMicros > targetLockWaitMicros) {
+            next = current - std::max(1, current / 4);
+        }
+        else if (queued) {
+            next = current + 1;
+        }
+        return std::max(minLimit, std::min(maxLimit, next));
+    }
+
+    AdmissionTicket::AdmissionTicket(const StringData& ns, int op, bool isCommand, bool nested)
+        : _queue(NULL) {
+        if (!admissionControl || isCommand || nested) {
+            return;
+        }
+        // replication tails the oplog with getMores that wait for data; it mustn't queue
+        // behind client load
+        if (ns.startsWith("local.")) {
+            return;
+        }
+
+        switch (op) {
+        case dbQuery:
+        case dbGetMore:
+            _queue = &readQueue;
+            break;
+        case dbInsert:
+        case dbUpdate:
+        case dbDelete:
+            _queue = &writeQueue;
+            break;
+        default:
+            return;
+        }
+        _queue->admit();
+    }
+
+    void AdmissionTicket::done(long long lockWaitMicros) {
+        if (NULL == _queue) {
+            return;
+        }
+        _queue->release(lockWaitMicros, admissionTargetLockWaitMicros,
+                        std::max(1, std::min(admissionMinConcurrency,
+                                             admissionMaxConcurrency)),
+                        admissionMaxConcurrency);
+        _queue = NULL;
+    }
+
+    AdmissionTicket::~AdmissionTicket() {
+        if (NULL != _queue) {
+            _queue->cancel();
+        }
+    }
+
+}  // namespace mongo
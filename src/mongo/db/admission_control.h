@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/ticketholder.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Caps how many operations of one kind may be past admission, and so going for locks, at
+     * once; the rest queue here instead of convoying on the lock.
+     *
+     * The cap adapts to the lock wait the admitted operations see: every kSampleSize
+     * operations it shrinks by a quarter if their average wait was over the target, and
+     * grows by one if it was under and operations had to queue.
+     *
+     * Thread safe.
+     */
+    class AdmissionQueue {
+        MONGO_DISALLOW_COPYING(AdmissionQueue);
+    public:
+        static const int kSampleSize = 256;
+
+        AdmissionQueue(int initialLimit);
+
+        /**
+         * Blocks until there is room for one more operation.
+         */
+        void admit();
+
+        /**
+         * Marks one admitted operation as done; it waited 'lockWaitMicros' for locks.
+         */
+        void release(long long lockWaitMicros, long long targetLockWaitMicros,
+                     int minLimit, int maxLimit);
+
+        /**
+         * Gives back the place of an operation that didn't finish, without sampling it.
+         */
+        void cancel();
+
+        int limit() const { return _tickets.outof(); }
+
+        void append(BSONObjBuilder* b) const;
+
+        /**
+         * @return the limit to use next, given the current one, the average lock wait over
+         *     the last sample and whether anything had to queue during it.
+         */
+        static int adjustedLimit(int current, long long avgLockWaitMicros,
+                                 long long targetLockWaitMicros, bool queued,
+                                 int minLimit, int maxLimit);
+
+    private:
+        TicketHolder _tickets;
+
+        AtomicInt64 _admitted;
+        AtomicInt64 _queued;
+        AtomicInt64 _queueMicros;
+
+        // The current sample; whoever completes it adjusts the limit and starts the next.
+        AtomicInt32 _sampleCount;
+        AtomicInt64 _sampleLockWaitMicros;
+        AtomicInt32 _sampleQueued;
+    };
+
+    /**
+     * Holds a place in the read or write admission queue for the life of one client
+     * operation, if admission control is on and the operation is one it applies to: queries
+     * and getMores are reads; inserts, updates and deletes are writes.  Commands, which
+     * include the ones needed to see and fix an overloaded server, always go straight in,
+     * as do operations on the local database, which replication depends on, and nested ones,
+     * which run inside an operation that was already admitted.
+     */
+    class AdmissionTicket {
+        MONGO_DISALLOW_COPYING(AdmissionTicket);
+    public:
+        AdmissionTicket(const StringData& ns, int op, bool isCommand, bool nested);
+
+        /**
+         * Releases the place, if one was taken, crediting the operation with
+         * 'lockWaitMicros' of lock wait.
+         */
+        void done(long long lockWaitMicros);
+
+        ~AdmissionTicket();
+
+    private:
+        AdmissionQueue* _queue;
+    };
+
+}  // namespace mongo
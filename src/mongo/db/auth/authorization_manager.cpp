@@ -107,6 +107,7 @@ namespace {
         readRoleActions.addAction(ActionType::find);
         readRoleActions.addAction(ActionType::indexRead);
         readRoleActions.addAction(ActionType::killCursors);
+        readRoleActions.addAction(ActionType::planCacheRead);
 
         // Read-write role
         readWriteRoleActions.addAllActionsFromSet(readRoleActions);
@@ -118,6 +119,7 @@ namespace {
         readWriteRoleActions.addAction(ActionType::emptycapped);
         readWriteRoleActions.addAction(ActionType::ensureIndex);
         readWriteRoleActions.addAction(ActionType::insert);
+        readWriteRoleActions.addAction(ActionType::planCacheWrite);
         readWriteRoleActions.addAction(ActionType::remove);
         readWriteRoleActions.addAction(ActionType::renameCollectionSameDB); // db admin gets this also
         readWriteRoleActions.addAction(ActionType::update);
@@ -139,6 +141,8 @@ namespace {
         dbAdminRoleActions.addAction(ActionType::ensureIndex);
         dbAdminRoleActions.addAction(ActionType::indexRead);
         dbAdminRoleActions.addAction(ActionType::indexStats);
+        dbAdminRoleActions.addAction(ActionType::planCacheRead);
+        dbAdminRoleActions.addAction(ActionType::planCacheWrite);
         dbAdminRoleActions.addAction(ActionType::profileEnable);
         dbAdminRoleActions.addAction(ActionType::profileRead);
         dbAdminRoleActions.addAction(ActionType::reIndex);
@@ -651,44 +655,67 @@ namespace {
     }
 
     Status AuthorizationManager::acquireUser(const UserName& userName, User** acquiredUser) {
-        boost::lock_guard<boost::mutex> lk(_lock);
-        unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
-        if (it != _userCache.end()) {
-            fassert(16914, it->second);
-            it->second->incrementRefCount();
-            *acquiredUser = it->second;
-            return Status::OK();
-        }
+        while (true) {
+            unsigned long long epoch;
+            {
+                boost::lock_guard<boost::mutex> lk(_lock);
+                unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
+                if (it != _userCache.end()) {
+                    fassert(16914, it->second);
+                    it->second->incrementRefCount();
+                    *acquiredUser = it->second;
+                    return Status::OK();
+                }
+                epoch = _cacheEpoch.load();
+            }
+
+            // Build the user without holding _lock, so that a cache miss, which has to read the
+            // privilege document, doesn't hold up every other thread acquiring a user.
+            // Put the new user into an auto_ptr temporarily in case there's an error while
+            // initializing the user.
+            auto_ptr<User> userHolder(new User(userName));
+            User* user = userHolder.get();
+
+            BSONObj userObj;
+            if (_version == 1) {
+                Status status = _externalState->getPrivilegeDocument(userName.getDB().toString(),
+                                                                     userName,
+                                                                     &userObj);
+                if (!status.isOK()) {
+                    return status;
+                }
+            } else {
+                return Status(ErrorCodes::UnsupportedFormat,
+                              mongoutils::str::stream() <<
+                                      "Unrecognized authorization format version: " << _version);
+            }
 
-        // Put the new user into an auto_ptr temporarily in case there's an error while
-        // initializing the user.
-        auto_ptr<User> userHolder(new User(userName));
-        User* user = userHolder.get();
 
-        BSONObj userObj;
-        if (_version == 1) {
-            Status status = _externalState->getPrivilegeDocument(userName.getDB().toString(),
-                                                                 userName,
-                                                                 &userObj);
+            Status status = _initializeUserFromPrivilegeDocument(user, userObj);
             if (!status.isOK()) {
                 return status;
             }
-        } else {
-            return Status(ErrorCodes::UnsupportedFormat,
-                          mongoutils::str::stream() <<
-                                  "Unrecognized authorization format version: " << _version);
-        }
 
+            boost::lock_guard<boost::mutex> lk(_lock);
+            if (_cacheEpoch.load() != epoch) {
+                // The cache was invalidated while we were reading, so what we read may already
+                // be out of date.  Start over.
+                continue;
+            }
 
-        Status status = _initializeUserFromPrivilegeDocument(user, userObj);
-        if (!status.isOK()) {
-            return status;
-        }
+            unordered_map<UserName, User*>::iterator it = _userCache.find(userName);
+            if (it != _userCache.end()) {
+                // Another thread built this user while we were; use its copy.
+                it->second->incrementRefCount();
+                *acquiredUser = it->second;
+                return Status::OK();
+            }
 
-        user->incrementRefCount();
-        _userCache.insert(make_pair(userName, userHolder.release()));
-        *acquiredUser = user;
-        return Status::OK();
+            user->incrementRefCount();
+            _userCache.insert(make_pair(userName, userHolder.release()));
+            *acquiredUser = user;
+            return Status::OK();
+        }
     }
 
     void AuthorizationManager::releaseUser(User* user) {
@@ -811,12 +838,22 @@ namespace {
         return Status::OK();
     }
 
+    void AuthorizationManager::invalidateUserCache() {
+        boost::lock_guard<boost::mutex> lk(_lock);
+        _invalidateUserCache_inlock();
+    }
+
+    unsigned long long AuthorizationManager::getCacheEpoch() const {
+        return _cacheEpoch.load();
+    }
+
     void AuthorizationManager::_invalidateUserCache_inlock() {
         for (unordered_map<UserName, User*>::iterator it = _userCache.begin();
                 it != _userCache.end(); ++it) {
             it->second->invalidate();
         }
         _userCache.clear();
+        _cacheEpoch.fetchAndAdd(1);
     }
 
     Status AuthorizationManager::initilizeAllV1UserData() {
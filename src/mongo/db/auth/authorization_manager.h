@@ -29,6 +29,7 @@
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/auth/user_name_hash.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -143,6 +144,20 @@ namespace mongo {
          */
         void releaseUser(User* user);
 
+        /**
+         * Invalidates every User object in the cache and removes them from it, so that the next
+         * acquireUser() of any user reads its privilege document again.  Call this whenever user
+         * or role information changes.
+         */
+        void invalidateUserCache();
+
+        /**
+         * Returns a number that changes every time the user cache is invalidated.  Reading it
+         * takes no lock, so AuthorizationSessions check it on every operation to find out when
+         * authorization results they have cached may be out of date.
+         */
+        unsigned long long getCacheEpoch() const;
+
         /**
          * Initializes the user cache with User objects for every v0 and v1 user document in the
          * system, by reading the system.users collection of every database.  If this function
@@ -185,8 +200,8 @@ namespace mongo {
                                                     const BSONObj& privDoc) const;
 
         /**
-         * Invalidates all User objects in the cache and removes them from the cache.
-         * Should only be called when already holding _lock.
+         * Invalidates all User objects in the cache, removes them from the cache and moves
+         * _cacheEpoch on.  Should only be called when already holding _lock.
          */
         void _invalidateUserCache_inlock();
 
@@ -215,9 +230,14 @@ namespace mongo {
         unordered_map<UserName, User*> _userCache;
 
         /**
-         * Protects _userCache.
+         * Protects _userCache.  Never held while reading privilege documents.
          */
         boost::mutex _lock;
+
+        /**
+         * Incremented, under _lock, every time the user cache is invalidated.  Read without it.
+         */
+        AtomicUInt64 _cacheEpoch;
     };
 
 } // namespace mongo
@@ -42,8 +42,10 @@ namespace {
     const std::string ADMIN_DBNAME = "admin";
 }  // namespace
 
-    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) {
+    AuthorizationSession::AuthorizationSession(AuthzSessionExternalState* externalState) :
+            _authorizedActionsEpoch(0) {
         _externalState.reset(externalState);
+        _authorizedActionsEpoch = getAuthorizationManager().getCacheEpoch();
     }
 
     AuthorizationSession::~AuthorizationSession(){}
@@ -108,6 +110,7 @@ namespace {
             return;
         _acquiredPrivileges.revokePrivilegesFromUser(principal->getName());
         _authenticatedPrincipals.removeByDBName(dbname);
+        _clearAuthorizedActionsCache();
         _externalState->onLogoutDatabase(dbname);
     }
 
@@ -300,7 +303,38 @@ namespace {
         return Status::OK();
     }
 
+    void AuthorizationSession::_clearAuthorizedActionsCache() {
+        if (!_authorizedActions.empty())
+            _authorizedActions = AuthorizedActionsCache();
+    }
+
     Status AuthorizationSession::_probeForPrivilege(const Privilege& privilege) {
+        const unsigned long long epoch = getAuthorizationManager().getCacheEpoch();
+        if (epoch != _authorizedActionsEpoch) {
+            _clearAuthorizedActionsCache();
+            _authorizedActionsEpoch = epoch;
+        }
+
+        AuthorizedActionsCache::const_iterator cached =
+                _authorizedActions.find(privilege.getResource());
+        if (cached != _authorizedActions.end() &&
+                cached->second.isSupersetOf(privilege.getActions())) {
+            return Status::OK();
+        }
+
+        Status status = _probeForPrivilegeUncached(privilege);
+        if (status.isOK()) {
+            if (cached == _authorizedActions.end() &&
+                    _authorizedActions.size() >= kMaxAuthorizedActionsCacheSize) {
+                _clearAuthorizedActionsCache();
+            }
+            _authorizedActions[privilege.getResource()].addAllActionsFromSet(
+                    privilege.getActions());
+        }
+        return status;
+    }
+
+    Status AuthorizationSession::_probeForPrivilegeUncached(const Privilege& privilege) {
         Privilege modifiedPrivilege = _modifyPrivilegeForSpecialCases(privilege);
         if (_acquiredPrivileges.hasPrivilege(modifiedPrivilege))
             return Status::OK();
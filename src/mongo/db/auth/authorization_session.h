@@ -30,6 +30,7 @@
 #include "mongo/db/auth/privilege.h"
 #include "mongo/db/auth/privilege_set.h"
 #include "mongo/db/auth/user_name.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -133,15 +134,30 @@ namespace mongo {
         void _acquirePrivilegesForPrincipalFromDatabase(const std::string& dbname,
                                                         const UserName& user);
 
+        // Checks to see if the given privilege is allowed, answering from _authorizedActions
+        // when it can and calling _probeForPrivilegeUncached when it can't.
+        Status _probeForPrivilege(const Privilege& privilege);
+
         // Checks to see if the given privilege is allowed, performing implicit privilege
         // acquisition if enabled and necessary to resolve the privilege.
-        Status _probeForPrivilege(const Privilege& privilege);
+        Status _probeForPrivilegeUncached(const Privilege& privilege);
 
         // Returns a new privilege that has replaced the actions needed to handle special casing
         // certain namespaces like system.users and system.profile.  Note that the special handling
         // of system.indexes takes place in checkAuthForInsert, not here.
         Privilege _modifyPrivilegeForSpecialCases(const Privilege& privilege);
 
+        // Forgets every result in _authorizedActions.  Called whenever the privileges of this
+        // session may have shrunk.
+        void _clearAuthorizedActionsCache();
+
+        // Most connections check the same few (resource, actions) pairs over and over; the
+        // ones granted are kept here so that repeat checks skip special case handling and
+        // the PrivilegeSet lookups.  Only kept for as long as the AuthorizationManager's user
+        // cache epoch stays at _authorizedActionsEpoch.
+        typedef StringMap<ActionSet> AuthorizedActionsCache;
+        static const size_t kMaxAuthorizedActionsCacheSize = 64;
+
 
         scoped_ptr<AuthzSessionExternalState> _externalState;
 
@@ -149,6 +165,10 @@ namespace mongo {
         PrivilegeSet _acquiredPrivileges;
         // All principals who have been authenticated on this connection
         PrincipalSet _authenticatedPrincipals;
+
+        // Actions already found to be authorized, by the resource they were checked on.
+        AuthorizedActionsCache _authorizedActions;
+        unsigned long long _authorizedActionsEpoch;
     };
 
 } // namespace mongo
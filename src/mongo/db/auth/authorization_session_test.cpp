@@ -67,6 +67,41 @@ namespace {
         ASSERT_FALSE(authzSession.checkAuthorization("test", ActionType::insert));
     }
 
+    TEST(AuthorizationSessionTest, RepeatedChecksFollowPrivilegeChanges) {
+        AuthzManagerExternalStateMock* managerExternalState = new AuthzManagerExternalStateMock();
+        AuthorizationManager authManager(managerExternalState);
+        AuthzSessionExternalStateMock* sessionExternalState = new AuthzSessionExternalStateMock(
+                &authManager);
+        AuthorizationSession authzSession(sessionExternalState);
+
+        Principal* principal = new Principal(UserName("Spencer", "test"));
+        authzSession.addAuthorizedPrincipal(principal);
+        ASSERT_OK(authzSession.acquirePrivilege(Privilege("test", ActionType::insert),
+                                                principal->getName()));
+
+        ASSERT_TRUE(authzSession.checkAuthorization("test.foo", ActionType::insert));
+        ASSERT_TRUE(authzSession.checkAuthorization("test.foo", ActionType::insert));
+        // A check already granted for some actions must not grant more.
+        ActionSet insertAndFind;
+        insertAndFind.addAction(ActionType::insert);
+        insertAndFind.addAction(ActionType::find);
+        ASSERT_FALSE(authzSession.checkAuthorization("test.foo", insertAndFind));
+        ASSERT_FALSE(authzSession.checkAuthorization("test.foo", ActionType::find));
+
+        ASSERT_OK(authzSession.acquirePrivilege(Privilege("test", ActionType::find),
+                                                principal->getName()));
+        ASSERT_TRUE(authzSession.checkAuthorization("test.foo", insertAndFind));
+
+        // Invalidating the user cache throws away what was cached, but not the privileges.
+        const unsigned long long epoch = authManager.getCacheEpoch();
+        authManager.invalidateUserCache();
+        ASSERT_NOT_EQUALS(epoch, authManager.getCacheEpoch());
+        ASSERT_TRUE(authzSession.checkAuthorization("test.foo", insertAndFind));
+
+        authzSession.logoutDatabase("test");
+        ASSERT_FALSE(authzSession.checkAuthorization("test.foo", ActionType::insert));
+    }
+
     class AuthManagerExternalStateImplictPriv : public AuthzManagerExternalStateMock {
     public:
         AuthManagerExternalStateImplictPriv() : AuthzManagerExternalStateMock() {}
@@ -33,7 +33,8 @@ namespace {
     RoleGraph::RoleGraph(const RoleGraph& other) : _roleToSubordinates(other._roleToSubordinates),
             _roleToMembers(other._roleToMembers),
             _directPrivilegesForRole(other._directPrivilegesForRole),
-            _allPrivilegesForRole(other._allPrivilegesForRole) {}
+            _allPrivilegesForRole(other._allPrivilegesForRole),
+            _staleRoles(other._staleRoles) {}
     RoleGraph::~RoleGraph() {};
 
     void RoleGraph::swap(RoleGraph& other) {
@@ -42,6 +43,7 @@ namespace {
         swap(this->_roleToMembers, other._roleToMembers);
         swap(this->_directPrivilegesForRole, other._directPrivilegesForRole);
         swap(this->_allPrivilegesForRole, other._allPrivilegesForRole);
+        swap(this->_staleRoles, other._staleRoles);
     }
 
     void swap(RoleGraph& lhs, RoleGraph& rhs) {
@@ -82,6 +84,7 @@ namespace {
         _roleToMembers[role];
         _directPrivilegesForRole[role];
         _allPrivilegesForRole[role];
+        _staleRoles.insert(role);
         return Status::OK();
     }
 
@@ -92,6 +95,7 @@ namespace {
                                   " does not exist",
                           0);
         }
+        _markStale(role);
         for (unordered_set<RoleName>::iterator it = _roleToSubordinates[role].begin();
                 it != _roleToSubordinates[role].end(); ++it) {
             _roleToMembers[*it].erase(role);
@@ -104,6 +108,7 @@ namespace {
         _roleToMembers.erase(role);
         _directPrivilegesForRole.erase(role);
         _allPrivilegesForRole.erase(role);
+        _staleRoles.erase(role);
         return Status::OK();
     }
 
@@ -149,6 +154,7 @@ namespace {
 
         _roleToSubordinates[recipient].insert(role);
         _roleToMembers[role].insert(recipient);
+        _markStale(recipient);
         return Status::OK();
     }
 
@@ -179,6 +185,7 @@ namespace {
                         recipient.getFullName() << " is a member of " << role.getFullName() <<
                         ". This shouldn't be possible",
                 _roleToSubordinates[recipient].erase(role));
+        _markStale(recipient);
         return Status::OK();
     }
 
@@ -209,6 +216,7 @@ namespace {
         }
 
         addPrivilegeToPrivilegeVector(_directPrivilegesForRole[role], privilegeToAdd);
+        _markStale(role);
         return Status::OK();
 
     }
@@ -260,6 +268,7 @@ namespace {
                 if (curPrivilege.getActions().empty()) {
                     currentPrivileges.erase(it);
                 }
+                _markStale(role);
                 return Status::OK();
             }
         }
@@ -295,33 +304,60 @@ namespace {
                           0);
         }
         _directPrivilegesForRole[role].clear();
+        _markStale(role);
         return Status::OK();
     }
 
+    void RoleGraph::_markStale(const RoleName& role) {
+        // Every member of a stale role is already stale, so the walk can stop at any role that
+        // is.  That keeps the total cost of marking between two recomputes O(n+m).
+        std::vector<RoleName> toMark;
+        toMark.push_back(role);
+        while (!toMark.empty()) {
+            RoleName current = toMark.back();
+            toMark.pop_back();
+            if (!_staleRoles.insert(current).second)
+                continue;
+            const unordered_set<RoleName>& members = _roleToMembers[current];
+            for (unordered_set<RoleName>::const_iterator it = members.begin();
+                    it != members.end(); ++it) {
+                toMark.push_back(*it);
+            }
+        }
+    }
+
     Status RoleGraph::recomputePrivilegeData() {
         /*
-         * This method is used to recompute the "allPrivileges" vector for each node in the graph,
-         * as well as look for cycles.  It is implemented by performing a depth-first traversal of
-         * the dependency graph, once for each node.  "visitedRoles" tracks the set of role names
-         * ever visited, and it is used to prune each DFS.  A node that has been visited once on any
-         * DFS is never visited again.  Complexity of this implementation is O(n+m) where "n" is the
-         * number of nodes and "m" is the number of prerequisite edges.  Space complexity is O(n),
-         * in both stack space and size of the "visitedRoles" set.
+         * This method is used to recompute the "allPrivileges" vector for each stale node in the
+         * graph, as well as look for cycles.  It is implemented by performing a depth-first
+         * traversal of the dependency graph, once for each stale node.  "visitedRoles" tracks the
+         * set of role names ever visited, and it is used to prune each DFS; so are the nodes that
+         * aren't stale, whose "allPrivileges" vectors are already right.  A node that has been
+         * visited once on any DFS is never visited again.  Complexity of this implementation is
+         * O(n+m) where "n" is the number of stale nodes and "m" is the number of prerequisite
+         * edges out of them.  Space complexity is O(n), in both stack space and size of the
+         * "visitedRoles" set.
          *
-         * "inProgressRoles" is used to detect and report cycles.
+         * Any cycle added since the last recompute goes through an added edge, and so only
+         * through stale nodes; "inProgressRoles" is used to detect and report it.
          */
 
         std::vector<RoleName> inProgressRoles;
+        unordered_set<RoleName> inProgressRoleSet;
         unordered_set<RoleName> visitedRoles;
 
-        for (EdgeSet::const_iterator it = _roleToSubordinates.begin();
-                it != _roleToSubordinates.end(); ++it) {
-            Status status = _recomputePrivilegeDataHelper(it->first, inProgressRoles, visitedRoles);
+        for (unordered_set<RoleName>::const_iterator it = _staleRoles.begin();
+                it != _staleRoles.end(); ++it) {
+            Status status = _recomputePrivilegeDataHelper(*it,
+                                                          inProgressRoles,
+                                                          inProgressRoleSet,
+                                                          visitedRoles);
             if (status != Status::OK()) {
                 return status;
             }
         }
 
+        _staleRoles.clear();
         return Status::OK();
     }
 
@@ -331,9 +367,10 @@ namespace {
      */
     Status RoleGraph::_recomputePrivilegeDataHelper(const RoleName& currentRole,
                                                     std::vector<RoleName>& inProgressRoles,
+                                                    unordered_set<RoleName>& inProgressRoleSet,
                                                     unordered_set<RoleName>& visitedRoles) {
 
-        if (visitedRoles.count(currentRole)) {
+        if (visitedRoles.count(currentRole) || !_staleRoles.count(currentRole)) {
             return Status::OK();
         }
 
@@ -345,9 +382,9 @@ namespace {
         }
 
         // Check for cycles
-        std::vector<RoleName>::iterator firstOccurence = std::find(
-                inProgressRoles.begin(), inProgressRoles.end(), currentRole);
-        if (firstOccurence != inProgressRoles.end()) {
+        if (inProgressRoleSet.count(currentRole)) {
+            std::vector<RoleName>::iterator firstOccurence = std::find(
+                    inProgressRoles.begin(), inProgressRoles.end(), currentRole);
             std::ostringstream os;
             os << "Cycle in dependency graph: ";
             for (std::vector<RoleName>::iterator it = firstOccurence;
@@ -359,14 +396,19 @@ namespace {
         }
 
         inProgressRoles.push_back(currentRole);
+        inProgressRoleSet.insert(currentRole);
 
         // Need to clear out the "all privileges" vector for the current role, and re-fill it with
-        // just the direct privileges for this role.
+        // just the direct privileges for this role.  The direct privileges are already de-duped
+        // by resource.  "resourceIndex" maps each resource to its privilege's position in the
+        // vector, so merging in the children's privileges is linear in their number.
         PrivilegeVector& currentRoleAllPrivileges = _allPrivilegesForRole[currentRole];
         const PrivilegeVector& currentRoleDirectPrivileges = _directPrivilegesForRole[currentRole];
+        unordered_map<std::string, size_t> resourceIndex;
         currentRoleAllPrivileges.clear();
         for (PrivilegeVector::const_iterator it = currentRoleDirectPrivileges.begin();
                 it != currentRoleDirectPrivileges.end(); ++it) {
+            resourceIndex[it->getResource()] = currentRoleAllPrivileges.size();
             currentRoleAllPrivileges.push_back(*it);
         }
 
@@ -375,7 +417,10 @@ namespace {
         for (unordered_set<RoleName>::const_iterator roleIt = children.begin();
                 roleIt != children.end(); ++roleIt) {
             const RoleName& childRole = *roleIt;
-            Status status = _recomputePrivilegeDataHelper(childRole, inProgressRoles, visitedRoles);
+            Status status = _recomputePrivilegeDataHelper(childRole,
+                                                          inProgressRoles,
+                                                          inProgressRoleSet,
+                                                          visitedRoles);
             if (status != Status::OK()) {
                 return status;
             }
@@ -385,13 +430,23 @@ namespace {
             const PrivilegeVector& childsPrivileges = _allPrivilegesForRole[childRole];
             for (PrivilegeVector::const_iterator privIt = childsPrivileges.begin();
                     privIt != childsPrivileges.end(); ++privIt) {
-                addPrivilegeToPrivilegeVector(currentRoleAllPrivileges, *privIt);
+                std::pair<unordered_map<std::string, size_t>::iterator, bool> inserted =
+                        resourceIndex.insert(std::make_pair(privIt->getResource(),
+                                                            currentRoleAllPrivileges.size()));
+                if (inserted.second) {
+                    currentRoleAllPrivileges.push_back(*privIt);
+                }
+                else {
+                    currentRoleAllPrivileges[inserted.first->second].addActions(
+                            privIt->getActions());
+                }
             }
         }
 
         if (inProgressRoles.back() != currentRole)
             return Status(ErrorCodes::InternalError, "inProgressRoles stack corrupt");
         inProgressRoles.pop_back();
+        inProgressRoleSet.erase(currentRole);
         visitedRoles.insert(currentRole);
         return Status::OK();
     }
@@ -37,6 +37,11 @@ namespace mongo {
      * recomputePrivilegeData() before calling getAllPrivileges() if any of the mutation methods
      * have been called on the instance since the later of its construction or the last call to
      * recomputePrivilegeData() on the object.
+     *
+     * The transitive privileges of every role are kept precomputed.  Each mutation marks the
+     * roles whose transitive privileges it may change (the role itself and everything that is
+     * a member of it, directly or not) and recomputePrivilegeData() recomputes only those, so
+     * a change to one corner of a large graph doesn't cost a walk of all of it.
      */
     class RoleGraph {
     public:
@@ -152,7 +157,8 @@ namespace mongo {
         Status removeAllPrivilegesFromRole(const RoleName& role);
 
         /**
-         * Recomputes the indirect (getAllPrivileges) data for this graph.
+         * Recomputes the indirect (getAllPrivileges) data for the roles of this graph that
+         * mutations since the last call may have changed.
          *
          * Must be called between calls to any of the mutation functions and calls
          * to getAllPrivileges().
@@ -167,8 +173,13 @@ namespace mongo {
         // data and look for cycles
         Status _recomputePrivilegeDataHelper(const RoleName& currentRole,
                                              std::vector<RoleName>& inProgressRoles,
+                                             unordered_set<RoleName>& inProgressRoleSet,
                                              unordered_set<RoleName>& visitedRoles);
 
+        // Marks "role", and every role that is a member of it directly or transitively, as
+        // needing its indirect privilege data recomputed.
+        void _markStale(const RoleName& role);
+
         // Represents all the outgoing edges to other roles from any given role.
         typedef unordered_map<RoleName, unordered_set<RoleName> > EdgeSet;
         // Maps a role name to a list of privileges associated with that role.
@@ -178,6 +189,10 @@ namespace mongo {
         EdgeSet _roleToMembers;
         RolePrivilegeMap _directPrivilegesForRole;
         RolePrivilegeMap _allPrivilegesForRole;
+
+        // Roles whose _allPrivilegesForRole entry is out of date.  Every member of a role in
+        // here is in here as well.
+        unordered_set<RoleName> _staleRoles;
     };
 
     void swap(RoleGraph& lhs, RoleGraph& rhs);
@@ -460,6 +460,56 @@ namespace {
         ASSERT_FALSE(privileges[0].getActions().contains(ActionType::insert));
     }
 
+    // Tests that recomputing after a change deep in the graph updates every role above it, and
+    // that cycles added after a recompute are still caught.
+    TEST(RoleGraphTest, IncrementalRecompute) {
+        RoleName roleA("roleA", "dbA");
+        RoleName roleB("roleB", "dbB");
+        RoleName roleC("roleC", "dbC");
+        RoleName roleD("roleD", "dbD");
+
+        // A -> B -> C, and D -> C
+        RoleGraph graph;
+        ASSERT_OK(graph.createRole(roleA));
+        ASSERT_OK(graph.createRole(roleB));
+        ASSERT_OK(graph.createRole(roleC));
+        ASSERT_OK(graph.createRole(roleD));
+        ASSERT_OK(graph.addRoleToRole(roleA, roleB));
+        ASSERT_OK(graph.addRoleToRole(roleB, roleC));
+        ASSERT_OK(graph.addRoleToRole(roleD, roleC));
+        ASSERT_OK(graph.addPrivilegeToRole(roleA, Privilege("dbA", ActionType::find)));
+        ASSERT_OK(graph.addPrivilegeToRole(roleD, Privilege("dbD", ActionType::find)));
+        ASSERT_OK(graph.recomputePrivilegeData());
+        ASSERT_EQUALS(static_cast<size_t>(1), graph.getAllPrivileges(roleA).size());
+
+        ASSERT_OK(graph.addPrivilegeToRole(roleC, Privilege("dbA", ActionType::insert)));
+        ASSERT_OK(graph.addPrivilegeToRole(roleC, Privilege("dbC", ActionType::update)));
+        ASSERT_OK(graph.recomputePrivilegeData());
+
+        PrivilegeVector privileges = graph.getAllPrivileges(roleA);
+        ASSERT_EQUALS(static_cast<size_t>(2), privileges.size());
+        for (size_t i = 0; i < privileges.size(); ++i) {
+            if (privileges[i].getResource() == "dbA") {
+                ASSERT_TRUE(privileges[i].getActions().contains(ActionType::find));
+                ASSERT_TRUE(privileges[i].getActions().contains(ActionType::insert));
+            }
+            else {
+                ASSERT_EQUALS("dbC", privileges[i].getResource());
+                ASSERT_TRUE(privileges[i].getActions().contains(ActionType::update));
+            }
+        }
+        ASSERT_EQUALS(static_cast<size_t>(2), graph.getAllPrivileges(roleB).size());
+        ASSERT_EQUALS(static_cast<size_t>(3), graph.getAllPrivileges(roleD).size());
+
+        // C -> A closes a cycle through roles whose privileges were all up to date.
+        ASSERT_OK(graph.addRoleToRole(roleC, roleA));
+        ASSERT_EQUALS(ErrorCodes::GraphContainsCycle, graph.recomputePrivilegeData().code());
+        ASSERT_OK(graph.removeRoleFromRole(roleC, roleA));
+        ASSERT_OK(graph.recomputePrivilegeData());
+        ASSERT_EQUALS(static_cast<size_t>(2), graph.getAllPrivileges(roleA).size());
+        ASSERT_EQUALS(static_cast<size_t>(2), graph.getAllPrivileges(roleC).size());
+    }
+
     // Tests copy constructor and swap functionality.
     TEST(RoleGraphTest, CopySwap) {
         RoleName roleA("roleA", "dbA");
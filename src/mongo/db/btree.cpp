@@ -34,12 +34,15 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/server.h"
+#include "mongo/util/mmap.h"
 #include "mongo/util/startup_test.h"
 
 namespace mongo {
 
     BOOST_STATIC_ASSERT( Record::HeaderSize == 16 );
     BOOST_STATIC_ASSERT( Record::HeaderSize + BtreeData_V1::BucketSize == 8192 );
+    BOOST_STATIC_ASSERT( Record::HeaderSize + BtreeData_V2::BucketSize == 8192 );
+    BOOST_STATIC_ASSERT( BtreeData_V2::KeyMax <= KeyV2::MaxOwned );
 
     NOINLINE_DECL void checkFailed(unsigned line) {
         static time_t last;
@@ -191,6 +194,83 @@ namespace mongo {
         return kc;
     }
 
+    template< class V >
+    long long BtreeBucket<V>::countUsedKeys() const {
+        // a cold subtree is read one bucket at a time below; have the OS read this bucket's
+        // children in parallel instead
+        DiskLoc first = this->childForPos( 0 );
+        if ( !first.isNull() &&
+             !Record::likelyInPhysicalMemory( first.rec()->dataNoThrowing() ) ) {
+            for ( int i = 0; i <= this->n; i++ ) {
+                DiskLoc child = this->childForPos( i );
+                if ( !child.isNull() ) {
+                    MAdvise::willNeed( child.rec(), V::BucketSize );
+                }
+            }
+        }
+
+        long long kc = 0;
+        for ( int i = 0; i < this->n; i++ ) {
+            const _KeyNode& kn = this->k(i);
+            if ( kn.isUsed() ) {
+                kc++;
+            }
+            if ( !kn.prevChildBucket.isNull() ) {
+                DiskLoc left = kn.prevChildBucket;
+                kc += left.btree<V>()->countUsedKeys();
+            }
+        }
+        if ( !this->nextChild.isNull() ) {
+            DiskLoc ll = this->nextChild;
+            kc += ll.btree<V>()->countUsedKeys();
+        }
+        return kc;
+    }
+
+    template< class V >
+    int BtreeBucket<V>::countUsedKeysToEnd(int keyOfs) const {
+        int kc = 0;
+        for ( int i = keyOfs; i < this->n; i++ ) {
+            if ( !this->childForPos( i + 1 ).isNull() ) {
+                return -1;
+            }
+            if ( this->k( i ).isUsed() ) {
+                kc++;
+            }
+        }
+        return kc;
+    }
+
+    template< class V >
+    void BtreeBucket<V>::prefetchNextSiblings(const DiskLoc& thisLoc, int count) const {
+        if ( this->parent.isNull() ) {
+            return;
+        }
+        const BtreeBucket *p = this->parent.template btree<V>();
+        for ( int i = 0; i <= p->n; i++ ) {
+            if ( p->childForPos( i ) != thisLoc ) {
+                continue;
+            }
+            for ( int j = i + 1; j <= p->n && j <= i + count; j++ ) {
+                DiskLoc sibling = p->childForPos( j );
+                if ( !sibling.isNull() &&
+                     !Record::likelyInPhysicalMemory( sibling.rec()->dataNoThrowing() ) ) {
+                    MAdvise::willNeed( sibling.rec(), V::BucketSize );
+                }
+            }
+            return;
+        }
+    }
+
+    template< class V >
+    int BtreeBucket<V>::height() const {
+        int h = 1;
+        for ( DiskLoc down = this->childForPos(0); !down.isNull(); down = down.btree<V>()->childForPos(0) ) {
+            h++;
+        }
+        return h;
+    }
+
     int nDumped = 0;
 
     template< class V >
@@ -325,7 +405,7 @@ namespace mongo {
         KeyNode kn = keyNode(this->n-1);
         recLoc = kn.recordLoc;
         key.assign(kn.key);
-        int keysize = kn.key.dataSize();
+        int keysize = keyStorageSize(kn.key);
 
         massert( 10283 , "rchild not null in btree popBack()", this->nextChild.isNull());
 
@@ -343,10 +423,8 @@ namespace mongo {
     /** add a key.  must be > all existing.  be careful to set next ptr right. */
     template< class V >
     bool BucketBasics<V>::_pushBack(const DiskLoc recordLoc, const Key& key, const Ordering &order, const DiskLoc prevChild) {
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
-        if ( bytesNeeded > this->emptySize )
+        if ( !_roomForPushBack(key, order) )
             return false;
-        verify( bytesNeeded <= this->emptySize );
         if( this->n ) {
             const KeyNode klast = keyNode(this->n-1);
             if(  klast.key.woCompare(key, order) > 0 ) { 
@@ -361,14 +439,32 @@ namespace mongo {
         _KeyNode& kn = k(this->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs( (short) _alloc(key.dataSize()) );
+        int sz = keyStorageSize(key);
+        kn.setKeyDataOfs( (short) _alloc(sz) );
         short ofs = kn.keyDataOfs();
         char *p = dataAt(ofs);
-        memcpy(p, key.data(), key.dataSize());
+        memcpy(p, key.data() + this->keyPrefixLen(), sz);
 
         return true;
     }
 
+    template< class V >
+    bool BucketBasics<V>::_roomForPushBack(const Key& key, const Ordering &order) {
+        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        return bytesNeeded <= this->emptySize;
+    }
+
+    template< class V >
+    bool BucketBasics<V>::_roomFor(const DiskLoc thisLoc, int &keypos, const Key& key, const Ordering &order) const {
+        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        if ( bytesNeeded > this->emptySize ) {
+            _pack(thisLoc, order, keypos);
+            if ( bytesNeeded > this->emptySize )
+                return false;
+        }
+        return true;
+    }
+
     /* durability note
        we do separate intent declarations herein.  arguably one could just declare
        the whole bucket given we do group commits. this is something we could investigate
@@ -381,12 +477,8 @@ namespace mongo {
     bool BucketBasics<V>::basicInsert(const DiskLoc thisLoc, int &keypos, const DiskLoc recordLoc, const Key& key, const Ordering &order) const {
         check( this->n < 1024 );
         check( keypos >= 0 && keypos <= this->n );
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
-        if ( bytesNeeded > this->emptySize ) {
-            _pack(thisLoc, order, keypos);
-            if ( bytesNeeded > this->emptySize )
-                return false;
-        }
+        if ( !_roomFor(thisLoc, keypos, key, order) )
+            return false;
 
         BucketBasics *b;
         {
@@ -405,6 +497,15 @@ namespace mongo {
                 b->k(j) = b->k(j-1);
         }
 
+        {
+            // measured against the keys present before this insert
+            int tail = isTailInsert( keypos ) ? std::min( tailInserts() + 1, (int)MaxTailInserts ) : 0;
+            if ( tail != tailInserts() ) {
+                getDur().declareWriteIntent(&b->flags, sizeof(this->flags));
+                b->flags = ( b->flags & ~TailInserts ) | ( tail << TailInsertsShift );
+            }
+        }
+
         getDur().declareWriteIntent(&b->emptySize, sizeof(this->emptySize)+sizeof(this->topSize)+sizeof(this->n));
         b->emptySize -= sizeof(_KeyNode);
         b->n++;
@@ -413,10 +514,11 @@ namespace mongo {
         _KeyNode& kn = b->k(keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) b->_alloc(key.dataSize()) );
+        int sz = b->keyStorageSize(key);
+        kn.setKeyDataOfs((short) b->_alloc(sz) );
         char *p = b->dataAt(kn.keyDataOfs());
-        getDur().declareWriteIntent(p, key.dataSize());
-        memcpy(p, key.data(), key.dataSize());
+        getDur().declareWriteIntent(p, sz);
+        memcpy(p, key.data() + b->keyPrefixLen(), sz);
         return true;
     }
 
@@ -431,7 +533,7 @@ namespace mongo {
 
     template< class V >
     int BucketBasics<V>::packedDataSize( int refPos ) const {
-        if ( this->flags & Packed ) {
+        if ( ( this->flags & Packed ) && this->keyPrefixLen() == 0 ) {
             return V::BucketSize - this->emptySize - headerSize();
         }
         int size = 0;
@@ -549,9 +651,14 @@ namespace mongo {
         // when splitting a btree node, if the new key is greater than all the other keys, we should not do an even split, but a 90/10 split.
         // see SERVER-983
         // TODO I think we only want to do the 90% split on the rhs node of the tree.
-        int rightSizeLimit = ( this->topSize + sizeof( _KeyNode ) * this->n ) / ( keypos == this->n ? 10 : 2 );
+        // keys that increase only roughly, like ObjectIds from several clients, land just
+        // short of the end instead; the bucket's recent inserts tell those apart from random
+        // keys, which an uneven split would leave a full left bucket for.
+        bool increasing = keypos == this->n ||
+            ( isTailInsert( keypos ) && tailInserts() == MaxTailInserts );
+        int rightSizeLimit = ( this->topSize + sizeof( _KeyNode ) * this->n ) / ( increasing ? 10 : 2 );
         for( int i = this->n - 1; i > -1; --i ) {
-            rightSize += keyNode( i ).key.dataSize() + sizeof( _KeyNode );
+            rightSize += keyStorageSize( keyNode( i ).key ) + sizeof( _KeyNode );
             if ( rightSize > rightSizeLimit ) {
                 split = i;
                 break;
@@ -583,10 +690,12 @@ namespace mongo {
         _KeyNode &kn = k( i );
         kn.recordLoc = recordLoc;
         kn.prevChildBucket = prevChildBucket;
-        short ofs = (short) _alloc( key.dataSize() );
+        verify( _hasKeyPrefix( key ) );
+        int sz = keyStorageSize( key );
+        short ofs = (short) _alloc( sz );
         kn.setKeyDataOfs( ofs );
         char *p = dataAt( ofs );
-        memcpy( p, key.data(), key.dataSize() );
+        memcpy( p, key.data() + this->keyPrefixLen(), sz );
     }
 
     template< class V >
@@ -599,6 +708,141 @@ namespace mongo {
         _packReadyForMod( order, refpos );
     }
 
+    /* BucketBasics<V2> : prefix compressed buckets ------------------- */
+
+    static int commonPrefixLen( const char *a, int aLen, const char *b, int bLen ) {
+        int len = min( aLen, bLen );
+        int i = 0;
+        while ( i < len && a[i] == b[i] )
+            i++;
+        return i;
+    }
+
+    template<>
+    bool BucketBasics<V2>::_repackPrefix( const Ordering &order, int &refPos, const KeyV2 *key, bool mayDrop ) {
+        assertWritable();
+
+        // first find the prefix and check that everything will fit: we don't touch the bucket
+        // until we know it will.  the existing prefix is common to all our keys (and only
+        // exists if they are all compact format) so the new one only differs from it in length.
+        char prefix[KeyMax];
+        int len = -1;
+        bool allCompact = true;
+        int nKept = 0;
+        int keyBytes = 0;
+        for ( int j = 0; j < this->n; j++ ) {
+            if ( mayDrop && mayDropKey( j, refPos ) )
+                continue;
+            const KeyNode kn = keyNode( j );
+            const int sz = kn.key.dataSize();
+            if ( !kn.key.isCompactFormat() )
+                allCompact = false;
+            if ( len < 0 ) {
+                memcpy( prefix, kn.key.data(), sz );
+                len = sz;
+            }
+            else {
+                len = commonPrefixLen( prefix, len, kn.key.data(), sz );
+            }
+            nKept++;
+            keyBytes += sz;
+        }
+        if ( key ) {
+            const int sz = key->dataSize();
+            if ( !key->isCompactFormat() )
+                allCompact = false;
+            if ( len < 0 ) {
+                memcpy( prefix, key->data(), sz );
+                len = sz;
+            }
+            else {
+                len = commonPrefixLen( prefix, len, key->data(), sz );
+            }
+        }
+        if ( !allCompact || nKept == 0 || len < MinKeyPrefixLen )
+            len = 0;
+
+        const int tdz = totalDataSize();
+        const int dataUsed = len + keyBytes - nKept * len;
+        if ( dataUsed + nKept * (int) sizeof( _KeyNode ) > tdz )
+            return false;
+
+        // now rewrite the key data, keys are still read through the old prefix
+        char temp[V2::BucketSize];
+        int ofs = tdz - len;
+        memcpy( temp + ofs, prefix, len );
+        const int newPrefixOfs = ofs;
+        int i = 0;
+        for ( int j = 0; j < this->n; j++ ) {
+            if ( mayDrop && mayDropKey( j, refPos ) ) {
+                continue; // key is unused and has no children - drop it
+            }
+            if ( i != j ) {
+                if ( refPos == j ) {
+                    refPos = i; // i < j so j will never be refPos again
+                }
+                k( i ) = k( j );
+            }
+            const KeyNode kn = keyNode( i );
+            const int sz = kn.key.dataSize() - len;
+            ofs -= sz;
+            memcpy( temp + ofs, kn.key.data() + len, sz );
+            k( i ).setKeyDataOfsSavingUse( ofs );
+            ++i;
+        }
+        if ( refPos == this->n ) {
+            refPos = i;
+        }
+        dassert( i == nKept && tdz - ofs == dataUsed );
+        this->n = i;
+        memcpy( this->data + ofs, temp + ofs, dataUsed );
+        this->topSize = dataUsed;
+        this->emptySize = tdz - dataUsed - this->n * sizeof( _KeyNode );
+        this->prefixLen = len;
+        this->prefixOfs = len ? newPrefixOfs : 0;
+        setPacked();
+
+        assertValid( order );
+        return true;
+    }
+
+    template<>
+    void BucketBasics<V2>::_packReadyForMod( const Ordering &order, int &refPos ) {
+        assertWritable();
+
+        if ( this->flags & Packed )
+            return;
+
+        // without a new key the prefix can only grow, so the keys always fit
+        bool ok = _repackPrefix( order, refPos, 0, true );
+        verify( ok );
+    }
+
+    template<>
+    bool BucketBasics<V2>::_roomFor( const DiskLoc thisLoc, int &keypos, const KeyV2 &key, const Ordering &order ) const {
+        if ( _hasKeyPrefix( key ) && keyStorageSize( key ) + (int) sizeof( _KeyNode ) <= this->emptySize )
+            return true;
+
+        // either key doesn't share our prefix, or we are full in which case recomputing the
+        // prefix may find us more room than packing alone
+        BucketBasics *b = thisLoc.btreemod<V2>();
+        if ( b->_repackPrefix( order, keypos, &key, true ) &&
+             keyStorageSize( key ) + (int) sizeof( _KeyNode ) <= this->emptySize ) {
+            return true;
+        }
+        b->_packReadyForMod( order, keypos );
+        return false;
+    }
+
+    template<>
+    bool BucketBasics<V2>::_roomForPushBack( const KeyV2 &key, const Ordering &order ) {
+        if ( _hasKeyPrefix( key ) && keyStorageSize( key ) + (int) sizeof( _KeyNode ) <= this->emptySize )
+            return true;
+        int refPos = 0;
+        return _repackPrefix( order, refPos, &key, false ) &&
+            keyStorageSize( key ) + (int) sizeof( _KeyNode ) <= this->emptySize;
+    }
+
     /* - BtreeBucket --------------------------------------------------- */
 
     /** @return largest key in the subtree. */
@@ -634,39 +878,96 @@ namespace mongo {
      *  https://jira.mongodb.org/browse/SERVER-371
      */
     /* static */
-    template< class V >
-    int BtreeBucket<V>::customBSONCmp( const BSONObj &l, const BSONObj &rBegin, int rBeginLen, bool rSup, const vector< const BSONElement * > &rEnd, const vector< bool > &rEndInclusive, const Ordering &o, int direction ) {
+    CustomTarget::CustomTarget( const BSONObj &keyBegin, int keyBeginLen, bool afterKey,
+                                const vector< const BSONElement * > &keyEnd,
+                                const vector< bool > &keyEndInclusive, const Ordering &order,
+                                int direction ) :
+        _keyBegin( keyBegin ), _keyBeginLen( keyBeginLen ), _afterKey( afterKey ),
+        _keyEnd( keyEnd ), _keyEndInclusive( keyEndInclusive ), _order( order ),
+        _direction( direction ), _firstExclusive( keyEnd.size() ) {
+        for( int i = keyBeginLen; i < (int)keyEndInclusive.size(); ++i ) {
+            if ( !keyEndInclusive[ i ] ) {
+                _firstExclusive = i;
+                break;
+            }
+        }
+    }
+
+    int CustomTarget::compare( const KeyV1 &l ) const {
+        const KeyV1* target = compact();
+        if ( !target || !l.isCompactFormat() ) {
+            return compareBson( l.toBson() );
+        }
+
+        int field;
+        int x = l.compactCompare( *target, _order, &field );
+        if ( x != 0 && field < _keyBeginLen ) {
+            return x;
+        }
+        if ( _afterKey ) {
+            return -_direction;
+        }
+        if ( _firstExclusive < field ) {
+            // equal up to a field whose end bound is exclusive
+            return -_direction;
+        }
+        return x;
+    }
+
+    const KeyV1* CustomTarget::compact() const {
+        if ( !_compact ) {
+            BSONObjBuilder b;
+            BSONObjIterator i( _keyBegin );
+            for( int f = 0; f < _keyBeginLen; ++f ) {
+                b.appendAs( i.next(), "" );
+            }
+            for( int f = _keyBeginLen; f < (int)_keyEnd.size(); ++f ) {
+                // past keyBegin the fields don't matter for afterKey, and keyEnd may not
+                // have been set there, so any compact value will do
+                if ( _afterKey ) {
+                    b.appendMinKey( "" );
+                }
+                else {
+                    b.appendAs( *_keyEnd[ f ], "" );
+                }
+            }
+            _compact.reset( new KeyV1Owned( b.obj() ) );
+        }
+        return _compact->isCompactFormat() ? _compact.get() : NULL;
+    }
+
+    int CustomTarget::compareBson( const BSONObj &l ) const {
         BSONObjIterator ll( l );
-        BSONObjIterator rr( rBegin );
-        vector< const BSONElement * >::const_iterator rr2 = rEnd.begin();
-        vector< bool >::const_iterator inc = rEndInclusive.begin();
+        BSONObjIterator rr( _keyBegin );
+        vector< const BSONElement * >::const_iterator rr2 = _keyEnd.begin();
+        vector< bool >::const_iterator inc = _keyEndInclusive.begin();
         unsigned mask = 1;
-        for( int i = 0; i < rBeginLen; ++i, mask <<= 1 ) {
+        for( int i = 0; i < _keyBeginLen; ++i, mask <<= 1 ) {
             BSONElement lll = ll.next();
             BSONElement rrr = rr.next();
             ++rr2;
             ++inc;
 
             int x = lll.woCompare( rrr, false );
-            if ( o.descending( mask ) )
+            if ( _order.descending( mask ) )
                 x = -x;
             if ( x != 0 )
                 return x;
         }
-        if ( rSup ) {
-            return -direction;
+        if ( _afterKey ) {
+            return -_direction;
         }
         for( ; ll.more(); mask <<= 1 ) {
             BSONElement lll = ll.next();
             BSONElement rrr = **rr2;
             ++rr2;
             int x = lll.woCompare( rrr, false );
-            if ( o.descending( mask ) )
+            if ( _order.descending( mask ) )
                 x = -x;
             if ( x != 0 )
                 return x;
             if ( !*inc ) {
-                return -direction;
+                return -_direction;
             }
             ++inc;
         }
@@ -1099,6 +1400,32 @@ namespace mongo {
         return true;
     }
 
+    /**
+     * Moving keys between prefix compressed buckets can grow them when the buckets' prefixes
+     * differ, so the byte accounting that balancing relies on doesn't hold.  V2 buckets are
+     * merged (canMergeChildren() goes by uncompressed sizes) or, if an empty child can't be,
+     * refilled by rotating a single key into it; otherwise underfull buckets are left be.
+     */
+    template<>
+    bool BtreeBucket<V2>::tryBalanceChildren( const DiskLoc thisLoc, int leftIndex, IndexDetails &id, const Ordering &order ) const {
+        if ( canMergeChildren( thisLoc, leftIndex ) ) {
+            return false;
+        }
+        if ( this->childForPos( leftIndex ).btree<V2>()->n != 0 &&
+             this->childForPos( leftIndex + 1 ).btree<V2>()->n != 0 ) {
+            return true;
+        }
+        thisLoc.btreemod<V2>()->doBalanceChildren( thisLoc, leftIndex, id, order );
+        return true;
+    }
+
+    /** the single key rotation described at tryBalanceChildren() */
+    template<>
+    int BtreeBucket<V2>::rebalancedSeparatorPos( const DiskLoc &thisLoc, int leftIndex ) const {
+        const BtreeBucket *l = this->childForPos( leftIndex ).btree<V2>();
+        return l->n == 0 ? 1 : l->n - 1;
+    }
+
     template< class V >
     void BtreeBucket<V>::doBalanceLeftToRight( const DiskLoc thisLoc, int leftIndex, int split,
                                             BtreeBucket *l, const DiskLoc lchild,
@@ -1375,6 +1702,8 @@ namespace mongo {
             r->pushBack(kn.recordLoc, kn.key, order, kn.prevChildBucket);
         }
         r->nextChild = this->nextChild;
+        // inserts that went to our tail go on in the new right bucket
+        r->flags |= ( this->flags & BucketBasics<V>::TailInserts );
         r->assertValid( order );
 
         if ( split_debug )
@@ -1505,6 +1834,34 @@ namespace mongo {
         return DiskLoc();
     }
 
+    template< class V >
+    DiskLoc BtreeBucket<V>::advancePastRightChild(const DiskLoc& thisLoc, int& keyOfs) const {
+        verify( keyOfs >= 0 && keyOfs < this->n );
+        int ko = keyOfs + 1;
+        if ( ko < this->n ) {
+            keyOfs = ko;
+            return thisLoc;
+        }
+
+        // end of bucket.  traverse back up as advance() does.
+        DiskLoc childLoc = thisLoc;
+        DiskLoc ancestor = this->parent;
+        while ( !ancestor.isNull() ) {
+            const BtreeBucket *an = BTREE(ancestor);
+            for ( int i = 0; i < an->n; i++ ) {
+                if ( an->childForPos(i) == childLoc ) {
+                    keyOfs = i;
+                    return ancestor;
+                }
+            }
+            verify( an->nextChild == childLoc );
+            childLoc = ancestor;
+            ancestor = an->parent;
+        }
+
+        return DiskLoc();
+    }
+
     template< class V >
     DiskLoc BtreeBucket<V>::locate(const IndexDetails& idx, const DiskLoc& thisLoc, const BSONObj& key, const Ordering &order, int& pos, bool& found, const DiskLoc &recordLoc, int direction) const {
         KeyOwned k(key);
@@ -1536,13 +1893,15 @@ namespace mongo {
     }
 
     template< class V >
-    bool BtreeBucket<V>::customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) {
+    bool BtreeBucket<V>::customFind( int l, int h, const CustomTarget &target, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) {
+        const int direction = target.direction();
         const BtreeBucket<V> * bucket = BTREE(thisLoc);
         while( 1 ) {
             if ( l + 1 == h ) {
                 keyOfs = ( direction > 0 ) ? h : l;
                 DiskLoc next = bucket->k( h ).prevChildBucket;
                 if ( !next.isNull() ) {
+                    prefetchNeighbour( bucket, ( direction > 0 ) ? h + 1 : l, next );
                     bestParent = make_pair( thisLoc, keyOfs );
                     thisLoc = next;
                     return true;
@@ -1552,7 +1911,7 @@ namespace mongo {
                 }
             }
             int m = l + ( h - l ) / 2;
-            int cmp = customBSONCmp( bucket->keyNode( m ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int cmp = target.compare( bucket->keyNode( m ).key );
             if ( cmp < 0 ) {
                 l = m;
             }
@@ -1570,6 +1929,20 @@ namespace mongo {
         }
     }
 
+    template< class V >
+    void BtreeBucket<V>::prefetchNeighbour( const BtreeBucket<V> *parent, int neighbourPos, const DiskLoc &child ) {
+        if ( neighbourPos < 0 || neighbourPos > parent->n ) {
+            return;
+        }
+        if ( Record::likelyInPhysicalMemory( child.rec()->dataNoThrowing() ) ) {
+            return;
+        }
+        DiskLoc neighbour = parent->childForPos( neighbourPos );
+        if ( !neighbour.isNull() ) {
+            MAdvise::willNeed( neighbour.rec(), V::BucketSize );
+        }
+    }
+
     /**
      * find smallest/biggest value greater-equal/less-equal than specified
      * starting thisLoc + keyOfs will be strictly less than/strictly greater than keyBegin/keyBeginLen/keyEnd
@@ -1577,22 +1950,23 @@ namespace mongo {
      */
     template< class V >
     void BtreeBucket<V>::advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) const {
+        const CustomTarget target( keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
         int l,h;
         bool dontGoUp;
         if ( direction > 0 ) {
             l = keyOfs;
             h = this->n - 1;
-            dontGoUp = ( customBSONCmp( keyNode( h ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 );
+            dontGoUp = ( target.compare( keyNode( h ).key ) >= 0 );
         }
         else {
             l = 0;
             h = keyOfs;
-            dontGoUp = ( customBSONCmp( keyNode( l ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 );
+            dontGoUp = ( target.compare( keyNode( l ).key ) <= 0 );
         }
         pair< DiskLoc, int > bestParent;
         if ( dontGoUp ) {
             // this comparison result assures h > l
-            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, thisLoc, keyOfs, bestParent ) ) {
+            if ( !customFind( l, h, target, thisLoc, keyOfs, bestParent ) ) {
                 return;
             }
         }
@@ -1601,18 +1975,18 @@ namespace mongo {
             while( !BTREE(thisLoc)->parent.isNull() ) {
                 thisLoc = BTREE(thisLoc)->parent;
                 if ( direction > 0 ) {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( BTREE(thisLoc)->n - 1 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) >= 0 ) {
+                    if ( target.compare( BTREE(thisLoc)->keyNode( BTREE(thisLoc)->n - 1 ).key ) >= 0 ) {
                         break;
                     }
                 }
                 else {
-                    if ( customBSONCmp( BTREE(thisLoc)->keyNode( 0 ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction ) <= 0 ) {
+                    if ( target.compare( BTREE(thisLoc)->keyNode( 0 ).key ) <= 0 ) {
                         break;
                     }
                 }
             }
         }
-        customLocate( thisLoc, keyOfs, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, bestParent );
+        customLocate( thisLoc, keyOfs, target, bestParent );
     }
 
     /** @param thisLoc in/out param. perhaps thisLoc isn't the best name given that.
@@ -1630,6 +2004,13 @@ namespace mongo {
     void BtreeBucket<V>::customLocate(DiskLoc &locInOut, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, 
                                       const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, 
                                       const Ordering &order, int direction, pair< DiskLoc, int > &bestParent ) {
+        const CustomTarget target( keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+        customLocate( locInOut, keyOfs, target, bestParent );
+    }
+
+    template< class V >
+    void BtreeBucket<V>::customLocate(DiskLoc &locInOut, int &keyOfs, const CustomTarget &target, pair< DiskLoc, int > &bestParent ) {
+        const int direction = target.direction();
         dassert( direction == 1 || direction == -1 );
         const BtreeBucket<V> *bucket = BTREE(locInOut);
         if ( bucket->n == 0 ) {
@@ -1645,7 +2026,7 @@ namespace mongo {
             int z = (1-direction)/2*h;
 
             // leftmost/rightmost key may possibly be >=/<= search key
-            int res = customBSONCmp( bucket->keyNode( z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            int res = target.compare( bucket->keyNode( z ).key );
             bool firstCheck = direction*res >= 0;
 
             if ( firstCheck ) {
@@ -1659,6 +2040,7 @@ namespace mongo {
                     next = bucket->nextChild;
                 }
                 if ( !next.isNull() ) {
+                    prefetchNeighbour( bucket, ( direction > 0 ) ? 1 : bucket->n - 1, next );
                     bestParent = pair< DiskLoc, int >( locInOut, keyOfs );
                     locInOut = next;
                     bucket = BTREE(locInOut);
@@ -1669,7 +2051,7 @@ namespace mongo {
                 }
             }
 
-            res = customBSONCmp( bucket->keyNode( h-z ).key.toBson(), keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction );
+            res = target.compare( bucket->keyNode( h-z ).key );
             bool secondCheck = direction*res < 0;
 
             if ( secondCheck ) {
@@ -1693,7 +2075,7 @@ namespace mongo {
                 }
             }
 
-            if ( !customFind( l, h, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, order, direction, locInOut, keyOfs, bestParent ) ) {
+            if ( !customFind( l, h, target, locInOut, keyOfs, bestParent ) ) {
                 return;
             }
             bucket = BTREE(locInOut);
@@ -1895,8 +2277,10 @@ namespace mongo {
 
     template class BucketBasics<V0>;
     template class BucketBasics<V1>;
+    template class BucketBasics<V2>;
     template class BtreeBucket<V0>;
     template class BtreeBucket<V1>;
+    template class BtreeBucket<V2>;
     template struct __KeyNode<DiskLoc>;
     template struct __KeyNode<DiskLoc56Bit>;
 
@@ -183,6 +183,8 @@ namespace mongo {
         static const int KeyMax = OldBucketSize / 10;
         // A sentinel value sometimes used to identify a deallocated bucket.
         static const int INVALID_N_SENTINEL = -1;
+
+        int keyPrefixLen() const { return 0; }
     };
 
     // a a a ofs ofs ofs ofs
@@ -290,10 +292,69 @@ namespace mongo {
         char data[4];
 
         void _init() { }
+    public:
+        int keyPrefixLen() const { return 0; }
+    };
+
+    /**
+     * Same as BtreeData_V1, except that when every key in the bucket is in compact format and
+     * they share a long enough leading run of bytes, that run is stored once and the key data
+     * of each _KeyNode holds only the remainder of its key.
+     *
+     * |hhhh|kkkkkkk--------ssssssssssssssssssppppp|
+     * s = key suffixes
+     * p = the shared prefix
+     *
+     * The prefix is chosen when the bucket is packed, and is shortened (possibly to nothing)
+     * when a key that doesn't share it is added.
+     */
+    class BtreeData_V2 {
+    public:
+        typedef DiskLoc56Bit Loc;
+        typedef __KeyNode<Loc> _KeyNode;
+        typedef KeyV2 Key;
+        typedef KeyV2Owned KeyOwned;
+        enum { BucketSize = 8192-16 }; // leave room for Record header
+        static const int KeyMax = 1024;
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+        /** shorter common runs aren't worth factoring out */
+        static const int MinKeyPrefixLen = 4;
+    protected:
+        /** Parent bucket of this bucket, which isNull() for the root bucket. */
+        Loc parent;
+        /** Given that there are n keys, this is the n index child. */
+        Loc nextChild;
+
+        unsigned short flags;
+
+        /** basicInsert() assumes the next three members are consecutive and in this order: */
+
+        /** Size of the empty region. */
+        unsigned short emptySize;
+        /** Size used for bson storage, including storage of old keys and the prefix. */
+        unsigned short topSize;
+        /* Number of keys in the bucket. */
+        unsigned short n;
+
+        /** Length of the prefix shared by every key in the bucket, 0 if keys are stored whole. */
+        unsigned short prefixLen;
+        /** Offset within the body of the prefix bytes. */
+        unsigned short prefixOfs;
+
+        /* Beginning of the bucket's body */
+        char data[4];
+
+        void _init() {
+            prefixLen = 0;
+            prefixOfs = 0;
+        }
+    public:
+        int keyPrefixLen() const { return prefixLen; }
     };
 
     typedef BtreeData_V0 V0;
     typedef BtreeData_V1 V1;
+    typedef BtreeData_V2 V2;
 
     /**
      * This class adds functionality to BtreeData for managing a single bucket.
@@ -388,6 +449,15 @@ namespace mongo {
     protected:
         char * dataAt(short ofs) { return this->data + ofs; }
 
+        /** @return the key stored for k, reassembled from the bucket's key prefix if it has one */
+        Key _keyFor(const _KeyNode &k) const { return Key(this->data + k.keyDataOfs()); }
+
+        /** @return true if 'key' begins with the prefix factored out of this bucket's keys */
+        bool _hasKeyPrefix(const Key& key) const { return true; }
+
+        /** @return bytes of key data needed to store 'key', which must have our key prefix */
+        int keyStorageSize(const Key& key) const { return key.dataSize() - this->keyPrefixLen(); }
+
         /** Initialize the header for a new node. */
         void init();
 
@@ -409,6 +479,19 @@ namespace mongo {
          */
         bool basicInsert(const DiskLoc thisLoc, int &keypos, const DiskLoc recordLoc, const Key& key, const Ordering &order) const;
 
+        /**
+         * Makes space for 'key' to be added by basicInsert(), packing if necessary.
+         * @return false if 'key' will not fit, in which case the bucket is packed.
+         */
+        bool _roomFor(const DiskLoc thisLoc, int &keypos, const Key& key, const Ordering &order) const;
+
+        /**
+         * Makes space for 'key' to be added by _pushBack().  Keys are never dropped here,
+         * so indexes of existing keys are stable.
+         * @return false if 'key' will not fit.
+         */
+        bool _roomForPushBack(const Key& key, const Ordering &order);
+
         /**
          * Preconditions:
          *  - key / recordLoc are > all existing keys
@@ -465,7 +548,16 @@ namespace mongo {
            We "repack" when we run out of space before considering the node
            to be full.
            */
-        enum Flags { Packed=1 };
+        enum Flags { Packed=1, TailInserts=6 };
+
+        /**
+         * Bits TailInserts of flags count, up to MaxTailInserts, the inserts in a row that
+         * went into the last sixteenth of the bucket's keys (see isTailInsert()), as inserts of
+         * increasing keys from several writers do.  Older versions leave those bits alone.
+         */
+        enum { TailInsertsShift = 1, MaxTailInserts = 3 };
+        int tailInserts() const { return ( this->flags & TailInserts ) >> TailInsertsShift; }
+        bool isTailInsert( int keypos ) const { return keypos >= this->n - this->n / 16; }
 
         /** n == 0 is ok */
         const Loc& childForPos(int p) const { return p == this->n ? this->nextChild : k(p).prevChildBucket; }
@@ -498,7 +590,21 @@ namespace mongo {
         /** Pack when already writable */
         void _packReadyForMod(const Ordering &order, int &refPos);
 
-        /** @return the size the bucket's body would have if we were to call pack() */
+        /**
+         * V2 only.  Packs the bucket storing the longest prefix (of at least MinKeyPrefixLen
+         * bytes) common to all the remaining keys and 'key', if non null, once.  Unlike
+         * _packReadyForMod this works on a packed bucket too.
+         * @param mayDrop whether unused keys may be dropped, as in _packReadyForMod
+         * @return false, with the bucket unchanged, if the keys would not fit.  that can only
+         *  happen when 'key' doesn't share the current prefix.
+         */
+        bool _repackPrefix(const Ordering &order, int &refPos, const Key *key, bool mayDrop);
+
+        /**
+         * @return the size the bucket's body would have if we were to call pack().  for a
+         * prefix compressed bucket this is the size it would have with its keys stored whole,
+         * which is what they may grow back to when moved to another bucket.
+         */
         int packedDataSize( int refPos ) const;
         void setNotPacked() { this->flags &= ~Packed; }
         void setPacked() { this->flags |= Packed; }
@@ -560,7 +666,8 @@ namespace mongo {
          * Preconditions: 'this' is packed
          * @return the key index to be promoted on split
          * @param keypos The requested index of a key to insert, which may affect
-         *  the choice of split position.
+         *  the choice of split position: most keys stay on the left when it is past the
+         *  last key, or a tail insert after a run of MaxTailInserts of them.
          */
         int splitPos( int keypos ) const;
 
@@ -587,8 +694,69 @@ namespace mongo {
         void setKey( int i, const DiskLoc recordLoc, const Key& key, const DiskLoc prevChildBucket );
     };
 
+    template<>
+    inline KeyV2 BucketBasics<V2>::_keyFor(const _KeyNode &k) const {
+        const char *p = this->data + k.keyDataOfs();
+        if ( this->prefixLen == 0 )
+            return KeyV2(p);
+        return KeyV2(this->data + this->prefixOfs, this->prefixLen, p);
+    }
+
+    template<>
+    inline bool BucketBasics<V2>::_hasKeyPrefix(const KeyV2& key) const {
+        const int len = this->prefixLen;
+        return len == 0 ||
+            ( key.isCompactFormat() && key.dataSize() >= len &&
+              memcmp( key.data(), this->data + this->prefixOfs, len ) == 0 );
+    }
+
+    template<> bool BucketBasics<V2>::_roomFor(const DiskLoc thisLoc, int &keypos, const KeyV2& key, const Ordering &order) const;
+    template<> bool BucketBasics<V2>::_roomForPushBack(const KeyV2& key, const Ordering &order);
+    template<> void BucketBasics<V2>::_packReadyForMod(const Ordering &order, int &refPos);
+
     class IndexDetails;
 
+    /**
+     * The key advanceTo() and customLocate() look for: the first keyBeginLen fields of
+     * keyBegin, then the rest of keyEnd, with afterKey and keyEndInclusive saying which side
+     * of keys equal to it to stop on.
+     *
+     * Compact v:1 bucket keys are compared with it byte by byte, against a copy of it in the
+     * compact format built on first use, rather than by decoding each of them with toBson().
+     */
+    class CustomTarget : boost::noncopyable {
+    public:
+        CustomTarget( const BSONObj &keyBegin, int keyBeginLen, bool afterKey,
+                      const vector< const BSONElement * > &keyEnd,
+                      const vector< bool > &keyEndInclusive, const Ordering &order,
+                      int direction );
+
+        /**
+         * @return < 0 if 'l' comes before the target in the scan direction, > 0 if after, 0
+         *     if it is the target.
+         */
+        int compare( const KeyBson &l ) const { return compareBson( l.toBson() ); }
+        int compare( const KeyV1 &l ) const;
+
+        int direction() const { return _direction; }
+
+    private:
+        /** @return the target as a compact key, or NULL if it can't be one */
+        const KeyV1* compact() const;
+        int compareBson( const BSONObj &l ) const;
+
+        const BSONObj &_keyBegin;
+        const int _keyBeginLen;
+        const bool _afterKey;
+        const vector< const BSONElement * > &_keyEnd;
+        const vector< bool > &_keyEndInclusive;
+        const Ordering &_order;
+        const int _direction;
+        // index of the first field past keyBegin whose keyEnd bound is exclusive
+        int _firstExclusive;
+        mutable scoped_ptr<KeyV1Owned> _compact;
+    };
+
     /**
      * This class adds functionality for manipulating buckets that are assembled
      * in a tree.  The requirements for const and non const functions and
@@ -637,6 +805,34 @@ namespace mongo {
         void dumpTree(const DiskLoc &thisLoc, const BSONObj &order) const;
         long long fullValidate(const DiskLoc& thisLoc, const BSONObj &order, long long *unusedCount = 0, bool strict = false, unsigned depth=0) const; /* traverses everything */
 
+        /**
+         * @return the number of used keys in the subtree rooted at this bucket.  Reads every
+         * bucket of the subtree but none of the key data.
+         */
+        long long countUsedKeys() const;
+
+        /** @return the height of the subtree rooted at this bucket, 1 for a leaf. */
+        int height() const;
+
+        /** @return the child bucket holding the keys that follow key 'keyOfs', maybe null. */
+        DiskLoc rightChild(int keyOfs) const { return this->childForPos(keyOfs + 1); }
+
+        /**
+         * @return the number of used keys from 'keyOfs' to the last key of this bucket, which
+         *     are consecutive in the btree's order if none of them has a right child, or -1
+         *     if one of them does.
+         */
+        int countUsedKeysToEnd(int keyOfs) const;
+
+        /**
+         * Asks the OS to start reading up to 'count' buckets that follow 'thisLoc' among its
+         * parent's children, those that don't look resident, for a scan to find them in
+         * memory when it gets there.
+         */
+        void prefetchNextSiblings(const DiskLoc& thisLoc, int count) const;
+
+        DiskLoc getParent() const { return this->parent; }
+
         bool isUsed( int i ) const { return this->k(i).isUsed(); }
         string bucketSummary() const;
         void dump(unsigned depth=0) const;
@@ -734,6 +930,12 @@ namespace mongo {
          */
         DiskLoc advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller) const;
 
+        /**
+         * Advance forward to the next key that isn't in the subtree rightChild(keyOfs), skipping
+         * that whole subtree rather than descending into it.
+         */
+        DiskLoc advancePastRightChild(const DiskLoc& thisLoc, int& keyOfs) const;
+
         /** Advance in specified direction to the specified key */
         void advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) const;
 
@@ -902,7 +1104,7 @@ namespace mongo {
         Key keyAt(int i) const {
             if( i >= this->n ) 
                 return Key();
-            return Key(this->data + k(i).keyDataOfs());
+            return this->_keyFor(k(i));
         }
     protected:
 
@@ -949,9 +1151,15 @@ namespace mongo {
                     const DiskLoc lChild, const DiskLoc rChild, IndexDetails &idx) const;
 
         bool find(const IndexDetails& idx, const Key& key, const DiskLoc &recordLoc, const Ordering &order, int& pos, bool assertIfDup) const;        
-        static bool customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) ;
+        static bool customFind( int l, int h, const CustomTarget &target, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) ;
+        static void customLocate( DiskLoc &locInOut, int &keyOfs, const CustomTarget &target, pair< DiskLoc, int > &bestParent );
+        /**
+         * Called on descending from 'parent' into 'child'.  If 'child' isn't in memory, asks
+         * the OS to start reading the child at 'neighbourPos' too, as a sorted run of
+         * advanceTo()s (an $in) likely goes on there next.
+         */
+        static void prefetchNeighbour( const BtreeBucket *parent, int neighbourPos, const DiskLoc &child );
         static void findLargestKey(const DiskLoc& thisLoc, DiskLoc& largestLoc, int& largestKey);
-        static int customBSONCmp( const BSONObj &l, const BSONObj &rBegin, int rBeginLen, bool rSup, const vector< const BSONElement * > &rEnd, const vector< bool > &rEndInclusive, const Ordering &o, int direction );
         
         /** If child is non null, set its parent to thisLoc */
         static void fix(const DiskLoc thisLoc, const DiskLoc child);
@@ -994,6 +1202,9 @@ namespace mongo {
     };
 #pragma pack()
 
+    template<> bool BtreeBucket<V2>::tryBalanceChildren( const DiskLoc thisLoc, int leftIndex, IndexDetails &id, const Ordering &order ) const;
+    template<> int BtreeBucket<V2>::rebalancedSeparatorPos( const DiskLoc &thisLoc, int leftIndex ) const;
+
     /**
      * give us a writable version of the btree bucket (declares write intent).
      * note it is likely more efficient to declare write intent on something smaller when you can.
@@ -1008,7 +1219,7 @@ namespace mongo {
     template< class V >
     BucketBasics<V>::KeyNode::KeyNode(const BucketBasics<V>& bb, const _KeyNode &k) :
         prevChildBucket(k.prevChildBucket),
-        recordLoc(k.recordLoc), key(bb.data+k.keyDataOfs())
+        recordLoc(k.recordLoc), key(bb._keyFor(k))
     { }
 
 } // namespace mongo;
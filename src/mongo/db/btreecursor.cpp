@@ -255,6 +255,34 @@ namespace mongo {
         return ok();
     }
 
+    bool BtreeCursor::advancePastPrefix( int prefixLen ) {
+        verify( !_independentFieldRanges );
+        _boundsMustMatch = true;
+
+        killCurrentOp.checkForInterrupt();
+        if (!ok()) {
+            return false;
+        }
+
+        // With afterKey set only the first prefixLen fields of the target matter, but the
+        // target still needs a bound for every field.
+        const BSONObj key = currKey();
+        vector<BSONElement> elements;
+        key.elems( elements );
+        vector<const BSONElement*> keyEnd;
+        for ( size_t i = 0; i < elements.size(); ++i ) {
+            keyEnd.push_back( &elements[ i ] );
+        }
+        const vector<bool> keyEndInclusive( elements.size(), true );
+
+        advanceTo( key, prefixLen, true, keyEnd, keyEndInclusive );
+        checkEnd();
+        if ( ok() ) {
+            ++_nscanned;
+        }
+        return ok();
+    }
+
     void BtreeCursor::noteLocation() {
         if (!eof()) { _indexCursor->savePosition(); }
     }
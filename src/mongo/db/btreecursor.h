@@ -81,6 +81,15 @@ namespace mongo {
 
         virtual bool ok();
         virtual bool advance();
+
+        /**
+         * Skips the rest of the keys whose first 'prefixLen' fields equal the current key's,
+         * moving to the first key past them with one btree descent.  Only for a cursor made
+         * with a start and end key.
+         * @return ok()
+         */
+        bool advancePastPrefix( int prefixLen );
+
         virtual void noteLocation();
         virtual void checkLocation();
         virtual bool supportGetMore() { return true; }
@@ -27,6 +27,7 @@
 #include "mongo/db/index_update.h"
 #include "mongo/db/json.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/hashtab.h"
 #include "mongo/util/mmap.h"
@@ -52,6 +53,12 @@
 
 namespace mongo {
 
+    // When an insert into a capped collection without a max has to delete old documents to
+    // make room, it deletes at least this many bytes of them (but no more than 1/64 of the
+    // extent), so that the inserts after it find room without deleting anything.  0 deletes
+    // just enough for each insert.
+    MONGO_EXPORT_SERVER_PARAMETER(cappedDeleteAheadBytes, int, 64 * 1024);
+
     /* combine adjacent deleted records *for the current extent* of the capped collection
 
        this is O(n^2) but we call it for capped tables where typically n==1 or 2!
@@ -265,9 +272,7 @@ namespace mongo {
                 continue;
             }
 
-            DiskLoc fr = theCapExtent()->firstRecord;
-            theDataFileMgr.deleteRecord(this, ns, fr.rec(), fr, true); // ZZZZZZZZZZZZ
-            compact();
+            cappedDeleteOldest( ns, len );
             if( ++passes > maxPasses ) {
                 StringBuilder sb;
                 sb << "passes >= maxPasses in NamespaceDetails::cappedAlloc: ns: " << ns
@@ -287,6 +292,33 @@ namespace mongo {
         return loc;
     }
 
+    void NamespaceDetails::cappedDeleteOldest( const char *ns, int len ) {
+        // With a max, the collection is kept at exactly that many documents once full, so
+        // each insert deletes one.
+        int wanted = len;
+        if ( maxCappedDocs() == numeric_limits<long long>::max() ) {
+            wanted = std::max( len, std::min( cappedDeleteAheadBytes,
+                                              theCapExtent()->length / 64 ) );
+        }
+
+        // The oldest documents in the extent are the ones from its front up to the first one
+        // allocated on this pass through it.  Compacting once at the end merges the space of
+        // them all, as compacting after each would.
+        int freed = 0;
+        while ( 1 ) {
+            DiskLoc fr = theCapExtent()->firstRecord;
+            freed += fr.rec()->lengthWithHeaders();
+            theDataFileMgr.deleteRecord(this, ns, fr.rec(), fr, true);
+
+            if ( freed >= wanted )
+                break;
+            fr = theCapExtent()->firstRecord;
+            if ( fr.isNull() || fr == _capFirstNewRecord )
+                break;
+        }
+        compact();
+    }
+
     void NamespaceDetails::dumpExtents() {
         cout << "dumpExtents:" << endl;
         for ( DiskLoc i = _firstExtent; !i.isNull(); i = i.ext()->xnext ) {
@@ -0,0 +1,71 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/capped_insert_notifier.h"
+
+#include <boost/thread/condition.hpp>
+
+#include "mongo/platform/unordered_map.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    namespace {
+        // Guards 'versions'.  Held only to bump or compare a counter.
+        mongo::mutex notifierMutex("CappedInsertNotifier");
+        boost::condition notifierCondition;
+
+        // Collections only get an entry once something is inserted into them.
+        typedef unordered_map<std::string, unsigned long long> VersionMap;
+        VersionMap versions;
+
+        unsigned long long getVersion_inlock(const std::string& ns) {
+            VersionMap::const_iterator it = versions.find(ns);
+            return it == versions.end() ? 0 : it->second;
+        }
+    }
+
+    // static
+    void CappedInsertNotifier::notifyOfInsert(const StringData& ns) {
+        mutex::scoped_lock lk(notifierMutex);
+        ++versions[ns.toString()];
+        notifierCondition.notify_all();
+    }
+
+    // static
+    unsigned long long CappedInsertNotifier::getVersion(const StringData& ns) {
+        mutex::scoped_lock lk(notifierMutex);
+        return getVersion_inlock(ns.toString());
+    }
+
+    // static
+    void CappedInsertNotifier::waitForInsert(const StringData& ns, unsigned long long since,
+                                             unsigned maxMillis) {
+        const std::string key = ns.toString();
+        const boost::system_time deadline =
+            boost::get_system_time() + boost::posix_time::milliseconds(maxMillis);
+
+        mutex::scoped_lock lk(notifierMutex);
+        // Inserts into any capped collection wake every waiter; the others go back to sleep.
+        while (getVersion_inlock(key) == since) {
+            if (!notifierCondition.timed_wait(lk.boost(), deadline))
+                return; // timed out
+        }
+    }
+
+}  // namespace mongo
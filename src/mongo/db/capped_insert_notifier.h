@@ -0,0 +1,53 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/base/string_data.h"
+
+namespace mongo {
+
+    /**
+     * Lets awaitData getMores on a capped collection sleep until something is inserted into
+     * it, rather than poll.  Each capped collection has a version that every insert bumps.
+     * A waiter reads the version before looking for data, and waits for it to change if it
+     * finds none, so an insert between the two is not missed.
+     *
+     * The oplog doesn't use this; its tailers wait on OpTime instead.
+     */
+    class CappedInsertNotifier {
+    public:
+        /**
+         * Called after a document is inserted into the capped collection 'ns'.
+         */
+        static void notifyOfInsert(const StringData& ns);
+
+        /**
+         * The current insert version of 'ns'.  0 until the first insert is seen.
+         */
+        static unsigned long long getVersion(const StringData& ns);
+
+        /**
+         * Waits until the version of 'ns' differs from 'since', or for 'maxMillis'.
+         */
+        static void waitForInsert(const StringData& ns, unsigned long long since,
+                                  unsigned maxMillis);
+
+    private:
+        CappedInsertNotifier();
+    };
+
+}  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/authz_session_external_state_d.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/client_registry.h"
 #include "mongo/db/db.h"
 #include "mongo/db/commands.h"
 #include "mongo/db/curop-inl.h"
@@ -151,23 +152,49 @@ namespace mongo {
     }
 
 
+    static string currentThreadId() {
+#ifndef _WIN32
+        stringstream temp;
+        temp << hex << showbase << pthread_self();
+        return temp.str();
+#else
+        return "";
+#endif
+    }
+
+    Client* Client::releaseThread() {
+        verify( currentClient.get() != 0 );
+        return currentClient.release();
+    }
+
+    void Client::adoptThread() {
+        verify( currentClient.get() == 0 );
+        currentClient.reset( this );
+        setThreadName( _desc.c_str() );
+        _threadId = currentThreadId();
+
+        _slot->beginWrite();
+        OpStatus& status = _slot->status();
+        OpStatus::copyString( status.threadId, sizeof( status.threadId ), _threadId );
+        _slot->endWrite();
+    }
+
     Client::Client(const string& desc, AbstractMessagingPort *p) :
         ClientBasic(p),
+        _connectionId( p ? p->connectionId() : 0 ),
+        _threadId( currentThreadId() ),
         _context(0),
         _shutdown(false),
         _desc(desc),
         _god(0),
-        _lastOp(0)
+        _lastOp(0),
+        _slot( ClientRegistry::claim( desc, _threadId, _connectionId ) ),
+        _ls( _slot->lockState() )
     {
         _hasWrittenThisPass = false;
         _pageFaultRetryableSection = 0;
-        _connectionId = p ? p->connectionId() : 0;
         _curOp = new CurOp( this );
-#ifndef _WIN32
-        stringstream temp;
-        temp << hex << showbase << pthread_self();
-        _threadId = temp.str();
-#endif
+        _curOp->_publish();
         scoped_lock bl(clientsMutex);
         clients.insert(this);
     }
@@ -205,6 +232,8 @@ namespace mongo {
                 delete _curOp;
                 // _curOp may have been reset to _curOp->_wrapped
             } while (_curOp != last);
+
+            ClientRegistry::release( _slot );
         }
     }
 
@@ -223,6 +252,7 @@ namespace mongo {
             scoped_lock bl(clientsMutex);
             clients.erase(this);
         }
+        ClientRegistry::unlist( _slot );
 
         return false;
     }
@@ -454,20 +484,21 @@ namespace mongo {
         int num = 0;
         int w = 0;
         int r = 0;
-        {
-            scoped_lock bl(clientsMutex);
-            for ( set<Client*>::iterator i=clients.begin(); i!=clients.end(); ++i ) {
-                Client* c = *i;
-                if ( c->lockState().hasLockPending() ) {
-                    num++;
-                    if ( c->lockState().hasAnyWriteLock() )
-                        w++;
-                    else
-                        r++;
-                }
-                if (num > 100 && !needExact)
-                    break;
+        const size_t numSlots = ClientRegistry::numSlots();
+        for ( size_t i = 0; i < numSlots; i++ ) {
+            ClientSlot* slot = ClientRegistry::slotAt( i );
+            if ( !slot->listed() )
+                continue;
+            const LockState& ls = slot->lockState();
+            if ( ls.hasLockPending() ) {
+                num++;
+                if ( ls.hasAnyWriteLock() )
+                    w++;
+                else
+                    r++;
             }
+            if (num > 100 && !needExact)
+                break;
         }
 
         if ( writers )
@@ -493,15 +524,16 @@ namespace mongo {
         writers = 0;
         readers = 0;
 
-        scoped_lock bl(clientsMutex);
-        for ( set<Client*>::iterator i=clients.begin(); i!=clients.end(); ++i ) {
-            Client* c = *i;
-            if ( ! c->curop()->active() )
+        const size_t numSlots = ClientRegistry::numSlots();
+        for ( size_t i = 0; i < numSlots; i++ ) {
+            ClientSlot* slot = ClientRegistry::slotAt( i );
+            if ( !slot->listed() || !slot->opActive() )
                 continue;
 
-            if ( c->lockState().hasAnyWriteLock() )
+            const LockState& ls = slot->lockState();
+            if ( ls.hasAnyWriteLock() )
                 writers++;
-            if ( c->lockState().hasAnyReadLock() )
+            if ( ls.hasAnyReadLock() )
                 readers++;
         }
 
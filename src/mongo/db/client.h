@@ -44,6 +44,7 @@ namespace mongo {
     class Command;
     class Client;
     class AbstractMessagingPort;
+    class ClientSlot;
     class LockCollectionForReading;
     class PageFaultRetryableSection;
 
@@ -55,6 +56,7 @@ namespace mongo {
     class Client : public ClientBasic {
     public:
         // always be in clientsMutex when manipulating this. killop stuff uses these.
+        // currentOp and the yield heuristics go through the ClientRegistry instead.
         static set<Client*>& clients;
         static mongo::mutex& clientsMutex;
         static int getActiveClientCount( int& writers , int& readers );
@@ -79,6 +81,16 @@ namespace mongo {
          */
         static void resetThread( const StringData& origThreadName );
 
+        /**
+         * Detaches this thread's Client without destroying it, so that another thread can
+         * later adoptThread() it.  Used by the pooled network service, where successive
+         * messages from one connection can be handled by different worker threads.
+         */
+        static Client* releaseThread();
+
+        /** Makes this (released) Client the current thread's Client. */
+        void adoptThread();
+
         /** this has to be called as the client goes away, but before thread termination
          *  @return true if anything was done
          */
@@ -117,6 +129,9 @@ namespace mongo {
 
         LockState& lockState() { return _ls; }
 
+        /** where this client's current op is published for currentOp */
+        ClientSlot* registrySlot() const { return _slot; }
+
     private:
         Client(const std::string& desc, AbstractMessagingPort *p = 0);
         friend class CurOp;
@@ -134,7 +149,8 @@ namespace mongo {
         bool _hasWrittenThisPass;
         PageFaultRetryableSection *_pageFaultRetryableSection;
 
-        LockState _ls;
+        ClientSlot* _slot;
+        LockState& _ls; // lives in _slot
         
         friend class PageFaultRetryableSection; // TEMP
         friend class NoPageFaultsAllowed; // TEMP
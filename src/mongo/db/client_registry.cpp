@@ -0,0 +1,152 @@
+// client_registry.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/client_registry.h"
+
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    const size_t ClientRegistry::BlockSlots;
+    const size_t ClientRegistry::MaxBlocks;
+
+    namespace {
+        // a reader that finds the status changing this many times in a row gives up on it
+        const int kReadAttempts = 16;
+
+        // claim() and release() lock this; readers never do
+        SimpleMutex registryMutex( "ClientRegistry" );
+        std::vector<ClientSlot*>& freeSlots = *new std::vector<ClientSlot*>();
+
+        // written once each, under registryMutex, before numSlotsAllocated covers them
+        ClientSlot* blocks[ClientRegistry::MaxBlocks];
+        AtomicUInt32 numSlotsAllocated;
+    }
+
+    OpStatus::OpStatus()
+        : connectionId( 0 ),
+          opNum( 0 ),
+          active( false ),
+          suppressFromCurop( false ),
+          op( 0 ),
+          startMicros( 0 ),
+          numYields( 0 ),
+          querySize( 0 ),
+          progressActive( false ),
+          progressDone( 0 ),
+          progressTotal( 0 ),
+          memoryBytes( 0 ),
+          memoryPeakBytes( 0 ) {
+        desc[0] = 0;
+        threadId[0] = 0;
+        remote[0] = 0;
+        ns[0] = 0;
+        message[0] = 0;
+        progressName[0] = 0;
+    }
+
+    void OpStatus::copyString( char* to, size_t size, const StringData& from ) {
+        const size_t n = std::min( from.size(), size - 1 );
+        memcpy( to, from.rawData(), n );
+        to[n] = 0;
+    }
+
+    ClientSlot::ClientSlot() { }
+
+    bool ClientSlot::read( OpStatus* out, unsigned* generation ) const {
+        for ( int i = 0; i < kReadAttempts; i++ ) {
+            const unsigned gen = _generation.load();
+            if ( _state.load() != Listed )
+                return false;
+
+            const unsigned before = _seq.load();
+            if ( before & 1 )
+                continue; // being written
+
+            // this may copy a half written status, which the check below throws away
+            *out = _status;
+
+            if ( _seq.load() == before && _generation.load() == gen ) {
+                *generation = gen;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ClientSlot* ClientRegistry::claim( const StringData& desc, const std::string& threadId,
+                                       long long connectionId ) {
+        ClientSlot* slot;
+        {
+            SimpleMutex::scoped_lock lk( registryMutex );
+            if ( freeSlots.empty() ) {
+                const size_t n = numSlotsAllocated.load();
+                massert( 17016, "too many clients", n / BlockSlots < MaxBlocks );
+                ClientSlot* block = new ClientSlot[BlockSlots];
+                blocks[n / BlockSlots] = block;
+                for ( size_t i = BlockSlots; i > 1; i-- ) {
+                    freeSlots.push_back( &block[i - 1] );
+                }
+                slot = &block[0];
+                numSlotsAllocated.store( n + BlockSlots );
+            }
+            else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+        }
+
+        // Free, so no one but us reads the status or the lock state yet
+        slot->_generation.fetchAndAdd( 1 );
+        slot->_killPendingOp.store( 0 );
+        slot->_lockState = LockState();
+        slot->beginWrite();
+        slot->_status = OpStatus();
+        OpStatus& status = slot->_status;
+        OpStatus::copyString( status.desc, sizeof( status.desc ), desc );
+        OpStatus::copyString( status.threadId, sizeof( status.threadId ), threadId );
+        status.connectionId = connectionId;
+        slot->endWrite();
+        slot->_state.store( ClientSlot::Listed );
+        return slot;
+    }
+
+    void ClientRegistry::unlist( ClientSlot* slot ) {
+        slot->_state.store( ClientSlot::Unlisted );
+    }
+
+    void ClientRegistry::release( ClientSlot* slot ) {
+        slot->_state.store( ClientSlot::Free );
+        SimpleMutex::scoped_lock lk( registryMutex );
+        freeSlots.push_back( slot );
+    }
+
+    size_t ClientRegistry::numSlots() {
+        return numSlotsAllocated.load();
+    }
+
+    ClientSlot* ClientRegistry::slotAt( size_t i ) {
+        return &blocks[i / BlockSlots][i % BlockSlots];
+    }
+
+}
@@ -0,0 +1,160 @@
+// client_registry.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/string_data.h"
+#include "mongo/db/lockstat.h"
+#include "mongo/db/lockstate.h"
+#include "mongo/db/storage/namespace.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    /**
+     * What currentOp shows of a client and its current operation.  A copy of what the CurOp
+     * holds, kept up to date by the client's own thread as the operation goes along.
+     */
+    struct OpStatus {
+        enum { QueryBufSize = 512, MessageSize = 256 };
+
+        OpStatus();
+
+        /** copies as much of 'from' as fits in 'to', always terminating it */
+        static void copyString( char* to, size_t size, const StringData& from );
+
+        // the client's
+        char desc[64];
+        char threadId[32];
+        long long connectionId;
+        char remote[64];
+
+        // the operation's
+        unsigned opNum;
+        bool active;
+        bool suppressFromCurop;
+        int op;
+        unsigned long long startMicros; // 0 until started
+        int numYields;
+        char ns[Namespace::MaxNsLen + 2];
+        int querySize; // as in CachedBSONObj: 0 if none, TOO_BIG_SENTINEL if it didn't fit
+        char query[QueryBufSize];
+        char message[MessageSize];
+        bool progressActive;
+        char progressName[32];
+        unsigned long long progressDone;
+        unsigned long long progressTotal;
+        LockStat lockStat;
+        long long memoryBytes;      // as of the op's last interrupt check
+        long long memoryPeakBytes;
+    };
+
+    /**
+     * The part of the client registry a client holds for its life.
+     *
+     * The OpStatus here is written only by the client's thread, between beginWrite() and
+     * endWrite(), which make a sequence counter odd and then even again.  A reader copies it
+     * and keeps the copy only if the counter was even and unchanged across the copy, so it
+     * never waits for the writer, nor the writer for it.
+     */
+    class ClientSlot {
+        MONGO_DISALLOW_COPYING(ClientSlot);
+    public:
+        ClientSlot();
+
+        // owner only
+        void beginWrite() { _seq.fetchAndAdd( 1 ); }
+        void endWrite() { _seq.fetchAndAdd( 1 ); }
+        OpStatus& status() { return _status; }
+
+        /**
+         * Copies the last status completely written into 'out'.
+         * @param generation out: pass to sameHolder() to check that anything else looked at
+         *     here since, the lock state for one, was still the same client's
+         * @return false if the slot isn't held by a client in Client::clients, or the status
+         *     kept changing under us
+         */
+        bool read( OpStatus* out, unsigned* generation ) const;
+
+        bool sameHolder( unsigned generation ) const {
+            return _generation.load() == generation && _state.load() == Listed;
+        }
+
+        /** whether the slot is held by a client in Client::clients, as of now */
+        bool listed() const { return _state.loadRelaxed() == Listed; }
+
+        /**
+         * Whether the current operation is active. Like reading CurOp::active() from another
+         * thread, this may be a moment out of date.
+         */
+        bool opActive() const { return _status.active; }
+
+        /**
+         * The client's lock state.  It lives here rather than in the Client so that looking at
+         * it from another thread is safe even as the client goes away.
+         */
+        LockState& lockState() { return _lockState; }
+
+        /** Set by killOp, which can't write the status as it isn't the owner. */
+        void noteKillPending( unsigned opNum ) { _killPendingOp.store( opNum ); }
+        bool killPending( unsigned opNum ) const { return _killPendingOp.load() == opNum; }
+
+    private:
+        friend class ClientRegistry;
+
+        enum State { Free = 0, Listed = 1, Unlisted = 2 };
+
+        AtomicUInt32 _state;
+        AtomicUInt32 _generation; // bumped each time the slot is claimed
+        AtomicUInt32 _seq;
+        AtomicUInt32 _killPendingOp;
+        OpStatus _status;
+        LockState _lockState;
+    };
+
+    /**
+     * A slot for every client, which currentOp and the like can go through without taking a
+     * lock that connecting, disconnecting and every running operation would otherwise
+     * contend for.  Slots are allocated in blocks that are never freed, so any slot can be
+     * looked at at any time; Client::clients and its mutex remain for what has to reach the
+     * Client or CurOp itself, such as killOp.
+     */
+    class ClientRegistry {
+    public:
+        static const size_t BlockSlots = 256;
+        static const size_t MaxBlocks = 4096;
+
+        /** @return a slot with a fresh status and lock state */
+        static ClientSlot* claim( const StringData& desc, const std::string& threadId,
+                                  long long connectionId );
+
+        /** called as the client leaves Client::clients; the client still owns the slot */
+        static void unlist( ClientSlot* slot );
+
+        /** called as the client is destroyed */
+        static void release( ClientSlot* slot );
+
+        /** slotAt( i ) for any i less than this is safe to look at */
+        static size_t numSlots();
+        static ClientSlot* slotAt( size_t i );
+    };
+
+}
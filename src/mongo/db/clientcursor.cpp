@@ -39,9 +39,11 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/db.h"
+#include "mongo/db/dbmessage.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/lockstate.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/repl/rs.h"
@@ -53,10 +55,43 @@
 
 namespace mongo {
 
-    CCById ClientCursor::clientCursorsById;
+    const unsigned ClientCursor::NumPartitions;
+    ClientCursor::CCPartition* ClientCursor::partitions( new CCPartition[NumPartitions] );
     boost::recursive_mutex& ClientCursor::ccmutex( *(new boost::recursive_mutex()) );
     long long ClientCursor::numberTimedOut = 0;
 
+    namespace {
+        struct PreparedBatch {
+            string ns;
+            QueryResult* qr;
+            long long createdMillis;
+        };
+        typedef map<CursorId, PreparedBatch> PreparedBatchMap;
+
+        // Guards the two below.  Never held while taking any other lock.
+        mongo::mutex preparedBatchMutex( "preparedBatches" );
+        PreparedBatchMap preparedBatches;
+        long long preparedBatchBytesTotal = 0;
+
+        void freePreparedBatch_inlock( PreparedBatchMap::iterator it ) {
+            preparedBatchBytesTotal -= it->second.qr->len;
+            free( it->second.qr );
+            preparedBatches.erase( it );
+        }
+
+        // Prepared replies nobody collects go after the same time as idle cursors.
+        void dropStalePreparedBatches() {
+            const long long cutoff = Listener::getElapsedTimeMillis() - 600000;
+            mutex::scoped_lock lk( preparedBatchMutex );
+            for ( PreparedBatchMap::iterator it = preparedBatches.begin();
+                  it != preparedBatches.end(); ) {
+                PreparedBatchMap::iterator j = it++;
+                if ( j->second.createdMillis < cutoff )
+                    freePreparedBatch_inlock( j );
+            }
+        }
+    }
+
     void aboutToDeleteForSharding( const StringData& ns,
                                    const Database* db,
                                    const NamespaceDetails* nsd,
@@ -64,15 +99,25 @@ namespace mongo {
 
     /*static*/ void ClientCursor::assertNoCursors() {
         recursive_scoped_lock lock(ccmutex);
-        if( clientCursorsById.size() ) {
-            log() << "ERROR clientcursors exist but should not at this point" << endl;
-            ClientCursor *cc = clientCursorsById.begin()->second;
-            log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
-            clientCursorsById.clear();
-            verify(false);
+        for ( unsigned p = 0; p < NumPartitions; p++ ) {
+            CCById& cursors = partitions[p].cursors;
+            if( cursors.size() ) {
+                log() << "ERROR clientcursors exist but should not at this point" << endl;
+                ClientCursor *cc = cursors.begin()->second;
+                log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
+                cursors.clear();
+                verify(false);
+            }
         }
     }
 
+    /*static*/ unsigned ClientCursor::numCursors() {
+        unsigned n = 0;
+        for ( unsigned p = 0; p < NumPartitions; p++ )
+            n += partitions[p].cursors.size();
+        return n;
+    }
+
 
     void ClientCursor::setLastLoc_inlock(DiskLoc L) {
         verify( _pos != -2 ); // defensive - see ~ClientCursor
@@ -168,12 +213,14 @@ namespace mongo {
     void ClientCursor::idleTimeReport(unsigned millis) {
         bool foundSomeToTimeout = false;
 
+        dropStalePreparedBatches();
+
         // two passes so that we don't need to readlock unless we really do some timeouts
         // we assume here that incrementing _idleAgeMillis outside readlock is ok.
         {
             recursive_scoped_lock lock(ccmutex);
             {
-                unsigned sz = clientCursorsById.size();
+                unsigned sz = numCursors();
                 static time_t last;
                 if( sz >= 100000 ) { 
                     if( time(0) - last > 300 ) {
@@ -182,11 +229,12 @@ namespace mongo {
                     }
                 }
             }
-            for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end();  ) {
-                CCById::iterator j = i;
-                i++;
-                if( j->second->shouldTimeout( millis ) ) {
-                    foundSomeToTimeout = true;
+            for ( unsigned p = 0; p < NumPartitions; p++ ) {
+                CCById& cursors = partitions[p].cursors;
+                for ( CCById::iterator i = cursors.begin(); i != cursors.end(); ++i ) {
+                    if( i->second->shouldTimeout( millis ) ) {
+                        foundSomeToTimeout = true;
+                    }
                 }
             }
         }
@@ -295,11 +343,32 @@ namespace mongo {
         }
     }
 
+    ClientCursor::LockedIterator::LockedIterator() : _lock( ccmutex ), _partition( 0 ) {
+        for ( unsigned p = 0; p < NumPartitions; p++ )
+            partitions[p].mutex.lock();
+        _i = partitions[0].cursors.begin();
+        _skipToNonEmpty();
+    }
+
+    ClientCursor::LockedIterator::~LockedIterator() {
+        for ( unsigned p = NumPartitions; p > 0; p-- )
+            partitions[p - 1].mutex.unlock();
+    }
+
+    void ClientCursor::LockedIterator::_skipToNonEmpty() {
+        while ( _i == partitions[_partition].cursors.end() ) {
+            if ( ++_partition == NumPartitions )
+                return;
+            _i = partitions[_partition].cursors.begin();
+        }
+    }
+
     void ClientCursor::LockedIterator::deleteAndAdvance() {
         ClientCursor *cc = current();
         CursorId id = cc->cursorid();
         delete cc;
-        _i = clientCursorsById.upper_bound( id );
+        _i = partitions[_partition].cursors.upper_bound( id );
+        _skipToNonEmpty();
     }
     
     ClientCursor::ClientCursor(int queryOptions, const shared_ptr<Cursor>& c, const string& ns, BSONObj query ) :
@@ -317,7 +386,11 @@ namespace mongo {
             noTimeout();
         recursive_scoped_lock lock(ccmutex);
         _cursorid = allocCursorId_inlock();
-        clientCursorsById.insert( make_pair(_cursorid, this) );
+        {
+            CCPartition& partition = partitionFor(_cursorid);
+            recursive_scoped_lock partitionLock(partition.mutex);
+            partition.cursors.insert( make_pair(_cursorid, this) );
+        }
 
         if ( ! _c->modifiedKeys() ) {
             // store index information so we can decide if we can
@@ -348,7 +421,11 @@ namespace mongo {
         {
             recursive_scoped_lock lock(ccmutex);
             setLastLoc_inlock( DiskLoc() ); // removes us from bylocation multimap
-            clientCursorsById.erase(_cursorid);
+            CCPartition& partition = partitionFor(_cursorid);
+            recursive_scoped_lock partitionLock(partition.mutex);
+            partition.cursors.erase(_cursorid);
+
+            dropPreparedBatch(_cursorid);
 
             // defensive:
             _cursorid = INVALID_CURSOR_ID;
@@ -467,6 +544,11 @@ namespace mongo {
     }
 
     int ClientCursor::suggestYieldMicros() {
+        if ( LockState::numLockPending() == 0 && ! *killCurrentOp.checkForInterruptNoAssert() ) {
+            // nobody to yield to; skip going through every client to find that out
+            return 0;
+        }
+
         int writers = 0;
         int readers = 0;
 
@@ -714,17 +796,20 @@ namespace mongo {
 
     void ClientCursor::appendStats( BSONObjBuilder& result ) {
         recursive_scoped_lock lock(ccmutex);
-        result.appendNumber("totalOpen", clientCursorsById.size() );
+        result.appendNumber("totalOpen", static_cast<long long>(numCursors()) );
         result.appendNumber("clientCursors_size", (int) numCursors());
         result.appendNumber("timedOut" , numberTimedOut);
         unsigned pinned = 0;
         unsigned notimeout = 0;
-        for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end(); i++ ) {
-            unsigned p = i->second->_pinValue;
-            if( p >= 100 )
-                pinned++;
-            else if( p > 0 )
-                notimeout++;
+        for ( unsigned p = 0; p < NumPartitions; p++ ) {
+            CCById& cursors = partitions[p].cursors;
+            for ( CCById::iterator i = cursors.begin(); i != cursors.end(); i++ ) {
+                unsigned pv = i->second->_pinValue;
+                if( pv >= 100 )
+                    pinned++;
+                else if( pv > 0 )
+                    notimeout++;
+            }
         }
         if( pinned ) 
             result.append("pinned", pinned);
@@ -836,12 +921,53 @@ namespace mongo {
         client.shutdown();
     }
 
+    void ClientCursor::addPreparedBatch( CursorId id, const string& ns, QueryResult* qr ) {
+        mutex::scoped_lock lk( preparedBatchMutex );
+        PreparedBatchMap::iterator it = preparedBatches.find( id );
+        if ( it != preparedBatches.end() )
+            freePreparedBatch_inlock( it );
+
+        PreparedBatch& batch = preparedBatches[id];
+        batch.ns = ns;
+        batch.qr = qr;
+        batch.createdMillis = Listener::getElapsedTimeMillis();
+        preparedBatchBytesTotal += qr->len;
+    }
+
+    QueryResult* ClientCursor::takePreparedBatch( CursorId id, const StringData& ns ) {
+        mutex::scoped_lock lk( preparedBatchMutex );
+        PreparedBatchMap::iterator it = preparedBatches.find( id );
+        // a getMore naming the wrong ns fails later on; leave the batch for the real one
+        if ( it == preparedBatches.end() || ns != it->second.ns )
+            return 0;
+
+        QueryResult* qr = it->second.qr;
+        preparedBatchBytesTotal -= qr->len;
+        preparedBatches.erase( it );
+        return qr;
+    }
+
+    void ClientCursor::dropPreparedBatch( CursorId id ) {
+        mutex::scoped_lock lk( preparedBatchMutex );
+        PreparedBatchMap::iterator it = preparedBatches.find( id );
+        if ( it != preparedBatches.end() )
+            freePreparedBatch_inlock( it );
+    }
+
+    long long ClientCursor::preparedBatchBytes() {
+        mutex::scoped_lock lk( preparedBatchMutex );
+        return preparedBatchBytesTotal;
+    }
+
     void ClientCursor::find( const string& ns , set<CursorId>& all ) {
         recursive_scoped_lock lock(ccmutex);
 
-        for ( CCById::iterator i=clientCursorsById.begin(); i!=clientCursorsById.end(); ++i ) {
-            if ( i->second->_ns == ns )
-                all.insert( i->first );
+        for ( unsigned p = 0; p < NumPartitions; p++ ) {
+            CCById& cursors = partitions[p].cursors;
+            for ( CCById::iterator i = cursors.begin(); i != cursors.end(); ++i ) {
+                if ( i->second->_ns == ns )
+                    all.insert( i->first );
+            }
         }
     }
 
@@ -857,6 +983,8 @@ namespace mongo {
 
     bool ClientCursor::erase(CursorId id) {
         recursive_scoped_lock lock(ccmutex);
+        // keeps the cursor from being pinned between the check and the delete
+        recursive_scoped_lock partitionLock(partitionFor(id).mutex);
         ClientCursor* cursor = find_inlock(id);
         if (!cursor) {
             return false;
@@ -897,6 +1025,7 @@ namespace mongo {
         // of 2 invariants: that the cursor ID won't be re-used in a short period of time, and that
         // the namespace associated with a cursor cannot change.
         recursive_scoped_lock lock(ccmutex);
+        recursive_scoped_lock partitionLock(partitionFor(id).mutex);
         ClientCursor* cursor = find_inlock(id);
         if (!cursor) {
             // Cursor was deleted in another thread since we found it earlier in this function.
@@ -47,6 +47,7 @@ namespace mongo {
     class Cursor; /* internal server cursor base class */
     class ClientCursor;
     class ParsedQuery;
+    struct QueryResult;
 
     /* todo: make this map be per connection.  this will prevent cursor hijacking security attacks perhaps.
      *       ERH: 9/2010 this may not work since some drivers send getMore over a different connection
@@ -70,7 +71,7 @@ namespace mongo {
         public:
             Pin( long long cursorid ) :
                 _cursorid( INVALID_CURSOR_ID ) {
-                recursive_scoped_lock lock( ccmutex );
+                recursive_scoped_lock lock( partitionFor( cursorid ).mutex );
                 ClientCursor *cursor = ClientCursor::find_inlock( cursorid, true );
                 if ( cursor ) {
                     uassert( 12051, "clientcursor already in use? driver problem?",
@@ -138,22 +139,27 @@ namespace mongo {
         };
 
         /**
-         * Iterates through all ClientCursors, under its own ccmutex lock.
-         * Also supports deletion on the fly.
+         * Iterates through all ClientCursors, under ccmutex and every partition lock, so no
+         * cursor can be pinned meanwhile.  Also supports deletion on the fly.
          */
         class LockedIterator : boost::noncopyable {
         public:
-            LockedIterator() : _lock( ccmutex ), _i( clientCursorsById.begin() ) {}
-            bool ok() const { return _i != clientCursorsById.end(); }
+            LockedIterator();
+            ~LockedIterator();
+            bool ok() const { return _partition < NumPartitions; }
             ClientCursor *current() const { return _i->second; }
-            void advance() { ++_i; }
+            void advance() { ++_i; _skipToNonEmpty(); }
             /**
              * Delete 'current' and advance. Properly handles cascading deletions that may occur
              * when one ClientCursor is directly deleted.
              */
             void deleteAndAdvance();
         private:
+            // moves on to the next partition while at the end of this one
+            void _skipToNonEmpty();
+
             recursive_scoped_lock _lock;
+            unsigned _partition;
             CCById::const_iterator _i;
         };
         
@@ -294,9 +300,11 @@ namespace mongo {
     private:
         void setLastLoc_inlock(DiskLoc);
 
+        // Needs ccmutex or the partition lock for 'id'.
         static ClientCursor* find_inlock(CursorId id, bool warn = true) {
-            CCById::iterator it = clientCursorsById.find(id);
-            if ( it == clientCursorsById.end() ) {
+            CCById& cursors = partitionFor(id).cursors;
+            CCById::iterator it = cursors.find(id);
+            if ( it == cursors.end() ) {
                 if ( warn ) {
                     OCCASIONALLY out() << "ClientCursor::find(): cursor not found in map '" << id
                                        << "' (ok after a drop)" << endl;
@@ -314,7 +322,7 @@ namespace mongo {
 
     public:
         static ClientCursor* find(CursorId id, bool warn = true) {
-            recursive_scoped_lock lock(ccmutex);
+            recursive_scoped_lock lock(partitionFor(id).mutex);
             ClientCursor *c = find_inlock(id, warn);
             // if this asserts, your code was not thread safe - you either need to set no timeout
             // for the cursor or keep a ClientCursor::Pointer in scope for it.
@@ -370,12 +378,32 @@ namespace mongo {
         static void idleTimeReport(unsigned millis);
 
         static void appendStats( BSONObjBuilder& result );
-        static unsigned numCursors() { return clientCursorsById.size(); }
+        static unsigned numCursors();
         static void aboutToDelete( const StringData& ns,
                                    const NamespaceDetails* nsd,
                                    const DiskLoc& dl );
         static void find( const string& ns , set<CursorId>& all );
 
+        /**
+         * getMore replies built before the client asked for them, see prepareNextGetMore().
+         * Keyed by cursor id.  An entry outlives its cursor when it holds the last batch, and
+         * is dropped with the cursor otherwise.  Entries nobody collects time out like idle
+         * cursors do.  Takes ownership of 'qr'.
+         */
+        static void addPreparedBatch( CursorId id, const string& ns, QueryResult* qr );
+
+        /**
+         * Removes and returns the reply prepared for the next getMore on 'id' in 'ns', or NULL
+         * if there is none.  The caller owns the result.  The cursor has already moved past
+         * its documents, so it is returned whatever batch size the getMore asks for.
+         */
+        static QueryResult* takePreparedBatch( CursorId id, const StringData& ns );
+
+        static void dropPreparedBatch( CursorId id );
+
+        /** Bytes held in prepared replies. */
+        static long long preparedBatchBytes();
+
 
     private: // methods
 
@@ -422,9 +450,28 @@ namespace mongo {
 
     private: // static members
 
-        static CCById clientCursorsById;
+        /**
+         * The cursors whose ids fall in one slice of the id space.  Looking a cursor up by id,
+         * as Pin and find() do on every getMore, takes just the lock of its partition.
+         * Adding or removing a cursor takes ccmutex and then the partition lock, so holding
+         * either is enough to read a partition's map.
+         */
+        struct CCPartition {
+            boost::recursive_mutex mutex;
+            CCById cursors;
+        };
+
+        static const unsigned NumPartitions = 16;
+
+        static CCPartition& partitionFor(CursorId id) {
+            return partitions[ static_cast<unsigned long long>(id) % NumPartitions ];
+        }
+
+        static CCPartition* partitions;
         static long long numberTimedOut;
-        static boost::recursive_mutex& ccmutex;   // must use this for all statics above!
+        // must use this for all statics above, and for the by location maps.  when taking
+        // partition locks as well, take this first.
+        static boost::recursive_mutex& ccmutex;
         static CursorId allocCursorId_inlock();
 
     };
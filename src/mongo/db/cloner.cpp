@@ -58,8 +58,11 @@ namespace mongo {
          { "name" : "name_1" , "ns" : "foo.index3" , "key" :  { "name" : 1.0 } }
        we need to fix up the value in the "ns" parameter so that the name prefix is correct on a
        copy to a new name.
+
+       if foreground is true the "background" flag is dropped too, so the index is built
+       bottom up from the copied data rather than one document at a time.
     */
-    BSONObj fixindex(BSONObj o) {
+    BSONObj fixindex(BSONObj o, bool foreground) {
         BSONObjBuilder b;
         BSONObjIterator i(o);
         while ( i.moreWithEOO() ) {
@@ -72,6 +75,10 @@ namespace mongo {
                 continue;
             }
 
+            if ( foreground && string("background") == e.fieldName() ) {
+                continue;
+            }
+
             if ( string("ns") == e.fieldName() ) {
                 uassert( 10024 , "bad ns field for index during dbcopy", e.type() == String);
                 const char *p = strchr(e.valuestr(), '.');
@@ -141,7 +148,7 @@ namespace mongo {
                 BSONObj js = tmp;
                 if ( isindex ) {
                     verify(nsToCollectionSubstring(from_collection) == "system.indexes");
-                    js = fixindex(tmp);
+                    js = fixindex(tmp, foregroundIndexes);
                     storedForLater->push_back( js.getOwned() );
                     continue;
                 }
@@ -175,6 +182,7 @@ namespace mongo {
         Client::Context *context;
         bool _mayYield;
         bool _mayBeInterrupted;
+        bool foregroundIndexes;
     };
 
     /* copy the specified collection
@@ -182,7 +190,7 @@ namespace mongo {
     */
     void Cloner::copy(const char *from_collection, const char *to_collection, bool isindex,
                       bool logForRepl, bool masterSameProcess, bool slaveOk, bool mayYield,
-                      bool mayBeInterrupted, Query query) {
+                      bool mayBeInterrupted, Query query, bool foregroundIndexes) {
 
         list<BSONObj> storedForLater;
         LOG(2) << "\t\tcloning collection " << from_collection << " to " << to_collection << " on " << _conn->getServerAddress() << " with filter " << query.toString() << endl;
@@ -197,6 +205,7 @@ namespace mongo {
         f.logForRepl = logForRepl;
         f._mayYield = mayYield;
         f._mayBeInterrupted = mayBeInterrupted;
+        f.foregroundIndexes = foregroundIndexes;
 
         int options = QueryOption_NoCursorTimeout | ( slaveOk ? QueryOption_SlaveOk : 0 );
         {
@@ -488,7 +497,8 @@ namespace mongo {
             BSONObj query = BSON( "name" << NE << "_id_" << "ns" << NIN << arr );
             
             // won't need a snapshot of the query of system.indexes as there can never be very many.
-            copy(system_indexes_from.c_str(), system_indexes_to.c_str(), true, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, query );
+            copy(system_indexes_from.c_str(), system_indexes_to.c_str(), true, opts.logForRepl, masterSameProcess, opts.slaveOk, opts.mayYield, opts.mayBeInterrupted, query,
+                 opts.foregroundIndexes );
         }
         return true;
     }
@@ -90,7 +90,7 @@ namespace mongo {
     private:
         void copy(const char *from_ns, const char *to_ns, bool isindex, bool logForRepl,
                   bool masterSameProcess, bool slaveOk, bool mayYield, bool mayBeInterrupted,
-                  Query q);
+                  Query q, bool foregroundIndexes = false);
 
         struct Fun;
         auto_ptr<DBClientBase> _conn;
@@ -108,6 +108,7 @@ namespace mongo {
 
             syncData = true;
             syncIndexes = true;
+            foregroundIndexes = false;
         }
             
         string fromDB;
@@ -122,6 +123,10 @@ namespace mongo {
 
         bool syncData;
         bool syncIndexes;
+
+        // build every copied index in the foreground, even those the source built in the
+        // background.  only for targets nobody reads from until the clone is done.
+        bool foregroundIndexes;
     };
 
 } // namespace mongo
@@ -89,6 +89,8 @@ namespace {
         ("maxConns",po::value<int>(), maxConnInfoBuilder.str().c_str())
         ("logpath", po::value<string>() , "log file to send write to instead of stdout - has to be a file, not directory" )
         ("logappend" , "append to logpath instead of over-writing" )
+        ("logAsync", po::value<std::string>(), "write the logpath log from a background thread; "
+         "when its buffer is full, block or drop new log lines (block|drop)")
         ("pidfilepath", po::value<string>(), "full path to pidfile (if not set, no pidfile is created)")
         ("keyFile", po::value<string>(), "private key for cluster authentication")
         ("setParameter", po::value< std::vector<std::string> >()->composing(),
@@ -375,6 +377,19 @@ namespace {
 
         cmdLine.logWithSyslog = params.count("syslog");
         cmdLine.logAppend = params.count("logappend");
+        if (params.count("logAsync")) {
+            const std::string policy = params["logAsync"].as<std::string>();
+            if (policy != "block" && policy != "drop") {
+                cout << "logAsync must be block or drop" << endl;
+                return false;
+            }
+            if (cmdLine.logpath.empty()) {
+                cout << "logAsync can only be used with logpath" << endl;
+                return false;
+            }
+            cmdLine.logAsync = true;
+            cmdLine.logAsyncDropWhenFull = (policy == "drop");
+        }
         if (!cmdLine.logpath.empty() && cmdLine.logWithSyslog) {
             cout << "Cant use both a logpath and syslog " << endl;
             return false;
@@ -110,6 +110,7 @@ namespace mongo {
         int defaultProfile;    // --profile
         int slowMS;            // --time in ms that is "slow"
         int defaultLocalThresholdMillis;    // --localThreshold in ms to consider a node local
+        bool latencyAwareReads;  // --latencyAwareReads pick among local nodes by latency and load
         int pretouch;          // --pretouch for replication application (experimental)
         bool moveParanoia;     // for move chunk paranoia
         double syncdelay;      // seconds between fsyncs
@@ -125,6 +126,8 @@ namespace mongo {
 
         std::string logpath;   // Path to log file, if logging to a file; otherwise, empty.
         bool logAppend;        // True if logging to a file in append mode.
+        bool logAsync;         // True if the log file is written from a background thread.
+        bool logAsyncDropWhenFull; // If logAsync, drop lines rather than wait when it's behind.
         bool logWithSyslog;    // True if logging to syslog; must not be set if logpath is set.
         std::string clusterAuthMode; // Cluster authentication mode
 
@@ -196,9 +199,11 @@ namespace mongo {
         noTableScan(false), prealloc(true), preallocj(true), smallfiles(sizeof(int*) == 4),
         configsvr(false), quota(false), quotaFiles(8), cpu(false),
         durOptions(0), objcheck(true), oplogSize(0), defaultProfile(0),
-        slowMS(100), defaultLocalThresholdMillis(15), pretouch(0), moveParanoia( false ),
+        slowMS(100), defaultLocalThresholdMillis(15), latencyAwareReads(false), pretouch(0),
+        moveParanoia( false ),
         syncdelay(60), noUnixSocket(false), doFork(0), socket("/tmp"), maxConns(DEFAULT_MAX_CONN),
-        logAppend(false), logWithSyslog(false), isHttpInterfaceEnabled(false)
+        logAppend(false), logAsync(false), logAsyncDropWhenFull(false), logWithSyslog(false),
+        isHttpInterfaceEnabled(false)
     {
         started = time(0);
 
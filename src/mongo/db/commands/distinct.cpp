@@ -22,8 +22,10 @@
 #include "mongo/db/auth/action_set.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/privilege.h"
+#include "mongo/db/btreecursor.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/kill_current_op.h"
@@ -77,6 +79,51 @@ namespace mongo {
                 return true;
             }
 
+            // With no query, an index led by the key holds each value as one run of keys, and
+            // one key of each run is all distinct needs.
+            const int skipScanIdxNo = query.isEmpty() ? skipScanIndexNo( d, key ) : -1;
+            if ( skipScanIdxNo >= 0 ) {
+                IndexDetails& idx = d->idx( skipScanIdxNo );
+                BSONObjBuilder startKey;
+                BSONObjBuilder endKey;
+                BSONForEach( field, idx.keyPattern() ) {
+                    if ( field.number() < 0 ) {
+                        startKey.appendMaxKey( "" );
+                        endKey.appendMinKey( "" );
+                    }
+                    else {
+                        startKey.appendMinKey( "" );
+                        endKey.appendMaxKey( "" );
+                    }
+                }
+
+                BtreeCursor* btree = BtreeCursor::make( d, idx, startKey.obj(), endKey.obj(),
+                                                        true, 1 );
+                shared_ptr<Cursor> cursor( btree );
+                string cursorName = cursor->toString();
+                auto_ptr<ClientCursor> cc (new ClientCursor(QueryOption_NoCursorTimeout, cursor,
+                                                            ns));
+
+                while ( cursor->ok() ) {
+                    nscanned++;
+                    n++;
+                    addValue( btree->currKey().firstElement(), &values, &arr, bb, bufSize );
+
+                    btree->advancePastPrefix( 1 );
+
+                    if (!cc->yieldSometimes( ClientCursor::MaybeCovered )) {
+                        cc.release();
+                        break;
+                    }
+                }
+
+                verify( start == bb.buf() );
+
+                result.appendArray( "values" , arr.done() );
+                appendStats( result, n, nscanned, nscannedObjects, t, cursorName );
+                return true;
+            }
+
             shared_ptr<Cursor> cursor;
             if ( ! query.isEmpty() ) {
                 cursor = getOptimizedCursor( ns.c_str(), query, BSONObj() );
@@ -122,18 +169,7 @@ namespace mongo {
                     loadedRecord = ! cc->getFieldsDotted( key , temp, holder );
 
                     for ( BSONElementSet::iterator i=temp.begin(); i!=temp.end(); ++i ) {
-                        BSONElement e = *i;
-                        if ( values.count( e ) )
-                            continue;
-
-                        int now = bb.len();
-
-                        uassert(10044,  "distinct too big, 16mb cap", ( now + e.size() + 1024 ) < bufSize );
-
-                        arr.append( e );
-                        BSONElement x( start + now );
-
-                        values.insert( x );
+                        addValue( *i, &values, &arr, bb, bufSize );
                     }
                 }
 
@@ -153,18 +189,61 @@ namespace mongo {
             verify( start == bb.buf() );
 
             result.appendArray( "values" , arr.done() );
+            appendStats( result, n, nscanned, nscannedObjects, t, cursorName );
 
-            {
-                BSONObjBuilder b;
-                b.appendNumber( "n" , n );
-                b.appendNumber( "nscanned" , nscanned );
-                b.appendNumber( "nscannedObjects" , nscannedObjects );
-                b.appendNumber( "timems" , t.millis() );
-                b.append( "cursor" , cursorName );
-                result.append( "stats" , b.obj() );
+            return true;
+        }
+
+    private:
+        /**
+         * @return the number of an index to skip-scan for 'key', or -1 if there is none.  It has
+         *     to be a plain btree index led by 'key', holding every document and just one key
+         *     for each: not sparse, partial or multikey.
+         */
+        static int skipScanIndexNo( NamespaceDetails* d, const string& key ) {
+            NamespaceDetails::IndexIterator ii = d->ii();
+            while ( ii.more() ) {
+                IndexDetails& idx = ii.next();
+                const int idxNo = ii.pos() - 1;
+                const BSONObj info = idx.info.obj();
+
+                if ( d->isMultikey( idxNo ) || info["sparse"].trueValue() ||
+                     info.hasField( "partialFilterExpression" ) ||
+                     !IndexNames::findPluginName( idx.keyPattern() ).empty() )
+                    continue;
+
+                if ( key == idx.keyPattern().firstElementFieldName() )
+                    return idxNo;
             }
+            return -1;
+        }
 
-            return true;
+        /** Appends 'e' to 'arr', which writes to 'bb', unless 'values' already has it. */
+        static void addValue( const BSONElement& e, BSONElementSet* values,
+                              BSONArrayBuilder* arr, BufBuilder& bb, int bufSize ) {
+            if ( values->count( e ) )
+                return;
+
+            int now = bb.len();
+
+            uassert(10044,  "distinct too big, 16mb cap", ( now + e.size() + 1024 ) < bufSize );
+
+            arr->append( e );
+            BSONElement x( bb.buf() + now );
+
+            values->insert( x );
+        }
+
+        static void appendStats( BSONObjBuilder& result, long long n, long long nscanned,
+                                 long long nscannedObjects, const Timer& t,
+                                 const string& cursorName ) {
+            BSONObjBuilder b;
+            b.appendNumber( "n" , n );
+            b.appendNumber( "nscanned" , nscanned );
+            b.appendNumber( "nscannedObjects" , nscannedObjects );
+            b.appendNumber( "timems" , t.millis() );
+            b.append( "cursor" , cursorName );
+            result.append( "stats" , b.obj() );
         }
 
     } distinctCmd;
@@ -22,15 +22,76 @@
 
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/matcher/match_details.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/update.h"
+#include "mongo/db/query_optimizer.h"
 #include "mongo/db/queryutil.h"
 
 namespace mongo {
 
+    namespace {
+
+        // Past this many, the queue cursors are forgotten and left to time out.
+        const size_t kMaxQueueCursors = 10000;
+
+        /**
+         * The cursors of findAndModify's queue mode, by namespace and query.  Each is left just
+         * past the last document handed out for its query.
+         */
+        class QueueCursors {
+        public:
+            QueueCursors() : _mutex( "QueueCursors" ) { }
+
+            /** Returns 0 if there is no cursor for 'query' on 'ns'. */
+            CursorId get( const string& ns, const BSONObj& query ) {
+                scoped_lock lk( _mutex );
+                map<string, CursorId>::const_iterator it = _cursors.find( key( ns, query ) );
+                return it == _cursors.end() ? 0 : it->second;
+            }
+
+            /** Forgets the cursor for 'query' on 'ns' if 'id' is 0. */
+            void set( const string& ns, const BSONObj& query, CursorId id ) {
+                scoped_lock lk( _mutex );
+                if ( !id ) {
+                    _cursors.erase( key( ns, query ) );
+                    return;
+                }
+                if ( _cursors.size() >= kMaxQueueCursors ) {
+                    _cursors.clear();
+                }
+                _cursors[ key( ns, query ) ] = id;
+            }
+
+        private:
+            static string key( const string& ns, const BSONObj& query ) {
+                return ns + '\0' + string( query.objdata(), query.objsize() );
+            }
+
+            mongo::mutex _mutex;
+            map<string, CursorId> _cursors;
+        } queueCursors;
+
+        /**
+         * Advances 'c' to the next document it matches, setting 'details' for it.  Returns
+         * false at the end.
+         */
+        bool nextMatch( Cursor* c, MatchDetails* details ) {
+            for ( ; c->ok(); c->advance() ) {
+                *details = MatchDetails();
+                details->requestElemMatchKey();
+                if ( c->currentMatches( details ) && !c->getsetdup( c->currLoc() ) ) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    }
+
     /* Find and Modify an object returning either the old (default) or new value*/
     class CmdFindAndModify : public Command {
     public:
@@ -39,6 +100,8 @@ namespace mongo {
                  "{ findAndModify: \"collection\", query: {processed:false}, update: {$set: {processed:true}}, new: true}\n"
                  "{ findAndModify: \"collection\", query: {processed:false}, remove: true, sort: {priority:-1}}\n"
                  "Either update or remove is required, all other fields have default values.\n"
+                 "With queue: true and no sort, calls with the same query hand out documents\n"
+                 "in turn, each resuming after the last one found.\n"
                  "Output is in the \"value\" field\n";
         }
 
@@ -64,6 +127,7 @@ namespace mongo {
             bool upsert = cmdObj["upsert"].trueValue();
             bool returnNew = cmdObj["new"].trueValue();
             bool remove = cmdObj["remove"].trueValue();
+            bool queue = cmdObj["queue"].trueValue();
 
             if ( remove ) {
                 if ( upsert ) {
@@ -85,7 +149,7 @@ namespace mongo {
                 try {
                     return runNoDirectClient( ns , 
                                               query , fields , update , 
-                                              upsert , returnNew , remove , 
+                                              upsert , returnNew , remove , queue ,
                                               result , errmsg );
                 }
                 catch ( PageFaultException& e ) {
@@ -113,75 +177,105 @@ namespace mongo {
                 
         }
 
-        bool runNoDirectClient( const string& ns , 
-                                const BSONObj& queryOriginal , const BSONObj& fields , const BSONObj& update , 
-                                bool upsert , bool returnNew , bool remove ,
-                                BSONObjBuilder& result , string& errmsg ) {
-            
-            
-            Lock::DBWrite lk( ns );
-            Client::Context cx( ns );
-
-            BSONObj doc;
-            
-            bool found = Helpers::findOne( ns.c_str() , queryOriginal , doc );
+        BSONObj _lastErrorObject( const UpdateResult& res ) {
+            BSONObjBuilder le;
+            le.appendBool( "updatedExisting" , res.existing );
+            le.appendNumber( "n" , res.num );
+            if ( res.upserted.isSet() )
+                le.append( "upserted" , res.upserted );
+            return le.obj();
+        }
 
-            BSONObj queryModified = queryOriginal;
-            if ( found && doc["_id"].type() && ! isSimpleIdQuery( queryOriginal ) ) {
-                // we're going to re-write the query to be more efficient
-                // we have to be a little careful because of positional operators
-                // maybe we can pass this all through eventually, but right now isn't an easy way
-                
-                bool hasPositionalUpdate = false;
+        /**
+         * Finds the document after the one the last call handed out for 'query' on 'ns', or
+         * the first if there is none after it, and leaves the query's cursor past it.  Returns
+         * a null DiskLoc if nothing matches.
+         */
+        DiskLoc _locateQueued( const string& ns , const BSONObj& query , MatchDetails* details ) {
+            DiskLoc loc;
+            CursorId id = queueCursors.get( ns , query );
+            if ( id ) {
                 {
-                    // if the update has a positional piece ($)
-                    // then we need to pull all query parts in
-                    // so here we check for $
-                    // a little hacky
-                    BSONObjIterator i( update );
-                    while ( i.more() ) {
-                        const BSONElement& elem = i.next();
-                        
-                        if ( elem.fieldName()[0] != '$' || elem.type() != Object )
-                            continue;
-
-                        BSONObjIterator j( elem.Obj() );
-                        while ( j.more() ) {
-                            if ( str::contains( j.next().fieldName(), ".$" ) ) {
-                                hasPositionalUpdate = true;
-                                break;
-                            }
+                    ClientCursor::Pin pin( id );
+                    ClientCursor* cursor = pin.c();
+                    if ( cursor && cursor->ns() == ns ) {
+                        cursor->c()->recoverFromYield();
+                        if ( nextMatch( cursor->c() , details ) &&
+                             _advanceQueued( cursor , &loc ) ) {
+                            return loc;
                         }
                     }
                 }
+                ClientCursor::erase( id );
+                queueCursors.set( ns , query , 0 );
+                if ( !loc.isNull() ) {
+                    return loc;
+                }
+            }
 
-                BSONObjBuilder b( queryOriginal.objsize() + 10 );
-                b.append( doc["_id"] );
-                
-                bool addedAtomic = false;
+            // Documents before the old cursor's position may have come to match since.
+            shared_ptr<Cursor> c = getOptimizedCursor( ns, query, BSONObj() );
+            ClientCursor::Holder cursor( new ClientCursor( 0 , c , ns , query ) );
+            if ( nextMatch( c.get() , details ) && _advanceQueued( cursor.get() , &loc ) ) {
+                queueCursors.set( ns , query , cursor->cursorid() );
+                cursor.release();
+            }
+            return loc;
+        }
 
-                BSONObjIterator i( queryOriginal );
-                while ( i.more() ) {
-                    const BSONElement& elem = i.next();
+        /**
+         * Sets *loc to the document 'cursor' is on, which the caller is about to modify, and
+         * moves the cursor past it, saving its position for the next call.  Returns false if
+         * there is nothing after it, so the cursor isn't worth keeping.
+         */
+        bool _advanceQueued( ClientCursor* cursor , DiskLoc* loc ) {
+            Cursor* c = cursor->c();
+            *loc = c->currLoc();
+            while ( c->ok() && c->currLoc() == *loc ) {
+                c->advance();
+            }
+            if ( !c->ok() ) {
+                return false;
+            }
 
-                    if ( str::equals( "_id" , elem.fieldName() ) ) {
-                        // we already do _id
-                        continue;
-                    }
-                    
-                    if ( ! hasPositionalUpdate ) {
-                        // if there is a dotted field, accept we may need more query parts
-                        continue;
-                    }
-                    
-                    if ( ! addedAtomic ) {
-                        b.appendBool( "$atomic" , true );
-                        addedAtomic = true;
-                    }
+            if ( c->supportYields() ) {
+                ClientCursor::YieldData data;
+                verify( cursor->prepareToYield( data ) );
+            }
+            else {
+                c->noteLocation();
+            }
+            return true;
+        }
+
+        bool runNoDirectClient( const string& ns , 
+                                const BSONObj& queryOriginal , const BSONObj& fields , const BSONObj& update , 
+                                bool upsert , bool returnNew , bool remove , bool queue ,
+                                BSONObjBuilder& result , string& errmsg ) {
+            
+            
+            Lock::DBWrite lk( ns );
+            Client::Context cx( ns );
 
-                    b.append( elem );
+            // Locate the document once, remembering where it is and which array element the
+            // query matched, so the update can go straight to it.
+            DiskLoc loc;
+            MatchDetails details;
+            if ( queue ) {
+                loc = _locateQueued( ns , queryOriginal , &details );
+            }
+            else {
+                shared_ptr<Cursor> c = getOptimizedCursor( ns, queryOriginal, BSONObj() );
+                if ( nextMatch( c.get() , &details ) ) {
+                    loc = c->currLoc();
                 }
-                queryModified = b.obj();
+            }
+            bool found = !loc.isNull();
+            BSONObj doc = found ? loc.obj() : BSONObj();
+
+            BSONObj queryModified = queryOriginal;
+            if ( found && doc["_id"].type() ) {
+                queryModified = doc["_id"].wrap();
             }
 
             if ( remove ) {
@@ -203,37 +297,48 @@ namespace mongo {
                     // we found it or we're updating
                     
                     if ( ! returnNew ) {
+                        // before the update, which may change 'doc' in place
                         _appendHelper( result , doc , found , fields );
                     }
-                    
-                    UpdateResult res = updateObjects( ns.c_str() , update , queryModified , upsert , false , true , cc().curop()->debug() );
-                    
-                    if ( returnNew ) {
-                        if ( res.upserted.isSet() ) {
-                            queryModified = BSON( "_id" << res.upserted );
-                        }
-                        else if ( queryModified["_id"].type() ) {
-                            // we do this so that if the update changes the fields, it still matches
-                            queryModified = queryModified["_id"].wrap();
-                        }
-                        if ( ! Helpers::findOne( ns.c_str() , queryModified , doc ) ) {
-                            errmsg = str::stream() << "can't find object after modification  " 
-                                                   << " ns: " << ns 
-                                                   << " queryModified: " << queryModified 
-                                                   << " queryOriginal: " << queryOriginal;
-                            log() << errmsg << endl;
-                            return false;
+
+                    OpDebug& debug = cc().curop()->debug();
+                    BSONObj newObj;
+                    BSONObj lastError;
+                    if ( found ) {
+                        const StringData elemMatchKey = details.hasElemMatchKey() ?
+                                                        details.elemMatchKey() : StringData();
+                        UpdateResult res = updateObjectAt( ns.c_str() , loc , update ,
+                                                           queryModified , elemMatchKey ,
+                                                           true , debug , &newObj );
+                        lastError = _lastErrorObject( res );
+                    }
+                    else {
+                        UpdateResult res = updateObjects( ns.c_str() , update , queryOriginal ,
+                                                          upsert , false , true , debug );
+                        if ( returnNew ) {
+                            if ( res.upserted.isSet() ) {
+                                queryModified = BSON( "_id" << res.upserted );
+                            }
+                            else if ( queryModified["_id"].type() ) {
+                                queryModified = queryModified["_id"].wrap();
+                            }
+                            if ( ! Helpers::findOne( ns.c_str() , queryModified , newObj ) ) {
+                                errmsg = str::stream() << "can't find object after modification  "
+                                                       << " ns: " << ns
+                                                       << " queryModified: " << queryModified
+                                                       << " queryOriginal: "
+                                                       << queryOriginal;
+                                log() << errmsg << endl;
+                                return false;
+                            }
                         }
-                        _appendHelper( result , doc , true , fields );
+                        lastError = _lastErrorObject( res );
                     }
-                    
-                    BSONObjBuilder le( result.subobjStart( "lastErrorObject" ) );
-                    le.appendBool( "updatedExisting" , res.existing );
-                    le.appendNumber( "n" , res.num );
-                    if ( res.upserted.isSet() )
-                        le.append( "upserted" , res.upserted );
-                    le.done();
-                    
+
+                    if ( returnNew ) {
+                        _appendHelper( result , newObj , true , fields );
+                    }
+                    result.append( "lastErrorObject" , lastError );
                 }
             }
             
@@ -246,6 +351,11 @@ namespace mongo {
             if ( cmdObj["sort"].eoo() )
                 return runNoDirectClient( dbname , cmdObj , x, errmsg , result, y );
 
+            if ( cmdObj["queue"].trueValue() ) {
+                errmsg = "queue and sort can't co-exist";
+                return false;
+            }
+
             string ns = dbname + '.' + cmdObj.firstElement().valuestr();
 
             BSONObj origQuery = cmdObj.getObjectField("query"); // defaults to {}
@@ -18,6 +18,8 @@
 
 #include "pch.h"
 
+#include <limits>
+#include <pcrecpp.h>
 #include <vector>
 
 #include "mongo/db/auth/action_set.h"
@@ -27,10 +29,281 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/query_optimizer.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/float_utils.h"
 #include "mongo/scripting/engine.h"
 
 namespace mongo {
 
+    // Whether group may run a reduce function it recognizes without JavaScript.
+    MONGO_EXPORT_SERVER_PARAMETER(groupNativeReduce, bool, true);
+
+namespace {
+
+    /**
+     * A reduce function made only of statements group can run without JavaScript, with the
+     * same results:
+     *
+     *   prev.x++;  ++prev.x;  prev.x += 1;  prev.x += obj.y;
+     *   prev.x = Math.min(prev.x, obj.y);  prev.x = Math.max(obj.y, prev.x);
+     *
+     * where obj and prev are the function's parameters, and each prev field is a number in
+     * initial.  As in JavaScript every value is a double, and values are converted to numbers
+     * the way JavaScript would; a value JavaScript wouldn't simply convert, like a string which
+     * '+' would concatenate, makes process() fail so the caller can start over with JavaScript.
+     */
+    class NativeReduce {
+    public:
+        /** @return false if the reduce function or initial isn't one this can run */
+        bool parse( const string& reduceCode, const BSONObj& initial, const BSONObj& keyPattern );
+
+        /** @return the state of a new group. */
+        const vector<double>& initialState() const { return _initial; }
+
+        /**
+         * Applies the reduce function to 'obj'.
+         * @return false if obj has a value JavaScript would treat in a way this can't
+         */
+        bool process( const BSONObj& obj, vector<double>* state ) const;
+
+        /** @return false if 'key' has a value appendResult() can't convert like JavaScript */
+        static bool acceptsKey( const BSONObj& key );
+
+        /**
+         * Appends a group's result as JavaScript would return it: 'key', with int numbers
+         * made doubles, then the state.
+         */
+        void appendResult( const BSONObj& key, const vector<double>& state,
+                           BSONArrayBuilder* out ) const;
+
+    private:
+        struct Op {
+            enum Type { ADD, MIN, MAX };
+            Type type;
+            size_t target;  // index into _names
+            string field;   // the document field read, or empty for 'constant'
+            double constant;
+        };
+
+        bool parseStatement( const string& statement );
+        bool parseOperand( const string& operand, Op* op ) const;
+        int targetIndex( const string& object, const string& field ) const;
+
+        /** JavaScript's ToNumber for the types it makes a plain number from. */
+        static bool toNumber( const BSONElement& e, double* out );
+
+        string _obj;
+        string _prev;
+        vector<string> _names;
+        vector<double> _initial;
+        vector<Op> _ops;
+    };
+
+    const char kIdent[] = "([A-Za-z_$][\\w$]*)";
+
+    bool NativeReduce::parse( const string& reduceCode, const BSONObj& initial,
+                              const BSONObj& keyPattern ) {
+        // JavaScript orders names like "0" first, and would put an _id first too.
+        BSONForEach( e, initial ) {
+            const string name = e.fieldName();
+            if ( ( e.type() != NumberInt && e.type() != NumberDouble ) || name == "_id" ||
+                 !pcrecpp::RE( string( "^" ) + kIdent + "$" ).FullMatch( name ) ||
+                 keyPattern.hasField( name.c_str() ) )
+                return false;
+            _names.push_back( name );
+            _initial.push_back( e.number() );
+        }
+        BSONForEach( e, keyPattern ) {
+            if ( str::equals( e.fieldName(), "_id" ) ||
+                 !pcrecpp::RE( string( "^" ) + kIdent + "$" ).FullMatch( e.fieldName() ) )
+                return false;
+        }
+
+        string body;
+        static const pcrecpp::RE function(
+            string( "\\s*function(?:\\s+[A-Za-z_$][\\w$]*)?\\s*\\(\\s*" ) + kIdent +
+            "\\s*,\\s*" + kIdent +
+            "\\s*\\)\\s*\\{(.*)\\}\\s*;?\\s*",
+            pcrecpp::RE_Options().set_dotall( true ) );
+        if ( !function.FullMatch( reduceCode, &_obj, &_prev, &body ) || _obj == _prev )
+            return false;
+
+        size_t start = 0;
+        while ( start <= body.size() ) {
+            size_t end = body.find_first_of( ";\n", start );
+            if ( end == string::npos )
+                end = body.size();
+
+            string statement = body.substr( start, end - start );
+            pcrecpp::RE( "^\\s+|\\s+$" ).GlobalReplace( "", &statement );
+            if ( !statement.empty() && !parseStatement( statement ) )
+                return false;
+            start = end + 1;
+        }
+        return !_ops.empty();
+    }
+
+    bool NativeReduce::parseStatement( const string& statement ) {
+        static const pcrecpp::RE increment( string( kIdent ) + "\\." + kIdent +
+                                            "\\s*\\+\\+" );
+        static const pcrecpp::RE preIncrement( string( "\\+\\+\\s*" ) + kIdent + "\\." +
+                                               kIdent );
+        static const pcrecpp::RE add( string( kIdent ) + "\\." + kIdent +
+                                      "\\s*\\+=\\s*(.+)" );
+        static const pcrecpp::RE minMax( string( kIdent ) + "\\." + kIdent +
+                                         "\\s*=\\s*Math\\.(min|max)\\s*\\(\\s*(.+?)"
+                                         "\\s*,\\s*(.+?)\\s*\\)" );
+
+        string object;
+        string field;
+        string operand;
+        string function;
+        string first;
+        string second;
+        Op op;
+        if ( increment.FullMatch( statement, &object, &field ) ||
+             preIncrement.FullMatch( statement, &object, &field ) ) {
+            op.type = Op::ADD;
+            op.constant = 1;
+        }
+        else if ( add.FullMatch( statement, &object, &field, &operand ) ) {
+            op.type = Op::ADD;
+            if ( !parseOperand( operand, &op ) )
+                return false;
+        }
+        else if ( minMax.FullMatch( statement, &object, &field, &function, &first, &second ) ) {
+            op.type = function == "min" ? Op::MIN : Op::MAX;
+            const string self = object + "." + field;
+            if ( first == self )
+                operand = second;
+            else if ( second == self )
+                operand = first;
+            else
+                return false;
+            if ( !parseOperand( operand, &op ) )
+                return false;
+        }
+        else {
+            return false;
+        }
+
+        const int target = targetIndex( object, field );
+        if ( target < 0 )
+            return false;
+        op.target = target;
+        _ops.push_back( op );
+        return true;
+    }
+
+    bool NativeReduce::parseOperand( const string& operand, Op* op ) const {
+        static const pcrecpp::RE fieldOperand( string( kIdent ) + "\\." + kIdent );
+        static const pcrecpp::RE constantOperand( "-?\\d+(\\.\\d+)?" );
+
+        string object;
+        if ( fieldOperand.FullMatch( operand, &object, &op->field ) )
+            return object == _obj;
+
+        if ( constantOperand.FullMatch( operand ) ) {
+            op->field.clear();
+            op->constant = strtod( operand.c_str(), NULL );
+            return true;
+        }
+        return false;
+    }
+
+    int NativeReduce::targetIndex( const string& object, const string& field ) const {
+        if ( object != _prev )
+            return -1;
+        for ( size_t i = 0; i < _names.size(); i++ ) {
+            if ( _names[ i ] == field )
+                return i;
+        }
+        return -1;
+    }
+
+    bool NativeReduce::toNumber( const BSONElement& e, double* out ) {
+        switch ( e.type() ) {
+        case NumberInt:
+        case NumberDouble:
+            *out = e.number();
+            return true;
+        case EOO: // undefined, as is a missing field
+        case Undefined:
+            *out = std::numeric_limits<double>::quiet_NaN();
+            return true;
+        case jstNULL:
+            *out = 0;
+            return true;
+        case Bool:
+            *out = e.boolean() ? 1 : 0;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool NativeReduce::process( const BSONObj& obj, vector<double>* state ) const {
+        for ( size_t i = 0; i < _ops.size(); i++ ) {
+            const Op& op = _ops[ i ];
+            double value = op.constant;
+            if ( !op.field.empty() && !toNumber( obj[ op.field ], &value ) )
+                return false;
+
+            double& target = ( *state )[ op.target ];
+            switch ( op.type ) {
+            case Op::ADD:
+                target += value;
+                break;
+            case Op::MIN:
+            case Op::MAX:
+                // Math.min and Math.max return NaN if either argument is
+                if ( isNaN( target ) || isNaN( value ) )
+                    target = std::numeric_limits<double>::quiet_NaN();
+                else if ( op.type == Op::MIN ? value < target : value > target )
+                    target = value;
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool NativeReduce::acceptsKey( const BSONObj& key ) {
+        BSONForEach( e, key ) {
+            switch ( e.type() ) {
+            case NumberInt:
+            case NumberDouble:
+            case NumberLong:
+            case String:
+            case Bool:
+            case jstNULL:
+            case Date:
+            case jstOID:
+                break;
+            default:
+                // objects and arrays, and types JavaScript holds as objects of its own
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void NativeReduce::appendResult( const BSONObj& key, const vector<double>& state,
+                                     BSONArrayBuilder* out ) const {
+        BSONObjBuilder result( out->subobjStart() );
+        BSONForEach( e, key ) {
+            if ( e.type() == NumberInt || e.type() == NumberDouble )
+                result.append( e.fieldName(), e.number() );
+            else
+                result.append( e );
+        }
+        for ( size_t i = 0; i < _names.size(); i++ ) {
+            result.append( _names[ i ], state[ i ] );
+        }
+        result.doneFast();
+    }
+
+} // namespace
+
     class GroupCommand : public Command {
     public:
         GroupCommand() : Command("group") {}
@@ -61,6 +334,81 @@ namespace mongo {
             return obj.extractFields( keyPattern , true ).getOwned();
         }
 
+        /**
+         * Runs a group whose reduce function 'native' parsed, without JavaScript.
+         * @return false, having added nothing to 'result', if a key or document turns out to
+         *     need JavaScript after all
+         */
+        bool groupNative( const std::string& ns,
+                          const BSONObj& query,
+                          const BSONObj& keyPattern,
+                          const NativeReduce& native,
+                          BSONObjBuilder& result ) {
+            map<BSONObj,int,BSONObjCmp> groups;
+            vector<BSONObj> keys;
+            vector<vector<double> > states;
+            long long count = 0;
+
+            shared_ptr<Cursor> cursor = getOptimizedCursor(ns.c_str() , query);
+            ClientCursor::Holder ccPointer( new ClientCursor( QueryOption_NoCursorTimeout, cursor,
+                                                             ns ) );
+
+            while ( cursor->ok() ) {
+
+                if ( !ccPointer->yieldSometimes( ClientCursor::MaybeCovered ) ||
+                    !cursor->ok() ) {
+                    break;
+                }
+
+                if ( !cursor->currentMatches() || cursor->getsetdup( cursor->currLoc() ) ) {
+                    cursor->advance();
+                    continue;
+                }
+
+                if ( !ccPointer->yieldSometimes( ClientCursor::WillNeed ) ||
+                    !cursor->ok() ) {
+                    break;
+                }
+
+                BSONObj obj = cursor->current();
+                cursor->advance();
+
+                BSONObj key = obj.extractFields( keyPattern , true ).getOwned();
+                count++;
+
+                map<BSONObj,int,BSONObjCmp>::const_iterator it = groups.find( key );
+                int n;
+                if ( it == groups.end() ) {
+                    if ( !NativeReduce::acceptsKey( key ) )
+                        return false;
+
+                    n = keys.size();
+                    groups[ key ] = n;
+                    keys.push_back( key );
+                    states.push_back( native.initialState() );
+
+                    uassert( 10043 ,  "group() can't handle more than 20000 unique keys" ,
+                             keys.size() <= 20000 );
+                }
+                else {
+                    n = it->second;
+                }
+
+                if ( !native.process( obj, &states[ n ] ) )
+                    return false;
+            }
+            ccPointer.reset();
+
+            BSONArrayBuilder retval( result.subarrayStart( "retval" ) );
+            for ( size_t i = 0; i < keys.size(); i++ ) {
+                native.appendResult( keys[ i ], states[ i ], &retval );
+            }
+            retval.done();
+            result.append( "count" , static_cast<double>( count ) );
+            result.append( "keys" , (int)(keys.size()) );
+            return true;
+        }
+
         bool group( const std::string& realdbname,
                     const std::string& ns,
                     const BSONObj& query,
@@ -73,6 +421,14 @@ namespace mongo {
                     string& errmsg,
                     BSONObjBuilder& result ) {
 
+            if ( groupNativeReduce && keyFunctionCode.empty() && !reduceScope &&
+                 finalize.empty() ) {
+                NativeReduce native;
+                if ( native.parse( reduceCode, initial, keyPattern ) &&
+                     groupNative( ns, query, keyPattern, native, result ) )
+                    return true;
+            }
+
             auto_ptr<Scope> s = globalScriptEngine->getPooledScope( realdbname, "group");
 
             if ( reduceScope )
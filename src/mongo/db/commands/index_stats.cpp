@@ -346,6 +346,7 @@ namespace mongo {
 
     typedef BtreeInspectorImpl<V0> BtreeInspectorV0;
     typedef BtreeInspectorImpl<V1> BtreeInspectorV1;
+    typedef BtreeInspectorImpl<V2> BtreeInspectorV2;
 
     /**
      * Run analysis with the provided parameters. See IndexStatsCmd for in-depth expanation of
@@ -379,6 +380,7 @@ namespace mongo {
 
         scoped_ptr<BtreeInspector> inspector(NULL);
         switch (details->version()) {
+          case 2: inspector.reset(new BtreeInspectorV2(params.expandNodes)); break;
           case 1: inspector.reset(new BtreeInspectorV1(params.expandNodes)); break;
           case 0: inspector.reset(new BtreeInspectorV0(params.expandNodes)); break;
           default:
@@ -405,7 +407,7 @@ namespace mongo {
      *
      * The output has the form:
      *     { index: <index name>,
-     *       version: <index version (0 or 1),
+     *       version: <index version (0, 1 or 2),
      *       isIdKey: <true if this is the default _id index>,
      *       keyPattern: <bson object describing the key pattern>,
      *       storageNs: <namespace of the index's underlying storage>,
@@ -543,6 +545,71 @@ namespace mongo {
 
     };
 
+    /**
+     * Reports how much each index of a collection has been read since the server started, the
+     * index was made or the counts were last reset.  Unlike indexStats this reads no index
+     * data, so it is cheap enough to poll.
+     */
+    class IndexUsageCmd : public Command {
+    public:
+        IndexUsageCmd() : Command("indexUsage") {}
+
+        virtual bool slaveOk() const {
+            return true;
+        }
+
+        virtual void help(stringstream& h) const {
+            h << "Reports for each index of a collection how many times cursors seeked in it, "
+              << "how many keys they scanned and when it was last used, counted since the "
+              << "server started, the index was built or {reset: true} was passed. "
+              << "For example, {indexUsage: 'collection'}. "
+              << "Counts are recorded as cursors close, so open cursors aren't included yet.";
+        }
+
+        virtual LockType locktype() const { return READ; }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::indexStats);
+            out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg,
+                 BSONObjBuilder& result, bool fromRepl) {
+
+            string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
+            NamespaceDetails* nsd = nsdetails(ns);
+            if (!nsd) {
+                errmsg = "ns not found";
+                return false;
+            }
+            const bool reset = cmdObj["reset"].trueValue();
+
+            IndexUsageMap& usageMap = NamespaceDetailsTransient::get(ns.c_str()).indexUsage();
+            BSONArrayBuilder indexes(result.subarrayStart("indexes"));
+            NamespaceDetails::IndexIterator it = nsd->ii();
+            while (it.more()) {
+                const IndexDetails& index = it.next();
+                shared_ptr<IndexUsage> usage = usageMap.get(index.indexName());
+
+                BSONObjBuilder b(indexes.subobjStart());
+                b.append("name", index.indexName());
+                b.append("key", index.keyPattern());
+                usage->toBSON(&b);
+                b.done();
+
+                if (reset)
+                    usage->reset();
+            }
+            indexes.done();
+            result.append("ns", ns);
+            return true;
+        }
+
+    } indexUsageCmd;
+
     MONGO_INITIALIZER(IndexStatsCmd)(InitializerContext* context) {
         if (cmdLine.experimental.indexStatsCmdEnabled) {
             // Leaked intentionally: a Command registers itself when constructed.
@@ -254,7 +254,6 @@ namespace mongo {
                         << cmdObj.firstElement().String()
                         << "_"
                         << JOB_NUMBER++;
-                incLong = tempNamespace + "_inc";
             }
 
             {
@@ -297,12 +296,10 @@ namespace mongo {
         }
 
         /**
-         * Clean up the temporary and incremental collections
+         * Clean up the temporary collection
          */
         void State::dropTempCollections() {
             _db.dropCollection(_config.tempNamespace);
-            if (_useIncremental)
-                _db.dropCollection(_config.incLong);
         }
 
         /**
@@ -313,19 +310,6 @@ namespace mongo {
                 return;
 
             dropTempCollections();
-            if (_useIncremental) {
-                // create the inc collection and make sure we have index on "0" key
-                {
-                    Client::WriteContext ctx( _config.incLong );
-                    string err;
-                    if ( ! userCreateNS( _config.incLong.c_str() , BSON( "autoIndexId" << 0 << "temp" << true ) , err , false ) ) {
-                        uasserted( 13631 , str::stream() << "userCreateNS failed for mr incLong ns: " << _config.incLong << " err: " << err );
-                    }
-                }
-
-                BSONObj sortKey = BSON( "0" << 1 );
-                _db.ensureIndex( _config.incLong , sortKey );
-            }
 
             // create temp collection
             {
@@ -569,20 +553,22 @@ namespace mongo {
         }
 
         /**
-         * Insert doc into the inc collection
+         * Hands a tuple to the sorter, creating it if needed
          */
-        void State::_insertToInc( BSONObj& o ) {
+        void State::_spill( const BSONObj& tuple ) {
             verify( _onDisk );
-            theDataFileMgr.insertWithObjMod( _config.incLong.c_str(), o, false, true );
-            getDur().commitIfNeeded();
+            if ( ! _sorter )
+                _sorter.reset( SpillSorter::make( SortOptions().ExtSortAllowed() , TupleSortCmp() ) );
+            _sorter->add( tuple , BSONObj() );
+            _numSpilled++;
         }
 
         State::State(const Config& c) :
                 _config(c),
-                _useIncremental(true),
                 _size(0),
                 _dupCount(0),
-                _numEmits(0) {
+                _numEmits(0),
+                _numSpilled(0) {
             _temp.reset( new InMemory() );
             _onDisk = _config.outputOptions.outType != Config::INMEMORY;
         }
@@ -784,14 +770,6 @@ namespace mongo {
             return BSONObj();
         }
 
-//        BSONObj _nativeToInc( const BSONObj& args, void* data ) {
-//            State* state = (State*) data;
-//            BSONObjIterator it(args);
-//            const BSONObj& obj = it.next().Obj();
-//            state->_insertToInc(const_cast<BSONObj&>(obj));
-//            return BSONObj();
-//        }
-
         /**
          * Applies last reduce and finalize.
          * After calling this method, the temp collection will be completed.
@@ -829,91 +807,48 @@ namespace mongo {
                         size += res.objsize();
                     }
                     _size = size;
+                    _memory.set( _size , "mapReduce" );
                 }
                 return;
             }
 
-            // use index on "0" to pull sorted data
+            // everything was spilled by dumpToSorter(), pull it back in key order
             verify( _temp->size() == 0 );
-            BSONObj sortKey = BSON( "0" << 1 );
-            {
-                bool foundIndex = false;
-
-                auto_ptr<DBClientCursor> idx = _db.getIndexes( _config.incLong );
-                while ( idx.get() && idx->more() ) {
-                    BSONObj x = idx->nextSafe();
-                    if ( sortKey.woCompare( x["key"].embeddedObject() ) == 0 ) {
-                        foundIndex = true;
-                        break;
-                    }
-                }
-
-                verify( foundIndex );
-            }
-
-            Client::ReadContext ctx( _config.incLong );
+            if ( ! _sorter )
+                return; // nothing was emitted
 
-            BSONObj prev;
             BSONList all;
 
             verify(pm == op->setMessage("m/r: (3/3) final reduce to collection",
                                         "M/R: (3/3) Final Reduce Progress",
-                                        _db.count(_config.incLong, BSONObj(), QueryOption_SlaveOk)));
-
-            shared_ptr<Cursor> temp = getBestGuessCursor(_config.incLong.c_str(),
-                                                         BSONObj(),
-                                                         sortKey);
-            ClientCursor::Holder cursor(new ClientCursor(QueryOption_NoCursorTimeout,
-                                                         temp,
-                                                         _config.incLong.c_str()));
-            // iterate over all sorted objects
-            while ( cursor->ok() ) {
-                BSONObj o = cursor->current().getOwned();
-                cursor->advance();
+                                        _numSpilled));
+
+            // no lock is needed to read the sorter, finalReduce() locks to insert each result
+            scoped_ptr<SpillSorter::Iterator> sorted( _sorter->done() );
+            while ( sorted->more() ) {
+                BSONObj o = sorted->next().first.getOwned();
 
                 pm.hit();
 
-                if ( o.woSortOrder( prev , sortKey ) == 0 ) {
+                if ( all.empty() || o.firstElement().woCompare( all.front().firstElement() ) == 0 ) {
                     // object is same as previous, add to array
                     all.push_back( o );
-                    if ( pm->hits() % 100 == 0 ) {
-                        if ( ! cursor->yield() ) {
-                            break;
-                        }
+                    if ( pm->hits() % 100 == 0 )
                         killCurrentOp.checkForInterrupt();
-                    }
                     continue;
                 }
 
-                ClientCursor::YieldLock yield (cursor.get());
-
-                try {
-                    // reduce a finalize array
-                    finalReduce( all );
-                }
-                catch (...) {
-                    yield.relock();
-                    throw;
-                }
+                // reduce a finalize array
+                finalReduce( all );
 
                 all.clear();
-                prev = o;
                 all.push_back( o );
 
-                if ( ! yield.stillOk() ) {
-                    break;
-                }
-
                 killCurrentOp.checkForInterrupt();
             }
 
-            {
-                dbtempreleasecond tl;
-                if ( ! tl.unlocked() )
-                    warning() << "map/reduce can't temp release" << endl;
-                // reduce and finalize last array
-                finalReduce( all );
-            }
+            // reduce and finalize last array
+            finalReduce( all );
 
             pm.finished();
         }
@@ -921,7 +856,7 @@ namespace mongo {
         /**
          * Attempts to reduce objects in the memory map.
          * A new memory map will be created to hold the results.
-         * If applicable, objects with unique key may be dumped to inc collection.
+         * If applicable, objects with unique key may be spilled to the sorter.
          * Input and output objects are both {"0": key, "1": val}
          */
         void State::reduceInMemory() {
@@ -942,9 +877,8 @@ namespace mongo {
                 if ( all.size() == 1 ) {
                     // only 1 value for this key
                     if ( _onDisk ) {
-                        // this key has low cardinality, so just write to collection
-                        Client::WriteContext ctx(_config.incLong.c_str());
-                        _insertToInc( *(all.begin()) );
+                        // this key has low cardinality, so just spill it
+                        _spill( *(all.begin()) );
                     }
                     else {
                         // add to new map
@@ -964,22 +898,19 @@ namespace mongo {
         }
 
         /**
-         * Dumps the entire in memory map to the inc collection.
+         * Dumps the entire in memory map to the sorter.
          */
-        void State::dumpToInc() {
+        void State::dumpToSorter() {
             if ( ! _onDisk )
                 return;
 
-            Lock::DBWrite kl(_config.incLong);
-            Client::Context ctx(_config.incLong);
-
             for ( InMemory::iterator i=_temp->begin(); i!=_temp->end(); i++ ) {
                 BSONList& all = i->second;
                 if ( all.size() < 1 )
                     continue;
 
                 for ( BSONList::iterator j=all.begin(); j!=all.end(); j++ )
-                    _insertToInc( *j );
+                    _spill( *j );
             }
             _temp->clear();
             _size = 0;
@@ -1028,7 +959,8 @@ namespace mongo {
             if (_jsMode)
                 return;
 
-            if (_size > _config.maxInMemSize || _dupCount > (_temp->size() * _config.reduceTriggerRatio)) {
+            bool overLimit = !_memory.trySet( _size );
+            if (overLimit || _size > _config.maxInMemSize || _dupCount > (_temp->size() * _config.reduceTriggerRatio)) {
                 // attempt to reduce in memory map, if memory is too high or we have many duplicates
                 long oldSize = _size;
                 Timer t;
@@ -1036,10 +968,14 @@ namespace mongo {
                 LOG(1) << "  MR - did reduceInMemory: size=" << oldSize << " dups=" << _dupCount << " newSize=" << _size << " time=" << t.millis() << "ms" << endl;
 
                 // if size is still high, or values are not reducing well, dump
-                if ( _onDisk && (_size > _config.maxInMemSize || _size > oldSize / 2) ) {
-                    dumpToInc();
-                    LOG(1) << "  MR - dumping to db" << endl;
+                overLimit = !_memory.trySet( _size );
+                if ( _onDisk && (overLimit || _size > _config.maxInMemSize || _size > oldSize / 2) ) {
+                    dumpToSorter();
+                    LOG(1) << "  MR - spilled to sorter" << endl;
                 }
+
+                // inline output has nowhere to spill to
+                _memory.set( _size , "mapReduce" );
             }
         }
 
@@ -1268,8 +1204,8 @@ namespace mongo {
                     // do reduce in memory
                     // this will be the last reduce needed for inline mode
                     state.reduceInMemory();
-                    // if not inline: dump the in memory map to inc collection, all data is on disk
-                    state.dumpToInc();
+                    // if not inline: dump the in memory map to the sorter, it now has all the data
+                    state.dumpToSorter();
                     // final reduce
                     state.finalReduce( op , pm );
                     inReduce += rt.micros();
@@ -1352,10 +1288,6 @@ namespace mongo {
                 State state(config);
                 state.init();
 
-                // no need for incremental collection because records are already sorted
-                state._useIncremental = false;
-                config.incLong = config.tempNamespace;
-
                 BSONObj shardCounts = cmdObj["shardCounts"].embeddedObjectUserCheck();
                 BSONObj counts = cmdObj["counts"].embeddedObjectUserCheck();
 
@@ -1483,3 +1415,5 @@ namespace mongo {
 
 }
 
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::BSONObj, mongo::mr::TupleSortCmp);
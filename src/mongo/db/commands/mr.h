@@ -26,6 +26,8 @@
 #include "mongo/db/curop.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/memory_tracker.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/scripting/engine.h"
 
 namespace mongo {
@@ -152,6 +154,16 @@ namespace mongo {
 
         typedef map< BSONObj,BSONList,TupleKeyCmp > InMemory; // from key to list of tuples
 
+        /**
+         * orders (tuple, unused) pairs spilled to the Sorter by key, like TupleKeyCmp
+         */
+        class TupleSortCmp {
+        public:
+            int operator()( const pair<BSONObj,BSONObj>& l, const pair<BSONObj,BSONObj>& r ) const {
+                return l.first.firstElement().woCompare( r.first.firstElement() );
+            }
+        };
+
         /**
          * holds map/reduce config information
          */
@@ -183,7 +195,6 @@ namespace mongo {
             BSONObj scopeSetup;
 
             // output tables
-            string incLong;
             string tempNamespace;
 
             enum OutputType {
@@ -241,7 +252,7 @@ namespace mongo {
 
             /**
              * if size is big, run a reduce
-             * if its still big, dump to temp collection
+             * if its still big, spill to the sorter
              */
             void checkSize();
 
@@ -251,11 +262,10 @@ namespace mongo {
             void reduceInMemory();
 
             /**
-             * transfers in memory storage to temp collection
+             * transfers in memory storage to the sorter, which keeps what doesn't fit in memory in
+             * sorted files under dbpath/_tmp until the final reduce
              */
-            void dumpToInc();
-            void insertToInc( BSONObj& o );
-            void _insertToInc( BSONObj& o );
+            void dumpToSorter();
 
             // ------ reduce stage -----------
 
@@ -310,21 +320,27 @@ namespace mongo {
 
             const Config& _config;
             DBDirectClient _db;
-            bool _useIncremental;   // use an incremental collection
 
         protected:
 
+            typedef Sorter<BSONObj, BSONObj> SpillSorter; // (tuple, unused)
+
             void _add( InMemory* im , const BSONObj& a , long& size );
+            void _spill( const BSONObj& tuple );
 
             scoped_ptr<Scope> _scope;
             bool _onDisk; // if the end result of this map reduce is disk or not
 
             scoped_ptr<InMemory> _temp;
             long _size; // bytes in _temp
+            MemoryCharge _memory; // of _size, set by checkSize()
             long _dupCount; // number of duplicate key entries
 
             long long _numEmits;
 
+            scoped_ptr<SpillSorter> _sorter; // tuples spilled from _temp, created on first spill
+            long long _numSpilled;
+
             bool _jsMode;
             ScriptingFunction _reduceAll;
             ScriptingFunction _reduceAndEmit;
@@ -18,6 +18,7 @@
 
 #include "mongo/pch.h"
 
+#include "mongo/client/connpool.h"
 #include "mongo/client/dbclient_rs.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/commands.h"
@@ -216,6 +217,62 @@ namespace mongo {
                                                           &cmdLine.syncdelay,
                                                           true,
                                                           true );
+
+        /**
+         * Exposes one of the global connection pool's per host limits, which live as statics
+         * on PoolForHost rather than as plain variables.
+         */
+        class ConnPoolSetting : public ServerParameter {
+        public:
+            ConnPoolSetting(const std::string& name, unsigned (*getter)(), void (*setter)(unsigned))
+                : ServerParameter(ServerParameterSet::getGlobal(), name),
+                  _getter(getter), _setter(setter) {}
+
+            virtual void append(BSONObjBuilder& b, const std::string& name) {
+                b.appendNumber(name, static_cast<long long>(_getter()));
+            }
+
+            virtual Status set(const BSONElement& newValueElement) {
+                int newValue;
+                if (!newValueElement.coerce(&newValue) || newValue < 0)
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for " << name() << ": " << newValueElement);
+                _setter(newValue);
+                return Status::OK();
+            }
+
+            virtual Status setFromString(const std::string& str) {
+                int newValue;
+                Status status = parseNumberFromString(str, &newValue);
+                if (!status.isOK())
+                    return status;
+                if (newValue < 0)
+                    return Status(ErrorCodes::BadValue, mongoutils::str::stream() <<
+                                  "Invalid value for " << name() << ": " << newValue);
+                _setter(newValue);
+                return Status::OK();
+            }
+
+        private:
+            unsigned (*_getter)();
+            void (*_setter)(unsigned);
+        };
+
+        ConnPoolSetting connPoolMaxConnsPerHost("connPoolMaxConnsPerHost",
+                                                &PoolForHost::getMaxPerHost,
+                                                &PoolForHost::setMaxPerHost);
+        ConnPoolSetting connPoolMaxInUseConnsPerHost("connPoolMaxInUseConnsPerHost",
+                                                     &PoolForHost::getMaxInUsePerHost,
+                                                     &PoolForHost::setMaxInUsePerHost);
+        ConnPoolSetting connPoolWaitTimeoutMillis("connPoolWaitTimeoutMillis",
+                                                  &PoolForHost::getMaxWaitMillis,
+                                                  &PoolForHost::setMaxWaitMillis);
+        ConnPoolSetting connPoolMinIdleConnsPerHost("connPoolMinIdleConnsPerHost",
+                                                    &PoolForHost::getMinIdlePerHost,
+                                                    &PoolForHost::setMinIdlePerHost);
+        ConnPoolSetting connPoolMaxIdleTimeSecs("connPoolMaxIdleTimeSecs",
+                                                &PoolForHost::getMaxIdleSecs,
+                                                &PoolForHost::setMaxIdleSecs);
     }
 
 }
@@ -83,11 +83,16 @@ namespace mongo {
             // can't use result BSONObjBuilder directly since it won't handle exceptions correctly.
             BSONArrayBuilder resultsArray;
             const int byteLimit = MaxBytesToReturnToClientAtOnce;
-            for (int objs = 0;
-                    objs < batchSize && cursor->ok() && resultsArray.len() <= byteLimit;
-                    objs++) {
-                // TODO may need special logic if cursor->current() would cause results to be > 16MB
-                resultsArray.append(cursor->current());
+            for (int objs = 0; objs < batchSize && cursor->ok(); objs++) {
+                BSONObj next = cursor->current();
+
+                // Like getMore, stop before a document that would take the batch past the byte
+                // limit rather than after it, so a batch never grows much past byteLimit.  The
+                // document stays current and starts the first getMore.
+                if (objs > 0 && resultsArray.len() + next.objsize() > byteLimit)
+                    break;
+
+                resultsArray.append(next);
                 cursor->advance();
             }
 
@@ -124,11 +129,18 @@ namespace mongo {
 
         // "core" cursor protocol
         virtual bool ok() { return !iterator()->eof(); }
-        virtual bool advance() { return iterator()->advance(); }
+        virtual bool advance() {
+            _currentObj = BSONObj();
+            return iterator()->advance();
+        }
         virtual BSONObj current() {
-            BSONObjBuilder builder;
-            iterator()->getCurrent().toBson(&builder);
-            return builder.obj();
+            // getMore looks at the same document several times, so only convert it once.
+            if (_currentObj.isEmpty()) {
+                BSONObjBuilder builder(_sizeTracker);
+                iterator()->getCurrent().toBson(&builder);
+                _currentObj = builder.obj();
+            }
+            return _currentObj;
         }
 
         virtual bool requiresLock() { return false; }
@@ -152,6 +164,8 @@ namespace mongo {
         DocumentSource* iterator() { return _pipeline->output(); }
 
         intrusive_ptr<Pipeline> _pipeline;
+        BSONObj _currentObj; // iterator()->getCurrent() as BSON, empty until asked for
+        BSONSizeTracker _sizeTracker; // sizes of recent _currentObjs
     };
 
     class PipelineCommand :
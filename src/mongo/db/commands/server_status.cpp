@@ -30,6 +30,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/util/net/listen.h"
+#include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
 #include "mongo/util/version.h"
@@ -101,7 +102,12 @@ namespace mongo {
             timeBuilder.appendNumber( "after basic" , Listener::getElapsedTimeMillis() - start );
             
             // --- all sections
-            
+
+            // { defaultSections : false } leaves out everything not asked for by name, for
+            // callers that poll often and only look at a few sections
+            const bool includeDefaults = !cmdObj["defaultSections"].type() ||
+                                         cmdObj["defaultSections"].trueValue();
+
             for ( SectionMap::const_iterator i = _sections->begin(); i != _sections->end(); ++i ) {
                 ServerStatusSection* section = i->second;
                 
@@ -110,7 +116,7 @@ namespace mongo {
                 if (!authSession->checkAuthForPrivileges(requiredPrivileges).isOK())
                     continue;
 
-                bool include = section->includeByDefault();
+                bool include = includeDefaults && section->includeByDefault();
                 
                 BSONElement e = cmdObj[section->getSectionName()];
                 if ( e.type() ) {
@@ -131,8 +137,13 @@ namespace mongo {
 
             // --- counters
             bool includeMetricTree = MetricTree::theMetricTree != NULL;
-            if ( cmdObj["metrics"].type() && !cmdObj["metrics"].trueValue() )
+            if ( cmdObj["metrics"].type() ) {
+                if ( !cmdObj["metrics"].trueValue() )
+                    includeMetricTree = false;
+            }
+            else if ( !includeDefaults ) {
                 includeMetricTree = false;
+            }
 
             if ( includeMetricTree ) {
                 MetricTree::theMetricTree->appendTo( result );
@@ -318,6 +329,25 @@ namespace mongo {
                 
         } network;
 
+#ifdef MONGO_SSL
+        class SSLServerStatus : public ServerStatusSection {
+        public:
+            SSLServerStatus() : ServerStatusSection( "ssl" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                SSLManagerInterface* manager = getSSLManager();
+                if ( ! manager )
+                    return BSONObj();
+
+                BSONObjBuilder b;
+                manager->appendStats( &b );
+                return b.obj();
+            }
+
+        } sslServerStatus;
+#endif
+
         class MemBase : public ServerStatusMetric {
         public:
             MemBase() : ServerStatusMetric(".mem.bits") {}
@@ -48,8 +48,14 @@ namespace mongo {
         virtual void help( stringstream& help ) const {
             help << "touch collection\n"
                 "Page in all pages of memory containing every extent for the given collection\n"
-                "{ touch : <collection_name>, [data : true] , [index : true] }\n"
-                " at least one of data or index must be true; default is both are false\n";
+                "{ touch : <collection_name>, [data : true] , [index : true] ,\n"
+                "  [indexes : [ <index name or key pattern>, ... ]] ,\n"
+                "  [min : <key>] , [max : <key>] , [threads : <n>] }\n"
+                " at least one of data or index must be true; default is both are false\n"
+                " indexes touches just those indexes, in that order, and implies index : true\n"
+                " min and max, with one index in indexes, touch just the keys from min to max\n"
+                "  (and with data : true the documents they point to) instead\n"
+                " indexes are touched before data, on up to threads threads (default 4)\n";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
                                            const BSONObj& cmdObj,
@@ -78,14 +84,30 @@ namespace mongo {
                 return false;
             }
 
-            bool touch_indexes( cmdObj["index"].trueValue() );
+            BSONElement indexes = cmdObj["indexes"];
+            if ( !indexes.eoo() && indexes.type() != Array ) {
+                errmsg = "indexes must be an array";
+                return false;
+            }
+
+            bool touch_indexes( cmdObj["index"].trueValue() || !indexes.eoo() );
             bool touch_data( cmdObj["data"].trueValue() );
 
             if ( ! (touch_indexes || touch_data) ) {
                 errmsg = "must specify at least one of (data:true, index:true)";
                 return false;
             }
-            bool ok = touch( ns, errmsg, touch_data, touch_indexes, result );
+
+            int threads = cmdObj["threads"].eoo() ? 4 : cmdObj["threads"].numberInt();
+            if ( threads < 1 || threads > 64 ) {
+                errmsg = "threads must be from 1 to 64";
+                return false;
+            }
+
+            Timer t;
+            bool ok = touch( ns, errmsg, touch_data, touch_indexes, indexes, cmdObj, threads,
+                             result );
+            result.append( "millis", t.millis() );
             return ok;
         }
 
@@ -93,34 +115,75 @@ namespace mongo {
                     std::string& errmsg, 
                     bool touch_data, 
                     bool touch_indexes, 
+                    const BSONElement& indexes,
+                    const BSONObj& cmdObj,
+                    int threads,
                     BSONObjBuilder& result ) {
 
-            if (touch_data) {
-                log() << "touching namespace " << ns << endl;
-                touchNs( ns );
-                log() << "touching namespace " << ns << " complete" << endl;
-            }
-
+            // enumerate indexes, the ones asked for in the order asked for
+            std::vector<std::string> indexNames;
+            std::vector<std::string> indexNamespaces;
             if (touch_indexes) {
-                // enumerate indexes
-                std::vector< std::string > indexes;
-                {
-                    Client::ReadContext ctx(ns);
-                    NamespaceDetails *nsd = nsdetails(ns);
-                    massert( 16153, "namespace does not exist", nsd );
-                    
+                Client::ReadContext ctx(ns);
+                NamespaceDetails *nsd = nsdetails(ns);
+                massert( 16153, "namespace does not exist", nsd );
+
+                if ( indexes.eoo() ) {
                     NamespaceDetails::IndexIterator ii = nsd->ii(); 
                     while ( ii.more() ) {
                         IndexDetails& idx = ii.next();
-                        indexes.push_back( idx.indexNamespace() );
+                        indexNames.push_back( idx.indexName() );
+                        indexNamespaces.push_back( idx.indexNamespace() );
+                    }
+                }
+                else {
+                    BSONObjIterator i( indexes.embeddedObject() );
+                    while ( i.more() ) {
+                        BSONElement e = i.next();
+                        int idxNo = -1;
+                        if ( e.type() == String )
+                            idxNo = nsd->findIndexByName( e.valuestr() );
+                        else if ( e.type() == Object )
+                            idxNo = nsd->findIndexByKeyPattern( e.embeddedObject() );
+                        if ( idxNo < 0 ) {
+                            errmsg = str::stream() << "index not found: " << e.toString( false );
+                            return false;
+                        }
+                        IndexDetails& idx = nsd->idx( idxNo );
+                        indexNames.push_back( idx.indexName() );
+                        indexNamespaces.push_back( idx.indexNamespace() );
                     }
                 }
-                for ( std::vector<std::string>::const_iterator it = indexes.begin(); 
-                      it != indexes.end(); 
-                      it++ ) {
-                    touchNs( *it );
+            }
+
+            if ( cmdObj.hasField( "min" ) || cmdObj.hasField( "max" ) ) {
+                if ( indexes.eoo() || indexNames.size() != 1 ) {
+                    errmsg = "min and max need exactly one index in indexes";
+                    return false;
                 }
+                log() << "touching index " << indexNames[0] << " of " << ns << " from "
+                      << cmdObj.getObjectField( "min" ) << " to " << cmdObj.getObjectField( "max" )
+                      << endl;
+                const long long keys = touchIndexRange( ns, indexNames[0],
+                                                        cmdObj.getObjectField( "min" ),
+                                                        cmdObj.getObjectField( "max" ),
+                                                        touch_data );
+                result.appendNumber( "keysTouched", keys );
+                return true;
             }
+
+            std::vector<std::string> namespaces( indexNamespaces );
+            if (touch_data) {
+                namespaces.push_back( ns );
+            }
+            if ( namespaces.empty() ) {
+                return true;
+            }
+
+            log() << "touching namespace " << ns << endl;
+            const long long bytes = touchNamespaces( namespaces, threads );
+            log() << "touching namespace " << ns << " complete" << endl;
+            result.appendNumber( "bytesTouched", bytes );
             return true;
         }
         
@@ -71,7 +71,13 @@ namespace mongo {
     bool WriteBatchExecutor::applyWriteBatch(const WriteBatch& writeBatch,
                                              BSONArrayBuilder* resultsArray) {
         bool batchSuccess = true;
-        for (size_t i = 0; i < writeBatch.getNumWriteItems(); ++i) {
+
+        size_t i = 0;
+        if (WriteBatch::WRITE_INSERT == writeBatch.getWriteType()) {
+            i = applyInsertBatch(writeBatch, resultsArray);
+        }
+
+        for (; i < writeBatch.getNumWriteItems(); ++i) {
             const WriteBatch::WriteItem& writeItem = writeBatch.getWriteItem(i);
 
             // All writes in the batch must be of the same type:
@@ -108,8 +114,91 @@ namespace mongo {
             return 0;
         }
 
+        // Records stats for a finished child operation, and logs and profiles it as needed.
+        // Helper for WriteBatchExecutor::applyWriteItem() and applyInsertBatch().
+        void finishChildOp(Client* client, CurOp* childOp, int opCode) {
+            OpDebug& opDebug = childOp->debug();
+            opDebug.executionTime = childOp->totalTimeMillis();
+            opDebug.recordStats();
+
+            // Log operation if running with at least "-v", or if exceeds slow threshold.
+            if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))
+                || opDebug.executionTime > cmdLine.slowMS + childOp->getExpectedLatencyMs()) {
+
+                MONGO_TLOG(1) << opDebug.report(*childOp) << endl;
+            }
+
+            // TODO Log operation if logLevel >= 3 and assertion thrown (as assembleResponse()
+            // does).
+
+            // Save operation to system.profile if shouldDBProfile().
+            if (childOp->shouldDBProfile(opDebug.executionTime)) {
+                profile(*client, opCode, *childOp);
+            }
+        }
+
     } // namespace
 
+    size_t WriteBatchExecutor::applyInsertBatch(const WriteBatch& writeBatch,
+                                                BSONArrayBuilder* resultsArray) {
+        const string& ns = writeBatch.getNS();
+
+        vector<BSONObj> docs(writeBatch.getNumWriteItems());
+        for (size_t i = 0; i < docs.size(); ++i) {
+            string errMsg;
+            bool ret = writeBatch.getWriteItem(i).parseInsertItem(&errMsg, &docs[i]);
+            verify(ret); // writeItem should have been already validated by WriteBatch::parse().
+        }
+
+        size_t numInserted = 0;
+        uint64_t batchTimeMicros = 0;
+
+        PageFaultRetryableSection s;
+        while (true) {
+            try {
+                CurOp childOp(_client, _client->curop());
+                childOp.reset(_client->getRemote(), dbInsert);
+
+                childOp.ensureStarted();
+                OpDebug& opDebug = childOp.debug();
+                opDebug.ns = ns;
+                opDebug.op = dbInsert;
+                {
+                    Client::WriteContext ctx(ns);
+                    numInserted = checkAndInsertBatch(ns.c_str(), docs);
+                    getDur().commitIfNeeded();
+                }
+                childOp.done();
+                batchTimeMicros = childOp.totalTimeMicros();
+                opDebug.ninserted = numInserted;
+
+                // Nothing to report if the batch didn't apply.
+                if (numInserted > 0) {
+                    finishChildOp(_client, &childOp, dbInsert);
+                }
+                break;
+            }
+            catch (PageFaultException& e) {
+                e.touch();
+            }
+        }
+
+        // The same result each item would have had on its own, with the time shared out.
+        for (size_t i = 0; i < numInserted; ++i) {
+            _opCounters->gotInsert();
+            _le->reset(true);
+            _le->nObjects = 1; // TODO Replace after implementing LastError::recordInsert().
+
+            BSONObjBuilder results;
+            results.append("ok", true);
+            _le->appendSelf(results, false);
+            results.append("micros", static_cast<long long>(batchTimeMicros / numInserted));
+            resultsArray->append(results.obj());
+        }
+
+        return numInserted;
+    }
+
     bool WriteBatchExecutor::applyWriteItem(const string& ns,
                                             const WriteBatch::WriteItem& writeItem,
                                             BSONObjBuilder* results) {
@@ -153,23 +242,7 @@ namespace mongo {
                 childOp.done();
                 itemTimeMicros = childOp.totalTimeMicros();
 
-                opDebug.executionTime = childOp.totalTimeMillis();
-                opDebug.recordStats();
-
-                // Log operation if running with at least "-v", or if exceeds slow threshold.
-                if (logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))
-                    || opDebug.executionTime > cmdLine.slowMS + childOp.getExpectedLatencyMs()) {
-
-                    MONGO_TLOG(1) << opDebug.report(childOp) << endl;
-                }
-
-                // TODO Log operation if logLevel >= 3 and assertion thrown (as assembleResponse()
-                // does).
-
-                // Save operation to system.profile if shouldDBProfile().
-                if (childOp.shouldDBProfile(opDebug.executionTime)) {
-                    profile(*_client, getOpCode(writeItem.getWriteType()), childOp);
-                }
+                finishChildOp(_client, &childOp, getOpCode(writeItem.getWriteType()));
                 break;
             }
             catch (PageFaultException& e) {
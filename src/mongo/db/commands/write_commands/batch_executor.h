@@ -52,6 +52,14 @@ namespace mongo {
          */
         bool applyWriteBatch(const WriteBatch& writeBatch, BSONArrayBuilder* resultsArray);
 
+        /**
+         * Inserts as many documents from the front of an insert batch as will go in together,
+         * indexing them a whole index at a time (see checkAndInsertBatch()).  Fills
+         * "resultsArray" with a result for each.  Returns the number inserted, which may be 0.
+         * The remaining items are left for applyWriteItem().
+         */
+        size_t applyInsertBatch(const WriteBatch& writeBatch, BSONArrayBuilder* resultsArray);
+
         /**
          * Issues a single write.  Fills "results" with write result.
          * Returns true iff write item was issued sucessfully.
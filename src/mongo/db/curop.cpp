@@ -17,6 +17,7 @@
 #include "mongo/pch.h"
 
 #include "mongo/base/counter.h"
+#include "mongo/base/init.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/database.h"
@@ -24,6 +25,19 @@
 
 namespace mongo {
 
+    namespace {
+        OpMemoryAccount* currentOpMemory() {
+            Client* c = currentClient.get();
+            CurOp* op = c ? c->curop() : NULL;
+            return op ? &op->memory() : NULL;
+        }
+    }
+
+    MONGO_INITIALIZER(CurOpMemoryAccounts)(InitializerContext*) {
+        OpMemoryAccount::setCurrentGetter( currentOpMemory );
+        return Status::OK();
+    }
+
     // todo : move more here
 
     CurOp::CurOp( Client * client , CurOp * wrapped ) :
@@ -35,12 +49,15 @@ namespace mongo {
         _start = 0;
         _active = false;
         _reset();
+        _maxTimeDeadline = _wrapped ? _wrapped->_maxTimeDeadline : 0;
         _op = 0;
         _opNum = _nextOpNum++;
         // These addresses should never be written to again.  The zeroes are
         // placed here as a precaution because currentOp may be accessed
         // without the db mutex.
         memset(_ns, 0, sizeof(_ns));
+        if ( _wrapped )
+            _publish();
     }
 
     void CurOp::_reset() {
@@ -55,16 +72,76 @@ namespace mongo {
         _numYields = 0;
         _expectedLatencyMs = 0;
         _lockStat.reset();
+        _memory.reset();
     }
 
     void CurOp::reset() {
         _reset();
+        // nested ops, as of a DBDirectClient, are bound by the time limit of the op around them
+        _maxTimeDeadline = _wrapped ? _wrapped->_maxTimeDeadline : 0;
         _start = 0;
         _opNum = _nextOpNum++;
         _ns[0] = 0;
         _debug.reset();
         _query.reset();
         _active = true; // this should be last for ui clarity
+        _publish();
+    }
+
+    ClientSlot* CurOp::_publishSlot() const {
+        if ( !_client || _client->_curOp != this )
+            return NULL;
+        return _client->registrySlot();
+    }
+
+    void CurOp::_fillStatus( OpStatus* status ) const {
+        BOOST_STATIC_ASSERT( sizeof( status->query ) == CachedBSONObj::BufSize );
+        BOOST_STATIC_ASSERT( sizeof( status->ns ) == sizeof( _ns ) );
+
+        status->opNum = _opNum;
+        status->active = _active;
+        status->suppressFromCurop = _suppressFromCurop;
+        status->op = _op;
+        status->startMicros = _start;
+        status->numYields = _numYields;
+        memcpy( status->ns, _ns, sizeof( _ns ) );
+        status->querySize = _query.copyRaw( status->query );
+        if ( _message.empty() )
+            status->message[0] = 0;
+        else
+            OpStatus::copyString( status->message, sizeof( status->message ),
+                                  _message.toString() );
+        status->progressActive = _progressMeter.isActive();
+        if ( status->progressActive )
+            OpStatus::copyString( status->progressName, sizeof( status->progressName ),
+                                  _progressMeter.getName() );
+        status->progressDone = _progressMeter.done();
+        status->progressTotal = _progressMeter.total();
+        status->lockStat = _lockStat;
+        status->memoryBytes = _memory.bytes();
+        status->memoryPeakBytes = _memory.peakBytes();
+    }
+
+    void CurOp::_publish() {
+        ClientSlot* slot = _publishSlot();
+        if ( !slot )
+            return;
+        slot->beginWrite();
+        _fillStatus( &slot->status() );
+        slot->endWrite();
+    }
+
+    void CurOp::_publishRemote() {
+        ClientSlot* slot = _publishSlot();
+        if ( !slot )
+            return;
+        slot->beginWrite();
+        OpStatus& status = slot->status();
+        if ( _remote.empty() )
+            status.remote[0] = 0;
+        else
+            OpStatus::copyString( status.remote, sizeof( status.remote ), _remote.toString() );
+        slot->endWrite();
     }
 
     CurOp* CurOp::getOp(const BSONObj& criteria) {
@@ -110,8 +187,15 @@ namespace mongo {
         if( _remote != remote ) {
             // todo : _remote is not thread safe yet is used as such!
             _remote = remote;
+            _publishRemote();
         }
         _op = op;
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            slot->status().op = op;
+            slot->endWrite();
+        }
     }
 
     ProgressMeter& CurOp::setMessage(const char * msg,
@@ -130,6 +214,7 @@ namespace mongo {
             _progressMeter.finished();
         }
         _message = msg;
+        _publish();
         return _progressMeter;
     }
 
@@ -137,15 +222,26 @@ namespace mongo {
         killCurrentOp.notifyAllWaiters();
 
         if ( _wrapped ) {
-            scoped_lock bl(Client::clientsMutex);
-            _client->_curOp = _wrapped;
+            {
+                scoped_lock bl(Client::clientsMutex);
+                _client->_curOp = _wrapped;
+            }
+            _wrapped->_publish();
+            _wrapped->_publishRemote();
         }
         _client = 0;
     }
 
     void CurOp::ensureStarted() {
-        if ( _start == 0 )
-            _start = curTimeMicros64();
+        if ( _start != 0 )
+            return;
+        _start = curTimeMicros64();
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            slot->status().startMicros = _start;
+            slot->endWrite();
+        }
     }
 
     void CurOp::enter( Client::Context * context ) {
@@ -154,74 +250,173 @@ namespace mongo {
         strncpy( _ns, context->ns(), Namespace::MaxNsLen);
         _ns[Namespace::MaxNsLen] = 0;
 
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            memcpy( slot->status().ns, _ns, sizeof( _ns ) );
+            slot->endWrite();
+        }
+
+        // before the op runs, so that an op dropping the collection doesn't bring it back
+        Top::global.resolve( _ns , &_topHandle );
+
         _dbprofile = std::max( context->_db ? context->_db->getProfilingLevel() : 0 , _dbprofile );
     }
 
     void CurOp::leave( Client::Context * context ) {
     }
 
+    void CurOp::done() {
+        _active = false;
+        _end = curTimeMicros64();
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            slot->status().active = false;
+            slot->status().lockStat = _lockStat;
+            slot->endWrite();
+        }
+    }
+
+    void CurOp::setQuery( const BSONObj& query ) {
+        _query.set( query );
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            OpStatus& status = slot->status();
+            status.querySize = _query.copyRaw( status.query );
+            slot->endWrite();
+        }
+    }
+
+    void CurOp::yielded() {
+        _numYields++;
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            slot->status().numYields = _numYields;
+            slot->status().lockStat = _lockStat;
+            slot->endWrite();
+        }
+    }
+
+    void CurOp::suppressFromCurop() {
+        _suppressFromCurop = true;
+
+        if ( ClientSlot* slot = _publishSlot() ) {
+            slot->beginWrite();
+            slot->status().suppressFromCurop = true;
+            slot->endWrite();
+        }
+    }
+
+    void CurOp::publishProgress() {
+        const bool progress = _progressMeter.isActive();
+        if ( !progress && _memory.peakBytes() == 0 )
+            return;
+        ClientSlot* slot = _publishSlot();
+        if ( !slot )
+            return;
+        OpStatus& status = slot->status();
+        if ( ( !progress || status.progressDone == _progressMeter.done() ) &&
+             status.memoryBytes == _memory.bytes() &&
+             status.memoryPeakBytes == _memory.peakBytes() )
+            return;
+        slot->beginWrite();
+        if ( progress ) {
+            status.progressDone = _progressMeter.done();
+            status.progressTotal = _progressMeter.total();
+        }
+        status.memoryBytes = _memory.bytes();
+        status.memoryPeakBytes = _memory.peakBytes();
+        slot->endWrite();
+    }
+
     void CurOp::recordGlobalTime( long long micros ) const {
         if ( _client ) {
             const LockState& ls = _client->lockState();
             verify( ls.threadState() );
-            Top::global.record( _ns , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros , _command );
+            Top::global.record( _topHandle , _op , ls.hasAnyWriteLock() ? 1 : -1 , micros ,
+                                _command );
         }
     }
 
     BSONObj CurOp::info() {
+        OpStatus status;
+        if ( _client ) {
+            OpStatus::copyString( status.desc, sizeof( status.desc ), _client->desc() );
+            OpStatus::copyString( status.threadId, sizeof( status.threadId ),
+                                  _client->_threadId );
+            status.connectionId = _client->_connectionId;
+        }
+        if( !_remote.empty() ) {
+            OpStatus::copyString( status.remote, sizeof( status.remote ), _remote.toString() );
+        }
+        _fillStatus( &status );
+        return info( status, _client ? &_client->_ls : NULL, killPending() );
+    }
+
+    BSONObj CurOp::info( const OpStatus& status, LockState* ls, bool killPending ) {
         BSONObjBuilder b;
-        b.append("opid", _opNum);
-        bool a = _active && _start;
+        b.append("opid", status.opNum);
+        bool a = status.active && status.startMicros;
         b.append("active", a);
 
         if( a ) {
-            b.append("secs_running", elapsedSeconds() );
+            const unsigned long long now = curTimeMicros64();
+            const unsigned long long start = status.startMicros;
+            b.append("secs_running", now > start ? (int)( ( now - start ) / 1000000 ) : 0 );
         }
 
-        b.append( "op" , opToString( _op ) );
+        b.append( "op" , opToString( status.op ) );
 
-        b.append("ns", _ns);
+        b.append("ns", status.ns);
 
-        if (_op == dbInsert) {
-            _query.append(b, "insert");
-        }
-        else {
-            _query.append(b , "query");
-        }
+        BSONObj query = CachedBSONObj::fromRaw( status.querySize, status.query );
+        b.append( status.op == dbInsert ? "insert" : "query" , query );
 
-        if( !_remote.empty() ) {
-            b.append("client", _remote.toString());
+        if( status.remote[0] ) {
+            b.append("client", status.remote);
         }
 
-        if ( _client ) {
-            b.append( "desc" , _client->desc() );
-            if ( _client->_threadId.size() )
-                b.append( "threadId" , _client->_threadId );
-            if ( _client->_connectionId )
-                b.appendNumber( "connectionId" , _client->_connectionId );
-            _client->_ls.reportState(b);
+        if ( ls ) {
+            b.append( "desc" , status.desc );
+            if ( status.threadId[0] )
+                b.append( "threadId" , status.threadId );
+            if ( status.connectionId )
+                b.appendNumber( "connectionId" , status.connectionId );
+            ls->reportState(b);
         }
 
-        if ( ! _message.empty() ) {
-            if ( _progressMeter.isActive() ) {
+        if ( status.message[0] ) {
+            if ( status.progressActive ) {
                 StringBuilder buf;
-                buf << _message.toString() << " " << _progressMeter.toString();
+                buf << status.message << " " << status.progressName << ": "
+                    << status.progressDone << '/' << status.progressTotal << ' '
+                    << ( status.progressTotal ?
+                         ( status.progressDone * 100 ) / status.progressTotal : 0 ) << '%';
                 b.append( "msg" , buf.str() );
                 BSONObjBuilder sub( b.subobjStart( "progress" ) );
-                sub.appendNumber( "done" , (long long)_progressMeter.done() );
-                sub.appendNumber( "total" , (long long)_progressMeter.total() );
+                sub.appendNumber( "done" , (long long)status.progressDone );
+                sub.appendNumber( "total" , (long long)status.progressTotal );
                 sub.done();
             }
             else {
-                b.append( "msg" , _message.toString() );
+                b.append( "msg" , status.message );
             }
         }
 
-        if( killPending() )
+        if( killPending )
             b.append("killPending", true);
 
-        b.append( "numYields" , _numYields );
-        b.append( "lockStats" , _lockStat.report() );
+        b.append( "numYields" , status.numYields );
+        b.append( "lockStats" , status.lockStat.report() );
+
+        if ( status.memoryPeakBytes ) {
+            BSONObjBuilder sub( b.subobjStart( "memory" ) );
+            sub.appendNumber( "bytes" , status.memoryBytes );
+            sub.appendNumber( "peakBytes" , status.memoryPeakBytes );
+            sub.done();
+        }
 
         return b.obj();
     }
@@ -251,6 +446,9 @@ namespace mongo {
 
     void CurOp::kill(bool* pNotifyFlag /* = NULL */) {
         _killPending.store(1);
+        if ( _client ) {
+            _client->registrySlot()->noteKillPending( _opNum );
+        }
         if (pNotifyFlag) {
             _notifyList.push_back(pNotifyFlag);
         }
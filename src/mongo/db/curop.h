@@ -23,6 +23,9 @@
 
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/client.h"
+#include "mongo/db/client_registry.h"
+#include "mongo/db/memory_tracker.h"
+#include "mongo/db/stats/top.h"
 #include "mongo/db/storage/namespace.h"
 #include "mongo/util/concurrency/spin_lock.h"
 #include "mongo/util/net/hostandport.h"
@@ -106,6 +109,7 @@ namespace mongo {
     class CachedBSONObj {
     public:
         enum { TOO_BIG_SENTINEL = 1 } ;
+        enum { BufSize = 512 };
         static BSONObj _tooBig; // { $msg : "query not recording (too large)" }
 
         CachedBSONObj() {
@@ -144,6 +148,27 @@ namespace mongo {
             b.append( name , temp );
         }
 
+        /**
+         * Copies the buffer as is, for turning back into a BSONObj later with fromRaw().
+         * @return the size, as size() would
+         */
+        int copyRaw( char* buf ) const {
+            scoped_spinlock lk(_lock);
+            const int sz = size();
+            if ( sz > TOO_BIG_SENTINEL )
+                memcpy( buf, _buf, sz );
+            return sz;
+        }
+
+        /** @return an owned copy of what copyRaw() copied */
+        static BSONObj fromRaw( int sz, const char* buf ) {
+            if ( sz == 0 )
+                return BSONObj();
+            if ( sz == TOO_BIG_SENTINEL )
+                return _tooBig;
+            return BSONObj( buf ).copy();
+        }
+
     private:
         /** you have to be locked when you call this */
         BSONObj _get() const {
@@ -160,7 +185,7 @@ namespace mongo {
 
         mutable SpinLock _lock;
         int * _size;
-        char _buf[512];
+        char _buf[BufSize];
     };
 
     /* Current operation (for the current Client).
@@ -204,10 +229,7 @@ namespace mongo {
             ensureStarted();
             return _start;
         }
-        void done() {
-            _active = false;
-            _end = curTimeMicros64();
-        }
+        void done();
         unsigned long long totalTimeMicros() {
             massert( 12601 , "CurOp not marked done yet" , ! _active );
             return _end - startTime();
@@ -218,11 +240,18 @@ namespace mongo {
             return (int) (total / 1000);
         }
         int elapsedSeconds() { return elapsedMillis() / 1000; }
-        void setQuery(const BSONObj& query) { _query.set( query ); }
+        void setQuery(const BSONObj& query);
         Client * getClient() const { return _client; }
 
         BSONObj info();
 
+        /**
+         * Formats what currentOp shows of an operation, as info() does, from a status
+         * copied from the client registry.
+         * @param ls the lock state of the client, if there is one
+         */
+        static BSONObj info( const OpStatus& status, LockState* ls, bool killPending );
+
         // Fetches less information than "info()"; used to search for ops with certain criteria
         BSONObj description();
 
@@ -237,9 +266,31 @@ namespace mongo {
         void kill(bool* pNotifyFlag = NULL); 
         bool killPendingStrict() const { return _killPending.load(); }
         bool killPending() const { return _killPending.loadRelaxed(); }
-        void yielded() { _numYields++; }
+
+        /**
+         * Interrupts this op, and ops it starts, once 'micros' from now have passed, as maxTimeMS
+         * asks.  The limit is enforced wherever kills are checked for.
+         */
+        void setMaxTimeMicros( unsigned long long micros ) {
+            _maxTimeDeadline = curTimeMicros64() + micros;
+        }
+        bool hasMaxTime() const { return _maxTimeDeadline != 0; }
+        bool maxTimeHasExpired() const {
+            return _maxTimeDeadline != 0 && curTimeMicros64() >= _maxTimeDeadline;
+        }
+        void yielded();
         int numYields() const { return _numYields; }
-        void suppressFromCurop() { _suppressFromCurop = true; }
+
+        /** the memory this op's big buffers hold, as MemoryCharges note it */
+        OpMemoryAccount& memory() { return _memory; }
+        void suppressFromCurop();
+
+        /**
+         * Publishes how far the progress meter has got, and the memory the op holds, to the
+         * client registry.  Both change in too many places to do this on each change, so
+         * currentOp shows them as of the last interrupt check.
+         */
+        void publishProgress();
         
         long long getExpectedLatencyMs() const { return _expectedLatencyMs; }
         void setExpectedLatencyMs( long long latency ) { _expectedLatencyMs = latency; }
@@ -263,6 +314,19 @@ namespace mongo {
         friend class Client;
         void _reset();
 
+        /**
+         * @return the client's registry slot, if this is the client's current op.  Only the
+         *     client's thread may write to it.
+         */
+        ClientSlot* _publishSlot() const;
+
+        /** copies all of this op to the client registry */
+        void _publish();
+        void _publishRemote();
+
+        /** fills 'status' with this op, leaving the client's fields as they are */
+        void _fillStatus( OpStatus* status ) const;
+
         static AtomicUInt _nextOpNum;
         Client * _client;
         CurOp * _wrapped;
@@ -281,8 +345,12 @@ namespace mongo {
         ThreadSafeString _message;
         ProgressMeter _progressMeter;
         AtomicInt32 _killPending;
+        unsigned long long _maxTimeDeadline; // curTimeMicros64() to interrupt at, or 0
+        OpMemoryAccount _memory;
         int _numYields;
         LockStat _lockStat;
+        // the Top counters of _ns, kept across reset() as the next op is likely on it too
+        Top::Handle _topHandle;
         // _notifyList is protected by the global killCurrentOp's mtx.
         std::vector<bool*> _notifyList;
         
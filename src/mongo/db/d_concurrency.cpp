@@ -44,6 +44,7 @@
 
 #define MONGOD_CONCURRENCY_LEVEL_GLOBAL 0
 #define MONGOD_CONCURRENCY_LEVEL_DB 1
+#define MONGOD_CONCURRENCY_LEVEL_COLLECTION 2
 
 #ifndef MONGOD_CONCURRENCY_LEVEL
 #define MONGOD_CONCURRENCY_LEVEL MONGOD_CONCURRENCY_LEVEL_DB
@@ -52,6 +53,7 @@
 namespace mongo { 
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
+    static const bool COLLECTION_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_COLLECTION );
 
     inline LockState& lockState() { 
         return cc().lockState();
@@ -88,6 +90,11 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* ns->lock for the collection tier, which sits beneath the db locks.  same lifetime rules
+       as dblocks: a dropped collection's lock lingers (and is reused if it is recreated).
+    */
+    static DBLocksMap collectionlocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -191,6 +198,8 @@ namespace mongo {
         bool w_to_X() { return q.w_to_X(); }
         void X_to_w() { q.X_to_w(); }
 
+        QLock::WaitStats waitStats(char mode) { return q.waitStats(mode); }
+
     private:
         void _unlock_R() {
             wassert( threadState() == 'R' );
@@ -263,6 +272,9 @@ namespace mongo {
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLevelLockingEnabled() {
+        return COLLECTION_LEVEL_LOCKING_ENABLED;
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
@@ -732,6 +744,67 @@ namespace mongo {
         _weLocked = ls.otherLock();
     }
 
+    Lock::CollectionWrite::CollectionWrite( const StringData& ns )
+        : DBWrite( ns ), _ns( ns.toString() ), _collLocked( 0 ) {
+        lockCollection();
+    }
+
+    Lock::CollectionWrite::~CollectionWrite() {
+        unlockCollection();
+    }
+
+    void Lock::CollectionWrite::_tempRelease() {
+        unlockCollection();
+        DBWrite::_tempRelease();
+    }
+
+    void Lock::CollectionWrite::_relock() {
+        DBWrite::_relock();
+        lockCollection();
+    }
+
+    void Lock::CollectionWrite::lockCollection() {
+        if ( !COLLECTION_LEVEL_LOCKING_ENABLED )
+            return;
+
+        LockState& ls = lockState();
+        if( ls.isW() )
+            return;
+        if( ls.collectionCount() ) {
+            // nested.  the db lock we hold is exclusive so whichever collection the outer lock
+            // is on, we are already protected.
+            return;
+        }
+
+        if( _ns != ls.collectionName() ) {
+            DBLocksMap::ref r(collectionlocks);
+            WrapperForRWLock*& lock = r[_ns];
+            if( lock == 0 )
+                lock = new WrapperForRWLock(_ns);
+            ls.lockedCollection( _ns , lock );
+        }
+        else {
+            DEV OCCASIONALLY { dassert( collectionlocks.get(_ns) == ls.collectionLock() ); }
+            ls.lockedCollection();
+        }
+
+        fassert(16982,_collLocked==0);
+        Timer t;
+        ls.collectionLock()->lock();
+        _collLocked = ls.collectionLock();
+        _collLocked->stats.recordAcquireTimeMicros( 'w' , t.micros() );
+        _collTimer.reset();
+    }
+
+    void Lock::CollectionWrite::unlockCollection() {
+        if( !_collLocked )
+            return;
+        _collLocked->stats.recordLockTimeMicros( 'w' , _collTimer.micros() );
+        lockState().unlockedCollection();
+        _collLocked->unlock();
+        _collLocked = 0;
+    }
+
     Lock::DBWrite::UpgradeToExclusive::UpgradeToExclusive() {
         fassert( 16187, lockState().threadState() == 'w' );
 
@@ -835,6 +908,22 @@ namespace mongo {
                 ttt.done();
             }
 
+            {
+                BSONObjBuilder ttt( t.subobjStart( "waits" ) );
+                const char modes[] = "rwRW";
+                for ( int i = 0; i < 4; i++ ) {
+                    const QLock::WaitStats stats = qlk.waitStats( modes[i] );
+                    BSONObjBuilder m( ttt.subobjStart( string( 1, modes[i] ) ) );
+                    m.append( "acquisitions" , stats.acquisitions );
+                    m.append( "waits" , stats.waits );
+                    m.append( "spinAcquisitions" , stats.spinAcquisitions );
+                    m.append( "waitMicros" , stats.waitMicros );
+                    m.append( "maxWaitMicros" , stats.maxWaitMicros );
+                    m.done();
+                }
+                ttt.done();
+            }
+
             return t.obj();
         }
 
@@ -859,6 +948,13 @@ namespace mongo {
                     b.append(i->first, i->second->stats.report());
                 }
             }
+            if ( COLLECTION_LEVEL_LOCKING_ENABLED ) {
+                // keyed by full ns, which can't collide with a db name as those have no '.'
+                DBLocksMap::ref r(collectionlocks);
+                for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                    b.append(i->first, i->second->stats.report());
+                }
+            }
             return b.obj();
         }
 
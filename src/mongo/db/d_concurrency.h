@@ -49,6 +49,7 @@ namespace mongo {
         static void assertWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+        static bool collectionLevelLockingEnabled();
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
@@ -193,6 +194,32 @@ namespace mongo {
             bool _nested;
         };
 
+        /**
+         * lock a single collection for writing.  the database is locked exactly as DBWrite
+         * does; when collection level locking is enabled a per collection lock is then taken
+         * beneath it.  asking for a collection lock while already holding one (or W) is a noop.
+         *
+         * note the db lock stays exclusive for now: extents, the freelist and the .ns file are
+         * shared by all collections of a database and are not yet safe for concurrent writers.
+         */
+        class CollectionWrite : public DBWrite {
+            void lockCollection();
+            void unlockCollection();
+
+        protected:
+            void _tempRelease();
+            void _relock();
+
+        public:
+            CollectionWrite(const StringData& ns);
+            virtual ~CollectionWrite();
+
+        private:
+            const string _ns;
+            WrapperForRWLock *_collLocked;
+            Timer _collTimer;
+        };
+
         // lock this database for reading. do not shared_lock globally first, that is handledin herein. 
         class DBRead : public ScopedLock {
             void lockTop(LockState&);
@@ -29,9 +29,12 @@
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // Off by default.  Databases keep any index files they already have either way.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(separateIndexFiles, bool, false);
 
     Database::~Database() {
         verify( Lock::isW() );
@@ -279,6 +282,9 @@ namespace mongo {
 
         sizeNeeded = ExtentManager::quantizeExtentSize( sizeNeeded );
 
+        if ( separateIndexFiles && !NamespaceString::normal( ns ) )
+            return suitableIndexFile( sizeNeeded, preallocate );
+
         // check existing files
         for ( int i=numFiles()-1; i>=0; i-- ) {
             DataFile* f = getFile( i );
@@ -315,6 +321,29 @@ namespace mongo {
         return 0;
     }
 
+    DataFile* Database::suitableIndexFile( int sizeNeeded, bool preallocate ) {
+        // no quota here, it isn't enforced on index namespaces anyway
+        const int numIndexFiles = _extentManager.numIndexFiles();
+        for ( int i = numIndexFiles - 1; i >= 0; i-- ) {
+            DataFile* f = getFile( ExtentManager::kIndexFileBase + i );
+            if ( f->getHeader()->unusedLength >= sizeNeeded )
+                return f;
+        }
+
+        for ( int i = 0; i < 8; i++ ) {
+            DataFile* f = _extentManager.addAnIndexFile( sizeNeeded, preallocate );
+
+            if ( f->getHeader()->unusedLength >= sizeNeeded )
+                return f;
+
+            if ( f->getHeader()->fileLength >= DataFile::maxSize() )
+                return f;
+        }
+
+        uasserted(17005, "couldn't allocate space (suitableIndexFile)");
+        return 0;
+    }
+
     Extent* Database::allocExtent( const char *ns, int size, bool capped, bool enforceQuota ) {
         // todo: when profiling, these may be worth logging into profile collection
         bool fromFreeList = true;
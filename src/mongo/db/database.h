@@ -29,6 +29,9 @@ namespace mongo {
     class Extent;
     class DataFile;
 
+    // whether new index extents go in the index/<db>.idx.# files instead of the data files
+    extern bool separateIndexFiles;
+
     /**
      * Database represents a database database
      * Each database database has its own set of files -- dbname.ns, dbname.0, dbname.1, ...
@@ -81,6 +84,9 @@ namespace mongo {
          */
         void preallocateAFile() { _extentManager.preallocateAFile(); }
 
+        /**
+         * With separateIndexFiles on, extents for index namespaces come from the index files.
+         */
         DataFile* suitableFile( const char *ns, int sizeNeeded, bool preallocate, bool enforceQuota );
 
         Extent* allocExtent( const char *ns, int size, bool capped, bool enforceQuota );
@@ -137,6 +143,8 @@ namespace mongo {
 
         void openAllFiles();
 
+        DataFile* suitableIndexFile( int sizeNeeded, bool preallocate );
+
         /**
          * throws exception if error encounted
          * @return true if the file was opened
@@ -25,13 +25,13 @@
 namespace mongo {
 
     Database* DatabaseHolder::getOrCreate( const string& ns, const string& path, bool& justCreated ) {
-        string dbname = _todb( ns );
+        const string dbname = _todb( ns ).toString();
         {
             SimpleMutex::scoped_lock lk(_m);
             Lock::assertAtLeastReadLocked(ns);
             DBs& m = _paths[path];
             {
-                DBs::iterator i = m.find(dbname);
+                DBs::const_iterator i = m.find(dbname);
                 if( i != m.end() ) {
                     justCreated = false;
                     return i->second;
@@ -20,6 +20,7 @@
 
 #include "mongo/db/database.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo { 
 
@@ -27,9 +28,8 @@ namespace mongo {
      * path + dbname -> Database
      */
     class DatabaseHolder {
-        typedef map<string,Database*> DBs;
-        typedef map<string,DBs> Paths;
-        // todo: we want something faster than this if called a lot:
+        typedef StringMap<Database*> DBs;
+        typedef map<string,DBs> Paths; // there is hardly ever more than the one dbpath
         mutable SimpleMutex _m;
         Paths _paths;
         int _size;
@@ -42,11 +42,7 @@ namespace mongo {
             if ( x == _paths.end() )
                 return false;
             const DBs& m = x->second;
-
-            string db = _todb( ns );
-
-            DBs::const_iterator it = m.find(db);
-            return it != m.end();
+            return m.find( _todb( ns ) ) != m.end();
         }
         // must be write locked as otherwise isLoaded could go false->true on you 
         // in the background and you might not expect that.
@@ -62,8 +58,7 @@ namespace mongo {
             if ( x == _paths.end() )
                 return 0;
             const DBs& m = x->second;
-            string db = _todb( ns );
-            DBs::const_iterator it = m.find(db);
+            DBs::const_iterator it = m.find( _todb( ns ) );
             if ( it != m.end() )
                 return it->second;
             return 0;
@@ -91,7 +86,7 @@ namespace mongo {
         void getAllShortNames( set<string>& all ) const {
             SimpleMutex::scoped_lock lk(_m);
             for ( Paths::const_iterator i=_paths.begin(); i!=_paths.end(); i++ ) {
-                DBs m = i->second;
+                const DBs& m = i->second;
                 for( DBs::const_iterator j=m.begin(); j!=m.end(); j++ ) {
                     all.insert( j->first );
                 }
@@ -99,19 +94,20 @@ namespace mongo {
         }
 
     private:
-        static string _todb( const string& ns ) {
-            string d = __todb( ns );
+        // the database part of 'ns', which it points into
+        static StringData _todb( const string& ns ) {
+            StringData d = __todb( ns );
             uassert( 13280 , (string)"invalid db name: " + ns , NamespaceString::validDBName( d ) );
             return d;
         }
-        static string __todb( const string& ns ) {
+        static StringData __todb( const string& ns ) {
             size_t i = ns.find( '.' );
             if ( i == string::npos ) {
                 uassert( 13074 , "db name can't be empty" , ns.size() );
                 return ns;
             }
             uassert( 13075 , "db name can't be empty" , i > 0 );
-            return ns.substr( 0 , i );
+            return StringData( ns ).substr( 0 , i );
         }
     };
 
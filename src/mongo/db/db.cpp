@@ -18,6 +18,7 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
@@ -35,6 +36,7 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/d_globals.h"
 #include "mongo/db/db.h"
+#include "mongo/db/defragmenter.h"
 #include "mongo/db/dbmessage.h"
 #include "mongo/db/dbwebserver.h"
 #include "mongo/db/dur.h"
@@ -46,27 +48,36 @@
 #include "mongo/db/json.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/module.h"
+#include "mongo/db/ops/query.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/range_deleter_service.h"
 #include "mongo/db/repl/repl_start.h"
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/restapi.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/db/ttl.h"
+#include "mongo/db/warm_cache.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/task.h"
 #include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/exception_filter_win32.h"
+#include "mongo/util/file.h"
 #include "mongo/util/file_allocator.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
 #include "mongo/util/ntservice.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/ramlog.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/stacktrace.h"
 #include "mongo/util/startup_test.h"
 #include "mongo/util/text.h"
@@ -233,6 +244,13 @@ namespace mongo {
                             continue; // this goes back to top loop
                         }
                     }
+                    if ( dbresponse.prepareNextNS.size() > 0 ) {
+                        // the client is busy reading what we just sent
+                        prepareNextGetMore( dbresponse.prepareNextNS.c_str(),
+                                            dbresponse.prepareNextNToReturn,
+                                            dbresponse.prepareNextCursorId,
+                                            port->remote() );
+                    }
                 }
                 break;
             }
@@ -244,8 +262,39 @@ namespace mongo {
             globalScriptEngine->threadDone();
         }
 
+        virtual bool supportsPooledService() const { return true; }
+
+        virtual ConnectionState* detachConnection( AbstractMessagingPort* p ) {
+            MongodConnectionState* s = new MongodConnectionState();
+            s->client = Client::releaseThread();
+            s->shardingInfo = ShardedConnectionInfo::release();
+            return s;
+        }
+
+        virtual void attachConnection( AbstractMessagingPort* p , ConnectionState* state ) {
+            scoped_ptr<MongodConnectionState> s( static_cast<MongodConnectionState*>( state ) );
+            s->client->adoptThread();
+            ShardedConnectionInfo::adopt( s->shardingInfo );
+            s->client = 0;
+            s->shardingInfo = 0;
+        }
+
+    private:
+        // the thread locals connected() and the sharding code set up for a connection
+        struct MongodConnectionState : public ConnectionState {
+            MongodConnectionState() : client( 0 ), shardingInfo( 0 ) {}
+            virtual ~MongodConnectionState() {
+                delete shardingInfo;
+                delete client;
+            }
+            Client* client;
+            ShardedConnectionInfo* shardingInfo;
+        };
     };
 
+    // number of threads servicing client connections; 0 means a thread per connection
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(serviceWorkerThreads, int, 0);
+
     void logStartup() {
         BSONObjBuilder toLog;
         stringstream id;
@@ -281,6 +330,7 @@ namespace mongo {
         MessageServer::Options options;
         options.port = port;
         options.ipList = cmdLine.bind_ip;
+        options.workerThreads = serviceWorkerThreads;
 
         MessageServer * server = createServer( options , new MyMessageHandler() );
         server->setAsTimeTracker();
@@ -325,71 +375,175 @@ namespace mongo {
         return repairDatabase( dbName.c_str(), errmsg );
     }
 
+    // ran at startup.
+    // Databases whose indexes are checked for pre-2.4 plugin names at once while starting up.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(startupCheckThreads, int, 8);
+
+    /**
+     * Reads the header of the first data file of 'dbName' straight from disk, without opening
+     * the database.
+     * @return false if there was none to read
+     */
+    static bool readFirstDataFileHeader( const string& dbName, DataFileHeader* h ) {
+        boost::filesystem::path p( dbpath );
+        if ( directoryperdb )
+            p /= dbName;
+        p /= ( dbName + ".0" );
+        if ( !boost::filesystem::exists( p ) )
+            return false;
+
+        File f;
+        f.open( p.string().c_str(), true );
+        if ( !f.is_open() || f.bad() || f.len() < DataFileHeader::HeaderSize )
+            return false;
+        f.read( 0, reinterpret_cast<char*>( h ), DataFileHeader::HeaderSize );
+        return !f.bad();
+    }
+
+    /**
+     * Warns about indexes of the current database that name a plugin which didn't exist
+     * before 2.4; a file from before 2.4 can have them, for 2.2 used any key pattern.
+     */
+    static void warnAboutPre24IndexPlugins() {
+        const string systemIndexes = cc().database()->name() + ".system.indexes";
+        shared_ptr<Cursor> cursor(theDataFileMgr.findAll(systemIndexes));
+        for ( ; cursor && cursor->ok(); cursor->advance()) {
+            const BSONObj index = cursor->current();
+            const BSONObj key = index.getObjectField("key");
+            const string plugin = IndexNames::findPluginName(key);
+            if (IndexNames::existedBefore24(plugin))
+                continue;
+
+            log() << "Index " << index << " claims to be of type '" << plugin << "', "
+                  << "which is either invalid or did not exist before v2.4. "
+                  << "See the upgrade section: "
+                  << "http://dochub.mongodb.org/core/upgrade-2.4"
+                  << startupWarningsLog;
+        }
+    }
+
+    /**
+     * Runs warnAboutPre24IndexPlugins() on databases of 'dbNames' until there are none left,
+     * each under its own database lock.  The first error goes into 'firstError'.
+     */
+    static void checkPre24IndexPluginsThread( const vector<string>* dbNames, AtomicUInt32* next,
+                                              SimpleMutex* errorMutex, Status* firstError ) {
+        Client::initThread( "startupIndexCheck" );
+        ON_BLOCK_EXIT_OBJ( cc(), &Client::shutdown );
+        Client::GodScope gs;
+
+        while ( true ) {
+            const unsigned i = next->fetchAndAdd( 1 );
+            if ( i >= dbNames->size() )
+                return;
+            const string& dbName = (*dbNames)[i];
+            LOG(1) << "\t" << dbName << endl;
+            try {
+                Lock::DBWrite lk( dbName ); // opening a database needs a write lock
+                Client::Context ctx( dbName );
+                warnAboutPre24IndexPlugins();
+            }
+            catch ( const DBException& e ) {
+                SimpleMutex::scoped_lock lk( *errorMutex );
+                if ( firstError->isOK() )
+                    *firstError = e.toStatus();
+                return;
+            }
+        }
+    }
+
     // ran at startup.
     static void repairDatabasesAndCheckVersion() {
         //        LastError * le = lastError.get( true );
         Client::GodScope gs;
         LOG(1) << "enter repairDatabases (to check pdfile version #)" << endl;
 
-        Lock::GlobalWrite lk;
         vector< string > dbNames;
         getDatabaseNames( dbNames );
-        for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
-            string dbName = *i;
-            LOG(1) << "\t" << dbName << endl;
-            Client::Context ctx( dbName );
-            DataFile *p = cc().database()->getFile( 0 );
-            DataFileHeader *h = p->getHeader();
-            if ( !h->isCurrentVersion() || forceRepair ) {
-
-                if( h->version <= 0 ) {
-                    uasserted(14026,
-                      str::stream() << "db " << dbName << " appears corrupt pdfile version: " << h->version
-                                    << " info: " << h->versionMinor << ' ' << h->fileLength);
+
+        // Most databases are at the current version and only need their first data file header
+        // read.  Those from before 2.4 also need their indexes checked, which is done below,
+        // several at a time; the rest are opened here, one at a time.
+        vector< string > toCheckIndexes;
+        {
+            Lock::GlobalWrite lk;
+            for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
+                string dbName = *i;
+
+                DataFileHeader header;
+                if ( !forceRepair && readFirstDataFileHeader( dbName, &header ) &&
+                     header.isCurrentVersion() ) {
+                    if ( header.versionMinor == PDFILE_VERSION_MINOR_22_AND_OLDER )
+                        toCheckIndexes.push_back( dbName );
+                    continue;
                 }
 
-                log() << "****" << endl;
-                log() << "****" << endl;
-                log() << "need to upgrade database " << dbName << " "
-                      << "with pdfile version " << h->version << "." << h->versionMinor << ", "
-                      << "new version: "
-                      << PDFILE_VERSION << "." << PDFILE_VERSION_MINOR_22_AND_OLDER
-                      << endl;
-                if ( shouldRepairDatabases ) {
-                    // QUESTION: Repair even if file format is higher version than code?
-                    log() << "\t starting upgrade" << endl;
-                    string errmsg;
-                    verify( doDBUpgrade( dbName , errmsg , h ) );
+                LOG(1) << "\t" << dbName << endl;
+                Client::Context ctx( dbName );
+                DataFile *p = cc().database()->getFile( 0 );
+                DataFileHeader *h = p->getHeader();
+                if ( !h->isCurrentVersion() || forceRepair ) {
+
+                    if( h->version <= 0 ) {
+                        uasserted(14026,
+                          str::stream() << "db " << dbName << " appears corrupt pdfile version: " << h->version
+                                        << " info: " << h->versionMinor << ' ' << h->fileLength);
+                    }
+
+                    log() << "****" << endl;
+                    log() << "****" << endl;
+                    log() << "need to upgrade database " << dbName << " "
+                          << "with pdfile version " << h->version << "." << h->versionMinor << ", "
+                          << "new version: "
+                          << PDFILE_VERSION << "." << PDFILE_VERSION_MINOR_22_AND_OLDER
+                          << endl;
+                    if ( shouldRepairDatabases ) {
+                        // QUESTION: Repair even if file format is higher version than code?
+                        log() << "\t starting upgrade" << endl;
+                        string errmsg;
+                        verify( doDBUpgrade( dbName , errmsg , h ) );
+                    }
+                    else {
+                        log() << "\t Not upgrading, exiting" << endl;
+                        log() << "\t run --upgrade to upgrade dbs, then start again" << endl;
+                        log() << "****" << endl;
+                        dbexit( EXIT_NEED_UPGRADE );
+                        shouldRepairDatabases = 1;
+                        return;
+                    }
                 }
                 else {
-                    log() << "\t Not upgrading, exiting" << endl;
-                    log() << "\t run --upgrade to upgrade dbs, then start again" << endl;
-                    log() << "****" << endl;
-                    dbexit( EXIT_NEED_UPGRADE );
-                    shouldRepairDatabases = 1;
-                    return;
+                    if (h->versionMinor == PDFILE_VERSION_MINOR_22_AND_OLDER) {
+                        warnAboutPre24IndexPlugins();
+                    }
+                    Database::closeDatabase( dbName.c_str(), dbpath );
                 }
             }
-            else {
-                if (h->versionMinor == PDFILE_VERSION_MINOR_22_AND_OLDER) {
-                    const string systemIndexes = cc().database()->name() + ".system.indexes";
-                    shared_ptr<Cursor> cursor(theDataFileMgr.findAll(systemIndexes));
-                    for ( ; cursor && cursor->ok(); cursor->advance()) {
-                        const BSONObj index = cursor->current();
-                        const BSONObj key = index.getObjectField("key");
-                        const string plugin = IndexNames::findPluginName(key);
-                        if (IndexNames::existedBefore24(plugin))
-                            continue;
-
-                        log() << "Index " << index << " claims to be of type '" << plugin << "', "
-                              << "which is either invalid or did not exist before v2.4. "
-                              << "See the upgrade section: "
-                              << "http://dochub.mongodb.org/core/upgrade-2.4"
-                              << startupWarningsLog;
-                    }
+        }
+
+        if ( !toCheckIndexes.empty() ) {
+            const int nThreads = std::max( 1, std::min( startupCheckThreads,
+                                                        static_cast<int>( toCheckIndexes.size() ) ) );
+            AtomicUInt32 next;
+            SimpleMutex errorMutex( "startupIndexCheck" );
+            Status firstError = Status::OK();
+            boost::thread_group threads;
+            for ( int i = 0; i < nThreads; i++ ) {
+                threads.create_thread( boost::bind( checkPre24IndexPluginsThread, &toCheckIndexes,
+                                                    &next, &errorMutex, &firstError ) );
+            }
+            threads.join_all();
+
+            // the checks leave their databases open, so they could run in parallel
+            Lock::GlobalWrite lk;
+            for ( vector< string >::iterator i = toCheckIndexes.begin();
+                  i != toCheckIndexes.end(); ++i ) {
+                if ( dbHolder()._isLoaded( *i, dbpath ) ) {
+                    Client::Context ctx( *i );
+                    Database::closeDatabase( *i, dbpath );
                 }
-                Database::closeDatabase( dbName.c_str(), dbpath );
             }
+            uassertStatusOK( firstError );
         }
 
         LOG(1) << "done repairDatabases" << endl;
@@ -432,13 +586,24 @@ namespace mongo {
     /**
      * does background async flushes of mmapped files
      */
+    // Directories are flushed on up to this many threads at once, see MongoFile::flushAll.
+    MONGO_EXPORT_SERVER_PARAMETER(syncFlushThreads, int, 4);
+
+    // Off by default: with it on, DataFileSync starts writeback of the mapped files a bit at a
+    // time between flushes, see _waitForNextFlush.
+    MONGO_EXPORT_SERVER_PARAMETER(syncWriteback, bool, false);
+
+    // Below this much dirty memory system wide there is nothing worth writing back early.
+    MONGO_EXPORT_SERVER_PARAMETER(syncWritebackMinDirtyMB, int, 64);
+
     class DataFileSync : public BackgroundJob , public ServerStatusSection {
     public:
         DataFileSync()
             : ServerStatusSection( "backgroundFlushing" ),
               _total_time( 0 ),
               _flushes( 0 ),
-              _last() {
+              _last(),
+              _writebackBytes( 0 ) {
         }
 
         virtual bool includeByDefault() const { return true; }
@@ -465,7 +630,7 @@ namespace mongo {
                     continue;
                 }
 
-                sleepmillis( (long long) std::max(0.0, (cmdLine.syncdelay * 1000) - time_flushing) );
+                _waitForNextFlush( (long long) std::max(0.0, (cmdLine.syncdelay * 1000) - time_flushing) );
 
                 if ( inShutdown() ) {
                     // occasional issue trying to flush during shutdown when sleep interrupted
@@ -473,7 +638,7 @@ namespace mongo {
                 }
 
                 Date_t start = jsTime();
-                int numFiles = MemoryMappedFile::flushAll( true );
+                int numFiles = MemoryMappedFile::flushAll( true, syncFlushThreads );
                 time_flushing = (int) (jsTime() - start);
 
                 _flushed(time_flushing);
@@ -491,22 +656,54 @@ namespace mongo {
             b.appendNumber( "average_ms" , (_flushes ? (_total_time / double(_flushes)) : 0.0) );
             b.appendNumber( "last_ms" , _last_time );
             b.append("last_finished", _last);
+            b.appendNumber( "writeback_bytes" , _writebackBytes );
+            {
+                BSONObjBuilder histogram( b.subobjStart( "histogram" ) );
+                _flushTimes.append( &histogram );
+                histogram.doneFast();
+            }
             return b.obj();
         }
 
     private:
 
+        /**
+         * Sleeps 'millis'.  With syncWriteback on, it also starts writeback of a second's share
+         * of the mapped files each second, so the pages the next flush would write in one burst
+         * go out evenly over the interval instead.  Seconds when the system has little dirty
+         * memory are skipped.
+         */
+        void _waitForNextFlush( long long millis ) {
+            const long long stepMillis = 1000;
+            while ( millis > stepMillis && syncWriteback && ! inShutdown() ) {
+                sleepmillis( stepMillis );
+                millis -= stepMillis;
+
+                const long long dirty = ProcessInfo::getSystemDirtyBytes();
+                if ( dirty >= 0 && dirty < syncWritebackMinDirtyMB * 1024LL * 1024 )
+                    continue;
+
+                const long long perStep = (long long)
+                    ( MongoFile::totalMappedLength() / std::max( 1.0, cmdLine.syncdelay ) );
+                _writebackBytes += MongoFile::writeback( perStep );
+            }
+            sleepmillis( millis );
+        }
+
         void _flushed(int ms) {
             _flushes++;
             _total_time += ms;
             _last_time = ms;
             _last = jsTime();
+            _flushTimes.record( std::max( 0, ms ) * 1000ULL );
         }
 
         long long _total_time;
         long long _flushes;
         int _last_time;
         Date_t _last;
+        LatencyHistogram _flushTimes;
+        long long _writebackBytes;
 
 
     } dataFileSync;
@@ -658,6 +855,7 @@ namespace mongo {
         /* this is for security on certain platforms (nonce generation) */
         srand((unsigned) (curTimeMicros() ^ startupSrandTimer.micros()));
 
+        startWarmCacheBackgroundJob();
         snapshotThread.go();
         d.clientCursorMonitor.go();
         PeriodicTask::theRunner->go();
@@ -666,6 +864,7 @@ namespace mongo {
         }
         else {
             startTTLBackgroundJob();
+            startDefragmenterBackgroundJob();
         }
 
 #ifndef _WIN32
@@ -402,6 +402,37 @@ namespace mongo {
         }
     } cmdProfile;
 
+    class CmdProfileBuffer : public Command {
+    public:
+        virtual bool slaveOk() const {
+            return true;
+        }
+        virtual void help( stringstream& help ) const {
+            help << "read the in memory profile buffer, used when profileRingBufferMB is set\n";
+            help << "{ profileBuffer : 1, drain : <bool> }\n";
+            help << "drain removes the documents returned";
+        }
+        virtual LockType locktype() const { return NONE; }
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::profileRead);
+            out->push_back(Privilege(dbname, actions));
+        }
+        CmdProfileBuffer() : Command("profileBuffer") {}
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            const bool drain = cmdObj["drain"].trueValue();
+
+            BSONArrayBuilder docs( result.subarrayStart( "docs" ) );
+            const bool more = readProfileRingBuffer( dbname, drain, &docs );
+            docs.done();
+
+            result.appendBool( "more", more );
+            return true;
+        }
+    } cmdProfileBuffer;
+
     class CmdGetOpTime : public Command {
     public:
         virtual bool slaveOk() const {
@@ -1241,6 +1272,11 @@ namespace mongo {
             result.append( "nindexes" , nsd->getCompletedIndexCount() );
             result.append( "lastExtentSize" , nsd->lastExtentSize() / scale );
             result.append( "paddingFactor" , nsd->paddingFactor() );
+            {
+                BSONObjBuilder growth( result.subobjStart( "recordGrowth" ) );
+                NamespaceDetailsTransient::get( ns.c_str() ).growthModel().toBSON( &growth );
+                growth.done();
+            }
             result.append( "systemFlags" , nsd->systemFlags() );
             result.append( "userFlags" , nsd->userFlags() );
 
@@ -1446,7 +1482,7 @@ namespace mongo {
             result.appendNumber( "indexSize" , indexSize / scale );
             result.appendNumber( "fileSize" , d->fileSize() / scale );
             if( d )
-                result.appendNumber( "nsSizeMB", (int) d->namespaceIndex().fileLength() / 1024 / 1024 );
+                result.appendNumber( "nsSizeMB", (int) ( d->namespaceIndex().fileLength() / 1024 / 1024 ) );
 
             BSONObjBuilder dataFileVersion( result.subobjStart( "dataFileVersion" ) );
             if ( d && !d->isEmpty() ) {
@@ -1560,8 +1596,6 @@ namespace mongo {
             out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
         }
         bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
-            BackgroundOperation::assertNoBgOpInProgForDb(dbname.c_str());
-
             string from = jsobj.getStringField( "convertToCapped" );
             long long size = (long long)jsobj.getField( "size" ).number();
 
@@ -1570,6 +1604,10 @@ namespace mongo {
                 return false;
             }
 
+            // Only the collection itself and its temporary copy are touched, so builds on the
+            // database's other collections can go on.
+            BackgroundOperation::assertNoBgOpInProgForNs(dbname + "." + from);
+
             string shortTmpName = str::stream() << "tmp.convertToCapped." << from;
             string longTmpName = str::stream() << dbname << "." << shortTmpName;
 
@@ -1980,6 +2018,16 @@ namespace mongo {
             return;
         }
 
+        BSONElement maxTime = cmdObj["maxTimeMS"];
+        if ( !maxTime.eoo() ) {
+            if ( !maxTime.isNumber() || maxTime.numberLong() < 0 ) {
+                appendCommandStatus(result, false, "maxTimeMS must be a non-negative number");
+                return;
+            }
+            if ( maxTime.numberLong() > 0 )
+                client.curop()->setMaxTimeMicros( maxTime.numberLong() * 1000ULL );
+        }
+
         bool canRunHere =
             isMaster( dbname.c_str() ) ||
             c->slaveOk() ||
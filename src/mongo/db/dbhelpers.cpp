@@ -286,7 +286,8 @@ namespace mongo {
                                     bool secondaryThrottle,
                                     RemoveCallback * callback,
                                     bool fromMigrate,
-                                    bool onlyRemoveOrphanedDocs )
+                                    bool onlyRemoveOrphanedDocs,
+                                    const RemovePacing& pacing )
     {
         Timer rangeRemoveTimer;
         const string& ns = range.ns;
@@ -326,84 +327,115 @@ namespace mongo {
         
         long long millisWaitingForReplication = 0;
 
-        while ( 1 ) {
+        // shrinks when a batch runs out of pacing.maxBatchMillis, grows back when it doesn't
+        int batchSize = std::max( 1, pacing.docsPerBatch );
+        Timer rateTimer;
+        bool done = false;
+
+        while ( ! done ) {
+            int deletedThisBatch = 0;
             try {
 
                 Client::WriteContext ctx(ns);
+                Timer batchTimer;
+                bool outOfTime = false;
 
-                scoped_ptr<Cursor> c;
-                
-                {
-                    NamespaceDetails* nsd = nsdetails( ns );
-                    if ( ! nsd )
-                        break;
+                while ( deletedThisBatch < batchSize ) {
+                    scoped_ptr<Cursor> c;
 
-                    int ii = nsd->findIndexByKeyPattern( indexKeyPattern.toBSON() );
-                    verify( ii >= 0 );
-                    
-                    IndexDetails& i = nsd->idx( ii );
-                    
-                    c.reset( BtreeCursor::make( nsd, i, min, max, maxInclusive, 1 ) );
-                }
-                
-                if ( ! c->ok() ) {
-                    // we're done
-                    break;
-                }
-                
-                DiskLoc rloc = c->currLoc();
-                BSONObj obj = c->current();
-
-                // this is so that we don't have to handle this cursor in the delete code
-                c.reset(0);
-
-                if ( onlyRemoveOrphanedDocs ) {
+                    {
+                        NamespaceDetails* nsd = nsdetails( ns );
+                        if ( ! nsd ) {
+                            done = true;
+                            break;
+                        }
 
-                    // Do a final check in the write lock to make absolutely sure that our
-                    // collection hasn't been modified in a way that invalidates our migration
-                    // cleanup.
+                        int ii = nsd->findIndexByKeyPattern( indexKeyPattern.toBSON() );
+                        verify( ii >= 0 );
 
-                    // We should never be able to turn off the sharding state once enabled, but
-                    // in the future we might want to.
-                    verify(shardingState.enabled());
+                        IndexDetails& i = nsd->idx( ii );
 
-                    // In write lock, so will be the most up-to-date version
-                    CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+                        c.reset( BtreeCursor::make( nsd, i, min, max, maxInclusive, 1 ) );
+                    }
 
-                    bool docIsOrphan;
-                    if ( metadataNow ) {
-                        KeyPattern kp( metadataNow->getKeyPattern() );
-                        BSONObj key = kp.extractSingleKey( obj );
-                        docIsOrphan = !metadataNow->keyBelongsToMe( key )
-                            && !metadataNow->keyIsPending( key );
+                    if ( ! c->ok() ) {
+                        // we're done
+                        done = true;
+                        break;
                     }
-                    else {
-                        docIsOrphan = false;
+
+                    DiskLoc rloc = c->currLoc();
+                    BSONObj obj = c->current();
+
+                    // this is so that we don't have to handle this cursor in the delete code
+                    c.reset(0);
+
+                    if ( onlyRemoveOrphanedDocs ) {
+
+                        // Do a final check in the write lock to make absolutely sure that our
+                        // collection hasn't been modified in a way that invalidates our migration
+                        // cleanup.
+
+                        // We should never be able to turn off the sharding state once enabled, but
+                        // in the future we might want to.
+                        verify(shardingState.enabled());
+
+                        // In write lock, so will be the most up-to-date version
+                        CollectionMetadataPtr metadataNow = shardingState.getCollectionMetadata( ns );
+
+                        bool docIsOrphan;
+                        if ( metadataNow ) {
+                            KeyPattern kp( metadataNow->getKeyPattern() );
+                            BSONObj key = kp.extractSingleKey( obj );
+                            docIsOrphan = !metadataNow->keyBelongsToMe( key )
+                                && !metadataNow->keyIsPending( key );
+                        }
+                        else {
+                            docIsOrphan = false;
+                        }
+
+                        if ( !docIsOrphan ) {
+                            warning() << "aborting migration cleanup for chunk " << min << " to " << max
+                                      << ( metadataNow ? (string) " at document " + obj.toString() : "" )
+                                      << ", collection " << ns << " has changed " << endl;
+                            done = true;
+                            break;
+                        }
                     }
 
-                    if ( !docIsOrphan ) {
-                        warning() << "aborting migration cleanup for chunk " << min << " to " << max
-                                  << ( metadataNow ? (string) " at document " + obj.toString() : "" )
-                                  << ", collection " << ns << " has changed " << endl;
+                    if ( callback )
+                        callback->goingToDelete( obj );
+
+                    logOp( "d" , ns.c_str() , rloc.obj()["_id"].wrap() , 0 , 0 , fromMigrate );
+                    theDataFileMgr.deleteRecord(ns.c_str() , rloc.rec(), rloc);
+                    numDeleted++;
+                    deletedThisBatch++;
+                    if ( pacing.docsDeleted )
+                        pacing.docsDeleted->fetchAndAdd( 1 );
+
+                    if ( pacing.maxBatchMillis > 0 && batchTimer.millis() >= pacing.maxBatchMillis ) {
+                        outOfTime = true;
                         break;
                     }
                 }
-                
-                if ( callback )
-                    callback->goingToDelete( obj );
-                
-                logOp( "d" , ns.c_str() , rloc.obj()["_id"].wrap() , 0 , 0 , fromMigrate );
-                theDataFileMgr.deleteRecord(ns.c_str() , rloc.rec(), rloc);
-                numDeleted++;
+
+                if ( outOfTime )
+                    batchSize = std::max( 1, deletedThisBatch / 2 );
+                else if ( deletedThisBatch == batchSize )
+                    batchSize = std::min( std::max( 1, pacing.docsPerBatch ), batchSize * 2 );
             }
             catch( PageFaultException& e ) {
                 e.touch();
-                continue;
+                if ( deletedThisBatch == 0 )
+                    continue;
             }
 
+            if ( deletedThisBatch == 0 )
+                break;
+
             Timer secondaryThrottleTime;
 
-            if ( secondaryThrottle && numDeleted > 0 ) {
+            if ( secondaryThrottle ) {
                 if ( ! waitForReplication( c.getLastOp(), 2, 60 /* seconds to wait */ ) ) {
                     warning() << "replication to secondaries for removeRange at least 60 seconds behind" << endl;
                 }
@@ -411,7 +443,15 @@ namespace mongo {
             }
             
             if ( ! Lock::isLocked() ) {
-                int micros = ( 2 * Client::recommendedYieldMicros() ) - secondaryThrottleTime.micros();
+                long long micros = ( 2 * Client::recommendedYieldMicros() ) - secondaryThrottleTime.micros();
+
+                if ( pacing.maxDocsPerSecond > 0 ) {
+                    // stay behind the schedule the rate limit allows
+                    long long aheadMicros =
+                        ( numDeleted * 1000000LL / pacing.maxDocsPerSecond ) - rateTimer.micros();
+                    micros = std::max( micros, aheadMicros );
+                }
+
                 if ( micros > 0 ) {
                     LOG(1) << "Helpers::removeRangeUnlocked going to sleep for " << micros << " micros" << endl;
                     sleepmicros( micros );
@@ -22,6 +22,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/db.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/range_arithmetic.h"
 
 namespace mongo {
@@ -127,6 +128,28 @@ namespace mongo {
             virtual void goingToDelete( const BSONObj& o ) = 0;
         };
 
+        /**
+         * How fast removeRange deletes.  The defaults delete one document per write lock,
+         * with no rate limit.
+         */
+        struct RemovePacing {
+            RemovePacing() : docsPerBatch( 1 ), maxBatchMillis( 0 ), maxDocsPerSecond( 0 ),
+                             docsDeleted( NULL ) {}
+
+            // most documents deleted per write lock
+            int docsPerBatch;
+
+            // a batch gives up the lock after this long, and later batches shrink to fit
+            // in it; 0 for no limit
+            int maxBatchMillis;
+
+            // deletes are spaced out to stay under this rate; 0 for no limit
+            int maxDocsPerSecond;
+
+            // if set, incremented as documents are deleted, so progress is visible mid-range
+            AtomicInt64* docsDeleted;
+        };
+
         /**
          * Takes a namespace range, specified by a min and max and qualified by an index pattern,
          * and removes all the documents in that range found by iterating
@@ -139,7 +162,8 @@ namespace mongo {
          *
          * Returns -1 when no usable index exists
          *
-         * Does oplog the individual document deletions.
+         * Does oplog the individual document deletions.  The deletions of a batch are
+         * oplogged together under one write lock, and secondaryThrottle waits once per batch.
          * // TODO: Refactor this mechanism, it is growing too large
          */
         static long long removeRange( const KeyRange& range,
@@ -147,7 +171,8 @@ namespace mongo {
                                       bool secondaryThrottle = false,
                                       RemoveCallback * callback = 0,
                                       bool fromMigrate = false,
-                                      bool onlyRemoveOrphanedDocs = false );
+                                      bool onlyRemoveOrphanedDocs = false,
+                                      const RemovePacing& pacing = RemovePacing() );
 
 
         // TODO: This will supersede Chunk::MaxObjectsPerChunk
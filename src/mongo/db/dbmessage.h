@@ -271,9 +271,16 @@ namespace mongo {
         Message *response;
         MSGID responseTo;
         string exhaustNS; /* points to ns if exhaust mode. 0=normal mode*/
-        DbResponse(Message *r, MSGID rt) : response(r), responseTo(rt){ }
+        /* if set, build the reply to the next getMore on this cursor once this one is sent */
+        string prepareNextNS;
+        long long prepareNextCursorId;
+        int prepareNextNToReturn;
+        DbResponse(Message *r, MSGID rt) : response(r), responseTo(rt),
+                                           prepareNextCursorId(0), prepareNextNToReturn(0) { }
         DbResponse() {
             response = 0;
+            prepareNextCursorId = 0;
+            prepareNextNToReturn = 0;
         }
         ~DbResponse() { delete response; }
     };
@@ -23,7 +23,9 @@
 
 #include "mongo/db/dbwebserver.h"
 
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/function.hpp>
 #include <pcrecpp.h>
 
 #include "mongo/base/init.h"
@@ -37,6 +39,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/db.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/snapshots.h"
 #include "mongo/util/admin_access.h"
 #include "mongo/util/md5.hpp"
@@ -52,6 +55,13 @@ namespace mongo {
     using namespace mongoutils::html;
     using namespace bson;
 
+    // Threads serving http requests.  0 serves them one at a time on the thread that listens.
+    MONGO_EXPORT_SERVER_PARAMETER(httpWorkerThreads, int, 0);
+
+    // How long the home page and _status, which run every status plugin and serverStatus, are
+    // served from a copy built earlier.  0 builds them for each request.
+    MONGO_EXPORT_SERVER_PARAMETER(httpStatusCacheMillis, int, 0);
+
     struct Timing {
         Timing() {
             start = timeLocked = 0;
@@ -62,13 +72,74 @@ namespace mongo {
     class DbWebServer : public MiniWebServer {
     public:
         DbWebServer(const string& ip, int port, const AdminAccess* webUsers)
-            : MiniWebServer("admin web console", ip, port), _webUsers(webUsers) {
+            : MiniWebServer("admin web console", ip, port, httpWorkerThreads),
+              _webUsers(webUsers),
+              _cacheMutex("DbWebServer::cache") {
             WebStatusPlugin::initAll();
         }
 
     private:
         const AdminAccess* _webUsers; // not owned here
 
+        typedef boost::function<void (string&, int&, vector<string>&)> PageBuilder;
+
+        struct CachedPage {
+            CachedPage() : builtAt(0), building(false) {}
+            string msg;
+            vector<string> headers;
+            unsigned long long builtAt; // 0 if there's no copy yet
+            bool building;
+        };
+
+        /**
+         * Serves the page at 'url' from its cached copy if that's recent enough, or builds it.
+         * While one request rebuilds a page the others get the old copy, so however often the
+         * page is scraped, it's built at most once per httpStatusCacheMillis.
+         */
+        void _cached(const string& url, const PageBuilder& build,
+                     string& responseMsg, int& responseCode, vector<string>& headers) {
+            const int cacheMillis = httpStatusCacheMillis;
+            if (cacheMillis <= 0) {
+                build(responseMsg, responseCode, headers);
+                return;
+            }
+
+            {
+                scoped_lock lk(_cacheMutex);
+                CachedPage& page = _cache[url];
+                if (page.builtAt &&
+                    (page.building || curTimeMillis64() - page.builtAt <
+                                          static_cast<unsigned long long>(cacheMillis))) {
+                    responseMsg = page.msg;
+                    responseCode = 200;
+                    headers.insert(headers.end(), page.headers.begin(), page.headers.end());
+                    return;
+                }
+                page.building = true;
+            }
+
+            try {
+                build(responseMsg, responseCode, headers);
+            }
+            catch (...) {
+                scoped_lock lk(_cacheMutex);
+                _cache[url].building = false;
+                throw;
+            }
+
+            scoped_lock lk(_cacheMutex);
+            CachedPage& page = _cache[url];
+            page.building = false;
+            if (responseCode == 200) {
+                page.msg = responseMsg;
+                page.headers = headers;
+                page.builtAt = curTimeMillis64();
+            }
+        }
+
+        mongo::mutex _cacheMutex;
+        map<string, CachedPage> _cache; // by url, only ever those of cacheable pages
+
         void doUnlockedStuff(stringstream& ss) {
             /* this is in the header already ss << "port:      " << port << '\n'; */
             ss << "<pre>";
@@ -162,6 +233,9 @@ namespace mongo {
             vector<string>& headers, // if completely empty, content-type: text/html will be added
             const SockAddr &from
         ) {
+            // the worker threads of a pool have no client until their first request
+            Client::initThreadIfNotAlready("websvr");
+
             if ( url.size() > 1 ) {
 
                 if ( ! allowed( rq , headers, from ) ) {
@@ -188,7 +262,16 @@ namespace mongo {
                             string callback = params.getStringField("jsonp");
                             uassert(13453, "server not started with --jsonp", callback.empty() || cmdLine.jsonp);
 
-                            handler->handle( rq , url , params , responseMsg , responseCode , headers , from );
+                            if ( pos == string::npos && handler->cacheable() ) {
+                                _cached( url,
+                                         boost::bind( &DbWebHandler::handle, handler, rq, url,
+                                                      params, _1, _2, _3, boost::cref( from ) ),
+                                         responseMsg, responseCode, headers );
+                            }
+                            else {
+                                handler->handle( rq , url , params , responseMsg , responseCode ,
+                                                 headers , from );
+                            }
 
                             if (responseCode == 200 && !callback.empty()) {
                                 responseMsg = callback + '(' + responseMsg + ')';
@@ -219,6 +302,11 @@ namespace mongo {
                 return;
             }
 
+            _cached( "/", boost::bind( &DbWebServer::_homePage, this, _1, _2, _3 ),
+                     responseMsg, responseCode, headers );
+        }
+
+        void _homePage( string& responseMsg, int& responseCode, vector<string>& headers ) {
             responseCode = 200;
             stringstream ss;
             string dbname;
@@ -406,21 +494,19 @@ namespace mongo {
     public:
         StatusHandler() : DbWebHandler( "_status" , 1 , false ) {}
 
+        virtual bool cacheable() const { return true; }
+
         virtual void handle( const char *rq, const std::string& url, BSONObj params,
                              string& responseMsg, int& responseCode,
                              vector<string>& headers,  const SockAddr &from ) {
             headers.push_back( "Content-Type: application/json;charset=utf-8" );
             responseCode = 200;
 
-            static vector<string> commands;
-            if ( commands.size() == 0 ) {
-                commands.push_back( "serverStatus" );
-                commands.push_back( "buildinfo" );
-            }
+            static const char* const commands[] = { "serverStatus", "buildinfo" };
 
             BSONObjBuilder buf(1024);
 
-            for ( unsigned i=0; i<commands.size(); i++ ) {
+            for ( unsigned i=0; i<sizeof(commands)/sizeof(commands[0]); i++ ) {
                 string cmd = commands[i];
 
                 Command * c = Command::findCommand( cmd );
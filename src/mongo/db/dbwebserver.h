@@ -42,6 +42,12 @@ namespace mongo {
 
         virtual bool requiresREST( const string& url ) const { return _requiresREST; }
 
+        /**
+         * Whether the page, when asked for without parameters, is the same for everyone and may
+         * be served from a copy up to httpStatusCacheMillis old.
+         */
+        virtual bool cacheable() const { return false; }
+
         virtual void handle( const char *rq, // the full request
                              const std::string& url,
                              BSONObj params,
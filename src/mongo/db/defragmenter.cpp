@@ -0,0 +1,346 @@
+// defragmenter.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/defragmenter.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/auth/user_name.h"
+#include "mongo/db/background.h"
+#include "mongo/db/client.h"
+#include "mongo/db/clientcursor.h"
+#include "mongo/db/commands/fsync.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/database_holder.h"
+#include "mongo/db/index_update.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/repl/is_master.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/background.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    void freeExtents(DiskLoc firstExt, DiskLoc lastExt);
+
+    Counter64 defragPasses;
+    Counter64 defragRecordsMoved;
+    Counter64 defragBytesMoved;
+    Counter64 defragExtentsFreed;
+
+    ServerStatusMetricField<Counter64> defragPassesDisplay("defragmenter.passes",
+                                                           &defragPasses);
+    ServerStatusMetricField<Counter64> defragRecordsMovedDisplay("defragmenter.recordsMoved",
+                                                                 &defragRecordsMoved);
+    ServerStatusMetricField<Counter64> defragBytesMovedDisplay("defragmenter.bytesMoved",
+                                                               &defragBytesMoved);
+    ServerStatusMetricField<Counter64> defragExtentsFreedDisplay("defragmenter.extentsFreed",
+                                                                 &defragExtentsFreed);
+
+    MONGO_EXPORT_SERVER_PARAMETER(defragmenterEnabled, bool, false);
+
+    // Extents whose records fill less than this percentage of them are emptied and freed.
+    MONGO_EXPORT_SERVER_PARAMETER(defragmenterSparseExtentPercent, int, 25);
+
+    // Cap on the record bytes copied per second, or 0 for none.
+    MONGO_EXPORT_SERVER_PARAMETER(defragmenterMaxBytesPerSec, int, 4 * 1024 * 1024);
+
+    namespace {
+
+        // Records moved per acquisition of the write lock.
+        const int kRecordsPerBatch = 100;
+
+        /**
+         * Capped collections can't lose records from the middle, system collections are
+         * pointed into (IndexDetails::info), and we stay off collections with an index build
+         * running.
+         */
+        bool isDefragmentable(const string& ns, NamespaceDetails* d) {
+            return d
+                && !d->isCapped()
+                && !NamespaceString(ns).isSystem()
+                && d->getCompletedIndexCount() == d->getTotalIndexCount()
+                && !BackgroundOperation::inProgForNs(ns);
+        }
+
+        /**
+         * @return true if 'extLoc' is still one of the extents of 'd' other than the last,
+         *     which new records are appended to and which we never empty.
+         */
+        bool isMovableExtentOf(NamespaceDetails* d, const DiskLoc& extLoc) {
+            for (DiskLoc L = d->firstExtent(); !L.isNull() && L != d->lastExtent();
+                 L = L.ext()->xnext) {
+                if (L == extLoc) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /** @return the bytes, headers included, of the records in the extent at 'extLoc'. */
+        long long recordBytesInExtent(Database* db, const DiskLoc& extLoc) {
+            long long bytes = 0;
+            for (DiskLoc L = extLoc.ext()->firstRecord; !L.isNull();
+                 L = db->getExtentManager().getNextRecordInExtent(L)) {
+                bytes += L.rec()->lengthWithHeaders();
+            }
+            return bytes;
+        }
+
+        /**
+         * Copies the record at 'oldLoc' into newly allocated space, moves its index entries and
+         * any cursors over to the copy, and removes the original.  The original's space is kept
+         * off the deleted lists so it can't be handed out again before its extent is freed.
+         * @return the bytes copied.
+         */
+        int moveRecord(const char* ns, NamespaceDetails* d, const DiskLoc& oldLoc) {
+            Record* oldRec = oldLoc.rec();
+            BSONObj obj = BSONObj::make(oldRec);
+            const int len = obj.objsize();
+            const int lenWHdr = d->getRecordAllocationSize(len + Record::HeaderSize);
+
+            DiskLoc newLoc = allocateSpaceForANewRecord(ns, d, lenWHdr, false);
+            uassert(16992, "defragmenter couldn't allocate space to move a record",
+                    !newLoc.isNull());
+            Record* newRec = (Record*) getDur().writingPtr(newLoc.rec(), lenWHdr);
+            memcpy(newRec->data(), obj.objdata(), len);
+            addRecordToRecListInExtent(newRec, newLoc);
+            d->incrementStats(newRec->netLength(), 1);
+
+            ClientCursor::aboutToDelete(ns, d, oldLoc);
+            unindexRecord(d, oldRec, oldLoc, true);
+            indexRecord(ns, d, BSONObj::make(newRec), newLoc);
+
+            const int oldLenWHdr = oldRec->lengthWithHeaders();
+            theDataFileMgr._deleteRecord(d, ns, oldRec, oldLoc);
+
+            // _deleteRecord() pushed the old space onto the head of its deleted list.
+            DiskLoc& head = d->deletedListEntry(NamespaceDetails::bucket(oldLenWHdr));
+            if (head == oldLoc) {
+                getDur().writingDiskLoc(head) = oldLoc.drec()->nextDeleted();
+            }
+
+            NamespaceDetailsTransient::get(ns).notifyOfWriteOp();
+            return len;
+        }
+
+        /**
+         * Moves up to kRecordsPerBatch records out of the extent at 'extLoc' under the write
+         * lock, then frees the extent if that emptied it.
+         * @return false once there is nothing more to do for this extent.
+         */
+        bool defragmentBatch(const string& ns, const DiskLoc& extLoc, long long* bytesMoved,
+                             bool* freed) {
+            Client::WriteContext ctx(ns);
+            NamespaceDetails* d = nsdetails(ns);
+            if (!isDefragmentable(ns, d) || !isMovableExtentOf(d, extLoc)) {
+                return false;
+            }
+
+            // Deletes since the last batch may have put space in this extent back on the lists.
+            d->unlinkDeletedRecordsInExtent(extLoc);
+
+            Extent* e = extLoc.ext();
+            for (int i = 0; i < kRecordsPerBatch && !e->firstRecord.isNull(); i++) {
+                *bytesMoved += moveRecord(ns.c_str(), d, e->firstRecord);
+                defragRecordsMoved.increment();
+            }
+
+            if (!e->firstRecord.isNull()) {
+                getDur().commitIfNeeded();
+                return true;
+            }
+
+            // Empty now.  Take it out of the collection's extent chain and free it; it is never
+            // the last extent, so it always has a successor.
+            if (e->xprev.isNull()) {
+                d->firstExtent().writing() = e->xnext;
+            }
+            else {
+                e->xprev.ext()->xnext.writing() = e->xnext;
+            }
+            e->xnext.ext()->xprev.writing() = e->xprev;
+            getDur().writing(e)->markEmpty();
+            freeExtents(extLoc, extLoc);
+            getDur().commitIfNeeded();
+
+            LOG(1) << "defragmenter freed extent " << extLoc.toString() << " of " << ns << endl;
+            defragExtentsFreed.increment();
+            *freed = true;
+            return false;
+        }
+
+        /** @return true if the extent at 'extLoc' was emptied and freed. */
+        bool drainExtent(const string& ns, const DiskLoc& extLoc, int extentLength,
+                         long long maxBytesPerSec) {
+            // Writers can keep moving records in as we move them out, so give up after copying
+            // twice the extent's size.
+            long long totalBytes = 0;
+            while (!inShutdown() && totalBytes < 2LL * extentLength) {
+                Timer t;
+                long long bytes = 0;
+                bool freed = false;
+                const bool more = defragmentBatch(ns, extLoc, &bytes, &freed);
+                totalBytes += bytes;
+                defragBytesMoved.increment(bytes);
+                if (!more) {
+                    return freed;
+                }
+
+                if (maxBytesPerSec > 0) {
+                    const long long wantMillis = bytes * 1000 / maxBytesPerSec;
+                    if (wantMillis > t.millis()) {
+                        sleepmillis(wantMillis - t.millis());
+                    }
+                }
+            }
+            return false;
+        }
+
+        void defragmentDatabase(const string& dbName) {
+            vector<string> collections;
+            {
+                DBDirectClient db;
+                auto_ptr<DBClientCursor> cursor = db.query(dbName + ".system.namespaces",
+                                                           BSONObj(),
+                                                           0, /* default nToReturn */
+                                                           0, /* default nToSkip */
+                                                           0, /* default fieldsToReturn */
+                                                           QueryOption_SlaveOk);
+                if (cursor.get()) {
+                    while (cursor->more()) {
+                        string ns = cursor->next()["name"].String();
+                        // Index namespaces hold btree buckets, not documents.
+                        if (ns.find('$') == string::npos) {
+                            collections.push_back(ns);
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < collections.size() && !inShutdown(); i++) {
+                int freed = defragmentCollection(collections[i],
+                                                 defragmenterSparseExtentPercent,
+                                                 defragmenterMaxBytesPerSec);
+                if (freed) {
+                    log() << "defragmenter freed " << freed << " extents of " << collections[i]
+                          << endl;
+                }
+            }
+        }
+
+        /**
+         * Empties and frees sparse extents in the background, a batch of records at a time,
+         * so that space left by deletes can be reclaimed without the blocking compact command.
+         */
+        class Defragmenter : public BackgroundJob {
+        public:
+            virtual string name() const { return "Defragmenter"; }
+
+            virtual void run() {
+                Client::initThread(name().c_str());
+                cc().getAuthorizationSession()->grantInternalAuthorization(
+                        UserName("_defragmenter", "local"));
+
+                while (!inShutdown()) {
+                    sleepsecs(60);
+
+                    if (!defragmenterEnabled) {
+                        continue;
+                    }
+
+                    if (lockedForWriting()) {
+                        continue;
+                    }
+
+                    // if part of replSet but not in a readable state (e.g. during initial sync),
+                    // skip.
+                    if (theReplSet && !theReplSet->state().readable()) {
+                        continue;
+                    }
+
+                    set<string> dbs;
+                    {
+                        Lock::DBRead lk("local");
+                        dbHolder().getAllShortNames(dbs);
+                    }
+
+                    defragPasses.increment();
+
+                    for (set<string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i) {
+                        try {
+                            defragmentDatabase(*i);
+                        }
+                        catch (DBException& e) {
+                            error() << "error defragmenting db: " << *i << " " << e << endl;
+                        }
+                    }
+                }
+            }
+        };
+
+    }  // namespace
+
+    int defragmentCollection(const string& ns, int sparsePercent, long long maxBytesPerSec) {
+        DiskLoc extLoc;
+        {
+            Client::ReadContext ctx(ns);
+            NamespaceDetails* d = nsdetails(ns);
+            if (!isDefragmentable(ns, d)) {
+                return 0;
+            }
+            extLoc = d->firstExtent();
+        }
+
+        // Look at one extent per acquisition of the read lock, so a big collection doesn't hold
+        // off writers while we find its sparse extents.
+        int freed = 0;
+        while (!extLoc.isNull() && !inShutdown()) {
+            DiskLoc nextLoc;
+            int extentLength;
+            bool sparse;
+            {
+                Client::ReadContext ctx(ns);
+                NamespaceDetails* d = nsdetails(ns);
+                if (!isDefragmentable(ns, d) || !isMovableExtentOf(d, extLoc)) {
+                    break;
+                }
+                Extent* e = extLoc.ext();
+                nextLoc = e->xnext;
+                extentLength = e->length;
+                sparse = recordBytesInExtent(cc().database(), extLoc) * 100
+                         < static_cast<long long>(extentLength) * sparsePercent;
+            }
+
+            if (sparse && drainExtent(ns, extLoc, extentLength, maxBytesPerSec)) {
+                freed++;
+            }
+            extLoc = nextLoc;
+        }
+        return freed;
+    }
+
+    void startDefragmenterBackgroundJob() {
+        Defragmenter* defragmenter = new Defragmenter();
+        defragmenter->go();
+    }
+}
@@ -0,0 +1,35 @@
+// defragmenter.h
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+namespace mongo {
+
+    void startDefragmenterBackgroundJob();
+
+    /**
+     * Moves the records out of the extents of collection 'ns' that are less than
+     * 'sparsePercent' full of records, and frees each extent once it is empty.  The write lock
+     * is taken one batch of records at a time; between batches we sleep as needed to keep the
+     * copying under 'maxBytesPerSec', or not at all if that is 0.
+     * @return the number of extents freed.
+     */
+    int defragmentCollection(const std::string& ns, int sparsePercent, long long maxBytesPerSec);
+}
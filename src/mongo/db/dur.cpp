@@ -68,6 +68,7 @@
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
 #include "mongo/db/dur_stats.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/server.h"
 #include "mongo/util/concurrency/race.h"
 #include "mongo/util/mongoutils/hash.h"
@@ -108,6 +109,16 @@ namespace mongo {
             _intervalMicros = 3000000;
         }
 
+        void Stats::S::recordCommitLatency(unsigned long long micros) {
+            unsigned i = 0;
+            unsigned long long bound = 1000;
+            while( i < NCommitLatencyBuckets - 1 && micros > bound ) {
+                i++;
+                bound *= 2;
+            }
+            _commitLatency[i]++;
+        }
+
         Stats::S * Stats::other() {
             return curr == &_a ? &_b : &_a;
         }
@@ -141,6 +152,7 @@ namespace mongo {
                        "journaledMB" << _journaledBytes / 1000000.0 <<
                        "writeToDataFilesMB" << _writeToDataFilesBytes / 1000000.0 <<
                        "compression" << _journaledBytes / (_uncompressedBytes+1.0) <<
+                       "compressionUnpadded" << _compressedBytes / (_uncompressedBytes+1.0) <<
                        "commitsInWriteLock" << _commitsInWriteLock <<
                        "earlyCommits" << _earlyCommits << 
                        "timeMs" <<
@@ -150,6 +162,14 @@ namespace mongo {
                              "writeToDataFiles" << (unsigned) (_writeToDataFilesMicros/1000) <<
                              "remapPrivateView" << (unsigned) (_remapPrivateViewMicros/1000)
                            );
+            {
+                BSONObjBuilder h( b.subobjStart( "commitLatencyMs" ) );
+                for( unsigned i = 0; i < NCommitLatencyBuckets - 1; i++ )
+                    h << string( str::stream() << "le" << (1 << i) ) << _commitLatency[i];
+                h << string( str::stream() << "gt" << (1 << (NCommitLatencyBuckets - 2)) )
+                  << _commitLatency[NCommitLatencyBuckets - 1];
+                h.done();
+            }
             if( cmdLine.journalCommitInterval != 0 )
                 b << "journalCommitIntervalMs" << cmdLine.journalCommitInterval;
             return b.obj();
@@ -565,6 +585,7 @@ namespace mongo {
                 return true;
             }
 
+            Timer commitTimer;
             JSectHeader h;
             PREPLOGBUFFER(h,ab); // need to be in readlock (writes excluded) for this
 
@@ -585,6 +606,7 @@ namespace mongo {
             // data is now in the journal, which is sufficient for acknowledging getLastError.
             // (ok to crash after that)
             commitJob.committingNotifyCommitted();
+            stats.curr->recordCommitLatency( commitTimer.micros() );
 
             // note the higher-up-the-chain locking of filesLockedFsync is important here, 
             // as we are not in Lock::GlobalRead anymore. private view readers won't see 
@@ -646,6 +668,7 @@ namespace mongo {
                     commitJob.committingNotifyCommitted();
                 }
                 else {
+                    Timer commitTimer;
                     JSectHeader h;
                     PREPLOGBUFFER(h,ab);
 
@@ -657,6 +680,7 @@ namespace mongo {
                     // data is now in the journal, which is sufficient for acknowledging getLastError.
                     // (ok to crash after that)
                     commitJob.committingNotifyCommitted();
+                    stats.curr->recordCommitLatency( commitTimer.micros() );
 
                     WRITETODATAFILES(h, ab);
                     debugValidateAllMapsMatch();
@@ -772,6 +796,30 @@ namespace mongo {
         extern int groupCommitIntervalMs;
         boost::filesystem::path getJournalDir();
 
+        // commit as soon as a getlasterror j:true waiter shows up, or the uncommitted bytes
+        // reach journalGroupCommitBytes, rather than at the next third of the commit interval.
+        // waiters arriving within journalGroupCommitWindowMicros of the first join its commit.
+        MONGO_EXPORT_SERVER_PARAMETER(journalGroupCommit, bool, false);
+        MONGO_EXPORT_SERVER_PARAMETER(journalGroupCommitWindowMicros, int, 500);
+        MONGO_EXPORT_SERVER_PARAMETER(journalGroupCommitBytes, int, UncommittedBytesLimit / 2);
+
+        /** waits until the next group commit should start, for the journalGroupCommit mode */
+        static void awaitGroupCommitTrigger(unsigned ms) {
+            // the byte count isn't signalled, so we poll it while waiting for a waiter
+            const unsigned pollMillis = 2;
+            Timer t;
+            while( (unsigned) t.millis() < ms ) {
+                unsigned left = ms - t.millis();
+                if( commitJob._notify.awaitWaiter( std::min(left, pollMillis) ) ) {
+                    if( journalGroupCommitWindowMicros > 0 )
+                        sleepmicros( journalGroupCommitWindowMicros );
+                    return;
+                }
+                if( commitJob.bytes() > (size_t) journalGroupCommitBytes )
+                    return;
+            }
+        }
+
         void durThread() {
             Client::initThread("journal");
 
@@ -797,14 +845,19 @@ namespace mongo {
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
-                            break;
-                        if( commitJob.bytes() > UncommittedBytesLimit / 2  )
-                            break;
+                    if( journalGroupCommit ) {
+                        awaitGroupCommitTrigger(ms);
+                    }
+                    else {
+                        // commit sooner if one or more getLastError j:true is pending
                         sleepmillis(oneThird);
+                        for( unsigned i = 1; i <= 2; i++ ) {
+                            if( commitJob._notify.nWaiting() )
+                                break;
+                            if( commitJob.bytes() > UncommittedBytesLimit / 2  )
+                                break;
+                            sleepmillis(oneThird);
+                        }
                     }
                                         
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
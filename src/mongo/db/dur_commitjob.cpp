@@ -143,6 +143,22 @@ namespace mongo {
             dassert(contains(other));
         }
 
+        void IntentsAndDurOps::insertWriteIntent(void* p, int len) {
+            WriteIntent w(p, len);
+
+            // the first intent ending at or after our start is the first we could touch.  since
+            // ours are disjoint, they are ordered by start as well as by end.
+            set<WriteIntent>::iterator i = _intents.lower_bound(WriteIntent(p, 0));
+            if( i != _intents.end() && i->contains(w) )
+                return;
+            while( i != _intents.end() && i->start() <= w.end() ) {
+                w.absorb(*i);
+                _intents.erase(i++);
+            }
+            _intents.insert(i, w);
+            wassert( _intents.size() < 2000000 );
+        }
+
         void IntentsAndDurOps::clear() {
             assertLockedForCommitting();
             commitJob.groupCommitMutex.dassertLocked();
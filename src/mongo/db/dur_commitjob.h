@@ -89,17 +89,17 @@ namespace mongo {
         /** our record of pending/uncommitted write intents */
         class IntentsAndDurOps : boost::noncopyable {
         public:
-            vector<WriteIntent> _intents;
+            /** disjoint, non-adjacent ranges: overlapping and adjacent intents are merged as they
+                are inserted, so a big batch of updates to the same pages stays small
+            */
+            set<WriteIntent> _intents;
             Already<127> _alreadyNoted;
             vector< shared_ptr<DurOp> > _durOps; // all the ops other than basic writes
 
             /** reset the IntentsAndDurOps structure (empties all the above) */
             void clear();
 
-            void insertWriteIntent(void* p, int len) {
-                _intents.push_back(WriteIntent(p,len));
-                wassert( _intents.size() < 2000000 );
-            }
+            void insertWriteIntent(void* p, int len);
             #if defined(DEBUG_WRITE_INTENT)
             map<void*,int> _debug;
             #endif
@@ -171,12 +171,10 @@ namespace mongo {
             /** we check how much written and if it is getting to be a lot, we commit sooner. */
             size_t bytes() const { return _bytes; }
 
-            /** used in prepbasicwrites. sorted so that overlapping and duplicate items 
-             * can be merged.  we sort here so the caller receives something they must 
-             * keep const from their pov. */
-            const vector<WriteIntent>& getIntentsSorted() {
+            /** used in prepbasicwrites. sorted by address, with overlapping and adjacent
+             * intents already merged. */
+            const set<WriteIntent>& getIntentsSorted() {
                 groupCommitMutex.dassertLocked();
-                sort(_intentsAndDurOps._intents.begin(), _intentsAndDurOps._intents.end());
                 return _intentsAndDurOps._intents;
             }
 
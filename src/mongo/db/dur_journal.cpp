@@ -754,6 +754,7 @@ namespace mongo {
                 verify( _curLogFile );
 
                 stats.curr->_uncompressedBytes += uncompressed.len();
+                stats.curr->_compressedBytes += compressedLength;
                 unsigned w = b.len();
                 _written += w;
                 verify( w <= L );
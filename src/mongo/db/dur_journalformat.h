@@ -61,7 +61,9 @@ namespace mongo {
 
         /** "Section" header.  A section corresponds to a group commit.
             len is length of the entire section including header and footer.
-            header and footer are not compressed, just the stuff in between.
+            header and footer are not compressed, just the stuff in between.  the stuff in between
+            is the JEntry/DurOp stream as built by PREPLOGBUFFER, compressed as a single snappy
+            block (see Journal::journal) unless built with _NOCOMPRESS.
         */
         struct JSectHeader {
         private:
@@ -65,12 +65,8 @@ namespace mongo {
             size_t ofs = 1;
             DurableMappedFile *mmf = findMMF_inlock(i->start(), /*out*/ofs);
 
-            if( unlikely(!mmf->willNeedRemap()) ) {
-                // tag this mmf as needed a remap of its private view later.
-                // usually it will already be dirty/already set, so we do the if above first
-                // to avoid possibility of cpu cache line contention
-                mmf->willNeedRemap() = true;
-            }
+            // tag this part of the mmf as needing a remap of its private view later.
+            mmf->noteWrite(ofs, i->length());
 
             // since we have already looked up the mmf, we go ahead and remember the write view location
             // so we don't have to find the DurableMappedFile again later in WRITETODATAFILES()
@@ -129,23 +125,13 @@ namespace mongo {
             RelativePath lastDbPath;
 
             assertNothingSpooled();
-            const vector<WriteIntent>& _intents = commitJob.getIntentsSorted();
+            const set<WriteIntent>& _intents = commitJob.getIntentsSorted();
             verify( !_intents.empty() );
 
-            WriteIntent last;
-            for( vector<WriteIntent>::const_iterator i = _intents.begin(); i != _intents.end(); i++ ) { 
-                if( i->start() < last.end() ) { 
-                    // overlaps
-                    last.absorb(*i);
-                }
-                else { 
-                    // discontinuous
-                    if( i != _intents.begin() )
-                        prepBasicWrite_inlock(bb, &last, lastDbPath);
-                    last = *i;
-                }
+            // overlapping intents were merged as they were noted
+            for( set<WriteIntent>::const_iterator i = _intents.begin(); i != _intents.end(); i++ ) { 
+                prepBasicWrite_inlock(bb, &*i, lastDbPath);
             }
-            prepBasicWrite_inlock(bb, &last, lastDbPath);
         }
 
         static void resetLogBuffer(/*out*/JSectHeader& h, AlignedBuilder& bb) {
@@ -37,17 +37,24 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/bufreader.h"
 #include "mongo/util/checksum.h"
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/progress_meter.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
 
 namespace mongo {
 
+    // Threads that parse journal sections ahead and apply the writes for different data files
+    // concurrently during recovery.  1 recovers serially.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(journalRecoveryThreads, int, 4);
+
     namespace dur {
 
         struct ParsedJournalEntry { /*copyable*/
@@ -184,6 +191,79 @@ namespace mongo {
 
         };
 
+        /** a journal section that is parsed ahead of being applied during recovery */
+        struct ParsedSection : boost::noncopyable {
+            ParsedSection(const JSectHeader *h, const char *data, unsigned len, const JSectFooter *f)
+                : h(h), data(data), len(len), f(f), skip(false), eof(false), errCode(0) { }
+
+            const JSectHeader *h;
+            const char *data;
+            unsigned len;
+            const JSectFooter *f;
+
+            bool skip; // already in the data files before the crash
+
+            // the iterator owns the uncompressed buffer that the entries point into
+            auto_ptr<JournalSectionIterator> it;
+            vector<ParsedJournalEntry> entries;
+
+            // a parse failure is reported when the section's turn to be applied comes
+            bool eof;
+            int errCode;
+            string errMsg;
+        };
+
+        // limits on what is parsed ahead; each section holds its uncompressed entries until applied
+        static const size_t kMaxSectionsAhead = 32;
+        static const unsigned kMaxBytesAhead = 64 * 1024 * 1024;
+
+        /** uncompresses and parses a section and checks its footer.  runs on the recovery pool. */
+        static void parseSection(ParsedSection *s) {
+            try {
+                s->it.reset(new JournalSectionIterator(*s->h, s->data, s->len, true));
+                ParsedJournalEntry e;
+                while( !s->it->atEof() ) {
+                    s->it->next(e);
+                    s->entries.push_back(e);
+                }
+                if( !s->f->checkHash(s->h, s->len + sizeof(JSectHeader)) ) {
+                    msgasserted(13594, "journal checksum doesn't match");
+                }
+            }
+            catch( BufReader::eof& ) {
+                s->eof = true;
+            }
+            catch( DBException& e ) {
+                s->errCode = e.getCode();
+                s->errMsg = e.what();
+            }
+            catch( std::exception& e ) {
+                s->errCode = 16994;
+                s->errMsg = e.what();
+            }
+        }
+
+        /** the writes of a run of entries that go to one data file, in journal order */
+        struct FileWrites {
+            FileWrites() : mmf(0), bytes(0) { }
+            DurableMappedFile *mmf;
+            vector<const JEntry*> writes;
+            unsigned long long bytes;
+        };
+
+        static void applyFileWrites(FileWrites *w) {
+            char *view = (char *) w->mmf->view_write();
+            const unsigned long long length = w->mmf->length();
+            for( vector<const JEntry*>::const_iterator i = w->writes.begin(); i != w->writes.end(); ++i ) {
+                const JEntry *e = *i;
+                // writes past the end are dropped as in write(); a later op truncated the file
+                if( (unsigned long long) e->ofs + e->len <= length ) {
+                    memcpy(view + e->ofs, e->srcData(), e->len);
+                    w->bytes += e->len;
+                }
+            }
+        }
+
         static string fileName(const char* dbName, int fileNo) {
             stringstream ss;
             ss << dbName << '.';
@@ -200,6 +280,7 @@ namespace mongo {
         }
 
         RecoveryJob::~RecoveryJob() {
+            _pool.reset();
             DESTRUCTOR_GUARD(
                 if( !_mmfs.empty() )
                     close();
@@ -351,11 +432,70 @@ namespace mongo {
                 log() << "END section" << endl;
         }
 
-        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
-            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
-            scoped_lock lk(_mx);
-            RACECHECK
+        /** applies the basic writes entries[begin, end) on the pool, one task per data file.
+            writes to different files can't overlap, and each file's writes keep journal order.
+        */
+        void RecoveryJob::applyWrites(const vector<ParsedJournalEntry> &entries, size_t begin, size_t end) {
+            map<DurableMappedFile*, FileWrites> files;
+            Last last;
+            for( size_t i = begin; i != end; ++i ) {
+                const ParsedJournalEntry& entry = entries[i];
+                verify(entry.dbName);
+                verify((size_t)strnlen(entry.dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+
+                DurableMappedFile *mmf = last.newEntry(entry, *this);
+                FileWrites& w = files[mmf];
+                if( !w.mmf ) {
+                    verify(mmf->view_write());
+                    w.mmf = mmf;
+                }
+                w.writes.push_back(entry.e);
+            }
+
+            if( files.size() == 1 ) {
+                applyFileWrites(&files.begin()->second);
+            }
+            else {
+                for( map<DurableMappedFile*, FileWrites>::iterator i = files.begin(); i != files.end(); ++i ) {
+                    _pool->schedule(applyFileWrites, &i->second);
+                }
+                _pool->join();
+            }
+
+            for( map<DurableMappedFile*, FileWrites>::const_iterator i = files.begin(); i != files.end(); ++i ) {
+                stats.curr->_writeToDataFilesBytes += i->second.bytes;
+            }
+        }
+
+        void RecoveryJob::applyEntriesInParallel(const vector<ParsedJournalEntry> &entries) {
+            bool apply = (cmdLine.durOptions & CmdLine::DurScanOnly) == 0;
+            bool dump = cmdLine.durOptions & CmdLine::DurDumpJournal;
+            if( !apply || dump ) {
+                applyEntries(entries);
+                return;
+            }
 
+            // DurOps are barriers: they may create, drop or close files the writes around them use
+            size_t begin = 0;
+            while( begin != entries.size() ) {
+                size_t end = begin;
+                while( end != entries.size() && entries[end].e ) {
+                    ++end;
+                }
+                if( end != begin ) {
+                    applyWrites(entries, begin, end);
+                }
+                if( end != entries.size() ) {
+                    Last last;
+                    applyEntry(last, entries[end], true, false);
+                    ++end;
+                }
+                begin = end;
+            }
+        }
+
+        /** @return true if the section was already in the data files before the crash */
+        bool RecoveryJob::skipSection(const JSectHeader *h) {
             /** todo: we should really verify the checksum to see that seqNumber is ok?
                       that is expensive maybe there is some sort of checksum of just the header 
                       within the header itself
@@ -371,6 +511,56 @@ namespace mongo {
                     }
                     _lastSeqMentionedInConsoleLog = h->seqNumber;
                 }
+                return true;
+            }
+            return false;
+        }
+
+        /** parses the sections read ahead on the pool, then applies them in journal order.
+            the sections are taken from 'ahead', which is left empty.
+        */
+        void RecoveryJob::processSections(OwnedPointerVector<ParsedSection> &ahead, ProgressMeter &pm) {
+            OwnedPointerVector<ParsedSection> sections;
+            sections.mutableVector().swap(ahead.mutableVector());
+
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            RACECHECK
+
+            for( size_t i = 0; i != sections.vector().size(); ++i ) {
+                ParsedSection *s = sections.vector()[i];
+                s->skip = skipSection(s->h);
+                if( !s->skip ) {
+                    _pool->schedule(parseSection, s);
+                }
+            }
+            _pool->join();
+
+            for( size_t i = 0; i != sections.vector().size(); ++i ) {
+                ParsedSection *s = sections.vector()[i];
+                if( !s->skip ) {
+                    // fail where serial recovery would have, with the sections before applied
+                    if( s->eof ) {
+                        throw BufReader::eof();
+                    }
+                    if( s->errCode ) {
+                        msgasserted(s->errCode, s->errMsg);
+                    }
+                    applyEntriesInParallel(s->entries);
+                }
+                pm.hit(s->h->sectionLenWithPadding());
+
+                // ctrl c check
+                killCurrentOp.checkForInterrupt(false);
+            }
+        }
+
+        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            RACECHECK
+
+            if( skipSection(h) ) {
                 return;
             }
 
@@ -419,6 +609,9 @@ namespace mongo {
             @return true if this is detected to be the last file (ends abruptly)
         */
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
+            ProgressMeter pm(len, 10, 1, "bytes", "recover progress");
+            OwnedPointerVector<ParsedSection> ahead;
+            unsigned aheadBytes = 0;
             try {
                 unsigned long long fileId;
                 BufReader br(p,len);
@@ -459,6 +652,9 @@ namespace mongo {
                             log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
                             log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
                         }
+                        if( !ahead.vector().empty() ) {
+                            processSections(ahead, pm);
+                        }
                         return true;
                     }
                     unsigned slen = h.sectionLen();
@@ -466,13 +662,36 @@ namespace mongo {
                     const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
+
+                    if( _pool ) {
+                        ahead.mutableVector().push_back(new ParsedSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer));
+                        aheadBytes += slen;
+                        if( ahead.vector().size() == kMaxSectionsAhead || aheadBytes >= kMaxBytesAhead ) {
+                            processSections(ahead, pm);
+                            aheadBytes = 0;
+                        }
+                        continue;
+                    }
+
                     processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+                    pm.hit(h.sectionLenWithPadding());
 
                     // ctrl c check
                     killCurrentOp.checkForInterrupt(false);
                 }
+
+                if( !ahead.vector().empty() ) {
+                    processSections(ahead, pm);
+                }
             }
             catch( BufReader::eof& ) {
+                // the complete sections read ahead of the end still get applied
+                if( !ahead.vector().empty() ) {
+                    try {
+                        processSections(ahead, pm);
+                    }
+                    catch( BufReader::eof& ) { }
+                }
                 if( cmdLine.durOptions & CmdLine::DurDumpJournal )
                     log() << "ABRUPT END" << endl;
                 return true; // abrupt end
@@ -511,6 +730,10 @@ namespace mongo {
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
 
+            if( journalRecoveryThreads > 1 ) {
+                _pool.reset(new ThreadPool(journalRecoveryThreads));
+            }
+
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
                 if( abruptEnd && i+1 < files.size() ) {
@@ -521,6 +744,7 @@ namespace mongo {
             }
 
             close();
+            _pool.reset();
 
             if( cmdLine.durOptions & CmdLine::DurScanOnly ) {
                 uasserted(13545, str::stream() << "--durOptions " << (int) CmdLine::DurScanOnly << " (scan only) specified");
@@ -19,17 +19,25 @@
 #pragma once
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <list>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
     class DurableMappedFile;
+    class ProgressMeter;
+
+    namespace threadpool {
+        class ThreadPool;
+    }
 
     namespace dur {
         struct ParsedJournalEntry;
+        struct ParsedSection;
 
         /** call go() to execute a recovery from existing journal files.
          */
@@ -59,6 +67,10 @@ namespace mongo {
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const vector<ParsedJournalEntry> &entries);
+            void applyEntriesInParallel(const vector<ParsedJournalEntry> &entries);
+            void applyWrites(const vector<ParsedJournalEntry> &entries, size_t begin, size_t end);
+            bool skipSection(const JSectHeader *h);
+            void processSections(OwnedPointerVector<ParsedSection> &ahead, ProgressMeter &pm);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
@@ -73,6 +85,10 @@ namespace mongo {
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
 
+            // parses sections ahead and applies writes to distinct files concurrently during
+            // recovery.  null when recovering serially or doing WRITETODATAFILES.
+            boost::scoped_ptr<threadpool::ThreadPool> _pool;
+
             static RecoveryJob &_instance;
         };
     }
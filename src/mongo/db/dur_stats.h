@@ -37,6 +37,7 @@ namespace mongo {
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
                 unsigned long long _journaledBytes;
                 unsigned long long _uncompressedBytes;
+                unsigned long long _compressedBytes; // snappy output, before padding to Alignment
                 unsigned long long _writeToDataFilesBytes;
 
                 unsigned long long _prepLogBufferMicros;
@@ -51,6 +52,13 @@ namespace mongo {
                 // - data being written faster than the normal group commit interval
                 unsigned _commitsInWriteLock;
 
+                // time from preparing a commit's log buffer until it is in the journal, which is
+                // what getlasterror j:true waiters wait on.  bucket i counts commits that took at
+                // most 2^i ms; the last bucket counts everything slower.
+                enum { NCommitLatencyBuckets = 10 };
+                unsigned _commitLatency[NCommitLatencyBuckets];
+                void recordCommitLatency(unsigned long long micros);
+
                 unsigned _dtMillis;
             };
             S *curr;
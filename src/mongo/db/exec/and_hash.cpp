@@ -36,7 +36,7 @@ namespace mongo {
         return _dataMap.end() == _resultIterator;
     }
 
-    PlanStage::StageState AndHashStage::work(WorkingSetID* out) {
+    PlanStage::StageState AndHashStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         // An AND is either reading the first child into the hash table, probing against the hash
@@ -56,11 +56,11 @@ namespace mongo {
         verify(!_shouldScanChildren);
 
         // Keep the thing we're returning so we can remove it from our internal map later.
-        DataMap::iterator returnedIt = _resultIterator;
+        DataMap::const_iterator returnedIt = _resultIterator;
         ++_resultIterator;
 
-        WorkingSetID idToReturn = returnedIt->second;
-        _dataMap.erase(returnedIt);
+        WorkingSetID idToReturn = returnedIt->second.id;
+        _dataMap.erase(returnedIt->first);
         WorkingSetMember* member = _ws->get(idToReturn);
 
         // We should check for matching at the end so the matcher can use information in the
@@ -88,7 +88,7 @@ namespace mongo {
             verify(member->hasLoc());
             verify(_dataMap.end() == _dataMap.find(member->loc));
 
-            _dataMap[member->loc] = id;
+            _dataMap[member->loc].id = id;
             return PlanStage::NEED_TIME;
         }
         else if (PlanStage::IS_EOF == childStatus) {
@@ -99,6 +99,7 @@ namespace mongo {
                 _shouldScanChildren = false;
                 return PlanStage::IS_EOF;
             }
+            rebuildFilter();
             return PlanStage::NEED_TIME;
         }
         else {
@@ -115,35 +116,32 @@ namespace mongo {
         if (PlanStage::ADVANCED == childStatus) {
             WorkingSetMember* member = _ws->get(id);
             verify(member->hasLoc());
-            if (_dataMap.end() == _dataMap.find(member->loc)) {
+            if (!_filter.mayContain(hashOf(member->loc))
+                || _dataMap.end() == _dataMap.find(member->loc)) {
                 // Ignore.  It's not in any previous child.
             }
             else {
                 // We have a hit.  Copy data into the WSM we already have.
-                _seenMap.insert(member->loc);
-                WorkingSetMember* olderMember = _ws->get(_dataMap[member->loc]);
+                DataEntry& entry = _dataMap.get(member->loc);
+                entry.lastChildSeen = _currentChild;
+                WorkingSetMember* olderMember = _ws->get(entry.id);
                 AndCommon::mergeFrom(olderMember, member);
             }
             _ws->free(id);
             return PlanStage::NEED_TIME;
         }
         else if (PlanStage::IS_EOF == childStatus) {
-            // Finished with a child.
-            ++_currentChild;
-
-            // Keep elements of _dataMap that are in _seenMap.
-            DataMap::iterator it = _dataMap.begin();
-            while (it != _dataMap.end()) {
-                if (_seenMap.end() == _seenMap.find(it->first)) {
-                    DataMap::iterator toErase = it;
-                    ++it;
-                    _ws->free(toErase->second);
-                    _dataMap.erase(toErase);
+            // Keep elements of _dataMap that this child produced.  Erasing doesn't move
+            // other entries, so the iterator stays good.
+            for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+                if (it->second.lastChildSeen != _currentChild) {
+                    _ws->free(it->second.id);
+                    _dataMap.erase(it->first);
                 }
-                else { ++it; }
             }
 
-            _seenMap.clear();
+            // Finished with a child.
+            ++_currentChild;
 
             // _dataMap is now the intersection of the first _currentChild nodes.
 
@@ -158,6 +156,9 @@ namespace mongo {
                 _shouldScanChildren = false;
                 _resultIterator = _dataMap.begin();
             }
+            else {
+                rebuildFilter();
+            }
 
             return PlanStage::NEED_TIME;
         }
@@ -167,35 +168,43 @@ namespace mongo {
         }
     }
 
+    void AndHashStage::rebuildFilter() {
+        _filter.reset(_dataMap.size());
+        for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+            _filter.insert(hashOf(it->first));
+        }
+    }
+
     void AndHashStage::prepareToYield() {
+        ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->prepareToYield();
         }
     }
 
     void AndHashStage::recoverFromYield() {
+        ++_commonStats.unyields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->recoverFromYield();
         }
     }
 
     void AndHashStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         if (isEOF()) { return; }
 
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->invalidate(dl);
         }
 
-        _seenMap.erase(dl);
-
         // If we're pointing at the DiskLoc, move past it.  It will be deleted.
         if (_dataMap.end() != _resultIterator && (_resultIterator->first == dl)) {
             ++_resultIterator;
         }
 
-        DataMap::iterator it = _dataMap.find(dl);
+        DataMap::const_iterator it = _dataMap.find(dl);
         if (_dataMap.end() != it) {
-            WorkingSetID id = it->second;
+            WorkingSetID id = it->second.id;
             WorkingSetMember* member = _ws->get(id);
             verify(member->loc == dl);
 
@@ -204,8 +213,17 @@ namespace mongo {
 
             // Add the WSID to the to-be-reviewed list in the WS.
             _ws->flagForReview(id);
-            _dataMap.erase(it);
+            _dataMap.erase(dl);
+        }
+    }
+
+    PlanStageStats* AndHashStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "AND_HASH"));
+        for (size_t i = 0; i < _children.size(); ++i) {
+            ret->children.push_back(_children[i]->getStats());
         }
+        return ret.release();
     }
 
 }  // namespace mongo
@@ -22,8 +22,9 @@
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
+#include "mongo/db/exec/blocked_bloom_filter.h"
 #include "mongo/db/exec/plan_stage.h"
-#include "mongo/platform/unordered_set.h"
+#include "mongo/util/unordered_fast_key_table.h"
 
 namespace mongo {
 
@@ -31,6 +32,10 @@ namespace mongo {
      * Reads from N children, each of which must have a valid DiskLoc.  Uses a hash table to
      * intersect the outputs of the N children, and outputs the intersection.
      *
+     * The table is open addressed, so a probe doesn't chase list nodes, and each probe is first
+     * checked against a Bloom filter of the table's keys.  Most results from the later children
+     * aren't in the intersection, and the filter turns those away from one cache line.
+     *
      * Preconditions: Valid DiskLoc.  More than one child.
      *
      * Any DiskLoc that we keep a reference to that is invalidated before we are able to return it
@@ -45,13 +50,17 @@ namespace mongo {
 
         void addChild(PlanStage* child);
 
-        virtual StageState work(WorkingSetID* out);
         virtual bool isEOF();
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         StageState readFirstChild();
         StageState hashOtherChildren();
@@ -63,16 +72,47 @@ namespace mongo {
         // The stages we read from.  Owned by us.
         vector<PlanStage*> _children;
 
+        // Rebuilds _filter from the keys of _dataMap.
+        void rebuildFilter();
+
+        static uint64_t hashOf(const DiskLoc& dl) {
+            return BlockedBloomFilter::mix((static_cast<uint64_t>(dl.a()) << 32)
+                                           | static_cast<uint32_t>(dl.getOfs()));
+        }
+
+        struct DiskLocHash {
+            size_t operator()(const DiskLoc& dl) const { return hashOf(dl); }
+        };
+
+        struct DiskLocEquals {
+            bool operator()(const DiskLoc& a, const DiskLoc& b) const { return a == b; }
+        };
+
+        struct DiskLocIdentity {
+            const DiskLoc& operator()(const DiskLoc& dl) const { return dl; }
+        };
+
+        struct DataEntry {
+            DataEntry() : id(WorkingSet::INVALID_ID), lastChildSeen(0) { }
+
+            WorkingSetID id;
+
+            // The last child that produced this DiskLoc.  Entries that the child being read
+            // doesn't produce are dropped when it hits EOF.
+            size_t lastChildSeen;
+        };
+
         // _dataMap is filled out by the first child and probed by subsequent children.
-        typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
+        typedef UnorderedFastKeyTable<DiskLoc, DiskLoc, DataEntry, DiskLocHash, DiskLocEquals,
+                                      DiskLocIdentity> DataMap;
         DataMap _dataMap;
 
-        // Keeps track of what elements from _dataMap subsequent children have seen.
-        typedef unordered_set<DiskLoc, DiskLoc::Hasher> SeenMap;
-        SeenMap _seenMap;
+        // Holds the keys of _dataMap as of the end of the last child.  Entries removed since
+        // are still in it, which only costs a table probe.
+        BlockedBloomFilter _filter;
 
         // Iterator over the members of _dataMap that survive.
-        DataMap::iterator _resultIterator;
+        DataMap::const_iterator _resultIterator;
 
         // True if we're still scanning _children for results.
         bool _shouldScanChildren;
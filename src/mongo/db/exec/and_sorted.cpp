@@ -35,7 +35,7 @@ namespace mongo {
 
     bool AndSortedStage::isEOF() { return _isEOF; }
 
-    PlanStage::StageState AndSortedStage::work(WorkingSetID* out) {
+    PlanStage::StageState AndSortedStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         // If we don't have any nodes that we're work()-ing until they hit a certain DiskLoc...
@@ -166,18 +166,21 @@ namespace mongo {
     }
 
     void AndSortedStage::prepareToYield() {
+        ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->prepareToYield();
         }
     }
 
     void AndSortedStage::recoverFromYield() {
+        ++_commonStats.unyields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->recoverFromYield();
         }
     }
 
     void AndSortedStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         if (isEOF()) { return; }
 
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -196,4 +199,13 @@ namespace mongo {
         }
     }
 
+    PlanStageStats* AndSortedStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "AND_SORTED"));
+        for (size_t i = 0; i < _children.size(); ++i) {
+            ret->children.push_back(_children[i]->getStats());
+        }
+        return ret.release();
+    }
+
 }  // namespace mongo
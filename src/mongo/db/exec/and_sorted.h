@@ -46,13 +46,17 @@ namespace mongo {
 
         void addChild(PlanStage* child);
 
-        virtual StageState work(WorkingSetID* out);
         virtual bool isEOF();
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         // Find a node to AND against.
         PlanStage::StageState getTargetLoc();
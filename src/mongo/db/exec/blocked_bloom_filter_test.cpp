@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/blocked_bloom_filter.h
+ */
+
+#include "mongo/db/exec/blocked_bloom_filter.h"
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(BlockedBloomFilterTest, UnsizedContainsEverything) {
+        BlockedBloomFilter filter;
+        ASSERT_TRUE(filter.mayContain(BlockedBloomFilter::mix(1)));
+    }
+
+    TEST(BlockedBloomFilterTest, NoFalseNegatives) {
+        const uint64_t n = 10000;
+        BlockedBloomFilter filter;
+        filter.reset(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            filter.insert(BlockedBloomFilter::mix(i));
+        }
+        for (uint64_t i = 0; i < n; ++i) {
+            ASSERT_TRUE(filter.mayContain(BlockedBloomFilter::mix(i)));
+        }
+    }
+
+    TEST(BlockedBloomFilterTest, FewFalsePositives) {
+        const uint64_t n = 10000;
+        BlockedBloomFilter filter;
+        filter.reset(n);
+        for (uint64_t i = 0; i < n; ++i) {
+            filter.insert(BlockedBloomFilter::mix(i));
+        }
+
+        uint64_t falsePositives = 0;
+        for (uint64_t i = n; i < 2 * n; ++i) {
+            if (filter.mayContain(BlockedBloomFilter::mix(i))) {
+                ++falsePositives;
+            }
+        }
+        ASSERT_LESS_THAN(falsePositives, n / 20);
+    }
+
+    TEST(BlockedBloomFilterTest, ResetEmpties) {
+        BlockedBloomFilter filter;
+        filter.reset(100);
+        for (uint64_t i = 0; i < 100; ++i) {
+            filter.insert(BlockedBloomFilter::mix(i));
+        }
+        filter.reset(100);
+
+        uint64_t hits = 0;
+        for (uint64_t i = 0; i < 100; ++i) {
+            if (filter.mayContain(BlockedBloomFilter::mix(i))) {
+                ++hits;
+            }
+        }
+        ASSERT_EQUALS(0U, hits);
+    }
+
+}  // namespace
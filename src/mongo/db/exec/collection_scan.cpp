@@ -31,7 +31,7 @@ namespace mongo {
                                                        _params(params),
                                                        _nsDropped(false) { }
 
-    PlanStage::StageState CollectionScan::work(WorkingSetID* out) {
+    PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         if (NULL == _iter) {
             NamespaceDetails* nsd = nsdetails(_params.ns);
 
@@ -75,14 +75,26 @@ namespace mongo {
         return _iter->isEOF();
     }
 
-    void CollectionScan::invalidate(const DiskLoc& dl) { _iter->invalidate(dl); }
+    void CollectionScan::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _iter->invalidate(dl);
+    }
 
-    void CollectionScan::prepareToYield() { _iter->prepareToYield(); }
+    void CollectionScan::prepareToYield() {
+        ++_commonStats.yields;
+        _iter->prepareToYield();
+    }
 
     void CollectionScan::recoverFromYield() {
+        ++_commonStats.unyields;
         if (!_iter->recoverFromYield()) {
             _nsDropped = true;
         }
     }
 
+    PlanStageStats* CollectionScan::getStats() {
+        _commonStats.isEOF = isEOF();
+        return new PlanStageStats(_commonStats, "COLLSCAN");
+    }
+
 }  // namespace mongo
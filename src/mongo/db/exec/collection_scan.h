@@ -37,13 +37,17 @@ namespace mongo {
         CollectionScan(const CollectionScanParams& params, WorkingSet* workingSet,
                        Matcher* matcher);
 
-        virtual StageState work(WorkingSetID* out);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl);
+
+        virtual PlanStageStats* getStats();
         virtual void prepareToYield();
         virtual void recoverFromYield();
 
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         // WorkingSet is not owned by us.
         WorkingSet* _workingSet;
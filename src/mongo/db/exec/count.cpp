@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/exec/count.h"
+
+namespace mongo {
+
+    CountStage::CountStage(WorkingSet* ws, PlanStage* child)
+        : _ws(ws), _child(child), _count(0), _returned(false) { }
+
+    CountStage::~CountStage() { }
+
+    bool CountStage::isEOF() { return _returned; }
+
+    PlanStage::StageState CountStage::doWork(WorkingSetID* out) {
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        WorkingSetID id;
+        StageState status = _child->work(&id);
+
+        if (PlanStage::ADVANCED == status) {
+            ++_count;
+            _ws->free(id);
+            return PlanStage::NEED_TIME;
+        }
+        else if (PlanStage::IS_EOF == status) {
+            WorkingSetID countId = _ws->allocate();
+            WorkingSetMember* member = _ws->get(countId);
+            member->obj = BSON("n" << _count);
+            member->state = WorkingSetMember::OWNED_OBJ;
+            _returned = true;
+            *out = countId;
+            return PlanStage::ADVANCED;
+        }
+        else {
+            if (PlanStage::NEED_FETCH == status) { *out = id; }
+            // NEED_TIME/YIELD, ERROR
+            return status;
+        }
+    }
+
+    void CountStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
+
+    void CountStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
+
+    void CountStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _child->invalidate(dl);
+    }
+
+    PlanStageStats* CountStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "COUNT"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,68 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/exec/plan_stage.h"
+
+namespace mongo {
+
+    /**
+     * This stage counts its child's results.  It frees each one as it arrives and, once the child
+     * is EOF, returns a single result {n: <count>}.
+     *
+     * With an index scan below that doesn't need key data (see IndexScanParams::needKeyData), a
+     * count never reads a document or copies a key.
+     *
+     * In WorkingSetMember terms, the one result is OWNED_OBJ.
+     *
+     * Preconditions: None.
+     */
+    class CountStage : public PlanStage {
+    public:
+        CountStage(WorkingSet* ws, PlanStage* child);
+        virtual ~CountStage();
+
+        virtual bool isEOF();
+
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+        virtual void invalidate(const DiskLoc& dl);
+
+        virtual PlanStageStats* getStats();
+
+        /**
+         * The number of results counted so far.
+         */
+        long long getCount() const { return _count; }
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
+    private:
+        // _ws is not owned by us.
+        WorkingSet* _ws;
+        scoped_ptr<PlanStage> _child;
+
+        long long _count;
+
+        // Have we returned the count?
+        bool _returned;
+    };
+
+}  // namespace mongo
@@ -26,8 +26,10 @@ namespace mongo {
     MONGO_FP_DECLARE(fetchInMemoryFail);
     MONGO_FP_DECLARE(fetchInMemorySucceed);
 
-    FetchStage::FetchStage(WorkingSet* ws, PlanStage* child, Matcher* matcher)
-        : _ws(ws), _child(child), _matcher(matcher), _idBeingPagedIn(WorkingSet::INVALID_ID) { }
+    FetchStage::FetchStage(WorkingSet* ws, PlanStage* child, Matcher* matcher,
+                           size_t prefetchDepth)
+        : _ws(ws), _child(child), _matcher(matcher), _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _prefetchDepth(prefetchDepth) { }
 
     FetchStage::~FetchStage() { }
 
@@ -38,6 +40,8 @@ namespace mongo {
             return false;
         }
 
+        if (!_lookahead.empty()) { return false; }
+
         return _child->isEOF();
     }
 
@@ -53,7 +57,7 @@ namespace mongo {
         return Record::likelyInPhysicalMemory(data);
     }
 
-    PlanStage::StageState FetchStage::work(WorkingSetID* out) {
+    PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         // If we asked our parent for a page-in last time work(...) was called, finish the fetch.
@@ -61,52 +65,106 @@ namespace mongo {
             return fetchCompleted(out);
         }
 
-        // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another to-be-fetched
-        // result from our child.
-        WorkingSetID id;
-        StageState status = _child->work(&id);
+        if (0 == _prefetchDepth) {
+            // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another
+            // to-be-fetched result from our child.
+            WorkingSetID id;
+            StageState status = _child->work(&id);
 
-        if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
+            if (PlanStage::ADVANCED == status) {
+                return fetchOrRequest(id, out);
+            }
+            else {
+                // NEED_TIME/YIELD, ERROR, IS_EOF
+                if (PlanStage::NEED_FETCH == status) { *out = id; }
+                return status;
+            }
+        }
 
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                return returnIfMatches(member, id, out);
+        // Keep the lookahead full so that page-ins overlap with returning the results ahead
+        // of them.
+        if (_lookahead.size() < _prefetchDepth && !_child->isEOF()) {
+            StageState status = readAhead(out);
+            if (PlanStage::ADVANCED != status && PlanStage::IS_EOF != status) {
+                // NEED_TIME/YIELD, ERROR, or a fetch request from our child
+                return status;
+            }
+            if (_lookahead.size() < _prefetchDepth && !_child->isEOF()) {
+                return PlanStage::NEED_TIME;
             }
+        }
 
-            // We need a valid loc to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::LOC_AND_IDX == member->state);
-            verify(member->hasLoc());
+        if (_lookahead.empty()) { return PlanStage::IS_EOF; }
 
+        WorkingSetID id = _lookahead.front();
+        _lookahead.pop_front();
+        return fetchOrRequest(id, out);
+    }
+
+    PlanStage::StageState FetchStage::readAhead(WorkingSetID* out) {
+        WorkingSetID id;
+        StageState status = _child->work(&id);
+
+        if (PlanStage::ADVANCED != status) {
+            if (PlanStage::NEED_FETCH == status) { *out = id; }
+            return status;
+        }
+
+        WorkingSetMember* member = _ws->get(id);
+        if (!member->hasObj()) {
+            verify(member->hasLoc());
             Record* record = member->loc.rec();
-            const char* data = record->dataNoThrowing();
-
-            if (!recordInMemory(data)) {
-                // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
-                verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
-                _idBeingPagedIn = id;
-                *out = id;
-                return PlanStage::NEED_FETCH;
-            }
-            else {
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = BSONObj(data);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-                return returnIfMatches(member, id, out);
+            if (!recordInMemory(record->dataNoThrowing())) {
+                record->prefetch();
             }
         }
+        _lookahead.push_back(id);
+        return PlanStage::ADVANCED;
+    }
+
+    PlanStage::StageState FetchStage::fetchOrRequest(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            return returnIfMatches(member, id, out);
+        }
+
+        // We need a valid loc to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::LOC_AND_IDX == member->state);
+        verify(member->hasLoc());
+
+        Record* record = member->loc.rec();
+        const char* data = record->dataNoThrowing();
+
+        if (!recordInMemory(data)) {
+            // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
+            verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+            _idBeingPagedIn = id;
+            *out = id;
+            return PlanStage::NEED_FETCH;
+        }
         else {
-            // NEED_TIME/YIELD, ERROR, IS_EOF
-            return status;
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = BSONObj(data);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            return returnIfMatches(member, id, out);
         }
     }
 
-    void FetchStage::prepareToYield() { _child->prepareToYield(); }
+    void FetchStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
 
-    void FetchStage::recoverFromYield() { _child->recoverFromYield(); }
+    void FetchStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
 
     void FetchStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         _child->invalidate(dl);
 
         // If we're holding on to an object that we're waiting for the runner to page in...
@@ -120,6 +178,14 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(member);
             }
         }
+
+        // Results we've read ahead are ours now, not our child's, so we handle them here.
+        for (size_t i = 0; i < _lookahead.size(); ++i) {
+            WorkingSetMember* member = _ws->get(_lookahead[i]);
+            if (member->hasLoc() && member->loc == dl) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::fetchCompleted(WorkingSetID* out) {
@@ -168,4 +234,11 @@ namespace mongo {
         }
     }
 
+    PlanStageStats* FetchStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "FETCH"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
+
 }  // namespace mongo
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
@@ -30,19 +32,28 @@ namespace mongo {
      * the record at the provided loc.  Returns verbatim any data that already has an object.
      *
      * Preconditions: Valid DiskLoc.
+     *
+     * If prefetchDepth is nonzero, up to that many results are read ahead from the child and
+     * the OS is asked to start paging in any that aren't in memory.  Results are still returned
+     * in child order and a NEED_FETCH is still passed up for one that hasn't arrived by the time
+     * it's returned, but the page-ins for the ones behind it are by then already under way.
      */
     class FetchStage : public PlanStage {
     public:
-        FetchStage(WorkingSet* ws, PlanStage* child, Matcher* matcher);
+        FetchStage(WorkingSet* ws, PlanStage* child, Matcher* matcher, size_t prefetchDepth = 0);
         virtual ~FetchStage();
 
         virtual bool isEOF();
-        virtual StageState work(WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         /**
          * If the member (with id memberID) passes our filter, set *out to memberID and return that
@@ -56,6 +67,17 @@ namespace mongo {
          */
         StageState fetchCompleted(WorkingSetID* out);
 
+        /**
+         * Materializes the object for memberID if it is in memory, otherwise holds on to memberID
+         * and passes a fetch request up.
+         */
+        StageState fetchOrRequest(WorkingSetID memberID, WorkingSetID* out);
+
+        /**
+         * Pulls one result from the child into _lookahead, hinting a page-in for it if needed.
+         */
+        StageState readAhead(WorkingSetID* out);
+
         // _ws is not owned by us.
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
@@ -64,6 +86,11 @@ namespace mongo {
         // If we're fetching a DiskLoc and it points at something that's not in memory, we return a
         // a "please page this in" result and hold on to the WSID until the next call to work(...).
         WorkingSetID _idBeingPagedIn;
+
+        // Results read ahead of the one we're returning, in child order.  Never larger than
+        // _prefetchDepth.
+        size_t _prefetchDepth;
+        std::deque<WorkingSetID> _lookahead;
     };
 
 }  // namespace mongo
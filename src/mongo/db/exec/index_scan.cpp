@@ -39,7 +39,8 @@ namespace mongo {
           _endKey(params.endKey), _endKeyInclusive(params.endKeyInclusive),
           _direction(params.direction), _hitEnd(false),
           _matcher(matcher), _shouldDedup(params.descriptor->isMultikey()),
-          _yieldMovedCursor(false), _numWanted(params.limit) {
+          _yieldMovedCursor(false), _numWanted(params.limit),
+          _needKeyData(params.needKeyData) {
 
         string amName;
 
@@ -58,7 +59,7 @@ namespace mongo {
         }
     }
 
-    PlanStage::StageState IndexScan::work(WorkingSetID* out) {
+    PlanStage::StageState IndexScan::doWork(WorkingSetID* out) {
         if (NULL == _indexCursor.get()) {
             // First call to work().  Perform cursor init.
             CursorOptions cursorOptions;
@@ -105,11 +106,21 @@ namespace mongo {
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
         member->loc = loc;
-        member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(),
-                                                _indexCursor->getKey().getOwned()));
+        if (_needKeyData) {
+            member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(),
+                                                    _indexCursor->getKey().getOwned()));
+        }
+        else if (NULL != _matcher) {
+            // The key only has to outlive the match, and the cursor doesn't move until then.
+            member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(),
+                                                    _indexCursor->getKey()));
+        }
         member->state = WorkingSetMember::LOC_AND_IDX;
 
         if (NULL == _matcher || _matcher->matches(member)) {
+            if (!_needKeyData) {
+                member->keyData.clear();
+            }
             *out = id;
             return PlanStage::ADVANCED;
         }
@@ -129,6 +140,7 @@ namespace mongo {
     }
 
     void IndexScan::prepareToYield() {
+        ++_commonStats.yields;
         if (isEOF() || (NULL == _indexCursor.get())) { return; }
         _savedKey = _indexCursor->getKey().getOwned();
         _savedLoc = _indexCursor->getValue();
@@ -136,6 +148,7 @@ namespace mongo {
     }
 
     void IndexScan::recoverFromYield() {
+        ++_commonStats.unyields;
         if (isEOF() || (NULL == _indexCursor.get())) { return; }
 
         _indexCursor->restorePosition();
@@ -152,6 +165,7 @@ namespace mongo {
     }
 
     void IndexScan::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         // If we see this DiskLoc again, it may not be the same doc. it was before, so we want to
         // return it.
         _returned.erase(dl);
@@ -170,4 +184,9 @@ namespace mongo {
         }
     }
 
+    PlanStageStats* IndexScan::getStats() {
+        _commonStats.isEOF = isEOF();
+        return new PlanStageStats(_commonStats, "IXSCAN");
+    }
+
 }  // namespace mongo
@@ -41,12 +41,16 @@ namespace mongo {
         IndexScan(const IndexScanParams& params, WorkingSet* workingSet, Matcher* matcher);
         virtual ~IndexScan() { }
 
-        virtual StageState work(WorkingSetID* out);
         virtual bool isEOF();
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         /** See if the cursor is pointing at or past _endKey, if _endKey is non-empty. */
         void checkEnd();
@@ -83,11 +87,14 @@ namespace mongo {
 
         // This is IndexScanParams::limit.  See comment there.
         int _numWanted;
+
+        // This is IndexScanParams::needKeyData.  See comment there.
+        bool _needKeyData;
     };
 
     struct IndexScanParams {
         IndexScanParams() : descriptor(NULL), endKeyInclusive(true), direction(1), limit(0),
-                            forceBtreeAccessMethod(false) { }
+                            forceBtreeAccessMethod(false), needKeyData(true) { }
         IndexDescriptor* descriptor;
         BSONObj startKey;
         BSONObj endKey;
@@ -99,6 +106,11 @@ namespace mongo {
 
         // Special indices internally open an IndexCursor over themselves but as a straight Btree.
         bool forceBtreeAccessMethod;
+
+        // If false, results carry only their DiskLoc and no key data, which saves copying each
+        // key out of the index.  The filter still sees the key.  For consumers such as a count or
+        // a fetch that don't look at the key.
+        bool needKeyData;
     };
 
 }  // namespace mongo
@@ -25,7 +25,7 @@ namespace mongo {
 
     bool LimitStage::isEOF() { return (0 == _numToReturn) || _child->isEOF(); }
 
-    PlanStage::StageState LimitStage::work(WorkingSetID* out) {
+    PlanStage::StageState LimitStage::doWork(WorkingSetID* out) {
         // If we've returned as many results as we're limited to, isEOF will be true.
         if (isEOF()) { return PlanStage::IS_EOF; }
 
@@ -43,10 +43,26 @@ namespace mongo {
         }
     }
 
-    void LimitStage::prepareToYield() { _child->prepareToYield(); }
+    void LimitStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
 
-    void LimitStage::recoverFromYield() { _child->recoverFromYield(); }
+    void LimitStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
 
-    void LimitStage::invalidate(const DiskLoc& dl) { _child->invalidate(dl); }
+    void LimitStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _child->invalidate(dl);
+    }
+
+    PlanStageStats* LimitStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "LIMIT"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
 
 }  // namespace mongo
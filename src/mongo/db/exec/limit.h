@@ -35,12 +35,16 @@ namespace mongo {
         virtual ~LimitStage();
 
         virtual bool isEOF();
-        virtual StageState work(WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
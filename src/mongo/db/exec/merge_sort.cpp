@@ -23,7 +23,10 @@ namespace mongo {
 
     MergeSortStage::MergeSortStage(const MergeSortStageParams& params, WorkingSet* ws)
         : _ws(ws), _pattern(params.pattern), _dedup(params.dedup),
-          _merging(StageWithValueComparison(ws, params.pattern)) { }
+          _diskLocOrder(params.diskLocOrder),
+          _merging(StageWithValueComparison(ws, params.pattern, params.diskLocOrder)) {
+        verify(-1 <= _diskLocOrder && _diskLocOrder <= 1);
+    }
 
     MergeSortStage::~MergeSortStage() {
         for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
@@ -42,7 +45,7 @@ namespace mongo {
         return _merging.empty() && _noResultToMerge.empty();
     }
 
-    PlanStage::StageState MergeSortStage::work(WorkingSetID* out) {
+    PlanStage::StageState MergeSortStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         if (!_noResultToMerge.empty()) {
@@ -53,8 +56,9 @@ namespace mongo {
             StageState code = child->work(&id);
 
             if (PlanStage::ADVANCED == code) {
-                // If we're deduping...
-                if (_dedup) {
+                // If we're deduping with a seen set...  Otherwise copies are dropped as they come
+                // off the merge.
+                if (_dedup && 0 == _diskLocOrder) {
                     WorkingSetMember* member = _ws->get(id);
 
                     if (!member->hasLoc()) {
@@ -122,24 +126,39 @@ namespace mongo {
         WorkingSetID idToTest = top->id;
         _mergingData.erase(top);
 
+        if (_dedup && 0 != _diskLocOrder) {
+            WorkingSetMember* member = _ws->get(idToTest);
+            if (member->hasLoc()) {
+                // Copies of a record are merged next to each other.
+                if (member->loc == _lastReturned) {
+                    _ws->free(idToTest);
+                    return PlanStage::NEED_TIME;
+                }
+                _lastReturned = member->loc;
+            }
+        }
+
         // Return the min.
         *out = idToTest;
         return PlanStage::ADVANCED;
     }
 
     void MergeSortStage::prepareToYield() {
+        ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->prepareToYield();
         }
     }
 
     void MergeSortStage::recoverFromYield() {
+        ++_commonStats.unyields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->recoverFromYield();
         }
     }
 
     void MergeSortStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->invalidate(dl);
         }
@@ -157,7 +176,18 @@ namespace mongo {
 
         // If we see DL again it is not the same record as it once was so we still want to
         // return it.
-        if (_dedup) { _seen.erase(dl); }
+        if (_dedup) {
+            _seen.erase(dl);
+            if (dl == _lastReturned) { _lastReturned = DiskLoc(); }
+        }
+    }
+
+    size_t MergeSortStage::dedupMemUsage() const {
+        if (_seen.empty()) { return 0; }
+
+        // Each element of an unordered_set is a node holding the DiskLoc, plus a bucket pointer.
+        return _seen.size() * (sizeof(DiskLoc) + 2 * sizeof(void*))
+             + _seen.bucket_count() * sizeof(void*);
     }
 
     // Is lhs less than rhs?  Note that priority_queue is a max heap by default so we invert
@@ -185,7 +215,24 @@ namespace mongo {
             if (x != 0) { return x > 0; }
         }
 
-        return true;
+        if (0 != _diskLocOrder) {
+            // Results without a DiskLoc compare as the null DiskLoc.
+            DiskLoc lhsLoc = lhsMember->hasLoc() ? lhsMember->loc : DiskLoc();
+            DiskLoc rhsLoc = rhsMember->hasLoc() ? rhsMember->loc : DiskLoc();
+            int x = lhsLoc.compare(rhsLoc) * _diskLocOrder;
+            if (x != 0) { return x > 0; }
+        }
+
+        return false;
+    }
+
+    PlanStageStats* MergeSortStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "SORT_MERGE"));
+        for (size_t i = 0; i < _children.size(); ++i) {
+            ret->children.push_back(_children[i]->getStats());
+        }
+        return ret.release();
     }
 
 }  // namespace mongo
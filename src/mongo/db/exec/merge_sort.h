@@ -38,6 +38,11 @@ namespace mongo {
      * AKA the SERVER-1205 stage.  Allows very efficient handling of the following query:
      * find($or[{a:1}, {b:1}]).sort({c:1}) with indices {a:1, c:1} and {b:1, c:1}.
      *
+     * Deduplicating normally remembers every DiskLoc returned.  If the children are known to
+     * break ties in 'pattern' by DiskLoc, and a record can't appear under two different sort
+     * keys (no multikey index on a sort field), the merge breaks ties the same way.  Copies of a
+     * record then come out back to back and only the last DiskLoc returned is remembered.
+     *
      * Preconditions: For each field in 'pattern' all inputs in the child must handle a
      * getFieldDotted for that field.
      */
@@ -49,12 +54,21 @@ namespace mongo {
         void addChild(PlanStage* child);
 
         virtual bool isEOF();
-        virtual StageState work(WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+        /**
+         * Approximate bytes used to remember what has been returned, for deduplication.
+         */
+        size_t dedupMemUsage() const;
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         // Not owned by us.
         WorkingSet* _ws;
@@ -65,9 +79,16 @@ namespace mongo {
         // Are we deduplicating on DiskLoc?
         bool _dedup;
 
+        // 1 or -1 if the children order results with equal sort keys by DiskLoc, ascending or
+        // descending, in which case _lastReturned is used instead of _seen.  0 otherwise.
+        int _diskLocOrder;
+
         // Which DiskLocs have we seen?
         unordered_set<DiskLoc, DiskLoc::Hasher> _seen;
 
+        // The DiskLoc of the last result returned, for deduplicating when _diskLocOrder != 0.
+        DiskLoc _lastReturned;
+
         // Owned by us.  All the children we're reading from.
         vector<PlanStage*> _children;
 
@@ -99,8 +120,8 @@ namespace mongo {
         // The comparison function used in our priority queue.
         class StageWithValueComparison {
         public:
-            StageWithValueComparison(WorkingSet* ws, BSONObj pattern)
-                : _ws(ws), _pattern(pattern) {}
+            StageWithValueComparison(WorkingSet* ws, BSONObj pattern, int diskLocOrder)
+                : _ws(ws), _pattern(pattern), _diskLocOrder(diskLocOrder) {}
 
             // Is lhs less than rhs?  Note that priority_queue is a max heap by default so we invert
             // the return from the expected value.
@@ -109,6 +130,7 @@ namespace mongo {
         private:
             WorkingSet* _ws;
             BSONObj _pattern;
+            int _diskLocOrder;
         };
 
         // The min heap of the results we're returning.
@@ -121,13 +143,18 @@ namespace mongo {
     // Parameters that must be provided to a MergeSortStage
     class MergeSortStageParams {
     public:
-        MergeSortStageParams() : dedup(true) { }
+        MergeSortStageParams() : dedup(true), diskLocOrder(0) { }
 
         // How we're sorting.
         BSONObj pattern;
 
         // Do we deduplicate on DiskLoc?
         bool dedup;
+
+        // 1 or -1 if every child returns results with equal sort keys in ascending or descending
+        // DiskLoc order, and no record appears with two different sort keys.  True of index
+        // scans over indices that aren't multikey, in the direction of the scan.  0 if unknown.
+        int diskLocOrder;
     };
 
 }  // namespace mongo
@@ -20,7 +20,7 @@ namespace mongo {
 
     MockStage::MockStage(WorkingSet* ws) : _ws(ws) { }
 
-    PlanStage::StageState MockStage::work(WorkingSetID* out) {
+    PlanStage::StageState MockStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         StageState state = _results.front();
@@ -40,6 +40,11 @@ namespace mongo {
 
     bool MockStage::isEOF() { return _results.empty(); }
 
+    PlanStageStats* MockStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        return new PlanStageStats(_commonStats, "MOCK");
+    }
+
     void MockStage::pushBack(const PlanStage::StageState state) {
         _results.push(state);
     }
@@ -39,16 +39,15 @@ namespace mongo {
         MockStage(WorkingSet* ws);
         virtual ~MockStage() { }
 
-        virtual StageState work(WorkingSetID* out);
-
         virtual bool isEOF();
 
-        // These don't really mean anything here.
-        // Some day we could count the # of calls to the yield functions to check that other stages
-        // have correct yielding behavior.
-        virtual void prepareToYield() { }
-        virtual void recoverFromYield() { }
-        virtual void invalidate(const DiskLoc& dl) { }
+        // These don't really mean anything here, but they are counted, so tests can check that
+        // other stages yield and invalidate their children correctly.
+        virtual void prepareToYield() { ++_commonStats.yields; }
+        virtual void recoverFromYield() { ++_commonStats.unyields; }
+        virtual void invalidate(const DiskLoc& dl) { ++_commonStats.invalidates; }
+
+        virtual PlanStageStats* getStats();
 
         /**
          * Add a result to the back of the queue.  work() goes through the queue.
@@ -61,6 +60,9 @@ namespace mongo {
          */
         void pushBack(const WorkingSetMember& member);
 
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         // We don't own this.
         WorkingSet* _ws;
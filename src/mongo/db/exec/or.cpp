@@ -31,7 +31,7 @@ namespace mongo {
 
     bool OrStage::isEOF() { return _currentChild >= _children.size(); }
 
-    PlanStage::StageState OrStage::work(WorkingSetID* out) {
+    PlanStage::StageState OrStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         WorkingSetID id;
@@ -85,18 +85,21 @@ namespace mongo {
     }
 
     void OrStage::prepareToYield() {
+        ++_commonStats.yields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->prepareToYield();
         }
     }
 
     void OrStage::recoverFromYield() {
+        ++_commonStats.unyields;
         for (size_t i = 0; i < _children.size(); ++i) {
             _children[i]->recoverFromYield();
         }
     }
 
     void OrStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         if (isEOF()) { return; }
 
         for (size_t i = 0; i < _children.size(); ++i) {
@@ -108,4 +111,13 @@ namespace mongo {
         if (_dedup) { _seen.erase(dl); }
     }
 
+    PlanStageStats* OrStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "OR"));
+        for (size_t i = 0; i < _children.size(); ++i) {
+            ret->children.push_back(_children[i]->getStats());
+        }
+        return ret.release();
+    }
+
 }  // namespace mongo
@@ -40,12 +40,16 @@ namespace mongo {
 
         virtual bool isEOF();
 
-        virtual StageState work(WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
         // Not owned by us.
         WorkingSet* _ws;
@@ -0,0 +1,181 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/kill_current_op.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/data_file.h"
+#include "mongo/db/storage/extent.h"
+
+namespace mongo {
+
+    // Threads a count or aggregation that has to read a whole collection may scan it with.  1
+    // scans on the calling thread only.
+    MONGO_EXPORT_SERVER_PARAMETER(parallelScanThreads, int, 1);
+
+    // Smaller collections aren't worth starting threads for.
+    MONGO_EXPORT_SERVER_PARAMETER(parallelScanMinMB, int, 64);
+
+    namespace {
+        // How many records a worker reads between checks for a kill or a failed sibling.
+        const unsigned kRecordsPerCheck = 128;
+
+        struct ExtentSize {
+            ExtentSize(int length, size_t index) : length(length), index(index) { }
+            bool operator<(const ExtentSize& other) const { return length > other.length; }
+            int length;
+            size_t index;
+        };
+
+        bool hasWhere(const MatchExpression* expr) {
+            if (expr->matchType() == MatchExpression::WHERE)
+                return true;
+            for (size_t i = 0; i < expr->numChildren(); i++) {
+                if (hasWhere(expr->getChild(i)))
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    bool ParallelCollectionScan::Partition::next(BSONObj* out) {
+        while (_curr.isNull()) {
+            if (_extent == _extents.size())
+                return false;
+            _curr = _extents[_extent++].firstRecord;
+        }
+
+        if (++_count % kRecordsPerCheck == 0) {
+            if (_scan->_op->killPending())
+                _scan->stop();
+            if (_scan->_stopped.loadRelaxed())
+                return false;
+        }
+
+        // Records never link across extents, so the next one is in the same file.
+        const Record* r = _extents[_extent - 1].file->recordAt(_curr);
+        *out = BSONObj(r->data());
+        _curr = r->nextOfs() == DiskLoc::NullOfs ? DiskLoc() : DiskLoc(_curr.a(), r->nextOfs());
+        return true;
+    }
+
+    ParallelCollectionScan::ParallelCollectionScan(NamespaceDetails* nsd, int maxPartitions)
+        : _op(cc().curop()),
+          _errorMutex("ParallelCollectionScan"),
+          _errorCode(0) {
+        verify(!nsd->isCapped());
+        verify(maxPartitions > 0);
+
+        vector<Partition::ExtentRef> extents;
+        vector<ExtentSize> sizes;
+        for (DiskLoc loc = nsd->firstExtent(); !loc.isNull(); ) {
+            Extent* e = DataFileMgr::getExtent(loc);
+            if (!e->firstRecord.isNull()) {
+                Partition::ExtentRef ref;
+                ref.file = cc().database()->getFile(loc.a());
+                ref.firstRecord = e->firstRecord;
+                sizes.push_back(ExtentSize(e->length, extents.size()));
+                extents.push_back(ref);
+            }
+            loc = e->xnext;
+        }
+
+        // Biggest extents first, each to the partition with the least so far.  Extents grow as a
+        // collection does, so a few big ones would otherwise end up on the same thread.
+        _partitions.resize(std::min(extents.size(), static_cast<size_t>(maxPartitions)));
+        vector<long long> assigned(_partitions.size(), 0);
+        std::sort(sizes.begin(), sizes.end());
+        for (size_t i = 0; i < sizes.size(); i++) {
+            const size_t least = std::min_element(assigned.begin(), assigned.end()) -
+                                 assigned.begin();
+            assigned[least] += sizes[i].length;
+            _partitions[least]._extents.push_back(extents[sizes[i].index]);
+        }
+
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            _partitions[i]._scan = this;
+        }
+    }
+
+    int ParallelCollectionScan::threadsFor(NamespaceDetails* nsd) {
+        if (parallelScanThreads <= 1 || nsd->isCapped() ||
+            nsd->dataSize() < parallelScanMinMB * 1024LL * 1024)
+            return 1;
+        return parallelScanThreads;
+    }
+
+    bool ParallelCollectionScan::canMatchInParallel(const BSONObj& query) {
+        StatusWithMatchExpression parsed = MatchExpressionParser::parse(query);
+        if (!parsed.isOK())
+            return false;
+        scoped_ptr<MatchExpression> expr(parsed.getValue());
+        return !hasWhere(expr.get());
+    }
+
+    void ParallelCollectionScan::run(const boost::function<void (size_t, Partition*)>& work) {
+        boost::thread_group workers;
+        for (size_t i = 0; i < _partitions.size(); i++) {
+            workers.create_thread(boost::bind(&ParallelCollectionScan::runPartition, this,
+                                              work, i));
+        }
+        workers.join_all();
+
+        killCurrentOp.checkForInterrupt();
+        if (_errorCode) {
+            uasserted(_errorCode, _errorMsg);
+        }
+    }
+
+    void ParallelCollectionScan::runPartition(
+            const boost::function<void (size_t, Partition*)>& work, size_t i) {
+        Client::initThread("parallelCollectionScan");
+        try {
+            work(i, &_partitions[i]);
+        }
+        catch (const DBException& e) {
+            scoped_lock lk(_errorMutex);
+            if (!_errorCode) {
+                _errorCode = e.getCode() ? e.getCode() : 17028;
+                _errorMsg = e.what();
+            }
+            stop();
+        }
+        catch (const std::exception& e) {
+            scoped_lock lk(_errorMutex);
+            if (!_errorCode) {
+                _errorCode = 17028;
+                _errorMsg = e.what();
+            }
+            stop();
+        }
+        cc().shutdown();
+    }
+
+    void ParallelCollectionScan::stop() {
+        _stopped.store(1);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,120 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <boost/function.hpp>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class CurOp;
+    class DataFile;
+    class NamespaceDetails;
+
+    /**
+     * Scans a collection on several threads at once, each thread reading its own share of the
+     * collection's extents.
+     *
+     * The calling thread must hold a read lock on the collection from construction until run()
+     * returns.  The workers take no locks: they only read records of extents the constructor
+     * looked up, which nothing can move or free while that lock is held.
+     *
+     * Records come back in no particular order, so this only suits work like counting and
+     * grouping where order doesn't matter.
+     */
+    class ParallelCollectionScan {
+    public:
+        /**
+         * The records of one worker's extents.  next() is only called from that worker.
+         */
+        class Partition {
+        public:
+            Partition() : _scan(NULL), _extent(0), _count(0) { }
+
+            /**
+             * Sets *out to the next record's document, which stays valid while the caller's
+             * lock is held.  Returns false once the partition is done or the scan was stopped.
+             */
+            bool next(BSONObj* out);
+
+        private:
+            friend class ParallelCollectionScan;
+
+            struct ExtentRef {
+                DataFile* file;
+                DiskLoc firstRecord;
+            };
+
+            ParallelCollectionScan* _scan;
+            vector<ExtentRef> _extents;
+            size_t _extent;
+            DiskLoc _curr;
+            unsigned _count;
+        };
+
+        /**
+         * Splits the extents of non-capped collection 'nsd' into at most 'maxPartitions'
+         * partitions of about equal size.
+         */
+        ParallelCollectionScan(NamespaceDetails* nsd, int maxPartitions);
+
+        /**
+         * How many threads should scan 'nsd', per the parallelScanThreads and parallelScanMinMB
+         * parameters.  1 means the caller should scan it the usual way.
+         */
+        static int threadsFor(NamespaceDetails* nsd);
+
+        /**
+         * Whether the workers can each match documents against 'query'.  They can't run a
+         * $where, which needs a JavaScript scope of its own.
+         */
+        static bool canMatchInParallel(const BSONObj& query);
+
+        size_t numPartitions() const { return _partitions.size(); }
+
+        Partition* partition(size_t i) { return &_partitions[i]; }
+
+        /**
+         * Runs work(i, partition) for each partition on a thread of its own and returns once all
+         * are done.  A kill of the calling operation stops the workers at their next check and
+         * throws here, as does the first exception a worker throws.
+         */
+        void run(const boost::function<void (size_t, Partition*)>& work);
+
+    private:
+        void runPartition(const boost::function<void (size_t, Partition*)>& work, size_t i);
+
+        // Tells the workers to stop early, after an error or a kill.
+        void stop();
+
+        vector<Partition> _partitions;
+
+        // Not owned.  The calling operation, whose kills the workers watch for.
+        CurOp* _op;
+
+        AtomicUInt32 _stopped;
+
+        mongo::mutex _errorMutex;
+        int _errorCode;
+        string _errorMsg;
+    };
+
+}  // namespace mongo
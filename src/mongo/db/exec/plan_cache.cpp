@@ -0,0 +1,252 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/exec/plan_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/expression_array.h"
+#include "mongo/db/matcher/expression_leaf.h"
+
+namespace mongo {
+
+    const size_t PlanCache::kMaxEntries;
+    const int PlanCache::kPoorRunRatio;
+    const long long PlanCache::kMinFeedbackWorks;
+    const int PlanCache::kMaxPoorRuns;
+
+    namespace {
+
+        const char* matchTypeName(MatchExpression::MatchType type) {
+            switch (type) {
+            case MatchExpression::AND: return "and";
+            case MatchExpression::OR: return "or";
+            case MatchExpression::NOR: return "nor";
+            case MatchExpression::NOT: return "not";
+            case MatchExpression::ALL: return "all";
+            case MatchExpression::ELEM_MATCH_OBJECT: return "elemMatchObj";
+            case MatchExpression::ELEM_MATCH_VALUE: return "elemMatchVal";
+            case MatchExpression::SIZE: return "size";
+            case MatchExpression::LTE: return "lte";
+            case MatchExpression::LT: return "lt";
+            case MatchExpression::EQ: return "eq";
+            case MatchExpression::GT: return "gt";
+            case MatchExpression::GTE: return "gte";
+            case MatchExpression::REGEX: return "regex";
+            case MatchExpression::MOD: return "mod";
+            case MatchExpression::EXISTS: return "exists";
+            case MatchExpression::MATCH_IN: return "in";
+            case MatchExpression::NIN: return "nin";
+            case MatchExpression::TYPE_OPERATOR: return "type";
+            case MatchExpression::GEO: return "geo";
+            case MatchExpression::WHERE: return "where";
+            case MatchExpression::ATOMIC: return "atomic";
+            case MatchExpression::ALWAYS_FALSE: return "false";
+            }
+            return "unknown";
+        }
+
+        /**
+         * Returns the path an expression applies to, or the empty string if it has none.
+         */
+        StringData pathOf(const MatchExpression* expr) {
+            if (const LeafMatchExpression* leaf =
+                    dynamic_cast<const LeafMatchExpression*>(expr)) {
+                return leaf->path();
+            }
+            if (const ArrayMatchingMatchExpression* array =
+                    dynamic_cast<const ArrayMatchingMatchExpression*>(expr)) {
+                return array->path();
+            }
+            if (const TypeMatchExpression* type = dynamic_cast<const TypeMatchExpression*>(expr)) {
+                return type->path();
+            }
+            if (const AllElemMatchOp* all = dynamic_cast<const AllElemMatchOp*>(expr)) {
+                return all->path();
+            }
+            return StringData();
+        }
+
+        void appendShape(const MatchExpression* expr, std::string* out) {
+            *out += matchTypeName(expr->matchType());
+
+            StringData path = pathOf(expr);
+            if (!path.empty()) {
+                *out += ' ';
+                out->append(path.rawData(), path.size());
+            }
+
+            const size_t numChildren = expr->numChildren();
+            if (0 == numChildren) {
+                return;
+            }
+
+            std::vector<std::string> children(numChildren);
+            for (size_t i = 0; i < numChildren; ++i) {
+                appendShape(expr->getChild(i), &children[i]);
+            }
+
+            // $and, $or and $nor don't care about the order of their clauses.
+            const MatchExpression::MatchType type = expr->matchType();
+            if (MatchExpression::AND == type || MatchExpression::OR == type
+                || MatchExpression::NOR == type) {
+                std::sort(children.begin(), children.end());
+            }
+
+            *out += '(';
+            for (size_t i = 0; i < numChildren; ++i) {
+                if (i > 0) {
+                    *out += ',';
+                }
+                *out += children[i];
+            }
+            *out += ')';
+        }
+
+    }  // namespace
+
+    PlanCache::PlanCache() : _mutex("PlanCache") { }
+
+    // static
+    std::string PlanCache::getShape(const MatchExpression* query,
+                                    const BSONObj& sort,
+                                    const BSONObj& projection) {
+        std::string shape;
+        appendShape(query, &shape);
+        shape += " sort";
+        shape += sort.toString();
+        shape += " proj";
+        shape += projection.toString();
+        return shape;
+    }
+
+    void PlanCache::add(const std::string& shape, const BSONObj& plan, long long works,
+                        long long results) {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        EntryMap::iterator it = _entries.find(shape);
+        if (it != _entries.end()) {
+            _remove_inlock(it);
+        }
+        else if (_entries.size() >= kMaxEntries) {
+            _remove_inlock(_entries.find(_lru.back()));
+        }
+
+        _lru.push_front(shape);
+        Entry& entry = _entries[shape];
+        entry.second = _lru.begin();
+        entry.first.plan = plan.getOwned();
+        entry.first.works = works;
+        entry.first.results = results;
+    }
+
+    bool PlanCache::get(const std::string& shape, BSONObj* planOut) {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        EntryMap::iterator it = _entries.find(shape);
+        if (it == _entries.end()) {
+            return false;
+        }
+
+        // Move to the front of the LRU list.
+        _lru.splice(_lru.begin(), _lru, it->second.second);
+
+        ++it->second.first.uses;
+        *planOut = it->second.first.plan;
+        return true;
+    }
+
+    bool PlanCache::feedback(const std::string& shape, long long works, long long results) {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        EntryMap::iterator it = _entries.find(shape);
+        if (it == _entries.end()) {
+            return false;
+        }
+
+        if (works < kMinFeedbackWorks) {
+            return true;
+        }
+
+        CachedSolution& solution = it->second.first;
+
+        // Compare results per work without dividing: results / works is poor if it is less
+        // than (cached results / cached works) / kPoorRunRatio.
+        const double ours = static_cast<double>(results) * kPoorRunRatio * solution.works;
+        const double cached = static_cast<double>(solution.results) * works;
+        if (ours >= cached) {
+            solution.poorRuns = 0;
+            return true;
+        }
+
+        if (++solution.poorRuns < kMaxPoorRuns) {
+            return true;
+        }
+
+        _remove_inlock(it);
+        return false;
+    }
+
+    bool PlanCache::remove(const std::string& shape) {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        EntryMap::iterator it = _entries.find(shape);
+        if (it == _entries.end()) {
+            return false;
+        }
+
+        _remove_inlock(it);
+        return true;
+    }
+
+    void PlanCache::clear() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _entries.clear();
+        _lru.clear();
+    }
+
+    size_t PlanCache::size() const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+    void PlanCache::toBSON(BSONArrayBuilder* out) const {
+        SimpleMutex::scoped_lock lk(_mutex);
+
+        for (LruList::const_iterator i = _lru.begin(); i != _lru.end(); ++i) {
+            EntryMap::const_iterator it = _entries.find(*i);
+            verify(it != _entries.end());
+            const CachedSolution& solution = it->second.first;
+
+            BSONObjBuilder bob(out->subobjStart());
+            bob.append("shape", *i);
+            bob.append("plan", solution.plan);
+            bob.append("works", solution.works);
+            bob.append("results", solution.results);
+            bob.append("uses", solution.uses);
+            bob.append("poorRuns", solution.poorRuns);
+            bob.doneFast();
+        }
+    }
+
+    void PlanCache::_remove_inlock(EntryMap::iterator it) {
+        _lru.erase(it->second.second);
+        _entries.erase(it);
+    }
+
+}  // namespace mongo
@@ -0,0 +1,136 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class MatchExpression;
+
+    /**
+     * A cached plan for one query shape, plus the feedback used to decide when it has gone bad.
+     */
+    struct CachedSolution {
+        CachedSolution() : works(0), results(0), uses(0), poorRuns(0) { }
+
+        // Description of the plan to run, e.g. a stageDebug style plan tree.
+        BSONObj plan;
+
+        // How the plan performed in the run that got it cached.
+        long long works;
+        long long results;
+
+        // Number of times the plan has been handed out by get().
+        long long uses;
+
+        // Consecutive runs that did much worse than 'works' and 'results' predict.
+        int poorRuns;
+    };
+
+    /**
+     * Per collection cache of plans for PlanStage based query execution.
+     *
+     * Entries are keyed on the shape of a query, which is its MatchExpression with values
+     * stripped and commutative children put in a canonical order, plus its sort and
+     * projection.  Unlike the old query optimizer's cache, entries are not flushed after a
+     * number of writes.  Instead a runner reports how each cached plan did via feedback(), and
+     * a plan that keeps doing much worse than when it was cached is evicted so the next query
+     * of that shape replans.  The cache is also bounded in size, dropping the least recently
+     * used shape when full, and is cleared when the collection's indexes change.
+     *
+     * All methods are thread safe.
+     */
+    class PlanCache {
+        MONGO_DISALLOW_COPYING(PlanCache);
+    public:
+        // Most shapes kept per collection.
+        static const size_t kMaxEntries = 500;
+
+        // A run is poor if its results per work are this many times worse than when cached.
+        static const int kPoorRunRatio = 10;
+
+        // Runs with fewer works than this are too short to judge and don't count as feedback.
+        static const long long kMinFeedbackWorks = 100;
+
+        // This many poor runs in a row evicts the plan.
+        static const int kMaxPoorRuns = 3;
+
+        PlanCache();
+
+        /**
+         * Returns the shape key for a query.  Queries differing only in the values they
+         * compare against, or in the order of $and/$or/$nor clauses, get the same key.
+         */
+        static std::string getShape(const MatchExpression* query,
+                                    const BSONObj& sort,
+                                    const BSONObj& projection);
+
+        /**
+         * Caches 'plan' for 'shape', replacing any previous entry.  'works' and 'results'
+         * describe how the plan did when it was chosen.
+         */
+        void add(const std::string& shape, const BSONObj& plan, long long works,
+                 long long results);
+
+        /**
+         * If a plan is cached for 'shape', sets *planOut to it and returns true.
+         */
+        bool get(const std::string& shape, BSONObj* planOut);
+
+        /**
+         * Reports how a run of the cached plan for 'shape' did.  Returns false if the plan was
+         * evicted as a result, in which case the caller should replan next time.
+         */
+        bool feedback(const std::string& shape, long long works, long long results);
+
+        /**
+         * Drops the entry for 'shape'.  Returns false if there was none.
+         */
+        bool remove(const std::string& shape);
+
+        void clear();
+
+        size_t size() const;
+
+        /**
+         * Appends one object per entry, most recently used first.
+         */
+        void toBSON(BSONArrayBuilder* out) const;
+
+    private:
+        typedef std::list<std::string> LruList;
+        typedef std::pair<CachedSolution, LruList::iterator> Entry;
+        typedef std::map<std::string, Entry> EntryMap;
+
+        void _remove_inlock(EntryMap::iterator it);
+
+        mutable SimpleMutex _mutex;
+
+        EntryMap _entries;
+
+        // Shapes in _entries, most recently used at the front.
+        LruList _lru;
+    };
+
+}  // namespace mongo
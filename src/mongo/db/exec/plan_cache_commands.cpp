@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/auth/action_set.h"
+#include "mongo/db/auth/action_type.h"
+#include "mongo/db/auth/privilege.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/exec/plan_cache.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/namespace_details.h"
+
+namespace mongo {
+
+    /**
+     * Lists the query shapes cached for a collection.
+     *
+     * db.runCommand({planCacheListShapes: "collectionname"})
+     */
+    class PlanCacheListShapesCmd : public Command {
+    public:
+        PlanCacheListShapesCmd() : Command("planCacheListShapes") { }
+
+        virtual LockType locktype() const { return READ; }
+        bool slaveOk() const { return true; }
+        bool slaveOverrideOk() const { return true; }
+        void help(stringstream& h) const {
+            h << "list the cached query shapes and plans for a collection\n"
+                 "{ planCacheListShapes : <collection> }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheRead);
+            out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result,
+                 bool fromRepl) {
+            const string ns = parseNs(dbname, cmdObj);
+
+            BSONArrayBuilder shapes(result.subarrayStart("shapes"));
+            NamespaceDetailsTransient::get(ns.c_str()).planCache().toBSON(&shapes);
+            shapes.done();
+            return true;
+        }
+    } planCacheListShapesCmd;
+
+    /**
+     * Drops one or all cached plans for a collection.
+     *
+     * db.runCommand({planCacheClear: "collectionname", shape: optionalShapeString})
+     */
+    class PlanCacheClearCmd : public Command {
+    public:
+        PlanCacheClearCmd() : Command("planCacheClear") { }
+
+        virtual LockType locktype() const { return READ; }
+        bool slaveOk() const { return true; }
+        bool slaveOverrideOk() const { return true; }
+        void help(stringstream& h) const {
+            h << "drop cached query plans for a collection, all of them unless a shape is given\n"
+                 "{ planCacheClear : <collection>, shape : <optional shape string> }";
+        }
+
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheWrite);
+            out->push_back(Privilege(parseNs(dbname, cmdObj), actions));
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result,
+                 bool fromRepl) {
+            const string ns = parseNs(dbname, cmdObj);
+            PlanCache& cache = NamespaceDetailsTransient::get(ns.c_str()).planCache();
+
+            BSONElement shapeElt = cmdObj["shape"];
+            if (shapeElt.eoo()) {
+                result.appendNumber("removed", static_cast<long long>(cache.size()));
+                cache.clear();
+                return true;
+            }
+
+            if (String != shapeElt.type()) {
+                errmsg = "shape must be a string";
+                return false;
+            }
+
+            result.appendNumber("removed", cache.remove(shapeElt.String()) ? 1 : 0);
+            return true;
+        }
+    } planCacheClearCmd;
+
+}  // namespace mongo
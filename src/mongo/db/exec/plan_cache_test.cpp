@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * This file contains tests for mongo/db/exec/plan_cache.cpp
+ */
+
+#include "mongo/db/exec/plan_cache.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    string shapeOf(const char* query, const BSONObj& sort = BSONObj(),
+                   const BSONObj& proj = BSONObj()) {
+        StatusWithMatchExpression swme = MatchExpressionParser::parse(fromjson(query));
+        ASSERT_TRUE(swme.isOK());
+        boost::scoped_ptr<MatchExpression> expr(swme.getValue());
+        return PlanCache::getShape(expr.get(), sort, proj);
+    }
+
+    TEST(PlanCacheTest, ShapeIgnoresValues) {
+        ASSERT_EQUALS(shapeOf("{a: 1, b: {$gt: 5}}"), shapeOf("{a: 'x', b: {$gt: 100}}"));
+        ASSERT_EQUALS(shapeOf("{a: {$in: [1, 2]}}"), shapeOf("{a: {$in: [3]}}"));
+    }
+
+    TEST(PlanCacheTest, ShapeIgnoresClauseOrder) {
+        ASSERT_EQUALS(shapeOf("{a: 1, b: 2}"), shapeOf("{b: 3, a: 4}"));
+        ASSERT_EQUALS(shapeOf("{$or: [{a: 1}, {b: 1}]}"), shapeOf("{$or: [{b: 2}, {a: 2}]}"));
+    }
+
+    TEST(PlanCacheTest, ShapeDistinguishesStructure) {
+        ASSERT_NOT_EQUALS(shapeOf("{a: 1}"), shapeOf("{b: 1}"));
+        ASSERT_NOT_EQUALS(shapeOf("{a: 1}"), shapeOf("{a: {$gt: 1}}"));
+        ASSERT_NOT_EQUALS(shapeOf("{a: {$elemMatch: {b: 1}}}"),
+                          shapeOf("{a: {$elemMatch: {c: 1}}}"));
+        ASSERT_NOT_EQUALS(shapeOf("{a: 1}", BSON("a" << 1)), shapeOf("{a: 1}", BSON("a" << -1)));
+        ASSERT_NOT_EQUALS(shapeOf("{a: 1}", BSONObj(), BSON("a" << 1)), shapeOf("{a: 1}"));
+    }
+
+    TEST(PlanCacheTest, AddGetRemove) {
+        PlanCache cache;
+        BSONObj plan;
+        ASSERT_FALSE(cache.get("s", &plan));
+
+        cache.add("s", BSON("ixscan" << 1), 10, 10);
+        ASSERT_EQUALS(1U, cache.size());
+        ASSERT_TRUE(cache.get("s", &plan));
+        ASSERT_EQUALS(BSON("ixscan" << 1), plan);
+
+        // Adding again replaces the entry.
+        cache.add("s", BSON("cscan" << 1), 10, 10);
+        ASSERT_EQUALS(1U, cache.size());
+        ASSERT_TRUE(cache.get("s", &plan));
+        ASSERT_EQUALS(BSON("cscan" << 1), plan);
+
+        ASSERT_TRUE(cache.remove("s"));
+        ASSERT_FALSE(cache.remove("s"));
+        ASSERT_EQUALS(0U, cache.size());
+    }
+
+    TEST(PlanCacheTest, EvictsLeastRecentlyUsed) {
+        PlanCache cache;
+        for (size_t i = 0; i < PlanCache::kMaxEntries; ++i) {
+            cache.add(BSON("" << static_cast<int>(i)).toString(), BSONObj(), 1, 1);
+        }
+
+        // Touching the oldest entry protects it; the second oldest goes instead.
+        BSONObj plan;
+        const string oldest = BSON("" << 0).toString();
+        ASSERT_TRUE(cache.get(oldest, &plan));
+        cache.add("new", BSONObj(), 1, 1);
+
+        ASSERT_EQUALS(PlanCache::kMaxEntries, cache.size());
+        ASSERT_TRUE(cache.get(oldest, &plan));
+        ASSERT_FALSE(cache.get(BSON("" << 1).toString(), &plan));
+        ASSERT_TRUE(cache.get("new", &plan));
+    }
+
+    TEST(PlanCacheTest, FeedbackEvictsConsistentlyPoorPlans) {
+        PlanCache cache;
+        BSONObj plan;
+        cache.add("s", BSONObj(), 100, 50);
+
+        // Short runs aren't judged.
+        for (int i = 0; i < 2 * PlanCache::kMaxPoorRuns; ++i) {
+            ASSERT_TRUE(cache.feedback("s", PlanCache::kMinFeedbackWorks - 1, 0));
+        }
+
+        // A good run resets the poor run count.
+        for (int i = 0; i < PlanCache::kMaxPoorRuns - 1; ++i) {
+            ASSERT_TRUE(cache.feedback("s", 10000, 1));
+        }
+        ASSERT_TRUE(cache.feedback("s", 10000, 5000));
+
+        for (int i = 0; i < PlanCache::kMaxPoorRuns - 1; ++i) {
+            ASSERT_TRUE(cache.feedback("s", 10000, 1));
+        }
+        ASSERT_TRUE(cache.get("s", &plan));
+        ASSERT_FALSE(cache.feedback("s", 10000, 1));
+        ASSERT_FALSE(cache.get("s", &plan));
+    }
+
+    TEST(PlanCacheTest, ToBSON) {
+        PlanCache cache;
+        cache.add("a", BSON("cscan" << 1), 10, 5);
+        cache.add("b", BSON("ixscan" << 1), 3, 3);
+
+        BSONArrayBuilder bab;
+        cache.toBSON(&bab);
+        BSONObj entries = bab.arr();
+
+        // Most recently used first.
+        ASSERT_EQUALS("b", entries["0"].Obj()["shape"].String());
+        ASSERT_EQUALS(BSON("cscan" << 1), entries["1"].Obj()["plan"].Obj());
+        ASSERT_EQUALS(10, entries["1"].Obj()["works"].numberLong());
+
+        cache.clear();
+        ASSERT_EQUALS(0U, cache.size());
+    }
+
+}  // namespace
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/util/time_support.h"
 
 namespace mongo {
 
@@ -127,8 +129,27 @@ namespace mongo {
          * Perform a unit of work on the query.  Ask the stage to produce the next unit of output.
          * Stage returns StageState::ADVANCED if *out is set to the next unit of output.  Otherwise,
          * returns another value of StageState to indicate the stage's status.
+         *
+         * Counts the call, its result and its duration in the stage's CommonStats; the stage
+         * itself does the work in doWork().
          */
-        virtual StageState work(WorkingSetID* out) = 0;
+        StageState work(WorkingSetID* out) {
+            ++_commonStats.works;
+            const unsigned long long start = curTimeMicros64();
+            const StageState state = doWork(out);
+            _commonStats.executionTimeMicros += curTimeMicros64() - start;
+
+            if (ADVANCED == state) {
+                ++_commonStats.advanced;
+            }
+            else if (NEED_TIME == state) {
+                ++_commonStats.needTime;
+            }
+            else if (NEED_FETCH == state) {
+                ++_commonStats.needFetch;
+            }
+            return state;
+        }
 
         /**
          * Returns true if no more work can be done on the query / out of results.
@@ -171,6 +192,21 @@ namespace mongo {
          * Can only be called after a prepareToYield but before a recoverFromYield.
          */
         virtual void invalidate(const DiskLoc& dl) = 0;
+
+        /**
+         * Returns the stats of this stage and all of the stages under it.  The caller owns the
+         * result.
+         */
+        virtual PlanStageStats* getStats() = 0;
+
+    protected:
+        /**
+         * The stage's part of work(...), which has the same contract.
+         */
+        virtual StageState doWork(WorkingSetID* out) = 0;
+
+        // Stages update the yield and invalidation counts; work(...) does the rest.
+        CommonStats _commonStats;
     };
 
 }  // namespace mongo
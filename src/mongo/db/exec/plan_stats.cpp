@@ -0,0 +1,47 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/db/exec/plan_stats.h"
+
+namespace mongo {
+
+    void PlanStageStats::toBSON(BSONObjBuilder* out) const {
+        out->append("type", stageType);
+        out->appendNumber("works", common.works);
+        out->appendNumber("advanced", common.advanced);
+        out->appendNumber("needTime", common.needTime);
+        out->appendNumber("needFetch", common.needFetch);
+        out->appendNumber("yields", common.yields);
+        out->appendNumber("unyields", common.unyields);
+        out->appendNumber("invalidates", common.invalidates);
+        out->appendNumber("executionTimeMicros", common.executionTimeMicros);
+        out->appendBool("isEOF", common.isEOF);
+
+        if (children.empty()) {
+            return;
+        }
+
+        BSONArrayBuilder childrenBuilder(out->subarrayStart("children"));
+        for (size_t i = 0; i < children.size(); ++i) {
+            BSONObjBuilder childBuilder(childrenBuilder.subobjStart());
+            children[i]->toBSON(&childBuilder);
+            childBuilder.doneFast();
+        }
+        childrenBuilder.doneFast();
+    }
+
+}  // namespace mongo
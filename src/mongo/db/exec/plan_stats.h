@@ -0,0 +1,80 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * The counters every stage keeps, whatever it does.  PlanStage::work() maintains the work
+     * counts and the time; stages count their own yields and invalidations.
+     */
+    struct CommonStats {
+        CommonStats() : works(0), advanced(0), needTime(0), needFetch(0), yields(0),
+                        unyields(0), invalidates(0), executionTimeMicros(0), isEOF(false) { }
+
+        // Calls to work(), and how many of them returned ADVANCED, NEED_TIME and NEED_FETCH.
+        size_t works;
+        size_t advanced;
+        size_t needTime;
+        size_t needFetch;
+
+        // Calls to prepareToYield(), recoverFromYield() and invalidate().
+        size_t yields;
+        size_t unyields;
+        size_t invalidates;
+
+        // Time spent in work(), including the time spent in children.
+        long long executionTimeMicros;
+
+        bool isEOF;
+    };
+
+    /**
+     * The stats of one stage and, through 'children', of the stages under it.  Owns the
+     * children.
+     */
+    class PlanStageStats {
+        MONGO_DISALLOW_COPYING(PlanStageStats);
+    public:
+        PlanStageStats(const CommonStats& c, const std::string& type)
+            : common(c), stageType(type) { }
+
+        ~PlanStageStats() {
+            for (size_t i = 0; i < children.size(); ++i) {
+                delete children[i];
+            }
+        }
+
+        /**
+         * Appends { type, works, advanced, ..., children: [...] } for this stage and its
+         * children.
+         */
+        void toBSON(BSONObjBuilder* out) const;
+
+        CommonStats common;
+        std::string stageType;
+        std::vector<PlanStageStats*> children;
+    };
+
+}  // namespace mongo
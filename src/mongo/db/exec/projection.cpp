@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/exec/projection.h"
+
+#include "mongo/db/exec/working_set_common.h"
+
+namespace mongo {
+
+    ProjectionStage::ProjectionStage(const BSONObj& projection, bool coveredByKeys,
+                                     WorkingSet* ws, PlanStage* child)
+        : _ws(ws), _child(child), _coveredByKeys(coveredByKeys) {
+        _projection.init(projection);
+    }
+
+    ProjectionStage::~ProjectionStage() { }
+
+    bool ProjectionStage::isEOF() { return _child->isEOF(); }
+
+    PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        WorkingSetID id;
+        StageState status = _child->work(&id);
+
+        if (PlanStage::ADVANCED != status) {
+            if (PlanStage::NEED_FETCH == status) { *out = id; }
+            // NEED_TIME/YIELD, ERROR, IS_EOF
+            return status;
+        }
+
+        WorkingSetMember* member = _ws->get(id);
+        BSONObj projected;
+
+        const Projection::KeyOnly* keyOnly = NULL;
+        if (_coveredByKeys && !member->hasObj() && 1 == member->keyData.size()) {
+            keyOnly = keyOnlyFor(member->keyData[0].indexKeyPattern);
+        }
+
+        if (NULL != keyOnly) {
+            // Covered: the key has everything we output.
+            projected = keyOnly->hydrate(member->keyData[0].keyData);
+        }
+        else if (WorkingSetCommon::fetch(member)) {
+            projected = _projection.transform(member->obj);
+        }
+        else {
+            _ws->free(id);
+            return PlanStage::FAILURE;
+        }
+
+        member->obj = projected;
+        member->keyData.clear();
+        member->loc = DiskLoc();
+        member->state = WorkingSetMember::OWNED_OBJ;
+
+        *out = id;
+        return PlanStage::ADVANCED;
+    }
+
+    void ProjectionStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
+
+    void ProjectionStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
+
+    void ProjectionStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _child->invalidate(dl);
+    }
+
+    const Projection::KeyOnly* ProjectionStage::keyOnlyFor(const BSONObj& keyPattern) {
+        if (!_lastKeyPattern.isEmpty() && _lastKeyPattern.binaryEqual(keyPattern)) {
+            return _keyOnly.get();
+        }
+
+        _lastKeyPattern = keyPattern.getOwned();
+        _keyOnly.reset(_projection.checkKey(keyPattern));
+        return _keyOnly.get();
+    }
+
+    PlanStageStats* ProjectionStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "PROJECTION"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,75 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/projection.h"
+#include "mongo/db/exec/plan_stage.h"
+
+namespace mongo {
+
+    /**
+     * This stage applies a find() style projection, such as {a: 1, _id: 0}, to its child's results.
+     *
+     * If 'coveredByKeys' is true, a result that only has index key data is projected straight from
+     * its key when the projection needs no field the key lacks, and the document is never read.
+     * Only pass true if no index below is multikey, as a multikey index key holds a single array
+     * element rather than the array.  Anything else is projected from its object, which is read if
+     * need be; put a FetchStage below us for documents that may not be in memory.
+     *
+     * In WorkingSetMember terms, it transitions to OWNED_OBJ.
+     *
+     * Preconditions: Valid DiskLoc or an object, unless the result is covered.
+     */
+    class ProjectionStage : public PlanStage {
+    public:
+        ProjectionStage(const BSONObj& projection, bool coveredByKeys, WorkingSet* ws,
+                        PlanStage* child);
+        virtual ~ProjectionStage();
+
+        virtual bool isEOF();
+
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+        virtual void invalidate(const DiskLoc& dl);
+
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
+    private:
+        /**
+         * Returns what rebuilds projected objects from keys of 'keyPattern', or NULL if such keys
+         * don't have all the fields the projection wants.
+         */
+        const Projection::KeyOnly* keyOnlyFor(const BSONObj& keyPattern);
+
+        // _ws is not owned by us.
+        WorkingSet* _ws;
+        scoped_ptr<PlanStage> _child;
+
+        Projection _projection;
+        bool _coveredByKeys;
+
+        // checkKey() of the last key pattern seen, which is almost always the only one.
+        BSONObj _lastKeyPattern;
+        scoped_ptr<Projection::KeyOnly> _keyOnly;
+    };
+
+}  // namespace mongo
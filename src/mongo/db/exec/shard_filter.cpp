@@ -0,0 +1,154 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/db/exec/shard_filter.h"
+
+#include "mongo/db/exec/working_set.h"
+
+namespace mongo {
+
+    ShardFilter::ShardFilter(const CollectionMetadataPtr& metadata)
+        : _metadata(metadata),
+          _shardKeyPattern(metadata ? metadata->getKeyPattern() : BSONObj()),
+          _shardKey(_shardKeyPattern),
+          _lastIndexUsable(false) { }
+
+    bool ShardFilter::canUseIndexKey(const BSONObj& indexKeyPattern) {
+        if (_shardKeyPattern.isEmpty() || indexKeyPattern.isEmpty()) {
+            return false;
+        }
+        if (indexKeyPattern.binaryEqual(_lastIndexPattern)) {
+            return _lastIndexUsable;
+        }
+
+        _lastIndexPattern = indexKeyPattern.getOwned();
+        _lastIndexUsable = true;
+        BSONObjIterator indexIt(indexKeyPattern);
+        BSONObjIterator shardIt(_shardKeyPattern);
+        while (shardIt.more()) {
+            BSONElement shardField = shardIt.next();
+            if (!indexIt.more()) {
+                _lastIndexUsable = false;
+                break;
+            }
+            BSONElement indexField = indexIt.next();
+
+            // Plain fields only: a hashed index's keys hold hashes made with a seed its pattern
+            // doesn't record, so they can't stand in for a hashed shard key either.
+            if (shardField.fieldNameStringData() != indexField.fieldNameStringData() ||
+                !shardField.isNumber() || !indexField.isNumber()) {
+                _lastIndexUsable = false;
+                break;
+            }
+        }
+        return _lastIndexUsable;
+    }
+
+    bool ShardFilter::indexKeyBelongsToMe(const BSONObj& indexKey) {
+        // Index keys have no field names; the shard key's are those of its pattern.
+        BSONObjBuilder shardKey;
+        BSONObjIterator keyIt(indexKey);
+        BSONObjIterator shardIt(_shardKeyPattern);
+        while (shardIt.more()) {
+            BSONElement field = shardIt.next();
+            verify(keyIt.more());
+            shardKey.appendAs(keyIt.next(), field.fieldName());
+        }
+        return shardKeyBelongsToMe(shardKey.obj());
+    }
+
+    bool ShardFilter::docBelongsToMe(const BSONObj& doc) {
+        if (_shardKeyPattern.isEmpty()) {
+            return true;
+        }
+        return shardKeyBelongsToMe(_shardKey.extractSingleKey(doc));
+    }
+
+    bool ShardFilter::shardKeyBelongsToMe(const BSONObj& shardKey) {
+        if (!_ownedMin.isEmpty() &&
+            shardKey.woCompare(_ownedMin) >= 0 && shardKey.woCompare(_ownedMax) < 0) {
+            return true;
+        }
+        return _metadata->keyBelongsToMe(shardKey, &_ownedMin, &_ownedMax);
+    }
+
+    ShardFilterStage::ShardFilterStage(const CollectionMetadataPtr& metadata, WorkingSet* ws,
+                                       PlanStage* child)
+        : _ws(ws), _child(child), _filter(metadata) { }
+
+    ShardFilterStage::~ShardFilterStage() { }
+
+    bool ShardFilterStage::isEOF() { return _child->isEOF(); }
+
+    PlanStage::StageState ShardFilterStage::doWork(WorkingSetID* out) {
+        if (isEOF()) { return PlanStage::IS_EOF; }
+
+        WorkingSetID id;
+        StageState status = _child->work(&id);
+
+        if (PlanStage::ADVANCED == status) {
+            if (!belongsToMe(_ws->get(id))) {
+                _ws->free(id);
+                return PlanStage::NEED_TIME;
+            }
+
+            *out = id;
+            return PlanStage::ADVANCED;
+        }
+        else {
+            // NEED_TIME/YIELD, ERROR, IS_EOF
+            return status;
+        }
+    }
+
+    bool ShardFilterStage::belongsToMe(WorkingSetMember* member) {
+        for (size_t i = 0; i < member->keyData.size(); ++i) {
+            const IndexKeyDatum& datum = member->keyData[i];
+            if (!datum.keyData.isEmpty() && _filter.canUseIndexKey(datum.indexKeyPattern)) {
+                return _filter.indexKeyBelongsToMe(datum.keyData);
+            }
+        }
+
+        if (member->hasObj()) {
+            return _filter.docBelongsToMe(member->obj);
+        }
+        verify(member->hasLoc());
+        return _filter.docBelongsToMe(member->loc.obj());
+    }
+
+    void ShardFilterStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
+
+    void ShardFilterStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
+
+    void ShardFilterStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _child->invalidate(dl);
+    }
+
+    PlanStageStats* ShardFilterStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "SHARD_FILTER"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
+
+}  // namespace mongo
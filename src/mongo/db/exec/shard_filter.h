@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/keypattern.h"
+#include "mongo/s/collection_metadata.h"
+
+namespace mongo {
+
+    /**
+     * Tells whether documents belong to the chunks this shard owns, to filter out orphans that a
+     * migration left behind or hasn't finished bringing in.
+     *
+     * It reads the shard key out of an index key when the index holds it, so the document needn't
+     * be fetched.  It also remembers the owned range of the last key it looked up: keys from an
+     * index scan come in order, so most fall in the same range and need no lookup at all.
+     */
+    class ShardFilter {
+    public:
+        /**
+         * @param metadata the collection's metadata, or NULL if it isn't sharded, in which case
+         * every document belongs here
+         */
+        explicit ShardFilter(const CollectionMetadataPtr& metadata);
+
+        /**
+         * Whether the keys of an index with pattern 'indexKeyPattern' start with the shard key.
+         * Hashed shard keys are always checked from the document.
+         */
+        bool canUseIndexKey(const BSONObj& indexKeyPattern);
+
+        /**
+         * 'indexKey' is a key of an index whose pattern canUseIndexKey() accepted.
+         */
+        bool indexKeyBelongsToMe(const BSONObj& indexKey);
+
+        bool docBelongsToMe(const BSONObj& doc);
+
+    private:
+        bool shardKeyBelongsToMe(const BSONObj& shardKey);
+
+        CollectionMetadataPtr _metadata;
+
+        // Empty if the collection isn't sharded.
+        BSONObj _shardKeyPattern;
+        KeyPattern _shardKey;
+
+        // The index pattern canUseIndexKey() was last asked about, and its answer.
+        BSONObj _lastIndexPattern;
+        bool _lastIndexUsable;
+
+        // The owned range holding the last key that belonged here, if any did.
+        BSONObj _ownedMin;
+        BSONObj _ownedMax;
+    };
+
+    /**
+     * This stage drops the results of its child that don't belong to this shard's chunks (see
+     * ShardFilter).  Results with index key data from an index that starts with the shard key are
+     * checked from the key, so below a FETCH the stage keeps orphans from being fetched at all.
+     * Other results have their document checked.
+     *
+     * Preconditions: Valid DiskLoc, or an object.
+     */
+    class ShardFilterStage : public PlanStage {
+    public:
+        /**
+         * @param metadata as for ShardFilter
+         */
+        ShardFilterStage(const CollectionMetadataPtr& metadata, WorkingSet* ws,
+                         PlanStage* child);
+        virtual ~ShardFilterStage();
+
+        virtual bool isEOF();
+
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+        virtual void invalidate(const DiskLoc& dl);
+
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
+    private:
+        bool belongsToMe(WorkingSetMember* member);
+
+        WorkingSet* _ws;
+        scoped_ptr<PlanStage> _child;
+        ShardFilter _filter;
+    };
+
+}  // namespace mongo
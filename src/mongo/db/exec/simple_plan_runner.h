@@ -17,17 +17,18 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/interrupt_token.h"
 #include "mongo/db/pdfile.h"
 
 namespace mongo {
 
     /**
      * A placeholder for a full-featured plan runner.  Calls work() on a plan until a result is
-     * produced.  Stops when the plan is EOF or if the plan errors.
+     * produced.  Stops when the plan is EOF or if the plan errors, and throws if the op is killed
+     * or runs out of time.
      *
      * TODO: Yielding policy
      * TODO: Graceful error handling
-     * TODO: Stats, diagnostics, instrumentation, etc.
      */
     class SimplePlanRunner {
     public:
@@ -44,7 +45,10 @@ namespace mongo {
         }
 
         bool getNext(BSONObj* objOut) {
+            _interrupt.rebind();
             for (;;) {
+                _interrupt.check();
+
                 WorkingSetID id;
                 PlanStage::StageState code = _root->work(&id);
 
@@ -89,9 +93,18 @@ namespace mongo {
             }
         }
 
+        /**
+         * Returns the stats of every stage in the plan.  The caller owns the result.
+         */
+        PlanStageStats* getStats() {
+            verify(_root.get());
+            return _root->getStats();
+        }
+
     private:
         WorkingSet _workingSet;
         scoped_ptr<PlanStage> _root;
+        InterruptToken _interrupt;
     };
 
 }  // namespace mongo
@@ -25,7 +25,7 @@ namespace mongo {
 
     bool SkipStage::isEOF() { return _child->isEOF(); }
 
-    PlanStage::StageState SkipStage::work(WorkingSetID* out) {
+    PlanStage::StageState SkipStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         WorkingSetID id;
@@ -49,10 +49,26 @@ namespace mongo {
         }
     }
 
-    void SkipStage::prepareToYield() { _child->prepareToYield(); }
+    void SkipStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
 
-    void SkipStage::recoverFromYield() { _child->recoverFromYield(); }
+    void SkipStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
 
-    void SkipStage::invalidate(const DiskLoc& dl) { _child->invalidate(dl); }
+    void SkipStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
+        _child->invalidate(dl);
+    }
+
+    PlanStageStats* SkipStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "SKIP"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
 
 }  // namespace mongo
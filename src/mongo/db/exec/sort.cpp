@@ -23,6 +23,8 @@
 
 namespace mongo {
 
+    const size_t SortStageParams::kDefaultMaxMemoryUsageBytes;
+
     // Used in STL sort.
     struct WorkingSetComparison {
         WorkingSetComparison(WorkingSet* ws, BSONObj pattern) : _ws(ws), _pattern(pattern) { }
@@ -48,26 +50,64 @@ namespace mongo {
                 if (x != 0) { return x < 0; }
             }
 
-            return true;
+            // Equal, so not less.  The heap and std::sort need a strict ordering.
+            return false;
         }
 
         WorkingSet* _ws;
         BSONObj _pattern;
     };
 
+    namespace {
+
+        // Compares the (sort key, object) pairs fed to the Sorter by their sort keys.
+        class SortKeyComparator {
+        public:
+            explicit SortKeyComparator(const BSONObj& pattern)
+                : _ordering(Ordering::make(pattern)) { }
+
+            int operator()(const pair<BSONObj, BSONObj>& lhs,
+                           const pair<BSONObj, BSONObj>& rhs) const {
+                // false means don't compare field name.
+                return lhs.first.woCompare(rhs.first, _ordering, false);
+            }
+
+        private:
+            Ordering _ordering;
+        };
+
+        // Approximately how much memory 'member' holds on to.
+        size_t memUsage(const WorkingSetMember* member) {
+            size_t usage = sizeof(WorkingSetMember);
+            if (member->hasObj()) {
+                usage += member->obj.objsize();
+            }
+            for (size_t i = 0; i < member->keyData.size(); ++i) {
+                usage += member->keyData[i].keyData.objsize();
+            }
+            return usage;
+        }
+
+    }  // namespace
+
     SortStage::SortStage(const SortStageParams& params, WorkingSet* ws, PlanStage* child)
-        : _ws(ws), _child(child), _pattern(params.pattern), _sorted(false),
-          _resultIterator(_data.end()) { }
+        : _ws(ws), _child(child), _pattern(params.pattern), _limit(params.limit),
+          _maxMemoryUsageBytes(params.maxMemoryUsageBytes), _memUsage(0), _sorted(false),
+          _resultIterator(_data.end()) {
+        verify(_limit >= 0);
+    }
 
     SortStage::~SortStage() { }
 
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        if (!_child->isEOF() || !_sorted) { return false; }
+        if (NULL != _sorterIterator) { return !_sorterIterator->more(); }
+        return _data.end() == _resultIterator;
     }
 
-    PlanStage::StageState SortStage::work(WorkingSetID* out) {
+    PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         // Still reading in results to sort.
@@ -76,8 +116,20 @@ namespace mongo {
             StageState code = _child->work(&id);
 
             if (PlanStage::ADVANCED == code) {
-                // We let the data stay in the WorkingSet and sort using the IDs.
-                _data.push_back(id);
+                if (NULL != _sorter) {
+                    addToSorter(id);
+                    return PlanStage::NEED_TIME;
+                }
+
+                if (_limit > 0) {
+                    if (!addToHeap(id)) {
+                        return PlanStage::NEED_TIME;
+                    }
+                }
+                else {
+                    // We let the data stay in the WorkingSet and sort using the IDs.
+                    _data.push_back(id);
+                }
 
                 // Add it into the map for quick invalidation if it has a valid DiskLoc.
                 // A DiskLoc may be invalidated at any time (during a yield).  We need to get into
@@ -87,12 +139,26 @@ namespace mongo {
                     _wsidByDiskLoc[member->loc] = id;
                 }
 
+                // Past our own limit, or what the op or server may hold, the results go to disk.
+                _memUsage += memUsage(member);
+                if (_memUsage > _maxMemoryUsageBytes || !_memory.trySet(_memUsage)) {
+                    spill();
+                }
+
                 return PlanStage::NEED_TIME;
             }
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                std::sort(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
+                if (NULL != _sorter) {
+                    _sorterIterator.reset(_sorter->done());
+                }
+                else if (_limit > 0) {
+                    std::sort_heap(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
+                }
+                else {
+                    std::sort(_data.begin(), _data.end(), WorkingSetComparison(_ws, _pattern));
+                }
                 _resultIterator = _data.begin();
                 _sorted = true;
                 return PlanStage::NEED_TIME;
@@ -102,18 +168,114 @@ namespace mongo {
             }
         }
 
+        verify(_sorted);
+
+        // Returning results from the Sorter.
+        if (NULL != _sorterIterator) {
+            WorkingSetID id = _ws->allocate();
+            WorkingSetMember* member = _ws->get(id);
+            member->obj = _sorterIterator->next().second.getOwned();
+            member->state = WorkingSetMember::OWNED_OBJ;
+            *out = id;
+            return PlanStage::ADVANCED;
+        }
+
         // Returning results.
         verify(_resultIterator != _data.end());
-        verify(_sorted);
         *out = *_resultIterator++;
         return PlanStage::ADVANCED;
     }
 
-    void SortStage::prepareToYield() { _child->prepareToYield(); }
+    bool SortStage::addToHeap(WorkingSetID id) {
+        WorkingSetComparison less(_ws, _pattern);
 
-    void SortStage::recoverFromYield() { _child->recoverFromYield(); }
+        if (_data.size() < static_cast<size_t>(_limit)) {
+            _data.push_back(id);
+            std::push_heap(_data.begin(), _data.end(), less);
+            return true;
+        }
+
+        if (!less(id, _data.front())) {
+            // Not good enough.
+            _ws->free(id);
+            return false;
+        }
+
+        // Replace the worst result we have with 'id'.
+        std::pop_heap(_data.begin(), _data.end(), less);
+        discard(_data.back());
+        _data.back() = id;
+        std::push_heap(_data.begin(), _data.end(), less);
+        return true;
+    }
+
+    void SortStage::discard(WorkingSetID id) {
+        WorkingSetMember* member = _ws->get(id);
+        _memUsage -= std::min(_memUsage, memUsage(member));
+        _memory.trySet(_memUsage);
+        if (member->hasLoc()) {
+            DataMap::iterator it = _wsidByDiskLoc.find(member->loc);
+            if (_wsidByDiskLoc.end() != it && id == it->second) {
+                _wsidByDiskLoc.erase(it);
+            }
+        }
+        _ws->free(id);
+    }
+
+    BSONObj SortStage::getSortKey(WorkingSetID id) {
+        WorkingSetMember* member = _ws->get(id);
+        BSONObjBuilder keyBuilder;
+
+        BSONObjIterator it(_pattern);
+        while (it.more()) {
+            BSONElement elt;
+            verify(member->getFieldDotted(it.next().fieldName(), &elt));
+            if (elt.eoo()) {
+                keyBuilder.appendNull("");
+            }
+            else {
+                keyBuilder.appendAs(elt, "");
+            }
+        }
+        return keyBuilder.obj();
+    }
+
+    void SortStage::addToSorter(WorkingSetID id) {
+        BSONObj key = getSortKey(id);
+
+        // We can't find spilled results to invalidate them, so they give up their DiskLocs now.
+        WorkingSetMember* member = _ws->get(id);
+        verify(WorkingSetCommon::fetchAndInvalidateLoc(member));
+        _sorter->add(key, member->obj);
+        _ws->free(id);
+    }
+
+    void SortStage::spill() {
+        SortOptions opts;
+        opts.MaxMemoryUsageBytes(_maxMemoryUsageBytes).ExtSortAllowed().Limit(_limit);
+        _sorter.reset(ExternalSorter::make(opts, SortKeyComparator(_pattern)));
+
+        for (size_t i = 0; i < _data.size(); ++i) {
+            addToSorter(_data[i]);
+        }
+        _data.clear();
+        _wsidByDiskLoc.clear();
+        _memUsage = 0;
+        _memory.trySet(0);
+    }
+
+    void SortStage::prepareToYield() {
+        ++_commonStats.yields;
+        _child->prepareToYield();
+    }
+
+    void SortStage::recoverFromYield() {
+        ++_commonStats.unyields;
+        _child->recoverFromYield();
+    }
 
     void SortStage::invalidate(const DiskLoc& dl) {
+        ++_commonStats.invalidates;
         _child->invalidate(dl);
 
         // _data contains indices into the WorkingSet, not actual data.  If a WorkingSetMember in
@@ -130,4 +292,14 @@ namespace mongo {
         }
     }
 
+    PlanStageStats* SortStage::getStats() {
+        _commonStats.isEOF = isEOF();
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, "SORT"));
+        ret->children.push_back(_child->getStats());
+        return ret.release();
+    }
+
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::BSONObj, mongo::SortKeyComparator);
@@ -21,7 +21,9 @@
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
+#include "mongo/db/memory_tracker.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -32,6 +34,11 @@ namespace mongo {
     /**
      * Sorts the input received from the child according to the sort pattern provided.
      *
+     * With a limit, only the best 'limit' results are kept, in a heap, and the rest are freed as
+     * soon as they're read.  Once the results held would use more than the memory allowed, they
+     * are all handed to a Sorter, which spills to disk.  Results that went through the Sorter
+     * come back as owned objects without a DiskLoc.
+     *
      * Preconditions: For each field in 'pattern', all inputs in the child must handle a
      * getFieldDotted for that field.
      */
@@ -42,13 +49,35 @@ namespace mongo {
         virtual ~SortStage();
 
         virtual bool isEOF();
-        virtual StageState work(WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
         virtual void invalidate(const DiskLoc& dl);
 
+        virtual PlanStageStats* getStats();
+
+    protected:
+        virtual StageState doWork(WorkingSetID* out);
+
     private:
+        typedef Sorter<BSONObj, BSONObj> ExternalSorter;
+
+        // Keeps the child's result 'id' if it's one of the best 'limit' seen so far, returning
+        // true.  Otherwise frees it and returns false.
+        bool addToHeap(WorkingSetID id);
+
+        // Moves 'id' to _sorter, freeing it from the WorkingSet.
+        void addToSorter(WorkingSetID id);
+
+        // Moves everything in _data to _sorter, creating it.
+        void spill();
+
+        // Frees 'id', which is in _data, from the WorkingSet and stops tracking it.
+        void discard(WorkingSetID id);
+
+        // Returns the sort key of the result 'id', with the pattern's fields in order.
+        BSONObj getSortKey(WorkingSetID id);
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -58,15 +87,33 @@ namespace mongo {
         // Our sort pattern.
         BSONObj _pattern;
 
-        // We read the child into this.
+        // Most results returned, or 0 for no limit.
+        int _limit;
+
+        // Memory we may hold results in before spilling them to a Sorter.
+        size_t _maxMemoryUsageBytes;
+
+        // We read the child into this.  With a limit it is a max-heap, worst result in front.
         vector<WorkingSetID> _data;
 
+        // Approximate memory used by the results in _data.
+        size_t _memUsage;
+
+        // _memUsage, charged to the op.
+        MemoryCharge _memory;
+
         // Have we sorted our data?
         bool _sorted;
 
         // Iterates through _data post-sort returning it.
         vector<WorkingSetID>::iterator _resultIterator;
 
+        // Once the results outgrow memory, they are all fed to this instead of _data.
+        scoped_ptr<ExternalSorter> _sorter;
+
+        // Iterates through the results of _sorter post-sort.
+        scoped_ptr<ExternalSorter::Iterator> _sorterIterator;
+
         // We buffer a lot of data and we want to look it up by DiskLoc quickly upon invalidation.
         typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
@@ -75,14 +122,19 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        //SortStageParams() : limit(0) { }
+        SortStageParams() : limit(0), maxMemoryUsageBytes(kDefaultMaxMemoryUsageBytes) { }
+
+        // Matches ScanAndOrder::MaxScanAndOrderBytes.
+        static const size_t kDefaultMaxMemoryUsageBytes = 32 * 1024 * 1024;
 
         // How we're sorting.
         BSONObj pattern;
 
-        // TODO: Implement this.
         // Must be >= 0.  Equal to 0 for no limit.
-        // int limit;
+        int limit;
+
+        // Results are spilled to disk beyond this.
+        size_t maxMemoryUsageBytes;
     };
 
 }  // namespace mongo
@@ -21,11 +21,14 @@
 #include "mongo/db/exec/and_hash.h"
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/count.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/exec/skip.h"
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/exec/simple_plan_runner.h"
@@ -34,13 +37,16 @@
 #include "mongo/db/matcher/matcher.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/s/d_logic.h"
 
 namespace mongo {
 
     /**
      * A command for manually constructing a query tree and running it.
      *
-     * db.runCommand({stageDebug: rootNode})
+     * db.runCommand({stageDebug: rootNode, explain: optionalBool})
+     *
+     * With explain, the reply also has "stats": the work counts and times of every stage.
      *
      * The value of the filter field is a BSONObj that specifies values that fields must have.  What
      * you'd pass to a matcher.
@@ -50,7 +56,7 @@ namespace mongo {
      * node -> {ixscan: {filter: {FILTER},
      *                   args: {name: "collectionname", indexKeyPattern: kpObj, start: startObj,
      *                          stop: stopObj, endInclusive: true/false, direction: -1/1,
-     *                          limit: int}}}
+     *                          limit: int, needKeyData: optionalBool}}}
      * node -> {cscan: {filter: {filter}, args: {name: "collectionname", direction: -1/1}}}
      *
      * Internal Nodes:
@@ -58,12 +64,16 @@ namespace mongo {
      * node -> {andHash: {filter: {filter}, args: { nodes: [node, node]}}}
      * node -> {andSorted: {filter: {filter}, args: { nodes: [node, node]}}}
      * node -> {or: {filter: {filter}, args: { dedup:bool, nodes:[node, node]}}}
-     * node -> {fetch: {filter: {filter}, args: {node: node}}}
+     * node -> {fetch: {filter: {filter}, args: {node: node, prefetch: optionalNonnegInt}}}
      * node -> {limit: {args: {node: node, num: posint}}}
      * node -> {skip: {args: {node: node, num: posint}}}
-     * node -> {sort: {args: {node: node, pattern: objWithSortCriterion }}}
-     * node -> {mergeSort: {args: {nodes: [node, node], pattern: objWithSortCriterion}}}
+     * node -> {shardFilter: {args: {node: node, name: "collectionname"}}}
+     * node -> {sort: {args: {node: node, pattern: objWithSortCriterion, limit: optionalInt }}}
+     * node -> {mergeSort: {args: {nodes: [node, node], pattern: objWithSortCriterion,
+     *                              diskLocOrder: optionalInt}}}
      * node -> {cscan: {filter: {filter}, args: {name: "collectionname" }}}
+     * node -> {projection: {args: {node: node, spec: projectionObj, covered: optionalBool}}}
+     * node -> {count: {args: {node: node}}}
      *
      * Forthcoming Nodes:
      *
@@ -107,6 +117,14 @@ namespace mongo {
             }
 
             resultBuilder.done();
+
+            if (cmdObj["explain"].trueValue()) {
+                scoped_ptr<PlanStageStats> stats(runner.getStats());
+                BSONObjBuilder statsBuilder(result.subobjStart("stats"));
+                stats->toBSON(&statsBuilder);
+                statsBuilder.done();
+            }
+
             return true;
         }
 
@@ -158,6 +176,9 @@ namespace mongo {
                 params.direction = nodeArgs["direction"].numberInt();
                 params.limit = nodeArgs["limit"].numberInt();
                 params.forceBtreeAccessMethod = false;
+                if (!nodeArgs["needKeyData"].eoo()) {
+                    params.needKeyData = nodeArgs["needKeyData"].trueValue();
+                }
 
                 return new IndexScan(params, workingSet, matcher.release());
             }
@@ -236,7 +257,13 @@ namespace mongo {
                 uassert(16929, "Node argument must be provided to fetch",
                         nodeArgs["node"].isABSONObj());
                 PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
-                return new FetchStage(workingSet, subNode, matcher.release());
+                size_t prefetch = 0;
+                if (nodeArgs["prefetch"].isNumber()) {
+                    uassert(16985, "Fetch prefetch depth can't be negative",
+                            nodeArgs["prefetch"].numberInt() >= 0);
+                    prefetch = nodeArgs["prefetch"].numberInt();
+                }
+                return new FetchStage(workingSet, subNode, matcher.release(), prefetch);
             }
             else if ("limit" == nodeName) {
                 uassert(16937, "Limit stage doesn't have a filter (put it on the child)",
@@ -258,6 +285,18 @@ namespace mongo {
                 PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
                 return new SkipStage(nodeArgs["num"].numberInt(), workingSet, subNode);
             }
+            else if ("shardFilter" == nodeName) {
+                uassert(17035, "Shard filter stage doesn't have a filter (put it on the child)",
+                        NULL == matcher.get());
+                uassert(17036, "Node argument must be provided to shardFilter",
+                        nodeArgs["node"].isABSONObj());
+                uassert(17037, "Name argument must be provided to shardFilter",
+                        String == nodeArgs["name"].type());
+                string ns = dbname + "." + nodeArgs["name"].String();
+                PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
+                return new ShardFilterStage(shardingState.getCollectionMetadata(ns), workingSet,
+                                            subNode);
+            }
             else if ("cscan" == nodeName) {
                 CollectionScanParams params;
 
@@ -286,6 +325,8 @@ namespace mongo {
                 PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
                 SortStageParams params;
                 params.pattern = nodeArgs["pattern"].Obj();
+                params.limit = nodeArgs["limit"].numberInt();
+                uassert(16990, "Limit argument to sort must not be negative", params.limit >= 0);
                 return new SortStage(params, workingSet, subNode);
             }
             else if ("mergeSort" == nodeName) {
@@ -297,6 +338,9 @@ namespace mongo {
                 MergeSortStageParams params;
                 params.pattern = nodeArgs["pattern"].Obj();
                 // Dedup is true by default.
+                params.diskLocOrder = nodeArgs["diskLocOrder"].numberInt();
+                uassert(16991, "diskLocOrder argument to mergeSort must be -1, 0 or 1",
+                        -1 <= params.diskLocOrder && params.diskLocOrder <= 1);
 
                 auto_ptr<MergeSortStage> mergeStage(new MergeSortStage(params, workingSet));
 
@@ -314,6 +358,25 @@ namespace mongo {
                 }
                 return mergeStage.release();
             }
+            else if ("projection" == nodeName) {
+                uassert(16995, "Projection stage doesn't have a filter (put it on the child)",
+                        NULL == matcher.get());
+                uassert(16996, "Node argument must be provided to projection",
+                        nodeArgs["node"].isABSONObj());
+                uassert(16997, "Spec argument must be provided to projection",
+                        nodeArgs["spec"].isABSONObj());
+                PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
+                return new ProjectionStage(nodeArgs["spec"].Obj(), nodeArgs["covered"].trueValue(),
+                                           workingSet, subNode);
+            }
+            else if ("count" == nodeName) {
+                uassert(16998, "Count stage doesn't have a filter (put it on the child)",
+                        NULL == matcher.get());
+                uassert(16999, "Node argument must be provided to count",
+                        nodeArgs["node"].isABSONObj());
+                PlanStage* subNode = parseQuery(dbname, nodeArgs["node"].Obj(), workingSet);
+                return new CountStage(workingSet, subNode);
+            }
             else {
                 return NULL;
             }
@@ -22,31 +22,65 @@ namespace mongo {
 
     const WorkingSetID WorkingSet::INVALID_ID = -1;
 
-    WorkingSet::WorkingSet() : _nextId(0) { }
+    const int WorkingSet::kSlabShift;
+    const WorkingSetID WorkingSet::kSlabSize;
+
+    namespace {
+        // Marks a holder whose member is handed out.
+        const WorkingSetID kAllocated = -2;
+    }
+
+    struct WorkingSet::MemberHolder {
+        MemberHolder() : nextFree(kAllocated) { }
+
+        // kAllocated if the member is in use, otherwise the next ID on the free list.
+        WorkingSetID nextFree;
+        WorkingSetMember member;
+    };
+
+    WorkingSet::WorkingSet() : _freeList(INVALID_ID), _nextId(0) { }
 
     WorkingSet::~WorkingSet() {
-        for (DataMap::const_iterator i = _data.begin(); i != _data.end(); ++i) {
-            delete i->second;
+        for (size_t i = 0; i < _slabs.size(); ++i) {
+            delete[] _slabs[i];
         }
     }
 
+    WorkingSet::MemberHolder* WorkingSet::holderFor(const WorkingSetID& i) const {
+        verify(i >= 0 && i < _nextId);
+        return &_slabs[i >> kSlabShift][i & (kSlabSize - 1)];
+    }
+
     WorkingSetID WorkingSet::allocate() {
-        verify(_data.end() == _data.find(_nextId));
-        _data[_nextId] = new WorkingSetMember();
-        return _nextId++;
+        if (INVALID_ID != _freeList) {
+            WorkingSetID id = _freeList;
+            MemberHolder* holder = holderFor(id);
+            _freeList = holder->nextFree;
+            holder->nextFree = kAllocated;
+            return id;
+        }
+
+        if (static_cast<size_t>(_nextId >> kSlabShift) == _slabs.size()) {
+            _slabs.push_back(new MemberHolder[kSlabSize]);
+        }
+        MemberHolder* holder = holderFor(_nextId++);
+        verify(kAllocated == holder->nextFree);
+        return _nextId - 1;
     }
 
     WorkingSetMember* WorkingSet::get(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        return it->second;
+        MemberHolder* holder = holderFor(i);
+        verify(kAllocated == holder->nextFree);
+        return &holder->member;
     }
 
     void WorkingSet::free(const WorkingSetID& i) {
-        DataMap::iterator it = _data.find(i);
-        verify(_data.end() != it);
-        delete it->second;
-        _data.erase(it);
+        MemberHolder* holder = holderFor(i);
+        verify(kAllocated == holder->nextFree);
+        // Drop any reference to the document now rather than when the ID is reused.
+        holder->member.clear();
+        holder->nextFree = _freeList;
+        _freeList = i;
     }
 
     void WorkingSet::flagForReview(const WorkingSetID& i) {
@@ -61,6 +95,13 @@ namespace mongo {
 
     WorkingSetMember::WorkingSetMember() : state(WorkingSetMember::INVALID) { }
 
+    void WorkingSetMember::clear() {
+        loc = DiskLoc();
+        obj = BSONObj();
+        keyData.clear();
+        state = WorkingSetMember::INVALID;
+    }
+
     bool WorkingSetMember::hasLoc() const {
         return state == LOC_AND_IDX || state == LOC_AND_UNOWNED_OBJ
                || state == LOC_AND_OWNED_OBJ;
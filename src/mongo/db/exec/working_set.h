@@ -17,9 +17,9 @@
 #pragma once
 
 #include <vector>
+#include "mongo/base/disallow_copying.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
-#include "mongo/platform/unordered_map.h"
 
 namespace mongo {
 
@@ -31,8 +31,14 @@ namespace mongo {
      * All data in use by a query.  Data is passed through the stage tree by referencing the ID of
      * an element of the working set.  Stages can add elements to the working set, delete elements
      * from the working set, or mutate elements in the working set.
+     *
+     * Members live in fixed size slabs indexed by WorkingSetID, and freed members go on a free
+     * list to be handed out again, so allocate(), get() and free() don't touch the heap once
+     * the set has grown to the query's working size.  A member's address doesn't change while
+     * it is allocated.  IDs are reused after free().
      */
     class WorkingSet {
+        MONGO_DISALLOW_COPYING(WorkingSet);
     public:
         static const WorkingSetID INVALID_ID;
 
@@ -70,12 +76,23 @@ namespace mongo {
         const vector<WorkingSetID>& getFlagged() const;
 
     private:
-        typedef unordered_map<WorkingSetID, WorkingSetMember*> DataMap;
+        struct MemberHolder;
+
+        // Members per slab.  A power of two, so an ID splits into slab and offset with shifts.
+        static const int kSlabShift = 8;
+        static const WorkingSetID kSlabSize = 1 << kSlabShift;
+
+        MemberHolder* holderFor(const WorkingSetID& i) const;
+
+        // Owned by us, each an array of kSlabSize holders.  The holder for ID i is at offset
+        // i % kSlabSize in slab i / kSlabSize.
+        vector<MemberHolder*> _slabs;
 
-        DataMap _data;
+        // Head of the list of freed IDs, chained through MemberHolder::nextFree, or INVALID_ID.
+        WorkingSetID _freeList;
 
-        // The WorkingSetID returned by the next call to allocate().  Should refer to the next valid
-        // ID.  IDs allocated contiguously.  Should never point at an in-use ID.  
+        // The WorkingSetID returned by the next call to allocate() when the free list is empty.
+        // IDs below it have been handed out at least once.
         WorkingSetID _nextId;
 
         // All WSIDs invalidated during evaluation of a predicate (AND).
@@ -101,7 +118,8 @@ namespace mongo {
     /**
      * The type of the data passed between query stages.  In particular:
      *
-     * Index scan stages return a WorkingSetMember in the LOC_AND_IDX state.
+     * Index scan stages return a WorkingSetMember in the LOC_AND_IDX state.  Its key data may be
+     * empty if the scan was told its consumers don't need it.
      *
      * Collection scan stages the LOC_AND_UNOWNED_OBJ state.
      *
@@ -148,6 +166,11 @@ namespace mongo {
          * Returns false otherwise.  Returning false indicates a query planning error.
          */
         bool getFieldDotted(const string& field, BSONElement* out);
+
+        /**
+         * Returns the member to its initial state, keeping the keyData buffer for reuse.
+         */
+        void clear();
     };
 
 }  // namespace mongo
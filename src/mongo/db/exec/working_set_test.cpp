@@ -38,7 +38,6 @@ namespace {
         }
 
         void tearDown() {
-            ws = WorkingSet();
             member = NULL;
         }
 
@@ -46,6 +45,27 @@ namespace {
         WorkingSetMember* member;
     };
 
+    TEST_F(WorkingSetFixture, freedIdsAreReused) {
+        WorkingSetID id = ws.allocate();
+        WorkingSetMember* second = ws.get(id);
+        second->state = WorkingSetMember::OWNED_OBJ;
+        second->obj = BSON("a" << 1);
+        ws.free(id);
+
+        // The freed member comes back, reset.
+        ASSERT_EQUALS(id, ws.allocate());
+        ASSERT_EQUALS(second, ws.get(id));
+        ASSERT_EQUALS(WorkingSetMember::INVALID, second->state);
+        ASSERT_TRUE(second->obj.isEmpty());
+    }
+
+    TEST_F(WorkingSetFixture, membersDontMoveAsSetGrows) {
+        for (int i = 0; i < 10000; ++i) {
+            ws.allocate();
+        }
+        ASSERT_EQUALS(member, ws.get(0));
+    }
+
     TEST_F(WorkingSetFixture, noFieldToGet) {
         BSONElement elt;
 
@@ -32,12 +32,17 @@
 #include <sys/types.h>
 
 #include "mongo/db/kill_current_op.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/util/file.h"
 
 #if MONGO_USE_NEW_SORTER
 namespace mongo {
 
+    // Most spill files an index build merges at once.  0 merges them all in one pass; on
+    // spinning disks a lower fan-in spends an extra pass to save seeking between files.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildSortMaxFanIn, int, 0);
+
     namespace {
         class OldExtSortComparator {
         public:
@@ -65,11 +70,37 @@ namespace mongo {
 
     BSONObjExternalSorter::BSONObjExternalSorter(const ExternalSortComparison* comp,
                                                  long maxFileSize)
-        : _mayInterrupt(boost::make_shared<bool>(false))
+        : _comp(comp)
+        , _mayInterrupt(boost::make_shared<bool>(false))
         , _sorter(Sorter<BSONObj, DiskLoc>::make(
-                    SortOptions().ExtSortAllowed().MaxMemoryUsageBytes(maxFileSize),
+                    SortOptions().ExtSortAllowed()
+                                 .MaxMemoryUsageBytes(maxFileSize)
+                                 .MaxFanIn(std::max(indexBuildSortMaxFanIn, 0)),
                     OldExtSortComparator(comp, _mayInterrupt)))
     {}
+
+    auto_ptr<BSONObjExternalSorter::Iterator> BSONObjExternalSorter::iterator() {
+        if (_absorbed.empty()) {
+            return auto_ptr<Iterator>(_sorter->done());
+        }
+
+        vector<shared_ptr<Iterator> > iters;
+        iters.push_back(shared_ptr<Iterator>(_sorter->done()));
+        for (size_t i = 0; i < _absorbed.size(); i++) {
+            iters.push_back(shared_ptr<Iterator>(_absorbed[i]->iterator().release()));
+        }
+        return auto_ptr<Iterator>(Iterator::merge(iters,
+                                                  SortOptions(),
+                                                  OldExtSortComparator(_comp, _mayInterrupt)));
+    }
+
+    int BSONObjExternalSorter::numFiles() {
+        int files = _sorter->numFiles();
+        for (size_t i = 0; i < _absorbed.size(); i++) {
+            files += _absorbed[i]->numFiles();
+        }
+        return files;
+    }
 }
 
 #include "mongo/db/sorter/sorter.cpp"
@@ -59,16 +59,27 @@ namespace mongo {
             _sorter->add(o.getOwned(), loc);
         }
 
-        auto_ptr<Iterator> iterator() { return auto_ptr<Iterator>(_sorter->done()); }
+        /**
+         * Takes over 'other', which must sort with an equivalent comparison.  iterator() then
+         * merges what was added to either.  Lets several threads sort shares of the data into
+         * sorters of their own.
+         */
+        void absorb(auto_ptr<BSONObjExternalSorter> other) {
+            _absorbed.push_back(shared_ptr<BSONObjExternalSorter>(other.release()));
+        }
+
+        auto_ptr<Iterator> iterator();
 
         void sort( bool mayInterrupt ) { *_mayInterrupt = mayInterrupt; }
-        int numFiles() { return _sorter->numFiles(); }
+        int numFiles();
         long getCurSizeSoFar() { return _sorter->memUsed(); }
         void hintNumObjects(long long) {} // unused
 
     private:
+        const ExternalSortComparison* _comp;
         shared_ptr<bool> _mayInterrupt;
         scoped_ptr<Sorter<BSONObj, DiskLoc> > _sorter;
+        vector<shared_ptr<BSONObjExternalSorter> > _absorbed;
     };
 #else
     /**
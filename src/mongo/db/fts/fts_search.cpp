@@ -28,6 +28,19 @@ namespace mongo {
 
     namespace fts {
 
+        namespace {
+            // orders ScoredLocations so a heap of them has the best score on top
+            struct LowerScore {
+                bool operator()( const ScoredLocation& lhs, const ScoredLocation& rhs ) const {
+                    return lhs.score < rhs.score;
+                }
+            };
+
+            // the heap positions prefetched: the top's children and grandchildren, among which are
+            // the next candidates to be checked
+            const size_t prefetchWindow = 6;
+        }
+
         /*
          * Constructor generates query and term dictionaries
          * @param ns, namespace
@@ -83,6 +96,11 @@ namespace mongo {
                 cursors.push_back( c );
             }
 
+            if ( cursors.size() == 1 ) {
+                _goOneTerm( cursors[0].get(), results, limit );
+                return;
+            }
+
             while ( !inShutdown() ) {
                 bool gotAny = false;
                 for ( unsigned i = 0; i < cursors.size(); i++ ) {
@@ -100,35 +118,62 @@ namespace mongo {
             }
 
 
-            // priority queue using a compare that grabs the lowest of two ScoredLocations by score.
+            // Check phrases and negations on the best candidates first, and only until 'limit'
+            // of them pass, rather than on every candidate that might briefly make the top.
+            vector<ScoredLocation> candidates;
+            candidates.reserve( _scores.size() );
             for ( Scores::iterator i = _scores.begin(); i != _scores.end(); ++i ) {
-
                 if ( i->second < 0 )
                     continue;
+                candidates.push_back( ScoredLocation( i->first, i->second ) );
+            }
 
-                // priority queue
-                if ( results->size() < limit ) { // case a: queue unfilled
+            // a max-heap by score, popped lazily
+            make_heap( candidates.begin(), candidates.end(), LowerScore() );
+            vector<ScoredLocation>::iterator end = candidates.end();
+
+            // Ask for the records of the candidates just below the top of the heap while the top
+            // one is checked, so their page faults overlap.
+            const bool checkRecords = _query.hasNonTermPieces();
+            while ( end != candidates.begin() && results->size() < limit ) {
+                if ( checkRecords ) {
+                    const size_t avail = end - candidates.begin();
+                    for ( size_t j = 1; j < avail && j <= prefetchWindow; j++ )
+                        candidates[j].rec->prefetch();
+                }
 
-                    if ( !_ok( i->first ) )
-                        continue;
+                pop_heap( candidates.begin(), end, LowerScore() );
+                --end;
 
-                    results->push( ScoredLocation( i->first, i->second ) );
+                if ( !_ok( end->rec ) )
+                    continue;
 
-                }
-                else if ( i->second > results->top().score ) { // case b: queue filled
+                results->push( *end );
+            }
+        }
 
-                    if ( !_ok( i->first ) )
-                        continue;
+        /*
+         * A document has one key per term, and the cursor walks the term's keys from the highest
+         * score down, so the first documents to match are the best ones: stop at 'limit' of them
+         * instead of scoring every key.
+         */
+        void FTSSearch::_goOneTerm( BtreeCursor* cursor, Results* results, unsigned limit ) {
+            for ( ; !cursor->eof() && results->size() < limit && !inShutdown();
+                  cursor->advance() ) {
+                RARELY killCurrentOp.checkForInterrupt();
 
-                    results->pop();
-                    results->push( ScoredLocation( i->first, i->second ) );
-                }
-                else {
-                    // else do nothing (case c)
-                }
+                Record* record = cursor->currLoc().rec();
+                _process( cursor );
 
-            }
+                const double score = _scores[record];
+                if ( score < 0 )
+                    continue; // rejected by the filter
 
+                if ( !_ok( record ) )
+                    continue;
+
+                results->push( ScoredLocation( record, score ) );
+            }
         }
 
         /*
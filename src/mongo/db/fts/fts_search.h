@@ -72,6 +72,11 @@ namespace mongo {
 
             void _process( BtreeCursor* cursor );
 
+            /**
+             * go() for a query with a single term.
+             */
+            void _goOneTerm( BtreeCursor* cursor, Results* results, unsigned limit );
+
             /**
              * checks not index pieces
              * i.e. prhases & negated terms
@@ -208,13 +208,16 @@ namespace mongo {
 
             unsigned numTokens = 0;
 
+            // reused across tokens so lowering doesn't allocate per token
+            string term;
+
             Tokenizer i( tools.language, raw );
             while ( i.more() ) {
                 Token t = i.next();
                 if ( t.type != Token::TEXT )
                     continue;
 
-                string term = t.data.toString();
+                term.assign( t.data.rawData(), t.data.size() );
                 makeLower( &term );
                 if ( tools.stopwords->isStopWord( term ) )
                     continue;
@@ -25,6 +25,8 @@ namespace mongo {
 
     namespace fts {
 
+        const size_t Stemmer::maxCachedStems;
+
         Stemmer::Stemmer( const string& language ) {
             _stemmer = NULL;
             if ( language != "none" )
@@ -42,6 +44,11 @@ namespace mongo {
             if ( !_stemmer )
                 return word.toString();
 
+            std::string key = word.toString();
+            unordered_map<std::string,std::string>::const_iterator i = _cache.find( key );
+            if ( i != _cache.end() )
+                return i->second;
+
             const sb_symbol* sb_sym = sb_stemmer_stem( _stemmer,
                                                        (const sb_symbol*)word.rawData(),
                                                        word.size() );
@@ -51,7 +58,12 @@ namespace mongo {
                 abort();
             }
 
-            return string( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            if ( _cache.size() >= maxCachedStems )
+                _cache.clear();
+
+            std::string& stemmed = _cache[key];
+            stemmed.assign( (const char*)(sb_sym), sb_stemmer_length( _stemmer ) );
+            return stemmed;
         }
 
     }
@@ -22,6 +22,7 @@
 #include <string>
 
 #include "mongo/base/string_data.h"
+#include "mongo/platform/unordered_map.h"
 #include "third_party/libstemmer_c/include/libstemmer.h"
 
 namespace mongo {
@@ -39,8 +40,16 @@ namespace mongo {
             ~Stemmer();
 
             std::string stem( const StringData& word ) const;
+
+            // a document or query rarely has more distinct words than this
+            static const size_t maxCachedStems = 1024;
+
         private:
             struct sb_stemmer* _stemmer;
+
+            // word -> stem, so repeated words are only run through snowball once.
+            // emptied when it reaches maxCachedStems.
+            mutable unordered_map<std::string,std::string> _cache;
         };
     }
 }
@@ -37,6 +37,20 @@ namespace mongo {
             ASSERT_EQUALS( "Unite", s.stem( "United" ) );
         }
 
+        TEST( English, Cached ) {
+            Stemmer s( "english" );
+            ASSERT_EQUALS( "run", s.stem( "running" ) );
+            ASSERT_EQUALS( "run", s.stem( "running" ) );
+
+            // filling the cache past its bound must not change results
+            for ( size_t i = 0; i <= Stemmer::maxCachedStems; i++ ) {
+                std::string word( 1 + i / 26, 'a' + i % 26 );
+                s.stem( word + "ing" );
+            }
+            ASSERT_EQUALS( "run", s.stem( "running" ) );
+            ASSERT_EQUALS( "Run", s.stem( "Running" ) );
+        }
+
 
     }
 }
@@ -16,6 +16,7 @@
 *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
@@ -39,12 +40,14 @@ namespace mongo {
         }
 
 
-        StopWords::StopWords(){
+        StopWords::StopWords() : _maxLength( 0 ) {
         }
 
-        StopWords::StopWords( const std::set<std::string>& words ) {
-            for ( std::set<std::string>::const_iterator i = words.begin(); i != words.end(); ++i )
+        StopWords::StopWords( const std::set<std::string>& words ) : _maxLength( 0 ) {
+            for ( std::set<std::string>::const_iterator i = words.begin(); i != words.end(); ++i ) {
                 _words.insert( *i );
+                _maxLength = std::max( _maxLength, i->size() );
+            }
         }
 
         const StopWords* StopWords::getStopWords( const std::string& langauge ) {
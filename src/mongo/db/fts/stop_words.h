@@ -34,6 +34,9 @@ namespace mongo {
             StopWords( const std::set<std::string>& words );
 
             bool isStopWord( const std::string& word ) const {
+                // most words in a text are longer than any stop word
+                if ( word.size() > _maxLength )
+                    return false;
                 return _words.count( word ) > 0;
             }
 
@@ -43,6 +46,7 @@ namespace mongo {
         private:
             ~StopWords(){}
             unordered_set<std::string> _words;
+            size_t _maxLength;
         };
 
     }
@@ -236,6 +236,12 @@ namespace mongo {
                        || _geometryCollection->multiPolygons.vector().size() > 0));
     }
 
+    bool GeometryContainer::regionIsArea() const {
+        return (NULL != _polygon && _polygon->crs == SPHERE)
+               || (NULL != _cap && _cap->crs == SPHERE)
+               || NULL != _multiPolygon;
+    }
+
     bool GeometryContainer::hasS2Region() const {
         return NULL != _point
                || NULL != _line
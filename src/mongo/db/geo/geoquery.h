@@ -52,6 +52,17 @@ namespace mongo {
         // Used by s2cursor only to generate a covering of the query object.
         // One region is not NULL and this returns it.
         const S2Region& getRegion() const;
+
+        /**
+         * True if this is a polygon, multipolygon or cap on the sphere.  A point in any cell of
+         * an interior covering of such a region is both within and intersecting it.
+         */
+        bool regionIsArea() const;
+
+        /**
+         * The leaf cell of a single point, or NULL for any other geometry.
+         */
+        const S2Cell* getPointCell() const { return NULL == _point ? NULL : &_point->cell; }
     private:
         // Does 'this' intersect with the provided type?
         bool intersects(const S2Cell& otherPoint) const;
@@ -120,6 +131,7 @@ namespace mongo {
         bool hasS2Region() const;
         const S2Region& getRegion() const;
         string getField() const { return field; }
+        const GeometryContainer& getGeometry() const { return geoContainer; }
     private:
         // Try to parse the provided object into the right place.
         bool parseLegacyQuery(const BSONObj &obj);
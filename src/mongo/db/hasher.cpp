@@ -39,11 +39,44 @@ namespace mongo {
         md5_finish( &_md5State , out );
     }
 
+    namespace {
+        // Scalar values up to this size are hashed from one contiguous buffer.
+        const int maxFlatValueSize = 64;
+    }
+
     long long int BSONElementHasher::hash64( const BSONElement& e , HashSeed seed ){
-        scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
-        recursiveHash( h.get() , e , false );
         HashDigest d;
-        h->finish(d);
+        if ( !e.mayEncapsulate() && ( e.isNumber() || e.valuesize() <= maxFlatValueSize ) ) {
+            // Nearly every hashed index key and shard key is a number, ObjectId or short
+            // string.  Feed MD5 the same bytes recursiveHash would, in one append and
+            // without a heap allocated Hasher.
+            char buf[ sizeof( HashSeed ) + sizeof( int ) + maxFlatValueSize ];
+            size_t len = 0;
+            memcpy( buf , &seed , sizeof( seed ) );
+            len += sizeof( seed );
+            int canonicalType = e.canonicalType();
+            memcpy( buf + len , &canonicalType , sizeof( canonicalType ) );
+            len += sizeof( canonicalType );
+            if ( e.isNumber() ) {
+                long long int i = e.safeNumberLong();
+                memcpy( buf + len , &i , sizeof( i ) );
+                len += sizeof( i );
+            }
+            else {
+                memcpy( buf + len , e.value() , e.valuesize() );
+                len += e.valuesize();
+            }
+
+            md5_state_t st;
+            md5_init( &st );
+            md5_append( &st , reinterpret_cast< const md5_byte_t * >( buf ) , len );
+            md5_finish( &st , d );
+        }
+        else {
+            scoped_ptr<Hasher> h( HasherFactory::createHasher( seed ) );
+            recursiveHash( h.get() , e , false );
+            h->finish(d);
+        }
         //HashDigest is actually 16 bytes, but we just get 8 via truncation
         // NOTE: assumes little-endian
         return *reinterpret_cast< long long int * >( d );
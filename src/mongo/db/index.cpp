@@ -31,7 +31,9 @@
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_update.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/ops/delete.h"
+#include "mongo/db/queryutil.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/util/scopeguard.h"
 #include "mongo/util/mongoutils/str.h"
@@ -95,6 +97,7 @@ namespace mongo {
             NamespaceDetailsTransient::get( pns.c_str() ).deletedIndex();
 
             string name = indexName();
+            NamespaceDetailsTransient::get( pns.c_str() ).indexUsage().drop( name );
 
             /* important to catch exception here so we can finish cleanup below. */
             try {
@@ -184,6 +187,11 @@ namespace mongo {
             return false;
         }
 
+        if (existingDetails.info.obj().getObjectField("partialFilterExpression") !=
+                newSpec.getObjectField("partialFilterExpression")) {
+            return false;
+        }
+
         // Note: { _id: 1 } or { _id: -1 } implies unique: true.
         if (!existingDetails.isIdIndex() &&
                 existingDetails.unique() != newSpec["unique"].trueValue()) {
@@ -321,6 +329,26 @@ namespace mongo {
                 upgradeMinorVersionOrAssert(pluginName);
         }
 
+        const BSONElement partialFilter = io["partialFilterExpression"];
+        if ( !partialFilter.eoo() ) {
+            uassert(17017, "partialFilterExpression must be a non-empty object",
+                    partialFilter.type() == Object && !partialFilter.Obj().isEmpty());
+            uassert(17018, str::stream() << "partial indexes must have a plain key pattern, not "
+                                         << key,
+                    pluginName.empty() && !IndexDetails::isIdIndexPattern(key));
+
+            // The planner only uses a partial index for queries it can show imply the filter,
+            // which it can't for anything FieldRangeSet doesn't represent exactly.
+            StatusWithMatchExpression parsed = MatchExpressionParser::parse( partialFilter.Obj() );
+            uassertStatusOK( parsed.getStatus() );
+            delete parsed.getValue();
+            FieldRangeSet ranges( sourceNS.c_str(), partialFilter.Obj(), true, true );
+            uassert(17019, str::stream() << "partialFilterExpression may only hold equality, "
+                                         << "$in and range predicates on simple values: "
+                                         << partialFilter.Obj(),
+                    ranges.mustBeExactMatchRepresentation() && ranges.matchPossible());
+        }
+
         { 
             BSONObj o = io;
             o = IndexLegacy::adjustIndexSpecObject(o);
@@ -331,7 +359,7 @@ namespace mongo {
                 // note (one day) we may be able to fresh build less versions than we can use
                 // isASupportedIndexVersionNumber() is what we can use
                 uassert(14803, str::stream() << "this version of mongod cannot build new indexes of version number " << vv, 
-                    vv == 0 || vv == 1);
+                    vv == 0 || vv == 1 || vv == 2);
                 v = (int) vv;
             }
             // idea is to put things we use a lot earlier
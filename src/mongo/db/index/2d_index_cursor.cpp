@@ -349,10 +349,12 @@ namespace mongo {
             return true;
         }
 
-        void save(){ _cursor->noteLocation(); }
-        void restore(){ _cursor->checkLocation(); }
+        // A browse that doesn't use this location never made its cursor.
+        void save(){ if (_cursor) _cursor->noteLocation(); }
+        void restore(){ if (_cursor) _cursor->checkLocation(); }
 
         string toString() {
+            if (!_cursor) return "[unused]";
             stringstream ss;
             ss << "bucket: " << _cursor->getBucket().toString() << " pos: " << _cursor->getKeyOfs()
                << (_cursor->ok() ? (str::stream() << " k: " << _cursor->currKey()
@@ -361,6 +363,26 @@ namespace mongo {
             return ss.str();
         }
 
+        // Positions 'loc' at the first key whose hash is at least 'start', in key order.
+        static void seek(IndexDescriptor* descriptor, const TwoDIndexingParams& params,
+                         BtreeLocation& loc, const GeoHash& start) {
+            BSONObj query = BSON(params.geo << BSON(start.wrap("$gte").firstElement()
+                                                    << "$lt" << MAXKEY));
+            loc._frs.reset(new FieldRangeSet(descriptor->parentNS().c_str(), query, true, false));
+
+            BSONObjBuilder bob;
+            bob.append(params.geo, 1);
+            for(vector<pair<string, int> >::const_iterator i = params.other.begin();
+                i != params.other.end(); i++){
+                bob.append(i->first, i->second);
+            }
+            loc._keyPattern = bob.obj();
+
+            shared_ptr<FieldRangeVector> frv(new FieldRangeVector(*loc._frs, loc._keyPattern, 1));
+            loc._cursor.reset(BtreeCursor::make(nsdetails(descriptor->parentNS()),
+                                                descriptor->getOnDisk(), frv, 0, 1));
+        }
+
         // Returns the min and max keys which bound a particular location.
         // The only time these may be equal is when we actually equal the location
         // itself, otherwise our expanding algorithm will fail.
@@ -1621,8 +1643,16 @@ namespace mongo {
         shared_ptr<GeoHashConverter> _converter;
     };
 
+    /**
+     * Finds the points in a box by scanning the cells of a geohash cover of it, instead of
+     * expanding a search from its center.  The cover is the finest grid of cells, at most
+     * maxCoverCells of them, that the box overlaps.  Cells next to each other in key order
+     * are scanned as one range, so there is one btree seek per range of the cover.
+     */
     class GeoBoxBrowse : public GeoBrowse {
     public:
+        static const unsigned long long maxCoverCells = 64;
+
         GeoBoxBrowse(TwoDAccessMethod* accessMethod, const BSONObj& box, BSONObj filter = BSONObj(),
                      bool uniqueDocs = true)
             : GeoBrowse(accessMethod, "box", filter, uniqueDocs) {
@@ -1652,9 +1682,135 @@ namespace mongo {
                        std::max((_want._max.x - _want._min.x),
                                  (_want._max.y - _want._min.y)) / 2;
 
+            _range = 0;
+
             ok();
         }
 
+        // A run of 'count' cells of 'bits' bits that are adjacent in key order.
+        struct CoverRange {
+            CoverRange(const GeoHash& first) : first(first), count(1) { }
+            GeoHash first;
+            unsigned long long count;
+        };
+
+        /** Fills _cover with the ranges of cells the box's region overlaps, in key order. */
+        void makeCover() {
+            unsigned x0, y0, x1, y1;
+            _converter->hash(_wantRegion._min).unhash(&x0, &y0);
+            _converter->hash(_wantRegion._max).unhash(&x1, &y1);
+
+            // The finest level whose cells over the region are few enough.
+            unsigned bits = _converter->getBits();
+            for (; bits > 0; --bits) {
+                unsigned shift = 32 - bits;
+                unsigned long long cells =
+                    static_cast<unsigned long long>((x1 >> shift) - (x0 >> shift) + 1) *
+                    ((y1 >> shift) - (y0 >> shift) + 1);
+                if (cells <= maxCoverCells) break;
+            }
+
+            vector<GeoHash> cells;
+            if (bits == 0) {
+                cells.push_back(GeoHash(0u, 0u, 0));
+            }
+            else {
+                unsigned shift = 32 - bits;
+                for (unsigned x = x0 >> shift; x <= x1 >> shift; ++x) {
+                    for (unsigned y = y0 >> shift; y <= y1 >> shift; ++y) {
+                        cells.push_back(GeoHash(x << shift, y << shift, bits));
+                    }
+                }
+            }
+
+            // Keys sort by their hash as an unsigned big-endian number.
+            sort(cells.begin(), cells.end(), hashOrder);
+            for (vector<GeoHash>::const_iterator i = cells.begin(); i != cells.end(); ++i) {
+                _expPrefixes.push_back(*i);
+                if (!_cover.empty() &&
+                    (unsignedHash(*i) - unsignedHash(_cover.back().first)) >>
+                        (64 - 2 * bits) == _cover.back().count) {
+                    _cover.back().count++;
+                }
+                else {
+                    _cover.push_back(CoverRange(*i));
+                }
+            }
+            _expPrefix.reset(new GeoHash(cells.back()));
+        }
+
+        static unsigned long long unsignedHash(const GeoHash& hash) {
+            return static_cast<unsigned long long>(hash.getHash());
+        }
+
+        static bool hashOrder(const GeoHash& a, const GeoHash& b) {
+            return unsignedHash(a) < unsignedHash(b);
+        }
+
+        /** < 0 if 'key' is before 'range', 0 if in it, > 0 if after it. */
+        static int compareToRange(const BSONObj& key, const CoverRange& range) {
+            unsigned bits = range.first.getBits();
+            if (bits == 0) return 0;
+
+            unsigned long long hash = unsignedHash(GeoHash(key.firstElement()));
+            unsigned long long first = unsignedHash(range.first);
+            if (hash < first) return -1;
+            return ((hash - first) >> (64 - 2 * bits)) < range.count ? 0 : 1;
+        }
+
+        virtual void fillStack(int maxToCheck, int maxToAdd = -1, bool onlyExpand = false) {
+            if (maxToAdd < 0) maxToAdd = maxToCheck;
+            int maxFound = _foundInExp + maxToCheck;
+            verify(_found <= 0x7fffffff); // conversion to int
+            int maxAdded = static_cast<int>(_found) + maxToAdd;
+
+            if (_state == START) {
+                makeCover();
+                BtreeLocation::seek(_descriptor, _params, _scan, _cover[0].first);
+                _state = DOING_EXPAND;
+            }
+
+            while (_state == DOING_EXPAND) {
+                if (!_scan._cursor->ok()) {
+                    _state = DONE;
+                    return;
+                }
+
+                int where = compareToRange(_scan.key(), _cover[_range]);
+                if (where == 0) {
+                    if (_foundInExp >= maxFound || _found >= maxAdded) return;
+                    _foundInExp++;
+                    GeoKeyNode n(_scan._cursor->getBucket(), _scan._cursor->getKeyOfs(),
+                                 _scan._cursor->currLoc(), _scan._cursor->currKey());
+                    add(n);
+                    _scan._cursor->advance();
+                }
+                else if (where > 0) {
+                    // Past this range; the next may start at or before the current key.
+                    if (++_range == _cover.size()) {
+                        _state = DONE;
+                    }
+                    else if (compareToRange(_scan.key(), _cover[_range]) < 0) {
+                        BtreeLocation::seek(_descriptor, _params, _scan, _cover[_range].first);
+                    }
+                }
+                else {
+                    BtreeLocation::seek(_descriptor, _params, _scan, _cover[_range].first);
+                }
+            }
+        }
+
+        virtual void noteLocation() {
+            GeoBrowse::noteLocation();
+            _scan.save();
+        }
+
+        virtual void checkLocation() {
+            // GeoBrowse::checkLocation() may advance, which scans on.
+            _scan.restore();
+            GeoBrowse::checkLocation();
+        }
+
         void fixBox(Box& box) {
             if(box._min.x > box._max.x)
                 swap(box._min.x, box._max.x);
@@ -1704,6 +1860,10 @@ namespace mongo {
         double _fudge;
         GeoHash _start;
         shared_ptr<GeoHashConverter> _converter;
+
+        vector<CoverRange> _cover;
+        size_t _range;
+        BtreeLocation _scan;
     };
 
     class GeoPolygonBrowse : public GeoBrowse {
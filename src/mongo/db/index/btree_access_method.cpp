@@ -16,6 +16,7 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/base/status.h"
@@ -23,6 +24,7 @@
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/keypattern.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/pdfile_private.h"
 
@@ -31,7 +33,7 @@ namespace mongo {
     BtreeBasedAccessMethod::BtreeBasedAccessMethod(IndexDescriptor *descriptor)
         : _descriptor(descriptor), _ordering(Ordering::make(_descriptor->keyPattern())) {
 
-        verify(0 == descriptor->version() || 1 == descriptor->version());
+        verify(0 <= descriptor->version() && descriptor->version() <= 2);
         _interface = BtreeInterface::interfaces[descriptor->version()];
     }
 
@@ -80,6 +82,100 @@ namespace mongo {
         return ret;
     }
 
+    namespace {
+
+        // One key of a document in a bulk insert.
+        struct BulkKey {
+            BulkKey(const BSONObj& k, size_t d) : key(k), doc(d) { }
+            BSONObj key;
+            size_t doc;
+        };
+
+        // Orders keys as the index does, then by position in the batch.
+        class BulkKeyLess {
+        public:
+            BulkKeyLess(const Ordering& ordering) : _ordering(ordering) { }
+
+            bool operator()(const BulkKey& a, const BulkKey& b) const {
+                int cmp = a.key.woCompare(b.key, _ordering, false);
+                if (0 != cmp) {
+                    return cmp < 0;
+                }
+                return a.doc < b.doc;
+            }
+
+        private:
+            Ordering _ordering;
+        };
+
+    }  // namespace
+
+    Status BtreeBasedAccessMethod::insertBulk(const vector<BSONObj>& objs,
+                                              const vector<DiskLoc>& locs,
+                                              const InsertDeleteOptions& options,
+                                              vector<bool>* failed) {
+        verify(objs.size() == locs.size());
+        verify(objs.size() == failed->size());
+
+        vector<BulkKey> keys;
+        for (size_t i = 0; i < objs.size(); ++i) {
+            if ((*failed)[i]) {
+                continue;
+            }
+
+            BSONObjSet docKeys;
+            try {
+                // Delegate to the subclass.
+                getKeys(objs[i], &docKeys);
+            }
+            catch (AssertionException&) {
+                (*failed)[i] = true;
+                continue;
+            }
+
+            for (BSONObjSet::const_iterator j = docKeys.begin(); j != docKeys.end(); ++j) {
+                keys.push_back(BulkKey(*j, i));
+            }
+        }
+
+        std::sort(keys.begin(), keys.end(), BulkKeyLess(_ordering));
+
+        vector<int> numInserted(objs.size(), 0);
+        bool isMultikey = false;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const size_t doc = keys[i].doc;
+            if ((*failed)[doc]) {
+                continue;
+            }
+
+            try {
+                _interface->bt_insert(_descriptor->getHead(), locs[doc], keys[i].key, _ordering,
+                                      options.dupsAllowed, _descriptor->getOnDisk(), true);
+                if (++numInserted[doc] > 1) {
+                    isMultikey = true;
+                }
+            } catch (AssertionException& e) {
+                if (10287 == e.getCode() && _descriptor->isBackgroundIndex()) {
+                    // The duplicate key exception, ignored in BG indexing as in insert().
+                    DEV log() << "info: key already in index during bg indexing (ok)\n";
+                } else {
+                    if (options.dupsAllowed) {
+                        problem() << " caught assertion addKeysToIndex "
+                                  << _descriptor->indexNamespace()
+                                  << objs[doc]["_id"] << endl;
+                    }
+                    (*failed)[doc] = true;
+                }
+            }
+        }
+
+        if (isMultikey) {
+            _descriptor->setMultikey();
+        }
+
+        return Status::OK();
+    }
+
     bool BtreeBasedAccessMethod::removeOneKey(const BSONObj& key, const DiskLoc& loc) {
         bool ret = false;
 
@@ -224,6 +320,26 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool BtreeBasedAccessMethod::keysEqual(const BSONObj& from, const BSONObj& to) {
+        BSONObjSet fromKeys;
+        BSONObjSet toKeys;
+        getKeys(from, &fromKeys);
+        getKeys(to, &toKeys);
+
+        if (fromKeys.size() != toKeys.size()) {
+            return false;
+        }
+
+        // Equal as setDifference() sees it, so update() would have nothing to add or remove.
+        for (BSONObjSet::const_iterator i = fromKeys.begin(), j = toKeys.begin();
+             i != fromKeys.end(); ++i, ++j) {
+            if (0 != i->woCompare(*j)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     // Standard Btree implementation below.
     BtreeAccessMethod::BtreeAccessMethod(IndexDescriptor* descriptor)
         : BtreeBasedAccessMethod(descriptor) {
@@ -242,15 +358,25 @@ namespace mongo {
         if (0 == descriptor->version()) {
             _keyGenerator.reset(new BtreeKeyGeneratorV0(fieldNames, fixed,
                 _descriptor->isSparse()));
-        } else if (1 == descriptor->version()) {
+        } else if (1 == descriptor->version() || 2 == descriptor->version()) {
             _keyGenerator.reset(new BtreeKeyGeneratorV1(fieldNames, fixed,
                 _descriptor->isSparse()));
         } else {
             massert(16745, "Invalid index version for key generation.", false );
         }
+
+        if (_descriptor->isPartial()) {
+            StatusWithMatchExpression parsed =
+                MatchExpressionParser::parse(_descriptor->partialFilter());
+            massert(17020, parsed.getStatus().reason(), parsed.isOK());
+            _partialFilter.reset(parsed.getValue());
+        }
     }
 
     void BtreeAccessMethod::getKeys(const BSONObj& obj, BSONObjSet* keys) {
+        if (_partialFilter && !_partialFilter->matchesBSON(obj)) {
+            return;
+        }
         _keyGenerator->getKeys(obj, keys);
     }
 
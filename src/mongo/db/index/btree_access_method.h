@@ -24,6 +24,7 @@
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/db/index/btree_access_method_internal.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/matcher/expression.h"
 
 namespace mongo {
 
@@ -53,6 +54,9 @@ namespace mongo {
 
         // Our keys differ for V0 and V1.
         scoped_ptr<BtreeKeyGenerator> _keyGenerator;
+
+        // Set for a partial index: documents that don't match it get no keys.
+        scoped_ptr<MatchExpression> _partialFilter;
     };
 
 }  // namespace mongo
@@ -45,6 +45,11 @@ namespace mongo {
                               const InsertDeleteOptions& options,
                               int64_t* numInserted);
 
+        virtual Status insertBulk(const vector<BSONObj>& objs,
+                                  const vector<DiskLoc>& locs,
+                                  const InsertDeleteOptions& options,
+                                  vector<bool>* failed);
+
         virtual Status remove(const BSONObj& obj,
                               const DiskLoc& loc,
                               const InsertDeleteOptions& options,
@@ -58,6 +63,8 @@ namespace mongo {
 
         virtual Status update(const UpdateTicket& ticket, int64_t* numUpdated);
 
+        virtual bool keysEqual(const BSONObj& from, const BSONObj& to);
+
         virtual Status newCursor(IndexCursor **out) = 0;
 
         virtual Status touch(const BSONObj& obj);
@@ -16,6 +16,13 @@
 
 #include "mongo/db/index/btree_based_builder.h"
 
+#include <deque>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition.hpp>
+
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/btreebuilder.h"
 #include "mongo/db/index/catalog_hack.h"
 #include "mongo/db/index/index_descriptor.h"
@@ -23,12 +30,19 @@
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/sort_phase_one.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/db/pdfile_private.h"
 
 namespace mongo {
 
+    // Threads generating and sorting keys in phase one of a foreground index build.  With more
+    // than one, the thread holding the lock only scans the collection and hands out documents.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildThreads, int, 1);
+
     int oldCompare(const BSONObj& l,const BSONObj& r, const Ordering &o); // key.cpp
 
     class ExternalSortComparisonV0 : public ExternalSortComparison {
@@ -122,11 +136,198 @@ namespace mongo {
         }
     }
 
+    namespace {
+
+        typedef vector<ExternalSortDatum> DocBatch;
+
+        // Documents handed to a key generating thread at a time.
+        const size_t kDocBatchSize = 1000;
+
+        // Batches queued per key generating thread before the scan waits.
+        const size_t kQueuedBatchesPerThread = 4;
+
+        // Phase one sorts in this much memory, split between the key generating threads.
+        const long kPhaseOneSortMemory = 100 * 1024 * 1024;
+
+        /**
+         * Hands batches of documents from the thread scanning a collection to the threads
+         * generating their keys.  Bounded, so the scan can't run far ahead of key generation.
+         */
+        class DocBatchQueue : boost::noncopyable {
+        public:
+            explicit DocBatchQueue(size_t maxBatches)
+                : _mutex("DocBatchQueue")
+                , _maxBatches(maxBatches)
+                , _finished(false)
+                , _closed(false) {
+            }
+
+            /**
+             * Takes the contents of 'batch', blocking while the queue is full.  Returns false,
+             * leaving 'batch' alone, if the queue has been closed.
+             */
+            bool push(DocBatch* batch) {
+                scoped_lock lk(_mutex);
+                while (!_closed && _batches.size() >= _maxBatches) {
+                    _changed.wait(lk.boost());
+                }
+                if (_closed) {
+                    return false;
+                }
+                _batches.push_back(DocBatch());
+                _batches.back().swap(*batch);
+                _changed.notify_all();
+                return true;
+            }
+
+            /**
+             * Blocks until a batch can be moved into 'batch'.  Returns false once the queue is
+             * finished and empty, or closed.
+             */
+            bool pop(DocBatch* batch) {
+                scoped_lock lk(_mutex);
+                while (!_closed && !_finished && _batches.empty()) {
+                    _changed.wait(lk.boost());
+                }
+                if (_closed || _batches.empty()) {
+                    return false;
+                }
+                batch->swap(_batches.front());
+                _batches.pop_front();
+                _changed.notify_all();
+                return true;
+            }
+
+            /** Nothing more will be pushed.  What is queued can still be popped. */
+            void finish() {
+                scoped_lock lk(_mutex);
+                _finished = true;
+                _changed.notify_all();
+            }
+
+            /** Stops both ends now, dropping whatever is queued. */
+            void close() {
+                scoped_lock lk(_mutex);
+                _closed = true;
+                _batches.clear();
+                _changed.notify_all();
+            }
+
+        private:
+            mongo::mutex _mutex;
+            boost::condition _changed;
+            const size_t _maxBatches;
+            std::deque<DocBatch> _batches;
+            bool _finished;
+            bool _closed;
+        };
+
+        /**
+         * Closes a DocBatchQueue when it goes out of scope, so threads waiting on it don't
+         * outlive an index build that failed on the scanning thread.
+         */
+        class DocBatchQueueCloser : boost::noncopyable {
+        public:
+            explicit DocBatchQueueCloser(DocBatchQueue* queue) : _queue(queue) { }
+            ~DocBatchQueueCloser() { _queue->close(); }
+        private:
+            DocBatchQueue* _queue;
+        };
+
+        /**
+         * Generates the keys of the documents popped from a DocBatchQueue on a thread of its
+         * own, sorting them into a sorter of its own.  The documents are not copied: they stay
+         * put while the scanning thread holds the write lock, which it does until the keys have
+         * all been merged into the index.
+         *
+         * There is no Client on the thread, so the sorter never checks for interrupts.  The
+         * scanning thread does that instead.
+         */
+        class KeyGenerator : boost::noncopyable {
+        public:
+            typedef boost::function<void (const BSONObj&, BSONObjSet*)> GetKeysFn;
+
+            KeyGenerator(const GetKeysFn& getKeys,
+                         const ExternalSortComparison* comp,
+                         long maxSortMemory,
+                         DocBatchQueue* queue)
+                : n(0)
+                , nkeys(0)
+                , multi(false)
+                , _getKeys(getKeys)
+                , _queue(queue)
+                , _sorter(new BSONObjExternalSorter(comp, maxSortMemory))
+                , _failed(false)
+                , _errorCode(0) {
+            }
+
+            void run() {
+                try {
+                    DocBatch batch;
+                    while (_queue->pop(&batch)) {
+                        for (DocBatch::const_iterator it = batch.begin(); it != batch.end(); ++it) {
+                            BSONObjSet keys;
+                            _getKeys(it->first, &keys);
+                            multi = multi || (keys.size() > 1);
+                            for (BSONObjSet::const_iterator k = keys.begin(); k != keys.end(); ++k) {
+                                _sorter->add(*k, it->second, false);
+                                ++nkeys;
+                            }
+                            ++n;
+                        }
+                    }
+                }
+                catch (DBException& e) {
+                    fail(e.getCode(), e.what());
+                }
+                catch (std::exception& e) {
+                    fail(16988, e.what());
+                }
+            }
+
+            /** Rethrows, on the calling thread, an error that stopped run(). */
+            void checkFailed() const {
+                if (_failed) {
+                    uasserted(_errorCode, _errorMessage);
+                }
+            }
+
+            auto_ptr<BSONObjExternalSorter> releaseSorter() { return _sorter; }
+
+            unsigned long long n;
+            unsigned long long nkeys;
+            bool multi;
+
+        private:
+            void fail(int code, const string& message) {
+                _failed = true;
+                _errorCode = code;
+                _errorMessage = message;
+                // Stop the scan and the other generators.
+                _queue->close();
+            }
+
+            const GetKeysFn _getKeys;
+            DocBatchQueue* _queue;
+            auto_ptr<BSONObjExternalSorter> _sorter;
+            bool _failed;
+            int _errorCode;
+            string _errorMessage;
+        };
+
+        void runKeyGenerator(KeyGenerator* generator) {
+            generator->run();
+        }
+
+    }  // namespace
+
     DiskLoc BtreeBasedBuilder::makeEmptyIndex(const IndexDetails& idx) {
         if (0 == idx.version()) {
             return BtreeBucket<V0>::addBucket(idx);
-        } else {
+        } else if (1 == idx.version()) {
             return BtreeBucket<V1>::addBucket(idx);
+        } else {
+            return BtreeBucket<V2>::addBucket(idx);
         }
     }
 
@@ -135,7 +336,8 @@ namespace mongo {
         if (0 == version) {
             return new ExternalSortComparisonV0(keyPattern);
         } else {
-            verify(1 == version);
+            // v:2 keys are in the v:1 format, only their storage in buckets differs
+            verify(1 == version || 2 == version);
             return new ExternalSortComparisonV1(keyPattern);
         }
     }
@@ -147,9 +349,16 @@ namespace mongo {
                            int64_t nrecords,
                            ProgressMeter* progressMeter,
                            bool mayInterrupt, int idxNo) {
+        if (indexBuildThreads > 1) {
+            addKeysToPhaseOneInParallel(d, ns, idx, phaseOne, indexBuildThreads, progressMeter,
+                                        mayInterrupt, idxNo);
+            return;
+        }
+
         shared_ptr<Cursor> cursor = theDataFileMgr.findAll( ns );
         phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
-        phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get()));
+        phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get(),
+                                                         kPhaseOneSortMemory));
         phaseOne->sorter->hintNumObjects( nrecords );
         auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
         auto_ptr<BtreeBasedAccessMethod> iam(CatalogHack::getBtreeBasedIndex(desc.get()));
@@ -168,6 +377,68 @@ namespace mongo {
         }
     }
 
+    void BtreeBasedBuilder::addKeysToPhaseOneInParallel(NamespaceDetails* d, const char* ns,
+                                                        const IndexDetails& idx,
+                                                        SortPhaseOne* phaseOne,
+                                                        int nThreads,
+                                                        ProgressMeter* progressMeter,
+                                                        bool mayInterrupt, int idxNo) {
+        phaseOne->sortCmp.reset(getComparison(idx.version(), idx.keyPattern()));
+        phaseOne->sorter.reset(new BSONObjExternalSorter(phaseOne->sortCmp.get()));
+        auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, idxNo));
+
+        // Declared so that on the way out the queue is closed, then the threads are joined,
+        // then what they use is destroyed.
+        DocBatchQueue queue(nThreads * kQueuedBatchesPerThread);
+        OwnedPointerVector<BtreeBasedAccessMethod> iams;
+        OwnedPointerVector<KeyGenerator> generators;
+        for (int i = 0; i < nThreads; i++) {
+            // Each thread gets its own access method, as they aren't meant to be shared.
+            iams.mutableVector().push_back(CatalogHack::getBtreeBasedIndex(desc.get()));
+            generators.mutableVector().push_back(
+                    new KeyGenerator(boost::bind(&BtreeBasedAccessMethod::getKeys,
+                                                 iams.vector()[i], _1, _2),
+                                     phaseOne->sortCmp.get(),
+                                     kPhaseOneSortMemory / nThreads, &queue));
+        }
+        ThreadPool pool(nThreads);
+        DocBatchQueueCloser closer(&queue);
+        for (int i = 0; i < nThreads; i++) {
+            pool.schedule(runKeyGenerator, generators.vector()[i]);
+        }
+
+        shared_ptr<Cursor> cursor = theDataFileMgr.findAll( ns );
+        DocBatch batch;
+        batch.reserve(kDocBatchSize);
+        bool queueClosed = false;
+        while ( cursor->ok() && !queueClosed ) {
+            RARELY killCurrentOp.checkForInterrupt( !mayInterrupt );
+            batch.push_back(make_pair(cursor->current(), cursor->currLoc()));
+            if (batch.size() == kDocBatchSize) {
+                queueClosed = !queue.push(&batch);
+                batch.reserve(kDocBatchSize);
+            }
+            cursor->advance();
+            progressMeter->hit();
+        }
+        if (!batch.empty() && !queueClosed) {
+            queue.push(&batch);
+        }
+        queue.finish();
+        pool.join();
+
+        for (int i = 0; i < nThreads; i++) {
+            generators.vector()[i]->checkFailed();
+        }
+        for (int i = 0; i < nThreads; i++) {
+            KeyGenerator* generator = generators.vector()[i];
+            phaseOne->n += generator->n;
+            phaseOne->nkeys += generator->nkeys;
+            phaseOne->multi = phaseOne->multi || generator->multi;
+            phaseOne->sorter->absorb(generator->releaseSorter());
+        }
+    }
+
     uint64_t BtreeBasedBuilder::fastBuildIndex(const char* ns, NamespaceDetails* d,
                                                IndexDetails& idx, bool mayInterrupt,
                                                int idxNo) {
@@ -236,6 +507,17 @@ namespace mongo {
                                          pm,
                                          t,
                                          mayInterrupt);
+        else if( idx.version() == 2 )
+            buildBottomUpPhases2And3<V2>(dupsAllowed,
+                                         idx,
+                                         sorter,
+                                         dropDups,
+                                         dupsToDrop,
+                                         op,
+                                         &phase1,
+                                         pm,
+                                         t,
+                                         mayInterrupt);
         else
             verify(false);
 
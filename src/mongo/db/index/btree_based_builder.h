@@ -23,6 +23,7 @@
 
 namespace IndexUpdateTests {
     class AddKeysToPhaseOne;
+    class AddKeysToPhaseOneInParallel;
     class InterruptAddKeysToPhaseOne;
     class DoDropDups;
     class InterruptDoDropDups;
@@ -50,6 +51,7 @@ namespace mongo {
 
     private:
         friend class IndexUpdateTests::AddKeysToPhaseOne;
+        friend class IndexUpdateTests::AddKeysToPhaseOneInParallel;
         friend class IndexUpdateTests::InterruptAddKeysToPhaseOne;
         friend class IndexUpdateTests::DoDropDups;
         friend class IndexUpdateTests::InterruptDoDropDups;
@@ -61,6 +63,16 @@ namespace mongo {
                                       bool mayInterrupt,
                                       int idxNo);
 
+        /**
+         * addKeysToPhaseOne() for more than one thread.  This thread scans the collection and
+         * hands the documents to 'nThreads' others, which generate and sort their keys.  Their
+         * sorted keys are merged into phaseOne's sorter.
+         */
+        static void addKeysToPhaseOneInParallel(NamespaceDetails* d, const char* ns,
+                                                const IndexDetails& idx, SortPhaseOne* phaseOne,
+                                                int nThreads, ProgressMeter* progressMeter,
+                                                bool mayInterrupt, int idxNo);
+
         static void doDropDups(const char* ns, NamespaceDetails* d, const set<DiskLoc>& dupsToDrop,
                                bool mayInterrupt );
     };
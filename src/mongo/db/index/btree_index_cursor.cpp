@@ -23,6 +23,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/platform/unordered_set.h"
 
 namespace mongo {
@@ -34,15 +35,21 @@ namespace mongo {
     BtreeIndexCursor::BtreeIndexCursor(IndexDescriptor *descriptor, Ordering ordering,
                                        BtreeInterface *interface)
         : _direction(1), _descriptor(descriptor), _ordering(ordering), _interface(interface),
-          _bucket(descriptor->getHead()), _keyOffset(0) {
+          _bucket(descriptor->getHead()), _keyOffset(0),
+          _usage(NamespaceDetailsTransient::get(descriptor->parentNS().c_str())
+                     .indexUsage().get(descriptor->indexName())),
+          _seeks(0), _keysScanned(0) {
 
         SimpleMutex::scoped_lock lock(_activeCursorsMutex);
         _activeCursors.insert(this);
     }
 
     BtreeIndexCursor::~BtreeIndexCursor() {
-        SimpleMutex::scoped_lock lock(_activeCursorsMutex);
-        _activeCursors.erase(this);
+        {
+            SimpleMutex::scoped_lock lock(_activeCursorsMutex);
+            _activeCursors.erase(this);
+        }
+        _usage->record(_seeks, _keysScanned);
     }
 
     bool BtreeIndexCursor::isEOF() const { return _bucket.isNull(); }
@@ -87,6 +94,7 @@ namespace mongo {
                 found,
                 1 == _direction ? minDiskLoc : maxDiskLoc,
                 _direction);
+        noteSeek();
 
         skipUnusedKeys();
 
@@ -113,6 +121,7 @@ namespace mongo {
                 _ordering,
                 (int)_direction,
                 ignored);
+        noteSeek();
 
         skipUnusedKeys();
 
@@ -132,6 +141,7 @@ namespace mongo {
             keyEndInclusive,
             _ordering,
             (int)_direction);
+        noteSeek();
 
         skipUnusedKeys();
         return Status::OK();
@@ -245,6 +255,16 @@ namespace mongo {
     // Move to the next/prev. key.  Used by normal getNext and also skipping unused keys.
     void BtreeIndexCursor::advance(const char* caller) {
         _bucket = _interface->advance(_bucket, _keyOffset, _direction, caller);
+        if (!isEOF()) {
+            ++_keysScanned;
+        }
+    }
+
+    void BtreeIndexCursor::noteSeek() {
+        ++_seeks;
+        if (!isEOF()) {
+            ++_keysScanned;
+        }
     }
 
 }  // namespace mongo
@@ -23,6 +23,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/index/index_cursor.h"
+#include "mongo/db/index_usage.h"
 #include "mongo/db/index/index_descriptor.h"
 
 namespace mongo {
@@ -82,6 +83,9 @@ namespace mongo {
         // Move to the next/prev. key.  Used by normal getNext and also skipping unused keys.
         void advance(const char* caller);
 
+        // Counts a seek or skip, and the key it landed on.
+        void noteSeek();
+
         // For saving/restoring position.
         BSONObj _savedKey;
         DiskLoc _savedLoc;
@@ -97,6 +101,11 @@ namespace mongo {
         DiskLoc _bucket;
         // And we look at an offset in the bucket.
         int _keyOffset;
+
+        // Counted here and recorded into _usage when we're destroyed.
+        shared_ptr<IndexUsage> _usage;
+        long long _seeks;
+        long long _keysScanned;
     };
 
 }  // namespace mongo
@@ -103,9 +103,11 @@ namespace mongo {
     }
 
     string HaystackAccessMethod::makeString(int hashedX, int hashedY) const {
-        stringstream ss;
-        ss << hashedX << "_" << hashedY;
-        return ss.str();
+        // Called for every document an index build sees, where a stringstream's setup
+        // outweighs the formatting.
+        StringBuilder buf;
+        buf << hashedX << '_' << hashedY;
+        return buf.str();
     }
 
     // Build a new BSONObj with root in it.  If e is non-empty, append that to the key.  Insert
@@ -146,19 +148,23 @@ namespace mongo {
 
         long long btreeMatches = 0;
 
+        // The rest of every bucket's key, which is the same for them all.
+        BSONObjBuilder termsBuilder;
+        for (unsigned i = 0; i < _otherFields.size(); i++) {
+            // See if the non-geo field we're indexing on is in the provided search term.
+            BSONElement e = search.getFieldDotted(_otherFields[i]);
+            if (e.eoo())
+                termsBuilder.appendNull("");
+            else
+                termsBuilder.appendAs(e, "");
+        }
+        BSONObj terms = termsBuilder.obj();
+
         for (int a = -scale; a <= scale && !hopper.limitReached(); ++a) {
             for (int b = -scale; b <= scale && !hopper.limitReached(); ++b) {
                 BSONObjBuilder bb;
                 bb.append("", makeString(x + a, y + b));
-
-                for (unsigned i = 0; i < _otherFields.size(); i++) {
-                    // See if the non-geo field we're indexing on is in the provided search term.
-                    BSONElement e = search.getFieldDotted(_otherFields[i]);
-                    if (e.eoo())
-                        bb.appendNull("");
-                    else
-                        bb.appendAs(e, "");
-                }
+                bb.appendElements(terms);
 
                 BSONObj key = bb.obj();
 
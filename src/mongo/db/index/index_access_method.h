@@ -93,6 +93,12 @@ namespace mongo {
          */
         virtual Status update(const UpdateTicket& ticket, int64_t* numUpdated) = 0;
 
+        /**
+         * Returns true if 'from' and 'to' generate the same keys, so that updating a document
+         * from one to the other would leave this index as it is.
+         */
+        virtual bool keysEqual(const BSONObj& from, const BSONObj& to) = 0;
+
         /**
          * Fills in '*out' with an IndexCursor.  Return a status indicating success or reason of
          * failure. If the latter, '*out' contains NULL.  See index_cursor.h for IndexCursor usage.
@@ -119,10 +125,24 @@ namespace mongo {
         virtual Status validate(int64_t* numKeys) = 0;
 
         //
-        // Bulk operations support (TODO)
+        // Bulk operations support
         //
 
-        // virtual Status insertBulk(BulkDocs arg) = 0;
+        /**
+         * Inserts the keys for a batch of documents, 'objs[i]' being at 'locs[i]'.  The keys
+         * for the whole batch are sorted and inserted in key order, so that consecutive inserts
+         * descend through the same, already cached, part of the index.  Documents with
+         * (*failed)[i] set are skipped.  If generating or inserting a document's keys fails,
+         * (*failed)[i] is set and its remaining keys are skipped.  Keys already inserted for a
+         * failed document are left for the caller to remove.
+         *
+         * Among equal keys, the document earlier in 'objs' goes in first, so a unique index
+         * fails the same documents it would were they inserted one at a time.
+         */
+        virtual Status insertBulk(const vector<BSONObj>& objs,
+                                  const vector<DiskLoc>& locs,
+                                  const InsertDeleteOptions& options,
+                                  vector<bool>* failed) = 0;
 
         // virtual Status removeBulk(BulkDocs arg) = 0;
     };
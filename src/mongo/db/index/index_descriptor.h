@@ -106,6 +106,15 @@ namespace mongo {
         // Is this index sparse?
         bool isSparse() const { return _infoObj["sparse"].trueValue(); }
 
+        // The filter a partial index holds only the matching documents of.  Empty if the
+        // index isn't partial.
+        BSONObj partialFilter() const {
+            return _infoObj.getObjectField("partialFilterExpression");
+        }
+
+        // Does this index hold only some of the collection's documents?
+        bool isPartial() const { return !partialFilter().isEmpty(); }
+
         // Is this index multikey?
         bool isMultikey() const { return _namespaceDetails->isMultikey(_indexNumber); }
 
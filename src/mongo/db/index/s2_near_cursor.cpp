@@ -25,6 +25,10 @@
 
 namespace mongo {
 
+    // A shell keeps at most this many results.  Past that, it is narrowed so a dense area doesn't
+    // compute and hold far results before the near ones are returned.
+    static const size_t maxResultsPerShell = 1000;
+
     S2NearIndexCursor::S2NearIndexCursor(IndexDescriptor* descriptor,
                                          const S2IndexingParams& params)
         : _descriptor(descriptor), _params(params) { }
@@ -321,6 +325,7 @@ namespace mongo {
                     if (_returned.end() == _returned.find(cursor->currLoc())) {
                         _results.push(Result(cursor->currLoc(), cursor->currKey(),
                                     minDistance));
+                        if (_results.size() > 2 * maxResultsPerShell) { trimResults(); }
                     }
                 }
             }
@@ -340,6 +345,29 @@ namespace mongo {
         LOG(1) << "Filled shell with " << _results.size() << " results" << endl;
     }
 
+    void S2NearIndexCursor::trimResults() {
+        vector<Result> closest;
+        closest.reserve(_results.size());
+        while (!_results.empty()) {
+            closest.push_back(_results.top());
+            _results.pop();
+        }
+
+        // Everything at one distance can't be split between shells; keep it all.
+        const double newOuterRadius = closest[maxResultsPerShell].distance;
+        if (newOuterRadius <= _innerRadius) {
+            for (size_t i = 0; i < closest.size(); ++i) { _results.push(closest[i]); }
+            return;
+        }
+
+        LOG(1) << "narrowing shell from " << _outerRadius << " to " << newOuterRadius << endl;
+        _outerRadius = newOuterRadius;
+        for (size_t i = 0; i < maxResultsPerShell && closest[i].distance < _outerRadius; ++i) {
+            _results.push(closest[i]);
+        }
+        ++_stats._numShellTrims;
+    }
+
     // Grow _innerRadius and _outerRadius by _radiusIncrement, capping _outerRadius at halfway
     // around the world (pi * _params.radius).
     void S2NearIndexCursor::nextAnnulus() {
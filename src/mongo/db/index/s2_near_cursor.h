@@ -91,6 +91,13 @@ namespace mongo {
          */
         void nextAnnulus();
 
+        /**
+         * Keep only the closest results once a shell holds too many, pulling _outerRadius in to
+         * the distance of the first one dropped.  Dropped results are found again by the next
+         * shell, which starts there.
+         */
+        void trimResults();
+
         double distanceTo(const BSONObj &obj);
 
         IndexDescriptor* _descriptor;
@@ -139,7 +146,7 @@ namespace mongo {
         struct Stats {
             Stats() : _nscanned(0), _matchTested(0), _geoMatchTested(0), _numShells(0),
                       _keyGeoSkip(0), _returnSkip(0), _btreeDups(0), _inAnnulusTested(0),
-                      _numReturned(0) {}
+                      _numReturned(0), _numShellTrims(0) {}
             // Stat counters/debug information goes below.
             // How many items did we look at in the btree?
             long long _nscanned;
@@ -155,6 +162,8 @@ namespace mongo {
             long long _btreeDups;
             long long _inAnnulusTested;
             long long _numReturned;
+            // How many times was a shell narrowed because it held too many results?
+            long long _numShellTrims;
         };
 
         Stats _stats;
@@ -32,6 +32,7 @@ namespace mongo {
         _nscanned = 0;
         _matchTested = 0;
         _geoTested = 0;
+        _interiorMatched = 0;
         _fields = regions;
         _seen = unordered_set<DiskLoc, DiskLoc::Hasher>();
 
@@ -75,6 +76,18 @@ namespace mongo {
             frsObjBuilder.appendElements(fieldRange);
         }
 
+        _interiors.clear();
+        for (size_t i = 0; i < _fields.size(); ++i) {
+            vector<S2CellId> interior;
+            if (_fields[i].getGeometry().regionIsArea()) {
+                S2RegionCoverer interiorCoverer;
+                _params.configureCoverer(&interiorCoverer);
+                interiorCoverer.GetInteriorCovering(_fields[i].getRegion(), &interior);
+            }
+            _interiors.mutableVector().push_back(new S2CellUnion());
+            _interiors.vector().back()->InitSwap(&interior);
+        }
+
         frsObj = frsObjBuilder.obj();
 
         FieldRangeSet frs(_descriptor->parentNS().c_str(), frsObj, false, false);
@@ -122,6 +135,15 @@ namespace mongo {
                     GeometryContainer geoContainer;
                     uassert(16760, "malformed geometry: " + geoObj.toString(),
                             geoContainer.parseFrom(geoObj));
+
+                    // A point inside an interior cell is within and intersects the region; skip
+                    // the exact test, which is linear in the region's edges.
+                    const S2Cell* pointCell = geoContainer.getPointCell();
+                    if (NULL != pointCell && _interiors.vector()[i]->Contains(pointCell->id())) {
+                        ++_interiorMatched;
+                        match = true;
+                        continue;
+                    }
                     match = _fields[i].satisfiesPredicate(geoContainer);
                 }
 
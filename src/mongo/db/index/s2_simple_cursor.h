@@ -18,6 +18,7 @@
 
 #include <vector>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/geo/geoquery.h"
 #include "mongo/db/geo/s2common.h"
@@ -27,6 +28,7 @@
 #include "mongo/db/pdfile.h"
 #include "mongo/platform/unordered_set.h"
 #include "third_party/s2/s2cap.h"
+#include "third_party/s2/s2cellunion.h"
 #include "third_party/s2/s2regionintersection.h"
 
 namespace mongo {
@@ -64,6 +66,10 @@ namespace mongo {
         // What geo regions are we looking for?
         vector<GeoQuery> _fields;
 
+        // Cells entirely inside each of _fields, empty for regions without an area.  A point
+        // in one of these satisfies the field's predicate without an exact geometry test.
+        OwnedPointerVector<S2CellUnion> _interiors;
+
         // How were the keys created?  We need this to search for the right stuff.
         S2IndexingParams _params;
 
@@ -83,6 +89,9 @@ namespace mongo {
         // How many did we geo-test?
         long long _geoTested;
 
+        // How many geo tests did an interior cell answer?
+        long long _interiorMatched;
+
         // How many cells were in our cover?
         long long _cellsInCover;
     };
@@ -25,12 +25,27 @@ namespace mongo {
 
     AtomicUInt IndexBuilder::_indexBuildCount = 0;
 
+    mongo::mutex IndexBuilder::_buildsMutex("IndexBuilder");
+    boost::condition IndexBuilder::_buildDone;
+    std::map<std::string, int> IndexBuilder::_buildsByCollection;
+
     IndexBuilder::IndexBuilder(const std::string ns, const BSONObj index) :
         BackgroundJob(true /* self-delete */), _ns(ns), _index(index.getOwned()),
+        _collection(_index["ns"].valuestrsafe()),
         _name(str::stream() << "repl index builder " << (_indexBuildCount++).get()) {
+        // Counted from here rather than from run(), so that a wait right after go() returns
+        // can't miss a build whose thread hasn't started yet.
+        scoped_lock lk(_buildsMutex);
+        _buildsByCollection[_collection]++;
     }
 
-    IndexBuilder::~IndexBuilder() {}
+    IndexBuilder::~IndexBuilder() {
+        scoped_lock lk(_buildsMutex);
+        if (--_buildsByCollection[_collection] == 0) {
+            _buildsByCollection.erase(_collection);
+        }
+        _buildDone.notify_all();
+    }
 
     std::string IndexBuilder::name() const {
         return _name;
@@ -67,6 +82,17 @@ namespace mongo {
         return indexes;
     }
 
+    void IndexBuilder::waitForBuilds(const std::string& ns) {
+        verify(!Lock::isLocked());
+        scoped_lock lk(_buildsMutex);
+        if (_buildsByCollection.count(ns)) {
+            log() << "waiting for index builds on " << ns << " to finish" << endl;
+        }
+        while (_buildsByCollection.count(ns)) {
+            _buildDone.wait(lk.boost());
+        }
+    }
+
     void IndexBuilder::restoreIndexes(const std::string& ns, const std::vector<BSONObj>& indexes) {
         log() << "restarting " << indexes.size() << " index build(s)" << endl;
         for (int i = 0; i < static_cast<int>(indexes.size()); i++) {
@@ -16,10 +16,13 @@
 
 #pragma once
 
+#include <boost/thread/condition.hpp>
+#include <map>
 #include <string>
 
 #include "mongo/db/jsobj.h"
 #include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
 
 /**
  * Forks off a thread to build an index.
@@ -49,11 +52,24 @@ namespace mongo {
          */
         static void restoreIndexes(const std::string& ns, const std::vector<BSONObj>& indexes);
 
+        /**
+         * Blocks until no IndexBuilder is building an index of collection 'ns'.  The caller must
+         * not hold a lock, which the builds need to finish.
+         */
+        static void waitForBuilds(const std::string& ns);
+
     private:
         const std::string _ns;
         const BSONObj _index;
+        // The collection the index is on.
+        const std::string _collection;
         std::string _name;
         static AtomicUInt _indexBuildCount;
+
+        // How many IndexBuilders exist for each collection, for waitForBuilds().
+        static mongo::mutex _buildsMutex;
+        static boost::condition _buildDone;
+        static std::map<std::string, int> _buildsByCollection;
     };
 
 }
@@ -19,6 +19,7 @@
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/user_name.h"
 #include "mongo/db/client.h"
+#include "mongo/db/database.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/util/scopeguard.h"
@@ -57,14 +58,28 @@ namespace mongo {
     }
 
     void IndexRebuilder::checkDB(const std::string& dbName, bool* firstTime) {
-        const std::string systemNS = dbName + ".system.namespaces";
-        DBDirectClient cli;
-        scoped_ptr<DBClientCursor> cursor(cli.query(systemNS, Query()));
-
-        // This depends on system.namespaces not changing while we iterate
-        while (cursor->more()) {
-            BSONObj nsDoc = cursor->nextSafe();
-            const char* ns = nsDoc["name"].valuestrsafe();
+        // Look for interrupted builds under a read lock first: there rarely are any, and a
+        // write lock per collection adds up for databases with many of them.
+        std::list<std::string> toRetry;
+        {
+            Client::ReadContext ctx(dbName);
+            NamespaceIndex& nsIndex = ctx.ctx().db()->namespaceIndex();
+            std::list<std::string> namespaces;
+            nsIndex.getNamespaces(namespaces);
+            for (std::list<std::string>::const_iterator it = namespaces.begin();
+                 it != namespaces.end();
+                 ++it) {
+                NamespaceDetails* nsd = nsIndex.details(*it);
+                if (nsd != NULL && nsd->getIndexBuildsInProgress() > 0) {
+                    toRetry.push_back(*it);
+                }
+            }
+        }
+
+        for (std::list<std::string>::const_iterator it = toRetry.begin();
+             it != toRetry.end();
+             ++it) {
+            const char* ns = it->c_str();
             LOG(1) << "checking ns " << ns << " for interrupted index builds" << endl;
             // This write lock is held throughout the index building process
             // for this namespace.
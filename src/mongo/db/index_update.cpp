@@ -115,6 +115,29 @@ namespace mongo {
         }
     }
 
+    size_t indexRecordBatch(NamespaceDetails *d, const vector<BSONObj>& objs,
+                            const vector<DiskLoc>& locs) {
+        vector<bool> failed(objs.size(), false);
+        int numIndices = d->getTotalIndexCount();
+
+        for (int i = 0; i < numIndices; ++i) {
+            IndexDetails& id = d->idx(i);
+            auto_ptr<IndexDescriptor> desc(CatalogHack::getDescriptor(d, i));
+            auto_ptr<IndexAccessMethod> iam(CatalogHack::getIndex(desc.get()));
+            InsertDeleteOptions options;
+            options.logIfError = false;
+            options.dupsAllowed = (!KeyPattern::isIdKeyPattern(id.keyPattern()) && !id.unique())
+                || ignoreUniqueIndex(id);
+
+            Status ret = iam->insertBulk(objs, locs, options, &failed);
+            if (Status::OK() != ret) {
+                uasserted(ret.location(), ret.reason());
+            }
+        }
+
+        return std::find(failed.begin(), failed.end(), true) - failed.begin();
+    }
+
     //
     // Bulk index building
     //
@@ -40,6 +40,16 @@ namespace mongo {
     // add index keys for a newly inserted record 
     void indexRecord(const char *ns, NamespaceDetails *d, const BSONObj& obj, const DiskLoc &loc);
 
+    /**
+     * Add index keys for a batch of newly inserted records, 'objs[i]' being at 'locs[i]'.  Each
+     * index gets the keys of the whole batch in key order.
+     * @return the position of the first record that couldn't be indexed, or objs.size().  The
+     *     records from there on may be partly indexed.  The caller must delete them, which
+     *     unindexes them.
+     */
+    size_t indexRecordBatch(NamespaceDetails *d, const vector<BSONObj>& objs,
+                            const vector<DiskLoc>& locs);
+
     bool dropIndexes(NamespaceDetails *d, const char *ns, const char *name, string &errmsg,
                      BSONObjBuilder &anObjBuilder, bool maydeleteIdIndex );
 
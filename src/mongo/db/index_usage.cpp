@@ -0,0 +1,74 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/index_usage.h"
+
+#include <ctime>
+
+namespace mongo {
+
+    IndexUsage::IndexUsage() : _lastUsed(0), _since(time(0)) { }
+
+    void IndexUsage::record(long long seeks, long long keysScanned) {
+        if (seeks)
+            _counts.add(kSeeks, seeks);
+        if (keysScanned)
+            _counts.add(kKeysScanned, keysScanned);
+
+        const long long now = time(0);
+        if (_lastUsed.loadRelaxed() != now)
+            _lastUsed.store(now);
+    }
+
+    Date_t IndexUsage::lastUsed() const {
+        return Date_t(_lastUsed.load() * 1000);
+    }
+
+    Date_t IndexUsage::since() const {
+        return Date_t(_since.load() * 1000);
+    }
+
+    void IndexUsage::reset() {
+        _counts.zero();
+        _lastUsed.store(0);
+        _since.store(time(0));
+    }
+
+    void IndexUsage::toBSON(BSONObjBuilder* out) const {
+        out->append("seeks", seeks());
+        out->append("keysScanned", keysScanned());
+        out->appendDate("since", since());
+        const Date_t last = lastUsed();
+        if (last.millis)
+            out->appendDate("lastUsed", last);
+    }
+
+    IndexUsageMap::IndexUsageMap() : _mutex("IndexUsageMap") { }
+
+    shared_ptr<IndexUsage> IndexUsageMap::get(const std::string& indexName) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        shared_ptr<IndexUsage>& usage = _usage[indexName];
+        if (!usage)
+            usage.reset(new IndexUsage());
+        return usage;
+    }
+
+    void IndexUsageMap::drop(const std::string& indexName) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _usage.erase(indexName);
+    }
+
+}  // namespace mongo
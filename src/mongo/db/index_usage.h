@@ -0,0 +1,96 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/striped_counters.h"
+
+namespace mongo {
+
+    /**
+     * How much one index is read: how often cursors positioned themselves in it, how many keys
+     * they moved over, and when it was last read.  For finding the indexes that cost writes and
+     * memory but serve no queries.
+     *
+     * Cursors count in members of their own and record() once, when they are destroyed, so
+     * reading a key costs no more than an increment.  The counts are striped as every query
+     * on a hot index records here.  Thread safe.
+     */
+    class IndexUsage {
+        MONGO_DISALLOW_COPYING(IndexUsage);
+    public:
+        IndexUsage();
+
+        void record(long long seeks, long long keysScanned);
+
+        long long seeks() const { return _counts.get(kSeeks); }
+        long long keysScanned() const { return _counts.get(kKeysScanned); }
+
+        /** @return when record() was last called, to the second, or 0 if it never was. */
+        Date_t lastUsed() const;
+
+        /** @return when counting started, when this was made or at the last reset(). */
+        Date_t since() const;
+
+        /** Starts counting over.  Records going on at the same time may be lost. */
+        void reset();
+
+        /** Appends { seeks, keysScanned, since [, lastUsed ] }. */
+        void toBSON(BSONObjBuilder* out) const;
+
+    private:
+        enum { kSeeks, kKeysScanned, kNumCounts };
+
+        StripedCounters<kNumCounts> _counts;
+
+        // In seconds.  _lastUsed is only stored when it changes, so the cursors of a hot index
+        // mostly just read it.
+        AtomicInt64 _lastUsed;
+        AtomicInt64 _since;
+    };
+
+    /**
+     * The IndexUsage of each index of one collection, by index name.  Thread safe.
+     */
+    class IndexUsageMap {
+        MONGO_DISALLOW_COPYING(IndexUsageMap);
+    public:
+        IndexUsageMap();
+
+        /**
+         * @return the usage of index 'indexName', made if there's none yet.  A cursor holds it
+         *     until it records, so it stays valid if the index is dropped meanwhile.
+         */
+        shared_ptr<IndexUsage> get(const std::string& indexName);
+
+        /** Forgets the usage of a dropped index, so an index made with its name starts at 0. */
+        void drop(const std::string& indexName);
+
+    private:
+        typedef std::map<std::string, shared_ptr<IndexUsage> > UsageMap;
+
+        SimpleMutex _mutex;
+        UsageMap _usage;
+    };
+
+}  // namespace mongo
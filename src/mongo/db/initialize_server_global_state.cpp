@@ -32,6 +32,9 @@
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/security_key.h"
 #include "mongo/db/cmdline.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/logger/async_appender.h"
+#include "mongo/logger/async_log_writer.h"
 #include "mongo/logger/logger.h"
 #include "mongo/logger/message_event.h"
 #include "mongo/logger/message_event_utf8_encoder.h"
@@ -167,6 +170,34 @@ namespace mongo {
         return true;
     }
 
+namespace {
+    // Set up in ServerLogRedirection if --logAsync is given, and never destroyed.
+    logger::AsyncLogWriter* asyncLogWriter = NULL;
+
+    class LogServerStatusSection : public ServerStatusSection {
+    public:
+        LogServerStatusSection() : ServerStatusSection("log") {}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            b.appendBool("async", asyncLogWriter != NULL);
+            if (asyncLogWriter) {
+                b.appendBool("dropWhenFull", cmdLine.logAsyncDropWhenFull);
+                b.appendNumber("bufferSize", static_cast<long long>(
+                                       asyncLogWriter->getCapacity()));
+                b.appendNumber("written", static_cast<long long>(
+                                       asyncLogWriter->getWritten()));
+                b.appendNumber("dropped", static_cast<long long>(
+                                       asyncLogWriter->getDropped()));
+                b.appendNumber("blocked", static_cast<long long>(
+                                       asyncLogWriter->getBlocked()));
+            }
+            return b.obj();
+        }
+    } logServerStatusSection;
+}  // namespace
+
     void forkServerOrDie() {
         if (!forkServer())
             _exit(EXIT_FAILURE);
@@ -177,6 +208,7 @@ namespace mongo {
                               ("default"))(
             InitializerContext*) {
 
+        using logger::AsyncAppender;
         using logger::LogManager;
         using logger::MessageEventEphemeral;
         using logger::MessageEventDetailsEncoder;
@@ -243,14 +275,30 @@ namespace mongo {
 
             LogManager* manager = logger::globalLogManager();
             manager->getGlobalDomain()->clearAppenders();
-            manager->getGlobalDomain()->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
-            manager->getNamedDomain("javascriptOutput")->attachAppender(
-                    MessageLogDomain::AppenderAutoPtr(
-                            new RotatableFileAppender<MessageEventEphemeral>(
-                                    new MessageEventDetailsEncoder, writer.getValue())));
+            if (cmdLine.logAsync) {
+                asyncLogWriter = new logger::AsyncLogWriter(
+                        writer.getValue(),
+                        cmdLine.logAsyncDropWhenFull ? logger::AsyncLogWriter::kDropWhenFull :
+                                                       logger::AsyncLogWriter::kBlockWhenFull);
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncLogWriter)));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new AsyncAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, asyncLogWriter)));
+            }
+            else {
+                manager->getGlobalDomain()->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+                manager->getNamedDomain("javascriptOutput")->attachAppender(
+                        MessageLogDomain::AppenderAutoPtr(
+                                new RotatableFileAppender<MessageEventEphemeral>(
+                                        new MessageEventDetailsEncoder, writer.getValue())));
+            }
 
             if (cmdLine.logAppend && exists) {
                 log() << std::endl;
@@ -258,6 +306,8 @@ namespace mongo {
                 log() << "***** SERVER RESTARTED *****";
                 log() << std::endl;
                 log() << std::endl;
+                if (asyncLogWriter)
+                    asyncLogWriter->flush();
                 Status status =
                     logger::RotatableFileWriter::Use(writer.getValue()).status();
                 if (!status.isOK())
@@ -29,11 +29,14 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/db/admission_control.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/auth/action_type.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/background.h"
+#include "mongo/db/capped_insert_notifier.h"
+#include "mongo/db/client_registry.h"
 #include "mongo/db/cmdline.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
@@ -42,6 +45,7 @@
 #include "mongo/db/dur_commitjob.h"
 #include "mongo/db/dur_journal.h"
 #include "mongo/db/dur_recover.h"
+#include "mongo/db/index_update.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/json.h"
@@ -56,6 +60,8 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/stats/counters.h"
+#include "mongo/db/stats/op_latencies.h"
+#include "mongo/logger/async_log_writer.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h" // for SendStaleConfigException
@@ -159,22 +165,26 @@ namespace mongo {
                     filter = b.obj();
                 }
 
-                Client& me = cc();
-                scoped_lock bl(Client::clientsMutex);
+                // goes through the client registry rather than Client::clients, so that
+                // looking doesn't hold up clients connecting, disconnecting or being killed
                 scoped_ptr<Matcher> m(new Matcher(filter));
-                for( set<Client*>::iterator i = Client::clients.begin(); i != Client::clients.end(); i++ ) {
-                    Client *c = *i;
-                    verify( c );
-                    CurOp* co = c->curop();
-                    if ( c == &me && !co ) {
+                OpStatus status;
+                const size_t numSlots = ClientRegistry::numSlots();
+                for ( size_t i = 0; i < numSlots; i++ ) {
+                    ClientSlot* slot = ClientRegistry::slotAt( i );
+                    unsigned generation;
+                    if ( !slot->read( &status, &generation ) )
                         continue;
-                    }
-                    verify( co );
-                    if( all || co->displayInCurop() ) {
-                        BSONObj info = co->info();
-                        if ( all || m->matches( info )) {
-                            vals.push_back( info );
-                        }
+                    if ( !all && ( !status.active || status.suppressFromCurop ) )
+                        continue;
+
+                    BSONObj info = CurOp::info( status, &slot->lockState(),
+                                                slot->killPending( status.opNum ) );
+                    // the lock state may have been another client's by the time we read it
+                    if ( !slot->sameHolder( generation ) )
+                        continue;
+                    if ( all || m->matches( info ) ) {
+                        vals.push_back( info );
                     }
                 }
             }
@@ -424,6 +434,8 @@ namespace mongo {
         long long logThreshold = cmdLine.slowMS;
         bool shouldLog = logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1));
 
+        AdmissionTicket admission( ns, op, isCommand, nestedOp.get() != NULL );
+
         if ( op == dbQuery ) {
             if ( handlePossibleShardedMessage( m , &dbresponse ) )
                 return;
@@ -497,15 +509,25 @@ namespace mongo {
         currentOp.done();
         debug.executionTime = currentOp.totalTimeMillis();
 
+        {
+            const long long lockWaitMicros = currentOp.lockStat().getTotalTimeAcquiring();
+            admission.done( lockWaitMicros );
+            recordOpLatency( op, isCommand, lockWaitMicros,
+                             static_cast<long long>( currentOp.totalTimeMicros() ) - lockWaitMicros );
+        }
+
         logThreshold += currentOp.getExpectedLatencyMs();
 
         if ( shouldLog || debug.executionTime > logThreshold ) {
             MONGO_TLOG(0) << debug.report( currentOp ) << endl;
         }
 
-        if ( currentOp.shouldDBProfile( debug.executionTime ) ) {
+        if ( currentOp.shouldDBProfile( debug.executionTime ) && sampleForProfile() ) {
             // performance profiling is on
-            if ( Lock::isReadLocked() ) {
+            if ( profilingToRingBuffer() ) {
+                profileToRingBuffer( c, currentOp );
+            }
+            else if ( Lock::isReadLocked() ) {
                 LOG(1) << "note: not profiling because recursive read lock" << endl;
             }
             else if ( lockedForWriting() ) {
@@ -603,7 +625,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                Lock::CollectionWrite lk(ns);
                 
                 // void ReplSetImpl::relinquish() uses big write lock so 
                 // this is thus synchronized given our lock above.
@@ -646,7 +668,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( 1 ) {
             try {
-                Lock::DBWrite lk(ns);
+                Lock::CollectionWrite lk(ns);
                 
                 // writelock is used to synchronize stepdowns w/ writes
                 uassert( 10056 ,  "not master", isMasterNs( ns ) );
@@ -688,8 +710,10 @@ namespace mongo {
         scoped_ptr<Timer> timer;
         int pass = 0;
         bool exhaust = false;
+        bool canPrepareNext = false;
         QueryResult* msgdata = 0;
         OpTime last;
+        unsigned long long insertVersion = 0;
         while( 1 ) {
             bool isCursorAuthorized = false;
             try {
@@ -705,13 +729,19 @@ namespace mongo {
                         sleepmillis(0);
                     }
 
-                    if (pass == 0) {
-                        mutex::scoped_lock lk(OpTime::m);
-                        last = OpTime::getLast(lk);
-                    }
-                    else {
+                    if (pass > 0) {
                         last.waitForDifferent(1000/*ms*/);
                     }
+                    mutex::scoped_lock lk(OpTime::m);
+                    last = OpTime::getLast(lk);
+                }
+                else {
+                    // awaitData on any other capped collection: sleep until it gets an insert.
+                    // The version is read before looking for data so no insert is missed.
+                    if (pass > 0) {
+                        CappedInsertNotifier::waitForInsert(ns, insertVersion, 1000/*ms*/);
+                    }
+                    insertVersion = CappedInsertNotifier::getVersion(ns);
                 }
 
                 msgdata = processGetMore(ns,
@@ -720,7 +750,8 @@ namespace mongo {
                                          curop,
                                          pass,
                                          exhaust,
-                                         &isCursorAuthorized);
+                                         &isCursorAuthorized,
+                                         &canPrepareNext);
             }
             catch ( AssertionException& e ) {
                 if ( isCursorAuthorized ) {
@@ -751,12 +782,8 @@ namespace mongo {
                     }
                 }
                 pass++;
-                if (debug)
-                    sleepmillis(20);
-                else
-                    sleepmillis(2);
                 
-                // note: the 1100 is beacuse of the waitForDifferent above
+                // note: the 1100 is beacuse of the waits above
                 // should eventually clean this up a bit
                 curop.setExpectedLatencyMs( 1100 + timer->millis() );
                 
@@ -790,27 +817,40 @@ namespace mongo {
             curop.debug().exhaust = true;
             dbresponse.exhaustNS = ns;
         }
+        else if ( canPrepareNext && msgdata->cursorId ) {
+            dbresponse.prepareNextNS = ns;
+            dbresponse.prepareNextCursorId = cursorid;
+            dbresponse.prepareNextNToReturn = ntoreturn;
+        }
 
         return ok;
     }
 
-    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) { 
-        uassert( 10059 , "object to insert too large", js.objsize() <= BSONObjMaxUserSize);
-        {
-            BSONObjIterator i( js );
-            while ( i.more() ) {
-                BSONElement e = i.next();
+    static Status checkInsertable(const BSONObj& js) {
+        if ( js.objsize() > BSONObjMaxUserSize )
+            return Status( ErrorCodes::BadValue, "object to insert too large", 10059 );
 
-                // check no $ modifiers.  note we only check top level.  
-                // (scanning deep would be quite expensive)
-                uassert( 13511, "document to insert can't have $ fields", e.fieldName()[0] != '$' );
-                
-                // check no regexp for _id (SERVER-9502)
-                if (str::equals(e.fieldName(), "_id")) {
-                    uassert(16824, "can't use a regex for _id", e.type() != RegEx);
-                }
-            }
+        BSONObjIterator i( js );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+
+            // check no $ modifiers.  note we only check top level.  
+            // (scanning deep would be quite expensive)
+            if ( e.fieldName()[0] == '$' )
+                return Status( ErrorCodes::BadValue, "document to insert can't have $ fields",
+                               13511 );
+
+            // check no regexp for _id (SERVER-9502)
+            if ( str::equals( e.fieldName(), "_id" ) && e.type() == RegEx )
+                return Status( ErrorCodes::BadValue, "can't use a regex for _id", 16824 );
         }
+        return Status::OK();
+    }
+
+    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) { 
+        Status status = checkInsertable( js );
+        if ( !status.isOK() )
+            uasserted( status.location(), status.reason() );
 
         theDataFileMgr.insertWithObjMod(ns,
                                         // May be modified in the call to add an _id field.
@@ -824,9 +864,67 @@ namespace mongo {
         logOp("i", ns, js);
     }
 
+    size_t checkAndInsertBatch(const char *ns, /*modifies*/vector<BSONObj>& objs) {
+        NamespaceDetails *d = nsdetails( ns );
+        if ( objs.size() < 2 ||
+             !d ||
+             d->isCapped() ||
+             d->getTotalIndexCount() == 0 ||
+             d->getTotalIndexCount() != d->getCompletedIndexCount() ||
+             strstr( ns, ".system." ) ||
+             !NamespaceString::normal( ns ) ) {
+            return 0;
+        }
+
+        // Put the records in without touching the indexes, stopping short of any document
+        // checkAndInsert() would reject so that it reports the error.
+        vector<BSONObj> inserted;
+        vector<DiskLoc> locs;
+        for ( size_t i = 0; i < objs.size(); ++i ) {
+            if ( !checkInsertable( objs[i] ).isOK() )
+                break;
+
+            DiskLoc loc;
+            try {
+                loc = theDataFileMgr.insertWithObjMod( ns, objs[i], false, false, false );
+            }
+            catch ( const DBException& ) {
+                break;
+            }
+            if ( loc.isNull() )
+                break;
+
+            inserted.push_back( objs[i] );
+            locs.push_back( loc );
+        }
+
+        if ( inserted.empty() )
+            return 0;
+
+        size_t numIndexed = indexRecordBatch( d, inserted, locs );
+
+        // Back out the records from the first one that hit an index error.  The caller inserts
+        // them again one at a time, so the failing one reports its error and the rest are
+        // handled as keepGoing says.
+        for ( size_t i = locs.size(); i > numIndexed; --i ) {
+            // May point into the record if an _id was added.
+            objs[i - 1] = objs[i - 1].getOwned();
+            theDataFileMgr.deleteRecord( d, ns, locs[i - 1].rec(), locs[i - 1], false, true );
+        }
+
+        vector<LogOpBatchEntry> entries( numIndexed );
+        for ( size_t i = 0; i < numIndexed; ++i ) {
+            entries[i].obj = objs[i];
+        }
+        logOpBatch( "i", ns, entries );
+
+        return numIndexed;
+    }
+
     NOINLINE_DECL void insertMulti(bool keepGoing, const char *ns, vector<BSONObj>& objs, CurOp& op) {
-        size_t i;
-        for (i=0; i<objs.size(); i++){
+        size_t i = checkAndInsertBatch(ns, objs);
+        getDur().commitIfNeeded();
+        for (; i<objs.size(); i++){
             try {
                 checkAndInsert(ns, objs[i]);
                 getDur().commitIfNeeded();
@@ -868,7 +966,7 @@ namespace mongo {
         PageFaultRetryableSection s;
         while ( true ) {
             try {
-                Lock::DBWrite lk(ns);
+                Lock::CollectionWrite lk(ns);
                 
                 // CONCURRENCY TODO: is being read locked in big log sufficient here?
                 // writelock is used to synchronize stepdowns w/ writes
@@ -1156,6 +1254,7 @@ namespace mongo {
             return;
         }
 #endif
+        logger::AsyncLogWriter::flushAll();
         tryToOutputFatal( "dbexit: really exiting now" );
         if ( c ) c->shutdown();
         ::_exit(rc);
@@ -126,4 +126,14 @@ namespace mongo {
 
     void checkAndInsert(const char *ns, BSONObj& js);
 
+    /**
+     * Inserts documents from the front of 'objs' as one batch, adding each index's keys for the
+     * whole batch in key order rather than a document at a time.  Stops at the first document
+     * checkAndInsert() would fail on.  Documents that get an _id added are updated in place.
+     * @return the number of documents inserted, all logged.  0 if the collection doesn't take
+     *     batches (capped, system, no indexes, a background index build) or the first document
+     *     fails.  Carry on from there with checkAndInsert().
+     */
+    size_t checkAndInsertBatch(const char *ns, vector<BSONObj>& objs);
+
 } // namespace mongo
@@ -0,0 +1,38 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/interrupt_token.h"
+
+#include "mongo/db/kill_current_op.h"
+
+namespace mongo {
+
+    InterruptToken::InterruptToken( bool heedMutex )
+        : _op( cc().curop() ),
+          _heedMutex( heedMutex ),
+          _checksLeft( kChecksPerFullCheck ) {
+    }
+
+    void InterruptToken::rebind() {
+        _op = cc().curop();
+    }
+
+    void InterruptToken::fullCheck() {
+        _checksLeft = kChecksPerFullCheck;
+        killCurrentOp.checkForInterrupt( _heedMutex );
+    }
+
+}  // namespace mongo
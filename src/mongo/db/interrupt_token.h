@@ -0,0 +1,61 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/db/curop.h"
+
+namespace mongo {
+
+    /**
+     * Checks for a kill, a shutdown or a passed maxTimeMS from a tight loop, like that of a
+     * plan's work() calls, for much less than killCurrentOp.checkForInterrupt() costs.
+     *
+     * It holds on to the op current when it was made, so most checks are just a relaxed load of
+     * that op's kill flag.  Every kChecksPerFullCheck checks, and right away once a kill is
+     * pending, it does the full check, which also reads the clock for the time limit and
+     * publishes progress to currentOp.
+     *
+     * A token is only used on its op's thread.  Whatever keeps one across ops, as a cursor does
+     * across getMores, must rebind() it at the start of each.
+     */
+    class InterruptToken {
+    public:
+        static const unsigned kChecksPerFullCheck = 128;
+
+        /**
+         * @param heedMutex as for killCurrentOp.checkForInterrupt()
+         */
+        explicit InterruptToken( bool heedMutex = true );
+
+        /** Moves to the op now current on this thread. */
+        void rebind();
+
+        /** Throws if the op was killed or ran out of time. */
+        void check() {
+            if ( _op->killPending() || --_checksLeft == 0 )
+                fullCheck();
+        }
+
+    private:
+        void fullCheck();
+
+        CurOp* _op; // not owned
+        const bool _heedMutex;
+        unsigned _checksLeft;
+    };
+
+}  // namespace mongo
@@ -23,6 +23,13 @@
 
 namespace mongo {
 
+    // countKeys() counts subtrees of up to this height wholesale.  With hundreds of keys per
+    // bucket a height 2 subtree has at most a few hundred thousand keys.
+    static const int kMaxCountedSubtreeHeight = 2;
+
+    // On moving into a leaf bucket, iteration reads ahead this many of the buckets after it.
+    static const int kPrefetchSiblings = 2;
+
     unordered_set<IntervalBtreeCursor*> IntervalBtreeCursor::_activeCursors;
     SimpleMutex IntervalBtreeCursor::_activeCursorsMutex("active_interval_btree_cursors");
 
@@ -43,6 +50,21 @@ namespace mongo {
         }
     }
 
+    /**
+     * If 'loc' has moved on from bucket 'previous' into a leaf, asks for the buckets following
+     * that leaf to be read ahead.  A long scan of a cold index otherwise faults them in one
+     * at a time.
+     */
+    static void prefetchAhead( const DiskLoc& previous, const BtreeKeyLocation& loc ) {
+        if ( loc.bucket.isNull() || loc.bucket == previous ) {
+            return;
+        }
+        const BtreeBucket<V1>* bucket = loc.bucket.btree<V1>();
+        if ( bucket->height() == 1 ) {
+            bucket->prefetchNextSiblings( loc.bucket, kPrefetchSiblings );
+        }
+    }
+
     IntervalBtreeCursor* IntervalBtreeCursor::make( NamespaceDetails* namespaceDetails,
                                                     const IndexDetails& indexDetails,
                                                     const BSONObj& lowerBound,
@@ -129,11 +151,13 @@ namespace mongo {
             return false;
         }
         // Advance _curr to the next key in the btree.
+        const DiskLoc previous = _curr.bucket;
         _curr.bucket = _curr.bucket.btree<V1>()->advance( _curr.bucket,
                                                           _curr.pos,
                                                           1,
                                                           __FUNCTION__ );
         skipUnused( &_curr );
+        prefetchAhead( previous, _curr );
         if ( _curr == _end ) {
             // _curr has reached _end, so iteration is complete.
             _curr.bucket.Null();
@@ -144,6 +168,54 @@ namespace mongo {
         return ok();
     }
 
+    long long IntervalBtreeCursor::countKeys( long long maxKeys ) {
+        long long count = 0;
+        while ( ok() && count < maxKeys ) {
+            RARELY killCurrentOp.checkForInterrupt();
+            const BtreeBucket<V1>* bucket = _curr.bucket.btree<V1>();
+            const DiskLoc previous = _curr.bucket;
+
+            // _curr is a used key before _end.
+            ++count;
+
+            // The keys right after _curr are all before _end unless _end is among them.
+            DiskLoc right = bucket->rightChild( _curr.pos );
+            const int restOfBucket = ( right.isNull() && _curr.bucket != _end.bucket ) ?
+                    bucket->countUsedKeysToEnd( _curr.pos + 1 ) : -1;
+            if ( restOfBucket >= 0 ) {
+                // The rest of the bucket's keys follow _curr directly, count them in one pass.
+                count += restOfBucket;
+                _curr.pos = bucket->getN() - 1;
+                _curr.bucket = bucket->advance( _curr.bucket, _curr.pos, 1, __FUNCTION__ );
+            }
+            else if ( !right.isNull() &&
+                 !onPathToEnd( right ) &&
+                 right.btree<V1>()->height() <= kMaxCountedSubtreeHeight ) {
+                count += right.btree<V1>()->countUsedKeys();
+                _curr.bucket = bucket->advancePastRightChild( _curr.bucket, _curr.pos );
+            }
+            else {
+                _curr.bucket = bucket->advance( _curr.bucket, _curr.pos, 1, __FUNCTION__ );
+            }
+
+            skipUnused( &_curr );
+            prefetchAhead( previous, _curr );
+            if ( _curr == _end ) {
+                _curr.bucket.Null();
+            }
+        }
+
+        // The key we started at was already scanned, and the one we stopped at now is.
+        if ( count > 0 ) {
+            _nscanned += ok() ? count : count - 1;
+        }
+        return count;
+    }
+
+    bool IntervalBtreeCursor::onPathToEnd( const DiskLoc& bucket ) const {
+        return std::find( _endPath.begin(), _endPath.end(), bucket ) != _endPath.end();
+    }
+
     BSONObj IntervalBtreeCursor::currKey() const {
         if ( _curr.bucket.isNull() ) {
             return BSONObj();
@@ -215,6 +287,11 @@ namespace mongo {
         // Otherwise, relocate _end.
         _end = locateKey( _upperBound, _upperBoundInclusive );
         skipUnused( &_end );
+
+        _endPath.clear();
+        for ( DiskLoc b = _end.bucket; !b.isNull(); b = b.btree<V1>()->getParent() ) {
+            _endPath.push_back( b );
+        }
     }
 
 } // namespace mongo
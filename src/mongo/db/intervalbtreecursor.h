@@ -103,6 +103,18 @@ namespace mongo {
 
         virtual ~IntervalBtreeCursor();
 
+        /**
+         * Counts keys from the current position toward the end of the interval, stopping soon
+         * after 'maxKeys' have been counted, and leaves the cursor at the first key not yet
+         * counted.  A subtree that lies wholly within the interval is counted from its buckets
+         * rather than by stepping through its keys.  Only subtrees of modest height are counted
+         * that way, so each call does a bounded amount of work between yields.
+         *
+         * Keys are not deduped, so the result is only a document count if !isMultiKey().
+         * @return the number of keys counted.
+         */
+        long long countKeys( long long maxKeys );
+
     private:
         IntervalBtreeCursor( NamespaceDetails* namespaceDetails,
                              const IndexDetails& indexDetails,
@@ -128,6 +140,9 @@ namespace mongo {
         /** Find the iteration end location and set _end to it. */
         void relocateEnd();
 
+        /** @return true if 'bucket' is _end's bucket or one of its ancestors. */
+        bool onPathToEnd( const DiskLoc& bucket ) const;
+
         const NamespaceDetails& _namespaceDetails;
         const int32_t _indexNo;
         const IndexDetails& _indexDetails;
@@ -141,6 +156,7 @@ namespace mongo {
         LogicalBtreePosition _currRecoverable; // Helper to track the position of _curr if the
                                                // btree is modified during a mutex yield.
         BtreeKeyLocation _end; // Exclusive end location in the btree.
+        vector<DiskLoc> _endPath; // _end's bucket and its ancestors, for countKeys().
         int64_t _nscanned;
 
         shared_ptr<CoveredIndexMatcher> _matcher;
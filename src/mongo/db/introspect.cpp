@@ -18,15 +18,21 @@
 
 #include "mongo/pch.h"
 
+#include <deque>
+
+#include "mongo/base/counter.h"
 #include "mongo/bson/util/builder.h"
 #include "mongo/db/auth/authorization_manager.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/principal_set.h"
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/database_holder.h"
 #include "mongo/db/introspect.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/goodies.h"
 
 namespace {
@@ -65,11 +71,81 @@ namespace {
     }
 } // namespace
 
-    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
-        Database *db = c.database();
-        DEV verify( db );
-        const char *ns = db->getProfilingNS();
+    // Profile one in every profileSampleEvery ops that qualify.  1 profiles all of them.
+    MONGO_EXPORT_SERVER_PARAMETER(profileSampleEvery, int, 1);
+
+    // When above 0, profiled ops are kept in an in memory ring buffer of this many MB instead
+    // of being inserted into system.profile, so profiling takes no database lock.
+    MONGO_EXPORT_SERVER_PARAMETER(profileRingBufferMB, int, 0);
+
+namespace {
+
+    /**
+     * Profile documents waiting to be read by the profileBuffer command, oldest first.
+     * When full, the oldest documents are dropped to make room.
+     */
+    class ProfileRingBuffer {
+    public:
+        ProfileRingBuffer() : _mutex("ProfileRingBuffer"), _bytes(0) { }
+
+        void push(const StringData& dbName, const BSONObj& doc, size_t maxBytes) {
+            Entry entry(dbName.toString(), doc.getOwned());
+            SimpleMutex::scoped_lock lk(_mutex);
+            _entries.push_back(entry);
+            _bytes += doc.objsize();
+            while (_bytes > maxBytes && !_entries.empty()) {
+                _bytes -= _entries.front().second.objsize();
+                _entries.pop_front();
+                droppedCounter.increment();
+            }
+        }
+
+        bool read(const StringData& dbName, bool remove, BSONArrayBuilder* out) {
+            SimpleMutex::scoped_lock lk(_mutex);
+            std::deque<Entry>::iterator it = _entries.begin();
+            while (it != _entries.end()) {
+                if (dbName != it->first) {
+                    ++it;
+                    continue;
+                }
+                if (out->len() + it->second.objsize() > maxReplyBytes) {
+                    return true;
+                }
+                out->append(it->second);
+                if (remove) {
+                    _bytes -= it->second.objsize();
+                    it = _entries.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+            return false;
+        }
+
+        static Counter64 droppedCounter;
+
+    private:
+        typedef std::pair<std::string, BSONObj> Entry;
+
+        // Leaves room in a reply for the rest of the command response.
+        static const int maxReplyBytes = BSONObjMaxUserSize / 2;
+
+        SimpleMutex _mutex;
+        std::deque<Entry> _entries;
+        size_t _bytes;
+    } profileRingBuffer;
+
+    Counter64 ProfileRingBuffer::droppedCounter;
+    ServerStatusMetricField<Counter64> displayProfileDropped("profile.ringBufferDropped",
+                                                             &ProfileRingBuffer::droppedCounter);
+
+    AtomicUInt64 profileSampleCount;
 
+} // namespace
+
+    static BSONObj _buildProfileDoc(const Client& c, CurOp& currentOp,
+                                    BufBuilder& profileBufBuilder) {
         // build object
         BSONObjBuilder b(profileBufBuilder);
 
@@ -105,6 +181,16 @@ namespace {
             p = b.done();
         }
 
+        return p;
+    }
+
+    static void _profile(const Client& c, CurOp& currentOp, BufBuilder& profileBufBuilder) {
+        Database *db = c.database();
+        DEV verify( db );
+        const char *ns = db->getProfilingNS();
+
+        BSONObj p = _buildProfileDoc(c, currentOp, profileBufBuilder);
+
         // write: not replicated
         // get or create the profiling collection
         NamespaceDetails *details = getOrCreateProfileCollection(db);
@@ -138,6 +224,29 @@ namespace {
         }
     }
 
+    bool sampleForProfile() {
+        const int every = profileSampleEvery;
+        if (every <= 1) {
+            return true;
+        }
+        return 0 == profileSampleCount.fetchAndAdd(1) % every;
+    }
+
+    bool profilingToRingBuffer() {
+        return profileRingBufferMB > 0;
+    }
+
+    void profileToRingBuffer(const Client& c, CurOp& currentOp) {
+        BufBuilder profileBufBuilder(1024);
+        BSONObj p = _buildProfileDoc(c, currentOp, profileBufBuilder);
+        profileRingBuffer.push(nsToDatabaseSubstring(currentOp.getNS()), p,
+                               static_cast<size_t>(profileRingBufferMB) * 1024 * 1024);
+    }
+
+    bool readProfileRingBuffer(const StringData& dbName, bool remove, BSONArrayBuilder* out) {
+        return profileRingBuffer.read(dbName, remove, out);
+    }
+
     NamespaceDetails* getOrCreateProfileCollection(Database *db, bool force, string* errmsg ) {
         fassert(16372, db);
         const char* profileName = db->getProfilingNS();
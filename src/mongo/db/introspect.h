@@ -31,6 +31,23 @@ namespace mongo {
 
     void profile(const Client& c, int op, CurOp& currentOp);
 
+    /** false for ops skipped by the profileSampleEvery setting */
+    bool sampleForProfile();
+
+    /** true when profiled ops go to the in memory ring buffer rather than system.profile */
+    bool profilingToRingBuffer();
+
+    /** adds the profile document for currentOp to the ring buffer; takes no database lock */
+    void profileToRingBuffer(const Client& c, CurOp& currentOp);
+
+    /**
+     * Appends the buffered profile documents for dbName to out, oldest first, removing them
+     * from the buffer if remove is set.
+     *
+     * @return  true if documents were left out because the reply would have been too large
+     */
+    bool readProfileRingBuffer(const StringData& dbName, bool remove, BSONArrayBuilder* out);
+
     /**
      * Get (or create) the profile collection
      *
@@ -63,10 +63,16 @@ namespace mongo {
     MaxKeyLabeler MAXKEY;
 
     // need to move to bson/, but has dependency on base64 so move that to bson/util/ first.
-    inline string BSONElement::jsonString( JsonStringFormat format, bool includeFieldNames, int pretty ) const {
+    string BSONElement::jsonString( JsonStringFormat format, bool includeFieldNames, int pretty ) const {
+        stringstream s;
+        jsonStringStream( format, includeFieldNames, pretty, s );
+        return s.str();
+    }
+
+    void BSONElement::jsonStringStream( JsonStringFormat format, bool includeFieldNames,
+                                        int pretty, std::ostream& s ) const {
         int sign;
 
-        stringstream s;
         if ( includeFieldNames )
             s << '"' << escape( fieldName() ) << "\" : ";
         switch ( type() ) {
@@ -81,8 +87,9 @@ namespace mongo {
         case NumberDouble:
             if ( number() >= -numeric_limits< double >::max() &&
                     number() <= numeric_limits< double >::max() ) {
-                s.precision( 16 );
+                const std::streamsize precision = s.precision( 16 );
                 s << number();
+                s.precision( precision );
             }
             else if ( mongo::isNaN(number()) ) {
                 s << "NaN";
@@ -112,7 +119,7 @@ namespace mongo {
             }
             break;
         case Object:
-            s << embeddedObject().jsonString( format, pretty );
+            embeddedObject().jsonStringStream( format, pretty, s );
             break;
         case mongo::Array: {
             if ( embeddedObject().isEmpty() ) {
@@ -135,7 +142,7 @@ namespace mongo {
                         s << "undefined";
                     }
                     else {
-                        s << e.jsonString( format, false, pretty?pretty+1:0 );
+                        e.jsonStringStream( format, false, pretty?pretty+1:0, s );
                         e = i.next();
                     }
                     count++;
@@ -187,8 +194,9 @@ namespace mongo {
             base64::encode( s , start , len );
             s << "\", \"$type\" : \"" << hex;
             s.width( 2 );
-            s.fill( '0' );
+            const char fill = s.fill( '0' );
             s << type << dec;
+            s.fill( fill );
             s << "\" }";
             break;
         }
@@ -235,7 +243,9 @@ namespace mongo {
             BSONObj scope = codeWScopeObject();
             if ( ! scope.isEmpty() ) {
                 s << "{ \"$code\" : " << _asCode() << " , "
-                  << " \"$scope\" : " << scope.jsonString() << " }";
+                  << " \"$scope\" : ";
+                scope.jsonStringStream( Strict, 0, s );
+                s << " }";
                 break;
             }
         }
@@ -268,7 +278,6 @@ namespace mongo {
             string message = ss.str();
             massert( 10312 ,  message.c_str(), false );
         }
-        return s.str();
     }
 
     int BSONElement::getGtLtOp( int def ) const {
@@ -442,13 +451,24 @@ namespace mongo {
 
         if ( isEmpty() ) return "{}";
 
-        StringBuilder s;
+        stringstream s;
+        jsonStringStream( format, pretty, s );
+        return s.str();
+    }
+
+    void BSONObj::jsonStringStream( JsonStringFormat format, int pretty, std::ostream& s ) const {
+
+        if ( isEmpty() ) {
+            s << "{}";
+            return;
+        }
+
         s << "{ ";
         BSONObjIterator i(*this);
         BSONElement e = i.next();
         if ( !e.eoo() )
             while ( 1 ) {
-                s << e.jsonString( format, true, pretty?pretty+1:0 );
+                e.jsonStringStream( format, true, pretty?pretty+1:0, s );
                 e = i.next();
                 if ( e.eoo() )
                     break;
@@ -463,7 +483,6 @@ namespace mongo {
                 }
             }
         s << " }";
-        return s.str();
     }
 
     bool BSONObj::valid() const {
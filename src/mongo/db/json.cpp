@@ -41,7 +41,7 @@ namespace mongo {
         ID_RESERVE_SIZE = 64,
         PAT_RESERVE_SIZE = 4096,
         OPT_RESERVE_SIZE = 64,
-        FIELD_RESERVE_SIZE = 4096,
+        FIELD_RESERVE_SIZE = 64,
         STRINGVAL_RESERVE_SIZE = 4096,
         BINDATA_RESERVE_SIZE = 4096,
         BINDATATYPE_RESERVE_SIZE = 4096,
@@ -122,6 +122,11 @@ namespace mongo {
             }
         }
         else if (accept(DOUBLEQUOTE, false) || accept(SINGLEQUOTE, false)) {
+            StringData unescaped;
+            if (unescapedQuotedString(&unescaped)) {
+                builder.append(fieldName, unescaped);
+                return Status::OK();
+            }
             std::string valueString;
             valueString.reserve(STRINGVAL_RESERVE_SIZE);
             Status ret = quotedString(&valueString);
@@ -264,9 +269,11 @@ namespace mongo {
             if (valueRet != Status::OK()) {
                 return valueRet;
             }
+            // one buffer for the rest of the field names
+            std::string fieldName;
+            fieldName.reserve(FIELD_RESERVE_SIZE);
             while (accept(COMMA)) {
-                std::string fieldName;
-                fieldName.reserve(FIELD_RESERVE_SIZE);
+                fieldName.clear();
                 Status fieldRet = field(&fieldName);
                 if (fieldRet != Status::OK()) {
                     return fieldRet;
@@ -715,6 +722,34 @@ namespace mongo {
     }
 
     Status JParse::number(const StringData& fieldName, BSONObjBuilder& builder) {
+        // Most numbers are plain integers short enough not to overflow; convert those here
+        // rather than running both strtod and strtoll over them.
+        const char* p = _input;
+        while (p < _input_end && isspace(*p)) {
+            ++p;
+        }
+        const bool negative = (p < _input_end && *p == '-');
+        if (negative) {
+            ++p;
+        }
+        const char* digits = p;
+        long long magnitude = 0;
+        while (p < _input_end && p - digits < 19 && isdigit(*p)) {
+            magnitude = magnitude * 10 + (*p++ - '0');
+        }
+        if (p > digits && p - digits < 19 && p < _input_end && !isdigit(*p) &&
+                !match(*p, ".eExXpP")) {
+            const long long value = negative ? -magnitude : magnitude;
+            if (value == static_cast<int>(value)) {
+                builder.append(fieldName, static_cast<int>(value));
+            }
+            else {
+                builder.append(fieldName, value);
+            }
+            _input = p;
+            return Status::OK();
+        }
+
         char* endptrll;
         char* endptrd;
         long long retll;
@@ -802,6 +837,30 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool JParse::unescapedQuotedString(StringData* result) {
+        const char* q = _input;
+        while (q < _input_end && isspace(*q)) {
+            ++q;
+        }
+        if (q >= _input_end || (*q != '"' && *q != '\'')) {
+            return false;
+        }
+        const char quote = *q++;
+        const char* start = q;
+        while (q < _input_end && *q != quote) {
+            if (*q == '\\' || static_cast<unsigned char>(*q) <= 0x1F) {
+                return false;
+            }
+            ++q;
+        }
+        if (q >= _input_end) {
+            return false;
+        }
+        *result = StringData(start, q - start);
+        _input = q + 1;
+        return true;
+    }
+
     /*
      * terminalSet are characters that signal end of string (e.g.) [ :\0]
      * allowedSet are the characters that are allowed, if this is set
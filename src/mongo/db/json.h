@@ -251,7 +251,8 @@ namespace mongo {
              * NOTE: Number parsing is based on standard library functions, not
              * necessarily on the JSON numeric grammar.
              *
-             * Number as value - strtoll and strtod
+             * Number as value - strtoll and strtod, except that a plain
+             * integer of up to 18 digits is converted directly
              * Date - strtoll
              * Timestamp - strtoul for both timestamp and increment and '-'
              * before a number explicity disallowed
@@ -278,6 +279,14 @@ namespace mongo {
              */
             Status quotedString(std::string* result);
 
+            /*
+             * Accepts a STRING with no escapes or control characters in it,
+             * setting 'result' to point at its characters in the input rather
+             * than copying them.  Leaves the input where it was and returns
+             * false for any other STRING, which quotedString() then handles.
+             */
+            bool unescapedQuotedString(StringData* result);
+
             /*
              * CHARS :
              *     CHAR
@@ -522,14 +522,20 @@ namespace mongo {
     }
 
     int KeyV1::woCompare(const KeyV1& right, const Ordering &order) const {
+        if( (*_keyData|*right._keyData) == IsBSON ) // only can do this if cNOTUSED maintained
+            return compareHybrid(right, order);
+
+        int field;
+        return compactCompare(right, order, &field);
+    }
+
+    int KeyV1::compactCompare(const KeyV1& right, const Ordering &order, int* field) const {
         const unsigned char *l = _keyData;
         const unsigned char *r = right._keyData;
-
-        if( (*l|*r) == IsBSON ) // only can do this if cNOTUSED maintained
-            return compareHybrid(right, order);
+        dassert( isCompactFormat() && right.isCompactFormat() );
 
         unsigned mask = 1;
-        while( 1 ) { 
+        for( *field = 0; ; ++*field ) {
             char lval = *l; 
             char rval = *r;
             {
@@ -552,6 +558,7 @@ namespace mongo {
             mask <<= 1;
         }
 
+        ++*field;
         return 0;
     }
 
@@ -604,6 +611,56 @@ namespace mongo {
         return p - _keyData;
     }
 
+    KeyV2::KeyV2(const char *prefix, int prefixLen, const char *suffix) : _ownedLen(0) {
+        dassert( prefixLen > 0 && prefixLen <= MaxOwned );
+        unsigned char *out = (unsigned char *) _owned;
+        memcpy(out, prefix, prefixLen);
+
+        // the suffix carries no length of its own, so walk the elements of the reassembled key
+        // and pull in suffix bytes as each element needs them.  the suffix may end at the end of
+        // a bucket, so we must not look beyond the last of its elements.
+        const unsigned char *s = (const unsigned char *) suffix;
+        int have = prefixLen;
+        int pos = 0;
+        bool more;
+        do {
+            if( pos == have )
+                out[have++] = *s++;
+            unsigned type = out[pos] & cCANONTYPEMASK;
+            if( sizes[type] == 0 && pos + 1 == have )
+                out[have++] = *s++; // string or bindata length byte
+            int end = pos + sizeOfElement(out + pos);
+            verify( end <= MaxOwned );
+            if( end > have ) {
+                memcpy(out + have, s, end - have);
+                s += end - have;
+                have = end;
+            }
+            more = (out[pos] & cHASMORE) != 0;
+            pos = end;
+        } while( more );
+
+        dassert( pos == have );
+        _ownedLen = have;
+        _keyData = out;
+    }
+
+    KeyV2::KeyV2(const KeyV2& rhs) : KeyV1(), _ownedLen(0) {
+        assign(rhs);
+    }
+
+    void KeyV2::assign(const KeyV2& rhs) {
+        if( rhs._ownedLen == 0 ) {
+            _ownedLen = 0;
+            _keyData = rhs._keyData;
+            return;
+        }
+        if( &rhs != this )
+            memcpy(_owned, rhs._owned, rhs._ownedLen);
+        _ownedLen = rhs._ownedLen;
+        _keyData = (const unsigned char *) _owned;
+    }
+
     bool KeyV1::woEqual(const KeyV1& right) const {
         const unsigned char *l = _keyData;
         const unsigned char *r = right._keyData;
@@ -27,6 +27,9 @@ namespace mongo {
         KeyBson is a legacy wrapper implementation for old BSONObj style keys for v:0 indexes.
 
         KeyV1 is the new implementation.
+
+        KeyV2 is KeyV1 for v:2 indexes, whose buckets may factor a prefix common to all their
+        keys out of the stored key data.
     */
     class KeyBson /* "KeyV0" */ { 
     public:
@@ -72,6 +75,15 @@ namespace mongo {
         explicit KeyV1(const char *keyData) : _keyData((unsigned char *) keyData) { }
 
         int woCompare(const KeyV1& r, const Ordering &o) const;
+
+        /**
+         * woCompare() for two keys in the compact format, which it compares byte for byte
+         * without decoding either.
+         * @param field set to the index of the first field that differs, or to the number of
+         *     fields compared if none does.
+         */
+        int compactCompare(const KeyV1& r, const Ordering &o, int* field) const;
+
         bool woEqual(const KeyV1& r) const;
         BSONObj toBson() const;
         string toString() const { return toBson().toString(); }
@@ -115,4 +127,49 @@ namespace mongo {
         void traditional(const BSONObj& obj); // store as traditional bson not as compact format
     };
 
+    class KeyV2Owned;
+
+    // corresponding to BtreeData_V2
+    class KeyV2 : public KeyV1 {
+        void operator=(const KeyV2&);
+        KeyV2(const KeyV2Owned&);     // disallowed for the same reason as KeyV1(const KeyV1Owned&)
+    public:
+        KeyV2() : _ownedLen(0) { }
+
+        /** wraps a whole key, as KeyV1 does */
+        explicit KeyV2(const char *keyData) : KeyV1(keyData), _ownedLen(0) { }
+
+        /** reassembles a compact format key, read from a prefix compressed bucket, into a buffer
+            we own.  only as many bytes of 'suffix' as belong to the key are read.
+        */
+        KeyV2(const char *prefix, int prefixLen, const char *suffix);
+
+        /** copies the key if rhs owns it, else just points at the same data */
+        KeyV2(const KeyV2& rhs);
+        void assign(const KeyV2& rhs);
+
+        enum { MaxOwned = 1024 }; // BtreeData_V2::KeyMax
+    private:
+        unsigned short _ownedLen;
+        char _owned[MaxOwned];
+    };
+
+    class KeyV2Owned : public KeyV2 {
+        KeyV2Owned(const KeyV2Owned&);
+        void operator=(const KeyV2Owned&);
+    public:
+        /** @see KeyV1Owned(const BSONObj&) */
+        KeyV2Owned(const BSONObj& obj) : _k(obj) {
+            _keyData = (const unsigned char *) _k.data();
+        }
+
+        /** makes a copy */
+        KeyV2Owned(const KeyV2& rhs) : _k(rhs) {
+            _keyData = (const unsigned char *) _k.data();
+        }
+
+    private:
+        KeyV1Owned _k;
+    };
+
 };
@@ -106,6 +106,7 @@ namespace mongo {
 
     void KillCurrentOp::checkForInterrupt( bool heedMutex ) {
         Client& c = cc();
+        c.curop()->publishProgress();
         if ( heedMutex && Lock::somethingWriteLocked() && c.hasWrittenThisPass() )
             return;
         if( _globalKill )
@@ -114,6 +115,8 @@ namespace mongo {
             notifyAllWaiters();
             uasserted(11601,"operation was interrupted");
         }
+        if( c.curop()->maxTimeHasExpired() )
+            uasserted(ErrorCodes::ExceededTimeLimit, "operation exceeded time limit");
     }
     
     const char * KillCurrentOp::checkForInterruptNoAssert() {
@@ -122,6 +125,8 @@ namespace mongo {
             return "interrupted at shutdown";
         if( c.curop()->killPending() )
             return "interrupted";
+        if( c.curop()->maxTimeHasExpired() )
+            return "operation exceeded time limit";
         return "";
     }
 
@@ -50,6 +50,8 @@ namespace mongo {
             b.append( "writeback" , writebackId );
             b.append( "writebackSince", writebackSince );
             b.append( "instanceIdent" , prettyHostName() ); // this can be any unique string
+            if ( writebackSince == 0 && ! writebackInline.isEmpty() )
+                b.append( "writebackInline" , writebackInline );
         }
     }
 
@@ -21,6 +21,7 @@
 #include <string>
 
 #include "mongo/bson/oid.h"
+#include "mongo/db/jsobj.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
@@ -33,15 +34,17 @@ namespace mongo {
         enum UpdatedExistingType { NotUpdate, True, False } updatedExisting;
         OID upsertedId;
         OID writebackId; // this shouldn't get reset so that old GLE are handled
+        BSONObj writebackInline; // the queued writeback, for a mongos that replays it itself
         int writebackSince;
         long long nObjects;
         int nPrev;
         bool valid;
         bool disabled;
-        void writeback(const OID& oid) {
+        void writeback(const OID& oid, const BSONObj& inlineData = BSONObj()) {
             reset( true );
             writebackId = oid;
             writebackSince = 0;
+            writebackInline = inlineData;
         }
         void raiseError(int _code , const char *_msg) {
             reset( true );
@@ -73,6 +76,7 @@ namespace mongo {
             valid = _valid;
             disabled = false;
             upsertedId.clear();
+            writebackInline = BSONObj();
         }
 
         /**
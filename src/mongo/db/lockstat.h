@@ -38,6 +38,20 @@ namespace mongo {
         void report( StringBuilder& builder ) const;
 
         long long getTimeLocked( char type ) const { return timeLocked[mapNo(type)].load(); }
+
+        /** micros spent waiting for locks of any type */
+        long long getTotalTimeAcquiring() const {
+            long long total = 0;
+            for ( int i = 0; i < N; i++ )
+                total += timeAcquiring[i].load();
+            return total;
+        }
+
+        /**
+         * Notes opId as the op that took this lock most recently.
+         * @return the op that took it before, 0 if none did
+         */
+        unsigned swapLastAcquirer( unsigned opId ) { return lastAcquirer.swap( opId ); }
     private:
         static void _append( BSONObjBuilder& builder, const AtomicInt64* data );
         
@@ -46,6 +60,8 @@ namespace mongo {
         AtomicInt64 timeAcquiring[N];
         AtomicInt64 timeLocked[N];
 
+        AtomicUInt32 lastAcquirer;
+
         static unsigned mapNo(char type);
         static char nameFor(unsigned offset);
     };
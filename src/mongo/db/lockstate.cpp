@@ -24,10 +24,21 @@
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/stats/lock_contention.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
+    namespace {
+        AtomicInt32 numLockPending_;
+    }
+
+    int LockState::numLockPending() {
+        return numLockPending_.load();
+    }
+
     LockState::LockState() 
         : _batchWriter(false),
           _recursive(0),
@@ -36,6 +47,8 @@ namespace mongo {
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionCount(0),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
           _lockPendingParallelWriter(false)
@@ -130,6 +143,14 @@ namespace mongo {
                 b.append(s, kind(_otherCount));
             }
         }
+        if( _collectionCount ) {
+            WrapperForRWLock *k = _collectionLock;
+            if( k ) {
+                string s = "^";
+                s += k->name();
+                b.append(s, kind(_collectionCount));
+            }
+        }
         BSONObj o = b.obj();
         if( !o.isEmpty() ) 
             res.append("locks", o);
@@ -155,6 +176,9 @@ namespace mongo {
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
             }
+            if( _collectionCount ) {
+                ss << " collection:" << _collectionName;
+            }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
                 if( _whichNestable == Lock::local ) 
@@ -218,6 +242,23 @@ namespace mongo {
         _otherCount = 0;
     }
 
+    void LockState::lockedCollection() {
+        fassert( 16980 , _collectionCount == 0 );
+        _collectionCount = 1;
+    }
+
+    void LockState::lockedCollection( const StringData& ns , WrapperForRWLock* lock ) {
+        fassert( 16981 , _collectionCount == 0 );
+        _collectionName = ns.toString();
+        _collectionCount = 1;
+        _collectionLock = lock;
+    }
+
+    void LockState::unlockedCollection() {
+        // as with unlockedOther, the name and lock pointer stay cached
+        _collectionCount = 0;
+    }
+
     LockStat* LockState::getRelevantLockStat() {
         if ( _whichNestable )
             return Lock::nestableLockStat( _whichNestable );
@@ -235,22 +276,30 @@ namespace mongo {
     Acquiring::Acquiring( Lock::ScopedLock* lock,  LockState& ls )
         : _lock( lock ), _ls( ls ){
         _ls._lockPending = true;
+        numLockPending_.fetchAndAdd(1);
     }
 
     Acquiring::~Acquiring() {
         _ls._lockPending = false;
+        numLockPending_.fetchAndSubtract(1);
         LockStat* stat = _ls.getRelevantLockStat();
-        if ( stat && _lock )
-            stat->recordAcquireTimeMicros( _ls.threadState(), _lock->acquireFinished( stat ) );
+        if ( stat && _lock ) {
+            const char type = _ls.threadState();
+            const long long micros = _lock->acquireFinished( stat );
+            stat->recordAcquireTimeMicros( type, micros );
+            recordLockWait( type, micros, stat->swapLastAcquirer( cc().curop()->opNum() ) );
+        }
     }
     
     AcquiringParallelWriter::AcquiringParallelWriter( LockState& ls )
         : _ls( ls ) {
         _ls._lockPendingParallelWriter = true;
+        numLockPending_.fetchAndAdd(1);
     }
     
     AcquiringParallelWriter::~AcquiringParallelWriter() {
         _ls._lockPendingParallelWriter = false;
+        numLockPending_.fetchAndSubtract(1);
     }
 
 }
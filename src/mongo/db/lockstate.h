@@ -52,6 +52,12 @@ namespace mongo {
         /** pending means we are currently trying to get a lock */
         bool hasLockPending() const { return _lockPending || _lockPendingParallelWriter; }
 
+        /**
+         * @return how many threads are trying to get a lock right now; cheap enough to check
+         *     on every iteration of a scan, unlike going through the clients.
+         */
+        static int numLockPending();
+
         // ----
 
 
@@ -79,6 +85,14 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+
+        int collectionCount() const { return _collectionCount; }
+        const string& collectionName() const { return _collectionName; }
+        WrapperForRWLock* collectionLock() const { return _collectionLock; }
+
+        void lockedCollection( const StringData& ns , WrapperForRWLock* lock );
+        void lockedCollection();  // "same lock as last time" case
+        void unlockedCollection();
         bool _batchWriter;
 
         LockStat* getRelevantLockStat();
@@ -99,6 +113,11 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        // collection level locking related.  only write locks exist at this tier
+        int _collectionCount;          // >0 means we hold _collectionLock
+        string _collectionName;        // full ns of the collection we last locked
+        WrapperForRWLock* _collectionLock; // cached as with _otherLock
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
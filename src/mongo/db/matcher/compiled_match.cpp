@@ -0,0 +1,253 @@
+// compiled_match.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/matcher/compiled_match.h"
+
+#include <cmath>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/match_details.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    namespace {
+
+        // Children of an AND, with nested ANDs flattened.
+        void andChildren( const MatchExpression* e, std::vector<const MatchExpression*>* out ) {
+            if ( e->matchType() != MatchExpression::AND ) {
+                out->push_back( e );
+                return;
+            }
+            for ( size_t i = 0; i < e->numChildren(); i++ ) {
+                andChildren( e->getChild( i ), out );
+            }
+        }
+
+        // A path with an empty part, like 'a..b', is left to the leaf's own iterator.
+        bool isSimplePath( const StringData& path ) {
+            return !path.empty() && path[0] != '.' && path[path.size() - 1] != '.' &&
+                path.find( ".." ) == string::npos;
+        }
+
+        bool isNumericOperand( const BSONElement& e ) {
+            return e.type() == NumberInt ||
+                ( e.type() == NumberDouble && !std::isnan( e._numberDouble() ) );
+        }
+
+    }  // namespace
+
+    // static
+    CompiledMatch* CompiledMatch::compile( const MatchExpression* root ) {
+        std::vector<const MatchExpression*> children;
+        andChildren( root, &children );
+
+        std::auto_ptr<CompiledMatch> plan( new CompiledMatch() );
+        for ( size_t i = 0; i < children.size(); i++ ) {
+            const LeafMatchExpression* leaf =
+                dynamic_cast<const LeafMatchExpression*>( children[i] );
+            if ( leaf && isSimplePath( leaf->path() ) ) {
+                plan->addLeaf( leaf );
+            }
+            else {
+                plan->_others.push_back( children[i] );
+            }
+        }
+
+        if ( plan->_leaves.empty() ) {
+            return NULL;
+        }
+
+        plan->finish( &plan->_root );
+        return plan.release();
+    }
+
+    void CompiledMatch::addLeaf( const LeafMatchExpression* expr ) {
+        Leaf leaf;
+        leaf.expr = expr;
+        leaf.numeric = false;
+        leaf.op = expr->matchType();
+        leaf.rhs = 0;
+
+        switch ( leaf.op ) {
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::EQ:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            const BSONElement& rhs =
+                static_cast<const ComparisonMatchExpression*>( expr )->getRHS();
+            if ( isNumericOperand( rhs ) ) {
+                leaf.numeric = true;
+                leaf.rhs = rhs.number();
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        const size_t leafIndex = _leaves.size();
+        _leaves.push_back( leaf );
+
+        // Walk down the path, adding nodes as needed.
+        PathNode* node = &_root;
+        StringData rest = expr->path();
+        while ( node == &_root || !rest.empty() ) {
+            const size_t dot = rest.find( '.' );
+            const StringData part = rest.substr( 0, dot );
+            rest = dot == string::npos ? StringData() : rest.substr( dot + 1 );
+
+            PathNode* child = NULL;
+            for ( size_t i = 0; i < node->children.size(); i++ ) {
+                if ( node->children[i]->name == part ) {
+                    child = node->children[i];
+                    break;
+                }
+            }
+            if ( !child ) {
+                child = new PathNode();
+                child->name = part;
+                _nodes.mutableVector().push_back( child );
+                node->children.push_back( child );
+            }
+            node = child;
+        }
+        node->leaves.push_back( leafIndex );
+    }
+
+    void CompiledMatch::finish( PathNode* node ) {
+        node->subtreeLeaves = node->leaves;
+        for ( size_t i = 0; i < node->children.size(); i++ ) {
+            finish( node->children[i] );
+            const std::vector<size_t>& below = node->children[i]->subtreeLeaves;
+            node->subtreeLeaves.insert( node->subtreeLeaves.end(), below.begin(), below.end() );
+        }
+    }
+
+    bool CompiledMatch::matches( const BSONObj& doc, MatchDetails* details ) const {
+        if ( !matchChildren( _root, doc, doc, details ) ) {
+            if ( details )
+                details->resetOutput();
+            return false;
+        }
+
+        for ( size_t i = 0; i < _others.size(); i++ ) {
+            if ( !_others[i]->matchesBSON( doc, details ) ) {
+                if ( details )
+                    details->resetOutput();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool CompiledMatch::matchLeaf( const Leaf& leaf, const BSONElement& e ) const {
+        if ( leaf.numeric && isNumericOperand( e ) ) {
+            // Same as compareElementValues(), which compares ints and non NaN doubles as doubles.
+            const double x = e.type() == NumberInt ? e._numberInt() : e._numberDouble();
+            switch ( leaf.op ) {
+            case MatchExpression::LT: return x < leaf.rhs;
+            case MatchExpression::LTE: return x <= leaf.rhs;
+            case MatchExpression::EQ: return x == leaf.rhs;
+            case MatchExpression::GT: return x > leaf.rhs;
+            case MatchExpression::GTE: return x >= leaf.rhs;
+            default: break;
+            }
+        }
+        return leaf.expr->matchesSingleElement( e );
+    }
+
+    bool CompiledMatch::matchNode( const PathNode& node, const BSONElement& e,
+                                   const BSONObj& doc, MatchDetails* details ) const {
+        if ( e.type() == Array ) {
+            // Arrays fan out, so let each leaf below walk its own path.
+            for ( size_t i = 0; i < node.subtreeLeaves.size(); i++ ) {
+                if ( !_leaves[node.subtreeLeaves[i]].expr->matchesBSON( doc, details ) )
+                    return false;
+            }
+            return true;
+        }
+
+        for ( size_t i = 0; i < node.leaves.size(); i++ ) {
+            if ( !matchLeaf( _leaves[node.leaves[i]], e ) )
+                return false;
+        }
+
+        if ( node.children.empty() )
+            return true;
+
+        if ( e.type() == Object )
+            return matchChildren( node, e.Obj(), doc, details );
+
+        // Nothing is found below a missing field or a scalar.
+        const BSONElement missing;
+        for ( size_t i = 0; i < node.subtreeLeaves.size(); i++ ) {
+            const size_t leaf = node.subtreeLeaves[i];
+            if ( i < node.leaves.size() )
+                continue; // matched above
+            if ( !matchLeaf( _leaves[leaf], missing ) )
+                return false;
+        }
+        return true;
+    }
+
+    bool CompiledMatch::matchChildren( const PathNode& node, const BSONObj& obj,
+                                       const BSONObj& doc, MatchDetails* details ) const {
+        const size_t n = node.children.size();
+        if ( n > 64 ) {
+            for ( size_t i = 0; i < n; i++ ) {
+                const PathNode& child = *node.children[i];
+                if ( !matchNode( child, obj.getField( child.name ), doc, details ) )
+                    return false;
+            }
+            return true;
+        }
+
+        // One pass over obj finds every child.  Like getField(), a child gets the first field
+        // with its name.
+        uint64_t found = 0;
+        size_t numFound = 0;
+        BSONObjIterator it( obj );
+        while ( numFound < n && it.more() ) {
+            const BSONElement e = it.next();
+            const StringData fieldName( e.fieldName() );
+            for ( size_t i = 0; i < n; i++ ) {
+                const uint64_t bit = 1ULL << i;
+                if ( ( found & bit ) || node.children[i]->name != fieldName )
+                    continue;
+                found |= bit;
+                ++numFound;
+                if ( !matchNode( *node.children[i], e, doc, details ) )
+                    return false;
+                break;
+            }
+        }
+
+        const BSONElement missing;
+        for ( size_t i = 0; numFound < n && i < n; i++ ) {
+            if ( found & ( 1ULL << i ) )
+                continue;
+            ++numFound;
+            if ( !matchNode( *node.children[i], missing, doc, details ) )
+                return false;
+        }
+        return true;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,104 @@
+// compiled_match.h
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+    class LeafMatchExpression;
+    class MatchDetails;
+
+    /**
+     * An evaluation plan for a parsed query that visits each document once for all of the leaf
+     * predicates it can reach, rather than once per leaf.
+     *
+     * The leaves of the top level $and (or a root that is itself a leaf) are arranged in a tree by
+     * path, so {'a.x': 1, 'a.y': {$gt: 2}} scans the document to find a, then scans a once to find
+     * both x and y.  Every leaf still sees exactly the element that getFieldDottedOrArray() would
+     * give it.  Where a path runs into an array, the leaves below it fall back to their own
+     * iterators, since arrays fan out.  Numeric range and equality checks against int and double
+     * operands are evaluated inline.  All other children of the $and are matched as usual.
+     *
+     * The plan points into the expression tree it was compiled from, which must outlive it.
+     */
+    class CompiledMatch {
+        MONGO_DISALLOW_COPYING( CompiledMatch );
+    public:
+        /**
+         * @return a plan for 'root', or NULL if 'root' has no leaves to group.
+         */
+        static CompiledMatch* compile( const MatchExpression* root );
+
+        /**
+         * Same result as root->matchesBSON( doc, details ).  Not for callers that need the
+         * elemMatchKey recorded.
+         */
+        bool matches( const BSONObj& doc, MatchDetails* details = NULL ) const;
+
+    private:
+        struct Leaf {
+            const LeafMatchExpression* expr;
+
+            // If true, e matches iff inlineMatches( e ) whenever e is an int or a non NaN double.
+            bool numeric;
+            MatchExpression::MatchType op;
+            double rhs;
+        };
+
+        struct PathNode {
+            // One part of a dotted path, pointing into a leaf's path.
+            StringData name;
+
+            // Indexes into _leaves of the leaves whose path ends here.
+            std::vector<size_t> leaves;
+
+            // Indexes into _leaves of every leaf at or below this node.
+            std::vector<size_t> subtreeLeaves;
+
+            // Owned by _nodes.
+            std::vector<PathNode*> children;
+        };
+
+        CompiledMatch() { }
+
+        void addLeaf( const LeafMatchExpression* expr );
+        void finish( PathNode* node );
+
+        bool matchLeaf( const Leaf& leaf, const BSONElement& e ) const;
+        bool matchNode( const PathNode& node, const BSONElement& e,
+                        const BSONObj& doc, MatchDetails* details ) const;
+        bool matchChildren( const PathNode& node, const BSONObj& obj,
+                            const BSONObj& doc, MatchDetails* details ) const;
+
+        std::vector<Leaf> _leaves;
+        PathNode _root;
+        OwnedPointerVector<PathNode> _nodes;
+
+        // Children of the $and that aren't leaves, matched after the leaves.
+        std::vector<const MatchExpression*> _others;
+    };
+
+}  // namespace mongo
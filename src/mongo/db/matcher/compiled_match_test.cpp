@@ -0,0 +1,119 @@
+// compiled_match_test.cpp
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+/** Unit tests for CompiledMatch: each case must agree with matchesBSON. */
+
+#include "mongo/unittest/unittest.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/compiled_match.h"
+#include "mongo/db/matcher/expression_parser.h"
+
+namespace mongo {
+
+    namespace {
+
+        /**
+         * Asserts that the compiled form of 'query' gives the same answer as the expression
+         * itself for 'doc', and returns that answer.
+         */
+        bool compiledMatches( const char* query, const char* doc ) {
+            StatusWithMatchExpression result = MatchExpressionParser::parse( fromjson( query ) );
+            ASSERT( result.isOK() );
+            boost::scoped_ptr<MatchExpression> expr( result.getValue() );
+            boost::scoped_ptr<CompiledMatch> compiled( CompiledMatch::compile( expr.get() ) );
+            ASSERT( compiled );
+
+            BSONObj obj = fromjson( doc );
+            bool expected = expr->matchesBSON( obj, NULL );
+            ASSERT_EQUALS( expected, compiled->matches( obj ) );
+            return expected;
+        }
+
+    }
+
+    TEST( CompiledMatch, Simple ) {
+        ASSERT( compiledMatches( "{a: 1}", "{a: 1}" ) );
+        ASSERT( !compiledMatches( "{a: 1}", "{a: 2}" ) );
+        ASSERT( !compiledMatches( "{a: 1}", "{b: 1}" ) );
+        ASSERT( compiledMatches( "{a: 1, b: 'x'}", "{b: 'x', a: 1}" ) );
+        ASSERT( !compiledMatches( "{a: 1, b: 'x'}", "{b: 'y', a: 1}" ) );
+    }
+
+    TEST( CompiledMatch, SharedPrefix ) {
+        const char* query = "{'a.b': {$gt: 1}, 'a.c': {$lt: 5}, 'a.d.e': 'x'}";
+        ASSERT( compiledMatches( query, "{a: {b: 2, c: 4, d: {e: 'x'}}}" ) );
+        ASSERT( !compiledMatches( query, "{a: {b: 2, c: 6, d: {e: 'x'}}}" ) );
+        ASSERT( !compiledMatches( query, "{a: {b: 2, c: 4, d: {e: 'y'}}}" ) );
+        ASSERT( !compiledMatches( query, "{a: {b: 2, c: 4}}" ) );
+        ASSERT( compiledMatches( "{a: {$exists: true}, 'a.b': 1}", "{a: {b: 1}}" ) );
+    }
+
+    TEST( CompiledMatch, Missing ) {
+        ASSERT( compiledMatches( "{a: null}", "{b: 1}" ) );
+        ASSERT( compiledMatches( "{'a.b': null}", "{b: 1}" ) );
+        ASSERT( compiledMatches( "{'a.b': {$exists: false}, c: 1}", "{c: 1}" ) );
+        ASSERT( !compiledMatches( "{'a.b': {$exists: true}}", "{a: {}}" ) );
+    }
+
+    TEST( CompiledMatch, ScalarIntermediate ) {
+        ASSERT( !compiledMatches( "{'a.b': 1}", "{a: 1}" ) );
+        ASSERT( compiledMatches( "{'a.b': null}", "{a: 1}" ) );
+        ASSERT( compiledMatches( "{'a.b.c': null, 'a.d': 2}", "{a: {b: 5, d: 2}}" ) );
+    }
+
+    TEST( CompiledMatch, Arrays ) {
+        ASSERT( compiledMatches( "{a: 2}", "{a: [1, 2, 3]}" ) );
+        ASSERT( compiledMatches( "{'a.b': 2}", "{a: [{b: 1}, {b: 2}]}" ) );
+        ASSERT( !compiledMatches( "{'a.b': 3}", "{a: [{b: 1}, {b: 2}]}" ) );
+        ASSERT( compiledMatches( "{'a.0': 1}", "{a: [1, 2]}" ) );
+        ASSERT( compiledMatches( "{'a.b.c': 1, 'a.d': 2}", "{a: {b: [{c: 1}], d: 2}}" ) );
+        ASSERT( compiledMatches( "{a: [1, 2]}", "{a: [1, 2]}" ) );
+    }
+
+    TEST( CompiledMatch, Numbers ) {
+        ASSERT( compiledMatches( "{a: {$gte: 2}}", "{a: 2.0}" ) );
+        ASSERT( compiledMatches( "{a: 2.5}", "{a: 2.5}" ) );
+        ASSERT( !compiledMatches( "{a: {$lt: 2}}", "{a: NumberLong(2)}" ) );
+        ASSERT( !compiledMatches( "{a: {$lt: 2}}", "{a: 'x'}" ) );
+        ASSERT( !compiledMatches( "{a: {$lt: 2}}", "{a: NaN}" ) );
+        ASSERT( compiledMatches( "{a: NaN}", "{a: NaN}" ) );
+        ASSERT( !compiledMatches( "{a: {$gt: NaN}}", "{a: 1}" ) );
+    }
+
+    TEST( CompiledMatch, NonLeafClauses ) {
+        const char* query = "{a: 1, $or: [{b: 1}, {c: 1}]}";
+        ASSERT( compiledMatches( query, "{a: 1, c: 1}" ) );
+        ASSERT( !compiledMatches( query, "{a: 1, d: 1}" ) );
+        ASSERT( !compiledMatches( query, "{a: 2, b: 1}" ) );
+        ASSERT( compiledMatches( "{a: 1, b: {$elemMatch: {c: 1}}}", "{a: 1, b: [{c: 1}]}" ) );
+        ASSERT( compiledMatches( "{$and: [{a: 1}, {$and: [{'b.c': 2}]}]}", "{a: 1, b: {c: 2}}" ) );
+        ASSERT( !compiledMatches( "{a: {$not: {$gt: 1}}}", "{a: 2}" ) );
+    }
+
+    TEST( CompiledMatch, NothingToCompile ) {
+        StatusWithMatchExpression result =
+            MatchExpressionParser::parse( fromjson( "{$or: [{a: 1}, {b: 1}]}" ) );
+        ASSERT( result.isOK() );
+        boost::scoped_ptr<MatchExpression> expr( result.getValue() );
+        ASSERT( NULL == CompiledMatch::compile( expr.get() ) );
+    }
+
+}
@@ -114,6 +114,11 @@ namespace mongo {
 
         virtual bool equivalent( const MatchExpression* other ) const;
 
+        virtual size_t numChildren() const { return _list.size(); }
+        virtual const MatchExpression* getChild( size_t i ) const { return _list[i]; }
+
+        const StringData& path() const { return _path; }
+
     private:
         bool _allMatch( const BSONObj& anArray ) const;
 
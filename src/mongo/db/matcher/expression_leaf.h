@@ -215,6 +215,8 @@ namespace mongo {
         virtual void debugString( StringBuilder& debug, int level ) const;
 
         virtual bool equivalent( const MatchExpression* other ) const;
+
+        const StringData& path() const { return _path; }
     private:
         bool _matches( const StringData& path,
                        const MatchableDocument* doc,
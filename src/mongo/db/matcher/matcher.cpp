@@ -143,6 +143,7 @@ namespace mongo {
                  result.isOK() );
 
         _expression.reset( result.getValue() );
+        _compiled.reset( CompiledMatch::compile( _expression.get() ) );
     }
 
     Matcher2::Matcher2( const Matcher2 &docMatcher, const BSONObj &constrainIndexKey )
@@ -166,8 +167,11 @@ namespace mongo {
         if ( !_expression )
             return true;
 
-        if ( _indexKey.isEmpty() )
+        if ( _indexKey.isEmpty() ) {
+            if ( _compiled && !( details && details->needRecord() ) )
+                return _compiled->matches( doc, details );
             return _expression->matchesBSON( doc, details );
+        }
 
         if ( !doc.isEmpty() && doc.firstElement().fieldName()[0] )
             return _expression->matchesBSON( doc, details );
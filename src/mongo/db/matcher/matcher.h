@@ -23,6 +23,7 @@
 #include "mongo/base/disallow_copying.h"
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/compiled_match.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/matcher/match_details.h"
 #include "mongo/db/exec/working_set.h"
@@ -83,6 +84,9 @@ namespace mongo {
 
         boost::scoped_ptr<MatchExpression> _expression;
 
+        // How matches() evaluates _expression against whole documents, when it can.
+        boost::scoped_ptr<CompiledMatch> _compiled;
+
         IndexSpliceInfo _spliceInfo;
 
         static MatchExpression* _spliceForIndex( const set<std::string>& keys,
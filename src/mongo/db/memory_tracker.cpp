@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/memory_tracker.h"
+
+#include <algorithm>
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    // The most memory one op's sorts, groups and other big buffers may hold.  0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER(maxOpMemoryMB, int, 0);
+
+    // The most memory the big buffers of all ops together may hold.  0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER(maxTotalOpMemoryMB, int, 0);
+
+    namespace {
+        AtomicInt64 totalCharged;
+        AtomicUInt32 nextGeneration;
+        OpMemoryAccount* (*currentGetter)() = NULL;
+
+        long long limitBytes( int mb ) {
+            return mb > 0 ? mb * 1024LL * 1024 : 0;
+        }
+
+        class OpMemoryMetric : public ServerStatusMetric {
+        public:
+            OpMemoryMetric() : ServerStatusMetric( "operationMemory.bytes" ) {}
+            virtual void appendAtLeaf( BSONObjBuilder& b ) const {
+                b.appendNumber( _leafName, MemoryCharge::totalBytes() );
+            }
+        } opMemoryMetric;
+    }
+
+    OpMemoryAccount::OpMemoryAccount()
+        : _bytes( 0 ), _peakBytes( 0 ), _generation( nextGeneration.fetchAndAdd( 1 ) ) {
+    }
+
+    void OpMemoryAccount::reset() {
+        _bytes = 0;
+        _peakBytes = 0;
+        _generation = nextGeneration.fetchAndAdd( 1 );
+    }
+
+    void OpMemoryAccount::add( long long delta ) {
+        _bytes = std::max( 0LL, _bytes + delta );
+        _peakBytes = std::max( _peakBytes, _bytes );
+    }
+
+    OpMemoryAccount* OpMemoryAccount::current() {
+        return currentGetter ? currentGetter() : NULL;
+    }
+
+    void OpMemoryAccount::setCurrentGetter( OpMemoryAccount* (*getter)() ) {
+        currentGetter = getter;
+    }
+
+    OpMemoryAccount* MemoryCharge::currentAccount() {
+        OpMemoryAccount* account = OpMemoryAccount::current();
+        if ( account && ( account != _account || account->_generation != _generation ) ) {
+            account->add( _bytes );
+            _account = account;
+            _generation = account->_generation;
+        }
+        return account;
+    }
+
+    bool MemoryCharge::trySet( size_t bytes ) {
+        OpMemoryAccount* account = currentAccount();
+        const long long delta = static_cast<long long>( bytes ) - static_cast<long long>( _bytes );
+        if ( delta > 0 ) {
+            const long long opLimit = limitBytes( maxOpMemoryMB );
+            if ( opLimit && account && account->_bytes + delta > opLimit )
+                return false;
+            const long long totalLimit = limitBytes( maxTotalOpMemoryMB );
+            const long long total = totalCharged.addAndFetch( delta );
+            if ( totalLimit && total > totalLimit ) {
+                totalCharged.subtractAndFetch( delta );
+                return false;
+            }
+        }
+        else {
+            totalCharged.addAndFetch( delta );
+        }
+
+        if ( account )
+            account->add( delta );
+        _bytes = bytes;
+        return true;
+    }
+
+    void MemoryCharge::set( size_t bytes, const char* what ) {
+        uassert( 17041,
+                 str::stream() << what << " needs more memory than maxOpMemoryMB ("
+                               << maxOpMemoryMB << ") or maxTotalOpMemoryMB ("
+                               << maxTotalOpMemoryMB << ") allow",
+                 trySet( bytes ) );
+    }
+
+    long long MemoryCharge::totalBytes() {
+        return totalCharged.load();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,95 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    /**
+     * What an op holds of the memory charged through MemoryCharges, for currentOp and for the
+     * maxOpMemoryMB limit.  In mongod each CurOp has one.  Where there's no account, as in
+     * mongos, charges only count toward the server's total.
+     */
+    class OpMemoryAccount {
+    public:
+        OpMemoryAccount();
+
+        /** Starts over for a new op.  Charges counted here before are no longer. */
+        void reset();
+
+        long long bytes() const { return _bytes; }
+        long long peakBytes() const { return _peakBytes; }
+
+        /** @return the account of the op current on this thread, or NULL if there's none */
+        static OpMemoryAccount* current();
+
+        /** Sets how current() finds the account of the current op. */
+        static void setCurrentGetter( OpMemoryAccount* (*getter)() );
+
+    private:
+        friend class MemoryCharge;
+
+        void add( long long delta );
+
+        long long _bytes;
+        long long _peakBytes;
+        unsigned _generation; // unique to this account and op
+    };
+
+    /**
+     * The memory one big buffer holds, like a sort's or a $group's.  Its owner sets the charge as
+     * the buffer grows and shrinks.  The charge counts toward the server's total and toward the
+     * account of the op that is current when it changes.  Growing it fails if that would take
+     * the op past maxOpMemoryMB or the server past maxTotalOpMemoryMB.  The owner then spills to
+     * disk if it can, or fails the op.
+     *
+     * A buffer kept across ops, as a cursor keeps its buffers across getMores, moves to the
+     * account of the op that changes it next.
+     */
+    class MemoryCharge {
+        MONGO_DISALLOW_COPYING(MemoryCharge);
+    public:
+        MemoryCharge() : _bytes( 0 ), _account( NULL ), _generation( 0 ) {}
+        ~MemoryCharge() { trySet( 0 ); }
+
+        /**
+         * Sets the charge to 'bytes'.  Returns false, leaving the charge as it was, if that's
+         * more than the limits allow.  Shrinking it always works.
+         */
+        bool trySet( size_t bytes );
+
+        /** As trySet(), but throws if a limit is exceeded.  'what' names the buffer. */
+        void set( size_t bytes, const char* what );
+
+        size_t bytes() const { return _bytes; }
+
+        /** @return the memory charged on the whole server */
+        static long long totalBytes();
+
+    private:
+        // the current op's account, which this charge's bytes are moved to if they aren't in it
+        OpMemoryAccount* currentAccount();
+
+        size_t _bytes;
+        OpMemoryAccount* _account; // the last account charged; only used if still current
+        unsigned _generation;      // of _account when it was charged
+    };
+
+}  // namespace mongo
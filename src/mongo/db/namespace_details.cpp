@@ -27,6 +27,8 @@
 #include "mongo/db/ops/delete.h"
 #include "mongo/db/ops/update.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/queryutil.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/hashtab.h"
 #include "mongo/util/startup_test.h"
@@ -168,13 +170,18 @@ namespace mongo {
         return allocationSize;
     }
 
+    // Allocate from the head of a deleted list bucket instead of searching the lists for a
+    // good fit.  See __headAlloc().
+    MONGO_EXPORT_SERVER_PARAMETER(recordAllocHeadOfBucket, bool, false);
+
     /* predetermine location of the next alloc without actually doing it.
         if cannot predetermine returns null (so still call alloc() then)
     */
     DiskLoc NamespaceDetails::allocWillBeAt(const char *ns, int lenToAlloc) {
         if ( ! isCapped() ) {
             lenToAlloc = (lenToAlloc + 3) & 0xfffffffc;
-            return __stdAlloc(lenToAlloc, true);
+            return recordAllocHeadOfBucket ? __headAlloc(lenToAlloc, true)
+                                           : __stdAlloc(lenToAlloc, true);
         }
         return DiskLoc();
     }
@@ -246,6 +253,37 @@ namespace mongo {
        @param peekOnly just look up where and don't reserve
        returned item is out of the deleted list upon return
     */
+    /* for non-capped collections.
+       takes the first deleted record in the smallest bucket whose first record fits, touching at
+       most one deleted record per bucket rather than walking chains through cold pages.  Every
+       record in a bucket above bucket(len) fits, so this rarely falls back to __stdAlloc; the
+       price is splitting bigger records than a best fit would.
+       @param peekOnly just look up where and don't reserve
+       returned item is out of the deleted list upon return
+    */
+    DiskLoc NamespaceDetails::__headAlloc(int len, bool peekOnly) {
+        for ( int b = bucket(len); b <= MaxBucket; b++ ) {
+            DiskLoc cur = _deletedList[b];
+            if ( cur.isNull() )
+                continue;
+
+            DeletedRecord *r = cur.drec();
+            if ( r->lengthWithHeaders() < len )
+                continue;
+
+            /* unlink ourself from the deleted list */
+            if( !peekOnly ) {
+                *getDur().writing(&_deletedList[b]) = r->nextDeleted();
+                r->nextDeleted().writing().setInvalid(); // defensive.
+                verify(r->extentOfs() < cur.getOfs());
+            }
+            return cur;
+        }
+
+        // Only the first record of each bucket was too small, if any; search properly.
+        return __stdAlloc(len, peekOnly);
+    }
+
     DiskLoc NamespaceDetails::__stdAlloc(int len, bool peekOnly) {
         DiskLoc *prev;
         DiskLoc *bestprev = 0;
@@ -381,7 +419,7 @@ namespace mongo {
     /* alloc with capped table handling. */
     DiskLoc NamespaceDetails::_alloc(const char *ns, int len) {
         if ( ! isCapped() )
-            return __stdAlloc(len, false);
+            return recordAllocHeadOfBucket ? __headAlloc(len, false) : __stdAlloc(len, false);
 
         return cappedAlloc(ns,len);
     }
@@ -568,6 +606,8 @@ namespace mongo {
     void NamespaceDetailsTransient::reset() {
         Lock::assertWriteLocked(_ns); 
         clearQueryCache();
+        _planCache.clear();
+        _updateDriverCache.clear();
         _keysComputed = false;
     }
 
@@ -596,7 +636,7 @@ namespace mongo {
     // that is NOT handled here yet!  TODO
     // repair may not use nsdt though not sure.  anyway, requires work.
     NamespaceDetailsTransient::NamespaceDetailsTransient(Database *db, const string& ns) : 
-        _ns(ns), _keysComputed(false), _qcWriteCount() 
+        _ns(ns), _keysComputed(false), _qcWriteCount(), _insertCount(0) 
     {
         dassert(db);
     }
@@ -637,12 +677,23 @@ namespace mongo {
 
         NamespaceDetails::IndexIterator i = d->ii( true );
         while( i.more() ) {
-            BSONObj key = i.next().keyPattern();
+            IndexDetails& index = i.next();
+            BSONObj key = index.keyPattern();
             BSONObjIterator j( key );
             while ( j.more() ) {
                 BSONElement e = j.next();
                 _indexedPaths.addPath( e.fieldName() );
             }
+
+            // Changing a field a partial index filters on can move a document in or out of it.
+            BSONObj filter = index.info.obj().getObjectField( "partialFilterExpression" );
+            if ( !filter.isEmpty() ) {
+                FieldRangeSet ranges( _ns.c_str(), filter, true, true );
+                for ( map<string,FieldRange>::const_iterator k = ranges.ranges().begin();
+                      k != ranges.ranges().end(); ++k ) {
+                    _indexedPaths.addPath( k->first );
+                }
+            }
         }
 
         _keysComputed = true;
@@ -899,6 +950,31 @@ namespace mongo {
         }
     }
 
+    int NamespaceDetails::unlinkDeletedRecordsInExtent(const DiskLoc& extentLoc) {
+        verify( !isCapped() );
+        int n = 0;
+        for ( int b = 0; b < Buckets; b++ ) {
+            DiskLoc prev;
+            DiskLoc cur = _deletedList[b];
+            while ( !cur.isNull() ) {
+                DeletedRecord* r = cur.drec();
+                DiskLoc next = r->nextDeleted();
+                if ( r->myExtentLoc(cur) == extentLoc ) {
+                    if ( prev.isNull() )
+                        getDur().writingDiskLoc( _deletedList[b] ) = next;
+                    else
+                        prev.drec()->nextDeleted().writing() = next;
+                    n++;
+                }
+                else {
+                    prev = cur;
+                }
+                cur = next;
+            }
+        }
+        return n;
+    }
+
     /* ------------------------------------------------------------------------- */
 
     /* add a new namespace to the system catalog (<dbname>.system.namespaces).
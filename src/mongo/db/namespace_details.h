@@ -19,13 +19,17 @@
 #include "mongo/pch.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/db/exec/plan_cache.h"
 #include "mongo/db/index.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/index_set.h"
+#include "mongo/db/index_usage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/ops/update_driver_cache.h"
 #include "mongo/db/querypattern.h"
+#include "mongo/db/record_growth_model.h"
 #include "mongo/db/storage/namespace.h"
 #include "mongo/db/storage/namespace_index.h"
 #include "mongo/platform/unordered_map.h"
@@ -162,6 +166,11 @@ namespace mongo {
         void advanceCapExtent( const char *ns );
         DiskLoc __capAlloc(int len);
         DiskLoc cappedAlloc(const char *ns, int len);
+        /**
+         * Deletes the oldest documents in the cap extent to make room for a 'len' byte
+         * record, or more; see cappedDeleteAheadBytes.  The cap extent must have some.
+         */
+        void cappedDeleteOldest( const char *ns, int len );
         DiskLoc &cappedFirstDeletedInCurExtent();
         bool nextIsInCapExtent( const DiskLoc &dl ) const;
 
@@ -202,6 +211,14 @@ namespace mongo {
 
         void orphanDeletedList();
 
+        /**
+         * Takes the deleted records that lie in extent 'extentLoc' off the deleted lists, so
+         * nothing more is allocated there and the extent can be freed once it holds no
+         * records.  Not for capped collections.
+         * @return the number of deleted records taken off.
+         */
+        int unlinkDeletedRecordsInExtent(const DiskLoc& extentLoc);
+
         /**
          * @param max in and out, will be adjusted
          * @return if the value is valid at all
@@ -498,6 +515,7 @@ namespace mongo {
         DiskLoc _alloc(const char *ns, int len);
         void maybeComplain( const char *ns, int len ) const;
         DiskLoc __stdAlloc(int len, bool willBeAt);
+        DiskLoc __headAlloc(int len, bool willBeAt);
         void compact(); // combine adjacent deleted records
         friend class NamespaceIndex;
         struct ExtraOld {
@@ -622,6 +640,43 @@ namespace mongo {
             _qcCache[ pattern ] = cachedQueryPlan;
         }
 
+        /* record growth (for adaptive padding) --------------------------------- */
+    private:
+        RecordGrowthModel _growthModel;
+    public:
+        /* assumed to be in a lock on the database for this, a write lock to update it */
+        RecordGrowthModel& growthModel() { return _growthModel; }
+
+        /* inserts (for sharding's split point lookups) ------------------------- */
+    private:
+        unsigned long long _insertCount;
+    public:
+        /* records inserted since this was made, never decreases.
+           assumed to be in a lock on the database for this, a write lock to update it */
+        unsigned long long insertCount() const { return _insertCount; }
+        void notifyOfInsert() { ++_insertCount; }
+
+        /* plan cache (for PlanStage based execution) ---------------------------- */
+    private:
+        PlanCache _planCache;
+    public:
+        /* not flushed by writes, only on index changes; see PlanCache.  thread safe. */
+        PlanCache& planCache() { return _planCache; }
+
+        /* parsed update expressions -------------------------------------------- */
+    private:
+        UpdateDriverCache _updateDriverCache;
+    public:
+        /* flushed on index changes, like the plan cache.  thread safe. */
+        UpdateDriverCache& updateDriverCache() { return _updateDriverCache; }
+
+        /* index usage counts ---------------------------------------------------- */
+    private:
+        IndexUsageMap _indexUsage;
+    public:
+        /* kept across index changes; a dropped index's are forgotten.  thread safe. */
+        IndexUsageMap& indexUsage() { return _indexUsage; }
+
     }; /* NamespaceDetailsTransient */
 
     inline NamespaceDetailsTransient& NamespaceDetailsTransient::get_inlock(const string& ns) {
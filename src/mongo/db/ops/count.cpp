@@ -18,9 +18,15 @@
 
 #include "mongo/db/ops/count.h"
 
+#include <boost/bind.hpp>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/cursor.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
+#include "mongo/db/intervalbtreecursor.h"
+#include "mongo/db/matcher.h"
 #include "mongo/db/query_optimizer.h"
 #include "mongo/db/queryutil.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -52,6 +58,22 @@ namespace mongo {
 
         } _countPlanPolicies;
 
+        // Keys counted by IntervalBtreeCursor::countKeys() between yield checks.
+        const long long kKeysPerCountBatch = 10000;
+
+        void countPartition( const BSONObj& query, vector<long long>* counts, size_t i,
+                             ParallelCollectionScan::Partition* partition ) {
+            Matcher matcher( query );
+            long long n = 0;
+            BSONObj obj;
+            while ( partition->next( &obj ) ) {
+                if ( matcher.matches( obj ) ) {
+                    ++n;
+                }
+            }
+            (*counts)[ i ] = n;
+        }
+
     }
     
     long long runCount( const char *ns, const BSONObj &cmd, string &err, int &errCode ) {
@@ -80,6 +102,46 @@ namespace mongo {
         ClientCursor::Holder ccPointer;
         ElapsedTracker timeToStartYielding( 256, 20 );
         try {
+            // A query no index helps with has to read every document, so split them between
+            // threads.  This holds the read lock throughout rather than yielding.
+            const int threads = ParallelCollectionScan::threadsFor( d );
+            if ( threads > 1 && dynamic_cast<BasicCursor*>( cursor.get() ) &&
+                 ParallelCollectionScan::canMatchInParallel( query ) ) {
+                ParallelCollectionScan scan( d, threads );
+                vector<long long> counts( scan.numPartitions(), 0 );
+                scan.run( boost::bind( &countPartition, query, &counts, _1, _2 ) );
+                for ( size_t i = 0; i < counts.size(); i++ ) {
+                    count += counts[ i ];
+                }
+                return applySkipLimit( count, cmd );
+            }
+
+            // When the index bounds answer the query exactly, count keys a batch at a time rather
+            // than matching them one by one.  Multikey indexes need deduping so take the slow path.
+            IntervalBtreeCursor* intervalCursor = dynamic_cast<IntervalBtreeCursor*>( cursor.get() );
+            while( intervalCursor && !cursor->matcher() && !cursor->isMultiKey() &&
+                   cursor->ok() ) {
+                if ( !ccPointer ) {
+                    if ( timeToStartYielding.intervalHasElapsed() ) {
+                        ccPointer.reset( new ClientCursor( QueryOption_NoCursorTimeout, cursor, ns ) );
+                    }
+                }
+                else if ( !ccPointer->yieldSometimes( ClientCursor::MaybeCovered ) ||
+                         !cursor->ok() ) {
+                    ccPointer.reset();
+                    return count;
+                }
+
+                long long n = intervalCursor->countKeys( kKeysPerCountBatch );
+                long long skipped = std::min( skip, n );
+                skip -= skipped;
+                count += n - skipped;
+                if ( limit > 0 && count >= limit ) {
+                    ccPointer.reset();
+                    return limit;
+                }
+            }
+
             while( cursor->ok() ) {
                 if ( !ccPointer ) {
                     if ( timeToStartYielding.intervalHasElapsed() ) {
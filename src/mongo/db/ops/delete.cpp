@@ -32,8 +32,9 @@ namespace mongo {
        pattern: the "where" clause / criteria
        justOne: stop after 1 match
        god:     allow access to system namespaces, and don't yield
+       limit:   if positive, stop after this many deletes
     */
-    long long deleteObjects(const char *ns, BSONObj pattern, bool justOne, bool logop, bool god, RemoveSaver * rs ) {
+    long long deleteObjects(const char *ns, BSONObj pattern, bool justOne, bool logop, bool god, RemoveSaver * rs, long long limit ) {
         if( !god ) {
             if ( strstr(ns, ".system.") ) {
                 /* note a delete from system.indexes would corrupt the db
@@ -111,7 +112,7 @@ namespace mongo {
                 cc->advance();
             }
             
-            bool foundAllResults = ( justOne || !cc->ok() );
+            bool foundAllResults = ( justOne || !cc->ok() || ( limit > 0 && nDeleted + 1 >= limit ) );
 
             if ( !foundAllResults ) {
                 // NOTE: Saving and restoring a btree cursor's position was historically described
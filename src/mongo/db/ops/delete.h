@@ -27,7 +27,8 @@ namespace mongo {
     class RemoveSaver;
 
     // If justOne is true, deletedId is set to the id of the deleted object.
-    long long deleteObjects(const char *ns, BSONObj pattern, bool justOne, bool logop = false, bool god=false, RemoveSaver * rs=0);
+    // If limit is positive, stops after deleting that many objects.
+    long long deleteObjects(const char *ns, BSONObj pattern, bool justOne, bool logop = false, bool god=false, RemoveSaver * rs=0, long long limit=0);
 
 
 }
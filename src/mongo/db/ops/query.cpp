@@ -24,6 +24,7 @@
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/commands.h"
+#include "mongo/db/exec/shard_filter.h"
 #include "mongo/db/pagefault.h"
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/pdfile.h"
@@ -35,6 +36,7 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/repl_reads_ok.h"
 #include "mongo/db/scanandorder.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/s/stale_exception.h"  // for SendStaleConfigException
 #include "mongo/server.h"
@@ -42,6 +44,10 @@
 
 namespace mongo {
 
+    // Memory for getMore replies built before the client asks for them (see
+    // prepareNextGetMore()).  0 turns preparing replies off.
+    MONGO_EXPORT_SERVER_PARAMETER( getMorePrefetchMaxMB, int, 0 );
+
     /* We cut off further objects once we cross this threshold; thus, you might get
        a little bit more than this, it is a threshold rather than a limit.
     */
@@ -97,10 +103,16 @@ namespace mongo {
                                 CurOp& curop,
                                 int pass,
                                 bool& exhaust,
-                                bool* isCursorAuthorized ) {
+                                bool* isCursorAuthorized,
+                                bool* canPrepareNext ) {
         exhaust = false;
+        if ( canPrepareNext )
+            *canPrepareNext = false;
 
-        int bufSize = 512 + sizeof( QueryResult ) + MaxBytesToReturnToClientAtOnce;
+        // Room past the batch size limit for the document that crosses it.  getMore ends the
+        // batch early rather than grow past this, since growing copies the whole reply.
+        const int ReplyObjSlack = 512;
+        int bufSize = ReplyObjSlack + sizeof( QueryResult ) + MaxBytesToReturnToClientAtOnce;
 
         BufBuilder b( bufSize );
         b.skip(sizeof(QueryResult));
@@ -112,6 +124,14 @@ namespace mongo {
         // call this readlocked so state can't change
         replVerifyReadsOk();
 
+        if ( QueryResult* prepared = ClientCursor::takePreparedBatch( cursorid, ns ) ) {
+            // built by prepareNextGetMore() after the last reply was sent
+            *isCursorAuthorized = true;
+            if ( canPrepareNext )
+                *canPrepareNext = prepared->cursorId != 0;
+            return prepared;
+        }
+
         ClientCursor::Pin p(cursorid);
         ClientCursor *cc = p.c();
 
@@ -194,6 +214,13 @@ namespace mongo {
                     LOG(2) << "cursor skipping document in un-owned chunk: " << c->current()
                                << endl;
                 }
+                else if ( n > 0 && !c->keyFieldsOnly() &&
+                          b.len() + c->current().objsize() + ReplyObjSlack > b.getSize() ) {
+                    // Growing the buffer would copy everything already in it.  Send what we
+                    // have and start the next batch from this document instead.
+                    cc->incPos( n );
+                    break;
+                }
                 else {
                     if( c->getsetdup(c->currLoc()) ) {
                         //out() << "  but it's a dup \n";
@@ -233,6 +260,10 @@ namespace mongo {
                 cc->mayUpgradeStorage();
                 cc->storeOpForSlave( last );
                 exhaust = cc->queryOptions() & QueryOption_Exhaust;
+                if ( canPrepareNext ) {
+                    *canPrepareNext = getMorePrefetchMaxMB > 0 && !exhaust &&
+                        !c->tailable() && c->requiresLock();
+                }
             }
         }
 
@@ -248,6 +279,41 @@ namespace mongo {
         return qr;
     }
 
+    void prepareNextGetMore(const char* ns,
+                            int ntoreturn,
+                            long long cursorid,
+                            const HostAndPort& remote) {
+        if ( ClientCursor::preparedBatchBytes() >= getMorePrefetchMaxMB * 1024LL * 1024 )
+            return;
+
+        // Show up in currentOp as a getMore, since it is one.  The CurOp of the request just
+        // answered is done, so it can be reused.
+        CurOp& curop = *cc().curop();
+        if ( curop.active() )
+            return;
+        curop.reset( remote, dbGetMore );
+
+        bool exhaust = false;
+        bool isCursorAuthorized = false;
+        try {
+            QueryResult* qr = processGetMore( ns, ntoreturn, cursorid, curop, /*pass*/ 0,
+                                              exhaust, &isCursorAuthorized );
+            if ( qr ) {
+                ClientCursor::addPreparedBatch( cursorid, ns, qr );
+            }
+        }
+        catch ( AssertionException& e ) {
+            // Like a failed getMore: the cursor may have moved past documents nobody will
+            // see, so it can't be used any more.
+            LOG(1) << "failed to prepare next batch for cursor " << cursorid << ": " << e << endl;
+            if ( isCursorAuthorized )
+                ClientCursor::erase( cursorid );
+        }
+
+        curop.ensureStarted();
+        curop.done();
+    }
+
     ResultDetails::ResultDetails() :
         match(),
         orderedMatch(),
@@ -554,6 +620,9 @@ namespace mongo {
     
     void QueryResponseBuilder::init( const QueryPlanSummary &queryPlan, const BSONObj &oldPlan ) {
         _collMetadata = newCollMetadata();
+        if ( _collMetadata ) {
+            _shardFilter.reset( new ShardFilter( _collMetadata ) );
+        }
         _explain = newExplainRecordingStrategy( queryPlan, oldPlan );
         _builder = newResponseBuildStrategy( queryPlan );
         _builder->resetBuf();
@@ -680,11 +749,17 @@ namespace mongo {
         if ( !_collMetadata ) {
             return true;
         }
-        // TODO: should make this covered at some point
-        resultDetails->loadedRecord = true;
-        KeyPattern kp( _collMetadata->getKeyPattern() );
-        if ( _collMetadata->keyBelongsToMe( kp.extractSingleKey( _cursor->current() ) ) ) {
-            return true;
+        // An index holding the shard key answers without loading the document.
+        if ( _shardFilter->canUseIndexKey( _cursor->indexKeyPattern() ) ) {
+            if ( _shardFilter->indexKeyBelongsToMe( _cursor->currKey() ) ) {
+                return true;
+            }
+        }
+        else {
+            resultDetails->loadedRecord = true;
+            if ( _shardFilter->docBelongsToMe( _cursor->current() ) ) {
+                return true;
+            }
         }
         resultDetails->chunkSkip = true;
         return false;
@@ -1004,6 +1079,10 @@ namespace mongo {
             return "";
         }
 
+        if ( pq.getMaxTimeMS() > 0 ) {
+            curop.setMaxTimeMicros( pq.getMaxTimeMS() * 1000ULL );
+        }
+
         bool explain = pq.isExplain();
         BSONObj order = pq.getOrder();
         BSONObj query = pq.getFilter();
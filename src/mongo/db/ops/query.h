@@ -34,6 +34,7 @@ namespace mongo {
     class CurOp;
     class ParsedQuery;
     class QueryOptimizerCursor;
+    class ShardFilter;
     struct QueryPlanSummary;
 
     extern const int32_t MaxBytesToReturnToClientAtOnce;
@@ -42,6 +43,8 @@ namespace mongo {
      * Return a batch of results from a client OP_GET_MORE request.
      * 'cursorid' - The id of the cursor producing results.
      * 'isCursorAuthorized' - Set to true after a cursor with id 'cursorid' is authorized for use.
+     * 'canPrepareNext' - If not NULL, set to true when the next batch may be built ahead of the
+     *                    request for it with prepareNextGetMore().
      */
     QueryResult* processGetMore(const char* ns,
                                 int ntoreturn,
@@ -49,7 +52,19 @@ namespace mongo {
                                 CurOp& op,
                                 int pass,
                                 bool& exhaust,
-                                bool* isCursorAuthorized);
+                                bool* isCursorAuthorized,
+                                bool* canPrepareNext = NULL);
+
+    /**
+     * Builds the reply to the next getMore on 'cursorid' right away and keeps it with the
+     * cursor, so that getMore can be answered without touching the collection.  Meant to run
+     * once a reply has been sent, while the client reads it.  Does nothing once prepared
+     * replies use up getMorePrefetchMaxMB.
+     */
+    void prepareNextGetMore(const char* ns,
+                            int ntoreturn,
+                            long long cursorid,
+                            const HostAndPort& remote);
 
     string runQuery(Message& m, QueryMessage& q, CurOp& curop, Message &result);
 
@@ -319,6 +334,7 @@ namespace mongo {
         shared_ptr<QueryOptimizerCursor> _queryOptimizerCursor;
         BufBuilder _buf;
         CollectionMetadataPtr _collMetadata;
+        shared_ptr<ShardFilter> _shardFilter;
         shared_ptr<ExplainRecordingStrategy> _explain;
         shared_ptr<ResponseBuildStrategy> _builder;
     };
@@ -26,6 +26,9 @@
 #include "mongo/bson/mutable/document.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/index/catalog_hack.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/namespace_details.h"
 #include "mongo/db/ops/update_driver.h"
@@ -47,6 +50,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER( newUpdateFrameworkEnabled, bool, false );
 
+    // Oplog entries a multi-update collects before writing them and offering to yield.  One
+    // or less logs each document as it is updated.
+    MONGO_EXPORT_SERVER_PARAMETER( multiUpdateOplogBatchSize, int, 64 );
+
     bool isNewUpdateFrameworkEnabled() {
         return newUpdateFrameworkEnabled;
     }
@@ -55,6 +62,21 @@ namespace mongo {
         return newUpdateFrameworkEnabled = !newUpdateFrameworkEnabled;
     }
 
+    /**
+     * Returns true if 'from' and 'to' have the same keys in every index of 'd', so that going
+     * from one to the other needs no index changes.  Stops at the first index that differs.
+     */
+    static bool indexKeysUnchanged( NamespaceDetails* d, const BSONObj& from, const BSONObj& to ) {
+        for ( int i = 0; i < d->getTotalIndexCount(); ++i ) {
+            auto_ptr<IndexDescriptor> descriptor( CatalogHack::getDescriptor( d, i ) );
+            auto_ptr<IndexAccessMethod> iam( CatalogHack::getIndex( descriptor.get() ) );
+            if ( !iam->keysEqual( from, to ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void checkNoMods( BSONObj o ) {
         BSONObjIterator i( o );
         while( i.moreWithEOO() ) {
@@ -65,6 +87,74 @@ namespace mongo {
         }
     }
 
+    /**
+     * Holds back the oplog entries of a multi-update so they go out in one logOpBatch()
+     * call.  The write lock must not be released while anything is pending, so the update
+     * flushes before each yield; whatever is left is written on destruction, so the
+     * documents already changed are logged even if the update fails part way.
+     *
+     * The full objects may point into the records updated in place.  That is safe because
+     * nothing else can change those records until the lock is released.
+     */
+    class PendingUpdateLog : boost::noncopyable {
+    public:
+        PendingUpdateLog( const char* ns, bool fromMigrate ) :
+            _ns( ns ),
+            _fromMigrate( fromMigrate ) {
+        }
+
+        ~PendingUpdateLog() {
+            try {
+                flush();
+            }
+            catch ( const DBException& e ) {
+                error() << "failed to log " << _entries.size() << " updates to " << _ns
+                        << ": " << e.toString() << endl;
+            }
+        }
+
+        void add( const BSONObj& logObj, const BSONObj& pattern, const BSONObj& newObj ) {
+            _entries.push_back( LogOpBatchEntry() );
+            LogOpBatchEntry& entry = _entries.back();
+            entry.obj = logObj;
+            entry.pattern = pattern;
+            entry.fullObj = newObj;
+        }
+
+        size_t size() const { return _entries.size(); }
+
+        void flush() {
+            if ( _entries.empty() ) {
+                return;
+            }
+            logOpBatch( "u", _ns, _entries, _fromMigrate );
+            _entries.clear();
+        }
+
+    private:
+        const char* _ns;
+        const bool _fromMigrate;
+        std::vector<LogOpBatchEntry> _entries;
+    };
+
+    /**
+     * Writes the in place changes 'damages' of a mutable document, whose bytes are at
+     * 'source', into the record 'onDisk' points at, through the journal.
+     */
+    static void applyDamages( const BSONObj& onDisk,
+                              const char* source,
+                              const mutablebson::DamageVector& damages ) {
+        mutablebson::DamageVector::const_iterator where = damages.begin();
+        const mutablebson::DamageVector::const_iterator end = damages.end();
+        for( ; where != end; ++where ) {
+            const char* sourcePtr = source + where->sourceOffset;
+            void* targetPtr = getDur().writingPtr(
+                const_cast<char*>(onDisk.objdata()) + where->targetOffset,
+                where->size);
+            std::memcpy(targetPtr, sourcePtr, where->size);
+        }
+    }
+
     static void checkTooLarge(const BSONObj& newObj) {
         uassert( 12522 , "$ operator made object too large" , newObj.objsize() <= BSONObjMaxUserSize );
     }
@@ -237,6 +327,11 @@ namespace mongo {
             set<DiskLoc> seenObjects;
             MatchDetails details;
             auto_ptr<ClientCursor> cc;
+
+            const size_t oplogBatchSize = multi && logop && multiUpdateOplogBatchSize > 1 ?
+                                          multiUpdateOplogBatchSize : 0;
+            PendingUpdateLog pendingLog( ns, fromMigrate );
+
             do {
 
                 if ( cc.get() == 0 &&
@@ -248,13 +343,22 @@ namespace mongo {
 
                 bool atomic = c->matcher() && c->matcher()->docMatcher().atomic();
 
-                if ( ! atomic && debug.nscanned > 0 ) {
+                // With oplog entries pending, only offer to yield once the batch is full or
+                // the next record would fault, and write the batch out first.
+                const bool mayYield = 0 == pendingLog.size() ||
+                                      pendingLog.size() >= oplogBatchSize ||
+                                      ( ! c->currLoc().isNull() &&
+                                        ! c->currLoc().rec()->likelyInPhysicalMemory() );
+
+                if ( ! atomic && debug.nscanned > 0 && mayYield ) {
                     // we need to use a ClientCursor to yield
                     if ( cc.get() == 0 ) {
                         shared_ptr< Cursor > cPtr = c;
                         cc.reset( new ClientCursor( QueryOption_NoCursorTimeout , cPtr , ns ) );
                     }
 
+                    pendingLog.flush();
+
                     bool didYield;
                     if ( ! cc->yieldSometimes( ClientCursor::WillNeed, &didYield ) ) {
                         cc.release();
@@ -414,7 +518,12 @@ namespace mongo {
                         // this record", which is not what we want. Therefore, to get a no-op
                         // in the replica, we simply don't log.
                         if ( logObj.nFields() ) {
-                            logOp("u", ns, logObj , &pattern, 0, fromMigrate, &newObj );
+                            if ( oplogBatchSize ) {
+                                pendingLog.add( logObj, pattern, newObj );
+                            }
+                            else {
+                                logOp("u", ns, logObj , &pattern, 0, fromMigrate, &newObj );
+                            }
                         }
                     }
                     numModded++;
@@ -439,6 +548,8 @@ namespace mongo {
                 }
                 return UpdateResult( 1 , 0 , 1 , BSONObj() );
             } while ( c->ok() );
+
+            pendingLog.flush();
         } // endif
 
         if ( numModded )
@@ -481,6 +592,78 @@ namespace mongo {
         }
     }
 
+    /**
+     * Hands out an UpdateDriver for 'updateExpr' from the collection's cache, or a new one to
+     * be parsed, and puts it back in the cache on destruction if it parsed.  Object
+     * replacements are never cached, since their expression is a whole document.
+     *
+     * The update must not yield while this is alive: 'nsdt' must stay valid.
+     */
+    class CachedUpdateDriver : boost::noncopyable {
+    public:
+        CachedUpdateDriver( NamespaceDetailsTransient* nsdt,
+                            const BSONObj& updateExpr,
+                            const UpdateDriver::Options& opts ) :
+            _nsdt( nsdt ),
+            _updateExpr( updateExpr ),
+            _generation( 0 ),
+            _parsed( false ),
+            _cacheable( false ) {
+
+            if ( *updateExpr.firstElementFieldName() == '$' ) {
+                _driver.reset( _nsdt->updateDriverCache().take( updateExpr,
+                                                                &_generation,
+                                                                &_updateExpr ) );
+                if ( !_driver.get() ) {
+                    // The modifiers may point into what they parse, so a driver that is
+                    // going to be cached must parse a copy it can keep.
+                    _updateExpr = updateExpr.getOwned();
+                }
+            }
+
+            if ( _driver.get() ) {
+                _driver->setMulti( opts.multi );
+                _driver->setUpsert( opts.upsert );
+                _driver->setLogOp( opts.logOp );
+                _parsed = true;
+                _cacheable = true;
+            }
+            else {
+                _driver.reset( new UpdateDriver( opts ) );
+            }
+        }
+
+        ~CachedUpdateDriver() {
+            if ( _cacheable ) {
+                _nsdt->updateDriverCache().put( _updateExpr, _generation, _driver.release() );
+            }
+        }
+
+        /** Parses the update expression unless the driver came from the cache. */
+        Status parse( const IndexPathSet& indexedFields ) {
+            if ( _parsed ) {
+                return Status::OK();
+            }
+
+            Status status = _driver->parse( indexedFields, _updateExpr );
+            if ( status.isOK() ) {
+                _parsed = true;
+                _cacheable = _driver->dollarModMode();
+            }
+            return status;
+        }
+
+        UpdateDriver& get() { return *_driver; }
+
+    private:
+        NamespaceDetailsTransient* const _nsdt;
+        BSONObj _updateExpr;
+        unsigned _generation;
+        bool _parsed;
+        bool _cacheable;
+        auto_ptr<UpdateDriver> _driver;
+    };
+
     UpdateResult _updateObjectsNEW( bool su,
                                     const char* ns,
                                     const BSONObj& updateobj,
@@ -520,11 +703,12 @@ namespace mongo {
         opts.multi = multi;
         opts.upsert = upsert;
         opts.logOp = logop;
-        UpdateDriver driver( opts );
-        Status status = driver.parse( nsdt->indexKeys(), updateobj );
+        CachedUpdateDriver cachedDriver( nsdt, updateobj, opts );
+        Status status = cachedDriver.parse( nsdt->indexKeys() );
         if ( !status.isOK() ) {
             uasserted( 16840, status.reason() );
         }
+        UpdateDriver& driver = cachedDriver.get();
 
         shared_ptr<Cursor> cursor = getOptimizedCursor( ns, patternOrig, BSONObj(), planPolicy );
 
@@ -552,6 +736,7 @@ namespace mongo {
         // cursors and some of them do not deduplicate the entries they generate. We have
         // deduping logic in here, too -- for now.
         unordered_set<DiskLoc, DiskLoc::Hasher> seenLocs;
+        mutablebson::Document doc;
         int numUpdated = 0;
         debug.nscanned = 0;
         while ( cursor->ok() ) {
@@ -628,7 +813,7 @@ namespace mongo {
             // place", that is, some values of the old document just get adjusted without any
             // change to the binary layout on the bson layer. It may be that a whole new
             // document is needed to accomodate the new bson layout of the resulting document.
-            mutablebson::Document doc( oldObj, mutablebson::Document::kInPlaceEnabled );
+            doc.reset( oldObj, mutablebson::Document::kInPlaceEnabled );
             BSONObj logObj;
             StringData matchedField = matchDetails.hasElemMatchKey() ?
                                                     matchDetails.elemMatchKey():
@@ -648,30 +833,33 @@ namespace mongo {
             // This code flow is admittedly odd. But, right now, journaling is baked in the file
             // manager. And if we aren't using the file manager, we have to do jounaling
             // ourselves.
+            //
+            // Mods that touch indexed fields often leave the index keys as they were, e.g. a
+            // $set of a sub-document whose indexed field keeps its value. We build the new
+            // document to check, and still go in place if no index key changed.
             BSONObj newObj;
             const char* source = NULL;
             mutablebson::DamageVector damages;
             bool inPlace = doc.getInPlaceUpdates(&damages, &source);
-            if ( inPlace && !driver.modsAffectIndices() ) {
+            if ( inPlace && driver.modsAffectIndices() ) {
+                newObj = doc.getObject();
+                inPlace = indexKeysUnchanged( d, oldObj, newObj );
+            }
+
+            if ( inPlace ) {
                 d->paddingFits();
 
                 // All updates were in place. Apply them via durability and writing pointer.
-                mutablebson::DamageVector::const_iterator where = damages.begin();
-                const mutablebson::DamageVector::const_iterator end = damages.end();
-                for( ; where != end; ++where ) {
-                    const char* sourcePtr = source + where->sourceOffset;
-                    void* targetPtr = getDur().writingPtr(
-                        const_cast<char*>(oldObj.objdata()) + where->targetOffset,
-                        where->size);
-                    std::memcpy(targetPtr, sourcePtr, where->size);
-                }
+                applyDamages( oldObj, source, damages );
                 newObj = oldObj;
                 debug.fastmod = true;
             }
             else {
 
                 // The updates were not in place. Apply them through the file manager.
-                newObj = doc.getObject();
+                if ( newObj.isEmpty() ) {
+                    newObj = doc.getObject();
+                }
                 DiskLoc newLoc = theDataFileMgr.updateRecord(ns,
                                                              d,
                                                              nsdt,
@@ -755,7 +943,7 @@ namespace mongo {
         driver.setLogOp( false );
         driver.setContext( ModifierInterface::ExecInfo::INSERT_CONTEXT );
 
-        mutablebson::Document doc( oldObj, mutablebson::Document::kInPlaceDisabled );
+        doc.reset( oldObj, mutablebson::Document::kInPlaceDisabled );
         status = driver.update( StringData(), &doc, NULL /* no oplog record */);
         if ( !status.isOK() ) {
             uasserted( 16836, status.reason() );
@@ -854,6 +1042,125 @@ namespace mongo {
         }
     }
 
+    UpdateResult updateObjectAt( const char* ns,
+                                 const DiskLoc& loc,
+                                 const BSONObj& updateobj,
+                                 const BSONObj& pattern,
+                                 const StringData& elemMatchKey,
+                                 bool logop,
+                                 OpDebug& debug,
+                                 BSONObj* newObj ) {
+
+        validateUpdate( ns , updateobj , pattern );
+
+        debug.updateobj = updateobj;
+
+        NamespaceDetails* d = nsdetails( ns );
+        NamespaceDetailsTransient* nsdt = &NamespaceDetailsTransient::get( ns );
+        Record* r = loc.rec();
+        const BSONObj oldObj = loc.obj();
+        bool isOperatorUpdate = updateobj.firstElementFieldName()[0] == '$';
+
+        // Either the mods went into the record already, or 'built' is the new document.
+        bool inPlace = false;
+        BSONObj built;
+        BSONObj logObj;
+
+        if ( isNewUpdateFrameworkEnabled() ) {
+            UpdateDriver::Options opts;
+            opts.logOp = logop;
+            CachedUpdateDriver cachedDriver( nsdt, updateobj, opts );
+            Status status = cachedDriver.parse( nsdt->indexKeys() );
+            if ( !status.isOK() ) {
+                uasserted( 16840, status.reason() );
+            }
+            UpdateDriver& driver = cachedDriver.get();
+            driver.setContext( ModifierInterface::ExecInfo::UPDATE_CONTEXT );
+            isOperatorUpdate = driver.dollarModMode();
+
+            mutablebson::Document doc( oldObj, mutablebson::Document::kInPlaceEnabled );
+            status = driver.update( elemMatchKey, &doc, &logObj );
+            if ( !status.isOK() ) {
+                uasserted( 16837, status.reason() );
+            }
+
+            const char* source = NULL;
+            mutablebson::DamageVector damages;
+            inPlace = doc.getInPlaceUpdates( &damages, &source );
+            if ( inPlace && driver.modsAffectIndices() ) {
+                built = doc.getObject();
+                inPlace = indexKeysUnchanged( d, oldObj, built );
+            }
+
+            if ( inPlace ) {
+                applyDamages( oldObj, source, damages );
+            }
+            else if ( built.isEmpty() ) {
+                built = doc.getObject();
+            }
+        }
+        else if ( isOperatorUpdate ) {
+            ModSet mods( updateobj, nsdt->indexKeys() );
+            ModSet* useMods = &mods;
+
+            auto_ptr<ModSet> mymodset;
+            if ( !elemMatchKey.empty() && mods.hasDynamicArray() ) {
+                useMods = mods.fixDynamicArray( elemMatchKey.toString() );
+                mymodset.reset( useMods );
+            }
+
+            auto_ptr<ModSetState> mss = useMods->prepare( oldObj, false /* not an insertion */ );
+
+            // "system.users" updates must go through DataFileMgr::updateRecord(.), which
+            // validates them.
+            bool isSystemUsersMod = nsToCollectionSubstring(ns) == "system.users";
+
+            if ( !mss->isUpdateIndexed() && mss->canApplyInPlace() && !isSystemUsersMod ) {
+                mss->applyModsInPlace( true );
+                inPlace = true;
+            }
+            else {
+                built = mss->createNewFromMods();
+                checkTooLarge( built );
+            }
+            logObj = mss->getOpLogRewrite();
+        }
+        else {
+            BSONElementManipulator::lookForTimestamps( updateobj );
+            checkNoMods( updateobj );
+            built = updateobj;
+            logObj = updateobj;
+        }
+
+        DiskLoc newLoc = loc;
+        if ( inPlace ) {
+            d->paddingFits();
+            debug.fastmod = true;
+        }
+        else {
+            newLoc = theDataFileMgr.updateRecord( ns,
+                                                  d,
+                                                  nsdt,
+                                                  r,
+                                                  loc,
+                                                  built.objdata(),
+                                                  built.objsize(),
+                                                  debug );
+        }
+
+        // The record may have moved, and an _id the replacement left out was put back.
+        *newObj = newLoc.obj();
+
+        // A mod set that changed nothing has nothing to log; see _updateObjects().
+        if ( logop && logObj.nFields() ) {
+            BSONObj logPattern = pattern;
+            logOp( "u", ns, logObj, &logPattern, 0, false, newObj );
+        }
+
+        debug.nupdated = 1;
+        return UpdateResult( 1 , isOperatorUpdate , 1 , BSONObj() );
+    }
+
     BSONObj applyUpdateOperators( const BSONObj& from, const BSONObj& operators ) {
         if ( isNewUpdateFrameworkEnabled() ) {
             UpdateDriver::Options opts;
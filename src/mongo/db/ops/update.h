@@ -20,6 +20,7 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/diskloc.h"
 #include "mongo/db/query_plan_selection_policy.h"
 
 namespace mongo {
@@ -109,6 +110,25 @@ namespace mongo {
                                        = QueryPlanSelectionPolicy::any(),
                                    bool forReplication = false);
 
+    /**
+     * Applies 'updateobj' to the one document at 'loc', which the caller found matching its
+     * query without releasing the write lock since.  The document is changed in place when
+     * the mods leave it room.  'elemMatchKey' is the array position a positional ($) operator
+     * stands for, if any, and 'pattern' is the query the update is logged with.  Sets
+     * *newObj to the updated document, which may point into the record.
+     *
+     * Unlike updateObjects() this doesn't look the document up again, so findAndModify can
+     * locate, update and return a document in one pass.
+     */
+    UpdateResult updateObjectAt(const char* ns,
+                                const DiskLoc& loc,
+                                const BSONObj& updateobj,
+                                const BSONObj& pattern,
+                                const StringData& elemMatchKey,
+                                bool logop,
+                                OpDebug& debug,
+                                BSONObj* newObj);
+
     /**
      * takes the from document and returns a new document
      * after apply all the operators 
@@ -168,12 +168,11 @@ namespace mongo {
         FieldRefSet targetFields;
         _affectIndices = false;
 
-        // TODO: Should logBuilder own the document? Should we hold it by pointer to avoid
-        // creating it if we are not interested in logging? Or maybe by boost optional? For
-        // now, it is logically harmless to construct this and not use it, but a Document
-        // object isn't cheap, so we should avoid building it if we can.
-        mutablebson::Document logDoc;
-        LogBuilder logBuilder(logDoc.root());
+        // A Document isn't cheap to build, so we keep one for the log records and reset it
+        // for each update, reusing its storage across all the documents of a multi-update
+        // and across the operations a cached driver serves.
+        _logDoc.reset();
+        LogBuilder logBuilder(_logDoc.root());
 
         // Ask each of the mods to type check whether they can operate over the current document
         // and, if so, to change that document accordingly.
@@ -210,10 +209,10 @@ namespace mongo {
                                       << "' at the same time");
                 }
 
-                // We start with the expectation that a mod will be in-place. But if the mod
-                // touched an indexed field and the mod will indeed be executed -- that is, it
-                // is not a no-op and it is in a valid context -- then we switch back to a
-                // non-in-place mode.
+                // Note whether the mod touched an indexed field and will indeed be executed --
+                // that is, it is not a no-op and it is in a valid context.  In-place updates
+                // stay enabled: the caller compares the index keys before and after to see
+                // whether it can still apply the update in place.
                 //
                 // TODO: make mightBeIndexed and fieldRef like each other.
                 if (!_affectIndices &&
@@ -221,7 +220,6 @@ namespace mongo {
                     validContext &&
                     _indexedFields.mightBeIndexed(execInfo.fieldRef[i]->dottedField())) {
                     _affectIndices = true;
-                    doc->disableInPlaceUpdates();
                 }
             }
 
@@ -243,7 +241,7 @@ namespace mongo {
         }
 
         if (_logOp && logOpRec)
-            *logOpRec = logDoc.getObject();
+            *logOpRec = _logDoc.getObject();
 
         return Status::OK();
     }
@@ -296,6 +294,7 @@ namespace mongo {
         for (vector<ModifierInterface*>::iterator it = _mods.begin(); it != _mods.end(); ++it) {
             delete *it;
         }
+        _mods.clear();
         _indexedFields.clear();
         _dollarModMode = false;
     }
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/bson/mutable/document.h"
 #include "mongo/db/index_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/ops/modifier_interface.h"
@@ -123,6 +124,9 @@ namespace mongo {
 
         // Is this update going to be an upsert?
         ModifierInterface::ExecInfo::UpdateContext _context;
+
+        // Scratch document for the oplog record built by update().
+        mutablebson::Document _logDoc;
     };
 
     struct UpdateDriver::Options {
@@ -0,0 +1,105 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/db/ops/update_driver_cache.h"
+
+#include "mongo/db/ops/update_driver.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    const size_t UpdateDriverCache::kMaxEntries;
+
+    namespace {
+
+        // Generations are unique across caches, so a driver can't be put back into the cache
+        // of a collection that was dropped and recreated while it was out.
+        AtomicUInt32 nextGeneration;
+
+    }  // namespace
+
+    UpdateDriverCache::UpdateDriverCache()
+        : _mutex("UpdateDriverCache")
+        , _generation(nextGeneration.addAndFetch(1)) {
+    }
+
+    UpdateDriverCache::~UpdateDriverCache() {
+        _clear_inlock();
+    }
+
+    UpdateDriver* UpdateDriverCache::take(const BSONObj& updateExpr, unsigned* generation,
+                                          BSONObj* parsedExpr) {
+        SimpleMutex::scoped_lock lk(_mutex);
+        *generation = _generation;
+
+        for (EntryList::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->first.binaryEqual(updateExpr)) {
+                *parsedExpr = it->first;
+                UpdateDriver* driver = it->second;
+                _entries.erase(it);
+                return driver;
+            }
+        }
+        return NULL;
+    }
+
+    void UpdateDriverCache::put(const BSONObj& parsedExpr, unsigned generation,
+                                UpdateDriver* driver) {
+        dassert(parsedExpr.isOwned());
+
+        SimpleMutex::scoped_lock lk(_mutex);
+        if (generation != _generation) {
+            delete driver;
+            return;
+        }
+
+        // Another user of the same expression may have put its driver back first.
+        for (EntryList::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            if (it->first.binaryEqual(parsedExpr)) {
+                delete it->second;
+                _entries.erase(it);
+                break;
+            }
+        }
+
+        if (_entries.size() >= kMaxEntries) {
+            delete _entries.back().second;
+            _entries.pop_back();
+        }
+
+        _entries.push_front(Entry(parsedExpr, driver));
+    }
+
+    void UpdateDriverCache::clear() {
+        SimpleMutex::scoped_lock lk(_mutex);
+        _clear_inlock();
+        _generation = nextGeneration.addAndFetch(1);
+    }
+
+    size_t UpdateDriverCache::size() const {
+        SimpleMutex::scoped_lock lk(_mutex);
+        return _entries.size();
+    }
+
+    void UpdateDriverCache::_clear_inlock() {
+        for (EntryList::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            delete it->second;
+        }
+        _entries.clear();
+    }
+
+}  // namespace mongo
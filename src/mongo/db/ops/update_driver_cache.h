@@ -0,0 +1,89 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <list>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class UpdateDriver;
+
+    /**
+     * Per collection cache of UpdateDrivers that have already parsed a $mod style update
+     * expression, so an application sending the same update over and over doesn't rebuild
+     * its modifiers each time.
+     *
+     * Entries are keyed on the exact bytes of the update expression.  Modifiers check and
+     * copy their arguments in init(), and not all of them can be initialized twice, so a
+     * cached driver can't be rebound to new values; only repeats of the same expression hit.
+     *
+     * A driver is taken out of the cache while in use and put back afterwards, so no driver is
+     * ever shared.  clear() is called when the collection's indexes change; drivers taken
+     * before that are deleted instead of cached when they come back, since they may have been
+     * parsed against the old index keys.
+     *
+     * All methods are thread safe.
+     */
+    class UpdateDriverCache {
+        MONGO_DISALLOW_COPYING(UpdateDriverCache);
+    public:
+        // Most cached drivers per collection.
+        static const size_t kMaxEntries = 32;
+
+        UpdateDriverCache();
+        ~UpdateDriverCache();
+
+        /**
+         * Removes and returns a driver that parsed 'updateExpr', or returns NULL if there is
+         * none.  On a hit, sets '*parsedExpr' to the owned copy of 'updateExpr' the driver
+         * parsed.  Either way sets '*generation', which must be passed back to put().
+         */
+        UpdateDriver* take(const BSONObj& updateExpr, unsigned* generation, BSONObj* parsedExpr);
+
+        /**
+         * Caches 'driver', which parsed 'parsedExpr' successfully, and takes ownership of it.
+         * 'parsedExpr' must be owned, since modifiers may point into the expression they
+         * parsed; the cache keeps it alive as long as the driver.  Evicts the least recently
+         * put driver if the cache is full.
+         */
+        void put(const BSONObj& parsedExpr, unsigned generation, UpdateDriver* driver);
+
+        void clear();
+
+        size_t size() const;
+
+    private:
+        typedef std::pair<BSONObj, UpdateDriver*> Entry;
+        typedef std::list<Entry> EntryList;
+
+        void _clear_inlock();
+
+        mutable SimpleMutex _mutex;
+
+        // Most recently put first.
+        EntryList _entries;
+
+        // Changes on every clear() so drivers taken before it aren't put back.
+        unsigned _generation;
+    };
+
+}  // namespace mongo
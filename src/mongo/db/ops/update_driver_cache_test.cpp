@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * This file contains tests for mongo/db/ops/update_driver_cache.cpp
+ */
+
+#include "mongo/db/ops/update_driver_cache.h"
+
+#include "mongo/db/index_set.h"
+#include "mongo/db/json.h"
+#include "mongo/db/ops/update_driver.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using mongo::BSONObj;
+    using mongo::fromjson;
+    using mongo::IndexPathSet;
+    using mongo::UpdateDriver;
+    using mongo::UpdateDriverCache;
+
+    UpdateDriver* parsed(const BSONObj& updateExpr) {
+        UpdateDriver* driver = new UpdateDriver(UpdateDriver::Options());
+        ASSERT_OK(driver->parse(IndexPathSet(), updateExpr));
+        return driver;
+    }
+
+    TEST(UpdateDriverCache, TakeAndPut) {
+        UpdateDriverCache cache;
+        const BSONObj expr = fromjson("{$inc: {a: 1}, $set: {b: 2}}");
+
+        unsigned generation;
+        BSONObj parsedExpr;
+        ASSERT_TRUE(NULL == cache.take(expr, &generation, &parsedExpr));
+
+        UpdateDriver* driver = parsed(expr);
+        cache.put(expr, generation, driver);
+        ASSERT_EQUALS(1U, cache.size());
+
+        // Different values are a different key.
+        ASSERT_TRUE(NULL == cache.take(fromjson("{$inc: {a: 2}, $set: {b: 2}}"), &generation,
+                                       &parsedExpr));
+
+        // A driver is handed out to one user at a time.
+        ASSERT_EQUALS(driver, cache.take(expr, &generation, &parsedExpr));
+        ASSERT_TRUE(parsedExpr.binaryEqual(expr));
+        ASSERT_EQUALS(0U, cache.size());
+        ASSERT_TRUE(NULL == cache.take(expr, &generation, &parsedExpr));
+
+        cache.put(expr, generation, driver);
+        ASSERT_EQUALS(1U, cache.size());
+    }
+
+    TEST(UpdateDriverCache, SameExpressionPutTwice) {
+        UpdateDriverCache cache;
+        const BSONObj expr = fromjson("{$set: {a: 1}}");
+
+        unsigned generation;
+        BSONObj parsedExpr;
+        ASSERT_TRUE(NULL == cache.take(expr, &generation, &parsedExpr));
+        cache.put(expr, generation, parsed(expr));
+        cache.put(expr, generation, parsed(expr));
+        ASSERT_EQUALS(1U, cache.size());
+    }
+
+    TEST(UpdateDriverCache, ClearedCacheRejectsDriversTakenBefore) {
+        UpdateDriverCache cache;
+        const BSONObj expr = fromjson("{$set: {a: 1}}");
+
+        unsigned generation;
+        BSONObj parsedExpr;
+        ASSERT_TRUE(NULL == cache.take(expr, &generation, &parsedExpr));
+        cache.clear();
+        cache.put(expr, generation, parsed(expr));
+        ASSERT_EQUALS(0U, cache.size());
+
+        // Nor can they go into another cache.
+        UpdateDriverCache other;
+        other.put(expr, generation, parsed(expr));
+        ASSERT_EQUALS(0U, other.size());
+    }
+
+    TEST(UpdateDriverCache, EvictsOldest) {
+        UpdateDriverCache cache;
+        unsigned generation;
+        BSONObj parsedExpr;
+        for (size_t i = 0; i <= UpdateDriverCache::kMaxEntries; ++i) {
+            const BSONObj expr = BSON("$set" << BSON("a" << static_cast<int>(i)));
+            ASSERT_TRUE(NULL == cache.take(expr, &generation, &parsedExpr));
+            cache.put(expr, generation, parsed(expr));
+        }
+
+        ASSERT_EQUALS(UpdateDriverCache::kMaxEntries, cache.size());
+        UpdateDriver* driver =
+            cache.take(BSON("$set" << BSON("a" << 0)), &generation, &parsedExpr);
+        ASSERT_TRUE(NULL == driver);
+        driver = cache.take(BSON("$set" << BSON("a" << 1)), &generation, &parsedExpr);
+        ASSERT_TRUE(NULL != driver);
+        delete driver;
+    }
+
+} // namespace
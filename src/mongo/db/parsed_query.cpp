@@ -109,6 +109,7 @@ namespace mongo {
         _returnKey = false;
         _showDiskLoc = false;
         _maxScan = 0;
+        _maxTimeMS = 0;
     }
 
     /* This is for languages whose "objects" are not well ordered (JSON is well ordered).
@@ -170,6 +171,11 @@ namespace mongo {
                     _returnKey = e.trueValue();
                 else if ( strcmp( "maxScan" , name ) == 0 )
                     _maxScan = e.numberInt();
+                else if ( strcmp( "maxTimeMS" , name ) == 0 ) {
+                    uassert( 17040 , "$maxTimeMS must be a non-negative number" ,
+                             e.isNumber() && e.numberInt() >= 0 );
+                    _maxTimeMS = e.numberInt();
+                }
                 else if ( strcmp( "showDiskLoc" , name ) == 0 )
                     _showDiskLoc = e.trueValue();
                 else if ( strcmp( "comment" , name ) == 0 ) {
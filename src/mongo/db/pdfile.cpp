@@ -40,6 +40,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/pdfile_private.h"
 #include "mongo/db/background.h"
 #include "mongo/db/btree.h"
+#include "mongo/db/capped_insert_notifier.h"
 #include "mongo/db/cloner.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop-inl.h"
@@ -61,6 +62,7 @@ _ disallow system* manipulations from the database.
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/sort_phase_one.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/file.h"
 #include "mongo/util/file_allocator.h"
@@ -390,6 +392,8 @@ namespace mongo {
                 // the minimum extent size is 4097
                 high = Extent::minSize() + 1;
             }
+            // with separate index files, index and data extents don't mix
+            const bool wantIndexFile = !NamespaceString::normal( ns );
             int n = 0;
             Extent *best = 0;
             int bestDiff = 0x7fffffff;
@@ -398,7 +402,9 @@ namespace mongo {
                 DiskLoc L = f->firstExtent();
                 while( !L.isNull() ) {
                     Extent * e = L.ext();
-                    if( e->length >= low && e->length <= high ) {
+                    if( e->length >= low && e->length <= high &&
+                        ( !separateIndexFiles ||
+                          ExtentManager::isIndexFile( L.a() ) == wantIndexFile ) ) {
                         int diff = abs(e->length - approxSize);
                         if( diff < bestDiff ) {
                             bestDiff = diff;
@@ -772,6 +778,15 @@ namespace mongo {
     Counter64 moveCounter;
     ServerStatusMetricField<Counter64> moveCounterDisplay( "record.moves", &moveCounter );
 
+    // Pads new records by how much records of their size have grown on update in the same
+    // collection; see RecordGrowthModel.  Not used for capped or power of 2 collections.
+    MONGO_EXPORT_SERVER_PARAMETER(adaptivePaddingEnabled, bool, false);
+
+    // Bytes of slack the growth model added on top of the padding factor.
+    Counter64 adaptivePaddingCounter;
+    ServerStatusMetricField<Counter64> adaptivePaddingDisplay( "record.adaptivePaddingBytes",
+                                                               &adaptivePaddingCounter );
+
     /** Note: if the object shrinks a lot, we don't free up space, we leave extra at end of the record.
      */
     const DiskLoc DataFileMgr::updateRecord(
@@ -831,6 +846,10 @@ namespace mongo {
             }
         }
 
+        if ( adaptivePaddingEnabled ) {
+            nsdt->growthModel().noteUpdate( objOld.objsize(), objNew.objsize() );
+        }
+
         if ( toupdate->netLength() < objNew.objsize() ) {
             // doesn't fit.  reallocate -----------------------------------------------------
             moveCounter.increment();
@@ -950,9 +969,11 @@ namespace mongo {
 
     /** @param o the object to insert. can be modified to add _id and thus be an in/out param
      */
-    DiskLoc DataFileMgr::insertWithObjMod(const char* ns, BSONObj& o, bool mayInterrupt, bool god) {
+    DiskLoc DataFileMgr::insertWithObjMod(const char* ns, BSONObj& o, bool mayInterrupt, bool god,
+                                          bool addToIndexes) {
         bool addedID = false;
-        DiskLoc loc = insert( ns, o.objdata(), o.objsize(), mayInterrupt, god, true, &addedID );
+        DiskLoc loc = insert( ns, o.objdata(), o.objsize(), mayInterrupt, god, true, &addedID,
+                              addToIndexes );
         if( addedID && !loc.isNull() )
             o = BSONObj::make( loc.rec() );
         return loc;
@@ -1207,7 +1228,8 @@ namespace mongo {
                                 bool mayInterrupt,
                                 bool god,
                                 bool mayAddIndex,
-                                bool* addedID) {
+                                bool* addedID,
+                                bool addToIndexes) {
         bool wouldAddIndex = false;
         massert( 10093 , "cannot insert into reserved $ collection", god || NamespaceString::normal( ns ) );
         uassert( 10094 , str::stream() << "invalid ns: " << ns , isValidNS( ns ) );
@@ -1274,6 +1296,17 @@ namespace mongo {
         int lenWHdr = d->getRecordAllocationSize( len + Record::HeaderSize );
         fassert( 16440, lenWHdr >= ( len + Record::HeaderSize ) );
 
+        if ( adaptivePaddingEnabled &&
+             !d->isCapped() &&
+             !d->isUserFlagSet( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
+            const int adaptive = NamespaceDetailsTransient::get( ns ).growthModel()
+                .allocationSize( len + Record::HeaderSize );
+            if ( adaptive > lenWHdr ) {
+                adaptivePaddingCounter.increment( adaptive - lenWHdr );
+                lenWHdr = adaptive;
+            }
+        }
+
         // If the collection is capped, check if the new object will violate a unique index
         // constraint before allocating space.
         if (d->getCompletedIndexCount() &&
@@ -1313,15 +1346,21 @@ namespace mongo {
         d->incrementStats( r->netLength(), 1 );
 
         // we don't bother resetting query optimizer stats for the god tables - also god is true when adding a btree bucket
-        if ( !god )
-            NamespaceDetailsTransient::get( ns ).notifyOfWriteOp();
+        if ( !god ) {
+            NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get( ns );
+            nsdt.notifyOfWriteOp();
+            nsdt.notifyOfInsert();
+        }
 
         if ( tableToIndex ) {
             insert_makeIndex(tableToIndex, tabletoidxns, loc, mayInterrupt);
         }
 
         /* add this record to our indexes */
-        if ( d->getTotalIndexCount() > 0 ) {
+        if ( !addToIndexes ) {
+            verify( !tableToIndex && !d->isCapped() );
+        }
+        else if ( d->getTotalIndexCount() > 0 ) {
             try {
                 BSONObj obj(r->data());
                 indexRecord(ns, d, obj, loc);
@@ -1345,6 +1384,9 @@ namespace mongo {
 
         d->paddingFits();
 
+        if ( d->isCapped() )
+            CappedInsertNotifier::notifyOfInsert( ns );
+
         return loc;
     }
 
@@ -1398,6 +1440,74 @@ namespace mongo {
         return r;
     }
 
+    void DataFileMgr::fast_oplog_insert_batch(NamespaceDetails *d, const char *ns,
+                                              const vector<int>& lens, vector<char*>* data) {
+        verify( d );
+        verify( !lens.empty() );
+        DEV verify( d == nsdetails(ns) );
+
+        massert( 16509,
+                 str::stream()
+                 << "fast_oplog_insert requires a capped collection "
+                 << " but " << ns << " is not capped",
+                 d->isCapped() );
+
+        boost::optional<TimerHolder> insertTimer;
+        if (NamespaceString::oplog(ns)) {
+            insertTimer = boost::in_place(&oplogInsertStats);
+        }
+
+        // alloc() rounds the same way, so the region comes back exactly this long
+        int total = 0;
+        for ( size_t i = 0; i < lens.size(); i++ ) {
+            total += ( lens[i] + Record::HeaderSize + 3 ) & 0xfffffffc;
+            if (insertTimer)
+                oplogInsertBytesStats.increment(lens[i]);
+        }
+
+        DiskLoc loc = d->alloc(ns, total);
+        verify( !loc.isNull() );
+
+        Record *region = loc.rec();
+        const int regionLen = region->lengthWithHeaders();
+        verify( regionLen >= total );
+        const int extentOfs = region->extentOfs();
+        Extent *e = region->myExtent(loc);
+
+        int prevOfs = DiskLoc::NullOfs;
+        if ( e->lastRecord.isNull() ) {
+            Extent::FL *fl = getDur().writing( e->fl() );
+            fl->firstRecord = loc;
+        }
+        else {
+            prevOfs = e->lastRecord.getOfs();
+            getDur().writingInt( e->lastRecord.rec()->nextOfs() ) = loc.getOfs();
+        }
+
+        char *p = static_cast<char*>( getDur().writingPtr( region, regionLen ) );
+        long long netLength = 0;
+        int off = 0;
+        for ( size_t i = 0; i < lens.size(); i++ ) {
+            const bool last = i + 1 == lens.size();
+            const int lenWHdr = last ? regionLen - off
+                                     : ( lens[i] + Record::HeaderSize + 3 ) & 0xfffffffc;
+            Record *r = reinterpret_cast<Record*>( p + off );
+            r->lengthWithHeaders() = lenWHdr;
+            r->extentOfs() = extentOfs;
+            r->prevOfs() = prevOfs;
+            r->nextOfs() = last ? DiskLoc::NullOfs : loc.getOfs() + off + lenWHdr;
+            data->push_back( r->data() );
+            netLength += r->netLength();
+
+            prevOfs = loc.getOfs() + off;
+            off += lenWHdr;
+        }
+
+        getDur().writingDiskLoc( e->lastRecord ) = DiskLoc( loc.a(), prevOfs );
+
+        d->incrementStats( netLength, lens.size() );
+    }
+
 } // namespace mongo
 
 #include "clientcursor.h"
@@ -1482,23 +1592,37 @@ namespace mongo {
     // move temp files to standard data dir
     void _replaceWithRecovered( const char *database, const char *reservedPathString ) {
         Path newPath( dbpath );
-        if ( directoryperdb )
+        Path indexPath( reservedPathString );
+        if ( directoryperdb ) {
             newPath /= database;
+            indexPath /= database;
+        }
+        indexPath /= ExtentManager::kIndexDirName;
         class Replacer : public FileOp {
         public:
-            Replacer( const Path &newPath ) : newPath_( newPath ) {}
+            Replacer( const Path &newPath, const Path &indexPath )
+                : newPath_( newPath ), indexPath_( indexPath ) {}
         private:
             const boost::filesystem::path &newPath_;
+            const boost::filesystem::path &indexPath_;
             virtual bool apply( const Path &p ) {
                 if ( !boost::filesystem::exists( p ) )
                     return false;
-                boostRenameWrapper( p, newPath_ / p.leaf() );
+                if ( p.branch_path() == indexPath_ ) {
+                    Path dir = newPath_ / ExtentManager::kIndexDirName;
+                    if ( !boost::filesystem::exists( dir ) )
+                        boost::filesystem::create_directory( dir );
+                    boostRenameWrapper( p, dir / p.leaf() );
+                }
+                else {
+                    boostRenameWrapper( p, newPath_ / p.leaf() );
+                }
                 return true;
             }
             virtual const char * op() const {
                 return "renaming";
             }
-        } replacer( newPath );
+        } replacer( newPath, indexPath );
         _applyOpToDataFiles( database, replacer, true, reservedPathString );
     }
 
@@ -1625,28 +1749,16 @@ namespace mongo {
         return true;
     }
 
-    void _applyOpToDataFiles( const char *database, FileOp &fo, bool afterAllocator, const string& path ) {
-        if ( afterAllocator )
-            FileAllocator::get()->waitUntilFinished();
-        string c = database;
-        c += '.';
-        boost::filesystem::path p(path);
-        if ( directoryperdb )
-            p /= database;
-        boost::filesystem::path q;
-        q = p / (c+"ns");
-        bool ok = false;
-        MONGO_ASSERT_ON_EXCEPTION( ok = fo.apply( q ) );
-        if ( ok ) {
-            LOG(2) << fo.op() << " file " << q.string() << endl;
-        }
+    static void _applyOpToFileSeries( const boost::filesystem::path& p, const string& prefix,
+                                      FileOp &fo ) {
         int i = 0;
         int extra = 10; // should not be necessary, this is defensive in case there are missing files
         while ( 1 ) {
             verify( i <= DiskLoc::MaxFiles );
             stringstream ss;
-            ss << c << i;
-            q = p / ss.str();
+            ss << prefix << i;
+            boost::filesystem::path q = p / ss.str();
+            bool ok = false;
             MONGO_ASSERT_ON_EXCEPTION( ok = fo.apply(q) );
             if ( ok ) {
                 if ( extra != 10 ) {
@@ -1660,6 +1772,26 @@ namespace mongo {
         }
     }
 
+    void _applyOpToDataFiles( const char *database, FileOp &fo, bool afterAllocator, const string& path ) {
+        if ( afterAllocator )
+            FileAllocator::get()->waitUntilFinished();
+        string c = database;
+        c += '.';
+        boost::filesystem::path p(path);
+        if ( directoryperdb )
+            p /= database;
+        boost::filesystem::path q;
+        q = p / (c+"ns");
+        bool ok = false;
+        MONGO_ASSERT_ON_EXCEPTION( ok = fo.apply( q ) );
+        if ( ok ) {
+            LOG(2) << fo.op() << " file " << q.string() << endl;
+        }
+        _applyOpToFileSeries( p, c + "ns.", fo ); // extensions of the .ns file
+        _applyOpToFileSeries( p, c, fo );
+        _applyOpToFileSeries( p / ExtentManager::kIndexDirName, c + "idx.", fo );
+    }
+
     NamespaceDetails* nsdetails_notinline(const char *ns) { return nsdetails(ns); }
 
     bool DatabaseHolder::closeAll( const string& path , BSONObjBuilder& result , bool force ) {
@@ -1667,11 +1799,11 @@ namespace mongo {
         verify( Lock::isW() );
         getDur().commitNow(); // bad things happen if we close a DB with outstanding writes
 
-        map<string,Database*>& m = _paths[path];
+        DBs& m = _paths[path];
         _size -= m.size();
 
         set< string > dbs;
-        for ( map<string,Database*>::iterator i = m.begin(); i != m.end(); i++ ) {
+        for ( DBs::const_iterator i = m.begin(); i != m.end(); ++i ) {
             wassert( i->second->path() == path );
             dbs.insert( i->first );
         }
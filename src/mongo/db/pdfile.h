@@ -93,11 +93,13 @@ namespace mongo {
          * note: does NOT put on oplog
          * @param o both and in and out param
          * @param mayInterrupt When true, killop may interrupt the function call.
+         * @param addToIndexes see insert()
          */
         DiskLoc insertWithObjMod(const char* ns,
                                  BSONObj& /*out*/o,
                                  bool mayInterrupt = false,
-                                 bool god = false);
+                                 bool god = false,
+                                 bool addToIndexes = true);
 
         /**
          * Insert the contents of @param buf with length @param len into namespace @param ns.
@@ -109,6 +111,9 @@ namespace mongo {
          *     command.
          * @param addedID if not null, set to true if adding _id element.  You must assure false
          *     before calling if using.
+         * @param addToIndexes if false, the caller must index the record with indexRecordBatch()
+         *     or delete it before giving up the write lock.  Not for system or capped
+         *     collections.
          */
         DiskLoc insert(const char* ns,
                        const void* buf,
@@ -116,7 +121,8 @@ namespace mongo {
                        bool mayInterrupt = false,
                        bool god = false,
                        bool mayAddIndex = true,
-                       bool* addedID = 0);
+                       bool* addedID = 0,
+                       bool addToIndexes = true);
         static shared_ptr<Cursor> findAll(const StringData& ns, const DiskLoc &startLoc = DiskLoc());
 
         /* special version of insert for transaction logging -- streamlined a bit.
@@ -125,6 +131,13 @@ namespace mongo {
         */
         Record* fast_oplog_insert(NamespaceDetails *d, const char *ns, int len);
 
+        /* fast_oplog_insert() for a run of records laid down back to back, out of a single
+           allocation and under a single write intent.  'lens' are the data lengths; 'data'
+           gets where to write each record's data, already declared for writing.
+        */
+        void fast_oplog_insert_batch(NamespaceDetails *d, const char *ns,
+                                     const vector<int>& lens, vector<char*>* data);
+
         static Extent* getExtent(const DiskLoc& dl);
         static Record* getRecord(const DiskLoc& dl);
         static DeletedRecord* getDeletedRecord(const DiskLoc& dl);
@@ -247,6 +260,13 @@ namespace mongo {
          * */
         void touch( bool entireRecrd = false ) const;
 
+        /**
+         * asks the OS to start paging this record in, without blocking on it.  only the page
+         * holding the start of the record is requested; its length isn't read as that could
+         * itself fault.
+         */
+        void prefetch() const;
+
         /**
          * @return if this record is likely in physical memory
          *         its not guaranteed because its possible it gets swapped out in a very unlucky windows
@@ -259,6 +279,12 @@ namespace mongo {
          */
         Record* accessed();
 
+        /**
+         * like accessed(), for a record holding a btree bucket
+         * @return this, for simple chaining
+         */
+        Record* accessedAsIndex();
+
         static bool likelyInPhysicalMemory( const char* data );
 
         /**
@@ -393,7 +419,7 @@ namespace mongo {
     inline 
     const BtreeBucket<V> * DiskLoc::btree() const {
         verify( _a != -1 );
-        Record *r = rec();
+        Record *r = rec()->accessedAsIndex();
         memconcept::is(r, memconcept::concept::btreebucket, "", 8192);
         return (const BtreeBucket<V> *) r->data();
     }
@@ -22,25 +22,30 @@
 namespace mongo {
 
     void AccumulatorSum::processInternal(const Value& input, bool merging) {
-        // do nothing with non numeric types
-        if (!input.numeric())
-            return;
-
-        // upgrade to the widest type required to hold the result
-        totalType = Value::getWidestNumeric(totalType, input.getType());
+        // Switch on the input's own type rather than widening and coercing it, which is most of
+        // the work when every input is of the same numeric type.
+        switch (input.getType()) {
+        case NumberDouble:
+            totalType = NumberDouble;
+            doubleTotal += input.getDouble();
+            break;
 
-        if (totalType == NumberInt || totalType == NumberLong) {
-            long long v = input.coerceToLong();
-            longTotal += v;
-            doubleTotal += v;
-        }
-        else if (totalType == NumberDouble) {
-            double v = input.coerceToDouble();
+        case NumberLong:
+        case NumberInt: {
+            const long long v = input.getLong();
+            if (totalType != NumberDouble) {
+                // upgrade to the widest type required to hold the result
+                if (input.getType() == NumberLong)
+                    totalType = NumberLong;
+                longTotal += v;
+            }
             doubleTotal += v;
+            break;
         }
-        else {
-            // non numerics should have returned above so we should never get here
-            verify(false);
+
+        default:
+            // do nothing with non numeric types
+            return;
         }
 
         count++;
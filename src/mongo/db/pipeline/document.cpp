@@ -22,35 +22,159 @@
 
 #include "mongo/db/jsobj.h"
 #include "mongo/db/pipeline/field_path.h"
+#include "mongo/util/concurrency/threadlocal.h"
 #include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
     using namespace mongoutils;
 
-    Position DocumentStorage::findField(StringData requested) const {
-        int reqSize = requested.size(); // get size calculation out of the way if needed
+    namespace {
+        /**
+         * Recently freed DocumentStorage objects and power-of-two sized buffers, kept per
+         * thread so a pipeline stage making a document can reuse the one just freed by the
+         * stage after it instead of going back to malloc.
+         */
+        class DocumentStorageCache : boost::noncopyable {
+        public:
+            enum {
+                MIN_BUFFER_BYTES = 128, // smallest buffer DocumentStorage::alloc() makes
+                NUM_BUFFER_SIZES = 8, // 128 bytes through 16KB
+                MAX_PER_SIZE = 64,
+                MAX_CACHED_BYTES = 512 * 1024,
+            };
+
+            DocumentStorageCache() : _cachedBytes(0) {}
+
+            ~DocumentStorageCache() {
+                for (size_t i = 0; i < _objects.size(); i++)
+                    ::operator delete(_objects[i]);
+                for (int size = 0; size < NUM_BUFFER_SIZES; size++)
+                    for (size_t i = 0; i < _buffers[size].size(); i++)
+                        delete [] _buffers[size][i];
+            }
+
+            void* getObject() {
+                if (_objects.empty())
+                    return NULL;
+                void* out = _objects.back();
+                _objects.pop_back();
+                return out;
+            }
+
+            bool putObject(void* ptr) {
+                if (_objects.size() >= size_t(MAX_PER_SIZE))
+                    return false;
+                _objects.push_back(ptr);
+                return true;
+            }
 
-        if (_numFields >= HASH_TAB_MIN) { // hash lookup
-            const unsigned bucket = bucketForKey(requested);
+            char* getBuffer(size_t bytes) {
+                const int size = sizeIndex(bytes);
+                if (size < 0 || _buffers[size].empty())
+                    return NULL;
+                char* out = _buffers[size].back();
+                _buffers[size].pop_back();
+                _cachedBytes -= bytes;
+                return out;
+            }
+
+            bool putBuffer(char* buffer, size_t bytes) {
+                const int size = sizeIndex(bytes);
+                if (size < 0
+                        || _buffers[size].size() >= size_t(MAX_PER_SIZE)
+                        || _cachedBytes + bytes > size_t(MAX_CACHED_BYTES))
+                    return false;
+                _buffers[size].push_back(buffer);
+                _cachedBytes += bytes;
+                return true;
+            }
 
-            Position pos = _hashTab[bucket];
-            while (pos.found()) {
-                const ValueElement& elem = getField(pos);
-                if (elem.nameLen == reqSize
-                    && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
-                    return pos;
+        private:
+            /// Returns the slot for buffers of exactly 'bytes', or -1 if they aren't cached.
+            static int sizeIndex(size_t bytes) {
+                size_t slotBytes = MIN_BUFFER_BYTES;
+                for (int size = 0; size < NUM_BUFFER_SIZES; size++, slotBytes *= 2) {
+                    if (bytes == slotBytes)
+                        return size;
                 }
+                return -1;
+            }
+
+            vector<void*> _objects; // all sizeof(DocumentStorage)
+            vector<char*> _buffers[NUM_BUFFER_SIZES];
+            size_t _cachedBytes; // buffers only
+        };
+    }
 
-                // possible collision
-                pos = elem.nextCollision;
+    TSP_DECLARE(DocumentStorageCache, documentStorageCache)
+    TSP_DEFINE(DocumentStorageCache, documentStorageCache)
+
+    void* DocumentStorage::operator new(size_t bytes) {
+        dassert(bytes == sizeof(DocumentStorage));
+        if (void* cached = documentStorageCache.getMake()->getObject())
+            return cached;
+        return ::operator new(bytes);
+    }
+
+    void DocumentStorage::operator delete(void* ptr, size_t bytes) {
+        if (!ptr)
+            return;
+        if (!documentStorageCache.getMake()->putObject(ptr))
+            ::operator delete(ptr);
+    }
+
+    char* DocumentStorage::allocBuffer(size_t bytes) {
+        if (char* cached = documentStorageCache.getMake()->getBuffer(bytes))
+            return cached;
+        return new char[bytes];
+    }
+
+    void DocumentStorage::freeBuffer(char* buffer, size_t bytes) {
+        if (!buffer)
+            return;
+        if (!documentStorageCache.getMake()->putBuffer(buffer, bytes))
+            delete [] buffer;
+    }
+
+    Position DocumentStorage::findField(StringData requested) const {
+        if (_numFields >= HASH_TAB_MIN)
+            return findFieldInHashTable(requested, hashKey(requested));
+        return findFieldLinear(requested);
+    }
+
+    Position DocumentStorage::findField(StringData requested, unsigned hash) const {
+        dassert(hash == hashKey(requested));
+        if (_numFields >= HASH_TAB_MIN)
+            return findFieldInHashTable(requested, hash);
+        return findFieldLinear(requested);
+    }
+
+    Position DocumentStorage::findFieldInHashTable(StringData requested, unsigned hash) const {
+        const int reqSize = requested.size();
+
+        Position pos = _hashTab[hash & _hashTabMask];
+        while (pos.found()) {
+            const ValueElement& elem = getField(pos);
+            if (elem.nameLen == reqSize
+                && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
+                return pos;
             }
+
+            // possible collision
+            pos = elem.nextCollision;
         }
-        else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
-                if (it->nameLen == reqSize
-                    && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
-                    return it.position();
-                }
+
+        // if we got here, there's no such field
+        return Position();
+    }
+
+    Position DocumentStorage::findFieldLinear(StringData requested) const {
+        const int reqSize = requested.size();
+
+        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            if (it->nameLen == reqSize
+                && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
+                return it.position();
             }
         }
 
@@ -117,6 +241,7 @@ namespace mongo {
         const bool firstAlloc = !_buffer;
         const bool doingRehash = needRehash();
         const size_t oldCapacity = _bufferEnd - _buffer;
+        const size_t oldHashTabBytes = hashTabBytes();
 
         // make new bucket count big enough
         while (needRehash() || hashTabBuckets() < HASH_TAB_INIT_SIZE)
@@ -130,13 +255,14 @@ namespace mongo {
         uassert(16490, "Tried to make oversized document",
                 capacity <= size_t(BufferMaxSize));
 
-        boost::scoped_array<char> oldBuf(_buffer);
-        _buffer = new char[capacity];
+        char* const oldBuf = _buffer;
+        const size_t oldBufBytes = firstAlloc ? 0 : oldCapacity + oldHashTabBytes;
+        _buffer = allocBuffer(capacity);
         _bufferEnd = _buffer + capacity - hashTabBytes();
 
         if (!firstAlloc) {
             // This just copies the elements
-            memcpy(_buffer, oldBuf.get(), _usedBytes);
+            memcpy(_buffer, oldBuf, _usedBytes);
 
             if (_numFields >= HASH_TAB_MIN) {
                 // if we were hashing, deal with the hash table
@@ -145,10 +271,12 @@ namespace mongo {
                 }
                 else {
                     // no rehash needed so just slide table down to new position
-                    memcpy(_hashTab, oldBuf.get() + oldCapacity, hashTabBytes());
+                    memcpy(_hashTab, oldBuf + oldCapacity, hashTabBytes());
                 }
             }
         }
+
+        freeBuffer(oldBuf, oldBufBytes);
     }
 
     void DocumentStorage::reserveFields(size_t expectedFields) {
@@ -162,11 +290,16 @@ namespace mongo {
         // Using expectedFields+1 to allow space for long field names
         const size_t newSize = (expectedFields+1) * ValueElement::align(sizeof(ValueElement));
 
+        // Round up to a power of two like alloc() so the buffer can be recycled
+        size_t capacity = 128;
+        while (capacity < newSize + hashTabBytes())
+            capacity *= 2;
+
         uassert(16491, "Tried to make oversized document",
-                newSize <= size_t(BufferMaxSize));
+                capacity <= size_t(BufferMaxSize));
 
-        _buffer = new char[newSize + hashTabBytes()];
-        _bufferEnd = _buffer + newSize;
+        _buffer = allocBuffer(capacity);
+        _bufferEnd = _buffer + capacity - hashTabBytes();
     }
 
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
@@ -174,10 +307,10 @@ namespace mongo {
 
         // Make a copy of the buffer.
         // It is very important that the positions of each field are the same after cloning.
-        const size_t bufferBytes = (_bufferEnd + hashTabBytes()) - _buffer;
-        out->_buffer = new char[bufferBytes];
+        const size_t bytes = bufferBytes();
+        out->_buffer = allocBuffer(bytes);
         out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
-        memcpy(out->_buffer, _buffer, bufferBytes);
+        memcpy(out->_buffer, _buffer, bytes);
 
         // Copy remaining fields
         out->_usedBytes = _usedBytes;
@@ -193,11 +326,12 @@ namespace mongo {
     }
 
     DocumentStorage::~DocumentStorage() {
-        boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
-
         for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
         }
+
+        if (_buffer)
+            freeBuffer(_buffer, bufferBytes());
     }
 
     Document::Document(const BSONObj& bson) {
@@ -65,6 +65,14 @@ namespace mongo {
         const Value operator[] (StringData key) const { return getField(key); }
         const Value getField(StringData key) const { return storage().getField(key); }
 
+        /** Same as getField(key), given hashFieldName(key) computed ahead of time. Saves hashing
+         *  a name that is looked up in many documents.
+         */
+        const Value getField(StringData key, unsigned keyHash) const {
+            return storage().getField(key, keyHash);
+        }
+        static unsigned hashFieldName(StringData key) { return DocumentStorage::hashKey(key); }
+
         /// Look up a field by Position. See positionOf and getNestedField.
         const Value operator[] (Position pos) const { return getField(pos); }
         const Value getField(Position pos) const { return storage().getField(pos).val; }
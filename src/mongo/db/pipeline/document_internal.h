@@ -157,6 +157,11 @@ namespace mongo {
         {}
         ~DocumentStorage();
 
+        // Storage objects and their buffers are recycled through a per-thread cache, since
+        // pipelines free about as many documents as they make.
+        static void* operator new(size_t bytes);
+        static void operator delete(void* ptr, size_t bytes);
+
         static const DocumentStorage& emptyDoc() {
             static const char emptyBytes[sizeof(DocumentStorage)] = {0};
             return *reinterpret_cast<const DocumentStorage*>(emptyBytes);
@@ -176,6 +181,17 @@ namespace mongo {
         /// Returns the position of the named field (may be missing) or Position()
         Position findField(StringData name) const;
 
+        /// Same as findField(name), given hashKey(name) computed ahead of time.
+        Position findField(StringData name, unsigned hash) const;
+
+        /// Hash of a field name as used by findField.
+        static unsigned hashKey(StringData name) {
+            // TODO consider FNV-1a once we have a better benchmark corpus
+            unsigned out;
+            MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
+            return out;
+        }
+
         // Document uses these
         const ValueElement& getField(Position pos) const {
             verify(pos.found());
@@ -187,6 +203,12 @@ namespace mongo {
                 return Value();
             return getField(pos).val;
         }
+        Value getField(StringData name, unsigned hash) const {
+            Position pos = findField(name, hash);
+            if (!pos.found())
+                return Value();
+            return getField(pos).val;
+        }
 
         // MutableDocument uses these
         ValueElement& getField(Position pos) {
@@ -233,6 +255,13 @@ namespace mongo {
         /// Allocates space in _buffer. Copies existing data if there is any.
         void alloc(unsigned newSize);
 
+        /// Bytes in _buffer, including the hash table. Only valid if _buffer is set.
+        size_t bufferBytes() const { return (_bufferEnd + hashTabBytes()) - _buffer; }
+
+        /// Get and return buffers, going through the cache when 'bytes' is a cached size.
+        static char* allocBuffer(size_t bytes);
+        static void freeBuffer(char* buffer, size_t bytes);
+
         /// Call after adding field to _buffer and increasing _numFields
         void addFieldToHashTable(Position pos);
 
@@ -246,12 +275,9 @@ namespace mongo {
         /// Initialize empty hash table
         void hashTabInit() { memset(_hashTab, -1, hashTabBytes()); }
 
-        static unsigned hashKey(StringData name) {
-            // TODO consider FNV-1a once we have a better benchmark corpus
-            unsigned out;
-            MurmurHash3_x86_32(name.rawData(), name.size(), 0, &out);
-            return out;
-        }
+        // Lookups for findField
+        Position findFieldInHashTable(StringData name, unsigned hash) const;
+        Position findFieldLinear(StringData name) const;
 
         unsigned bucketForKey(StringData name) const {
             return hashKey(name) & _hashTabMask;
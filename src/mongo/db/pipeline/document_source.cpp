@@ -55,6 +55,15 @@ namespace mongo {
         return false;
     }
 
+    size_t DocumentSource::getNextBatch(vector<Document>* batch, size_t maxDocs) {
+        size_t n = 0;
+        for (bool hasDoc = !eof(); hasDoc && n < maxDocs; hasDoc = advance()) {
+            batch->push_back(getCurrent());
+            n++;
+        }
+        return n;
+    }
+
     void DocumentSource::dispose() {
         if ( pSource ) {
             // This is required for the DocumentSourceCursor to release its read lock, see
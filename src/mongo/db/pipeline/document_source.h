@@ -24,6 +24,7 @@
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
+#include "mongo/db/memory_tracker.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/expression.h"
@@ -42,6 +43,8 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class DocumentSourceSort;
+    class DocumentSourceUnwind;
 
     class DocumentSource : public IntrusiveCounterUnsigned {
     public:
@@ -95,6 +98,21 @@ namespace mongo {
          */
         virtual Document getCurrent() = 0;
 
+        /** Number of Documents stages ask their source for per getNextBatch() call. */
+        static const size_t DefaultBatchSize = 128;
+
+        /**
+         * Appends up to maxDocs of this source's remaining Documents to batch, consuming them.
+         *
+         * This lets a stage hand its successor many Documents per virtual call.  The default
+         * implementation falls back to eof()/getCurrent()/advance() one Document at a time;
+         * stages that can process a whole batch in a tight loop override it.  When this returns,
+         * eof() and getCurrent() refer to the first Document not yet returned.
+         *
+         * @returns the number of Documents appended; 0 only if the source is eof()
+         */
+        virtual size_t getNextBatch(vector<Document>* batch, size_t maxDocs);
+
         /**
          * Inform the source that it is no longer needed and may release its resources.  After
          * dispose() is called the source must still be able to handle iteration requests, but may
@@ -330,6 +348,14 @@ namespace mongo {
             const ShardOutput& shardOutput,
             const intrusive_ptr<ExpressionContext>& pExpCtx);
 
+        /**
+          Merge the shards' results in the order of a $sort they were already
+          sorted by, instead of returning them one shard after another.
+
+          @param pSort the $sort the shards ran
+         */
+        void setMergeSort(const intrusive_ptr<DocumentSourceSort>& pSort);
+
     protected:
         // virtuals from DocumentSource
         virtual void sourceToBson(BSONObjBuilder *pBuilder, bool explain) const;
@@ -347,6 +373,12 @@ namespace mongo {
          */
         void getNextDocument();
 
+        /// getNextDocument() when merging.
+        void getNextMergedDocument();
+
+        /// Checks a shard's response and returns its result array.
+        static BSONElement resultArray(const ShardOutput::value_type& shardResult);
+
         bool unstarted;
         bool hasCurrent;
         bool newSource; // set to true for the first item of a new source
@@ -354,6 +386,13 @@ namespace mongo {
         Document pCurrent;
         ShardOutput::const_iterator iterator;
         ShardOutput::const_iterator listEnd;
+
+        // only used when merging
+        class MergeComparator;
+        intrusive_ptr<DocumentSourceSort> _mergeSort;
+        vector<intrusive_ptr<DocumentSourceBsonArray> > _mergeSources; // one per shard
+        vector<Value> _mergeKeys; // sort key of each source's current document
+        vector<size_t> _mergeHeap; // of indexes into _mergeSources, earliest key on top
     };
 
 
@@ -369,6 +408,7 @@ namespace mongo {
         virtual bool eof();
         virtual bool advance();
         virtual Document getCurrent();
+        virtual size_t getNextBatch(vector<Document>* batch, size_t maxDocs);
         virtual void setSource(DocumentSource *pSource);
         virtual bool coalesce(const intrusive_ptr<DocumentSource>& nextSource);
 
@@ -489,6 +529,7 @@ namespace mongo {
         virtual bool eof();
         virtual bool advance();
         virtual Document getCurrent();
+        virtual size_t getNextBatch(vector<Document>* batch, size_t maxDocs);
 
         /**
           Create a BSONObj suitable for Matcher construction.
@@ -503,10 +544,6 @@ namespace mongo {
          */
         virtual void toMatcherBson(BSONObjBuilder *pBuilder) const = 0;
 
-    protected:
-        DocumentSourceFilterBase(
-            const intrusive_ptr<ExpressionContext> &pExpCtx);
-
         /**
           Test the given document against the predicate and report if it
           should be accepted or not.
@@ -516,6 +553,10 @@ namespace mongo {
          */
         virtual bool accept(const Document& pDocument) const = 0;
 
+    protected:
+        DocumentSourceFilterBase(
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
     private:
 
         void findNext();
@@ -523,6 +564,9 @@ namespace mongo {
         bool unstarted;
         bool hasCurrent;
         Document pCurrent;
+
+        // scratch space for getNextBatch(), kept to reuse its allocation
+        vector<Document> _inputBatch;
     };
 
 
@@ -654,6 +698,46 @@ namespace mongo {
         virtual intrusive_ptr<DocumentSource> getShardSource();
         virtual intrusive_ptr<DocumentSource> getRouterSource();
 
+        /**
+          Get the input order that would let this group stream.
+
+          If the _id is a field path, or an object of field paths, into the
+          input documents, input ordered on those fields brings each group's
+          documents together, so groups can be emitted one at a time without
+          holding them all.
+
+          @param following the $sort right after this group, or NULL
+          @param satisfiesFollowing set to true if following sorts on the
+            same keys as the _id, so it can be dropped once the input comes
+            in the returned order
+          @returns the order as a sort pattern on the input documents, or an
+            empty object if this group can't stream
+         */
+        BSONObj getStreamingSort(const DocumentSourceSort* following,
+                                 bool* satisfiesFollowing) const;
+
+        /**
+          Promise that the input will arrive in the order returned by
+          getStreamingSort(), and will not contain arrays along the _id paths.
+         */
+        void setStreaming(const BSONObj& sort);
+
+        /**
+          Take over the $unwind just before this group.
+
+          The group then unwinds each input document's array itself,
+          overwriting one element with the next in place, rather than being
+          handed a Document per element.  The $unwind still shows in the
+          serialized pipeline.
+
+          @param previous the source before this one in the pipeline
+          @returns whether previous was an $unwind, to be removed from the
+            pipeline
+         */
+        bool absorbUnwind(const intrusive_ptr<DocumentSource>& previous);
+
+        virtual void addToBsonArray(BSONArrayBuilder *pBuilder, bool explain=false) const;
+
         static const char groupName[];
 
     protected:
@@ -663,12 +747,24 @@ namespace mongo {
     private:
         DocumentSourceGroup(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
+        /// Adds input to its group, spilling to sortedFiles first if memory is short.
+        void accumulate(const Document& input,
+                        bool mergeInputs,
+                        int* memoryUsageBytes,
+                        vector<shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles);
+
         /// Spill groups map to disk and returns an iterator to the file.
         shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
         // Only used by spill. Would be function-local if that were legal in C++03.
         class SpillSTLComparator;
 
+        /**
+         * Merges all of sortedFiles into a single spill file, combining the partial accumulator
+         * states of equal ids, and replaces the contents of sortedFiles with it.
+         */
+        void reduceSpills(vector<shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles);
+
         /*
           Before returning anything, this source must fetch everything from
           the underlying source and group it.  populate() is used to do that
@@ -703,13 +799,47 @@ namespace mongo {
 
         Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
+        /// Serializes the mergeable state of accums for writing to a spill file.
+        static Value spilledState(const Accumulators& accums);
+
+        /// Folds a state produced by spilledState() into accums.
+        static void mergeSpilledState(const Value& state, const Accumulators& accums);
+
         bool _spilled;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
+        const size_t _maxSpillFiles;
+        MemoryCharge _memory; // of the groups accumulated in memory
 
         // only used when !_spilled
         GroupsMap::iterator groupsIterator;
 
+        /**
+         * The _id field names, and the input fields they are read from, if the _id is an
+         * object of field paths.  If the _id is a field path, idFields is left empty.
+         * Returns false if this group can't stream.
+         */
+        bool getStreamingKeys(vector<string>* idFields, vector<string>* inputFields) const;
+
+        /// Fills groups with the next run of input documents whose keys sort equal.
+        void readRun();
+
+        /// True if the input sorts id1 and id2 equal, so they belong in the same run.
+        bool sameRun(const Value& id1, const Value& id2) const;
+
+        /// Compares ids the way getStreamingSort()'s following $sort would.
+        class RunComparator;
+
+        // only used when streaming
+        bool _streaming;
+        vector<string> _streamingIdFields;
+        vector<int> _streamingDirections;
+        vector<GroupsMap::iterator> _runGroups; // the current run, in output order
+        size_t _runIndex;
+
+        // the absorbed $unwind, see absorbUnwind()
+        intrusive_ptr<DocumentSourceUnwind> _unwind;
+
         // only used when _spilled
         scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
         pair<Value, Value> _firstPartOfNextGroup;
@@ -764,9 +894,20 @@ namespace mongo {
             const intrusive_ptr<ExpressionContext> &pExpCtx);
 
         Matcher matcher;
+
+        // sizes of recent documents converted for the matcher, see accept()
+        BSONSizeTracker _sizeTracker;
     };
 
 
+    /**
+     * Writes the pipeline's documents to a collection of the same database, replacing its
+     * contents, and passes nothing on.  It must be the last stage.
+     *
+     * The documents are inserted in batches into a temporary collection holding only an _id
+     * index.  Once they are all in, the output collection's other indexes are built on it in
+     * bulk and it is renamed over the output collection, so readers never see a partial result.
+     */
     class DocumentSourceOut :
         public DocumentSource {
     public:
@@ -778,12 +919,10 @@ namespace mongo {
         virtual Document getCurrent();
 
         /**
-          Create a document source for output and pass-through.
+          Create a document source for output.
 
-          This can be put anywhere in a pipeline and will store content as
-          well as pass it on.
-
-          @param pBsonElement the raw BSON specification for the source
+          @param pBsonElement the raw BSON specification for the source, the name of the output
+            collection
           @param pExpCtx the expression context for the pipeline
           @returns the newly created document source
         */
@@ -798,8 +937,34 @@ namespace mongo {
         virtual void sourceToBson(BSONObjBuilder *pBuilder, bool explain) const;
 
     private:
-        DocumentSourceOut(BSONElement *pBsonElement,
-            const intrusive_ptr<ExpressionContext> &pExpCtx);
+        DocumentSourceOut(const string& outputCollection,
+                          const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /** Writes all of the source's documents, then swaps them in for the output collection. */
+        void populate();
+
+        /** Inserts _batch into the temporary collection and clears it. */
+        void flushBatch();
+
+        /** Builds the output collection's indexes, but _id's, on the temporary collection. */
+        void copyIndexes();
+
+        /** Throws the error of the last write to the temporary collection, if it had one. */
+        void checkLastError(const string& action);
+
+        // Configuration state.
+        string _outputCollection;
+
+        // Injected by PipelineD, as for DocumentSourceLookup.
+        string _db;
+        boost::scoped_ptr<DBClientWithCommands> _client; // either NULL or a DBDirectClient
+        friend class PipelineD;
+
+        // Output state.
+        bool _done;
+        string _tempNs;
+        vector<BSONObj> _batch;
+        int _batchBytes;
     };
 
     
@@ -812,9 +977,21 @@ namespace mongo {
         virtual bool advance();
         virtual const char *getSourceName() const;
         virtual Document getCurrent();
+        virtual size_t getNextBatch(vector<Document>* batch, size_t maxDocs);
         virtual void optimize();
 
+        virtual bool coalesce(const intrusive_ptr<DocumentSource> &pNextSource);
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
+        virtual void addToBsonArray(BSONArrayBuilder *pBuilder, bool explain=false) const;
+
+        /**
+         * For a $group that has absorbed this $unwind, see DocumentSourceGroup::absorbUnwind().
+         * After resetUnwound(input), each nextUnwound() sets *out to the next Document this
+         * would have passed on for input, and returns false when there are no more.  Each
+         * overwrites the last in place unless the caller still holds on to it.
+         */
+        void resetUnwound(const Document& input);
+        bool nextUnwound(Document* out);
 
         /**
           Create a new projection DocumentSource from BSON.
@@ -843,6 +1020,9 @@ namespace mongo {
         DocumentSourceProject(const intrusive_ptr<ExpressionContext>& pExpCtx,
                               const intrusive_ptr<ExpressionObject>& exprObj);
 
+        /// Applies the projection to a single input Document.
+        Document project(const Document& input) const;
+
         // configuration state
         intrusive_ptr<ExpressionObject> pEO;
         BSONObj _raw;
@@ -870,10 +1050,9 @@ namespace mongo {
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
 
         // Virtuals for SplittableDocumentSource
-        // All work for sort is done in router currently if there is no limit.
-        // If there is a limit, the $sort/$limit combination is performed on the
-        // shards, then the results are resorted and limited on mongos
-        virtual intrusive_ptr<DocumentSource> getShardSource() { return limitSrc ? this : NULL; }
+        // The $sort (and any coalesced $limit) is performed on the shards, then mongos merges
+        // their sorted results, see Pipeline::popMergeSort().
+        virtual intrusive_ptr<DocumentSource> getShardSource() { return this; }
         virtual intrusive_ptr<DocumentSource> getRouterSource() { return this; }
 
         /**
@@ -922,6 +1101,12 @@ namespace mongo {
 
         intrusive_ptr<DocumentSourceLimit> getLimitSrc() const { return limitSrc; }
 
+        /// Extracts the fields in vSortKey from the Document;
+        Value extractKey(const Document& d) const;
+
+        /// Compare two Values according to the specified sort key.
+        int compare(const Value& lhs, const Value& rhs) const;
+
         static const char sortName[];
     protected:
         // virtuals from DocumentSource
@@ -946,11 +1131,6 @@ namespace mongo {
         SortPaths vSortKey;
         vector<char> vAscending; // used like vector<bool> but without specialization
 
-        /// Extracts the fields in vSortKey from the Document;
-        Value extractKey(const Document& d) const;
-
-        /// Compare two Values according to the specified sort key.
-        int compare(const Value& lhs, const Value& rhs) const;
 
         typedef Sorter<Value, Document> MySorter;
 
@@ -1111,7 +1291,18 @@ namespace mongo {
         virtual const char *getSourceName() const;
         virtual Document getCurrent();
 
+        virtual bool coalesce(const intrusive_ptr<DocumentSource> &pNextSource);
         virtual GetDepsReturn getDependencies(set<string>& deps) const;
+        virtual void addToBsonArray(BSONArrayBuilder *pBuilder, bool explain=false) const;
+
+        /**
+         * For a $group that has absorbed this $unwind, see DocumentSourceGroup::absorbUnwind().
+         * After resetUnwound(input), each nextUnwound() sets *out to the next Document this
+         * would have passed on for input, and returns false when there are no more.  Each
+         * overwrites the last in place unless the caller still holds on to it.
+         */
+        void resetUnwound(const Document& input);
+        bool nextUnwound(Document* out);
 
         /**
           Create a new projection DocumentSource from BSON.
@@ -1154,11 +1345,84 @@ namespace mongo {
         // Configuration state.
         scoped_ptr<FieldPath> _unwindPath;
 
+        // A $match right after this one, absorbed so that rejected elements are never copied.
+        intrusive_ptr<DocumentSourceFilterBase> _filter;
+
         // Iteration state.
         class Unwinder;
         scoped_ptr<Unwinder> _unwinder;
     };
 
+    /**
+     * Joins each document to those of another collection in the same database: { $lookup:
+     * { from: <collection>, localField: <path>, foreignField: <path>, as: <path>,
+     *   query: <filter on the foreign documents>, fields: <their projection> } } sets 'as' to
+     * the array of the foreign documents whose foreignField equals the document's localField.
+     * A missing or null field equals null and arrays are compared whole.  The projection,
+     * if any, keeps the foreign field.
+     *
+     * The foreign documents go in a hash table built with one query.  If they're more than
+     * internalLookupHashJoinMaxBytes and the foreign field is indexed, each document is
+     * looked up on its own instead.
+     */
+    class DocumentSourceLookup :
+        public DocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual ~DocumentSourceLookup();
+        virtual bool eof();
+        virtual bool advance();
+        virtual const char *getSourceName() const;
+        virtual Document getCurrent();
+
+        virtual GetDepsReturn getDependencies(set<string>& deps) const;
+
+        static intrusive_ptr<DocumentSource> createFromBson(
+            BSONElement *pBsonElement,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        static const char lookupName[];
+
+    protected:
+        // virtuals from DocumentSource
+        virtual void sourceToBson(BSONObjBuilder *pBuilder, bool explain) const;
+
+    private:
+        DocumentSourceLookup(const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /** Picks the join strategy, building the hash table for a hash join. */
+        void lazyInit();
+
+        /** @return the array of foreign documents to join to a 'key' from joinKey(). */
+        Value lookup(const Value& key);
+
+        /** @return the value a local or foreign field value is joined by. */
+        static Value joinKey(const Value& value);
+
+        string foreignNs() const;
+
+        // Configuration state.
+        string _from;
+        scoped_ptr<FieldPath> _localField;
+        scoped_ptr<FieldPath> _foreignField;
+        scoped_ptr<FieldPath> _as;
+        BSONObj _query;
+        BSONObj _fields;
+
+        // Injected by PipelineD, as for DocumentSourceGeoNear.
+        string _db;
+        boost::scoped_ptr<DBClientWithCommands> _client; // either NULL or a DBDirectClient
+        friend class PipelineD;
+
+        // Iteration state.
+        bool _initialized;
+        bool _hashJoin;
+        typedef boost::unordered_map<Value, vector<Value>, Value::Hash> Table;
+        Table _table;
+        bool _haveCurrent;
+        Document _current;
+    };
+
     class DocumentSourceGeoNear : public SplittableDocumentSource {
     public:
         // virtuals from DocumentSource
@@ -16,6 +16,8 @@
 
 #include "pch.h"
 
+#include <algorithm>
+
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/s/shard.h"
 
@@ -82,7 +84,101 @@ namespace mongo {
         return pSource;
     }
 
+    void DocumentSourceCommandShards::setMergeSort(const intrusive_ptr<DocumentSourceSort>& pSort) {
+        verify(unstarted);
+        _mergeSort = pSort;
+    }
+
+    BSONElement DocumentSourceCommandShards::resultArray(
+            const ShardOutput::value_type& shardResult) {
+        const BSONObj& resultObj = shardResult.second;
+
+        uassert(16390, str::stream() << "sharded pipeline failed on shard " <<
+                                    shardResult.first.getName() << ": " <<
+                                    resultObj.toString(),
+                resultObj["ok"].trueValue());
+
+        /* grab the result array out of the shard server's response */
+        BSONElement resultArray = resultObj["result"];
+        massert(16391, str::stream() << "no result array? shard:" <<
+                                    shardResult.first.getName() << ": " <<
+                                    resultObj.toString(),
+                resultArray.type() == Array);
+
+        return resultArray;
+    }
+
+    /**
+     * Orders _mergeHeap.  The heap algorithms keep the greatest element on top, so this puts
+     * the source with the earliest sort key there; among equal keys the earliest shard wins.
+     */
+    class DocumentSourceCommandShards::MergeComparator {
+    public:
+        explicit MergeComparator(const DocumentSourceCommandShards& source) : _source(source) {}
+
+        bool operator()(size_t lhs, size_t rhs) const {
+            const int cmp = _source._mergeSort->compare(_source._mergeKeys[lhs],
+                                                        _source._mergeKeys[rhs]);
+            if (cmp)
+                return cmp > 0;
+            return lhs > rhs;
+        }
+
+    private:
+        const DocumentSourceCommandShards& _source;
+    };
+
+    void DocumentSourceCommandShards::getNextMergedDocument() {
+        const MergeComparator comparator(*this);
+
+        if (unstarted) {
+            unstarted = false;
+
+            for (; iterator != listEnd; ++iterator) {
+                BSONElement results = resultArray(*iterator);
+                intrusive_ptr<DocumentSourceBsonArray> pSource =
+                    DocumentSourceBsonArray::create(&results, pExpCtx);
+                if (pSource->eof())
+                    continue; // this shard had no results
+
+                _mergeHeap.push_back(_mergeSources.size());
+                _mergeKeys.push_back(_mergeSort->extractKey(pSource->getCurrent()));
+                _mergeSources.push_back(pSource);
+            }
+
+            make_heap(_mergeHeap.begin(), _mergeHeap.end(), comparator);
+        }
+        else if (!_mergeHeap.empty()) {
+            /* the current document came from the source on top of the heap, advance it */
+            pop_heap(_mergeHeap.begin(), _mergeHeap.end(), comparator);
+            const size_t i = _mergeHeap.back();
+            if (_mergeSources[i]->advance()) {
+                _mergeKeys[i] = _mergeSort->extractKey(_mergeSources[i]->getCurrent());
+                push_heap(_mergeHeap.begin(), _mergeHeap.end(), comparator);
+            }
+            else {
+                _mergeHeap.pop_back();
+                _mergeSources[i].reset();
+                _mergeKeys[i] = Value();
+            }
+        }
+
+        if (_mergeHeap.empty()) {
+            pCurrent = Document();
+            hasCurrent = false;
+            return;
+        }
+
+        pCurrent = _mergeSources[_mergeHeap.front()]->getCurrent();
+        hasCurrent = true;
+    }
+
     void DocumentSourceCommandShards::getNextDocument() {
+        if (_mergeSort) {
+            getNextMergedDocument();
+            return;
+        }
+
         if (unstarted) {
             unstarted = false;
             hasCurrent = true;
@@ -98,29 +194,17 @@ namespace mongo {
                 }
 
                 /* grab the next command result */
-                BSONObj resultObj = iterator->second;
-
-                uassert(16390, str::stream() << "sharded pipeline failed on shard " <<
-                                            iterator->first.getName() << ": " <<
-                                            resultObj.toString(),
-                        resultObj["ok"].trueValue());
-
-                /* grab the result array out of the shard server's response */
-                BSONElement resultArray = resultObj["result"];
-                massert(16391, str::stream() << "no result array? shard:" <<
-                                            iterator->first.getName() << ": " <<
-                                            resultObj.toString(),
-                        resultArray.type() == Array);
+                BSONElement results = resultArray(*iterator);
 
                 // done with error checking, don't need the shard name anymore
                 ++iterator;
 
-                if (resultArray.embeddedObject().isEmpty()){
+                if (results.embeddedObject().isEmpty()){
                     // this shard had no results, on to the next one
                     continue;
                 }
 
-                pBsonSource = DocumentSourceBsonArray::create(&resultArray, pExpCtx);
+                pBsonSource = DocumentSourceBsonArray::create(&results, pExpCtx);
                 newSource = true;
             }
 
@@ -60,6 +60,26 @@ namespace mongo {
         return _currentBatch.front();
     }
 
+    size_t DocumentSourceCursor::getNextBatch(vector<Document>* batch, size_t maxDocs) {
+        DocumentSource::advance(); // check for interrupts
+
+        if (unstarted)
+            loadBatch();
+
+        // hand out our already loaded Documents directly rather than one per advance()
+        size_t n = 0;
+        while (n < maxDocs && !_currentBatch.empty()) {
+            batch->push_back(_currentBatch.front());
+            _currentBatch.pop_front();
+            n++;
+
+            if (_currentBatch.empty())
+                loadBatch();
+        }
+
+        return n;
+    }
+
     void DocumentSourceCursor::dispose() {
         if (_cursorId) {
             ClientCursor::erase(_cursorId);
@@ -73,6 +73,42 @@ namespace mongo {
         return pCurrent;
     }
 
+    size_t DocumentSourceFilterBase::getNextBatch(vector<Document>* batch, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+
+        size_t n = 0;
+        if (!unstarted) {
+            // findNext() has already consumed pCurrent from our source
+            if (!hasCurrent)
+                return 0;
+
+            batch->push_back(pCurrent);
+            n++;
+        }
+
+        // Never ask for more input than we could return, so nothing needs to be held back.
+        while (n < maxDocs) {
+            _inputBatch.clear();
+            if (pSource->getNextBatch(&_inputBatch, maxDocs - n) == 0)
+                break;
+
+            for (size_t i = 0; i < _inputBatch.size(); i++) {
+                if (accept(_inputBatch[i])) {
+                    batch->push_back(_inputBatch[i]);
+                    n++;
+                }
+            }
+        }
+        _inputBatch.clear();
+
+        // The next eof() or getCurrent() resumes from wherever our source now is.
+        unstarted = true;
+        hasCurrent = false;
+        pCurrent = Document();
+
+        return n;
+    }
+
     DocumentSourceFilterBase::DocumentSourceFilterBase(
         const intrusive_ptr<ExpressionContext> &pExpCtx):
         DocumentSource(pExpCtx),
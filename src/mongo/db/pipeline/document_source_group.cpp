@@ -24,8 +24,17 @@
 #include "db/pipeline/expression.h"
 #include "db/pipeline/expression_context.h"
 #include "db/pipeline/value.h"
+#include "db/server_parameters.h"
 
 namespace mongo {
+    // Approximate number of bytes of group keys and accumulator state held in memory before
+    // the groups map is sorted and spilled to a temp file (requires allowDiskUsage).
+    MONGO_EXPORT_SERVER_PARAMETER(internalGroupMaxMemoryUsageBytes, int, 100*1024*1024);
+
+    // Once this many spill files exist they are merge-reduced into a single file so that
+    // groups with very many distinct keys don't exhaust file descriptors.
+    MONGO_EXPORT_SERVER_PARAMETER(internalGroupMaxSpillFiles, int, 64);
+
     const char DocumentSourceGroup::groupName[] = "$group";
 
     DocumentSourceGroup::~DocumentSourceGroup() {
@@ -39,6 +48,9 @@ namespace mongo {
         if (!populated)
             populate();
 
+        if (_streaming)
+            return _runIndex == _runGroups.size();
+
         return _spilled
                 ? _done
                 : (groupsIterator == groups.end());
@@ -50,6 +62,18 @@ namespace mongo {
         if (!populated)
             populate();
 
+        if (_streaming) {
+            verify(_runIndex < _runGroups.size());
+            if (++_runIndex == _runGroups.size()) {
+                readRun();
+                if (_runGroups.empty()) {
+                    dispose();
+                    return false;
+                }
+            }
+            return true;
+        }
+
         if (_spilled) {
             if (_doneAfterNextAdvance) {
                 verify(!_done);
@@ -66,26 +90,7 @@ namespace mongo {
             while (_currentId == _firstPartOfNextGroup.first) {
                 // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
                 // At loop exit, it is the first value to be processed in the next group.
-
-                switch (numAccumulators) { // mirrors switch in spill()
-                case 0: // no Accumulators so no Values
-                    break;
-
-                case 1: // single accumulators serialize as a single Value
-                    _currentAccumulators[0]->process(_firstPartOfNextGroup.second,
-                                                     /*merging=*/true);
-                    break;
-
-                default: { // multiple accumulators serialize as an array
-                    const vector<Value>& accumulatorStates =
-                        _firstPartOfNextGroup.second.getArray();
-                    for (size_t i=0; i < numAccumulators; i++) {
-                        _currentAccumulators[i]->process(accumulatorStates[i],
-                                                         /*merging=*/true);
-                    }
-                    break;
-                }
-                }
+                mergeSpilledState(_firstPartOfNextGroup.second, _currentAccumulators);
 
                 if (!_sorterIterator->more()) {
                     _doneAfterNextAdvance = true;
@@ -114,7 +119,11 @@ namespace mongo {
 
         dassert(!eof());
 
-        if (_spilled) {
+        if (_streaming) {
+            return makeDocument(_runGroups[_runIndex]->first,
+                                _runGroups[_runIndex]->second,
+                                pExpCtx->getInShard());
+        } else if (_spilled) {
             return makeDocument(_currentId, _currentAccumulators, pExpCtx->getInShard());
         } else {
             return makeDocument(groupsIterator->first,
@@ -125,7 +134,10 @@ namespace mongo {
 
     void DocumentSourceGroup::dispose() {
         // free our resources
+        _runGroups.clear();
+        _runIndex = 0;
         GroupsMap().swap(groups);
+        _memory.trySet(0);
         _sorterIterator.reset();
 
         // make us look done
@@ -154,7 +166,26 @@ namespace mongo {
         *pBuilder << groupName << insides.freeze();
     }
 
+    void DocumentSourceGroup::addToBsonArray(BSONArrayBuilder *pBuilder, bool explain) const {
+        if (_unwind)
+            _unwind->addToBsonArray(pBuilder, explain);
+        DocumentSource::addToBsonArray(pBuilder, explain);
+    }
+
+    bool DocumentSourceGroup::absorbUnwind(const intrusive_ptr<DocumentSource>& previous) {
+        verify(!_unwind && !_streaming);
+        DocumentSourceUnwind* unwind = dynamic_cast<DocumentSourceUnwind*>(previous.get());
+        if (!unwind)
+            return false;
+
+        _unwind = unwind;
+        return true;
+    }
+
     DocumentSource::GetDepsReturn DocumentSourceGroup::getDependencies(set<string>& deps) const {
+        if (_unwind && _unwind->getDependencies(deps) == NOT_SUPPORTED)
+            return NOT_SUPPORTED;
+
         // add the _id
         pIdExpression->addDependencies(deps);
 
@@ -179,7 +210,10 @@ namespace mongo {
         , populated(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->getExtSortAllowed() && !pExpCtx->getInRouter())
-        , _maxMemoryUsageBytes(100*1024*1024)
+        , _maxMemoryUsageBytes(internalGroupMaxMemoryUsageBytes)
+        , _maxSpillFiles(std::max(2, internalGroupMaxSpillFiles))
+        , _streaming(false)
+        , _runIndex(0)
         , _doneAfterNextAdvance(false)
         , _done(false)
     {}
@@ -348,75 +382,113 @@ namespace mongo {
         };
     }
 
-    void DocumentSourceGroup::populate() {
+    void DocumentSourceGroup::accumulate(
+            const Document& input,
+            bool mergeInputs,
+            int* memoryUsageBytes,
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles) {
         const size_t numAccumulators = vpAccumulatorFactory.size();
-        dassert(numAccumulators == vpExpression.size());
 
-        const bool mergeInputs = pExpCtx->getDoingMerge();
-
-        // pushed to on spill()
-        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
-        int memoryUsageBytes = 0;
+        // Past our own limit, or what the op or server may hold, the groups go to disk.
+        if (*memoryUsageBytes > _maxMemoryUsageBytes || !_memory.trySet(*memoryUsageBytes)) {
+            uassert(16945,
+                    "Exceeded memory limit for $group, but didn't allow external sort",
+                    _extSortAllowed);
+            sortedFiles->push_back(spill());
+            *memoryUsageBytes = 0;
 
-        // This loop consumes all input from pSource and buckets it based on pIdExpression.
-        for (bool hasNext = !pSource->eof(); hasNext; hasNext = pSource->advance()) {
-            if (memoryUsageBytes > _maxMemoryUsageBytes) {
-                uassert(16945, "Exceeded memory limit for $group, but didn't allow external sort",
-                        _extSortAllowed);
-                sortedFiles.push_back(spill());
-                memoryUsageBytes = 0;
+            if (sortedFiles->size() >= _maxSpillFiles) {
+                reduceSpills(sortedFiles);
             }
+        }
 
-            const Document input = pSource->getCurrent();
-            const Variables vars (input);
+        const Variables vars (input);
 
-            /* get the _id value */
-            Value id = pIdExpression->evaluate(vars);
+        /* get the _id value */
+        Value id = pIdExpression->evaluate(vars);
 
-            /* treat missing values the same as NULL SERVER-4674 */
-            if (id.missing())
-                id = Value(BSONNULL);
+        /* treat missing values the same as NULL SERVER-4674 */
+        if (id.missing())
+            id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
+        /*
+          Look for the _id value in the map; if it's not there, add a
+          new entry with a blank accumulator.
+        */
+        const size_t oldSize = groups.size();
+        vector<intrusive_ptr<Accumulator> >& group = groups[id];
+        const bool inserted = groups.size() != oldSize;
 
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
+        if (inserted) {
+            *memoryUsageBytes += id.getApproximateSize();
 
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
+            // Add the accumulators
+            group.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group.push_back(vpAccumulatorFactory[i]());
             }
-
-            /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
+        } else {
             for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(vars), mergeInputs);
-                memoryUsageBytes += group[i]->memUsageForSorter();
+                // subtract old mem usage. New usage added back after processing.
+                *memoryUsageBytes -= group[i]->memUsageForSorter();
             }
+        }
+
+        /* tickle all the accumulators for the group we found */
+        dassert(numAccumulators == group.size());
+        for (size_t i = 0; i < numAccumulators; i++) {
+            group[i]->process(vpExpression[i]->evaluate(vars), mergeInputs);
+            *memoryUsageBytes += group[i]->memUsageForSorter();
+        }
+
+        DEV {
+            // In debug mode, spill every time we have a duplicate id to stress merge logic.
+            if (!inserted // is a dup
+                    && !pExpCtx->getInRouter() // can't spill to disk in router
+                    && !_extSortAllowed // don't change behavior when testing external sort
+                    && sortedFiles->size() < 20 // don't open too many FDs
+                    ) {
+                sortedFiles->push_back(spill());
+            }
+        }
+    }
+
+    void DocumentSourceGroup::populate() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        dassert(numAccumulators == vpExpression.size());
+
+        if (_streaming) {
+            // Only the first run is read now, the rest as they are reached.
+            populated = true;
+            readRun();
+            return;
+        }
+
+        const bool mergeInputs = pExpCtx->getDoingMerge();
+
+        // pushed to on spill()
+        vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
+        int memoryUsageBytes = 0;
+
+        // This loop consumes all input from pSource and buckets it based on pIdExpression.
+        // Input is pulled in batches to cut per-Document virtual calls on our source.
+        vector<Document> batch;
+        batch.reserve(DefaultBatchSize);
+        Document unwound;
+        while (pSource->getNextBatch(&batch, DefaultBatchSize) > 0) {
+            for (size_t inputIndex = 0; inputIndex < batch.size(); inputIndex++) {
+                if (!_unwind) {
+                    accumulate(batch[inputIndex], mergeInputs, &memoryUsageBytes, &sortedFiles);
+                    continue;
+                }
 
-            DEV {
-                // In debug mode, spill every time we have a duplicate id to stress merge logic.
-                if (!inserted // is a dup
-                        && !pExpCtx->getInRouter() // can't spill to disk in router
-                        && !_extSortAllowed // don't change behavior when testing external sort
-                        && sortedFiles.size() < 20 // don't open too many FDs
-                        ) {
-                    sortedFiles.push_back(spill());
+                // One Document per input, its array element overwritten for each in turn.
+                _unwind->resetUnwound(batch[inputIndex]);
+                while (_unwind->nextUnwound(&unwound)) {
+                    accumulate(unwound, mergeInputs, &memoryUsageBytes, &sortedFiles);
                 }
             }
+            batch.clear();
         }
 
         // These blocks do any final steps necessary to prepare to output results.
@@ -452,6 +524,204 @@ namespace mongo {
         }
     }
 
+    namespace {
+        /// The input document path read by a field path expression, or "" if it reads a variable.
+        string inputPath(const ExpressionFieldPath& expr) {
+            const FieldPath& withVariable = expr.getFieldPath();
+            if (withVariable.getPathLength() < 2)
+                return "";
+            if (withVariable.getFieldName(0) != "CURRENT"
+                    && withVariable.getFieldName(0) != "ROOT")
+                return "";
+            return withVariable.tail().getPath(false);
+        }
+
+        /// Index order doesn't tell missing, undefined and null apart, so runs can't either.
+        Value runKeyPart(const Value& value) {
+            if (value.missing() || value.getType() == Undefined)
+                return Value(BSONNULL);
+            return value;
+        }
+    }
+
+    bool DocumentSourceGroup::getStreamingKeys(vector<string>* idFields,
+                                               vector<string>* inputFields) const {
+        if (ExpressionFieldPath* fieldPath =
+                dynamic_cast<ExpressionFieldPath*>(pIdExpression.get())) {
+            const string path = inputPath(*fieldPath);
+            if (path.empty())
+                return false;
+            inputFields->push_back(path);
+            return true;
+        }
+
+        ExpressionObject* object = dynamic_cast<ExpressionObject*>(pIdExpression.get());
+        vector<pair<string, intrusive_ptr<ExpressionFieldPath> > > fields;
+        if (!object || !object->getFieldPaths(&fields) || fields.empty())
+            return false;
+
+        set<string> seenPaths;
+        for (size_t i = 0; i < fields.size(); i++) {
+            const string path = inputPath(*fields[i].second);
+            if (path.empty()
+                    || !seenPaths.insert(path).second
+                    || str::contains(fields[i].first, '.'))
+                return false;
+            idFields->push_back(fields[i].first);
+            inputFields->push_back(path);
+        }
+        return true;
+    }
+
+    BSONObj DocumentSourceGroup::getStreamingSort(const DocumentSourceSort* following,
+                                                  bool* satisfiesFollowing) const {
+        *satisfiesFollowing = false;
+
+        // The input order says nothing of the order of the elements unwound from it.
+        if (_unwind)
+            return BSONObj();
+
+        vector<string> idFields;
+        vector<string> inputFields;
+        if (!getStreamingKeys(&idFields, &inputFields))
+            return BSONObj();
+
+        // A following $sort on "_id", or on each "_id.<field>" in order, differs from the
+        // input order only in the directions, which we're free to pick.
+        vector<int> directions(inputFields.size(), 1);
+        if (following) {
+            BSONObjBuilder sortKey;
+            following->sortKeyToBson(&sortKey, false);
+            const BSONObj sortObj = sortKey.obj();
+
+            vector<int> sortDirections;
+            BSONObjIterator it(sortObj);
+            while (it.more() && sortDirections.size() < inputFields.size()) {
+                const BSONElement key = it.next();
+                const string expected = idFields.empty()
+                                        ? "_id"
+                                        : "_id." + idFields[sortDirections.size()];
+                if (expected != key.fieldName())
+                    break;
+                sortDirections.push_back(key.number() < 0 ? -1 : 1);
+            }
+
+            if (sortDirections.size() == inputFields.size() && !it.more()) {
+                directions = sortDirections;
+                *satisfiesFollowing = true;
+            }
+        }
+
+        BSONObjBuilder sort;
+        for (size_t i = 0; i < inputFields.size(); i++) {
+            sort.append(inputFields[i], directions[i]);
+        }
+        return sort.obj();
+    }
+
+    void DocumentSourceGroup::setStreaming(const BSONObj& sort) {
+        vector<string> inputFields;
+        _streamingIdFields.clear();
+        verify(getStreamingKeys(&_streamingIdFields, &inputFields));
+
+        _streamingDirections.clear();
+        BSONObjIterator it(sort);
+        while (it.more()) {
+            _streamingDirections.push_back(it.next().number() < 0 ? -1 : 1);
+        }
+        verify(_streamingDirections.size() == inputFields.size());
+
+        _streaming = true;
+    }
+
+    bool DocumentSourceGroup::sameRun(const Value& id1, const Value& id2) const {
+        if (_streamingIdFields.empty())
+            return Value::compare(runKeyPart(id1), runKeyPart(id2)) == 0;
+
+        const Document doc1 = id1.getDocument();
+        const Document doc2 = id2.getDocument();
+        for (size_t i = 0; i < _streamingIdFields.size(); i++) {
+            if (Value::compare(runKeyPart(doc1[_streamingIdFields[i]]),
+                               runKeyPart(doc2[_streamingIdFields[i]])) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    class DocumentSourceGroup::RunComparator {
+    public:
+        RunComparator(const vector<string>& idFields, const vector<int>& directions)
+            : _idFields(idFields)
+            , _directions(directions)
+        {}
+
+        bool operator() (GroupsMap::iterator lhs, GroupsMap::iterator rhs) const {
+            if (_idFields.empty())
+                return Value::compare(lhs->first, rhs->first) * _directions[0] < 0;
+
+            const Document lhsDoc = lhs->first.getDocument();
+            const Document rhsDoc = rhs->first.getDocument();
+            for (size_t i = 0; i < _idFields.size(); i++) {
+                const int cmp = Value::compare(lhsDoc[_idFields[i]], rhsDoc[_idFields[i]]);
+                if (cmp)
+                    return cmp * _directions[i] < 0;
+            }
+            return false;
+        }
+
+    private:
+        const vector<string>& _idFields;
+        const vector<int>& _directions;
+    };
+
+    void DocumentSourceGroup::readRun() {
+        _runGroups.clear();
+        _runIndex = 0;
+        groups.clear();
+
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        const bool mergeInputs = pExpCtx->getDoingMerge();
+
+        Value runId;
+        for (bool more = !pSource->eof(); more; more = pSource->advance()) {
+            const Document input = pSource->getCurrent();
+            const Variables vars (input);
+
+            Value id = pIdExpression->evaluate(vars);
+            if (id.missing())
+                id = Value(BSONNULL);
+
+            if (groups.empty()) {
+                runId = id;
+            }
+            else if (!sameRun(runId, id)) {
+                break; // input stays on the first document of the next run
+            }
+
+            const size_t oldSize = groups.size();
+            Accumulators& group = groups[id];
+            if (groups.size() != oldSize) {
+                group.reserve(numAccumulators);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    group.push_back(vpAccumulatorFactory[i]());
+                }
+            }
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group[i]->process(vpExpression[i]->evaluate(vars), mergeInputs);
+            }
+        }
+
+        // Missing and null ids can share a run; order them as a following $sort would.
+        for (GroupsMap::iterator it = groups.begin(); it != groups.end(); ++it) {
+            _runGroups.push_back(it);
+        }
+        if (_runGroups.size() > 1) {
+            std::sort(_runGroups.begin(), _runGroups.end(),
+                      RunComparator(_streamingIdFields, _streamingDirections));
+        }
+    }
+
     class DocumentSourceGroup::SpillSTLComparator {
     public:
         bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
@@ -469,34 +739,97 @@ namespace mongo {
         stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
 
         SortedFileWriter<Value, Value> writer;
-        switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
-        case 0: // no values, essentially a distinct
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+        for (size_t i=0; i < ptrs.size(); i++) {
+            writer.addAlreadySorted(ptrs[i]->first, spilledState(ptrs[i]->second));
+        }
+
+        groups.clear();
+        _memory.trySet(0);
+
+        return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+    }
+
+    void DocumentSourceGroup::reduceSpills(
+            vector<shared_ptr<Sorter<Value, Value>::Iterator> >* sortedFiles) {
+        scoped_ptr<Sorter<Value, Value>::Iterator> merged(
+                Sorter<Value, Value>::Iterator::merge(*sortedFiles,
+                                                      SortOptions(),
+                                                      SorterComparator()));
+
+        Accumulators accums;
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        accums.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            accums.push_back(vpAccumulatorFactory[i]());
+        }
+
+        // The merged stream is ordered by _id, so each run of equal ids is one group. Combine
+        // the partial states of each run and write them back out as a single sorted file.
+        SortedFileWriter<Value, Value> writer;
+        bool haveCurrent = merged->more();
+        pair<Value, Value> current;
+        if (haveCurrent)
+            current = merged->next();
+
+        while (haveCurrent) {
+            pExpCtx->checkForInterrupt();
+
+            for (size_t i = 0; i < numAccumulators; i++) {
+                accums[i]->reset();
             }
-            break;
+
+            const Value id = current.first;
+            while (haveCurrent && id == current.first) {
+                mergeSpilledState(current.second, accums);
+                haveCurrent = merged->more();
+                if (haveCurrent)
+                    current = merged->next();
+            }
+
+            writer.addAlreadySorted(id, spilledState(accums));
+        }
+
+        merged.reset(); // drop all references to the old spill files so they get deleted
+        sortedFiles->clear();
+        sortedFiles->push_back(shared_ptr<Sorter<Value, Value>::Iterator>(writer.done()));
+    }
+
+    Value DocumentSourceGroup::spilledState(const Accumulators& accums) {
+        switch (accums.size()) {
+        case 0: // no values, essentially a distinct
+            return Value();
 
         case 1: // just one value, use optimized serialization as single Value
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: { // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (size_t i = 0; i < accums.size(); i++) {
+                states.push_back(accums[i]->getValue(/*toBeMerged=*/true));
             }
+            return Value::consume(states);
+        }
+        }
+    }
+
+    void DocumentSourceGroup::mergeSpilledState(const Value& state, const Accumulators& accums) {
+        switch (accums.size()) { // mirrors switch in spilledState()
+        case 0: // no Accumulators so no Values
             break;
 
-        default: // multiple values, serialize as array-typed Value
-            for (size_t i=0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j=0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
-                }
-                writer.addAlreadySorted(ptrs[i]->first, Value::consume(accums));
+        case 1: // single accumulators serialize as a single Value
+            accums[0]->process(state, /*merging=*/true);
+            break;
+
+        default: { // multiple accumulators serialize as an array
+            const vector<Value>& accumulatorStates = state.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(accumulatorStates[i], /*merging=*/true);
             }
             break;
         }
-
-        groups.clear();
-
-        return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
+        }
     }
 
     Document DocumentSourceGroup::makeDocument(const Value& id,
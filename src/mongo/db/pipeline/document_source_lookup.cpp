@@ -0,0 +1,237 @@
+/**
+ * Copyright (c) 2013 10gen Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
+
+namespace mongo {
+
+    // Approximate number of bytes of foreign documents a hash join holds.  Past it, a join on
+    // an indexed foreign field switches to index lookups and any other join fails.
+    MONGO_EXPORT_SERVER_PARAMETER(internalLookupHashJoinMaxBytes, int, 32*1024*1024);
+
+    const char DocumentSourceLookup::lookupName[] = "$lookup";
+
+    DocumentSourceLookup::~DocumentSourceLookup() {
+    }
+
+    DocumentSourceLookup::DocumentSourceLookup(const intrusive_ptr<ExpressionContext> &pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _initialized(false)
+        , _hashJoin(false)
+        , _haveCurrent(false) {
+    }
+
+    const char *DocumentSourceLookup::getSourceName() const {
+        return lookupName;
+    }
+
+    bool DocumentSourceLookup::eof() {
+        return pSource->eof();
+    }
+
+    bool DocumentSourceLookup::advance() {
+        DocumentSource::advance(); // check for interrupts
+
+        _haveCurrent = false;
+        return pSource->advance();
+    }
+
+    Document DocumentSourceLookup::getCurrent() {
+        if (!_haveCurrent) {
+            lazyInit();
+
+            const Document input = pSource->getCurrent();
+            MutableDocument output(input);
+            output.setNestedField(*_as, lookup(joinKey(input.getNestedField(*_localField))));
+            _current = output.freeze();
+            _haveCurrent = true;
+        }
+        return _current;
+    }
+
+    Value DocumentSourceLookup::joinKey(const Value& value) {
+        // A query for null matches documents without the field too; so does the hash join.
+        return value.nullish() ? Value(BSONNULL) : value;
+    }
+
+    string DocumentSourceLookup::foreignNs() const {
+        return _db + "." + _from;
+    }
+
+    void DocumentSourceLookup::lazyInit() {
+        if (_initialized)
+            return;
+
+        uassert(17027, str::stream() << lookupName << " is only supported on mongod, and not "
+                                     << "on sharded collections",
+                _client);
+        _initialized = true;
+
+        bool indexed = false;
+        const string foreignField = _foreignField->getPath(false);
+        auto_ptr<DBClientCursor> indexes = _client->getIndexes(foreignNs());
+        while (indexes->more()) {
+            const BSONObj key = indexes->next().getObjectField("key");
+            if (foreignField == key.firstElementFieldName()) {
+                indexed = true;
+                break;
+            }
+        }
+
+        // Hash join unless the filtered foreign documents don't fit, then look them up by the
+        // index if there is one.
+        _hashJoin = true;
+        int bytes = 0;
+        auto_ptr<DBClientCursor> cursor = _client->query(foreignNs(), _query, 0, 0,
+                                                         _fields.isEmpty() ? NULL : &_fields);
+        while (cursor->more()) {
+            const BSONObj obj = cursor->next();
+            bytes += obj.objsize();
+            if (bytes > internalLookupHashJoinMaxBytes) {
+                uassert(17026, str::stream() << "Exceeded memory limit for " << lookupName
+                                             << ", index " << foreignNs() << " on "
+                                             << foreignField << " to join it by index lookups",
+                        indexed);
+                _table.clear();
+                _hashJoin = false;
+                return;
+            }
+
+            const Document foreign(obj);
+            _table[joinKey(foreign.getNestedField(*_foreignField))].push_back(Value(foreign));
+        }
+    }
+
+    Value DocumentSourceLookup::lookup(const Value& key) {
+        if (_hashJoin) {
+            Table::const_iterator it = _table.find(key);
+            return it == _table.end() ? Value(vector<Value>()) : Value(it->second);
+        }
+
+        BSONObjBuilder match;
+        match << _foreignField->getPath(false) << key;
+        BSONObj query = match.obj();
+        if (!_query.isEmpty())
+            query = BSON("$and" << BSON_ARRAY(query << _query));
+
+        // The query also finds arrays holding the key, which the hash join wouldn't.
+        vector<Value> matches;
+        auto_ptr<DBClientCursor> cursor = _client->query(foreignNs(), query, 0, 0,
+                                                         _fields.isEmpty() ? NULL : &_fields);
+        while (cursor->more()) {
+            DocumentSource::advance(); // check for interrupts
+
+            const Document foreign(cursor->next());
+            if (Value::compare(joinKey(foreign.getNestedField(*_foreignField)), key) == 0)
+                matches.push_back(Value(foreign));
+        }
+        return Value::consume(matches);
+    }
+
+    void DocumentSourceLookup::sourceToBson(BSONObjBuilder *pBuilder, bool explain) const {
+        BSONObjBuilder spec(pBuilder->subobjStart(lookupName));
+        spec.append("from", _from);
+        spec.append("localField", _localField->getPath(false));
+        spec.append("foreignField", _foreignField->getPath(false));
+        spec.append("as", _as->getPath(false));
+        if (!_query.isEmpty())
+            spec.append("query", _query);
+        if (!_fields.isEmpty())
+            spec.append("fields", _fields);
+        if (explain && _initialized)
+            spec.append("strategy", _hashJoin ? "hash" : "index");
+        spec.doneFast();
+    }
+
+    DocumentSource::GetDepsReturn DocumentSourceLookup::getDependencies(set<string>& deps) const {
+        deps.insert(_localField->getPath(false));
+        return SEE_NEXT;
+    }
+
+    intrusive_ptr<DocumentSource> DocumentSourceLookup::createFromBson(
+        BSONElement *pBsonElement,
+        const intrusive_ptr<ExpressionContext> &pExpCtx) {
+        uassert(17021, str::stream() << lookupName << " must be specified as an object",
+                pBsonElement->type() == Object);
+
+        intrusive_ptr<DocumentSourceLookup> pLookup(new DocumentSourceLookup(pExpCtx));
+
+        BSONForEach(elem, pBsonElement->embeddedObject()) {
+            const StringData name = elem.fieldNameStringData();
+            if (name == "query" || name == "fields") {
+                uassert(17024, str::stream() << lookupName << "'s " << name
+                                             << " must be an object",
+                        elem.type() == Object);
+                (name == "query" ? pLookup->_query : pLookup->_fields) = elem.Obj().getOwned();
+                continue;
+            }
+
+            uassert(17022, str::stream() << "unknown " << lookupName << " option " << name,
+                    name == "from" || name == "localField" || name == "foreignField" ||
+                    name == "as");
+            uassert(17023, str::stream() << lookupName << "'s " << name
+                                         << " must be a non-empty string",
+                    elem.type() == String && elem.valuestrsafe()[0] != 0);
+
+            if (name == "from") {
+                pLookup->_from = elem.str();
+            }
+            else {
+                FieldPath path(Expression::removeFieldPrefix(elem.str()));
+                (name == "localField" ? pLookup->_localField
+                 : name == "foreignField" ? pLookup->_foreignField
+                 : pLookup->_as).reset(new FieldPath(path));
+            }
+        }
+
+        uassert(17022, str::stream() << lookupName
+                                     << " needs from, localField, foreignField and as",
+                !pLookup->_from.empty() && pLookup->_localField && pLookup->_foreignField &&
+                pLookup->_as);
+
+        // The join needs the foreign field, whatever else the projection leaves out.
+        if (!pLookup->_fields.isEmpty()) {
+            const string foreignField = pLookup->_foreignField->getPath(false);
+            const BSONElement projected = pLookup->_fields[foreignField];
+            uassert(17025, str::stream() << lookupName << "'s fields can't exclude "
+                                         << foreignField,
+                    projected.eoo() || projected.trueValue());
+
+            bool inclusion = false;
+            BSONForEach(field, pLookup->_fields) {
+                if (field.trueValue() && strcmp(field.fieldName(), "_id") != 0)
+                    inclusion = true;
+            }
+            if (inclusion && projected.eoo()) {
+                BSONObjBuilder fields;
+                fields.appendElements(pLookup->_fields);
+                fields.append(foreignField, 1);
+                pLookup->_fields = fields.obj();
+            }
+        }
+
+        return pLookup;
+    }
+}
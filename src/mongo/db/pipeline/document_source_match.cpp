@@ -53,7 +53,7 @@ namespace mongo {
           in here, and give that pDocument to create the created subset of
           fields, and then convert that instead.
         */
-        BSONObjBuilder objBuilder;
+        BSONObjBuilder objBuilder(_sizeTracker);
         pDocument->toBson(&objBuilder);
         BSONObj obj(objBuilder.done());
 
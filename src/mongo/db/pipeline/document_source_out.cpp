@@ -18,11 +18,22 @@
 
 #include "db/pipeline/document_source.h"
 
+#include "mongo/client/dbclientcursor.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
     const char DocumentSourceOut::outName[] = "$out";
 
+    namespace {
+        // Bytes of documents inserted per batch.  Each batch takes the write lock once.
+        const int kBatchBytes = 8 * 1024 * 1024;
+
+        // Numbers temporary collections so concurrent $outs to one collection don't collide.
+        AtomicUInt32 tempCollectionNumber;
+    }
+
     DocumentSourceOut::~DocumentSourceOut() {
     }
 
@@ -31,37 +42,142 @@ namespace mongo {
     }
 
     bool DocumentSourceOut::eof() {
-        return pSource->eof();
+        if (!_done)
+            populate();
+
+        return true;
     }
 
     bool DocumentSourceOut::advance() {
         DocumentSource::advance(); // check for interrupts
 
-        return pSource->advance();
+        if (!_done)
+            populate();
+
+        return false;
     }
 
     Document DocumentSourceOut::getCurrent() {
-        return pSource->getCurrent();
+        verify(false); // always eof()
     }
 
     DocumentSourceOut::DocumentSourceOut(
-        BSONElement *pBsonElement,
-        const intrusive_ptr<ExpressionContext> &pExpCtx):
-        DocumentSource(pExpCtx) {
-        verify(false && "unimplemented");
+        const string& outputCollection,
+        const intrusive_ptr<ExpressionContext> &pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _outputCollection(outputCollection)
+        , _done(false)
+        , _batchBytes(0) {
+    }
+
+    void DocumentSourceOut::populate() {
+        uassert(17032, str::stream() << outName << " is only supported on mongod, and not on "
+                                     << "sharded collections",
+                _client);
+        _done = true;
+
+        const string outputNs = _db + "." + _outputCollection;
+        _tempNs = str::stream() << _db << ".tmp.agg_out." << _outputCollection << "_"
+                                << tempCollectionNumber.fetchAndAdd(1);
+
+        // Marked temp so a restart part way through drops it.
+        BSONObj info;
+        const string tempCollection = nsToCollectionSubstring(_tempNs).toString();
+        uassert(17033, str::stream() << "failed to create " << outName << " collection "
+                                     << _tempNs << ": " << info,
+                _client->runCommand(_db, BSON("create" << tempCollection << "temp" << true),
+                                    info));
+
+        try {
+            vector<Document> batch;
+            batch.reserve(DefaultBatchSize);
+            while (pSource->getNextBatch(&batch, DefaultBatchSize) > 0) {
+                for (size_t i = 0; i < batch.size(); i++) {
+                    BSONObjBuilder builder;
+                    batch[i]->toBson(&builder);
+                    _batch.push_back(builder.obj());
+                    _batchBytes += _batch.back().objsize();
+                    if (_batchBytes >= kBatchBytes)
+                        flushBatch();
+                }
+                batch.clear();
+            }
+            flushBatch();
+            pSource->dispose();
+
+            // An index built over loaded data sorts its keys once instead of inserting each.
+            copyIndexes();
+
+            uassert(17033, str::stream() << "failed to rename " << _tempNs << " to "
+                                         << outputNs << ": " << info,
+                    _client->runCommand("admin", BSON("renameCollection" << _tempNs
+                                                      << "to" << outputNs
+                                                      << "dropTarget" << true),
+                                        info));
+        }
+        catch (...) {
+            _client->dropCollection(_tempNs);
+            throw;
+        }
+    }
+
+    void DocumentSourceOut::flushBatch() {
+        if (_batch.empty())
+            return;
+
+        // Unordered, so one bad document doesn't stop the rest of the batch being written.  The
+        // error still fails the $out.
+        _client->insert(_tempNs, _batch, InsertOption_ContinueOnError);
+        checkLastError("insert into");
+
+        _batch.clear();
+        _batchBytes = 0;
+    }
+
+    void DocumentSourceOut::copyIndexes() {
+        const string outputNs = _db + "." + _outputCollection;
+        auto_ptr<DBClientCursor> indexes = _client->getIndexes(outputNs);
+        while (indexes->more()) {
+            const BSONObj index = indexes->next();
+            if (str::equals(index.getStringField("name"), "_id_"))
+                continue;
+
+            BSONObjBuilder spec;
+            BSONForEach(field, index) {
+                if (str::equals(field.fieldName(), "ns"))
+                    spec.append("ns", _tempNs);
+                else
+                    spec.append(field);
+            }
+            _client->insert(_db + ".system.indexes", spec.obj());
+            checkLastError("copy an index to");
+        }
+    }
+
+    void DocumentSourceOut::checkLastError(const string& action) {
+        const string error = _client->getLastError(_db);
+        uassert(17033, str::stream() << outName << " failed to " << action << " " << _tempNs
+                                     << ": " << error,
+                error.empty());
     }
 
     intrusive_ptr<DocumentSourceOut> DocumentSourceOut::createFromBson(
         BSONElement *pBsonElement,
         const intrusive_ptr<ExpressionContext> &pExpCtx) {
-        intrusive_ptr<DocumentSourceOut> pSource(
-            new DocumentSourceOut(pBsonElement, pExpCtx));
+        uassert(17031, str::stream() << outName << " must be given the name of a collection",
+                pBsonElement->type() == String);
+
+        const string outputCollection = pBsonElement->str();
+        uassert(17031, str::stream() << "invalid " << outName << " collection name "
+                                     << outputCollection,
+                !outputCollection.empty() && NamespaceString::normal(outputCollection) &&
+                !str::startsWith(outputCollection, "system."));
 
-        return pSource;
+        return new DocumentSourceOut(outputCollection, pExpCtx);
     }
 
     void DocumentSourceOut::sourceToBson(
         BSONObjBuilder *pBuilder, bool explain) const {
-        verify(false); // CW TODO
+        pBuilder->append(outName, _outputCollection);
     }
 }
@@ -50,8 +50,23 @@ namespace mongo {
     }
 
     Document DocumentSourceProject::getCurrent() {
-        Document pInDocument(pSource->getCurrent());
+        return project(pSource->getCurrent());
+    }
+
+    size_t DocumentSourceProject::getNextBatch(vector<Document>* batch, size_t maxDocs) {
+        pExpCtx->checkForInterrupt();
+
+        // project in place over the range our source appended
+        const size_t start = batch->size();
+        const size_t n = pSource->getNextBatch(batch, maxDocs);
+        for (size_t i = start; i < start + n; i++) {
+            (*batch)[i] = project((*batch)[i]);
+        }
+
+        return n;
+    }
 
+    Document DocumentSourceProject::project(const Document& pInDocument) const {
         /* create the result document */
         const size_t sizeHint = pEO->getSizeHint();
         MutableDocument out (sizeHint);
@@ -69,7 +84,7 @@ namespace mongo {
             // Make sure we return the same results as Projection class
 
             BSONObjBuilder inputBuilder;
-            pSource->getCurrent()->toBson(&inputBuilder);
+            pInDocument->toBson(&inputBuilder);
             BSONObj input = inputBuilder.done();
 
             BSONObjBuilder outputBuilder;
@@ -260,9 +260,13 @@ namespace mongo {
                 return -Value::compare(lhs, rhs);
         }
 
-        // compound sort
+        // compound sort.  Compare the keys' elements in place: Value::operator[] would copy each
+        // one, and this runs O(log n) times per document.
+        const vector<Value>& lhsKeys = lhs.getArray();
+        const vector<Value>& rhsKeys = rhs.getArray();
+        dassert(lhsKeys.size() == n && rhsKeys.size() == n);
         for (size_t i = 0; i < n; i++) {
-            int cmp = Value::compare(lhs[i], rhs[i]);
+            int cmp = Value::compare(lhsKeys[i], rhsKeys[i]);
             if (cmp) {
                 /* if necessary, adjust the return value by the key ordering */
                 if (!vAscending[i])
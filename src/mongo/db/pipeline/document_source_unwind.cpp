@@ -138,19 +138,26 @@ namespace mongo {
     }
 
     void DocumentSourceUnwind::mayAdvanceSource() {
-        while(_unwinder->eof()) {
-            // The _unwinder is exhausted.
-
-            if (pSource->eof()) {
-                // The source is exhausted.
-                return;
+        for (;;) {
+            while(_unwinder->eof()) {
+                // The _unwinder is exhausted.
+
+                if (pSource->eof()) {
+                    // The source is exhausted.
+                    return;
+                }
+                if (!pSource->advance()) {
+                    // The source is exhausted.
+                    return;
+                }
+                // Reset the _unwinder with pSource's next document.
+                _unwinder->resetDocument(pSource->getCurrent());
             }
-            if (!pSource->advance()) {
-                // The source is exhausted.
+
+            // Nothing else holds a rejected element, so the next one overwrites it in place.
+            if (!_filter || _filter->accept(_unwinder->getCurrent()))
                 return;
-            }
-            // Reset the _unwinder with pSource's next document.
-            _unwinder->resetDocument(pSource->getCurrent());
+            _unwinder->advance();
         }
     }
 
@@ -176,6 +183,46 @@ namespace mongo {
         return _unwinder->getCurrent();
     }
 
+    bool DocumentSourceUnwind::coalesce(const intrusive_ptr<DocumentSource> &pNextSource) {
+        if (_filter)
+            return false;
+
+        DocumentSourceFilterBase* filter =
+            dynamic_cast<DocumentSourceFilterBase*>(pNextSource.get());
+        if (!filter)
+            return false;
+
+        _filter = filter;
+        return true;
+    }
+
+    void DocumentSourceUnwind::resetUnwound(const Document& input) {
+        if (!_unwinder) {
+            verify(_unwindPath);
+            _unwinder.reset(new Unwinder(*_unwindPath));
+        }
+        _unwinder->resetDocument(input);
+    }
+
+    bool DocumentSourceUnwind::nextUnwound(Document* out) {
+        while (!_unwinder->eof()) {
+            // Let go of the last one first so that this one can overwrite it.
+            *out = Document();
+            *out = _unwinder->getCurrent();
+            _unwinder->advance();
+            if (!_filter || _filter->accept(*out))
+                return true;
+        }
+        *out = Document();
+        return false;
+    }
+
+    void DocumentSourceUnwind::addToBsonArray(BSONArrayBuilder *pBuilder, bool explain) const {
+        DocumentSource::addToBsonArray(pBuilder, explain);
+        if (_filter)
+            _filter->addToBsonArray(pBuilder, explain);
+    }
+
     void DocumentSourceUnwind::sourceToBson(
         BSONObjBuilder *pBuilder, bool explain) const {
         verify(_unwindPath);
@@ -185,7 +232,7 @@ namespace mongo {
     DocumentSource::GetDepsReturn DocumentSourceUnwind::getDependencies(set<string>& deps) const {
         verify(_unwindPath);
         deps.insert(_unwindPath->getPath(false));
-        return SEE_NEXT;
+        return _filter ? _filter->getDependencies(deps) : SEE_NEXT;
     }
 
     void DocumentSourceUnwind::unwindPath(const FieldPath &fieldPath) {
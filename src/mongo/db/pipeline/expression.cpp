@@ -19,6 +19,7 @@
 #include "pch.h"
 #include "db/pipeline/expression.h"
 
+#include <algorithm>
 #include <cstdio>
 #include "db/jsobj.h"
 #include "db/pipeline/builder.h"
@@ -1103,21 +1104,18 @@ namespace mongo {
         const Variables& vars
         ) const
     {
-        FieldMap::const_iterator end = _expressions.end();
-
         // This is used to mark fields we've done so that we can add the ones we haven't
-        set<string> doneFields;
+        vector<char> doneFields(_order.size(), false);
+        size_t numDone = 0;
 
         FieldIterator fields(currentDoc);
         while(fields.more()) {
             Document::FieldPair field (fields.next());
 
-            // TODO don't make a new string here
-            const string fieldName = field.first.toString();
-            FieldMap::const_iterator exprIter = _expressions.find(fieldName);
+            const int orderIndex = findOrderIndex(field.first);
 
             // This field is not supposed to be in the output (unless it is _id)
-            if (exprIter == end) {
+            if (orderIndex < 0) {
                 if (!_excludeId && _atRoot && field.first == "_id") {
                     // _id from the root doc is always included (until exclusion is supported)
                     // not updating doneFields since "_id" isn't in _expressions
@@ -1127,9 +1125,12 @@ namespace mongo {
             }
 
             // make sure we don't add this field again
-            doneFields.insert(exprIter->first);
+            if (!doneFields[orderIndex]) {
+                doneFields[orderIndex] = true;
+                numDone++;
+            }
 
-            Expression* expr = exprIter->second.get();
+            Expression* expr = _orderedExpressions[orderIndex]->second.get();
 
             if (!expr) {
                 // This means pull the matching field from the input document
@@ -1194,18 +1195,17 @@ namespace mongo {
             }
         }
 
-        if (doneFields.size() == _expressions.size())
+        if (numDone == _order.size())
             return;
 
         /* add any remaining fields we haven't already taken care of */
-        for (vector<string>::const_iterator i(_order.begin()); i!=_order.end(); ++i) {
-            FieldMap::const_iterator it = _expressions.find(*i);
-            string fieldName(it->first);
-
+        for (size_t i = 0; i < _order.size(); i++) {
             /* if we've already dealt with this field, above, do nothing */
-            if (doneFields.count(fieldName))
+            if (doneFields[i])
                 continue;
 
+            FieldMap::const_iterator it = _orderedExpressions[i];
+
             // this is a missing inclusion field
             if (!it->second)
                 continue;
@@ -1226,10 +1226,19 @@ namespace mongo {
                 continue;
 
 
-            out.addField(fieldName, pValue);
+            out.addField(it->first, pValue);
         }
     }
 
+    int ExpressionObject::findOrderIndex(StringData name) const {
+        // Unlike _expressions.find(), this doesn't need the name copied into a string.
+        vector<FieldIndex>::const_iterator it =
+            std::lower_bound(_fieldIndexes.begin(), _fieldIndexes.end(), FieldIndex(name, 0));
+        if (it == _fieldIndexes.end() || it->first != name)
+            return -1;
+        return it->second;
+    }
+
     size_t ExpressionObject::getSizeHint() const {
         // Note: this can overestimate, but that is better than underestimating
         return _expressions.size() + (_excludeId ? 0 : 1);
@@ -1258,7 +1267,13 @@ namespace mongo {
         intrusive_ptr<ExpressionObject> subObj = dynamic_cast<ExpressionObject*>(expr.get());
 
         if (!haveExpr) {
+            FieldMap::const_iterator it = _expressions.find(fieldPart);
+            const FieldIndex index(it->first, _order.size());
+            _fieldIndexes.insert(std::lower_bound(_fieldIndexes.begin(), _fieldIndexes.end(),
+                                                  index),
+                                 index);
             _order.push_back(fieldPart);
+            _orderedExpressions.push_back(it);
         }
         else { // we already have an expression or inclusion for this field
             if (fieldPath.getPathLength() == 1) {
@@ -1307,6 +1322,21 @@ namespace mongo {
         addField(theFieldPath, NULL);
     }
 
+    bool ExpressionObject::getFieldPaths(
+            vector<pair<string, intrusive_ptr<ExpressionFieldPath> > >* fields) const {
+        for (vector<string>::const_iterator it(_order.begin()); it!=_order.end(); ++it) {
+            FieldMap::const_iterator expr = _expressions.find(*it);
+            verify(expr != _expressions.end());
+
+            ExpressionFieldPath* fieldPath = dynamic_cast<ExpressionFieldPath*>(expr->second.get());
+            if (!fieldPath)
+                return false; // an inclusion or some other expression
+
+            fields->push_back(make_pair(*it, intrusive_ptr<ExpressionFieldPath>(fieldPath)));
+        }
+        return true;
+    }
+
     Value ExpressionObject::serialize() const {
         MutableDocument valBuilder;
         if (_excludeId)
@@ -1364,7 +1394,11 @@ namespace mongo {
         , _baseVar(_fieldPath.getFieldName(0) == "CURRENT" ? CURRENT :
                    _fieldPath.getFieldName(0) == "ROOT" ?    ROOT :
                                                              OTHER)
-    {}
+    {
+        _fieldHashes.reserve(_fieldPath.getPathLength());
+        for (size_t i = 0; i < _fieldPath.getPathLength(); i++)
+            _fieldHashes.push_back(Document::hashFieldName(_fieldPath.getFieldName(i)));
+    }
 
     intrusive_ptr<Expression> ExpressionFieldPath::optimize() {
         /* nothing can be done for these */
@@ -1401,10 +1435,10 @@ namespace mongo {
 
         /* if we've hit the end of the path, stop */
         if (index == _fieldPath.getPathLength() - 1)
-            return input[_fieldPath.getFieldName(index)];
+            return input.getField(_fieldPath.getFieldName(index), _fieldHashes[index]);
 
         // Try to dive deeper
-        const Value val = input[_fieldPath.getFieldName(index)];
+        const Value val = input.getField(_fieldPath.getFieldName(index), _fieldHashes[index]);
         switch (val.getType()) {
         case Object:
             return evaluatePath(index+1, val.getDocument());
@@ -582,6 +582,10 @@ namespace mongo {
 
         const FieldPath _fieldPath;
         const BaseVar _baseVar;
+
+        // Document::hashFieldName() of each field in _fieldPath, so evaluatePath() doesn't hash
+        // the same names again for every document.
+        vector<unsigned> _fieldHashes;
     };
 
 
@@ -904,6 +908,14 @@ namespace mongo {
          */
         size_t getFieldCount() const;
 
+        /**
+         * If every field of this object is a field path expression, such as
+         * {day: "$day", customer: "$cust.id"}, appends each field's name and expression in
+         * output order and returns true.
+         */
+        bool getFieldPaths(
+                vector<pair<string, intrusive_ptr<ExpressionFieldPath> > >* fields) const;
+
         /*
           Specialized BSON conversion that allows for writing out a
           $project specification.  This creates a standalone object, which must
@@ -946,6 +958,19 @@ namespace mongo {
         // this is used to maintain order for generated fields not in the source document
         vector<string> _order;
 
+        // _expressions' entry for each field of _order, in the same order.  Map iterators stay
+        // valid as fields are added, and see expressions that optimize() replaces.
+        vector<FieldMap::const_iterator> _orderedExpressions;
+
+        // The fields of _order sorted by name, each with its index in _order.  The names point
+        // at _expressions' keys.  Lets addToDocument() look up a document's field names
+        // without copying them into strings.
+        typedef pair<StringData, size_t> FieldIndex;
+        vector<FieldIndex> _fieldIndexes;
+
+        // Index in _order of the field named 'name', or -1 if there is none.
+        int findOrderIndex(StringData name) const;
+
         bool _excludeId;
         bool _atRoot;
     };
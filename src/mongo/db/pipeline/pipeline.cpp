@@ -17,6 +17,8 @@
 #include "pch.h"
 #include "db/pipeline/pipeline.h"
 
+#include <limits>
+
 #include "db/jsobj.h"
 #include "db/pipeline/accumulator.h"
 #include "db/pipeline/document.h"
@@ -65,6 +67,8 @@ namespace mongo {
          DocumentSourceGroup::createFromBson},
         {DocumentSourceLimit::limitName,
          DocumentSourceLimit::createFromBson},
+        {DocumentSourceLookup::lookupName,
+         DocumentSourceLookup::createFromBson},
         {DocumentSourceMatch::matchName,
          DocumentSourceMatch::createFromBson},
 #ifdef LATER // https://jira.mongodb.org/browse/SERVER-3253 
@@ -109,6 +113,11 @@ namespace mongo {
                 continue;
             }
 
+            // the time limit is enforced by the command processor
+            if (str::equals(pFieldName, "maxTimeMS")) {
+                continue;
+            }
+
             /* look for the aggregation command */
             if (!strcmp(pFieldName, commandName)) {
                 pPipeline->collectionName = cmdElement.String();
@@ -194,6 +203,10 @@ namespace mongo {
             verify(stage);
             stage->setPipelineStep(iStep);
             sources.push_back(stage);
+
+            uassert(17030, str::stream() << DocumentSourceOut::outName
+                                         << " can only be the final stage in the pipeline",
+                    iStep == nSteps - 1 || !dynamic_cast<DocumentSourceOut*>(stage.get()));
         }
 
         /* if there aren't any pipeline stages, there's nothing more to do */
@@ -292,6 +305,20 @@ namespace mongo {
                 sources.push_back(pTemp);
         }
 
+        /*
+          Let a $group unwind the arrays of an $unwind just before it
+          itself, see DocumentSourceGroup::absorbUnwind().  This saves a
+          Document per array element.
+        */
+        for (size_t srci = 1; srci < sources.size(); ++srci) {
+            DocumentSourceGroup* pGroup =
+                dynamic_cast<DocumentSourceGroup *>(sources[srci].get());
+            if (pGroup && pGroup->absorbUnwind(sources[srci - 1])) {
+                sources.erase(sources.begin() + srci - 1);
+                --srci;
+            }
+        }
+
         /* optimize the elements in the pipeline */
         for(SourceContainer::iterator iter(sources.begin()),
                                       listEnd(sources.end());
@@ -338,6 +365,36 @@ namespace mongo {
                 if (shardSource) pShardPipeline->sources.push_back(shardSource);
                 if (routerSource)          this->sources.push_front(routerSource);
 
+                /*
+                  A $sort followed by $skips and a $limit only needs each
+                  shard's first skip+limit documents, so give its shard
+                  half a $limit; the router still applies both.
+                 */
+                DocumentSourceSort* pSort =
+                    dynamic_cast<DocumentSourceSort*>(shardSource.get());
+                if (pSort && !pSort->getLimitSrc()) {
+                    long long skip = 0;
+                    SourceContainer::const_iterator iter(sources.begin());
+                    if (routerSource) ++iter;
+                    for (; iter != sources.end(); ++iter) {
+                        const DocumentSourceSkip* pSkip =
+                            dynamic_cast<DocumentSourceSkip*>(iter->get());
+                        if (!pSkip) break;
+                        if (pSkip->getSkip() > numeric_limits<long long>::max() - skip) {
+                            iter = sources.end(); // don't overflow, just leave the $sort alone
+                            break;
+                        }
+                        skip += pSkip->getSkip();
+                    }
+
+                    const DocumentSourceLimit* pLimit = (iter == sources.end()
+                        ? NULL : dynamic_cast<DocumentSourceLimit*>(iter->get()));
+                    if (pLimit && pLimit->getLimit() <= numeric_limits<long long>::max() - skip) {
+                        pSort->coalesce(DocumentSourceLimit::create(pCtx,
+                                                                    skip + pLimit->getLimit()));
+                    }
+                }
+
                 break;
             }
         }
@@ -432,18 +489,21 @@ namespace mongo {
             // cant use subArrayStart() due to error handling
             BSONArrayBuilder resultArray;
             DocumentSource* finalSource = sources.back().get();
-            for (bool hasDoc = !finalSource->eof(); hasDoc; hasDoc = finalSource->advance()) {
-                Document pDocument(finalSource->getCurrent());
-
-                /* add the document to the result set */
-                BSONObjBuilder documentBuilder (resultArray.subobjStart());
-                pDocument->toBson(&documentBuilder);
-                documentBuilder.doneFast();
-                // object will be too large, assert. the extra 1KB is for headers
-                uassert(16389,
-                        str::stream() << "aggregation result exceeds maximum document size ("
-                                      << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
-                        resultArray.len() < BSONObjMaxUserSize - 1024);
+            vector<Document> batch;
+            batch.reserve(DocumentSource::DefaultBatchSize);
+            while (finalSource->getNextBatch(&batch, DocumentSource::DefaultBatchSize) > 0) {
+                for (size_t i = 0; i < batch.size(); i++) {
+                    /* add the document to the result set */
+                    BSONObjBuilder documentBuilder (resultArray.subobjStart());
+                    batch[i]->toBson(&documentBuilder);
+                    documentBuilder.doneFast();
+                    // object will be too large, assert. the extra 1KB is for headers
+                    uassert(16389,
+                            str::stream() << "aggregation result exceeds maximum document size ("
+                                          << BSONObjMaxUserSize / (1024 * 1024) << "MB)",
+                            resultArray.len() < BSONObjMaxUserSize - 1024);
+                }
+                batch.clear();
             }
 
             resultArray.done();
@@ -508,4 +568,20 @@ namespace mongo {
         sources.push_front(source);
     }
 
+    intrusive_ptr<DocumentSourceSort> Pipeline::popMergeSort() {
+        if (sources.empty())
+            return NULL;
+
+        intrusive_ptr<DocumentSourceSort> pSort =
+            dynamic_cast<DocumentSourceSort*>(sources.front().get());
+        if (!pSort)
+            return NULL;
+
+        sources.pop_front();
+        if (pSort->getLimitSrc())
+            sources.push_front(pSort->getLimitSrc());
+
+        return pSort;
+    }
+
 } // namespace mongo
@@ -29,6 +29,7 @@ namespace mongo {
     class BSONArrayBuilder;
     class DocumentSource;
     class DocumentSourceProject;
+    class DocumentSourceSort;
     class Expression;
     class ExpressionContext;
     class ExpressionNary;
@@ -129,6 +130,16 @@ namespace mongo {
         /// The initial source is special since it varies between mongos and mongod.
         void addInitialSource(intrusive_ptr<DocumentSource> source);
 
+        /**
+          If, after splitForSharded(), this pipeline starts with a $sort, the
+          shards ran it too.  Removes and returns it, putting back a $limit
+          coalesced into it, so the shards' results can be merged in its
+          order instead of being sorted again.
+
+          @returns the $sort, or NULL if this pipeline doesn't start with one
+         */
+        intrusive_ptr<DocumentSourceSort> popMergeSort();
+
         /// The source that represents the output. Returns a non-owning pointer.
         DocumentSource* output() { return sources.back().get(); }
 
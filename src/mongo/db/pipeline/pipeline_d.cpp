@@ -19,16 +19,258 @@
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <boost/bind.hpp>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/cursor.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/instance.h"
+#include "mongo/db/interrupt_status_mongod.h"
+#include "mongo/db/matcher.h"
+#include "mongo/db/namespace_details.h"
 #include "mongo/db/parsed_query.h"
+#include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query_optimizer.h"
 
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * Feeds a pipeline on a ParallelCollectionScan worker the documents of its partition
+         * that match the query.  Nothing is read until the worker first asks.
+         */
+        class DocumentSourcePartition : public DocumentSource {
+        public:
+            DocumentSourcePartition(ParallelCollectionScan::Partition* partition,
+                                    const BSONObj& query,
+                                    const set<string>& deps,
+                                    bool haveDeps,
+                                    const intrusive_ptr<ExpressionContext>& pExpCtx)
+                : DocumentSource(pExpCtx)
+                , _partition(partition)
+                , _query(query)
+                , _deps(deps)
+                , _haveDeps(haveDeps)
+                , _started(false)
+                , _haveCurrent(false) {
+            }
+
+            virtual bool eof() {
+                start();
+                return !_haveCurrent;
+            }
+
+            virtual bool advance() {
+                DocumentSource::advance(); // check for interrupts
+
+                if (eof())
+                    return false;
+                findNext();
+                return _haveCurrent;
+            }
+
+            virtual Document getCurrent() {
+                start();
+                verify(_haveCurrent);
+                return _current;
+            }
+
+            virtual void setSource(DocumentSource *pSource) {
+                /* this doesn't take a source */
+                verify(false);
+            }
+
+        protected:
+            virtual void sourceToBson(BSONObjBuilder *pBuilder, bool explain) const {
+            }
+
+        private:
+            void start() {
+                if (_started)
+                    return;
+                _started = true;
+                // Built here, on the worker, so nothing of theirs is shared between threads.
+                _matcher.reset(new Matcher(_query));
+                if (_haveDeps)
+                    _parsedDeps = parseDeps(_deps);
+                findNext();
+            }
+
+            void findNext() {
+                BSONObj obj;
+                while ((_haveCurrent = _partition->next(&obj))) {
+                    if (_matcher->matches(obj)) {
+                        _current = _haveDeps ? documentFromBsonWithDeps(obj, _parsedDeps)
+                                             : Document(obj);
+                        return;
+                    }
+                }
+            }
+
+            ParallelCollectionScan::Partition* _partition;
+            const BSONObj _query;
+            scoped_ptr<Matcher> _matcher;
+            const set<string> _deps;
+            const bool _haveDeps;
+            ParsedDeps _parsedDeps;
+            bool _started;
+            bool _haveCurrent;
+            Document _current;
+        };
+
+        /**
+         * Hands out Documents already in memory, here the workers' partial groups.
+         */
+        class DocumentSourceDocuments : public DocumentSource {
+        public:
+            DocumentSourceDocuments(vector<Document>* docs,
+                                    const intrusive_ptr<ExpressionContext>& pExpCtx)
+                : DocumentSource(pExpCtx)
+                , _pos(0) {
+                _docs.swap(*docs);
+            }
+
+            virtual bool eof() {
+                return _pos == _docs.size();
+            }
+
+            virtual bool advance() {
+                DocumentSource::advance(); // check for interrupts
+
+                if (eof())
+                    return false;
+                ++_pos;
+                return !eof();
+            }
+
+            virtual Document getCurrent() {
+                verify(!eof());
+                return _docs[_pos];
+            }
+
+            virtual void setSource(DocumentSource *pSource) {
+                /* this doesn't take a source */
+                verify(false);
+            }
+
+        protected:
+            virtual void sourceToBson(BSONObjBuilder *pBuilder, bool explain) const {
+            }
+
+        private:
+            vector<Document> _docs;
+            size_t _pos;
+        };
+
+        void drainPartition(const vector<DocumentSource*>* finals,
+                            vector<vector<Document> >* results,
+                            size_t i) {
+            DocumentSource* source = (*finals)[i];
+            while (source->getNextBatch(&(*results)[i], DocumentSource::DefaultBatchSize) > 0) {
+            }
+        }
+
+    }
+
+    bool PipelineD::groupInParallel(
+        const intrusive_ptr<Pipeline> &pPipeline,
+        NamespaceDetails *nsd,
+        const BSONObj &query,
+        const intrusive_ptr<ExpressionContext> &pExpCtx) {
+
+        const int threads = nsd ? ParallelCollectionScan::threadsFor(nsd) : 1;
+        if (threads <= 1 || pPipeline->isExplain() || pExpCtx->getInShard() ||
+            pExpCtx->getInRouter() || !ParallelCollectionScan::canMatchInParallel(query))
+            return false;
+
+        // The workers can run the $match, $project and $unwind stages up to a $group, and the
+        // $group's shard half if nothing it accumulates depends on the order documents come in.
+        Pipeline::SourceContainer& sources = pPipeline->sources;
+        BSONArrayBuilder stages;
+        size_t nStages = 0;
+        for (; nStages < sources.size(); nStages++) {
+            DocumentSource* source = sources[nStages].get();
+            if (dynamic_cast<DocumentSourceGroup*>(source))
+                break;
+            if (!dynamic_cast<DocumentSourceMatch*>(source) &&
+                !dynamic_cast<DocumentSourceProject*>(source) &&
+                !dynamic_cast<DocumentSourceUnwind*>(source))
+                return false;
+            source->addToBsonArray(&stages);
+        }
+        if (nStages == sources.size())
+            return false;
+
+        // The $group comes last in its serialization, after any $unwind it absorbed.
+        DocumentSourceGroup* group = static_cast<DocumentSourceGroup*>(sources[nStages].get());
+        BSONArrayBuilder groupBuilder;
+        group->addToBsonArray(&groupBuilder);
+        const BSONObj groupStages = groupBuilder.arr();
+        BSONObj groupStage;
+        BSONForEach(stage, groupStages) {
+            groupStage = stage.Obj().getOwned();
+            stages.append(groupStage);
+        }
+        BSONForEach(field, groupStage.firstElement().Obj()) {
+            if (str::equals(field.fieldName(), "_id"))
+                continue;
+            const StringData op = field.Obj().firstElementFieldName();
+            if (op == "$first" || op == "$last" || op == "$push")
+                return false;
+        }
+
+        set<string> deps;
+        DocumentSource::GetDepsReturn status = DocumentSource::SEE_NEXT;
+        for (size_t i = 0; i <= nStages && status == DocumentSource::SEE_NEXT; i++) {
+            status = sources[i]->getDependencies(deps);
+        }
+        const bool haveDeps = (status == DocumentSource::EXHAUSTIVE);
+
+        BSONObj command = BSON("aggregate" << pPipeline->getCollectionName()
+                               << "pipeline" << stages.arr());
+
+        // Each worker gets a pipeline of its own, parsed here from the stages above.
+        ParallelCollectionScan scan(nsd, threads);
+        vector<intrusive_ptr<Pipeline> > pipelines;
+        vector<DocumentSource*> finals;
+        for (size_t i = 0; i < scan.numPartitions(); i++) {
+            intrusive_ptr<ExpressionContext> pCtx(
+                ExpressionContext::create(&InterruptStatusMongod::status));
+            pCtx->setInShard(true);
+            pCtx->setExtSortAllowed(pExpCtx->getExtSortAllowed());
+
+            string errmsg;
+            intrusive_ptr<Pipeline> pipeline = Pipeline::parseCommand(errmsg, command, pCtx);
+            massert(17029, str::stream() << "couldn't parse the parallel part of a pipeline: "
+                                         << errmsg,
+                    pipeline);
+            pipeline->addInitialSource(new DocumentSourcePartition(
+                    scan.partition(i), query, deps, haveDeps, pCtx));
+            pipeline->stitch();
+
+            pipelines.push_back(pipeline);
+            finals.push_back(pipeline->sources.back().get());
+        }
+
+        vector<vector<Document> > results(scan.numPartitions());
+        scan.run(boost::bind(&drainPartition, &finals, &results, _1));
+
+        vector<Document> partials;
+        for (size_t i = 0; i < results.size(); i++) {
+            partials.insert(partials.end(), results[i].begin(), results[i].end());
+        }
+
+        intrusive_ptr<DocumentSource> merger = group->getRouterSource();
+        sources.erase(sources.begin(), sources.begin() + nStages + 1);
+        sources.push_front(merger);
+        pPipeline->addInitialSource(new DocumentSourceDocuments(&partials, pExpCtx));
+        return true;
+    }
+
     void PipelineD::prepareCursorSource(
         const intrusive_ptr<Pipeline> &pPipeline,
         const string &dbName,
@@ -37,6 +279,20 @@ namespace mongo {
         // We will be modifying the source vector as we go
         Pipeline::SourceContainer& sources = pPipeline->sources;
 
+        for (size_t i = 0; i < sources.size(); i++) {
+            DocumentSourceLookup* lookup = dynamic_cast<DocumentSourceLookup*>(sources[i].get());
+            if (lookup) {
+                lookup->_client.reset(new DBDirectClient);
+                lookup->_db = dbName;
+            }
+
+            DocumentSourceOut* out = dynamic_cast<DocumentSourceOut*>(sources[i].get());
+            if (out) {
+                out->_client.reset(new DBDirectClient);
+                out->_db = dbName;
+            }
+        }
+
         if (!sources.empty()) {
             DocumentSource* first = sources.front().get();
             DocumentSourceGeoNear* geoNear = dynamic_cast<DocumentSourceGeoNear*>(first);
@@ -111,6 +367,29 @@ namespace mongo {
             }
         }
 
+        /*
+          Without a leading $sort, a leading $group on indexed fields can
+          still use the index order: it then emits each group as soon as the
+          scan is past it, instead of holding all of them.  If the $sort after
+          the group is on the same keys it can go too.
+        */
+        intrusive_ptr<DocumentSourceGroup> pGroup;
+        bool groupSatisfiesSort = false;
+        if (!pSort && !sources.empty()) {
+            pGroup = dynamic_cast<DocumentSourceGroup *>(sources.front().get());
+            if (pGroup) {
+                const DocumentSourceSort* following = sources.size() > 1
+                    ? dynamic_cast<DocumentSourceSort *>(sources[1].get())
+                    : NULL;
+                const BSONObj groupSort =
+                    pGroup->getStreamingSort(following, &groupSatisfiesSort);
+                if (groupSort.isEmpty())
+                    pGroup.reset();
+                else
+                    sortBuilder.appendElements(groupSort);
+            }
+        }
+
         /* Create the sort object; see comments on the query object above */
         BSONObj sortObj = sortBuilder.obj();
 
@@ -155,7 +434,7 @@ namespace mongo {
 
         shared_ptr<Cursor> pCursor;
         bool initSort = false;
-        if (pSort) {
+        if (pSort || pGroup) {
             const BSONObj queryAndSort = BSON("$query" << queryObj << "$orderby" << sortObj);
             shared_ptr<ParsedQuery> pq (new ParsedQuery(
                 fullName.c_str(), 0, 0, QueryOption_NoCursorTimeout, queryAndSort, projection));
@@ -166,7 +445,7 @@ namespace mongo {
                     fullName.c_str(), queryObj, sortObj,
                     QueryPlanSelectionPolicy::any(), pq));
 
-            if (pSortedCursor.get()) {
+            if (pSortedCursor.get() && pSort) {
                 /* success:  remove the sort from the pipeline */
                 sources.pop_front();
 
@@ -175,6 +454,25 @@ namespace mongo {
                     sources.push_front(pSort->getLimitSrc());
                 }
 
+                pCursor = pSortedCursor;
+                initSort = true;
+            }
+            else if (pSortedCursor.get() && !pSortedCursor->isMultiKey()) {
+                // An array would put one document under several keys, so only stream over
+                // an index without any.
+                pGroup->setStreaming(sortObj);
+
+                if (groupSatisfiesSort) {
+                    intrusive_ptr<DocumentSourceSort> following =
+                        static_cast<DocumentSourceSort *>(sources[1].get());
+                    sources.erase(sources.begin() + 1);
+
+                    if (following->getLimitSrc()) {
+                        // need to reinsert coalesced $limit after removing $sort
+                        sources.insert(sources.begin() + 1, following->getLimitSrc());
+                    }
+                }
+
                 pCursor = pSortedCursor;
                 initSort = true;
             }
@@ -193,6 +491,12 @@ namespace mongo {
             pCursor = pUnsortedCursor;
         }
 
+        // A scan of the whole collection feeding a $group can be split between threads.
+        if (!initSort && dynamic_cast<BasicCursor*>(pCursor.get()) &&
+            groupInParallel(pPipeline, nsdetails(fullName), queryObj, pExpCtx)) {
+            return;
+        }
+
         // Now wrap the Cursor in ClientCursor
         ClientCursor::Holder cursor(
                 new ClientCursor(QueryOption_NoCursorTimeout, pCursor, fullName));
@@ -20,6 +20,7 @@
 
 namespace mongo {
     class DocumentSourceCursor;
+    class NamespaceDetails;
     class Pipeline;
 
     /*
@@ -58,6 +59,23 @@ namespace mongo {
 
     private:
         PipelineD(); // does not exist:  prevent instantiation
+
+        /**
+           Run the $match, $project and $unwind stages before a leading $group
+           and the $group itself on several threads, each scanning part of the
+           collection, then replace them with the merging half of the $group
+           fed by the threads' results.  Only for a pipeline that would
+           otherwise scan the whole collection; see ParallelCollectionScan.
+
+           @param query the initial match already taken out of the pipeline
+           @returns false, having changed nothing, if the pipeline isn't one
+             this can run or the collection isn't worth the threads
+         */
+        static bool groupInParallel(
+            const intrusive_ptr<Pipeline> &pPipeline,
+            NamespaceDetails *nsd,
+            const BSONObj &query,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
     };
 
 } // namespace mongo
@@ -113,6 +113,31 @@ namespace mongo {
                 _arrayOpType = ARRAY_OP_POSITIONAL;
             }
         }
+
+        compileTopLevel();
+    }
+
+    void Projection::compileTopLevel() {
+        if ( _include || _special || !_matchers.empty() || _arrayOpType != ARRAY_OP_NORMAL )
+            return;
+
+        vector<string> fields;
+        for ( FieldMap::const_iterator i = _fields.begin(); i != _fields.end(); ++i ) {
+            const Projection& sub = *i->second;
+            if ( !sub._fields.empty() || sub._special || !sub._include )
+                return;
+            if ( i->first != "_id" )
+                fields.push_back( i->first );
+        }
+        if ( _includeID )
+            fields.push_back( "_id" );
+        if ( fields.empty() || fields.size() > kMaxTopLevelFields )
+            return;
+
+        _topLevelOnly = true;
+        _topLevelFields.swap( fields );
+        for ( size_t i = 0; i < _topLevelFields.size(); i++ )
+            _topLevelIndexes[_topLevelFields[i]] = i;
     }
 
     void Projection::add(const string& field, bool include) {
@@ -155,6 +180,11 @@ namespace mongo {
     }
 
     void Projection::transform( const BSONObj& in , BSONObjBuilder& b, const MatchDetails* details ) const {
+        if ( _topLevelOnly ) {
+            transformTopLevel( in, b );
+            return;
+        }
+
         const ArrayOpType& arrayOpType = getArrayOpType();
 
         BSONObjIterator i(in);
@@ -200,8 +230,66 @@ namespace mongo {
         }
     }
 
+    void Projection::transformTopLevel( const BSONObj& in , BSONObjBuilder& b ) const {
+        if ( transformKnownLayout( in, b ) )
+            return;
+
+        FieldLayout layout;
+        unsigned seen = 0;
+        bool repeated = false;
+        int ordinal = 0;
+        BSONObjIterator i( in );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            StringMap<int>::const_iterator field = _topLevelIndexes.find( e.fieldName() );
+            if ( field != _topLevelIndexes.end() ) {
+                b.append( e );
+                const unsigned bit = 1U << field->second;
+                repeated = repeated || ( seen & bit );
+                seen |= bit;
+                layout.push_back( make_pair( ordinal, field->second ) );
+            }
+            ordinal++;
+        }
+
+        // documents missing some of the fields always take the full pass
+        if ( repeated || layout.size() != _topLevelFields.size() )
+            return;
+        if ( _layouts.size() == kMaxLayouts )
+            _layouts.pop_back();
+        _layouts.insert( _layouts.begin(), layout );
+    }
+
+    bool Projection::transformKnownLayout( const BSONObj& in , BSONObjBuilder& b ) const {
+        BSONElement found[kMaxTopLevelFields];
+        for ( size_t l = 0; l < _layouts.size(); l++ ) {
+            const FieldLayout& layout = _layouts[l];
+            size_t n = 0;
+            int ordinal = 0;
+            BSONObjIterator i( in );
+            while ( n < layout.size() && i.more() ) {
+                BSONElement e = i.next();
+                if ( ordinal++ != layout[n].first )
+                    continue;
+                if ( !mongoutils::str::equals( e.fieldName(),
+                                               _topLevelFields[layout[n].second].c_str() ) )
+                    break;
+                found[n++] = e;
+            }
+            if ( n < layout.size() )
+                continue;
+
+            for ( size_t j = 0; j < n; j++ )
+                b.append( found[j] );
+            if ( l > 0 )
+                std::rotate( _layouts.begin(), _layouts.begin() + l, _layouts.begin() + l + 1 );
+            return true;
+        }
+        return false;
+    }
+
     BSONObj Projection::transform( const BSONObj& in, const MatchDetails* details ) const {
-        BSONObjBuilder b;
+        BSONObjBuilder b( _sizeTracker );
         transform( in , b, details );
         return b.obj();
     }
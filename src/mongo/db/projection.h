@@ -69,7 +69,8 @@ namespace mongo {
             _skip(0) ,
             _limit(-1) ,
             _arrayOpType(ARRAY_OP_NORMAL),
-            _hasNonSimple(false) {
+            _hasNonSimple(false),
+            _topLevelOnly(false) {
         }
 
         /**
@@ -134,6 +135,20 @@ namespace mongo {
         void add( const string& field, int skip, int limit );
         void appendArray( BSONObjBuilder& b , const BSONObj& a , bool nested=false) const;
 
+        /**
+         * sets up _topLevelFields if this projection only includes whole top level fields,
+         * e.g. { _id : 0 , a : 1 , b : 1 }
+         */
+        void compileTopLevel();
+
+        /**
+         * transform() for a top level only projection: looks for the fields where one of the
+         * recently seen layouts has them, and otherwise does a full pass and learns this
+         * document's layout.
+         */
+        void transformTopLevel( const BSONObj& in , BSONObjBuilder& b ) const;
+        bool transformKnownLayout( const BSONObj& in , BSONObjBuilder& b ) const;
+
         bool _include; // true if default at this level is to include
         bool _special; // true if this level can't be skipped or included without recursing
 
@@ -153,6 +168,22 @@ namespace mongo {
         ArrayOpType _arrayOpType;
 
         bool _hasNonSimple;
+
+        // Where a top level only projection found all its fields in one document:
+        // ( ordinal of the element in the document , index into _topLevelFields ) for each, in
+        // document order.  A document with the same fields at those ordinals has nothing else
+        // to project, so the rest of it isn't looked at; if it repeats one of the field names
+        // further on, only the first is returned.
+        typedef vector< pair<int,int> > FieldLayout;
+        enum { kMaxTopLevelFields = 16 , kMaxLayouts = 4 };
+
+        bool _topLevelOnly;
+        vector<string> _topLevelFields;
+        StringMap<int> _topLevelIndexes; // into _topLevelFields
+        mutable vector<FieldLayout> _layouts; // most recently used first
+
+        // sizes of recent transform() results, so the next one can start out big enough
+        BSONSizeTracker _sizeTracker;
     };
 
 
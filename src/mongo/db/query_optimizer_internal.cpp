@@ -26,6 +26,7 @@
 #include "mongo/db/parsed_query.h"
 #include "mongo/db/query_plan_selection_policy.h"
 #include "mongo/db/queryutil.h"
+#include "mongo/db/server_parameters.h"
 
 //#define DEBUGQO(x) cout << x << endl;
 #define DEBUGQO(x)
@@ -412,6 +413,40 @@ namespace mongo {
         _allowSpecial( allowSpecial ) {
     }
 
+    // When more indexed plans than this are candidates for racing, only race the ones whose
+    // index bounds look cheapest.  0 races them all.
+    MONGO_EXPORT_SERVER_PARAMETER(queryOptimizerMaxRacedPlans, int, 0);
+
+    namespace {
+
+        // How far a candidate's index bounds are probed to cost it.
+        const long long kCostProbeKeys = 100;
+
+        /**
+         * @return the keys 'plan' scans, if it scans no more than kCostProbeKeys, otherwise
+         *     kCostProbeKeys + 1.  The bounds of each candidate are the sharpest statistic there
+         *     is for the query at hand, and selective ones, which are what racing is costly
+         *     for, are counted exactly.
+         */
+        long long estimatedKeysScanned( const QueryPlan& plan ) {
+            shared_ptr<Cursor> c = plan.newCursor();
+            while( c->ok() && c->nscanned() <= kCostProbeKeys ) {
+                c->advance();
+            }
+            return c->ok() ? kCostProbeKeys + 1 : c->nscanned();
+        }
+
+        struct CostedPlan {
+            CostedPlan( const shared_ptr<QueryPlan>& plan, long long cost ) :
+                plan( plan ), cost( cost ) {
+            }
+            shared_ptr<QueryPlan> plan;
+            long long cost;
+            bool operator<( const CostedPlan& other ) const { return cost < other.cost; }
+        };
+
+    } // namespace
+
     void QueryPlanGenerator::addInitialPlans() {
         const char* ns = _qps.frsp().ns();
         NamespaceDetails* d = nsdetails( ns );
@@ -478,6 +513,8 @@ namespace mongo {
             return;
         }
 
+        pruneByEstimatedCost( &plans );
+
         for( vector<shared_ptr<QueryPlan> >::const_iterator i = plans.begin(); i != plans.end();
             ++i ) {
             _qps.addCandidatePlan( *i );
@@ -486,6 +523,43 @@ namespace mongo {
         _qps.addCandidatePlan( newPlan( d, -1 ) );
     }
     
+    void QueryPlanGenerator::pruneByEstimatedCost( vector<shared_ptr<QueryPlan> >* plans ) const {
+        const size_t maxPlans = queryOptimizerMaxRacedPlans;
+        if ( maxPlans == 0 || plans->size() <= maxPlans ) {
+            return;
+        }
+
+        vector<CostedPlan> costed;
+        for( vector<shared_ptr<QueryPlan> >::const_iterator i = plans->begin(); i != plans->end();
+            ++i ) {
+            costed.push_back( CostedPlan( *i, estimatedKeysScanned( **i ) ) );
+        }
+        // Ties keep index order.
+        std::stable_sort( costed.begin(), costed.end() );
+
+        // With a sort, an in order plan can win by stopping early, whatever its bounds; keep
+        // the cheapest one in the race.
+        if ( !_qps.order().isEmpty() ) {
+            bool keptInOrder = false;
+            for( size_t i = 0; i < maxPlans; ++i ) {
+                keptInOrder = keptInOrder || !costed[ i ].plan->scanAndOrderRequired();
+            }
+            for( size_t i = maxPlans; !keptInOrder && i < costed.size(); ++i ) {
+                if ( !costed[ i ].plan->scanAndOrderRequired() ) {
+                    std::swap( costed[ maxPlans - 1 ], costed[ i ] );
+                    keptInOrder = true;
+                }
+            }
+        }
+
+        LOG(1) << "racing " << maxPlans << " of " << plans->size() << " candidate plans for "
+               << _qps.originalQuery() << endl;
+        plans->clear();
+        for( size_t i = 0; i < maxPlans; ++i ) {
+            plans->push_back( costed[ i ].plan );
+        }
+    }
+
     bool QueryPlanGenerator::addShortCircuitPlan( NamespaceDetails* d ) {
         return
             // The collection is missing.
@@ -340,6 +340,12 @@ namespace mongo {
 
         void warnOnCappedIdTableScan() const;
 
+        /**
+         * Cuts 'plans' down to the queryOptimizerMaxRacedPlans whose index bounds look
+         * cheapest, if there are more; see estimatedKeysScanned().
+         */
+        void pruneByEstimatedCost( vector<shared_ptr<QueryPlan> >* plans ) const;
+
         QueryPlanSet& _qps;
         auto_ptr<FieldRangeSetPair> _originalFrsp;
         shared_ptr<const ParsedQuery> _parsedQuery;
@@ -234,6 +234,10 @@ doneCheckOrder:
             _utility = Disallowed;
         }
 
+        if ( _descriptor->isPartial() && !queryImpliesPartialFilter() ) {
+            _utility = Disallowed;
+        }
+
         if ( _parsedQuery && _parsedQuery->getFields() && !_d->isMultikey( _idxNo ) ) {
             // Does not check modifiedKeys()
             _keyFieldsOnly.reset( _parsedQuery->getFields()->checkKey( _index->keyPattern() ) );
@@ -396,6 +400,23 @@ doneCheckOrder:
         return matcher()->docMatcher().hasExistsFalse();
     }
     
+    bool QueryPlan::queryImpliesPartialFilter() const {
+        // The filter is made of ranges that match exactly the documents with a value in each,
+        // see prepareToBuildIndex().  The multikey ranges of the query hold a value of every
+        // document it matches, so if they're within the filter's every match is in the index.
+        FieldRangeSet filter( _frs.ns(), _descriptor->partialFilter(), true, true );
+        if ( !filter.mustBeExactMatchRepresentation() ) {
+            return false;
+        }
+        for ( map<string,FieldRange>::const_iterator i = filter.ranges().begin();
+              i != filter.ranges().end(); ++i ) {
+            if ( !( _frsMulti.range( i->first.c_str() ) <= i->second ) ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     bool QueryPlan::queryBoundsExactOrderSuffix() const {
         if ( !indexed() ||
              !_frs.matchPossible() ||
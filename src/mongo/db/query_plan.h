@@ -157,6 +157,9 @@ namespace mongo {
         /** @return true when the plan's query may contains an $exists:false predicate. */
         bool hasPossibleExistsFalsePredicate() const;
 
+        /** @return true when every document the query matches is in the plan's partial index. */
+        bool queryImpliesPartialFilter() const;
+
         NamespaceDetails* _d;
         int _idxNo;
         const FieldRangeSet& _frs;
@@ -28,9 +28,11 @@ namespace mongo {
         const int version = indexdetails.version();
         if (0 == version) {
             return indexdetails.head.btree<V0>()->findSingle(indexdetails, indexdetails.head, key);
-        } else {
-            verify(1 == version);
+        } else if (1 == version) {
             return indexdetails.head.btree<V1>()->findSingle(indexdetails, indexdetails.head, key);
+        } else {
+            verify(2 == version);
+            return indexdetails.head.btree<V2>()->findSingle(indexdetails, indexdetails.head, key);
         }
     }
 
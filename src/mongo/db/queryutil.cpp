@@ -17,10 +17,12 @@
 
 #include "mongo/db/queryutil.h"
 #include "mongo/db/index_names.h"
+#include "mongo/db/server_parameters.h"
 
 #include "pdfile.h"
 #include "../util/startup_test.h"
 #include "../util/mongoutils/str.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
 
 namespace mongo {
 
@@ -153,17 +155,112 @@ namespace mongo {
     }
 
 
+    // $in arrays of at least this many elements have their intervals cached, so a query
+    // repeated with the same list skips sorting it.  0 disables the cache.
+    MONGO_EXPORT_SERVER_PARAMETER(queryInBoundsCacheMinElements, int, 1000);
+
+    namespace {
+
+        /** For a range sorted with element_lt, true iff 'l' and 'r' are equivalent. */
+        struct element_equivalent {
+            bool operator()( const BSONElement& l, const BSONElement& r ) const {
+                return !element_lt()( l, r ) && !element_lt()( r, l );
+            }
+        };
+
+        /**
+         * The intervals of recently seen large $in arrays without regexes, by a hash of the
+         * array's bytes.  Each entry owns a copy of its array, which its intervals point into.
+         */
+        class InBoundsCache : boost::noncopyable {
+        public:
+            static const size_t kMaxEntries = 64;
+
+            InBoundsCache() : _mutex( "InBoundsCache" ) { }
+
+            /**
+             * @return true if 'array' is cached, setting 'owned' to the copy the returned
+             *     'intervals' point into.
+             */
+            bool get( const BSONObj& array, BSONObj* owned, vector<FieldInterval>* intervals,
+                      bool* exactMatchesOnly ) {
+                const unsigned hash = hashOf( array );
+                SimpleMutex::scoped_lock lk( _mutex );
+                EntryMap::const_iterator i = _entries.find( hash );
+                if ( i == _entries.end() || !sameBytes( i->second.array, array ) ) {
+                    return false;
+                }
+                *owned = i->second.array;
+                *intervals = i->second.intervals;
+                *exactMatchesOnly = i->second.exactMatchesOnly;
+                return true;
+            }
+
+            /** @param owned an owned array, which 'intervals' point into. */
+            void put( const BSONObj& owned, const vector<FieldInterval>& intervals,
+                      bool exactMatchesOnly ) {
+                const unsigned hash = hashOf( owned );
+                SimpleMutex::scoped_lock lk( _mutex );
+                if ( _entries.size() >= kMaxEntries && _entries.count( hash ) == 0 ) {
+                    // arbitrary, as the map is in hash order
+                    _entries.erase( _entries.begin() );
+                }
+                Entry& entry = _entries[ hash ];
+                entry.array = owned;
+                entry.intervals = intervals;
+                entry.exactMatchesOnly = exactMatchesOnly;
+            }
+
+        private:
+            struct Entry {
+                BSONObj array;
+                vector<FieldInterval> intervals;
+                bool exactMatchesOnly;
+            };
+            typedef map<unsigned, Entry> EntryMap;
+
+            static unsigned hashOf( const BSONObj& array ) {
+                unsigned hash;
+                MurmurHash3_x86_32( array.objdata(), array.objsize(), 0, &hash );
+                return hash;
+            }
+
+            static bool sameBytes( const BSONObj& a, const BSONObj& b ) {
+                return a.objsize() == b.objsize() &&
+                        memcmp( a.objdata(), b.objdata(), a.objsize() ) == 0;
+            }
+
+            SimpleMutex _mutex;
+            EntryMap _entries;
+        } inBoundsCache;
+
+    }  // namespace
+
     FieldRange::FieldRange( const BSONElement &e, bool isNot, bool optimize ) :
     _exactMatchRepresentation() {
         int op = e.getGtLtOp();
 
         // NOTE with $not, we could potentially form a complementary set of intervals.
         if ( !isNot && !e.eoo() && e.type() != RegEx && op == BSONObj::opIN ) {
+            uassert( 12580 , "invalid query" , e.isABSONObj() );
+            BSONObj inArray = e.embeddedObject();
+            const bool cacheable = queryInBoundsCacheMinElements > 0 &&
+                    inArray.nFields() >= queryInBoundsCacheMinElements;
+            if ( cacheable ) {
+                BSONObj owned;
+                if ( inBoundsCache.get( inArray, &owned, &_intervals,
+                                        &_exactMatchRepresentation ) ) {
+                    addObj( owned );
+                    return;
+                }
+                // the intervals built below are kept in the cache, past the query
+                inArray = addObj( inArray.getOwned() );
+            }
+
             bool exactMatchesOnly = true;
-            set<BSONElement,element_lt> vals;
+            vector<BSONElement> vals;
             vector<FieldRange> regexes;
-            uassert( 12580 , "invalid query" , e.isABSONObj() );
-            BSONObjIterator i( e.embeddedObject() );
+            BSONObjIterator i( inArray );
             while( i.more() ) {
                 BSONElement ie = i.next();
                 uassert( 15881, "$elemMatch not allowed within $in",
@@ -177,14 +274,14 @@ namespace mongo {
                     // A document array may be indexed by its first element, by undefined
                     // if it is empty, or as a full array if it is embedded within another
                     // array.
-                    vals.insert( ie );                        
+                    vals.push_back( ie );
                     if ( ie.type() == Array ) {
                         exactMatchesOnly = false;
                         BSONElement temp = ie.embeddedObject().firstElement();
                         if ( temp.eoo() ) {
                             temp = staticUndefined.firstElement();
                         }                        
-                        vals.insert( temp );
+                        vals.push_back( temp );
                     }
                     if ( ie.isNull() ) {
                         // A null index key will not always match a null query value (eg
@@ -196,9 +293,17 @@ namespace mongo {
             }
 
             _exactMatchRepresentation = exactMatchesOnly;
-            for( set<BSONElement,element_lt>::const_iterator i = vals.begin(); i != vals.end(); ++i )
+            std::sort( vals.begin(), vals.end(), element_lt() );
+            vals.erase( std::unique( vals.begin(), vals.end(), element_equivalent() ),
+                        vals.end() );
+            _intervals.reserve( vals.size() );
+            for( vector<BSONElement>::const_iterator i = vals.begin(); i != vals.end(); ++i )
                 _intervals.push_back( FieldInterval(*i) );
 
+            if ( cacheable && regexes.empty() ) {
+                inBoundsCache.put( inArray, _intervals, _exactMatchRepresentation );
+            }
+
             for( vector<FieldRange>::const_iterator i = regexes.begin(); i != regexes.end(); ++i )
                 *this |= *i;
 
@@ -304,7 +304,8 @@ namespace mongo {
         }
 
         bool result = _env->deleteRange(ns, min, max, shardKeyPattern,
-                                        secondaryThrottle, errMsg);
+                                        secondaryThrottle, _stats->getDocsDeletedCounter(),
+                                        errMsg);
 
         {
             scoped_lock sl(_queueMutex);
@@ -451,6 +452,7 @@ namespace mongo {
                                    nextTask->max,
                                    nextTask->shardKeyPattern,
                                    nextTask->secondaryThrottle,
+                                   _stats->getDocsDeletedCounter(),
                                    &errMsg)) {
                 warning() << "Error encountered while trying to delete range: "
                           << errMsg << endl;
@@ -25,6 +25,7 @@
 #include "mongo/base/string_data.h"
 #include "mongo/db/cc_by_loc.h" // for typedef CursorId
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/concurrency/synchronization.h"
 
@@ -268,6 +269,8 @@ namespace mongo {
          * to be able to perform deletions.
          *
          * Must be a synchronous call. Docs should be deleted after call ends.
+         * docsDeleted should be incremented as documents are removed, so progress can be
+         * reported while the call is in flight.
          * Must not throw Exceptions.
          */
         virtual bool deleteRange(const StringData& ns,
@@ -275,6 +278,7 @@ namespace mongo {
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& shardKeyPattern,
                                  bool secondaryThrottle,
+                                 AtomicInt64* docsDeleted,
                                  std::string* errMsg) = 0;
 
         /**
@@ -23,10 +23,20 @@
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_logic.h"
 
 namespace mongo {
 
+    // Most documents deleted per write lock.
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchSize, int, 128);
+
+    // A batch yields the write lock after holding it this long, and the next ones shrink.
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterBatchMillis, int, 20);
+
+    // Upper bound on documents deleted per second, 0 for no limit.
+    MONGO_EXPORT_SERVER_PARAMETER(rangeDeleterMaxDocsPerSecond, int, 0);
+
     /**
      * Outline of the delete process:
      * 1. Initialize the client for this thread if there is no client. This is for the worker
@@ -34,7 +44,7 @@ namespace mongo {
      * 2. Grant this thread authorization to perform deletes.
      * 3. Temporarily enable mode to bypass shard version checks. TODO: Replace this hack.
      * 4. Setup callback to save deletes to moveChunk directory (only if moveParanoia is true).
-     * 5. Delete range.
+     * 5. Delete range, in batches paced by the server parameters above.
      * 6. Wait until the majority of the secondaries catch up.
      */
     bool RangeDeleterDBEnv::deleteRange(const StringData& ns,
@@ -42,6 +52,7 @@ namespace mongo {
                                         const BSONObj& exclusiveUpper,
                                         const BSONObj& keyPattern,
                                         bool secondaryThrottle,
+                                        AtomicInt64* docsDeleted,
                                         std::string* errMsg) {
         const bool initiallyHaveClient = haveClient();
 
@@ -67,6 +78,12 @@ namespace mongo {
                   << endl;
 
             try {
+                Helpers::RemovePacing pacing;
+                pacing.docsPerBatch = rangeDeleterBatchSize;
+                pacing.maxBatchMillis = rangeDeleterBatchMillis;
+                pacing.maxDocsPerSecond = rangeDeleterMaxDocsPerSecond;
+                pacing.docsDeleted = docsDeleted;
+
                 long long numDeleted =
                         Helpers::removeRange(KeyRange(ns.toString(),
                                                       inclusiveLower,
@@ -76,7 +93,8 @@ namespace mongo {
                                              replSet? secondaryThrottle : false,
                                              cmdLine.moveParanoia ? &removeSaver : NULL,
                                              true, /*fromMigrate*/
-                                             true); /*onlyRemoveOrphans*/
+                                             true, /*onlyRemoveOrphans*/
+                                             pacing);
 
                 if (numDeleted < 0) {
                     warning() << "collection or index dropped "
@@ -34,6 +34,9 @@ namespace mongo {
          * Note that secondaryThrottle will be ignored if current process is not part
          * of a replica set.
          *
+         * Deletes in batches paced by the rangeDeleterBatchSize, rangeDeleterBatchMillis and
+         * rangeDeleterMaxDocsPerSecond server parameters.
+         *
          * Does not throw Exceptions.
          */
         virtual bool deleteRange(const StringData& ns,
@@ -41,6 +44,7 @@ namespace mongo {
                                  const BSONObj& exclusiveUpper,
                                  const BSONObj& keyPattern,
                                  bool secondaryThrottle,
+                                 AtomicInt64* docsDeleted,
                                  std::string* errMsg);
 
         /**
@@ -117,6 +117,7 @@ namespace mongo {
                          const BSONObj& max,
                          const BSONObj& shardKeyPattern,
                          bool secondaryThrottle,
+                         AtomicInt64* docsDeleted,
                          string* errMsg);
 
         /**
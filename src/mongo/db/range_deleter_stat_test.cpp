@@ -58,6 +58,11 @@ namespace {
                                          &inProgressCount, NULL /* don't care errMsg */));
         ASSERT_EQUALS(0, inProgressCount);
 
+        long long docsDeleted = -1;
+        ASSERT_TRUE(FieldParser::extract(stats, RangeDeleterStats::DocsDeletedField,
+                                         &docsDeleted, NULL /* don't care errMsg */));
+        ASSERT_EQUALS(0, docsDeleted);
+
         deleter.stopWorkers();
     }
 
@@ -20,6 +20,7 @@ namespace mongo {
     const BSONField<int> RangeDeleterStats::TotalDeletesField("totalDeletes");
     const BSONField<int> RangeDeleterStats::PendingDeletesField("pendingDeletes");
     const BSONField<int> RangeDeleterStats::InProgressDeletesField("inProgressDeletes");
+    const BSONField<long long> RangeDeleterStats::DocsDeletedField("docsDeleted");
 
     BSONObj RangeDeleterStats::toBSON() const {
         scoped_lock sl(*_lockPtr);
@@ -28,6 +29,7 @@ namespace mongo {
         builder << TotalDeletesField(_totalDeletes);
         builder << PendingDeletesField(_pendingDeletes);
         builder << InProgressDeletesField(_inProgressDeletes);
+        builder << DocsDeletedField(_docsDeleted.load());
 
         return builder.obj();
     }
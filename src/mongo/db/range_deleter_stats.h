@@ -18,6 +18,7 @@
 
 #include "mongo/bson/bson_field.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/cstdint.h"
 #include "mongo/util/concurrency/mutex.h"
 
@@ -40,6 +41,9 @@ namespace mongo {
         // Total number of deletes that are currently in progress.
         static const BSONField<int> InProgressDeletesField;
 
+        // Total number of documents removed by deletes, including ones still in progress.
+        static const BSONField<long long> DocsDeletedField;
+
         /**
          * Creates a stat object given the mutex from the RangeDeleter object
          * that this instance is keeping track of.
@@ -59,6 +63,14 @@ namespace mongo {
         // Returns the current number of active and pending deletes.
         int getCurrentDeletes() const;
 
+        /**
+         * Returns the counter behind DocsDeletedField. Unlike the other stats, it is
+         * updated without the mutex, by the thread doing the delete as it goes.
+         */
+        AtomicInt64* getDocsDeletedCounter() {
+            return &_docsDeleted;
+        }
+
         //
         // Setters - Should be holding mutex passed to
         // the constructor when calling these methods.
@@ -99,5 +111,7 @@ namespace mongo {
         int _totalDeletes;
         int _pendingDeletes;
         int _inProgressDeletes;
+
+        AtomicInt64 _docsDeleted;
     };
 }
@@ -23,9 +23,11 @@
 #include "mongo/db/pagefault.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/record.h"
+#include "mongo/db/warm_cache.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/platform/bits.h"
 #include "mongo/platform/unordered_set.h"
+#include "mongo/util/mmap.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/stack_introspect.h"
@@ -421,6 +423,10 @@ namespace mongo {
         }
     }
 
+    void Record::prefetch() const {
+        MAdvise::willNeed( this, g_minOSPageSizeBytes );
+    }
+
     static bool blockSupported = false;
 
     MONGO_INITIALIZER_WITH_PREREQUISITES(RecordBlockSupported,
@@ -497,6 +503,22 @@ namespace mongo {
     }
 
 
+    namespace {
+        /** counts a page new to this thread's PointerTable in the estimates */
+        void noteWorkingSetPage( const char* data, bool index ) {
+            const long long nowSecs = Listener::getElapsedTimeMillis() / 1000;
+            ( index ? recordStats.indexPages : recordStats.dataPages ).noteAccess( data, nowSecs );
+            hotRegions().noteAccess( data, index );
+
+            Client* c = currentClient.get();
+            Database* db = c ? c->database() : NULL;
+            if ( db ) {
+                RecordStats& dbStats = db->recordStats();
+                ( index ? dbStats.indexPages : dbStats.dataPages ).noteAccess( data, nowSecs );
+            }
+        }
+    }
+
     Record* Record::accessed() {
         const bool seen = ps::PointerTable::seen( ps::PointerTable::getData(), reinterpret_cast<size_t>(_data));
         if (!seen){
@@ -504,10 +526,20 @@ namespace mongo {
             const size_t region = page >> 6;
             const size_t offset = page & 0x3f;        
             ps::rolling[ps::bigHash(region)].access( region , offset , true );
+            if ( MemoryTrackingEnabled )
+                noteWorkingSetPage( _data, false );
         }
 
         return this;
     }
+
+    Record* Record::accessedAsIndex() {
+        if ( MemoryTrackingEnabled &&
+             ! ps::PointerTable::seen( ps::PointerTable::getData(), reinterpret_cast<size_t>(_data) ) ) {
+            noteWorkingSetPage( _data, true );
+        }
+        return this;
+    }
     
     Record* DiskLoc::rec() const {
         Record *r = DataFileMgr::getRecord(*this);
@@ -562,6 +594,48 @@ namespace mongo {
                 
         } asserts;
 
+        class WorkingSetEstimateSSS : public ServerStatusSection {
+        public:
+            WorkingSetEstimateSSS() : ServerStatusSection( "workingSetEstimate" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder b;
+                ProcessInfo p;
+                b.appendNumber( "ramMB", static_cast<long long>( p.getMemSizeMB() ) );
+                const long long nowSecs = Listener::getElapsedTimeMillis() / 1000;
+                appendEstimates( &b, ::mongo::recordStats, nowSecs );
+
+                set<string> dbs;
+                {
+                    Lock::DBRead read( "local" );
+                    dbHolder().getAllShortNames( dbs );
+                }
+
+                BSONObjBuilder databases( b.subobjStart( "databases" ) );
+                for ( set<string>::iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                    Client::ReadContext ctx( *i );
+                    BSONObjBuilder temp( databases.subobjStart( *i ) );
+                    appendEstimates( &temp, ctx.ctx().db()->recordStats(), nowSecs );
+                    temp.done();
+                }
+                databases.done();
+
+                return b.obj();
+            }
+
+        private:
+            static void appendEstimates( BSONObjBuilder* b, const mongo::RecordStats& stats,
+                                         long long nowSecs ) {
+                BSONObjBuilder data( b->subobjStart( "data" ) );
+                stats.dataPages.append( &data, nowSecs );
+                data.done();
+                BSONObjBuilder indexes( b->subobjStart( "indexes" ) );
+                stats.indexPages.append( &indexes, nowSecs );
+                indexes.done();
+            }
+        } workingSetEstimateSSS;
+
         class RecordStats : public ServerStatusSection {
         public:
             RecordStats() : ServerStatusSection( "recordStats" ){}
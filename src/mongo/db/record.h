@@ -19,6 +19,7 @@
 #pragma once
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/stats/working_set.h"
 #include "mongo/platform/atomic_word.h"
 
 namespace mongo {
@@ -28,6 +29,10 @@ namespace mongo {
 
         AtomicInt64 accessesNotInMemory;
         AtomicInt64 pageFaultExceptionsThrown;
+
+        // pages of documents and of index buckets touched, for the workingSetEstimate section
+        WorkingSetEstimator dataPages;
+        WorkingSetEstimator indexPages;
     };
 
 
@@ -0,0 +1,92 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/db/record_growth_model.h"
+
+#include <algorithm>
+
+
+namespace mongo {
+
+    const int RecordGrowthModel::kNumSizeClasses;
+    const int RecordGrowthModel::kUpdatesToFit;
+
+    namespace {
+        // The moving average forgets roughly the updates older than the last this many.
+        const long long averagingWindow = 16;
+
+        // Power of two allocation never gives more than this either.
+        const double maxAllocationFactor = 2.0;
+    }
+
+    RecordGrowthModel::RecordGrowthModel() {
+        std::fill(_growth, _growth + kNumSizeClasses, 1.0);
+        std::fill(_updates, _updates + kNumSizeClasses, 0LL);
+    }
+
+    // static
+    int RecordGrowthModel::sizeClass(int size) {
+        int sizeClass = 0;
+        while (size > 1 && sizeClass < kNumSizeClasses - 1) {
+            size >>= 1;
+            ++sizeClass;
+        }
+        return sizeClass;
+    }
+
+    void RecordGrowthModel::noteUpdate(int oldSize, int newSize) {
+        if (oldSize <= 0) {
+            return;
+        }
+
+        const int c = sizeClass(oldSize);
+        const double growth = newSize > oldSize ? static_cast<double>(newSize) / oldSize : 1.0;
+
+        // A plain average until the window fills, then an exponential moving average.
+        if (_updates[c] < averagingWindow) {
+            ++_updates[c];
+            _growth[c] += (growth - _growth[c]) / _updates[c];
+        }
+        else {
+            ++_updates[c];
+            _growth[c] += (growth - _growth[c]) / averagingWindow;
+        }
+    }
+
+    double RecordGrowthModel::growthFactor(int size) const {
+        return _growth[sizeClass(size)];
+    }
+
+    int RecordGrowthModel::allocationSize(int size) const {
+        const double factor = std::min(1.0 + kUpdatesToFit * (growthFactor(size) - 1.0),
+                                       maxAllocationFactor);
+        return std::max(size, static_cast<int>(size * factor));
+    }
+
+    void RecordGrowthModel::toBSON(BSONObjBuilder* out) const {
+        for (int c = 0; c < kNumSizeClasses; ++c) {
+            if (0 == _updates[c]) {
+                continue;
+            }
+            BSONObjBuilder classBuilder(out->subobjStart(BSONObjBuilder::numStr(1 << c)));
+            classBuilder.appendNumber("updates", _updates[c]);
+            classBuilder.append("growthFactor", _growth[c]);
+            classBuilder.doneFast();
+        }
+    }
+
+}  // namespace mongo
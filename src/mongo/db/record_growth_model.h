@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Learns how much a collection's documents grow when they are updated, separately for each
+     * power of two size class, so that new records of a class that tends to grow can be given
+     * room for a few updates instead of moving on the first one.
+     *
+     * Not thread safe: callers hold the collection's database lock, in write mode to update.
+     */
+    class RecordGrowthModel {
+    public:
+        // Classes go up to 2^(kNumSizeClasses - 1) bytes, past the largest document.
+        static const int kNumSizeClasses = 26;
+
+        // The slack given is room for this many typical updates.
+        static const int kUpdatesToFit = 4;
+
+        RecordGrowthModel();
+
+        /**
+         * Notes an update of a 'oldSize' byte document to 'newSize' bytes.  Shrinking counts as
+         * no growth.
+         */
+        void noteUpdate(int oldSize, int newSize);
+
+        /**
+         * The average growth factor of one update to a document of 'size' bytes, 1.0 if no
+         * update of that size class has been seen.
+         */
+        double growthFactor(int size) const;
+
+        /**
+         * How many bytes to allocate for a new record of 'size' bytes.  At least 'size' and at
+         * most twice it.
+         */
+        int allocationSize(int size) const;
+
+        /**
+         * Appends { <smallest size of class>: { updates, growthFactor } } for every size class
+         * seen.
+         */
+        void toBSON(BSONObjBuilder* out) const;
+
+    private:
+        static int sizeClass(int size);
+
+        // Moving averages of the growth factor per update, and how many updates they cover.
+        double _growth[kNumSizeClasses];
+        long long _updates[kNumSizeClasses];
+    };
+
+}  // namespace mongo
@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * This file contains tests for mongo/db/record_growth_model.cpp
+ */
+
+#include "mongo/db/record_growth_model.h"
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(RecordGrowthModelTest, NoUpdatesNoSlack) {
+        RecordGrowthModel model;
+        ASSERT_EQUALS(1.0, model.growthFactor(100));
+        ASSERT_EQUALS(100, model.allocationSize(100));
+
+        BSONObjBuilder b;
+        model.toBSON(&b);
+        ASSERT_TRUE(b.obj().isEmpty());
+    }
+
+    TEST(RecordGrowthModelTest, LearnsGrowthPerSizeClass) {
+        RecordGrowthModel model;
+        for (int i = 0; i < 10; ++i) {
+            model.noteUpdate(100, 110);
+        }
+        ASSERT_APPROX_EQUAL(1.1, model.growthFactor(100), 1e-9);
+
+        // 100 and 127 share a class; 1000 doesn't.
+        ASSERT_APPROX_EQUAL(1.1, model.growthFactor(127), 1e-9);
+        ASSERT_EQUALS(1.0, model.growthFactor(1000));
+
+        // Room for four updates that grow by 10% each.
+        ASSERT_GREATER_THAN_OR_EQUALS(model.allocationSize(100), 139);
+        ASSERT_LESS_THAN_OR_EQUALS(model.allocationSize(100), 141);
+        ASSERT_EQUALS(1000, model.allocationSize(1000));
+    }
+
+    TEST(RecordGrowthModelTest, ShrinkingCountsAsNoGrowth) {
+        RecordGrowthModel model;
+        model.noteUpdate(100, 150);
+        model.noteUpdate(100, 50);
+        ASSERT_APPROX_EQUAL(1.25, model.growthFactor(100), 1e-9);
+    }
+
+    TEST(RecordGrowthModelTest, ForgetsOldUpdates) {
+        RecordGrowthModel model;
+        for (int i = 0; i < 100; ++i) {
+            model.noteUpdate(100, 200);
+        }
+        ASSERT_EQUALS(200, model.allocationSize(100));
+
+        for (int i = 0; i < 200; ++i) {
+            model.noteUpdate(100, 100);
+        }
+        ASSERT_LESS_THAN(model.growthFactor(100), 1.01);
+        ASSERT_LESS_THAN(model.allocationSize(100), 105);
+    }
+
+    TEST(RecordGrowthModelTest, ToBSON) {
+        RecordGrowthModel model;
+        model.noteUpdate(100, 120);
+
+        BSONObjBuilder b;
+        model.toBSON(&b);
+        BSONObj obj = b.obj();
+        ASSERT_EQUALS(1, obj.nFields());
+        ASSERT_EQUALS(1, obj["64"].Obj()["updates"].numberLong());
+        ASSERT_APPROX_EQUAL(1.2, obj["64"].Obj()["growthFactor"].Number(), 1e-9);
+    }
+
+}  // namespace
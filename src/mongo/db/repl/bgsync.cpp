@@ -79,6 +79,7 @@ namespace replset {
                                        _appliedBuffer(true),
                                        _assumingPrimary(false),
                                        _currentSyncTarget(NULL),
+                                       _syncTargetSince(0),
                                        _oplogMarkerTarget(NULL),
                                        _consumedOpTime(0, 0) {
     }
@@ -342,6 +343,25 @@ namespace replset {
             return;
         }
 
+        // Now that we know we follow on from the source's oplog, tail it again in exhaust mode
+        // so the source streams each batch as soon as the previous one is sent rather than
+        // waiting a round trip for our getMore.  The rollback checks above need the connection
+        // for other queries, which an exhaust cursor would not allow.
+        r.resetCursor();
+        r.setTailingQueryOptions(r.getTailingQueryOptions() | QueryOption_Exhaust);
+        r.tailingQueryGTE(rsoplog, lastOpTimeFetched);
+        if (!r.haveCursor() || !r.more()) {
+            return;
+        }
+        {
+            // skip the op we already have; if it changed underneath us, start over and let
+            // the checks above decide what to do
+            BSONObj o = r.nextSafe();
+            if (o["ts"]._opTime() != lastOpTimeFetched) {
+                return;
+            }
+        }
+
         while (!inShutdown()) {
             if (!r.moreInCurrentBatch()) {
                 // Check some things periodically
@@ -377,6 +397,7 @@ namespace replset {
                 }
 
 
+                Timer fetchTimer;
                 {
                     //record time for each getmore
                     TimerHolder batchTimer(&getmoreReplStats);
@@ -387,6 +408,14 @@ namespace replset {
                 }
                 networkByteStats.increment(r.currentBatchMessageSize());
 
+                // A full batch means the source had more than it could send in one, so how fast
+                // it came says how fast this source is rather than how fast the primary writes.
+                if (r.currentBatchMessageSize() >= BatchIsSmallish) {
+                    theReplSet->noteSyncSourceFetch(r.conn()->getServerAddress(),
+                                                    r.currentBatchMessageSize(),
+                                                    fetchTimer.millis());
+                }
+
                 if (!r.moreInCurrentBatch()) {
                     // If there is still no data from upstream, check a few more things
                     // and then loop back for another pass at getting more data
@@ -445,7 +474,8 @@ namespace replset {
 
         // check other members: is any member's optime more than 30 seconds ahead of the guy we're
         // syncing from?
-        return theReplSet->shouldChangeSyncTarget(_currentSyncTarget->hbinfo().opTime);
+        // or one that merely looks better by enough, after a while on this one?
+        return theReplSet->shouldChangeSyncTarget(_currentSyncTarget, _syncTargetSince);
     }
 
 
@@ -541,6 +571,7 @@ namespace replset {
             {
                 boost::unique_lock<boost::mutex> lock(_mutex);
                 _currentSyncTarget = target;
+                _syncTargetSince = time(0);
             }
             {
                 // prevent writers from blocking readers during fsync
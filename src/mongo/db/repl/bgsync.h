@@ -78,6 +78,8 @@ namespace replset {
         boost::condition _condvar;
 
         const Member* _currentSyncTarget;
+        // when we started syncing from _currentSyncTarget
+        time_t _syncTargetSince;
 
         // Notifier thread
 
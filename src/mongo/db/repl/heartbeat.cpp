@@ -17,6 +17,7 @@
 #include "mongo/pch.h"
 
 #include <boost/thread/thread.hpp>
+#include <cmath>
 
 #include "mongo/db/commands.h"
 #include "mongo/db/instance.h"
@@ -43,6 +44,32 @@ namespace mongo {
 
     extern bool replSetBlind;
 
+    namespace {
+        // Heartbeat response intervals to see before judging a member by its suspicion level.
+        const int kMinHeartbeatIntervals = 3;
+
+        // Weight of each new interval in the running mean and variance.
+        const double kIntervalWeight = 0.1;
+
+        // A floor on the standard deviation of the intervals, so that a member whose heartbeats
+        // have been perfectly regular isn't suspected the moment one is a little late.
+        const double kMinIntervalStdDevMillis = 200;
+
+        /**
+         * The phi accrual suspicion level of a member 'elapsed' ms after its last heartbeat
+         * response: -log10 of the probability that a response comes that late, for intervals
+         * normally distributed with mean 'mean' and standard deviation 'stdDev'.  Uses the
+         * logistic approximation of the normal distribution.
+         */
+        double suspicionLevel(double elapsed, double mean, double stdDev) {
+            double y = (elapsed - mean) / stdDev;
+            double e = exp(-y * (1.5976 + 0.070566 * y * y));
+            if (elapsed > mean)
+                return -log10(e / (1.0 + e));
+            return -log10(1.0 - 1.0 / (1.0 + e));
+        }
+    }
+
     unsigned int HeartbeatInfo::numPings;
 
     long long HeartbeatInfo::timeDown() const {
@@ -237,10 +264,16 @@ namespace mongo {
     public:
         ReplSetHealthPollTask(const HostAndPort& hh, const HeartbeatInfo& mm)
             : h(hh), m(mm), tries(s_try_offset), threshold(15),
-              _timeout(ReplSetConfig::DEFAULT_HB_TIMEOUT) {
+              _timeout(ReplSetConfig::DEFAULT_HB_TIMEOUT),
+              _suspicionThreshold(0),
+              _lastResponseMillis(0),
+              _intervals(0),
+              _intervalMean(0),
+              _intervalVariance(0) {
 
             if (theReplSet) {
                 _timeout = theReplSet->config().getHeartbeatTimeout();
+                _suspicionThreshold = theReplSet->config().getHeartbeatSuspicionThreshold();
             }
 
             // doesn't need protection, all health tasks are created in a single thread
@@ -272,6 +305,7 @@ namespace mongo {
                 }
 
                 if( ok ) {
+                    noteResponse();
                     up(info, mem);
                 }
                 else if (info["code"].numberInt() == ErrorCodes::Unauthorized ||
@@ -322,10 +356,59 @@ namespace mongo {
             return ok;
         }
 
+        void noteResponse() {
+            long long now = curTimeMillis64();
+            if (_lastResponseMillis) {
+                double interval = now - _lastResponseMillis;
+                if (_intervals++ == 0) {
+                    _intervalMean = interval;
+                }
+                else {
+                    double diff = interval - _intervalMean;
+                    _intervalMean += kIntervalWeight * diff;
+                    _intervalVariance = (1 - kIntervalWeight) *
+                                        (_intervalVariance + kIntervalWeight * diff * diff);
+                }
+            }
+            _lastResponseMillis = now;
+        }
+
+        /**
+         * The timeout for the next heartbeat: the time left until the member's suspicion level
+         * passes the threshold, if there is one and there have been enough responses to judge
+         * by.  Never more than the configured timeout nor less than a second.
+         */
+        time_t heartbeatTimeout() const {
+            if (_suspicionThreshold <= 0 || _timeout <= 0 ||
+                _intervals < kMinHeartbeatIntervals) {
+                return _timeout;
+            }
+
+            const double stdDev = std::max(sqrt(_intervalVariance), kMinIntervalStdDevMillis);
+            double lo = 0;
+            double hi = _timeout * 1000.0;
+            if (suspicionLevel(hi, _intervalMean, stdDev) < _suspicionThreshold) {
+                return _timeout;
+            }
+            // the elapsed time at which the suspicion level reaches the threshold
+            for (int i = 0; i < 32; i++) {
+                double mid = (lo + hi) / 2;
+                if (suspicionLevel(mid, _intervalMean, stdDev) < _suspicionThreshold)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+
+            double remaining = hi - (curTimeMillis64() - _lastResponseMillis);
+            time_t secs = static_cast<time_t>(ceil(remaining / 1000));
+            return std::max<time_t>(1, std::min(secs, _timeout));
+        }
+
         bool _requestHeartbeat(HeartbeatInfo& mem, BSONObj& info, int& theirConfigVersion) {
+            const time_t timeout = heartbeatTimeout();
             {
                 ScopedConn conn(h.toString());
-                conn.setTimeout(_timeout);
+                conn.setTimeout(timeout);
                 if (tries++ % threshold == (threshold - 1)) {
                     conn.reconnect();
                 }
@@ -340,13 +423,13 @@ namespace mongo {
             time_t totalSecs = mem.ping / 1000;
 
             // if that didn't work and we have more time, lower timeout and try again
-            if (!ok && totalSecs < _timeout) {
+            if (!ok && totalSecs < timeout) {
                 log() << "replset info " << h.toString() << " heartbeat failed, retrying" << rsLog;
 
                 // lower timeout to remaining ping time
                 {
                     ScopedConn conn(h.toString());
-                    conn.setTimeout(_timeout - totalSecs);
+                    conn.setTimeout(timeout - totalSecs);
                 }
 
                 int checkpoint = timer.millis();
@@ -354,12 +437,12 @@ namespace mongo {
                 ok = tryHeartbeat(&info, &theirConfigVersion);
                 mem.ping = static_cast<unsigned int>(timer.millis());
                 totalSecs = (checkpoint + mem.ping)/1000;
+            }
 
-                // set timeout back to default
-                {
-                    ScopedConn conn(h.toString());
-                    conn.setTimeout(_timeout);
-                }
+            // set timeout back to default
+            if (!ok || timeout != _timeout) {
+                ScopedConn conn(h.toString());
+                conn.setTimeout(_timeout);
             }
 
             // we set this on any response - we don't get this far if
@@ -484,6 +567,16 @@ namespace mongo {
 
         // Heartbeat timeout
         time_t _timeout;
+
+        // Suspicion level past which the member is taken down, or 0 to wait for the timeout.
+        double _suspicionThreshold;
+
+        // When the last heartbeat response came in, and the running mean and variance of the
+        // intervals between responses, in milliseconds.
+        long long _lastResponseMillis;
+        int _intervals;
+        double _intervalMean;
+        double _intervalVariance;
     };
 
     int ReplSetHealthPollTask::s_try_offset = 0;
@@ -501,7 +594,7 @@ namespace mongo {
         DEV log() << "starting rsHealthPoll for " << m->fullName() << endl;
         ReplSetHealthPollTask *task = new ReplSetHealthPollTask(m->h(), m->hbinfo());
         healthTasks.insert(task);
-        task::repeat(task, 2000);
+        task::repeat(task, config().getHeartbeatInterval());
     }
 
     void startSyncThread();
@@ -36,6 +36,7 @@
 #include "mongo/db/repl/replication_server_status.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/s/d_logic.h"
 #include "mongo/util/elapsed_tracker.h"
@@ -111,11 +112,8 @@ namespace mongo {
         @dst   where to put the newly built combined object.  e.g. ends up as something like:
                { ts:..., ns:..., os2:..., o:... }
     */
-    void append_O_Obj(char *dst, const BSONObj& partial, const BSONObj& o) {
+    static void write_O_Obj(void *p, const BSONObj& partial, const BSONObj& o) {
         const int size1 = partial.objsize() - 1;  // less the EOO char
-        const int oOfs = size1+3;                 // 3 = byte BSONOBJTYPE + byte 'o' + byte \0
-
-        void *p = getDur().writingPtr(dst, oOfs+o.objsize()+1);
 
         memcpy(p, partial.objdata(), size1);
 
@@ -132,6 +130,11 @@ namespace mongo {
         *b = EOO;
     }
 
+    void append_O_Obj(char *dst, const BSONObj& partial, const BSONObj& o) {
+        const int oOfs = partial.objsize() - 1 + 3; // 3 = byte BSONOBJTYPE + byte 'o' + byte \0
+        write_O_Obj(getDur().writingPtr(dst, oOfs+o.objsize()+1), partial, o);
+    }
+
     /* we write to local.oplog.rs:
          { ts : ..., h: ..., v: ..., op: ..., etc }
        ts: an OpTime timestamp
@@ -232,6 +235,100 @@ namespace mongo {
         LOG( 6 ) << "logOp:" << BSONObj::make(r) << endl;
     }
 
+    // Upper bound on the oplog space one batch allocation takes.  It's also kept to a fraction
+    // of the last extent, which is the last part of the oplog's size and so the smallest.
+    static const int OplogBatchRegionBytes = 256 * 1024;
+
+    /** _logOpRS() for a run of entries of one multi-document write.  The entries get their
+        timestamps and hashes under one hold of OpTime::m and go into the oplog in regions
+        carved up by fast_oplog_insert_batch(), rather than through a capped allocation each.
+    */
+    static void _logOpBatchRS(const char *opstr, const char *ns,
+                              const std::vector<LogOpBatchEntry>& entries, bool fromMigrate) {
+        Lock::DBWrite lk1("local");
+
+        if ( strncmp(ns, "local.", 6) == 0 ) {
+            if ( strncmp(ns, "local.slaves", 12) == 0 )
+                resetSlaveCache();
+            return;
+        }
+
+        mutex::scoped_lock lk2(OpTime::m);
+        massert(13312, "replSet error : logOp() but not primary?",
+                theReplSet && theReplSet->box.getState().primary());
+
+        // Every partial object goes into the one buffer; they're only looked up by offset
+        // once it's done growing.
+        logopbufbuilder.reset();
+        std::vector<int> partialOfs;
+        std::vector<int> lens;
+        partialOfs.reserve(entries.size());
+        lens.reserve(entries.size());
+        OpTime ts;
+        long long hashNew = theReplSet->lastH;
+        for ( size_t i = 0; i < entries.size(); i++ ) {
+            ts = OpTime::now(lk2);
+            hashNew = (hashNew * 131 + ts.asLL()) * 17 + theReplSet->selfId();
+
+            partialOfs.push_back( logopbufbuilder.len() );
+            BSONObjBuilder b(logopbufbuilder);
+            b.appendTimestamp("ts", ts.asDate());
+            b.append("h", hashNew);
+            b.append("v", OPLOG_VERSION);
+            b.append("op", opstr);
+            b.append("ns", ns);
+            if (fromMigrate)
+                b.appendBool("fromMigrate", true);
+            if ( !entries[i].pattern.isEmpty() )
+                b.append("o2", entries[i].pattern);
+            const int posz = b.done().objsize();
+            lens.push_back( posz + entries[i].obj.objsize() + 1 + 2 /*o:*/ );
+        }
+
+        const char *logns = rsoplog;
+        if ( rsOplogDetails == 0 ) {
+            Client::Context ctx(logns , dbpath);
+            localDB = ctx.db();
+            verify( localDB );
+            rsOplogDetails = nsdetails(logns);
+            massert(13347, "local.oplog.rs missing. did you drop it? if so restart server", rsOplogDetails);
+        }
+        Client::Context ctx(logns , localDB);
+
+        std::vector<int> regionLens;
+        std::vector<char*> data;
+        size_t i = 0;
+        while ( i < entries.size() ) {
+            const int limit = std::min( OplogBatchRegionBytes,
+                                        rsOplogDetails->lastExtentSize() / 8 );
+            const size_t first = i;
+            int regionBytes = 0;
+            regionLens.clear();
+            do {
+                regionBytes += lens[i] + Record::HeaderSize;
+                regionLens.push_back( lens[i] );
+                i++;
+            } while ( i < entries.size() && regionBytes + lens[i] + Record::HeaderSize <= limit );
+
+            data.clear();
+            theDataFileMgr.fast_oplog_insert_batch(rsOplogDetails, logns, regionLens, &data);
+            for ( size_t j = 0; j < data.size(); j++ ) {
+                BSONObj partial(logopbufbuilder.buf() + partialOfs[first + j]);
+                write_O_Obj(data[j], partial, entries[first + j].obj);
+            }
+        }
+
+        if( !(theReplSet->lastOpTimeWritten<ts) ) {
+            log() << "replSet ERROR possible failover clock skew issue? " << theReplSet->lastOpTimeWritten << ' ' << ts << rsLog;
+            log() << "replSet " << theReplSet->isPrimary() << rsLog;
+        }
+        theReplSet->lastOpTimeWritten = ts;
+        theReplSet->lastH = hashNew;
+        ctx.getClient()->setLastOp( ts );
+
+        LOG( 6 ) << "logOp: batch of " << entries.size() << ' ' << opstr << " for " << ns << endl;
+    }
+
     static void _logOpOld(const char *opstr, const char *ns, const char *logNS, const BSONObj& obj, BSONObj *o2, bool *bb, bool fromMigrate ) {
         Lock::DBWrite lk("local");
         static BufBuilder bufbuilder(8*1024); // todo there is likely a mutex on this constructor
@@ -337,6 +434,38 @@ namespace mongo {
         logOpForSharding(opstr, ns, obj, patt, fullObj, fromMigrate);
     }
 
+    void logOpBatch(const char* opstr,
+                    const char* ns,
+                    const std::vector<LogOpBatchEntry>& entries,
+                    bool fromMigrate) {
+        if ( entries.empty() ) {
+            return;
+        }
+
+        if ( replSettings.master ) {
+            if ( _logOp == _logOpRS ) {
+                _logOpBatchRS( opstr, ns, entries, fromMigrate );
+            }
+            else {
+                // The nested Lock::DBWrite in each _logOp() call is then just a recursion count.
+                Lock::DBWrite lk( "local" );
+                for ( std::vector<LogOpBatchEntry>::const_iterator i = entries.begin();
+                      i != entries.end(); ++i ) {
+                    BSONObj pattern = i->pattern;
+                    _logOp( opstr, ns, 0, i->obj, pattern.isEmpty() ? NULL : &pattern, NULL,
+                            fromMigrate );
+                }
+            }
+        }
+
+        for ( std::vector<LogOpBatchEntry>::const_iterator i = entries.begin();
+              i != entries.end(); ++i ) {
+            BSONObj pattern = i->pattern;
+            logOpForSharding( opstr, ns, i->obj, pattern.isEmpty() ? NULL : &pattern,
+                              &i->fullObj, fromMigrate );
+        }
+    }
+
     void createOplog() {
         Lock::GlobalWrite lk;
 
@@ -419,6 +548,10 @@ namespace mongo {
 
     // -------------------------------------
 
+    // Build the indexes replication creates in the background even when the primary built them in
+    // the foreground, so that oplog application goes on meanwhile instead of waiting for the build.
+    MONGO_EXPORT_SERVER_PARAMETER(replIndexBuildsInBackground, bool, false);
+
     /** @param fromRepl false if from ApplyOpsCmd
         @return true if was and update should have happened and the document DNE.  see replset initial sync code.
      */
@@ -450,6 +583,16 @@ namespace mongo {
 
             const char *p = strchr(ns, '.');
             if ( p && strcmp(p, ".system.indexes") == 0 ) {
+                if (fromRepl && replIndexBuildsInBackground && !o["background"].trueValue()) {
+                    BSONObjBuilder spec;
+                    BSONForEach(e, o) {
+                        if (!str::equals(e.fieldName(), "background")) {
+                            spec.append(e);
+                        }
+                    }
+                    spec.append("background", true);
+                    o = spec.obj();
+                }
                 if (o["background"].trueValue()) {
                     IndexBuilder* builder = new IndexBuilder(ns, o);
                     // This spawns a new thread and returns immediately.
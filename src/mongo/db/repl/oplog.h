@@ -16,9 +16,12 @@
 
 #pragma once
 
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
 namespace mongo {
 
-    class BSONObj;
     class Database;
 
     // These functions redefine the function for logOp(),
@@ -58,6 +61,21 @@ namespace mongo {
                 BSONObj *patt = NULL, bool *b = NULL, bool fromMigrate = false,
                 const BSONObj* fullObj = NULL );
 
+    /** The arguments of one logOp() call, for logOpBatch(). */
+    struct LogOpBatchEntry {
+        BSONObj obj;
+        BSONObj pattern;  // passed as 'patt' unless empty
+        BSONObj fullObj;
+    };
+
+    /**
+     * Logs 'entries' as if by one logOp() call each, but takes the local database lock once
+     * for the whole run, so a multi-document write lays its entries down back to back.
+     * The caller must hold its write lock from the first write of the run until this returns.
+     */
+    void logOpBatch( const char *opstr, const char *ns,
+                     const std::vector<LogOpBatchEntry>& entries, bool fromMigrate = false );
+
     // Log an empty no-op operation to the local oplog
     void logKeepalive();
 
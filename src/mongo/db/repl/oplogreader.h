@@ -37,7 +37,15 @@ namespace mongo {
     public:
         OplogReader( bool doHandshake = true );
         ~OplogReader() { }
-        void resetCursor() { cursor.reset(); }
+        void resetCursor() {
+            // a live exhaust cursor's batches are still streaming at us, so the connection
+            // can't be used for anything else
+            if ( cursor.get() && !cursor->isDead() &&
+                 ( _tailingQueryOptions & QueryOption_Exhaust ) ) {
+                _conn.reset();
+            }
+            cursor.reset();
+        }
         void resetConnection() {
             cursor.reset();
             _conn.reset();
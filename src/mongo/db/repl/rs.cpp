@@ -453,6 +453,7 @@ namespace mongo {
         _maintenanceMode(0),
         mgr(0),
         ghost(0),
+        _syncSourceRatesMutex("syncSourceRates"),
         _writerPool(replWriterThreadCount),
         _prefetcherPool(replPrefetcherThreadCount),
         oplogVersion(0),
@@ -592,6 +593,12 @@ namespace mongo {
             additive = false;
         }
 
+        // The health tasks read the heartbeat settings when they start, so restart them if those
+        // change.
+        if (reconf && !config().sameHeartbeatSettings(c)) {
+            additive = false;
+        }
+
         _cfg = new ReplSetConfig(c);
         dassert( &config() == _cfg ); // config() is same thing but const, so we use that when we can for clarity below
         verify( config().ok() );
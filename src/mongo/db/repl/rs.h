@@ -29,7 +29,7 @@
 #include "mongo/db/repl/sync_source_feedback.h"
 #include "mongo/util/concurrency/list.h"
 #include "mongo/util/concurrency/msg.h"
-#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/work_stealing_pool.h"
 #include "mongo/util/concurrency/value.h"
 #include "mongo/util/net/hostandport.h"
 
@@ -347,14 +347,22 @@ namespace mongo {
         OpTime lastOpTimeWritten;
         long long lastH; // hash we use to make sure we are reading the right flow of ops and aren't on an out-of-date "fork"
         bool forceSyncFrom(const string& host, string& errmsg, BSONObjBuilder& result);
-        // Check if the current sync target is suboptimal. This must be called while holding a mutex
-        // that prevents the sync source from changing.
-        bool shouldChangeSyncTarget(const OpTime& target) const;
+        // Check if the current sync target, synced from since 'syncingSince', is suboptimal. This
+        // must be called while holding a mutex that prevents the sync source from changing.
+        bool shouldChangeSyncTarget(const Member* target, time_t syncingSince) const;
 
         /**
-         * Find the closest member (using ping time) with a higher latest optime.
+         * Find the member with the best sync source score (see syncSourceScore()) with a higher
+         * latest optime.
          */
         const Member* getMemberToSyncTo();
+
+        /**
+         * Notes that 'bytes' of oplog came from sync source 'host' in 'millis' ms, while this
+         * member was far enough behind that the speed is the source's, not the primary's write
+         * rate.
+         */
+        void noteSyncSourceFetch(const string& host, long long bytes, long long millis);
         void veto(const string& host, unsigned secs=10);
         bool gotForceSync();
         void goStale(const Member* m, const BSONObj& o);
@@ -536,10 +544,21 @@ namespace mongo {
 
         // keep a list of hosts that we've tried recently that didn't work
         map<string,time_t> _veto;
+
+        /**
+         * How costly syncing from 'm' looks, in ms: its ping time, plus a penalty for how far its
+         * oplog is behind 'primaryOpTime', plus how long a megabyte of oplog takes to fetch from
+         * it.  Lower is better.
+         */
+        double syncSourceScore(const Member* m, const OpTime& primaryOpTime) const;
+
+        // measured oplog fetch rates of the members we have synced from, in bytes per second
+        mutable SimpleMutex _syncSourceRatesMutex;
+        map<string,double> _syncSourceRates;
         // persistent pool of worker threads for writing ops to the databases
-        threadpool::ThreadPool _writerPool;
+        WorkStealingPool _writerPool;
         // persistent pool of worker threads for prefetching
-        threadpool::ThreadPool _prefetcherPool;
+        WorkStealingPool _prefetcherPool;
 
     public:
         // Allow index prefetching to be turned on/off
@@ -556,8 +575,8 @@ namespace mongo {
             
         static const int replWriterThreadCount;
         static const int replPrefetcherThreadCount;
-        threadpool::ThreadPool& getPrefetchPool() { return _prefetcherPool; }
-        threadpool::ThreadPool& getWriterPool() { return _writerPool; }
+        WorkStealingPool& getPrefetchPool() { return _prefetcherPool; }
+        WorkStealingPool& getWriterPool() { return _writerPool; }
 
         static const int maxSyncSourceLagSecs;
 
@@ -626,8 +645,8 @@ namespace mongo {
         void summarizeAsHtml(stringstream& ss) const { _summarizeAsHtml(ss); }
         void summarizeStatus(BSONObjBuilder& b) const  { _summarizeStatus(b); }
         void fillIsMaster(BSONObjBuilder& b) { _fillIsMaster(b); }
-        threadpool::ThreadPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
-        threadpool::ThreadPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
+        WorkStealingPool& getPrefetchPool() { return ReplSetImpl::getPrefetchPool(); }
+        WorkStealingPool& getWriterPool() { return ReplSetImpl::getWriterPool(); }
 
         /**
          * We have a new config (reconfig) - apply it.
@@ -34,6 +34,7 @@ namespace mongo {
 
     mongo::mutex ReplSetConfig::groupMx("RS tag group");
     const int ReplSetConfig::DEFAULT_HB_TIMEOUT = 10;
+    const int ReplSetConfig::DEFAULT_HB_INTERVAL = 2000;
 
     void logOpInitiate(const bo&);
 
@@ -143,6 +144,16 @@ namespace mongo {
             empty = false;
         }
 
+        if (_heartbeatInterval != DEFAULT_HB_INTERVAL) {
+            settings << "heartbeatIntervalMillis" << _heartbeatInterval;
+            empty = false;
+        }
+
+        if (_heartbeatSuspicionThreshold != 0) {
+            settings << "heartbeatSuspicionThreshold" << _heartbeatSuspicionThreshold;
+            empty = false;
+        }
+
         if (!_chainingAllowed) {
             settings << "chainingAllowed" << _chainingAllowed;
             empty = false;
@@ -582,6 +593,19 @@ namespace mongo {
                 _heartbeatTimeout = timeout;
             }
 
+            if (settings.hasField("heartbeatIntervalMillis")) {
+                int interval = settings["heartbeatIntervalMillis"].numberInt();
+                uassert(17038, "Heartbeat interval must be at least 100ms", interval >= 100);
+                _heartbeatInterval = interval;
+            }
+
+            if (settings.hasField("heartbeatSuspicionThreshold")) {
+                double threshold = settings["heartbeatSuspicionThreshold"].numberDouble();
+                uassert(17039, "Heartbeat suspicion threshold must be non-negative",
+                        threshold >= 0);
+                _heartbeatSuspicionThreshold = threshold;
+            }
+
             // If the config explicitly sets chaining to false, turn it off.
             if (settings.hasField("chainingAllowed") &&
                 !settings["chainingAllowed"].trueValue()) {
@@ -601,6 +625,20 @@ namespace mongo {
         return _heartbeatTimeout;
     }
 
+    int ReplSetConfig::getHeartbeatInterval() const {
+        return _heartbeatInterval;
+    }
+
+    double ReplSetConfig::getHeartbeatSuspicionThreshold() const {
+        return _heartbeatSuspicionThreshold;
+    }
+
+    bool ReplSetConfig::sameHeartbeatSettings(const ReplSetConfig& other) const {
+        return _heartbeatTimeout == other._heartbeatTimeout &&
+               _heartbeatInterval == other._heartbeatInterval &&
+               _heartbeatSuspicionThreshold == other._heartbeatSuspicionThreshold;
+    }
+
     static inline void configAssert(bool expr) {
         uassert(13122, "bad repl set config?", expr);
     }
@@ -610,7 +648,9 @@ namespace mongo {
         _chainingAllowed(true),
         _majority(-1),
         _ok(false),
-        _heartbeatTimeout(DEFAULT_HB_TIMEOUT) {
+        _heartbeatTimeout(DEFAULT_HB_TIMEOUT),
+        _heartbeatInterval(DEFAULT_HB_INTERVAL),
+        _heartbeatSuspicionThreshold(0) {
     }
 
     ReplSetConfig* ReplSetConfig::make(BSONObj cfg, bool force) {
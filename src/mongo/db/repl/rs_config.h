@@ -170,6 +170,28 @@ namespace mongo {
          */
         static const int DEFAULT_HB_TIMEOUT;
 
+        /**
+         * Get the time between heartbeats to each member, in milliseconds.
+         */
+        int getHeartbeatInterval() const;
+
+        /**
+         * Default interval: 2 seconds
+         */
+        static const int DEFAULT_HB_INTERVAL;
+
+        /**
+         * Get the suspicion level, in the phi accrual sense, past which a member that hasn't
+         * answered a heartbeat is taken to be down.  0 means members are only taken down once a
+         * heartbeat times out.
+         */
+        double getHeartbeatSuspicionThreshold() const;
+
+        /**
+         * Whether heartbeats to the members of 'other' go the same way as to those of this config.
+         */
+        bool sameHeartbeatSettings(const ReplSetConfig& other) const;
+
         /**
          * Returns if replication chaining is allowed.
          */
@@ -198,6 +220,9 @@ namespace mongo {
          */
         int _heartbeatTimeout;
 
+        int _heartbeatInterval;
+        double _heartbeatSuspicionThreshold;
+
         /**
          * This is a logical grouping of servers.  It is pointed to by a set of
          * servers with a certain tag.
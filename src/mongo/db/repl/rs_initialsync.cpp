@@ -21,6 +21,7 @@
 #include "mongo/db/client.h"
 #include "mongo/db/cloner.h"
 #include "mongo/db/dbhelpers.h"
+#include "mongo/db/instance.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/oplogreader.h"
@@ -94,6 +95,7 @@ namespace mongo {
             options.mayBeInterrupted = false;
             options.syncData = dataPass;
             options.syncIndexes = ! dataPass;
+            options.foregroundIndexes = true;
 
             if (!cloner.go(master, options, err, &errCode)) {
                 sethbmsg(str::stream() << "initial sync: error while "
@@ -121,6 +123,21 @@ namespace mongo {
         d->emptyCappedCollection(rsoplog);
     }
 
+    /**
+     * True if the dbpath holds any database besides local, i.e. something --fastsync could
+     * have been seeded with.
+     */
+    static bool haveSeedData() {
+        vector<string> names;
+        getDatabaseNames(names);
+        for (vector<string>::const_iterator i = names.begin(); i != names.end(); ++i) {
+            if (*i != "local") {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool Member::syncable() const {
         bool buildIndexes = theReplSet ? theReplSet->buildIndexes() : true;
         return hbinfo().up() && (config().buildIndexes || !buildIndexes) && state().readable();
@@ -156,7 +173,7 @@ namespace mongo {
             }
         }
 
-        // find the member with the lowest ping time that has more data than me
+        // find the member with the best score that has more data than me
 
         // Find primary's oplog time. Reject sync candidates that are more than
         // maxSyncSourceLagSecs seconds behind.
@@ -176,6 +193,7 @@ namespace mongo {
         OpTime oldestSyncOpTime(primaryOpTime.getSecs() - maxSyncSourceLagSecs, 0);
 
         Member *closest = 0;
+        double closestScore = 0;
         time_t now = 0;
 
         // Make two attempts.  The first attempt, we ignore those nodes with
@@ -197,9 +215,9 @@ namespace mongo {
                         continue;
                 }
 
-                // omit nodes that are more latent than anything we've already considered
-                if (closest &&
-                    (m->hbinfo().ping > closest->hbinfo().ping))
+                // omit nodes that score worse than anything we've already considered
+                double score = syncSourceScore(m, primaryOpTime);
+                if (closest && score > closestScore)
                     continue;
 
                 if (attempts == 0 &&
@@ -228,6 +246,7 @@ namespace mongo {
                 }
                 // This candidate has passed all tests; set 'closest'
                 closest = m;
+                closestScore = score;
             }
             if (closest) break; // no need for second attempt
         }
@@ -378,6 +397,13 @@ namespace mongo {
         // written by applyToHead calls
         BSONObj minValid;
 
+        if (replSettings.fastsync && !haveSeedData()) {
+            // skipping the clone now would leave us an empty member claiming to be in sync
+            log() << "fastsync: no databases in " << dbpath << " to start from, "
+                  << "doing a full initial sync instead" << rsLog;
+            replSettings.fastsync = false;
+        }
+
         if (replSettings.fastsync) {
             log() << "fastsync: skipping database clone" << rsLog;
 
@@ -304,6 +304,10 @@ namespace mongo {
         bson::bo goodVersionOfObject;
     };
 
+    // Most _ids, and most bytes of _ids, asked for by one rollback refetch query
+    static const int refetchBatchSize = 1000;
+    static const int refetchBatchBytes = 1024 * 1024;
+
     void ReplSetImpl::syncFixUp(HowToFixUp& h, OplogReader& r) {
         DBClientConnection *them = r.conn();
 
@@ -315,24 +319,55 @@ namespace mongo {
 
         bo newMinValid;
 
-        /* fetch all the goodVersions of each document from current primary */
+        /* fetch all the goodVersions of each document from current primary.  toRefetch is
+           ordered by ns, so each namespace's documents are asked for together, a batch of _ids
+           per { _id : { $in : [...] } } query. */
         DocID d;
         unsigned long long n = 0;
         try {
-            for( set<DocID>::iterator i = h.toRefetch.begin(); i != h.toRefetch.end(); i++ ) {
+            set<DocID>::iterator i = h.toRefetch.begin();
+            while( i != h.toRefetch.end() ) {
                 d = *i;
 
-                verify( !d._id.eoo() );
-
+                set<DocID>::iterator batchEnd = i;
+                BSONObjBuilder query;
                 {
-                    /* TODO : slow.  lots of round trips. */
-                    n++;
-                    bo good= them->findOne(d.ns, d._id.wrap(), NULL, QueryOption_SlaveOk).getOwned();
+                    BSONObjBuilder idClause( query.subobjStart( "_id" ) );
+                    BSONArrayBuilder ids( idClause.subarrayStart( "$in" ) );
+                    for( int count = 0;
+                         batchEnd != h.toRefetch.end() && strcmp( batchEnd->ns, d.ns ) == 0 &&
+                             count < refetchBatchSize && ids.len() < refetchBatchBytes;
+                         ++batchEnd, ++count ) {
+                        verify( !batchEnd->_id.eoo() );
+                        ids.append( batchEnd->_id );
+                    }
+                    ids.done();
+                    idClause.done();
+                }
+
+                map<DocID,bo> fetched;
+                auto_ptr<DBClientCursor> cursor = them->query( d.ns, query.done(), 0, 0, NULL,
+                                                               QueryOption_SlaveOk );
+                uassert( 17000, str::stream() << "rollback refetch query on " << d.ns << " failed",
+                         cursor.get() );
+                while( cursor->more() ) {
+                    bo good = cursor->nextSafe().getOwned();
                     totSize += good.objsize();
                     uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
 
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID,bo>(d,good));
+                    DocID found;
+                    found.ns = d.ns;
+                    found._id = good["_id"];
+                    fetched[found] = good;
+                }
+
+                for( ; i != batchEnd; ++i ) {
+                    n++;
+                    // note a document the source no longer has comes back as eoo, indicating
+                    // we should delete it
+                    map<DocID,bo>::const_iterator good = fetched.find( *i );
+                    goodVersions.push_back( pair<DocID,bo>( *i, good == fetched.end() ? bo() :
+                                                                                      good->second ) );
                 }
             }
             newMinValid = r.getLastOp(rsoplog);
@@ -18,6 +18,7 @@
 
 #include "mongo/db/repl/rs_sync.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "third_party/murmurhash3/MurmurHash3.h"
@@ -25,12 +26,16 @@
 #include "mongo/db/client.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/database_holder.h"
+#include "mongo/db/index_builder.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/pdfile.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_sync.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/fail_point_service.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -63,6 +68,41 @@ namespace replset {
     static Counter64 opsAppliedStats;
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
+    //The oplog entries prefetched, and those skipped because another op in the batch already
+    //    prefetched the same pages
+    static Counter64 opsPrefetchedStats;
+    static ServerStatusMetricField<Counter64> displayOpsPrefetched( "repl.preload.ops",
+                                                                   &opsPrefetchedStats );
+    static Counter64 opsPrefetchSkippedStats;
+    static ServerStatusMetricField<Counter64> displayOpsPrefetchSkipped(
+                                                    "repl.preload.duplicateOps",
+                                                    &opsPrefetchSkippedStats );
+
+    // A prefetch worker handles up to this many ops on one namespace under a single read lock
+    static const size_t prefetchRunLength = 64;
+
+    // A writer applies up to this many consecutive inserts on one collection under a single
+    // write lock
+    static const size_t insertRunLength = 256;
+
+    /**
+     * Commands that need the indexes of the collection they name to be complete wait, before any
+     * lock is taken, for the background builds replication started on that collection.  The
+     * commands that drop or rebuild indexes stop the builds themselves instead, and no other op
+     * is held up at all.
+     */
+    static void waitForIndexBuilds(const BSONObj& op) {
+        if (op["op"].valuestrsafe()[0] != 'c' || !op["o"].isABSONObj()) {
+            return;
+        }
+        BSONElement cmd = op["o"].Obj().firstElement();
+        if (!str::equals(cmd.fieldName(), "collMod") &&
+            !str::equals(cmd.fieldName(), "convertToCapped")) {
+            return;
+        }
+        std::string db = nsToDatabase(op.getStringField("ns"));
+        IndexBuilder::waitForBuilds(db + "." + cmd.valuestrsafe());
+    }
 
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
@@ -100,8 +140,8 @@ namespace replset {
             // ahead and grab one here. suboptimal. :-(
             lk.reset(new Lock::GlobalWrite());
         } else {
-            // DB level lock for this operation
-            lk.reset(new Lock::DBWrite(ns)); 
+            // collection level lock for this operation
+            lk.reset(new Lock::CollectionWrite(ns)); 
         }
 
         Client::Context ctx(ns, dbpath);
@@ -115,6 +155,38 @@ namespace replset {
         return ok;
     }
 
+    // static
+    bool SyncTail::isGroupableInsert(const BSONObj& op) {
+        if (*op.getStringField("op") != 'i') {
+            return false;
+        }
+
+        // index builds keep the single op path
+        const char* ns = op.getStringField("ns");
+        return *ns != '\0' && *ns != '.' && nsToCollectionSubstring(ns) != "system.indexes";
+    }
+
+    bool SyncTail::syncApplyInserts(const BSONObj* ops, size_t n, const BSONObj** failed) {
+        const char* ns = ops[0].getStringField("ns");
+
+        Lock::CollectionWrite lk(ns);
+        Client::Context ctx(ns, dbpath);
+
+        for (size_t i = 0; i < n; ++i) {
+            dassert(isGroupableInsert(ops[i]));
+            dassert(str::equals(ops[i].getStringField("ns"), ns));
+
+            *failed = &ops[i];
+            ctx.getClient()->curop()->reset();
+            if (applyOperation_inlock(ops[i], true)) {
+                return false;
+            }
+            opsAppliedStats.increment();
+            getDur().commitIfNeeded();
+        }
+        return true;
+    }
+
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
@@ -142,18 +214,32 @@ namespace replset {
         // idempotent operations for this to work.  See SERVER-6825
         bool convertUpdatesToUpserts = theReplSet->oplogVersion > 1 ? true : false;
 
-        for (std::vector<BSONObj>::const_iterator it = ops.begin();
-             it != ops.end();
-             ++it) {
+        for (size_t i = 0; i < ops.size(); ) {
+            // group consecutive inserts on one collection so they share a lock and context
+            size_t end = i + 1;
+            if (SyncTail::isGroupableInsert(ops[i])) {
+                const StringData ns = ops[i].getStringField("ns");
+                while (end < ops.size() && end - i < insertRunLength
+                       && SyncTail::isGroupableInsert(ops[end])
+                       && ns == ops[end].getStringField("ns")) {
+                    ++end;
+                }
+            }
+
+            const BSONObj* current = &ops[i];
             try {
-                if (!st->syncApply(*it, convertUpdatesToUpserts)) {
+                bool ok = (end - i == 1)
+                        ? st->syncApply(ops[i], convertUpdatesToUpserts)
+                        : st->syncApplyInserts(&ops[i], end - i, &current);
+                if (!ok) {
                     fassertFailedNoTrace(16359);
                 }
             } catch (const DBException& e) {
                 error() << "writer worker caught exception: " << causedBy(e)
-                        << " on: " << it->toString() << endl;
+                        << " on: " << current->toString() << endl;
                 fassertFailedNoTrace(16360);
             }
+            i = end;
         }
     }
 
@@ -189,58 +275,143 @@ namespace replset {
     }
 
 
-    // The pool threads call this to prefetch each op
-    void SyncTail::prefetchOp(const BSONObj& op) {
+    // The pool threads call this to prefetch each run of ops, all on the same namespace
+    void SyncTail::prefetchRun(const std::vector<BSONObj>& ops) {
         initializePrefetchThread();
 
-        const char *ns = op.getStringField("ns");
-        if (ns && (ns[0] != '\0')) {
-            try {
-                // one possible tweak here would be to stay in the read lock for this database 
-                // for multiple prefetches if they are for the same database.
-                Client::ReadContext ctx(ns);
-                prefetchPagesForReplicatedOp(op);
-            }
-            catch (const DBException& e) {
-                LOG(2) << "ignoring exception in prefetchOp(): " << e.what() << endl;
-            }
-            catch (const std::exception& e) {
-                log() << "Unhandled std::exception in prefetchOp(): " << e.what() << endl;
-                fassertFailed(16397);
+        const char *ns = ops.front().getStringField("ns");
+        try {
+            Client::ReadContext ctx(ns);
+            for (std::vector<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+                try {
+                    prefetchPagesForReplicatedOp(*it);
+                }
+                catch (const DBException& e) {
+                    LOG(2) << "ignoring exception in prefetchRun(): " << e.what() << endl;
+                }
             }
         }
+        catch (const DBException& e) {
+            LOG(2) << "ignoring exception in prefetchRun(): " << e.what() << endl;
+        }
+        catch (const std::exception& e) {
+            log() << "Unhandled std::exception in prefetchRun(): " << e.what() << endl;
+            fassertFailed(16397);
+        }
     }
 
+    namespace {
+
+        // The document prefetchPagesForReplicatedOp() looks at for 'op', empty if it skips 'op'
+        BSONObj prefetchTarget(const BSONObj& op) {
+            switch (*op.getStringField("op")) {
+            case 'i':
+            case 'd':
+                return op.getObjectField("o");
+            case 'u':
+                return op.getObjectField("o2");
+            default:
+                return BSONObj();
+            }
+        }
+
+        // An op to prefetch, with what orders and identifies it within its namespace
+        struct PrefetchEntry {
+            BSONElement id;
+            BSONObj target;
+            BSONObj op;
+
+            bool operator<(const PrefetchEntry& other) const {
+                int cmp = id.woCompare(other.id, false);
+                if (cmp)
+                    return cmp < 0;
+                cmp = *op.getStringField("op") - *other.op.getStringField("op");
+                if (cmp)
+                    return cmp < 0;
+                return target.woCompare(other.target) < 0;
+            }
+            bool samePagesAs(const PrefetchEntry& other) const {
+                return !(*this < other) && !(other < *this);
+            }
+        };
+
+    } // namespace
+
     // Doles out all the work to the reader pool threads and waits for them to complete
     void SyncTail::prefetchOps(const std::deque<BSONObj>& ops) {
-        threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
-        for (std::deque<BSONObj>::const_iterator it = ops.begin();
-             it != ops.end();
+        // Group the batch by namespace.  Within a namespace, order the ops by _id so that the
+        // _id index, which every op touches, is walked in order, and drop the ops that would
+        // touch exactly the pages an earlier op did, such as repeated updates of a document.
+        typedef std::map<StringData, std::vector<PrefetchEntry> > EntriesByNs;
+        EntriesByNs byNs;
+        for (std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it) {
+            const char* ns = it->getStringField("ns");
+            if (!ns[0])
+                continue;
+
+            PrefetchEntry entry;
+            entry.target = prefetchTarget(*it);
+            if (entry.target.isEmpty())
+                continue;
+            entry.id = entry.target["_id"];
+            entry.op = *it;
+            byNs[ns].push_back(entry);
+        }
+
+        std::vector<std::vector<BSONObj> > runs;
+        for (EntriesByNs::iterator it = byNs.begin(); it != byNs.end(); ++it) {
+            std::vector<PrefetchEntry>& entries = it->second;
+            std::stable_sort(entries.begin(), entries.end());
+
+            size_t runStart = runs.size();
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (i > 0 && entries[i].samePagesAs(entries[i - 1])) {
+                    opsPrefetchSkippedStats.increment();
+                    continue;
+                }
+                if (runs.size() == runStart || runs.back().size() >= prefetchRunLength) {
+                    runs.push_back(std::vector<BSONObj>());
+                    runs.back().reserve(std::min(prefetchRunLength, entries.size() - i));
+                }
+                runs.back().push_back(entries[i].op);
+                opsPrefetchedStats.increment();
+            }
+        }
+
+        WorkStealingPool& prefetcherPool = theReplSet->getPrefetchPool();
+        std::vector<WorkStealingPool::Task> tasks;
+        tasks.reserve(runs.size());
+        for (std::vector<std::vector<BSONObj> >::const_iterator it = runs.begin();
+             it != runs.end();
              ++it) {
-            prefetcherPool.schedule(&prefetchOp, *it);
+            tasks.push_back(boost::bind(&prefetchRun, boost::cref(*it)));
         }
+        prefetcherPool.schedule(tasks);
         prefetcherPool.join();
     }
     
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                                      MultiSyncApplyFunc applyFunc) {
-        ThreadPool& writerPool = theReplSet->getWriterPool();
+        WorkStealingPool& writerPool = theReplSet->getWriterPool();
         TimerHolder timer(&applyBatchStats);
+        std::vector<WorkStealingPool::Task> tasks;
+        tasks.reserve(writerVectors.size());
         for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
              it != writerVectors.end();
              ++it) {
             if (!it->empty()) {
-                writerPool.schedule(applyFunc, boost::cref(*it), this);
+                tasks.push_back(boost::bind(applyFunc, boost::cref(*it), this));
             }
         }
+        writerPool.schedule(tasks);
         writerPool.join();
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::multiApply( std::deque<BSONObj>& ops, MultiSyncApplyFunc applyFunc ) {
 
-        // Use a ThreadPool to prefetch all the operations in a batch.
+        // Use the prefetcher pool to prefetch all the operations in a batch.
         prefetchOps(ops);
         
         std::vector< std::vector<BSONObj> > writerVectors(theReplSet->replWriterThreadCount);
@@ -258,8 +429,45 @@ namespace replset {
     }
 
 
+    // Spread CRUD ops on a single collection over the writer threads by _id.  When off, or for
+    // collections where that isn't safe, all ops on a namespace go to the same writer.
+    MONGO_EXPORT_SERVER_PARAMETER(replWriterPartitionById, bool, true);
+
+    bool SyncTail::canPartitionById(const std::string& ns, std::map<std::string, bool>* cache) {
+        std::map<std::string, bool>::const_iterator i = cache->find(ns);
+        if (i != cache->end()) {
+            return i->second;
+        }
+
+        // Ops touching different documents can only be reordered safely if nothing but the
+        // _id index constrains them: with another unique index, a delete of {a:1} followed by
+        // an insert of a new document with {a:1} would fail if the insert went first.  Capped
+        // collections must keep insertion order.  Unknown collections are applied in order.
+        bool ok = false;
+        {
+            Lock::DBRead lk(ns);
+            Database* db = dbHolder().get(ns, dbpath);
+            NamespaceDetails* d = db ? db->namespaceIndex().details(ns) : NULL;
+            if (d && !d->isCapped()) {
+                ok = true;
+                NamespaceDetails::IndexIterator ii = d->ii(true);
+                while (ok && ii.more()) {
+                    IndexDetails& idx = ii.next();
+                    if (idx.unique() && !idx.isIdIndex()) {
+                        ok = false;
+                    }
+                }
+            }
+        }
+
+        (*cache)[ns] = ok;
+        return ok;
+    }
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        std::map<std::string, bool> partitionable;
+
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
@@ -270,6 +478,25 @@ namespace replset {
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            // Commands and index builds always arrive in batches of their own (see
+            // tryPopAndWaitForMore), so within a batch only the order of ops on the same
+            // document matters.  Keep those on one writer by hashing the _id in too.
+            if (replWriterPartitionById) {
+                BSONElement id;
+                switch (*it->getField("op").valuestrsafe()) {
+                case 'i':
+                case 'd':
+                    id = it->getObjectField("o")["_id"];
+                    break;
+                case 'u':
+                    id = it->getObjectField("o2")["_id"];
+                    break;
+                }
+                if (!id.eoo() && canPartitionById(ns, &partitionable)) {
+                    MurmurHash3_x86_32(id.value(), id.valuesize(), hash, &hash);
+                }
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
@@ -455,6 +682,9 @@ namespace replset {
             setOplogVersion(lastOp);
             handleSlaveDelay(lastOp);
 
+            // Commands are applied one per batch, so this is the only op if it is one.
+            waitForIndexBuilds(lastOp);
+
             // Set minValid to the last op to be applied in this next batch.
             // This will cause this node to go into RECOVERING state
             // if we should crash and restart before updating the oplog
@@ -713,7 +943,71 @@ namespace replset {
         return _forceSyncTarget != 0;
     }
 
-    bool ReplSetImpl::shouldChangeSyncTarget(const OpTime& targetOpTime) const {
+    // How long to stay with a sync source before leaving it for one that merely scores better,
+    // and how much better, in percent, the other must score.  Together they keep a member from
+    // flapping between sources whose scores are close or still settling.
+    MONGO_EXPORT_SERVER_PARAMETER(syncSourceMinSecs, int, 60);
+    MONGO_EXPORT_SERVER_PARAMETER(syncSourceSwitchPercent, int, 30);
+
+    namespace {
+        // the amount of oplog whose fetch time counts toward a sync source's score
+        const double kScoreFetchBytes = 1024 * 1024;
+
+        // Lag behind the primary counts toward a score past this many seconds only, since the
+        // optimes heartbeats report are a couple of seconds old anyway, and then by this many ms
+        // per second.
+        const unsigned kScoreLagGraceSecs = 5;
+        const double kScoreLagMillisPerSec = 100;
+
+        // weight of each new measurement in a sync source's fetch rate
+        const double kFetchRateWeight = 0.2;
+    }
+
+    double ReplSetImpl::syncSourceScore(const Member* m, const OpTime& primaryOpTime) const {
+        double score = m->hbinfo().ping;
+
+        const unsigned secs = m->hbinfo().opTime.getSecs();
+        if (secs + kScoreLagGraceSecs < primaryOpTime.getSecs()) {
+            score += kScoreLagMillisPerSec * (primaryOpTime.getSecs() - kScoreLagGraceSecs - secs);
+        }
+
+        double rate = 0;
+        {
+            SimpleMutex::scoped_lock lk(_syncSourceRatesMutex);
+            map<string,double>::const_iterator i = _syncSourceRates.find(m->fullName());
+            if (i != _syncSourceRates.end()) {
+                rate = i->second;
+            }
+            else if (!_syncSourceRates.empty()) {
+                // Members we haven't measured are taken to be as fast as the average of those we
+                // have, so that neither kind is preferred for it.
+                for (i = _syncSourceRates.begin(); i != _syncSourceRates.end(); ++i) {
+                    rate += i->second;
+                }
+                rate /= _syncSourceRates.size();
+            }
+        }
+        if (rate > 0) {
+            score += 1000.0 * kScoreFetchBytes / rate;
+        }
+
+        return score;
+    }
+
+    void ReplSetImpl::noteSyncSourceFetch(const string& host, long long bytes, long long millis) {
+        double rate = bytes * 1000.0 / std::max(millis, 1LL);
+        SimpleMutex::scoped_lock lk(_syncSourceRatesMutex);
+        map<string,double>::iterator i = _syncSourceRates.find(host);
+        if (i == _syncSourceRates.end()) {
+            _syncSourceRates[host] = rate;
+        }
+        else {
+            i->second += kFetchRateWeight * (rate - i->second);
+        }
+    }
+
+    bool ReplSetImpl::shouldChangeSyncTarget(const Member* target, time_t syncingSince) const {
+        const OpTime& targetOpTime = target->hbinfo().opTime;
         for (Member *m = _members.head(); m; m = m->next()) {
             if (m->syncable() &&
                 targetOpTime.getSecs()+maxSyncSourceLagSecs < m->hbinfo().opTime.getSecs()) {
@@ -721,6 +1015,28 @@ namespace replset {
             }
         }
 
+        if (!_cfg || !_cfg->chainingAllowed() || time(0) - syncingSince < syncSourceMinSecs) {
+            return false;
+        }
+
+        // is there a source we'd pick over this one by enough of a margin?
+        const Member* primary = box.getPrimary();
+        const OpTime primaryOpTime = primary ? primary->hbinfo().opTime : targetOpTime;
+        const double targetScore = syncSourceScore(target, primaryOpTime);
+        for (Member *m = _members.head(); m; m = m->next()) {
+            if (m == target || !m->syncable() || m->hbinfo().opTime <= lastOpTimeWritten ||
+                myConfig().slaveDelay < m->config().slaveDelay || m->config().hidden) {
+                continue;
+            }
+            double score = syncSourceScore(m, primaryOpTime);
+            if (score * 100 < targetScore * (100 - syncSourceSwitchPercent)) {
+                log() << "replSet changing sync source from " << target->fullName()
+                      << " (score " << targetScore << ") to a better one, " << m->fullName()
+                      << " (score " << score << ")" << rsLog;
+                return true;
+            }
+        }
+
         return false;
     }
 
@@ -40,6 +40,19 @@ namespace replset {
         virtual ~SyncTail();
         virtual bool syncApply(const BSONObj &o, bool convertUpdateToUpsert = false);
 
+        /**
+         * Apply 'n' insert ops on the same collection, starting at 'ops', under one lock and
+         * context.  See isGroupableInsert().
+         * @return false if any insert failed; *failed is set to the op that did
+         */
+        bool syncApplyInserts(const BSONObj* ops, size_t n, const BSONObj** failed);
+
+        /**
+         * True if 'op' is an insert that syncApplyInserts() can apply alongside neighbouring
+         * inserts on the same namespace.
+         */
+        static bool isGroupableInsert(const BSONObj& op);
+
         /**
          * Apply ops from applyGTEObj's ts to at least minValidObj's ts.  Note that, due to
          * batching, this may end up applying ops beyond minValidObj's ts.
@@ -113,8 +126,8 @@ namespace replset {
 
         // Doles out all the work to the reader pool threads and waits for them to complete
         void prefetchOps(const std::deque<BSONObj>& ops);
-        // Used by the thread pool readers to prefetch an op
-        static void prefetchOp(const BSONObj& op);
+        // Used by the thread pool readers to prefetch a run of ops on one namespace
+        static void prefetchRun(const std::vector<BSONObj>& ops);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
@@ -122,6 +135,10 @@ namespace replset {
 
         void fillWriterVectors(const std::deque<BSONObj>& ops, 
                                std::vector< std::vector<BSONObj> >* writerVectors);
+
+        // Whether CRUD ops on ns can be spread across writer threads by _id instead of all
+        // going to one thread.  Answers are cached in 'cache' for the batch being filled.
+        static bool canPartitionById(const std::string& ns, std::map<std::string, bool>* cache);
         void handleSlaveDelay(const BSONObj& op);
         void setOplogVersion(const BSONObj& op);
     };
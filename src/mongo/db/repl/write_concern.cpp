@@ -65,6 +65,7 @@ namespace mongo {
             _dirty = false;
             _started = false;
             _currentlyUpdatingCache = false;
+            _progress = 0;
         }
 
         void run() {
@@ -140,6 +141,7 @@ namespace mongo {
                     go();
                 }
 
+                ++_progress;
                 _threadsWaitingForReplication.notify_all();
             }
         }
@@ -211,6 +213,29 @@ namespace mongo {
             return true;
         }
 
+        unsigned long long getProgress() const {
+            scoped_lock mylk(_mutex);
+            return _progress;
+        }
+
+        void waitForProgress(unsigned long long since, int maxMillis) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, MONGO_BOOST_TIME_UTC);
+            xt.sec += maxMillis / 1000;
+            xt.nsec += (maxMillis % 1000) * 1000000;
+            if (xt.nsec >= 1000000000) {
+                xt.nsec -= 1000000000;
+                xt.sec++;
+            }
+
+            scoped_lock mylk(_mutex);
+            while (_progress == since) {
+                if (!_threadsWaitingForReplication.timed_wait(mylk.boost(), xt)) {
+                    return;
+                }
+            }
+        }
+
         bool _replicatedToNum_slaves_locked(OpTime& op, int numSlaves ) {
             for ( map<Ident,OpTime>::iterator i=_slaves.begin(); i!=_slaves.end(); i++) {
                 OpTime s = i->second;
@@ -254,6 +279,7 @@ namespace mongo {
         bool _dirty;
         bool _started;
         bool _currentlyUpdatingCache; // this is not thread safe, but ok for our purposes
+        unsigned long long _progress; // bumped by every update() that moves a slave forward
 
     } slaveTracking;
 
@@ -324,6 +350,14 @@ namespace mongo {
         return slaveTracking.waitForReplication( op, w, maxSecondsToWait );
     }
 
+    unsigned long long getReplicationProgress() {
+        return slaveTracking.getProgress();
+    }
+
+    void waitForReplicationProgress( unsigned long long since , int maxMillis ) {
+        slaveTracking.waitForProgress( since, maxMillis );
+    }
+
     vector<BSONObj> getHostsWrittenTo(OpTime& op) {
         return slaveTracking.getHostsAtOp(op);
     }
@@ -39,6 +39,15 @@ namespace mongo {
 
     bool waitForReplication( OpTime op , int w , int maxSecondsToWait );
 
+    /** @return a count that changes whenever any slave's position moves forward */
+    unsigned long long getReplicationProgress();
+
+    /**
+     * Waits until getReplicationProgress() no longer returns 'since', or for 'maxMillis'.
+     * Take 'since' before checking opReplicatedEnough() so no progress is missed.
+     */
+    void waitForReplicationProgress( unsigned long long since , int maxMillis );
+
     std::vector<BSONObj> getHostsWrittenTo(OpTime& op);
 
     void resetSlaveCache();
@@ -120,6 +120,10 @@ namespace mongo {
         uassert( ScanAndOrderMemoryLimitExceededAssertionCode,
                 "too much data for sort() with no index.  add an index or specify a smaller limit",
                 (unsigned)newApproxSize < MaxScanAndOrderBytes );
+        uassert( ScanAndOrderMemoryLimitExceededAssertionCode,
+                "too much data for sort() with no index for the memory limits of the operation or "
+                "server.  add an index or specify a smaller limit",
+                _memory.trySet( newApproxSize ) );
         _approxSize = newApproxSize;
     }
 
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "mongo/db/diskloc.h"
+#include "mongo/db/memory_tracker.h"
 #include "mongo/db/projection.h"
 #include "mongo/db/queryutil.h"
 
@@ -91,7 +92,7 @@ namespace mongo {
 
         /**
          * @throw ScanAndOrderMemoryLimitExceededAssertionCode if adding would grow memory usage
-         * to ScanAndOrder::MaxScanAndOrderBytes.
+         * to ScanAndOrder::MaxScanAndOrderBytes, or past what the op or server may hold.
          */
         void add(const BSONObj &o, const DiskLoc* loc);
 
@@ -121,6 +122,7 @@ namespace mongo {
         int _limit;   // max to send back.
         KeyType _order;
         unsigned _approxSize;
+        MemoryCharge _memory; // of _approxSize
 
     };
 
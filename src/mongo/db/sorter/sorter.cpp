@@ -35,13 +35,17 @@
 
 #include "mongo/db/sorter/sorter.h"
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
+#include <cstdlib>
+#include <limits>
 
 #include "mongo/base/string_data.h"
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/cmdline.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/bufreader.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/log.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/paths.h"
@@ -181,14 +185,28 @@ namespace mongo {
             }
 
             void fill() {
-                int32_t blockSize;
-                read(&blockSize, sizeof(blockSize));
+                int32_t rawSize;
+                read(&rawSize, sizeof(rawSize));
                 if (_done) return;
 
+                // negative size means compressed
+                const bool compressed = rawSize < 0;
+                const int32_t blockSize = std::abs(rawSize);
+
                 _buffer.reset(new char[blockSize]);
                 read(_buffer.get(), blockSize);
                 massert(16816, "file too short?", !_done);
-                _reader.reset(new BufReader(_buffer.get(), blockSize));
+
+                if (!compressed) {
+                    _reader.reset(new BufReader(_buffer.get(), blockSize));
+                    return;
+                }
+
+                massert(16989, str::stream() << "failed to uncompress a block of \""
+                                             << _fileName << '"',
+                        uncompress(_buffer.get(), blockSize, &_uncompressed));
+                _buffer.reset();
+                _reader.reset(new BufReader(_uncompressed.data(), _uncompressed.size()));
             }
 
             // sets _done to true on EOF - asserts on any other error
@@ -210,6 +228,7 @@ namespace mongo {
             const Settings _settings;
             bool _done;
             boost::scoped_array<char> _buffer;
+            std::string _uncompressed; // the current block, if it was compressed
             boost::scoped_ptr<BufReader> _reader;
             string _fileName;
             boost::shared_ptr<FileDeleter> _fileDeleter; // Must outlive _file
@@ -339,6 +358,46 @@ namespace mongo {
             STLComparator _greater; // named so calls make sense
         };
 
+        /**
+         * Merges spilled files into fewer, larger ones until no more than opts.maxFanIn are left,
+         * so the final merge doesn't read from too many files at once.  Each pass merges runs of
+         * neighboring files, keeping their order so merging stays stable.
+         */
+        template <typename Key, typename Value, typename Comparator>
+        void reduceToMaxFanIn(std::vector<boost::shared_ptr<SortIteratorInterface<Key, Value> > >*
+                                  iters,
+                              const SortOptions& opts,
+                              const Comparator& comp,
+                              const typename SortedFileWriter<Key, Value>::Settings& settings) {
+            typedef SortIteratorInterface<Key, Value> Iterator;
+            typedef std::pair<Key, Value> Data;
+
+            if (opts.maxFanIn < 2)
+                return;
+
+            while (iters->size() > opts.maxFanIn) {
+                std::vector<boost::shared_ptr<Iterator> > merged;
+                for (size_t i = 0; i < iters->size(); i += opts.maxFanIn) {
+                    const size_t end = std::min(i + opts.maxFanIn, iters->size());
+                    if (end - i == 1) {
+                        merged.push_back((*iters)[i]);
+                        continue;
+                    }
+
+                    std::vector<boost::shared_ptr<Iterator> > group(iters->begin() + i,
+                                                                   iters->begin() + end);
+                    boost::scoped_ptr<Iterator> it(Iterator::merge(group, opts, comp));
+                    SortedFileWriter<Key, Value> writer(settings);
+                    while (it->more()) {
+                        const Data data = it->next();
+                        writer.addAlreadySorted(data.first, data.second);
+                    }
+                    merged.push_back(boost::shared_ptr<Iterator>(writer.done()));
+                }
+                iters->swap(merged);
+            }
+        }
+
         template <typename Key, typename Value, typename Comparator>
         class NoLimitSorter : public Sorter<Key, Value> {
         public:
@@ -374,6 +433,7 @@ namespace mongo {
                 }
 
                 spill();
+                reduceToMaxFanIn(&_iters, _opts, _comp, _settings);
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
@@ -553,6 +613,7 @@ namespace mongo {
                 }
 
                 spill();
+                reduceToMaxFanIn(&_iters, _opts, _comp, _settings);
                 return Iterator::merge(_iters, _opts, _comp);
             }
 
@@ -670,9 +731,18 @@ namespace mongo {
         if (size == 0)
             return;
 
+        std::string compressed;
+        compress(_buffer.buf(), size, &compressed);
+        verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
+
+        const bool shouldCompress = compressed.size() < size_t(size);
+        const char* outBuffer = shouldCompress ? compressed.data() : _buffer.buf();
+        const int32_t outSize = shouldCompress ? int32_t(compressed.size()) : size;
+        const int32_t header = shouldCompress ? -outSize : outSize; // negative means compressed
+
         try {
-            _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
-            _file.write(_buffer.buf(), size);
+            _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            _file.write(outBuffer, outSize);
         } catch (const std::exception&) {
             msgasserted(16821, str::stream() << "error writing to file \"" << _fileName << "\": "
                                              << sorter::myErrnoWithDescription());
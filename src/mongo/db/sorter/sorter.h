@@ -83,11 +83,13 @@ namespace mongo {
         unsigned long long limit; /// number of KV pairs to be returned. 0 for no limit.
         size_t maxMemoryUsageBytes; /// Approximate.
         bool extSortAllowed; /// If false, uassert if more mem needed than allowed.
+        size_t maxFanIn; /// Most spill files merged at once. 0 for no limit.
 
         SortOptions()
             : limit(0)
             , maxMemoryUsageBytes(64*1024*1024)
             , extSortAllowed(false)
+            , maxFanIn(0)
         {}
 
         /// Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
@@ -106,6 +108,11 @@ namespace mongo {
             extSortAllowed = newExtSortAllowed;
             return *this;
         }
+
+        SortOptions& MaxFanIn(size_t newMaxFanIn) {
+            maxFanIn = newMaxFanIn;
+            return *this;
+        }
     };
 
     /// This is the output from the sorting framework
@@ -161,7 +168,12 @@ namespace mongo {
         Sorter() {} // can only be constructed as a base
     };
 
-    /// Writes pre-sorted data to a sorted file and hands-back an Iterator over that file.
+    /**
+     * Writes pre-sorted data to a sorted file and hands-back an Iterator over that file.
+     *
+     * The file is a series of blocks, each an int32 length then that many bytes.  A negative
+     * length marks a block that is snappy compressed, which is done whenever it saves space.
+     */
     template <typename Key, typename Value>
     class SortedFileWriter {
         MONGO_DISALLOW_COPYING(SortedFileWriter);
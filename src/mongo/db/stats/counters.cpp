@@ -21,10 +21,10 @@
 #include "counters.h"
 
 namespace mongo {
+
     OpCounters::OpCounters() {}
 
     void OpCounters::gotOp( int op , bool isCommand ) {
-        RARELY _checkWrap();
         switch ( op ) {
         case dbInsert: /*gotInsert();*/ break; // need to handle multi-insert
         case dbQuery:
@@ -45,67 +45,41 @@ namespace mongo {
         }
     }
 
-    void OpCounters::_checkWrap() {
-        const unsigned MAX = 1 << 30;
-        
-        bool wrap =
-            _insert.get() > MAX ||
-            _query.get() > MAX ||
-            _update.get() > MAX ||
-            _delete.get() > MAX ||
-            _getmore.get() > MAX ||
-            _command.get() > MAX;
-        
-        if ( wrap ) {
-            _insert.zero();
-            _query.zero();
-            _update.zero();
-            _delete.zero();
-            _getmore.zero();
-            _command.zero();
+    unsigned OpCounters::_get( int which ) const {
+        const long long MAX = 1 << 30;
+
+        bool wrap = false;
+        for ( int i = 0; i < kNumCounts; i++ ) {
+            if ( _counts.get( i ) > MAX )
+                wrap = true;
         }
+        if ( wrap )
+            _counts.zero();
+
+        return static_cast<unsigned>( _counts.get( which ) );
     }
 
     BSONObj OpCounters::getObj() const {
         BSONObjBuilder b;
-        b.append( "insert" , _insert.get() );
-        b.append( "query" , _query.get() );
-        b.append( "update" , _update.get() );
-        b.append( "delete" , _delete.get() );
-        b.append( "getmore" , _getmore.get() );
-        b.append( "command" , _command.get() );
+        b.append( "insert" , getInsert() );
+        b.append( "query" , getQuery() );
+        b.append( "update" , getUpdate() );
+        b.append( "delete" , getDelete() );
+        b.append( "getmore" , getGetMore() );
+        b.append( "command" , getCommand() );
         return b.obj();
     }
 
     void NetworkCounter::hit( long long bytesIn , long long bytesOut ) {
-        const long long MAX = 1ULL << 60;
-
-        // don't care about the race as its just a counter
-        bool overflow = _bytesIn > MAX || _bytesOut > MAX;
-
-        if ( overflow ) {
-            _lock.lock();
-            _overflows++;
-            _bytesIn = bytesIn;
-            _bytesOut = bytesOut;
-            _requests = 1;
-            _lock.unlock();
-        }
-        else {
-            _lock.lock();
-            _bytesIn += bytesIn;
-            _bytesOut += bytesOut;
-            _requests++;
-            _lock.unlock();
-        }
+        _counts.add( kBytesIn , bytesIn );
+        _counts.add( kBytesOut , bytesOut );
+        _counts.add( kRequests , 1 );
     }
 
     void NetworkCounter::append( BSONObjBuilder& b ) {
-        _lock.lock();
-        b.appendNumber( "bytesIn" , _bytesIn );
-        b.appendNumber( "bytesOut" , _bytesOut );
-        b.appendNumber( "numRequests" , _requests );
-        _lock.unlock();
+        b.appendNumber( "bytesIn" , _counts.get( kBytesIn ) );
+        b.appendNumber( "bytesOut" , _counts.get( kBytesOut ) );
+        b.appendNumber( "numRequests" , _counts.get( kRequests ) );
     }
 
 
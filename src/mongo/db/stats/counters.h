@@ -21,51 +21,51 @@
 #include "../jsobj.h"
 #include "../../util/net/message.h"
 #include "../../util/processinfo.h"
-#include "../../util/concurrency/spin_lock.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/util/concurrency/striped_counters.h"
 
 namespace mongo {
 
     /**
      * for storing operation counters
-     * note: not thread safe.  ok with that for speed
+     * the counts are striped per thread, see StripedCounters
      */
     class OpCounters {
     public:
 
         OpCounters();
-        void incInsertInWriteLock(int n) { _insert.x += n; }
-        void gotInsert() { _insert++; }
-        void gotQuery() { _query++; }
-        void gotUpdate() { _update++; }
-        void gotDelete() { _delete++; }
-        void gotGetMore() { _getmore++; }
-        void gotCommand() { _command++; }
+        void incInsertInWriteLock(int n) { _counts.add( kInsert , n ); }
+        void gotInsert() { _counts.add( kInsert , 1 ); }
+        void gotQuery() { _counts.add( kQuery , 1 ); }
+        void gotUpdate() { _counts.add( kUpdate , 1 ); }
+        void gotDelete() { _counts.add( kDelete , 1 ); }
+        void gotGetMore() { _counts.add( kGetMore , 1 ); }
+        void gotCommand() { _counts.add( kCommand , 1 ); }
 
         void gotOp( int op , bool isCommand );
 
         BSONObj getObj() const;
         
         // thse are used by snmp, and other things, do not remove
-        const AtomicUInt * getInsert() const { return &_insert; }
-        const AtomicUInt * getQuery() const { return &_query; }
-        const AtomicUInt * getUpdate() const { return &_update; }
-        const AtomicUInt * getDelete() const { return &_delete; }
-        const AtomicUInt * getGetMore() const { return &_getmore; }
-        const AtomicUInt * getCommand() const { return &_command; }
+        unsigned getInsert() const { return _get( kInsert ); }
+        unsigned getQuery() const { return _get( kQuery ); }
+        unsigned getUpdate() const { return _get( kUpdate ); }
+        unsigned getDelete() const { return _get( kDelete ); }
+        unsigned getGetMore() const { return _get( kGetMore ); }
+        unsigned getCommand() const { return _get( kCommand ); }
 
 
     private:
-        void _checkWrap();
-        
-        // todo: there will be a lot of cache line contention on these.  need to do something 
-        //       else eventually.
-        AtomicUInt _insert;
-        AtomicUInt _query;
-        AtomicUInt _update;
-        AtomicUInt _delete;
-        AtomicUInt _getmore;
-        AtomicUInt _command;
+        enum { kInsert, kQuery, kUpdate, kDelete, kGetMore, kCommand, kNumCounts };
+
+        /**
+         * Reads a count, first zeroing them all if any is past 2^30, so that they all wrap
+         * together, and well before they'd turn negative as the ints they're reported as.
+         */
+        unsigned _get( int which ) const;
+
+        // mutable so that reads can wrap the counts
+        mutable StripedCounters<kNumCounts> _counts;
     };
 
     extern OpCounters globalOpCounters;
@@ -73,17 +73,12 @@ namespace mongo {
 
     class NetworkCounter {
     public:
-        NetworkCounter() : _bytesIn(0), _bytesOut(0), _requests(0), _overflows(0) {}
         void hit( long long bytesIn , long long bytesOut );
         void append( BSONObjBuilder& b );
     private:
-        long long _bytesIn;
-        long long _bytesOut;
-        long long _requests;
-
-        long long _overflows;
+        enum { kBytesIn, kBytesOut, kRequests, kNumCounts };
 
-        SpinLock _lock;
+        StripedCounters<kNumCounts> _counts;
     };
 
     extern NetworkCounter networkCounter;
@@ -0,0 +1,135 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include <cmath>
+
+namespace mongo {
+
+    const int LatencyHistogram::kSubBucketBits;
+    const uint64_t LatencyHistogram::kSubBuckets;
+    const int LatencyHistogram::kMaxExponent;
+    const size_t LatencyHistogram::kNumBuckets;
+
+    namespace {
+        // Index of the highest set bit; 'x' must not be 0.
+        int highBit( uint64_t x ) {
+            int bit = 0;
+            while ( x >>= 1 ) {
+                ++bit;
+            }
+            return bit;
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram() { }
+
+    // static
+    size_t LatencyHistogram::bucketFor( uint64_t micros ) {
+        // Below 2 * kSubBuckets every value has a bucket of its own.
+        if ( micros < 2 * kSubBuckets ) {
+            return static_cast<size_t>( micros );
+        }
+
+        const int exponent = highBit( micros );
+        if ( exponent > kMaxExponent ) {
+            return kNumBuckets - 1;
+        }
+
+        // The kSubBucketBits bits below the highest pick the part of [2^exponent, 2^exp+1).
+        const uint64_t sub = ( micros >> ( exponent - kSubBucketBits ) ) & ( kSubBuckets - 1 );
+        return static_cast<size_t>( ( exponent - kSubBucketBits + 1 ) * kSubBuckets + sub );
+    }
+
+    // static
+    uint64_t LatencyHistogram::bucketUpperBound( size_t bucket ) {
+        if ( bucket < 2 * kSubBuckets ) {
+            return bucket;
+        }
+
+        const int exponent = static_cast<int>( bucket / kSubBuckets ) + kSubBucketBits - 1;
+        const uint64_t sub = bucket % kSubBuckets;
+        const int shift = exponent - kSubBucketBits;
+        return ( ( kSubBuckets + sub + 1 ) << shift ) - 1;
+    }
+
+    void LatencyHistogram::record( uint64_t micros ) {
+        _buckets[bucketFor( micros )].fetchAndAdd( 1 );
+        _totalMicros.fetchAndAdd( micros );
+    }
+
+    void LatencyHistogram::add( const LatencyHistogram& other ) {
+        for ( size_t i = 0; i < kNumBuckets; ++i ) {
+            const uint64_t n = other._buckets[i].load();
+            if ( n ) {
+                _buckets[i].fetchAndAdd( n );
+            }
+        }
+        _totalMicros.fetchAndAdd( other._totalMicros.load() );
+    }
+
+    void LatencyHistogram::reset() {
+        for ( size_t i = 0; i < kNumBuckets; ++i ) {
+            _buckets[i].store( 0 );
+        }
+        _totalMicros.store( 0 );
+    }
+
+    uint64_t LatencyHistogram::count() const {
+        uint64_t n = 0;
+        for ( size_t i = 0; i < kNumBuckets; ++i ) {
+            n += _buckets[i].load();
+        }
+        return n;
+    }
+
+    uint64_t LatencyHistogram::percentile( double fraction ) const {
+        uint64_t counts[kNumBuckets];
+        uint64_t total = 0;
+        for ( size_t i = 0; i < kNumBuckets; ++i ) {
+            counts[i] = _buckets[i].load();
+            total += counts[i];
+        }
+        if ( 0 == total ) {
+            return 0;
+        }
+
+        // The rank of the quantile, counting from 1.
+        uint64_t rank = static_cast<uint64_t>( std::ceil( fraction * total ) );
+        if ( rank < 1 ) {
+            rank = 1;
+        }
+
+        uint64_t seen = 0;
+        for ( size_t i = 0; i < kNumBuckets; ++i ) {
+            seen += counts[i];
+            if ( seen >= rank ) {
+                return bucketUpperBound( i );
+            }
+        }
+        return bucketUpperBound( kNumBuckets - 1 );
+    }
+
+    void LatencyHistogram::append( BSONObjBuilder* out ) const {
+        out->appendNumber( "ops", static_cast<long long>( count() ) );
+        out->appendNumber( "totalMicros", static_cast<long long>( _totalMicros.load() ) );
+        out->appendNumber( "p50", static_cast<long long>( percentile( 0.5 ) ) );
+        out->appendNumber( "p99", static_cast<long long>( percentile( 0.99 ) ) );
+        out->appendNumber( "p999", static_cast<long long>( percentile( 0.999 ) ) );
+    }
+
+}  // namespace mongo
@@ -0,0 +1,76 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * Counts latencies, in microseconds, in log-linear buckets: each power of two is split
+     * into kSubBuckets equal parts, so a reported percentile is within 1/kSubBuckets of the
+     * true value.  Recording is a couple of atomic increments, with no lock.
+     *
+     * Reads are not a consistent snapshot; counts may move while percentiles are worked
+     * out, which at worst shifts a percentile by a bucket.
+     */
+    class LatencyHistogram {
+    public:
+        static const int kSubBucketBits = 3;
+        static const uint64_t kSubBuckets = 1 << kSubBucketBits;
+
+        // Latencies of 2^(kMaxExponent + 1) micros (about 38 hours) and up share the last
+        // bucket.
+        static const int kMaxExponent = 36;
+        static const size_t kNumBuckets = ( kMaxExponent - kSubBucketBits + 2 ) * kSubBuckets;
+
+        LatencyHistogram();
+
+        void record( uint64_t micros );
+
+        /**
+         * Adds everything recorded in 'other' into this one.
+         */
+        void add( const LatencyHistogram& other );
+
+        void reset();
+
+        uint64_t count() const;
+
+        /**
+         * The largest latency in the bucket holding the 'fraction' quantile, e.g. 0.99 for
+         * p99.  0 if nothing was recorded.
+         */
+        uint64_t percentile( double fraction ) const;
+
+        /**
+         * Appends { ops, totalMicros, p50, p99, p999 }, the percentiles in micros.
+         */
+        void append( BSONObjBuilder* out ) const;
+
+        // exposed for testing
+        static size_t bucketFor( uint64_t micros );
+        static uint64_t bucketUpperBound( size_t bucket );
+
+    private:
+        AtomicUInt64 _buckets[kNumBuckets];
+        AtomicUInt64 _totalMicros;
+    };
+
+}  // namespace mongo
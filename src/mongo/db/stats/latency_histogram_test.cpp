@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * This file contains tests for mongo/db/stats/latency_histogram.cpp
+ */
+
+#include "mongo/db/stats/latency_histogram.h"
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST(LatencyHistogramTest, SmallValuesAreExact) {
+        for (uint64_t i = 0; i < 2 * LatencyHistogram::kSubBuckets; ++i) {
+            ASSERT_EQUALS(i, LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(i)));
+        }
+    }
+
+    TEST(LatencyHistogramTest, BucketsCoverValues) {
+        // Every value falls in a bucket whose bound is at or above it and within 1/8 of it.
+        for (uint64_t i = 0; i < 100000; i += 7) {
+            const size_t bucket = LatencyHistogram::bucketFor(i);
+            ASSERT_LESS_THAN(bucket, LatencyHistogram::kNumBuckets);
+            const uint64_t bound = LatencyHistogram::bucketUpperBound(bucket);
+            ASSERT_GREATER_THAN_OR_EQUALS(bound, i);
+            ASSERT_LESS_THAN_OR_EQUALS(bound - i, i / LatencyHistogram::kSubBuckets);
+        }
+    }
+
+    TEST(LatencyHistogramTest, BucketsAreOrdered) {
+        for (size_t i = 1; i < LatencyHistogram::kNumBuckets; ++i) {
+            ASSERT_LESS_THAN(LatencyHistogram::bucketUpperBound(i - 1),
+                             LatencyHistogram::bucketUpperBound(i));
+            ASSERT_EQUALS(i, LatencyHistogram::bucketFor(LatencyHistogram::bucketUpperBound(i)));
+        }
+    }
+
+    TEST(LatencyHistogramTest, HugeValuesShareLastBucket) {
+        ASSERT_EQUALS(LatencyHistogram::kNumBuckets - 1,
+                      LatencyHistogram::bucketFor(1ULL << 40));
+        ASSERT_EQUALS(LatencyHistogram::kNumBuckets - 1,
+                      LatencyHistogram::bucketFor(~0ULL));
+    }
+
+    TEST(LatencyHistogramTest, Percentiles) {
+        LatencyHistogram histogram;
+        ASSERT_EQUALS(0U, histogram.percentile(0.5));
+
+        for (uint64_t i = 1; i <= 1000; ++i) {
+            histogram.record(i);
+        }
+        ASSERT_EQUALS(1000U, histogram.count());
+        ASSERT_EQUALS(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(500)),
+                      histogram.percentile(0.5));
+        ASSERT_EQUALS(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(990)),
+                      histogram.percentile(0.99));
+        ASSERT_EQUALS(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(1000)),
+                      histogram.percentile(1.0));
+
+        BSONObjBuilder b;
+        histogram.append(&b);
+        BSONObj obj = b.obj();
+        ASSERT_EQUALS(1000, obj["ops"].numberLong());
+        ASSERT_EQUALS(500500, obj["totalMicros"].numberLong());
+        ASSERT_EQUALS(static_cast<long long>(histogram.percentile(0.999)),
+                      obj["p999"].numberLong());
+    }
+
+    TEST(LatencyHistogramTest, AddAndReset) {
+        LatencyHistogram fast;
+        LatencyHistogram slow;
+        for (uint64_t i = 0; i < 90; ++i) {
+            fast.record(10);
+        }
+        for (uint64_t i = 0; i < 10; ++i) {
+            slow.record(5000);
+        }
+
+        fast.add(slow);
+        ASSERT_EQUALS(100U, fast.count());
+        ASSERT_EQUALS(10U, fast.percentile(0.9));
+        ASSERT_EQUALS(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketFor(5000)),
+                      fast.percentile(0.91));
+        ASSERT_EQUALS(10U, slow.count());
+
+        BSONObjBuilder b;
+        fast.append(&b);
+        ASSERT_EQUALS(90 * 10 + 10 * 5000, b.obj()["totalMicros"].numberLong());
+
+        fast.reset();
+        ASSERT_EQUALS(0U, fast.count());
+        ASSERT_EQUALS(0U, fast.percentile(0.5));
+    }
+
+}  // namespace
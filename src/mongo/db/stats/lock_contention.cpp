@@ -0,0 +1,192 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/lock_contention.h"
+
+#include <cstring>
+#include <vector>
+
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/db/stats/op_latencies.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+
+namespace mongo {
+
+    // Waits at least this long are candidates for the longestWaits list.
+    MONGO_EXPORT_SERVER_PARAMETER(lockWaitTraceMinMicros, int, 100 * 1000);
+
+    namespace {
+
+        const char lockModes[] = { 'R', 'W', 'r', 'w' };
+        const int numLockModes = sizeof( lockModes );
+
+        // The last column is for ops of no tracked type, e.g. internal threads.
+        LatencyHistogram lockWaits[numLockModes][NUM_OP_LATENCY_TYPES + 1];
+
+        int modeIndex( char type ) {
+            for ( int i = 0; i < numLockModes; i++ ) {
+                if ( lockModes[i] == type )
+                    return i;
+            }
+            return -1;
+        }
+
+        /**
+         * The few longest lock waits seen, each with whatever could be found out about the op
+         * that took the lock just before the waiter.
+         */
+        class LongestWaits {
+        public:
+            static const size_t kMaxWaits = 10;
+
+            LongestWaits() : _mutex( "LongestWaits" ) { }
+
+            /** true if a wait of 'micros' would make the list */
+            bool qualifies( long long micros ) const {
+                return micros >= lockWaitTraceMinMicros && micros > _shortest.load();
+            }
+
+            void add( long long micros, const BSONObj& trace ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                if ( micros <= _shortest.load() )
+                    return;
+
+                if ( _waits.size() >= kMaxWaits ) {
+                    _waits.erase( _waits.begin() + shortest_inlock() );
+                }
+                _waits.push_back( std::make_pair( micros, trace.getOwned() ) );
+
+                _shortest.store( _waits.size() < kMaxWaits ? 0 : _waits[shortest_inlock()].first );
+            }
+
+            void append( BSONArrayBuilder* out ) const {
+                SimpleMutex::scoped_lock lk( _mutex );
+                for ( size_t i = 0; i < _waits.size(); i++ ) {
+                    out->append( _waits[i].second );
+                }
+            }
+
+        private:
+            size_t shortest_inlock() const {
+                size_t shortest = 0;
+                for ( size_t i = 1; i < _waits.size(); i++ ) {
+                    if ( _waits[i].first < _waits[shortest].first )
+                        shortest = i;
+                }
+                return shortest;
+            }
+
+            mutable SimpleMutex _mutex;
+            std::vector<std::pair<long long, BSONObj> > _waits;
+
+            // wait time a new entry has to beat, 0 while the list has room
+            AtomicInt64 _shortest;
+        } longestWaits;
+
+        /** CurOp::info() for the op with opid 'opId' if it is still running */
+        BSONObj findOp( unsigned opId ) {
+            scoped_lock bl( Client::clientsMutex );
+            for ( set<Client*>::const_iterator i = Client::clients.begin();
+                  i != Client::clients.end(); ++i ) {
+                for ( CurOp* op = (*i)->curop(); op; op = op->parent() ) {
+                    if ( op->opNum() == opId )
+                        return op->info();
+                }
+            }
+            return BSONObj();
+        }
+
+        void traceWait( char type, long long waitMicros, unsigned previousOwner, CurOp* op ) {
+            BSONObjBuilder b;
+            b.appendDate( "ts", jsTime() );
+            b.append( "waitMicros", waitMicros );
+            b.append( "mode", StringData( &type, 1 ) );
+            b.append( "opid", op->opNum() );
+            b.append( "op", opToString( op->getOp() ) );
+            b.append( "ns", op->getNS() );
+
+            if ( previousOwner ) {
+                // The op may have finished since; then all we have is its opid.
+                BSONObj info = findOp( previousOwner );
+                if ( info.isEmpty() )
+                    b.append( "previousOwner", BSON( "opid" << previousOwner ) );
+                else
+                    b.append( "previousOwner", info );
+            }
+
+            longestWaits.add( waitMicros, b.obj() );
+        }
+
+        class LockContentionServerStatusSection : public ServerStatusSection {
+        public:
+            LockContentionServerStatusSection() : ServerStatusSection( "lockContention" ) { }
+            virtual bool includeByDefault() const { return false; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+
+                BSONObjBuilder waits( b.subobjStart( "waits" ) );
+                for ( int mode = 0; mode < numLockModes; mode++ ) {
+                    BSONObjBuilder modeBuilder( waits.subobjStart( StringData( &lockModes[mode],
+                                                                               1 ) ) );
+                    for ( int type = 0; type <= NUM_OP_LATENCY_TYPES; type++ ) {
+                        const LatencyHistogram& histogram = lockWaits[mode][type];
+                        if ( 0 == histogram.count() )
+                            continue;
+
+                        const char* name = type == NUM_OP_LATENCY_TYPES ? "other" :
+                            opLatencyTypeName( static_cast<OpLatencyType>( type ) );
+                        BSONObjBuilder typeBuilder( modeBuilder.subobjStart( name ) );
+                        histogram.append( &typeBuilder );
+                        typeBuilder.doneFast();
+                    }
+                    modeBuilder.doneFast();
+                }
+                waits.doneFast();
+
+                BSONArrayBuilder longest( b.subarrayStart( "longestWaits" ) );
+                longestWaits.append( &longest );
+                longest.doneFast();
+
+                return b.obj();
+            }
+        } lockContentionServerStatusSection;
+
+    }  // namespace
+
+    void recordLockWait( char type, long long waitMicros, unsigned previousOwner ) {
+        const int mode = modeIndex( type );
+        if ( mode < 0 )
+            return;
+        if ( waitMicros < 0 )
+            waitMicros = 0;
+
+        CurOp* op = cc().curop();
+        const bool isCommand = strstr( op->getNS(), ".$cmd" ) != NULL;
+        lockWaits[mode][opLatencyTypeFor( op->getOp(), isCommand )].record( waitMicros );
+
+        if ( longestWaits.qualifies( waitMicros ) )
+            traceWait( type, waitMicros, previousOwner, op );
+    }
+
+}  // namespace mongo
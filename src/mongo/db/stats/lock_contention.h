@@ -0,0 +1,31 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * Accounts one lock acquisition by the current thread's op, for the "lockContention"
+     * serverStatus section.
+     *
+     * @param type           the lock mode taken: R W for the global lock, r w for a database
+     * @param waitMicros     how long the acquisition waited
+     * @param previousOwner  opid of the op that took the same lock just before, 0 if none
+     */
+    void recordLockWait( char type, long long waitMicros, unsigned previousOwner );
+
+}  // namespace mongo
@@ -0,0 +1,92 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/stats/op_latencies.h"
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    namespace {
+
+        const char* const opTypeNames[NUM_OP_LATENCY_TYPES] =
+            { "query", "getmore", "insert", "update", "delete", "command" };
+
+        struct OpLatencies {
+            LatencyHistogram lockWait;
+            LatencyHistogram execution;
+        };
+
+        OpLatencies opLatencies[NUM_OP_LATENCY_TYPES];
+
+        class LatenciesServerStatusSection : public ServerStatusSection {
+        public:
+            LatenciesServerStatusSection() : ServerStatusSection( "latencies" ) { }
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection( const BSONElement& configElement ) const {
+                BSONObjBuilder b;
+                for ( int i = 0; i < NUM_OP_LATENCY_TYPES; i++ ) {
+                    BSONObjBuilder opBuilder( b.subobjStart( opTypeNames[i] ) );
+                    {
+                        BSONObjBuilder lockWait( opBuilder.subobjStart( "lockWait" ) );
+                        opLatencies[i].lockWait.append( &lockWait );
+                        lockWait.doneFast();
+                    }
+                    {
+                        BSONObjBuilder execution( opBuilder.subobjStart( "execution" ) );
+                        opLatencies[i].execution.append( &execution );
+                        execution.doneFast();
+                    }
+                    opBuilder.doneFast();
+                }
+                return b.obj();
+            }
+        } latenciesServerStatusSection;
+
+    }  // namespace
+
+    OpLatencyType opLatencyTypeFor( int op, bool isCommand ) {
+        switch ( op ) {
+        case dbQuery: return isCommand ? OP_LATENCY_COMMAND : OP_LATENCY_QUERY;
+        case dbGetMore: return OP_LATENCY_GETMORE;
+        case dbInsert: return OP_LATENCY_INSERT;
+        case dbUpdate: return OP_LATENCY_UPDATE;
+        case dbDelete: return OP_LATENCY_REMOVE;
+        default: return NUM_OP_LATENCY_TYPES;
+        }
+    }
+
+    const char* opLatencyTypeName( OpLatencyType type ) {
+        verify( type < NUM_OP_LATENCY_TYPES );
+        return opTypeNames[type];
+    }
+
+    void recordOpLatency( int op, bool isCommand, long long lockWaitMicros,
+                          long long executionMicros ) {
+        const OpLatencyType type = opLatencyTypeFor( op, isCommand );
+        if ( NUM_OP_LATENCY_TYPES == type ) {
+            return;
+        }
+        opLatencies[type].lockWait.record( std::max( lockWaitMicros, 0LL ) );
+        opLatencies[type].execution.record( std::max( executionMicros, 0LL ) );
+    }
+
+}  // namespace mongo
@@ -0,0 +1,49 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * The kinds of operation latencies are kept for; there is a histogram set for each.
+     */
+    enum OpLatencyType {
+        OP_LATENCY_QUERY,
+        OP_LATENCY_GETMORE,
+        OP_LATENCY_INSERT,
+        OP_LATENCY_UPDATE,
+        OP_LATENCY_REMOVE,
+        OP_LATENCY_COMMAND,
+        NUM_OP_LATENCY_TYPES
+    };
+
+    /** NUM_OP_LATENCY_TYPES for opcodes that aren't tracked, e.g. killCursors */
+    OpLatencyType opLatencyTypeFor( int op, bool isCommand );
+
+    /** "query", "getmore", "insert", "update", "delete" or "command" */
+    const char* opLatencyTypeName( OpLatencyType type );
+
+    /**
+     * Records the latency of one client operation, split into the time it waited for locks
+     * and the rest.  Reported through the "latencies" serverStatus section.
+     *
+     * 'op' is the wire protocol opcode; 'isCommand' tells commands apart from queries.
+     */
+    void recordOpLatency( int op, bool isCommand, long long lockWaitMicros,
+                          long long executionMicros );
+
+}  // namespace mongo
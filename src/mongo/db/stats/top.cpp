@@ -48,53 +48,83 @@ namespace mongo {
 
     }
 
-    void Top::record( const StringData& ns , int op , int lockType , long long micros , bool command ) {
-        if ( ns[0] == '?' )
-            return;
+    class Top::Entry : boost::noncopyable {
+    public:
+        explicit Entry( const StringData& name ) : ns( name.toString() ), refs( 1 ) { }
 
-        //cout << "record: " << ns << "\t" << op << "\t" << command << endl;
-        SimpleMutex::scoped_lock lk(_lock);
+        void inc( int usage , long long micros ) {
+            time[usage].fetchAndAdd( micros );
+            count[usage].fetchAndAdd( 1 );
+        }
 
-        if ( ( command || op == dbQuery ) && ns == _lastDropped ) {
-            _lastDropped = "";
-            return;
+        void release() {
+            if ( refs.subtractAndFetch( 1 ) == 0 )
+                delete this;
+        }
+
+        const string ns;
+
+        // one for the map, while in it, and one for each handle
+        AtomicInt32 refs;
+
+        // set as the entry leaves the map; recording to it is then ignored, which keeps the
+        // operation that dropped the collection from bringing it back
+        AtomicUInt32 dropped;
+
+        AtomicInt64 time[kNumUsages];
+        AtomicInt64 count[kNumUsages];
+    };
+
+    namespace {
+        Top::UsageData& usageField( Top::CollectionData& c , int usage ) {
+            Top::UsageData* fields[] = { &c.total , &c.readLock , &c.writeLock , &c.queries ,
+                                         &c.getmore , &c.insert , &c.update , &c.remove ,
+                                         &c.commands };
+            return *fields[usage];
         }
+    }
 
-        CollectionData& coll = _usage[ns];
-        _record( coll , op , lockType , micros , command );
-        _record( _global , op , lockType , micros , command );
+    bool Top::Handle::isFor( const StringData& ns ) const {
+        return _entry && !_entry->dropped.loadRelaxed() && ns == _entry->ns;
     }
 
-    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
-        c.total.inc( micros );
+    void Top::Handle::reset() {
+        if ( _entry ) {
+            _entry->release();
+            _entry = 0;
+        }
+    }
 
-        if ( lockType > 0 )
-            c.writeLock.inc( micros );
-        else if ( lockType < 0 )
-            c.readLock.inc( micros );
+    void Top::resolve( const StringData& ns , Handle* handle ) {
+        if ( handle->isFor( ns ) )
+            return;
+        handle->reset();
+        if ( ns.empty() || ns[0] == '?' )
+            return;
 
+        SimpleMutex::scoped_lock lk(_lock);
+        Entry*& entry = _entries[ns];
+        if ( !entry )
+            entry = new Entry( ns );
+        entry->refs.fetchAndAdd( 1 );
+        handle->_entry = entry;
+    }
+
+    int Top::_opUsage( int op , bool command ) {
         switch ( op ) {
         case 0:
             // use 0 for unknown, non-specific
             break;
         case dbUpdate:
-            c.update.inc( micros );
-            break;
+            return kUpdate;
         case dbInsert:
-            c.insert.inc( micros );
-            break;
+            return kInsert;
         case dbQuery:
-            if ( command )
-                c.commands.inc( micros );
-            else
-                c.queries.inc( micros );
-            break;
+            return command ? kCommands : kQueries;
         case dbGetMore:
-            c.getmore.inc( micros );
-            break;
+            return kGetMore;
         case dbDelete:
-            c.remove.inc( micros );
-            break;
+            return kRemove;
         case dbKillCursors:
             break;
         case opReply:
@@ -104,24 +134,75 @@ namespace mongo {
         default:
             log() << "unknown op in Top::record: " << op << endl;
         }
+        return -1;
+    }
 
+    void Top::record( const Handle& handle , int op , int lockType , long long micros ,
+                      bool command ) {
+        Entry* entry = handle._entry;
+        if ( !entry || entry->dropped.loadRelaxed() )
+            return;
+
+        int usages[3];
+        int n = 0;
+        usages[n++] = kTotal;
+        if ( lockType > 0 )
+            usages[n++] = kWriteLock;
+        else if ( lockType < 0 )
+            usages[n++] = kReadLock;
+        const int opUsage = _opUsage( op , command );
+        if ( opUsage >= 0 )
+            usages[n++] = opUsage;
+
+        for ( int i = 0; i < n; i++ ) {
+            entry->inc( usages[i] , micros );
+            _global.add( 2 * usages[i] , micros );
+            _global.add( 2 * usages[i] + 1 , 1 );
+        }
     }
 
     void Top::collectionDropped( const string& ns ) {
-        //cout << "collectionDropped: " << ns << endl;
-        SimpleMutex::scoped_lock lk(_lock);
-        _usage.erase(ns);
-        _lastDropped = ns;
+        Entry* entry;
+        {
+            SimpleMutex::scoped_lock lk(_lock);
+            EntryMap::const_iterator i = _entries.find( ns );
+            if ( i == _entries.end() )
+                return;
+            entry = i->second;
+            _entries.erase( ns );
+        }
+        entry->dropped.store( 1 );
+        entry->release();
     }
 
     void Top::cloneMap(Top::UsageMap& out) const {
+        out = UsageMap();
         SimpleMutex::scoped_lock lk(_lock);
-        out = _usage;
+        for ( EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i ) {
+            const Entry* entry = i->second;
+            CollectionData& coll = out[i->first];
+            for ( int usage = 0; usage < kNumUsages; usage++ ) {
+                UsageData& data = usageField( coll , usage );
+                data.time = entry->time[usage].load();
+                data.count = entry->count[usage].load();
+            }
+        }
+    }
+
+    Top::CollectionData Top::getGlobalData() const {
+        CollectionData coll;
+        for ( int usage = 0; usage < kNumUsages; usage++ ) {
+            UsageData& data = usageField( coll , usage );
+            data.time = _global.get( 2 * usage );
+            data.count = _global.get( 2 * usage + 1 );
+        }
+        return coll;
     }
 
     void Top::append( BSONObjBuilder& b ) {
-        SimpleMutex::scoped_lock lk( _lock );
-        _appendToUsageMap( b , _usage );
+        UsageMap usage;
+        cloneMap( usage );
+        _appendToUsageMap( b , usage );
     }
 
     void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
@@ -18,14 +18,21 @@
 #pragma once
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
 
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/striped_counters.h"
 #include "mongo/util/string_map.h"
 
 namespace mongo {
 
     /**
      * tracks usage by collection
+     *
+     * Each namespace's counters are atomics in an Entry that a Handle can reference, so
+     * recording takes neither a lock nor a lookup once the recorder has resolved its handle;
+     * CurOp keeps one across operations.  The lock is only for the map from namespaces to
+     * entries, which resolving a new namespace, dropping one and reading all of them use.
      */
     class Top {
 
@@ -66,25 +73,61 @@ namespace mongo {
 
         typedef StringMap<CollectionData> UsageMap;
 
+        class Entry;
+
+        /**
+         * A reference to the counters of one namespace.  Not thread safe, the owner's thread
+         * uses it.
+         */
+        class Handle : boost::noncopyable {
+        public:
+            Handle() : _entry( 0 ) { }
+            ~Handle() { reset(); }
+
+            /** @return whether this refers to the counters of 'ns', and they weren't dropped */
+            bool isFor( const StringData& ns ) const;
+
+            void reset();
+
+        private:
+            friend class Top;
+            Entry* _entry;
+        };
+
     public:
-        void record( const StringData& ns , int op , int lockType , long long micros , bool command );
+        /**
+         * Points 'handle' at the counters of 'ns', unless it is already.  Cheap in that case.
+         */
+        void resolve( const StringData& ns , Handle* handle );
+
+        /** counts an op against the namespace 'handle' is for, if it has one */
+        void record( const Handle& handle , int op , int lockType , long long micros ,
+                     bool command );
         void append( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
-        CollectionData getGlobalData() const { return _global; }
+        CollectionData getGlobalData() const;
         void collectionDropped( const string& ns );
 
     public: // static stuff
         static Top global;
 
     private:
+        typedef StringMap<Entry*> EntryMap;
+
+        enum Usage { kTotal, kReadLock, kWriteLock, kQueries, kGetMore, kInsert, kUpdate,
+                     kRemove, kCommands, kNumUsages };
+
+        /** @return the usage, other than total and lock, that an op counts as, or -1 */
+        static int _opUsage( int op , bool command );
+
         void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
-        void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
 
         mutable SimpleMutex _lock;
-        CollectionData _global;
-        UsageMap _usage;
-        string _lastDropped;
+        EntryMap _entries;
+
+        // time and count of each usage, over all namespaces; striped as everything records here
+        StripedCounters<2 * kNumUsages> _global;
     };
 
 } // namespace mongo
@@ -0,0 +1,106 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/db/stats/working_set.h"
+
+#include <cmath>
+
+namespace mongo {
+
+    const int WorkingSetEstimator::kPrecision;
+    const size_t WorkingSetEstimator::kRegisters;
+    const int WorkingSetEstimator::kPageShift;
+    const int WorkingSetEstimator::kWindowSecs;
+    const int WorkingSetEstimator::kWindows;
+
+    namespace {
+        // MurmurHash3's 64 bit finalizer: page numbers are sequential, the sketch needs their
+        // bits spread evenly.
+        uint64_t mix( uint64_t h ) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+    }
+
+    WorkingSetEstimator::WorkingSetEstimator() { }
+
+    void WorkingSetEstimator::noteAccess( const void* p, long long nowSecs ) {
+        const long long epoch = nowSecs / kWindowSecs;
+        Window& w = _windows[epoch % kWindows];
+        const long long old = w.epoch.load();
+        if ( old != epoch && w.epoch.compareAndSwap( old, epoch ) == old ) {
+            // the window last held the counts of kWindows windows ago
+            memset( w.registers, 0, sizeof( w.registers ) );
+        }
+
+        const uint64_t h = mix( reinterpret_cast<uint64_t>( p ) >> kPageShift );
+        const size_t reg = static_cast<size_t>( h >> ( 64 - kPrecision ) );
+
+        // the position of the first set bit in what is left of the hash
+        unsigned char rank = 1;
+        for ( uint64_t rest = h << kPrecision; rank <= 64 - kPrecision && !( rest >> 63 );
+              rest <<= 1 ) {
+            ++rank;
+        }
+
+        if ( w.registers[reg] < rank ) {
+            w.registers[reg] = rank;
+        }
+    }
+
+    double WorkingSetEstimator::estimate( int windows, long long nowSecs ) const {
+        const long long epoch = nowSecs / kWindowSecs;
+        unsigned char merged[kRegisters] = { 0 };
+        for ( int i = 0; i < kWindows; ++i ) {
+            const long long e = _windows[i].epoch.load();
+            if ( e > epoch || e <= epoch - windows ) {
+                continue;
+            }
+            for ( size_t r = 0; r < kRegisters; ++r ) {
+                merged[r] = std::max( merged[r], _windows[i].registers[r] );
+            }
+        }
+
+        double sum = 0;
+        int zeros = 0;
+        for ( size_t r = 0; r < kRegisters; ++r ) {
+            sum += std::ldexp( 1.0, -merged[r] );
+            if ( 0 == merged[r] ) {
+                ++zeros;
+            }
+        }
+
+        const double m = static_cast<double>( kRegisters );
+        const double raw = ( 0.7213 / ( 1 + 1.079 / m ) ) * m * m / sum;
+        if ( raw <= 2.5 * m && zeros > 0 ) {
+            // few pages: linear counting of the empty registers is more accurate
+            return m * std::log( m / zeros );
+        }
+        return raw;
+    }
+
+    void WorkingSetEstimator::append( BSONObjBuilder* out, long long nowSecs ) const {
+        const double pagesPerMB = ( 1024 * 1024 ) >> kPageShift;
+        out->append( "currentMinuteMB", estimate( 1, nowSecs ) / pagesPerMB );
+        out->append( "last10MinutesMB", estimate( kWindows, nowSecs ) / pagesPerMB );
+    }
+
+}  // namespace mongo
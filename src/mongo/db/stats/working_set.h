@@ -0,0 +1,73 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * Estimates how many distinct 4KB pages were touched recently, with a HyperLogLog sketch
+     * per kWindowSecs window: touching a page again within a window costs no space, and any
+     * run of windows merges into one estimate by taking the larger of each register.
+     * kRegisters one byte registers per window give about 3% standard error.
+     *
+     * Register updates are plain byte stores with no lock; a racing update can be lost, which
+     * at worst leaves an estimate low until the page is touched again.
+     */
+    class WorkingSetEstimator {
+    public:
+        static const int kPrecision = 10;
+        static const size_t kRegisters = 1 << kPrecision;
+        static const int kPageShift = 12;
+        static const int kWindowSecs = 60;
+        static const int kWindows = 10;
+
+        WorkingSetEstimator();
+
+        /**
+         * Notes that the page holding 'p' was touched at 'nowSecs', on any monotonic clock.
+         */
+        void noteAccess( const void* p, long long nowSecs );
+
+        /**
+         * @return the distinct pages touched in the last 'windows' windows, the current and
+         *     so partial one included.
+         */
+        double estimate( int windows, long long nowSecs ) const;
+
+        /**
+         * Appends { currentMinuteMB, last10MinutesMB }.
+         */
+        void append( BSONObjBuilder* out, long long nowSecs ) const;
+
+    private:
+        struct Window {
+            Window() : epoch( -1 ) { memset( registers, 0, sizeof( registers ) ); }
+
+            // now / kWindowSecs when the window was last started
+            AtomicInt64 epoch;
+            unsigned char registers[kRegisters];
+        };
+
+        Window _windows[kWindows];
+    };
+
+}  // namespace mongo
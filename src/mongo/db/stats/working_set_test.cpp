@@ -0,0 +1,82 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * This file contains tests for mongo/db/stats/working_set.cpp
+ */
+
+#include "mongo/db/stats/working_set.h"
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    const char* page( size_t n ) {
+        return reinterpret_cast<const char*>( n << WorkingSetEstimator::kPageShift );
+    }
+
+    TEST(WorkingSetEstimatorTest, EmptyIsZero) {
+        WorkingSetEstimator estimator;
+        ASSERT_EQUALS( 0.0, estimator.estimate( WorkingSetEstimator::kWindows, 0 ) );
+    }
+
+    TEST(WorkingSetEstimatorTest, CountsDistinctPages) {
+        WorkingSetEstimator estimator;
+        for ( size_t i = 0; i < 100000; ++i ) {
+            estimator.noteAccess( page( i ), 0 );
+            // same page, other bytes of it
+            estimator.noteAccess( page( i ) + 100, 0 );
+        }
+        const double estimate = estimator.estimate( 1, 0 );
+        ASSERT_GREATER_THAN( estimate, 90000.0 );
+        ASSERT_LESS_THAN( estimate, 110000.0 );
+    }
+
+    TEST(WorkingSetEstimatorTest, SmallCountsAreClose) {
+        WorkingSetEstimator estimator;
+        for ( size_t i = 0; i < 100; ++i ) {
+            estimator.noteAccess( page( 1000 + i ), 0 );
+        }
+        const double estimate = estimator.estimate( 1, 0 );
+        ASSERT_GREATER_THAN( estimate, 90.0 );
+        ASSERT_LESS_THAN( estimate, 110.0 );
+    }
+
+    TEST(WorkingSetEstimatorTest, WindowsSlide) {
+        WorkingSetEstimator estimator;
+        const long long window = WorkingSetEstimator::kWindowSecs;
+        for ( size_t i = 0; i < 1000; ++i ) {
+            estimator.noteAccess( page( i ), 0 );
+        }
+        for ( size_t i = 1000; i < 2000; ++i ) {
+            estimator.noteAccess( page( i ), window );
+        }
+
+        // the second window alone, and both merged
+        ASSERT_LESS_THAN( estimator.estimate( 1, window ), 1100.0 );
+        ASSERT_GREATER_THAN( estimator.estimate( 2, window ), 1800.0 );
+
+        // the first window's registers are reused for a new window
+        const long long later = window * WorkingSetEstimator::kWindows;
+        estimator.noteAccess( page( 5000 ), later );
+        ASSERT_LESS_THAN( estimator.estimate( 1, later ), 2.0 );
+        ASSERT_LESS_THAN( estimator.estimate( WorkingSetEstimator::kWindows, later ), 1100.0 );
+    }
+
+} // namespace
@@ -28,6 +28,7 @@
 #include "mongo/db/lockstate.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
 #include "mongo/util/file_allocator.h"
 
 namespace mongo {
@@ -68,9 +69,12 @@ namespace mongo {
     }
 
     int DataFile::defaultSize( const char *filename ) const {
+        // index files start small again, as their own series
+        const int n = ExtentManager::isIndexFile( fileNo ) ?
+            fileNo - ExtentManager::kIndexFileBase : fileNo;
         int size;
-        if ( fileNo <= 4 )
-            size = (64*1024*1024) << fileNo;
+        if ( n <= 4 )
+            size = (64*1024*1024) << n;
         else
             size = 0x7ff00000;
         if ( cmdLine.smallfiles ) {
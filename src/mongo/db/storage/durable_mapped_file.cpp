@@ -26,26 +26,68 @@
 
 #include "mongo/db/cmdline.h"
 
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/dur.h"
 #include "mongo/db/dur_journalformat.h"
 #include "mongo/db/memconcept.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
 
 using namespace mongoutils;
 
 namespace mongo {
 
+    // interleave the data file views over the NUMA nodes rather than filling the node of
+    // whichever thread faults them in first
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(mmapNumaInterleave, bool, false);
+
+    // ask for transparent huge pages for the data file views.  with journaling, the private
+    // view's copied pages are anonymous memory, which is where this helps most
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(mmapHugePages, bool, false);
+
+    static int placementOptions() {
+        int options = 0;
+        if ( mmapNumaInterleave )
+            options |= MongoFile::NUMA_INTERLEAVE;
+        if ( mmapHugePages )
+            options |= MongoFile::HUGEPAGES;
+        return options;
+    }
+
     void DurableMappedFile::remapThePrivateView() {
         verify( cmdLine.dur );
 
         // todo 1.9 : it turns out we require that we always remap to the same address.
         // so the remove / add isn't necessary and can be removed?
         void *old = _view_private;
+#if defined(_WIN32) || defined(__sunos__)
         //privateViews.remove(_view_private);        
         _view_private = remapPrivateView(_view_private);
         //privateViews.add(_view_private, this);
         fassert( 16112, _view_private == old );
+        fill( _dirtyChunks.begin(), _dirtyChunks.end(), false );
+#else
+        // only the written parts of the view can differ from the file, so the untouched ones, and
+        // the page tables behind them, are left alone
+        const size_t n = _dirtyChunks.size();
+        for( size_t c = 0; c < n; ) {
+            if( !_dirtyChunks[c] ) {
+                c++;
+                continue;
+            }
+            size_t end = c;
+            while( end < n && _dirtyChunks[end] ) {
+                _dirtyChunks[end] = false;
+                end++;
+            }
+            const unsigned long long ofs = (unsigned long long) c * RemapChunkSize;
+            const unsigned long long endOfs = min( (unsigned long long) end * RemapChunkSize, length() );
+            remapPrivateViewRange( old, ofs, endOfs - ofs );
+            c = end;
+        }
+#endif
     }
 
     /** register view. threadsafe */
@@ -132,14 +174,14 @@ namespace mongo {
     bool DurableMappedFile::open(const std::string& fname, bool sequentialHint) {
         LOG(3) << "mmf open " << fname << endl;
         setPath(fname);
-        _view_write = mapWithOptions(fname.c_str(), sequentialHint ? SEQUENTIAL : 0);
+        _view_write = mapWithOptions(fname.c_str(), (sequentialHint ? SEQUENTIAL : 0) | placementOptions());
         return finishOpening();
     }
 
     bool DurableMappedFile::create(const std::string& fname, unsigned long long& len, bool sequentialHint) {
         LOG(3) << "mmf create " << fname << endl;
         setPath(fname);
-        _view_write = map(fname.c_str(), len, sequentialHint ? SEQUENTIAL : 0);
+        _view_write = map(fname.c_str(), len, (sequentialHint ? SEQUENTIAL : 0) | placementOptions());
         return finishOpening();
     }
 
@@ -152,6 +194,7 @@ namespace mongo {
                     msgasserted(13636, str::stream() << "file " << filename() << " open/create failed in createPrivateMap (look in log for more information)");
                 }
                 privateViews.add(_view_private, this); // note that testIntent builds use this, even though it points to view_write then...
+                _dirtyChunks.assign( (length() + RemapChunkSize - 1) / RemapChunkSize, false );
             }
             else {
                 _view_private = _view_write;
@@ -202,4 +245,58 @@ namespace mongo {
         MemoryMappedFile::close();
     }
 
+
+    /**
+     * How much of each data file is in memory, from mincore() over its write view.  Walking
+     * every page of every file isn't free, so only on request: serverStatus({mappedFiles: 1}).
+     */
+    class MappedFilesSSS : public ServerStatusSection {
+    public:
+        MappedFilesSSS() : ServerStatusSection( "mappedFiles" ){}
+        virtual bool includeByDefault() const { return false; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            if ( !ProcessInfo::blockCheckSupported() )
+                return BSON( "note" << "not supported on this platform" );
+
+            const unsigned long long pageSize = ProcessInfo::getPageSize();
+            BSONObjBuilder b;
+            BSONArrayBuilder files( b.subarrayStart( "files" ) );
+            long long totalResident = 0;
+            vector<char> pages;
+            {
+                LockMongoFilesShared lk;
+                const set<MongoFile*>& all = MongoFile::getAllFiles();
+                for ( set<MongoFile*>::const_iterator i = all.begin(); i != all.end(); ++i ) {
+                    if ( !(*i)->isDurableMappedFile() )
+                        continue;
+                    DurableMappedFile *mmf = (DurableMappedFile*) *i;
+                    if ( !mmf->view_write() )
+                        continue; // not fully opened yet
+
+                    const size_t numPages = ( mmf->length() + pageSize - 1 ) / pageSize;
+                    if ( !ProcessInfo::pagesInMemory( mmf->view_write(), numPages, &pages ) )
+                        continue;
+                    long long resident = 0;
+                    for ( size_t p = 0; p < numPages; p++ )
+                        resident += pages[p];
+                    resident *= pageSize;
+                    totalResident += resident;
+
+                    BSONObjBuilder f( files.subobjStart() );
+                    f.append( "file", mmf->filename() );
+                    f.appendNumber( "mappedMB", static_cast<long long>( mmf->length() / ( 1024 * 1024 ) ) );
+                    f.appendNumber( "residentMB", resident / ( 1024 * 1024 ) );
+                    f.done();
+                }
+            }
+            files.done();
+            b.appendNumber( "residentMB", totalResident / ( 1024 * 1024 ) );
+            b.append( "numaInterleave", mmapNumaInterleave );
+            b.append( "hugePages", mmapHugePages );
+            return b.obj();
+        }
+
+    } mappedFilesSSS;
+
 }
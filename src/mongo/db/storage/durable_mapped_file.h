@@ -83,15 +83,30 @@ namespace mongo {
         */
         bool& willNeedRemap() { return _willNeedRemap; }
 
+        /** note that [ofs, ofs+len) of the private view has been written, so remapThePrivateView()
+            knows which parts of the view need replacing. called with the group commit mutex held
+        */
+        void noteWrite(size_t ofs, unsigned len) {
+            _willNeedRemap = true;
+            const size_t last = (ofs + (len ? len - 1 : 0)) / RemapChunkSize;
+            for( size_t c = ofs / RemapChunkSize; c <= last && c < _dirtyChunks.size(); c++ )
+                _dirtyChunks[c] = true;
+        }
+
+        /** replaces the written parts of the private view with fresh pages from the file */
         void remapThePrivateView();
 
         virtual bool isDurableMappedFile() { return true; }
 
     private:
 
+        /** granularity at which we track and remap the written parts of the private view */
+        static const size_t RemapChunkSize = 16 * 1024 * 1024;
+
         void *_view_write;
         void *_view_private;
         bool _willNeedRemap;
+        vector<bool> _dirtyChunks; // by RemapChunkSize chunk of the private view
         RelativePath _p;   // e.g. "somepath/dbname"
         int _fileSuffixNo;  // e.g. 3.  -1="ns"
 
@@ -34,7 +34,7 @@ namespace mongo {
     extern bool directoryperdb;
 
     ExtentManager::ExtentManager( const StringData& dbname, const StringData& path )
-        : _dbname( dbname.toString() ), _path( path.toString() ) {
+        : _dbname( dbname.toString() ), _path( path.toString() ), _lastFileAddedMillis( 0 ) {
     }
 
     ExtentManager::~ExtentManager() {
@@ -46,14 +46,26 @@ namespace mongo {
             delete _files[i];
         }
         _files.clear();
+        for ( size_t i = 0; i < _indexFiles.size(); i++ ) {
+            delete _indexFiles[i];
+        }
+        _indexFiles.clear();
     }
 
+    const char ExtentManager::kIndexDirName[] = "index";
+
     boost::filesystem::path ExtentManager::fileName( int n ) const {
         stringstream ss;
-        ss << _dbname << '.' << n;
         boost::filesystem::path fullName( _path );
         if ( directoryperdb )
             fullName /= _dbname;
+        if ( isIndexFile( n ) ) {
+            fullName /= kIndexDirName;
+            ss << _dbname << ".idx." << n - kIndexFileBase;
+        }
+        else {
+            ss << _dbname << '.' << n;
+        }
         fullName /= ss.str();
         return fullName;
     }
@@ -61,8 +73,19 @@ namespace mongo {
 
     Status ExtentManager::init() {
         verify( _files.size() == 0 );
+        verify( _indexFiles.size() == 0 );
+
+        Status s = openExistingFiles( 0, &_files );
+        if ( !s.isOK() ) {
+            return s;
+        }
 
-        for ( int n = 0; n < DiskLoc::MaxFiles; n++ ) {
+        // opened whether or not new index extents go to them, as index buckets may be in them
+        return openExistingFiles( kIndexFileBase, &_indexFiles );
+    }
+
+    Status ExtentManager::openExistingFiles( int firstFileNo, vector<DataFile*>* files ) {
+        for ( int n = firstFileNo; n < firstFileNo + DiskLoc::MaxFiles; n++ ) {
             boost::filesystem::path fullName = fileName( n );
             if ( !boost::filesystem::exists( fullName ) )
                 break;
@@ -81,7 +104,7 @@ namespace mongo {
                 break;
             }
 
-            _files.push_back( df.release() );
+            files->push_back( df.release() );
         }
 
         return Status::OK();
@@ -92,28 +115,30 @@ namespace mongo {
         verify(this);
         Lock::assertAtLeastReadLocked( _dbname );
 
-        if ( n < 0 || n >= DiskLoc::MaxFiles ) {
+        if ( n < 0 || n >= kIndexFileBase + DiskLoc::MaxFiles ) {
             out() << "getFile(): n=" << n << endl;
             massert( 10295 , "getFile(): bad file number value (corrupt db?): run repair", false);
         }
+        vector<DataFile*>& files = isIndexFile( n ) ? _indexFiles : _files;
+        const int i = isIndexFile( n ) ? n - kIndexFileBase : n;
         DEV {
-            if ( n > 100 ) {
+            if ( i > 100 ) {
                 out() << "getFile(): n=" << n << endl;
             }
         }
         DataFile* p = 0;
         if ( !preallocateOnly ) {
-            while ( n >= (int) _files.size() ) {
+            while ( i >= (int) files.size() ) {
                 verify(this);
                 if( !Lock::isWriteLocked(_dbname) ) {
                     log() << "error: getFile() called in a read lock, yet file to return is not yet open" << endl;
-                    log() << "       getFile(" << n << ") _files.size:" <<_files.size() << ' ' << fileName(n).string() << endl;
+                    log() << "       getFile(" << n << ") files.size:" << files.size() << ' ' << fileName(n).string() << endl;
                     log() << "       context ns: " << cc().ns() << endl;
                     verify(false);
                 }
-                _files.push_back(0);
+                files.push_back(0);
             }
-            p = _files[n];
+            p = files[i];
         }
         if ( p == 0 ) {
             Lock::assertWriteLocked( _dbname );
@@ -121,8 +146,8 @@ namespace mongo {
             string fullNameString = fullName.string();
             p = new DataFile(n);
             int minSize = 0;
-            if ( n != 0 && _files[ n - 1 ] )
-                minSize = _files[ n - 1 ]->getHeader()->fileLength;
+            if ( i != 0 && i - 1 < (int) files.size() && files[ i - 1 ] )
+                minSize = files[ i - 1 ]->getHeader()->fileLength;
             if ( sizeNeeded + DataFileHeader::HeaderSize > minSize )
                 minSize = sizeNeeded + DataFileHeader::HeaderSize;
             try {
@@ -135,7 +160,7 @@ namespace mongo {
             if ( preallocateOnly )
                 delete p;
             else
-                _files[n] = p;
+                files[i] = p;
         }
         return preallocateOnly ? 0 : p;
     }
@@ -144,20 +169,48 @@ namespace mongo {
         Lock::assertWriteLocked( _dbname );
         int n = (int) _files.size();
         DataFile *ret = getFile( n, sizeNeeded );
-        if ( preallocateNextFile )
+        if ( preallocateNextFile ) {
             preallocateAFile();
+            preallocateForGrowth();
+        }
+        _lastFileAddedMillis = curTimeMillis64();
+        return ret;
+    }
+
+    DataFile* ExtentManager::addAnIndexFile( int sizeNeeded, bool preallocateNextFile ) {
+        Lock::assertWriteLocked( _dbname );
+        int n = kIndexFileBase + (int) _indexFiles.size();
+        DataFile *ret = getFile( n, sizeNeeded );
+        if ( preallocateNextFile )
+            getFile( n + 1, 0, true );
         return ret;
     }
 
+    void ExtentManager::preallocateForGrowth() {
+        Lock::assertWriteLocked( _dbname );
+        if ( _lastFileAddedMillis == 0 ||
+             curTimeMillis64() - _lastFileAddedMillis >= kFastGrowthMillis )
+            return;
+        // with the file before it not open yet, this one gets the default size for its number
+        getFile( numFiles() + 1, 0, true );
+    }
+
     size_t ExtentManager::numFiles() const {
         DEV Lock::assertAtLeastReadLocked( _dbname );
         return _files.size();
     }
 
+    size_t ExtentManager::numIndexFiles() const {
+        DEV Lock::assertAtLeastReadLocked( _dbname );
+        return _indexFiles.size();
+    }
+
     long long ExtentManager::fileSize() const {
         long long size=0;
         for ( int n = 0; boost::filesystem::exists( fileName(n) ); n++)
             size += boost::filesystem::file_size( fileName(n) );
+        for ( int n = kIndexFileBase; boost::filesystem::exists( fileName(n) ); n++)
+            size += boost::filesystem::file_size( fileName(n) );
         return size;
     }
 
@@ -167,6 +220,9 @@ namespace mongo {
             DataFile *f = *i;
             f->flush(sync);
         }
+        for( vector<DataFile*>::iterator i = _indexFiles.begin(); i != _indexFiles.end(); i++ ) {
+            (*i)->flush(sync);
+        }
     }
 
     Record* ExtentManager::recordFor( const DiskLoc& loc ) {
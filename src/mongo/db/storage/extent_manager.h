@@ -34,7 +34,8 @@ namespace mongo {
     /**
      * ExtentManager basics
      *  - one per database
-     *  - responsible for managing <db>.# files
+     *  - responsible for managing <db>.# files, and the index/<db>.idx.# files that index
+     *    extents are given out of when separate index files are on
      *  - NOT responsible for .ns file
      *  - gives out extents
      *  - responsible for figuring out how to get a new extent
@@ -49,6 +50,20 @@ namespace mongo {
         MONGO_DISALLOW_COPYING( ExtentManager );
 
     public:
+        /**
+         * Index files are numbered from here on, in DiskLocs as in getFile(), so the two series
+         * can grow independently.  The files themselves are named from 0 up.
+         */
+        static const int kIndexFileBase = DiskLoc::MaxFiles;
+
+        /**
+         * The subdirectory of the database's directory the index files live in; it can be
+         * mounted on different storage than the data files.
+         */
+        static const char kIndexDirName[];
+
+        static bool isIndexFile( int n ) { return n >= kIndexFileBase; }
+
         ExtentManager( const StringData& dbname, const StringData& path );
         ~ExtentManager();
 
@@ -63,14 +78,26 @@ namespace mongo {
         Status init();
 
         size_t numFiles() const;
+        size_t numIndexFiles() const;
         long long fileSize() const;
 
+        /**
+         * @param n a data file number, or kIndexFileBase plus an index file number
+         */
         DataFile* getFile( int n, int sizeNeeded = 0, bool preallocateOnly = false );
 
         DataFile* addAFile( int sizeNeeded, bool preallocateNextFile );
+        DataFile* addAnIndexFile( int sizeNeeded, bool preallocateNextFile );
 
         void preallocateAFile() { getFile( numFiles() , 0, true ); }// XXX-ERH
 
+        /**
+         * Preallocates the file after the next one as well if the last file filled up within
+         * kFastGrowthMillis, so a fast growing database doesn't find its next file still being
+         * zeroed.
+         */
+        void preallocateForGrowth();
+
         void flushFiles( bool sync );
 
         Record* recordFor( const DiskLoc& loc );
@@ -99,6 +126,8 @@ namespace mongo {
 
         boost::filesystem::path fileName( int n ) const;
 
+        Status openExistingFiles( int firstFileNo, std::vector<DataFile*>* files );
+
 
 // -----
 
@@ -109,7 +138,12 @@ namespace mongo {
         // however during Database object construction we aren't, which is ok as it isn't yet visible
         //   to others and we are in the dbholder lock then.
         std::vector<DataFile*> _files;
+        std::vector<DataFile*> _indexFiles; // _indexFiles[i] is file kIndexFileBase + i
+
+        // when addAFile() last added a file, or 0
+        unsigned long long _lastFileAddedMillis;
 
+        static const unsigned long long kFastGrowthMillis = 60 * 1000;
     };
 
 }
@@ -21,21 +21,52 @@
 #include <boost/filesystem/operations.hpp>
 
 #include "mongo/db/namespace_details.h"
+#include "mongo/util/mongoutils/str.h"
 
 
 namespace mongo {
 
     unsigned lenForNewNsFiles = 16 * 1024 * 1024;
 
+    // extension files double in size up to this
+    static const unsigned long long maxNsExtensionLen = 1024 * 1024 * 1024;
+
+    NamespaceIndex::~NamespaceIndex() {
+        for ( size_t i = 0; i < _tables.size(); i++ )
+            delete _tables[i].ht;
+        for ( size_t i = 0; i < _extensionFiles.size(); i++ )
+            delete _extensionFiles[i];
+    }
+
+    bool NamespaceIndex::Table::contains( const NamespaceDetails* d ) const {
+        const char* begin = static_cast<const char*>( ht->_buf );
+        const char* p = reinterpret_cast<const char*>( d );
+        return p >= begin && p < begin + ht->n * sizeof( NamespaceHashTable::Node );
+    }
+
     NamespaceDetails* NamespaceIndex::details(const StringData& ns) {
         Namespace n(ns);
-        return details(n);
+        return _details( n, ns );
     }
 
     NamespaceDetails* NamespaceIndex::details(const Namespace& ns) {
-        if ( !_ht )
+        if ( !_indexed() )
+            return _details( ns, StringData() );
+        return _details( ns, ns.toString() );
+    }
+
+    NamespaceDetails* NamespaceIndex::_details(const Namespace& ns, const StringData& name) {
+        if ( _tables.empty() )
             return 0;
-        NamespaceDetails *d = _ht->get(ns);
+
+        NamespaceDetails *d;
+        if ( _indexed() ) {
+            StringMap<NamespaceDetails*>::const_iterator i = _index.find( name );
+            d = i == _index.end() ? 0 : i->second;
+        }
+        else {
+            d = _tables[0].ht->get( ns );
+        }
         if ( d && d->isCapped() )
             d->cappedCheckMigrate();
         return d;
@@ -52,22 +83,51 @@ namespace mongo {
     }
 
     void NamespaceIndex::add_ns( const Namespace& ns, const NamespaceDetails* details ) {
-        Lock::assertWriteLocked(ns.toString());
+        const string name = ns.toString();
+        Lock::assertWriteLocked(name);
         init();
-        uassert( 10081 , "too many namespaces/collections", _ht->put(ns, *details));
+
+        if ( !_indexed() ) {
+            if ( _tables[0].ht->put( ns, *details ) )
+                return;
+            _addExtension();
+        }
+
+        StringMap<NamespaceDetails*>::const_iterator i = _index.find( name );
+        if ( i != _index.end() ) {
+            void* d = getDur().writingPtr( i->second, sizeof(NamespaceDetails) );
+            *static_cast<NamespaceDetails*>( d ) = *details;
+            return;
+        }
+
+        for ( size_t t = 0; t < _tables.size(); t++ ) {
+            Table& table = _tables[t];
+            if ( table.full )
+                continue;
+            if ( NamespaceDetails* d = table.ht->putNew( ns, *details ) ) {
+                _index[name] = d;
+                return;
+            }
+            table.full = true;
+        }
+
+        _addExtension();
+        NamespaceDetails* d = _tables.back().ht->putNew( ns, *details );
+        uassert( 10081 , "too many namespaces/collections", d );
+        _index[name] = d;
     }
 
     void NamespaceIndex::kill_ns(const char *ns) {
         Lock::assertWriteLocked(ns);
-        if ( !_ht )
+        if ( _tables.empty() )
             return;
         Namespace n(ns);
-        _ht->kill(n);
+        _kill(n);
 
         for( int i = 0; i<=1; i++ ) {
             try {
                 Namespace extra(n.extraName(i));
-                _ht->kill(extra);
+                _kill(extra);
             }
             catch(DBException&) {
                 MONGO_DLOG(3) << "caught exception in kill_ns" << endl;
@@ -75,6 +135,28 @@ namespace mongo {
         }
     }
 
+    void NamespaceIndex::_kill(const Namespace& ns) {
+        if ( !_indexed() ) {
+            _tables[0].ht->kill( ns );
+            return;
+        }
+
+        const string name = ns.toString();
+        StringMap<NamespaceDetails*>::const_iterator i = _index.find( name );
+        if ( i == _index.end() )
+            return;
+
+        for ( size_t t = 0; t < _tables.size(); t++ ) {
+            Table& table = _tables[t];
+            if ( table.contains( i->second ) ) {
+                table.ht->kill( ns );
+                table.full = false;
+                break;
+            }
+        }
+        _index.erase( name );
+    }
+
     bool NamespaceIndex::exists() const {
         return !boost::filesystem::exists(path());
     }
@@ -87,6 +169,21 @@ namespace mongo {
         return ret;
     }
 
+    boost::filesystem::path NamespaceIndex::extensionPath( int i ) const {
+        boost::filesystem::path ret( _dir );
+        if ( directoryperdb )
+            ret /= _database;
+        ret /= string( mongoutils::str::stream() << _database << ".ns." << i );
+        return ret;
+    }
+
+    unsigned long long NamespaceIndex::fileLength() const {
+        unsigned long long len = 0;
+        for ( size_t i = 0; i < _tables.size(); i++ )
+            len += _tables[i].file->length();
+        return len;
+    }
+
     static void namespaceGetNamespacesCallback( const Namespace& k , NamespaceDetails& v , void * extra ) {
         list<string> * l = (list<string>*)extra;
         if ( ! k.hasDollarSign() )
@@ -97,8 +194,17 @@ namespace mongo {
         verify( onlyCollections ); // TODO: need to implement this
         //                                  need boost::bind or something to make this less ugly
 
-        if ( _ht )
-            _ht->iterAll( namespaceGetNamespacesCallback , (void*)&tofill );
+        if ( !_indexed() ) {
+            if ( !_tables.empty() )
+                _tables[0].ht->iterAll( namespaceGetNamespacesCallback , (void*)&tofill );
+            return;
+        }
+
+        for ( StringMap<NamespaceDetails*>::const_iterator i = _index.begin();
+              i != _index.end(); ++i ) {
+            if ( i->first.find( '$' ) == string::npos )
+                tofill.push_back( i->first );
+        }
     }
 
     void NamespaceIndex::maybeMkdir() const {
@@ -110,8 +216,66 @@ namespace mongo {
             MONGO_ASSERT_ON_EXCEPTION_WITH_MSG( boost::filesystem::create_directory( dir ), "create dir for db " );
     }
 
+    static void indexNamespaceCallback( const Namespace& k , NamespaceDetails& v , void * extra ) {
+        StringMap<NamespaceDetails*>* index = static_cast<StringMap<NamespaceDetails*>*>( extra );
+        (*index)[k.toString()] = &v;
+    }
+
+    bool NamespaceIndex::_openTable( DurableMappedFile* f, const boost::filesystem::path& p,
+                                     unsigned long long len ) {
+        const string pathString = p.string();
+        void *view = 0;
+        if ( len == 0 ) {
+            if( f->open(pathString, true) ) {
+                len = f->length();
+                if ( len % (1024*1024) != 0 ) {
+                    log() << "bad .ns file: " << pathString << endl;
+                    uassert( 10079 ,  "bad .ns file length, cannot open database", len % (1024*1024) == 0 );
+                }
+                view = f->getView();
+            }
+        }
+        else {
+            const unsigned long long wanted = len;
+            if ( f->create(pathString, len, true) ) {
+                getDur().createdFile(pathString, len); // always a new file
+                verify( len == wanted );
+                view = f->getView();
+            }
+        }
+
+        if ( view == 0 )
+            return false;
+
+        verify( len <= 0x7fffffff );
+        NamespaceHashTable* ht = new NamespaceHashTable(view, (int) len, "namespace index");
+        _tables.push_back( Table( f, ht ) );
+        return true;
+    }
+
+    void NamespaceIndex::_indexTables() {
+        for ( size_t i = 0; i < _tables.size(); i++ )
+            _tables[i].ht->iterAll( indexNamespaceCallback , &_index );
+    }
+
+    void NamespaceIndex::_addExtension() {
+        const int i = _extensionFiles.size();
+        const unsigned long long len = std::min( 2 * _tables.back().file->length(),
+                                                 maxNsExtensionLen );
+        const boost::filesystem::path p = extensionPath( i );
+        log() << "namespace index of " << _database << " is full, adding " << p.string()
+              << " (" << len / 1024 / 1024 << "MB)" << endl;
+
+        std::auto_ptr<DurableMappedFile> f( new DurableMappedFile() );
+        uassert( 17014, mongoutils::str::stream() << "couldn't create namespace index file " << p.string(),
+                 _openTable( f.get(), p, len ) );
+        _extensionFiles.push_back( f.release() );
+        if ( _tables.size() == 2 )
+            _indexTables(); // the .ns file just filled up
+    }
+
     NOINLINE_DECL void NamespaceIndex::_init() {
-        verify( !_ht );
+        verify( _tables.empty() );
 
         Lock::assertWriteLocked(_database);
 
@@ -126,44 +290,35 @@ namespace mongo {
         }
         */
 
-        unsigned long long len = 0;
         boost::filesystem::path nsPath = path();
-        string pathString = nsPath.string();
-        void *p = 0;
+        bool ok;
         if ( boost::filesystem::exists(nsPath) ) {
-            if( _f.open(pathString, true) ) {
-                len = _f.length();
-                if ( len % (1024*1024) != 0 ) {
-                    log() << "bad .ns file: " << pathString << endl;
-                    uassert( 10079 ,  "bad .ns file length, cannot open database", len % (1024*1024) == 0 );
-                }
-                p = _f.getView();
-            }
+            ok = _openTable( &_f, nsPath, 0 );
         }
         else {
             // use lenForNewNsFiles, we are making a new database
             massert( 10343, "bad lenForNewNsFiles", lenForNewNsFiles >= 1024*1024 );
             maybeMkdir();
-            unsigned long long l = lenForNewNsFiles;
-            if ( _f.create(pathString, l, true) ) {
-                getDur().createdFile(pathString, l); // always a new file
-                len = l;
-                verify( len == lenForNewNsFiles );
-                p = _f.getView();
-            }
+            ok = _openTable( &_f, nsPath, lenForNewNsFiles );
         }
 
-        if ( p == 0 ) {
+        for ( int i = 0; ok && boost::filesystem::exists( extensionPath( i ) ); i++ ) {
+            nsPath = extensionPath( i );
+            std::auto_ptr<DurableMappedFile> f( new DurableMappedFile() );
+            ok = _openTable( f.get(), nsPath, 0 );
+            if ( ok )
+                _extensionFiles.push_back( f.release() );
+        }
+
+        if ( !ok ) {
             /** TODO: this shouldn't terminate? */
-            log() << "error couldn't open file " << pathString << " terminating" << endl;
+            log() << "error couldn't open file " << nsPath.string() << " terminating" << endl;
             dbexit( EXIT_FS );
         }
 
-
-        verify( len <= 0x7fffffff );
-        _ht = new HashTable<Namespace,NamespaceDetails>(p, (int) len, "namespace index");
+        if ( _indexed() )
+            _indexTables();
     }
 
 
 }
-
@@ -20,10 +20,12 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/storage/namespace.h"
 #include "mongo/util/hashtab.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -31,17 +33,26 @@ namespace mongo {
 
     /* NamespaceIndex is the ".ns" file you see in the data directory.  It is the "system catalog"
        if you will: at least the core parts.  (Additional info in system.* collections.)
+
+       When the .ns file is full it grows by extension files, <db>.ns.0, <db>.ns.1 and so on,
+       each twice the size of the one before (up to 1GB), holding a hash table of their own.
+       Existing entries never move, so NamespaceDetails pointers stay good.  Once there are
+       extensions, lookups go through an in memory index of all the tables, so they don't
+       depend on how full those are; a database with just the .ns file uses it directly, so
+       opening one doesn't have to read all of it.
     */
     class NamespaceIndex {
     public:
         NamespaceIndex(const std::string &dir, const std::string &database) :
-            _ht( 0 ), _dir( dir ), _database( database ) {}
+            _dir( dir ), _database( database ) {}
+
+        ~NamespaceIndex();
 
         /* returns true if new db will be created if we init lazily */
         bool exists() const;
 
         void init() {
-            if( !_ht )
+            if( _tables.empty() )
                 _init();
         }
 
@@ -54,20 +65,56 @@ namespace mongo {
 
         void kill_ns(const char *ns);
 
-        bool allocated() const { return _ht != 0; }
+        bool allocated() const { return !_tables.empty(); }
 
         void getNamespaces( std::list<std::string>& tofill , bool onlyCollections = true ) const;
 
         boost::filesystem::path path() const;
 
-        unsigned long long fileLength() const { return _f.length(); }
+        /** @return the length of the .ns file and all its extensions */
+        unsigned long long fileLength() const;
 
     private:
+        typedef HashTable<Namespace,NamespaceDetails> NamespaceHashTable;
+
+        struct Table {
+            Table( DurableMappedFile* f, NamespaceHashTable* ht ) : file( f ), ht( ht ), full( false ) {}
+
+            bool contains( const NamespaceDetails* d ) const;
+
+            DurableMappedFile* file;
+            NamespaceHashTable* ht;
+            bool full; // a put() failed, and nothing was removed since
+        };
+
         void _init();
         void maybeMkdir() const;
 
+        NamespaceDetails* _details( const Namespace& ns, const StringData& name );
+        void _kill( const Namespace& ns );
+
+        bool _indexed() const { return _tables.size() > 1; }
+
+        /** fills _index from all the tables */
+        void _indexTables();
+
+        /** @return the path of extension file 'i', <db>.ns.<i> */
+        boost::filesystem::path extensionPath( int i ) const;
+
+        /** maps (creating it if 'len' isn't 0) a table file and adds it to _tables */
+        bool _openTable( DurableMappedFile* f, const boost::filesystem::path& p,
+                         unsigned long long len );
+
+        /** creates the next extension file, twice the size of the last table */
+        void _addExtension();
+
         DurableMappedFile _f;
-        HashTable<Namespace,NamespaceDetails> *_ht;
+        std::vector<DurableMappedFile*> _extensionFiles; // owned
+        std::vector<Table> _tables; // the .ns file first, then its extensions in order
+
+        // every namespace in _tables, if _indexed()
+        StringMap<NamespaceDetails*> _index;
+
         std::string _dir;
         std::string _database;
     };
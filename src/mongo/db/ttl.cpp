@@ -32,16 +32,25 @@
 #include "mongo/db/repl/is_master.h"
 #include "mongo/db/server_parameters.h"
 #include "mongo/util/background.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
     Counter64 ttlPasses;
     Counter64 ttlDeletedDocuments;
+    Counter64 ttlDeleteBatches;
 
     ServerStatusMetricField<Counter64> ttlPassesDisplay("ttl.passes", &ttlPasses);
     ServerStatusMetricField<Counter64> ttlDeletedDocumentsDisplay("ttl.deletedDocuments", &ttlDeletedDocuments);
+    ServerStatusMetricField<Counter64> ttlDeleteBatchesDisplay("ttl.deleteBatches", &ttlDeleteBatches);
 
     MONGO_EXPORT_SERVER_PARAMETER( ttlMonitorEnabled, bool, true );
+
+    // Most documents one TTL index may delete before the write lock is released.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlDeleteBatchSize, int, 1000 );
+
+    // Upper bound on TTL deletes per second across all collections; 0 means no limit.
+    MONGO_EXPORT_SERVER_PARAMETER( ttlMaxDeletesPerSecond, int, 0 );
     
     class TTLMonitor : public BackgroundJob {
     public:
@@ -51,8 +60,21 @@ namespace mongo {
         virtual string name() const { return "TTLMonitor"; }
         
         static string secondsExpireField;
+
+        /**
+         * The expired documents of one TTL index, deleted a batch at a time.
+         */
+        struct TTLWork {
+            TTLWork( const string& ns, const BSONObj& query )
+                : ns( ns ), query( query ), deleted( 0 ), done( false ) {}
+
+            string ns;
+            BSONObj query;
+            long long deleted;
+            bool done;
+        };
         
-        void doTTLForDB( const string& dbName ) {
+        void getTTLWorkForDB( const string& dbName, vector<TTLWork>* work ) {
 
             bool isMaster = isMasterNs( dbName.c_str() );
             vector<BSONObj> indexes;
@@ -90,9 +112,8 @@ namespace mongo {
                 
                 LOG(1) << "TTL: " << key << " \t " << query << endl;
                 
-                long long n = 0;
+                string ns = idx["ns"].String();
                 {
-                    string ns = idx["ns"].String();
                     Client::WriteContext ctx( ns );
                     NamespaceDetails* nsd = nsdetails( ns );
                     if ( ! nsd ) {
@@ -102,19 +123,79 @@ namespace mongo {
                     if ( nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes ) ) {
                         nsd->syncUserFlags( ns );
                     }
-                    // only do deletes if on master
-                    if ( ! isMaster ) {
+                }
+
+                // only do deletes if on master
+                if ( isMaster ) {
+                    work->push_back( TTLWork( ns, query ) );
+                }
+            }
+        }
+
+        /**
+         * Deletes up to ttlDeleteBatchSize expired documents for 'w' under one write lock,
+         * and marks it done once there are none left.
+         */
+        void deleteBatch( TTLWork* w ) {
+            const long long batchSize = std::max( ttlDeleteBatchSize, 1 );
+
+            Client::WriteContext ctx( w->ns );
+            // the collection may have been dropped, or we stepped down, since the last batch
+            if ( ! nsdetails( w->ns ) || ! isMasterNs( w->ns.c_str() ) ) {
+                w->done = true;
+                return;
+            }
+
+            long long n = deleteObjects( w->ns.c_str() , w->query , false , true , false , 0 ,
+                                         batchSize );
+            ttlDeletedDocuments.increment( n );
+            ttlDeleteBatches.increment();
+            w->deleted += n;
+            if ( n < batchSize )
+                w->done = true;
+        }
+
+        /**
+         * Deletes the expired documents of all TTL indexes.  Indexes take turns a batch at
+         * a time, so a collection with a large backlog neither holds the write lock for
+         * long nor starves the others, and the pass as a whole keeps to
+         * ttlMaxDeletesPerSecond.
+         */
+        void doTTLPass( vector<TTLWork>& work ) {
+            Timer t;
+            long long total = 0;
+
+            bool more = true;
+            while ( more && ! inShutdown() ) {
+                more = false;
+                for ( unsigned i = 0; i < work.size() && ! inShutdown(); i++ ) {
+                    TTLWork& w = work[i];
+                    if ( w.done )
                         continue;
+
+                    long long before = w.deleted;
+                    try {
+                        deleteBatch( &w );
+                    }
+                    catch ( DBException& e ) {
+                        error() << "error processing ttl for collection: " << w.ns << " " << e << endl;
+                        w.done = true;
                     }
+                    total += w.deleted - before;
+                    more = more || ! w.done;
 
-                    n = deleteObjects( ns.c_str() , query , false , true );
-                    ttlDeletedDocuments.increment( n );
-                }
+                    if ( w.done )
+                        LOG(1) << "\tTTL deleted: " << w.deleted << " from " << w.ns << endl;
 
-                LOG(1) << "\tTTL deleted: " << n << endl;
+                    int rate = ttlMaxDeletesPerSecond;
+                    if ( rate > 0 ) {
+                        long long dueMillis = total * 1000 / rate;
+                        long long elapsedMillis = t.millis();
+                        if ( dueMillis > elapsedMillis )
+                            sleepmillis( dueMillis - elapsedMillis );
+                    }
+                }
             }
-            
-            
         }
 
         virtual void run() {
@@ -150,16 +231,18 @@ namespace mongo {
                 
                 ttlPasses.increment();
 
+                vector<TTLWork> work;
                 for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
                     string db = *i;
                     try {
-                        doTTLForDB( db );
+                        getTTLWorkForDB( db, &work );
                     }
                     catch ( DBException& e ) {
                         error() << "error processing ttl for db: " << db << " " << e << endl;
                     }
                 }
 
+                doTTLPass( work );
             }
         }
 
@@ -0,0 +1,389 @@
+// warm_cache.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/warm_cache.h"
+
+#include <boost/bind.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/durable_mapped_file.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/file.h"
+#include "mongo/util/mmap.h"
+#include "mongo/util/paths.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/timer.h"
+#include "mongo/util/touch_pages.h"
+
+namespace mongo {
+
+    extern string dbpath;
+
+    // How often the hottest regions are saved; 0 turns saving off.
+    MONGO_EXPORT_SERVER_PARAMETER(warmCacheSaveSecs, int, 300);
+
+    // The threads the saved regions are read back with at startup; 0 turns that off.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(warmCachePreloadThreads, int, 4);
+
+    Counter64 warmCacheRegionsSaved;
+    Counter64 warmCacheBytesPreloaded;
+
+    ServerStatusMetricField<Counter64> warmCacheRegionsSavedDisplay("warmCache.regionsSaved",
+                                                                    &warmCacheRegionsSaved);
+    ServerStatusMetricField<Counter64> warmCacheBytesPreloadedDisplay("warmCache.bytesPreloaded",
+                                                                      &warmCacheBytesPreloaded);
+
+    const int HotRegionTracker::kRegionShift;
+    const size_t HotRegionTracker::kSlots;
+
+    namespace {
+        // in the dbpath
+        const char kHotRegionsFile[] = "hotRegions.bson";
+
+        size_t slotOf( size_t key ) {
+            // Fibonacci hashing; the regions of one file are consecutive numbers
+            const unsigned long long h = static_cast<unsigned long long>( key ) *
+                0x9E3779B97F4A7C15ULL;
+            return static_cast<size_t>( h >> 50 ) % HotRegionTracker::kSlots;
+        }
+
+        bool hotterFirst( const HotRegionTracker::Region& a, const HotRegionTracker::Region& b ) {
+            if ( a.hits != b.hits )
+                return a.hits > b.hits;
+            // an index region is on the path of more queries than one of documents
+            return a.index && !b.index;
+        }
+
+        struct View {
+            const char* end;
+            string file;
+        };
+    }
+
+    HotRegionTracker::HotRegionTracker() {
+        reset();
+    }
+
+    void HotRegionTracker::reset() {
+        memset( _slots, 0, sizeof( _slots ) );
+    }
+
+    void HotRegionTracker::noteAccess( const void* p, bool index ) {
+        const size_t key = ( reinterpret_cast<size_t>( p ) >> kRegionShift ) << 1 | index;
+        Slot& s = _slots[slotOf( key )];
+        if ( s.key == key ) {
+            s.hits++;
+        }
+        else if ( s.hits > 1 ) {
+            s.hits--;
+        }
+        else {
+            s.key = key;
+            s.hits = 1;
+        }
+    }
+
+    void HotRegionTracker::takeHottest( vector<Region>* out ) {
+        out->clear();
+
+        vector<Slot> slots( _slots, _slots + kSlots );
+        for ( size_t i = 0; i < kSlots; i++ ) {
+            _slots[i].hits >>= 1;
+        }
+
+        // files can't close while we hold this, so the views stay where they are
+        LockMongoFilesShared lk;
+
+        map<const char*, View> views;
+        const set<MongoFile*>& all = MongoFile::getAllFiles();
+        for ( set<MongoFile*>::const_iterator i = all.begin(); i != all.end(); ++i ) {
+            if ( !(*i)->isDurableMappedFile() )
+                continue;
+            DurableMappedFile* mmf = (DurableMappedFile*) *i;
+            const char* view = static_cast<const char*>( mmf->getView() );
+            if ( !view )
+                continue; // not fully opened yet
+            View& v = views[view];
+            v.end = view + mmf->length();
+            v.file = RelativePath::fromFullPath( mmf->filename() ).toString();
+        }
+
+        const size_t regionSize = size_t( 1 ) << kRegionShift;
+        for ( size_t i = 0; i < kSlots; i++ ) {
+            if ( slots[i].key == 0 || slots[i].hits == 0 )
+                continue;
+
+            const size_t region = slots[i].key >> 1;
+            const char* start = reinterpret_cast<const char*>( region << kRegionShift );
+            const char* end = start + regionSize;
+
+            // a region can span the end of one view and the start of the next
+            map<const char*, View>::const_iterator v = views.upper_bound( start );
+            if ( v != views.begin() )
+                --v;
+            for ( ; v != views.end() && v->first < end; ++v ) {
+                if ( v->second.end <= start )
+                    continue;
+                const char* from = std::max( start, v->first );
+                const char* to = std::min( end, v->second.end );
+
+                Region r;
+                r.file = v->second.file;
+                r.ofs = from - v->first;
+                r.len = static_cast<unsigned>( to - from );
+                r.hits = slots[i].hits;
+                r.index = slots[i].key & 1;
+                out->push_back( r );
+            }
+        }
+
+        std::sort( out->begin(), out->end(), hotterFirst );
+    }
+
+    BSONObj HotRegionTracker::toBSON( const vector<Region>& regions ) {
+        BSONObjBuilder b;
+        b.append( "version", 1 );
+        BSONArrayBuilder arr( b.subarrayStart( "regions" ) );
+        for ( vector<Region>::const_iterator i = regions.begin(); i != regions.end(); ++i ) {
+            arr.append( BSON( "file" << i->file <<
+                              "ofs" << static_cast<long long>( i->ofs ) <<
+                              "len" << i->len <<
+                              "hits" << i->hits <<
+                              "index" << i->index ) );
+        }
+        arr.done();
+        return b.obj();
+    }
+
+    bool HotRegionTracker::fromBSON( const BSONObj& obj, vector<Region>* out ) {
+        out->clear();
+        if ( obj["version"].numberInt() != 1 || obj["regions"].type() != Array ) {
+            return false;
+        }
+
+        BSONObjIterator i( obj["regions"].embeddedObject() );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            if ( e.type() != Object ) {
+                out->clear();
+                return false;
+            }
+            BSONObj o = e.embeddedObject();
+            if ( o["file"].type() != String || !o["ofs"].isNumber() || !o["len"].isNumber() ||
+                 o["len"].numberLong() <= 0 || o["len"].numberLong() > ( 1 << kRegionShift ) ) {
+                out->clear();
+                return false;
+            }
+
+            Region r;
+            r.file = o["file"].String();
+            r.ofs = o["ofs"].numberLong();
+            r.len = o["len"].numberInt();
+            r.hits = o["hits"].numberInt();
+            r.index = o["index"].trueValue();
+            out->push_back( r );
+        }
+        return true;
+    }
+
+    HotRegionTracker& hotRegions() {
+        static HotRegionTracker* tracker = new HotRegionTracker();
+        return *tracker;
+    }
+
+    namespace {
+
+        boost::filesystem::path hotRegionsPath() {
+            return boost::filesystem::path( dbpath ) / kHotRegionsFile;
+        }
+
+        void saveHotRegions() {
+            vector<HotRegionTracker::Region> regions;
+            hotRegions().takeHottest( &regions );
+            if ( regions.empty() ) {
+                // keep what an idle spell would otherwise wipe out
+                return;
+            }
+
+            const BSONObj obj = HotRegionTracker::toBSON( regions );
+            const boost::filesystem::path path = hotRegionsPath();
+            const string tmp = path.string() + ".tmp";
+            {
+                File f;
+                f.open( tmp.c_str() );
+                if ( !f.is_open() )
+                    return; // open logged why
+                f.write( 0, obj.objdata(), obj.objsize() );
+                f.truncate( obj.objsize() );
+                f.fsync();
+                if ( f.bad() )
+                    return;
+            }
+
+            // so a crash mid save leaves the last list
+            try {
+                boost::filesystem::rename( tmp, path );
+            }
+            catch ( boost::filesystem::filesystem_error& e ) {
+                warning() << "couldn't save the hot regions to " << path.string() << ": "
+                          << e.what() << endl;
+                return;
+            }
+
+            warmCacheRegionsSaved.increment( regions.size() );
+            LOG(1) << "saved " << regions.size() << " hot regions to " << path.string() << endl;
+        }
+
+        bool loadHotRegions( vector<HotRegionTracker::Region>* out ) {
+            const boost::filesystem::path path = hotRegionsPath();
+            if ( !boost::filesystem::exists( path ) )
+                return false;
+
+            File f;
+            f.open( path.string().c_str(), true );
+            if ( !f.is_open() )
+                return false;
+            const fileofs len = f.len();
+            if ( f.bad() || len < 5 || len > static_cast<fileofs>( BSONObjMaxInternalSize ) ) {
+                warning() << "ignoring " << path.string() << ", it is " << len << " bytes" << endl;
+                return false;
+            }
+
+            boost::scoped_array<char> buf( new char[len] );
+            f.read( 0, buf.get(), static_cast<unsigned>( len ) );
+            if ( f.bad() )
+                return false;
+
+            BSONObj obj( buf.get() );
+            if ( static_cast<fileofs>( obj.objsize() ) != len || !obj.valid() ||
+                 !HotRegionTracker::fromBSON( obj, out ) ) {
+                warning() << "ignoring " << path.string() << ", it isn't a list of regions"
+                          << endl;
+                return false;
+            }
+            return true;
+        }
+
+        void preloadThread( const vector<HotRegionTracker::Region>* regions,
+                            AtomicUInt32* next, unsigned long long maxBytes ) {
+            setThreadName( "warmCachePreload" );
+
+            // the regions of a file tend to come together, so keep the last one open
+            string openName;
+            boost::scoped_ptr<File> f;
+            try {
+                for ( unsigned i = next->fetchAndAdd( 1 ); i < regions->size() && !inShutdown();
+                      i = next->fetchAndAdd( 1 ) ) {
+                    const unsigned long long done = warmCacheBytesPreloaded.get();
+                    if ( maxBytes && done >= maxBytes )
+                        break;
+
+                    const HotRegionTracker::Region& r = (*regions)[i];
+                    if ( r.file != openName ) {
+                        openName = r.file;
+                        f.reset();
+                        const boost::filesystem::path path =
+                            boost::filesystem::path( dbpath ) / r.file;
+                        if ( !boost::filesystem::exists( path ) )
+                            continue; // dropped since
+                        f.reset( new File() );
+                        f->open( path.string().c_str(), true );
+                    }
+                    if ( !f || !f->is_open() || f->bad() )
+                        continue;
+
+                    warmCacheBytesPreloaded.increment( touch_file_pages( *f, r.ofs, r.len ) );
+                }
+            }
+            catch ( std::exception& e ) {
+                warning() << "stopped preloading hot regions: " << e.what() << endl;
+            }
+        }
+
+        void preloadHotRegions() {
+            const int nThreads = warmCachePreloadThreads;
+            if ( nThreads <= 0 )
+                return;
+
+            vector<HotRegionTracker::Region> regions;
+            if ( !loadHotRegions( &regions ) || regions.empty() )
+                return;
+
+            // more than fits would only push out what we read first
+            ProcessInfo p;
+            const unsigned long long maxBytes = p.getMemSizeMB() * 1024 * 1024;
+
+            log() << "preloading " << regions.size() << " hot regions on " << nThreads
+                  << " threads" << endl;
+            Timer t;
+            AtomicUInt32 next;
+            boost::thread_group threads;
+            for ( int i = 0; i < nThreads; i++ ) {
+                threads.create_thread( boost::bind( preloadThread, &regions, &next, maxBytes ) );
+            }
+            threads.join_all();
+
+            log() << "preloaded " << warmCacheBytesPreloaded.get() / ( 1024 * 1024 )
+                  << "MB of hot regions in " << t.millis() << "ms" << endl;
+        }
+
+        class WarmCacheJob : public BackgroundJob {
+        public:
+            WarmCacheJob() : BackgroundJob( true /* delete self */ ) { }
+
+            virtual string name() const { return "warmCache"; }
+
+            virtual void run() {
+                preloadHotRegions();
+
+                Timer sinceSave;
+                while ( !inShutdown() ) {
+                    sleepsecs( 10 );
+
+                    const int saveSecs = warmCacheSaveSecs;
+                    if ( saveSecs <= 0 || sinceSave.seconds() < saveSecs )
+                        continue;
+
+                    try {
+                        saveHotRegions();
+                    }
+                    catch ( std::exception& e ) {
+                        warning() << "couldn't save the hot regions: " << e.what() << endl;
+                    }
+                    sinceSave.reset();
+                }
+            }
+        };
+    }
+
+    void startWarmCacheBackgroundJob() {
+        WarmCacheJob* job = new WarmCacheJob();
+        job->go();
+    }
+}
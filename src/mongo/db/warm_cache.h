@@ -0,0 +1,91 @@
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    class BSONObj;
+
+    /**
+     * Counts how often each 1MB region of the mapped data and index files is touched, so the
+     * hottest ones can be written out and read back into the page cache after a restart.
+     *
+     * Every region hashes to one slot.  A region that finds its slot taken by another wears
+     * that one's count down by one instead, and takes the slot once it reaches zero, so the
+     * slots end up held by the regions touched most.  Slots are updated without a lock; a lost
+     * update only makes a count a little off.
+     */
+    class HotRegionTracker {
+        MONGO_DISALLOW_COPYING(HotRegionTracker);
+    public:
+        static const int kRegionShift = 20;
+        static const size_t kSlots = 1 << 14;
+
+        struct Region {
+            std::string file; // relative to the dbpath
+            unsigned long long ofs;
+            unsigned len;
+            unsigned hits;
+            bool index;
+        };
+
+        HotRegionTracker();
+
+        /**
+         * Notes a touch of the page holding 'p', a pointer into the view of a data file, or of
+         * an index file if 'index'.
+         */
+        void noteAccess( const void* p, bool index );
+
+        /**
+         * Fills 'out' with the tracked regions that are in files still open, hottest first,
+         * and halves every count, so regions that have gone cold fade out.
+         */
+        void takeHottest( std::vector<Region>* out );
+
+        void reset();
+
+        static BSONObj toBSON( const std::vector<Region>& regions );
+
+        /**
+         * @return false, leaving 'out' empty, if 'obj' isn't what toBSON() makes.
+         */
+        static bool fromBSON( const BSONObj& obj, std::vector<Region>* out );
+
+    private:
+        struct Slot {
+            size_t key; // region number << 1 | index; 0 if empty
+            unsigned hits;
+        };
+
+        Slot _slots[kSlots];
+    };
+
+    HotRegionTracker& hotRegions();
+
+    /**
+     * Starts the job that reads the regions saved before the last shutdown back into the page
+     * cache, on warmCachePreloadThreads threads and hottest first while the server takes
+     * requests, then saves the hottest regions every warmCacheSaveSecs.
+     */
+    void startWarmCacheBackgroundJob();
+}
@@ -31,6 +31,9 @@ namespace mongo {
     static Counter64 gleWtimeouts;
     static ServerStatusMetricField<Counter64> gleWtimeoutsDisplay( "getLastError.wtimeouts", &gleWtimeouts );
 
+    // longest a w: wait sleeps between checks when no slave reports progress
+    static const int maxReplicationWaitMillis = 100;
+
     bool waitForWriteConcern(const BSONObj& cmdObj,
                              bool err,
                              BSONObjBuilder* result,
@@ -133,6 +136,8 @@ namespace mongo {
             }
 
             while ( 1 ) {
+                // taken before the check below, so progress made after it wakes us
+                const unsigned long long progress = getReplicationProgress();
 
                 if ( !_isMaster() ) {
                     // this should be in the while loop in case we step down
@@ -166,7 +171,14 @@ namespace mongo {
 
                 verify( sprintf( buf , "w block pass: %lld" , ++passes ) < 30 );
                 c.curop()->setMessage( buf );
-                sleepmillis(1);
+
+                // slaves reporting their positions wake us; wake up regardless now and then to
+                // notice a step down or a killOp
+                int waitMillis = maxReplicationWaitMillis;
+                if ( timeout > 0 ) {
+                    waitMillis = std::min( waitMillis, timeout - gleTimerHolder->millis() );
+                }
+                waitForReplicationProgress( progress, std::max( waitMillis, 1 ) );
                 killCurrentOp.checkForInterrupt();
             }
 
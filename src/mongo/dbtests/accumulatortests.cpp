@@ -827,6 +827,20 @@ namespace AccumulatorTests {
                            + (double)numeric_limits<long long>::max());
             }
         };
+
+        /** Integers summed after a double stay doubles. */
+        class DoubleIntLong : public TypeConversionBase {
+        public:
+            void run() {
+                createAccumulator();
+                accumulator()->process(Value(0.5), false);
+                accumulator()->process(Value(2), false);
+                accumulator()->process(Value(3LL), false);
+                checkSum();
+            }
+        private:
+            Value expectedSum() { return Value(5.5); }
+        };
         
     } // namespace Sum
 
@@ -906,6 +920,7 @@ namespace AccumulatorTests {
             add<Sum::IntNull>();
             add<Sum::IntUndefined>();
             add<Sum::NoOverflowBeforeDouble>();
+            add<Sum::DoubleIntLong>();
         }
     } myall;
 
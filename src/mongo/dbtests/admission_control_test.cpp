@@ -0,0 +1,91 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * This file contains tests for AdmissionQueue and TicketHolder::setLimit
+ */
+
+#include "mongo/db/admission_control.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+using mongo::AdmissionQueue;
+using mongo::BSONObj;
+using mongo::BSONObjBuilder;
+using mongo::TicketHolder;
+
+namespace {
+
+    TEST(AdmissionQueue, ShrinksWhenOverTarget) {
+        ASSERT_EQUALS(75, AdmissionQueue::adjustedLimit(100, 5000, 2000, true, 4, 128));
+        ASSERT_EQUALS(75, AdmissionQueue::adjustedLimit(100, 5000, 2000, false, 4, 128));
+        ASSERT_EQUALS(2, AdmissionQueue::adjustedLimit(3, 5000, 2000, true, 1, 128));
+        ASSERT_EQUALS(4, AdmissionQueue::adjustedLimit(5, 5000, 2000, true, 4, 128));
+    }
+
+    TEST(AdmissionQueue, GrowsOnlyWhenQueued) {
+        ASSERT_EQUALS(101, AdmissionQueue::adjustedLimit(100, 1000, 2000, true, 4, 128));
+        ASSERT_EQUALS(100, AdmissionQueue::adjustedLimit(100, 1000, 2000, false, 4, 128));
+        ASSERT_EQUALS(128, AdmissionQueue::adjustedLimit(128, 0, 2000, true, 4, 128));
+    }
+
+    TEST(AdmissionQueue, StaysInBounds) {
+        ASSERT_EQUALS(64, AdmissionQueue::adjustedLimit(100, 0, 2000, false, 4, 64));
+        ASSERT_EQUALS(8, AdmissionQueue::adjustedLimit(2, 0, 2000, false, 8, 64));
+    }
+
+    TEST(AdmissionQueue, AdjustsEverySample) {
+        AdmissionQueue queue(10);
+        for (int i = 0; i < AdmissionQueue::kSampleSize - 1; i++) {
+            queue.admit();
+            queue.release(10000, 2000, 1, 100);
+        }
+        ASSERT_EQUALS(10, queue.limit());
+
+        queue.admit();
+        queue.release(10000, 2000, 1, 100);
+        ASSERT_EQUALS(8, queue.limit());
+
+        BSONObjBuilder b;
+        queue.append(&b);
+        BSONObj stats = b.obj();
+        ASSERT_EQUALS(0, stats["inUse"].numberInt());
+        ASSERT_EQUALS(AdmissionQueue::kSampleSize, stats["admitted"].numberLong());
+        ASSERT_EQUALS(0, stats["queued"].numberLong());
+    }
+
+    TEST(TicketHolder, SetLimitBelowUsed) {
+        TicketHolder tickets(4);
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(tickets.tryAcquire());
+        }
+
+        tickets.setLimit(2);
+        ASSERT_EQUALS(4, tickets.used());
+        tickets.release();
+        tickets.release();
+        ASSERT_FALSE(tickets.tryAcquire());
+        tickets.release();
+        ASSERT_TRUE(tickets.tryAcquire());
+        ASSERT_FALSE(tickets.tryAcquire());
+
+        tickets.setLimit(3);
+        ASSERT_TRUE(tickets.tryAcquire());
+        ASSERT_EQUALS(3, tickets.used());
+    }
+
+}  // namespace
@@ -19,6 +19,8 @@
 
 #include "pch.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "dbtests.h"
 #include "../util/base64.h"
 #include "../util/array.h"
@@ -29,6 +31,8 @@
 #include "../util/compress.h"
 #include "../util/time_support.h"
 #include "../db/db.h"
+#include "../db/stats/counters.h"
+#include "../db/stats/top.h"
 
 namespace BasicTests {
 
@@ -601,6 +605,82 @@ namespace BasicTests {
         }
     } ctest1;
 
+    class StripedCountersTest {
+    public:
+        void run() {
+            StripedCounters<2> counts;
+            boost::thread_group threads;
+            for ( int i = 0; i < 8; i++ ) {
+                threads.create_thread( boost::bind( &StripedCountersTest::count, &counts ) );
+            }
+            threads.join_all();
+            count( &counts );
+
+            ASSERT_EQUALS( 9 * 1000LL, counts.get( 0 ) );
+            ASSERT_EQUALS( 9 * 2000LL, counts.get( 1 ) );
+            counts.zero();
+            ASSERT_EQUALS( 0LL, counts.get( 0 ) );
+        }
+
+    private:
+        static void count( StripedCounters<2>* counts ) {
+            for ( int i = 0; i < 1000; i++ ) {
+                counts->add( 0, 1 );
+                counts->add( 1, 2 );
+            }
+        }
+    };
+
+    class OpCountersWrap {
+    public:
+        void run() {
+            OpCounters counters;
+            counters.gotQuery();
+            counters.gotOp( dbQuery, true );
+            ASSERT_EQUALS( 1U, counters.getQuery() );
+            ASSERT_EQUALS( 1U, counters.getCommand() );
+
+            counters.incInsertInWriteLock( ( 1 << 30 ) + 1 );
+            ASSERT_EQUALS( 0U, counters.getQuery() );
+            ASSERT_EQUALS( 0U, counters.getInsert() );
+        }
+    };
+
+    class TopHandles {
+    public:
+        void run() {
+            Top top;
+            Top::Handle handle;
+            top.resolve( "unittests.top", &handle );
+            ASSERT( handle.isFor( "unittests.top" ) );
+            top.record( handle, dbQuery, -1, 10, false );
+            top.record( handle, dbUpdate, 1, 5, false );
+
+            Top::UsageMap usage;
+            top.cloneMap( usage );
+            ASSERT_EQUALS( 1U, usage.size() );
+            const Top::CollectionData& coll = usage["unittests.top"];
+            ASSERT_EQUALS( 2, coll.total.count );
+            ASSERT_EQUALS( 15, coll.total.time );
+            ASSERT_EQUALS( 1, coll.queries.count );
+            ASSERT_EQUALS( 5, coll.writeLock.time );
+            ASSERT_EQUALS( 2, top.getGlobalData().total.count );
+
+            // what the dropping op records doesn't bring the collection back
+            top.collectionDropped( "unittests.top" );
+            ASSERT( !handle.isFor( "unittests.top" ) );
+            top.record( handle, dbQuery, -1, 10, true );
+            top.cloneMap( usage );
+            ASSERT_EQUALS( 0U, usage.size() );
+
+            top.resolve( "unittests.top", &handle );
+            top.record( handle, dbInsert, 1, 3, false );
+            top.cloneMap( usage );
+            ASSERT_EQUALS( 1, usage["unittests.top"].insert.count );
+            ASSERT_EQUALS( 1, usage["unittests.top"].total.count );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "basic" ) {
@@ -640,6 +720,10 @@ namespace BasicTests {
 
             add< CompressionTest1 >();
 
+            add< StripedCountersTest >();
+            add< OpCountersWrap >();
+            add< TopHandles >();
+
         }
     } myall;
 
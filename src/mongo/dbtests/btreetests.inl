@@ -285,6 +285,27 @@
         }
     };
 
+    /** Keys that keep landing just before the last one split unevenly, like those at the end. */
+    class SplitNearlyIncreasing : public Base {
+    public:
+        void run() {
+            BSONObj last = key( 0x7fffffffffffLL );
+            Base::insert( last );
+            int n = 1;
+            for( long long i = 1; bt()->getNextChild().isNull(); ++i, ++n ) {
+                BSONObj k = key( i );
+                Base::insert( k );
+            }
+            checkValid( n );
+            ASSERT_EQUALS( 1, bt()->nKeys() );
+            ASSERT( child( bt(), 0 )->nKeys() > 4 * child( bt(), 1 )->nKeys() );
+        }
+    private:
+        static BSONObj key( long long i ) {
+            return BSON( "" << bigNumString( i, 40 ) );
+        }
+    };
+
     class DontReuseUnused : public Base {
     public:
         void run() {
@@ -1640,6 +1661,7 @@
             add< MissingLocate >();
             add< MissingLocateMultiBucket >();
             add< SERVER983 >();
+            add< SplitNearlyIncreasing >();
             add< DontReuseUnused >();
             add< PackUnused >();
             add< DontDropReferenceKey >();
@@ -236,6 +236,28 @@ namespace ChunkTests {
             }
         };
 
+        class UnrelatedFieldsMultiShard : public EmptyQueryMultiShard {
+            virtual BSONObj query() const {
+                return fromjson( "{ab:'x', b:{$gt:1}, 'c.a':'y'}" );
+            }
+        };
+
+        class SubfieldOfKeyMultiShard : public MultiShardBase {
+            virtual BSONObj query() const { return BSON( "a.b" << 1 ); }
+            virtual BSONArray expectedShardNames() const {
+                return BSON_ARRAY( "0" << "1" << "2" << "3" );
+            }
+        };
+
+        class DottedKeyEqualitySingleShard : public Base {
+            virtual BSONObj shardKey() const { return BSON( "a.b" << 1 ); }
+            virtual BSONArray splitPoints() const {
+                return BSON_ARRAY( BSON( "a.b" << "x" ) << BSON( "a.b" << "y" ) );
+            }
+            virtual BSONObj query() const { return fromjson( "{'a.b':'x', c:1}" ); }
+            virtual BSONArray expectedShardNames() const { return BSON_ARRAY( "1" ); }
+        };
+
     } // namespace ChunkManagerTests
     
     class All : public Suite {
@@ -264,6 +286,9 @@ namespace ChunkTests {
             add<ChunkManagerTests::InequalityThenUnsatisfiable>();
             add<ChunkManagerTests::OrEqualityUnsatisfiableInequality>();
             add<ChunkManagerTests::InMultiShard>();
+            add<ChunkManagerTests::UnrelatedFieldsMultiShard>();
+            add<ChunkManagerTests::SubfieldOfKeyMultiShard>();
+            add<ChunkManagerTests::DottedKeyEqualitySingleShard>();
         }
     } myall;
     
@@ -0,0 +1,110 @@
+// client_registry_tests.cpp : client_registry.{h,cpp} unit tests.
+
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/client_registry.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/json.h"
+
+#include "mongo/dbtests/dbtests.h"
+
+namespace ClientRegistryTests {
+
+    static const char* ns() { return "unittests.clientregistry"; }
+
+    /** What the registry shows of the current op formats the same as CurOp::info(). */
+    class PublishesCurrentOp {
+    public:
+        void run() {
+            CurOp* curop = cc().curop();
+            curop->reset();
+            curop->setQuery( fromjson( "{a:1}" ) );
+            Client::ReadContext ctx( ns() );
+            curop->setMessage( "publishing" );
+
+            OpStatus status;
+            unsigned generation;
+            ClientSlot* slot = cc().registrySlot();
+            ASSERT( slot->read( &status, &generation ) );
+            ASSERT( slot->sameHolder( generation ) );
+            ASSERT_EQUALS( curop->opNum().get(), status.opNum );
+            ASSERT( status.active );
+            ASSERT_EQUALS( string( ns() ), status.ns );
+
+            BSONObj info = CurOp::info( status, &slot->lockState(), false );
+            BSONObj expected = curop->info();
+            ASSERT_EQUALS( expected["opid"].numberLong(), info["opid"].numberLong() );
+            ASSERT_EQUALS( expected["ns"].String(), info["ns"].String() );
+            ASSERT_EQUALS( expected["query"].Obj(), info["query"].Obj() );
+            ASSERT_EQUALS( expected["desc"].String(), info["desc"].String() );
+            ASSERT_EQUALS( string( "publishing" ), info["msg"].String() );
+        }
+    };
+
+    /** A kill shows for the op it was for and not the one after. */
+    class KillPending {
+    public:
+        void run() {
+            CurOp* curop = cc().curop();
+            curop->reset();
+            ClientSlot* slot = cc().registrySlot();
+            const unsigned killed = curop->opNum().get();
+            ASSERT( !slot->killPending( killed ) );
+
+            curop->kill();
+            ASSERT( slot->killPending( killed ) );
+
+            curop->reset();
+            ASSERT( !slot->killPending( curop->opNum().get() ) );
+        }
+    };
+
+    /** A finished op is published as inactive, which plain currentOp leaves out. */
+    class Done {
+    public:
+        void run() {
+            CurOp* curop = cc().curop();
+            curop->reset();
+            curop->ensureStarted();
+            curop->yielded();
+            curop->done();
+
+            OpStatus status;
+            unsigned generation;
+            ASSERT( cc().registrySlot()->read( &status, &generation ) );
+            ASSERT( !status.active );
+            ASSERT_EQUALS( 1, status.numYields );
+            ASSERT( status.startMicros > 0 );
+            curop->reset();
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "clientregistry" ) {
+        }
+
+        void setupTests() {
+            add<PublishesCurrentOp>();
+            add<KillPending>();
+            add<Done>();
+        }
+    } myall;
+
+} // namespace ClientRegistryTests
@@ -90,6 +90,34 @@ namespace mongo {
         }
     } myall;
 
+    TEST(DBHelperTests, RemoveRangeInBatches) {
+
+        DBDirectClient client;
+        client.dropCollection( ns );
+        for ( int i = 0; i < 10; ++i ) {
+            client.insert( ns, BSON( "_id" << i ) );
+        }
+
+        Helpers::RemovePacing pacing;
+        pacing.docsPerBatch = 3;
+        AtomicInt64 docsDeleted;
+        pacing.docsDeleted = &docsDeleted;
+
+        long long numDeleted;
+        {
+            // Remove _id range [2, 9), which takes three batches.
+            Lock::DBWrite lk( ns );
+            Client::Context ctx( ns );
+            KeyRange range( ns, BSON( "_id" << 2 ), BSON( "_id" << 9 ), BSON( "_id" << 1 ) );
+            numDeleted = Helpers::removeRange( range, false, false, NULL, false, false, pacing );
+        }
+
+        ASSERT_EQUALS( 7, numDeleted );
+        ASSERT_EQUALS( 7, docsDeleted.load() );
+        ASSERT_EQUALS( 3U, client.count( ns ) );
+        ASSERT_EQUALS( 0U, client.count( ns, BSON( "_id" << GTE << 2 << LT << 9 ) ) );
+    }
+
     //
     // Tests getting disk locs for an index range
     //
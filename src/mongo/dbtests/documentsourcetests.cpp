@@ -23,9 +23,15 @@
 
 #include "mongo/db/interrupt_status_mongod.h"
 #include "mongo/db/pipeline/expression_context.h"
+#include "mongo/s/shard.h"
 
 #include "dbtests.h"
 
+namespace mongo {
+    extern int internalGroupMaxMemoryUsageBytes;
+    extern int internalGroupMaxSpillFiles;
+}
+
 namespace DocumentSourceTests {
 
     static const char* const ns = "unittests.documentsourcetests";
@@ -412,7 +418,8 @@ namespace DocumentSourceTests {
 
         class Base : public DocumentSourceCursor::Base {
         protected:
-            void createGroup( const BSONObj &spec, bool inShard = false ) {
+            void createGroup( const BSONObj &spec, bool inShard = false,
+                              bool extSortAllowed = false ) {
                 BSONObj namedSpec = BSON( "$group" << spec );
                 BSONElement specElement = namedSpec.firstElement();
                 intrusive_ptr<ExpressionContext> expressionContext =
@@ -420,6 +427,7 @@ namespace DocumentSourceTests {
                 if ( inShard ) {
                     expressionContext->setInShard( true );
                 }
+                expressionContext->setExtSortAllowed( extSortAllowed );
                 _group = DocumentSourceGroup::createFromBson( &specElement, expressionContext );
                 assertRoundTrips( _group );
                 _group->setSource( source() );
@@ -933,6 +941,197 @@ namespace DocumentSourceTests {
             string expectedResultSetString() { return "[{_id:[1,2,3],a:[[4,5,6]]}]"; }
         };
 
+        /**
+         * With a tiny memory limit every document spills, and a small spill file limit forces
+         * repeated merge-reduce passes.  The results must match an in memory $group.
+         */
+        class SpillAndReduce : public Base {
+        public:
+            SpillAndReduce() :
+                _oldMaxMemoryUsageBytes( internalGroupMaxMemoryUsageBytes ),
+                _oldMaxSpillFiles( internalGroupMaxSpillFiles ) {
+            }
+            ~SpillAndReduce() {
+                internalGroupMaxMemoryUsageBytes = _oldMaxMemoryUsageBytes;
+                internalGroupMaxSpillFiles = _oldMaxSpillFiles;
+            }
+            void run() {
+                for( int i = 0; i < 200; ++i ) {
+                    client.insert( ns, BSON( "k" << i % 20 << "v" << i ) );
+                }
+                internalGroupMaxMemoryUsageBytes = 1;
+                internalGroupMaxSpillFiles = 3;
+                createSource();
+                createGroup( fromjson( "{_id:'$k',n:{$sum:1},total:{$sum:'$v'},"
+                                       "first:{$min:'$v'}}" ),
+                             false, true );
+
+                // Spilled results are returned in _id order.
+                int expectedId = 0;
+                for( ; !group()->eof(); group()->advance() ) {
+                    Document doc = group()->getCurrent();
+                    ASSERT_EQUALS( expectedId, doc[ "_id" ].getInt() );
+                    ASSERT_EQUALS( 10, doc[ "n" ].getInt() );
+                    // expectedId + (expectedId + 20) + ... + (expectedId + 180)
+                    ASSERT_EQUALS( 10 * expectedId + 900, doc[ "total" ].getInt() );
+                    ASSERT_EQUALS( expectedId, doc[ "first" ].getInt() );
+                    ++expectedId;
+                }
+                ASSERT_EQUALS( 20, expectedId );
+            }
+        private:
+            const int _oldMaxMemoryUsageBytes;
+            const int _oldMaxSpillFiles;
+        };
+
+        /** Exceeding the memory limit without allowDiskUsage is an error. */
+        class SpillNotAllowed : public Base {
+        public:
+            SpillNotAllowed() : _oldMaxMemoryUsageBytes( internalGroupMaxMemoryUsageBytes ) {
+            }
+            ~SpillNotAllowed() {
+                internalGroupMaxMemoryUsageBytes = _oldMaxMemoryUsageBytes;
+            }
+            void run() {
+                for( int i = 0; i < 10; ++i ) {
+                    client.insert( ns, BSON( "k" << i ) );
+                }
+                internalGroupMaxMemoryUsageBytes = 1;
+                createSource();
+                createGroup( fromjson( "{_id:'$k'}" ) );
+                ASSERT_THROWS( group()->eof(), UserException );
+            }
+        private:
+            const int _oldMaxMemoryUsageBytes;
+        };
+
+        /** The input order a group needs in order to stream, and when it satisfies a $sort. */
+        class StreamingSort : public Base {
+        public:
+            void run() {
+                // A field path _id.
+                assertStreamingSort( "{_id:'$a'}", BSONObj(), "{a:1}", false );
+                assertStreamingSort( "{_id:'$a.b'}", fromjson( "{_id:-1}" ), "{'a.b':-1}", true );
+                assertStreamingSort( "{_id:'$a'}", fromjson( "{n:1}" ), "{a:1}", false );
+                assertStreamingSort( "{_id:'$a'}", fromjson( "{_id:1,n:1}" ), "{a:1}", false );
+
+                // An object of field paths.
+                assertStreamingSort( "{_id:{d:'$day',c:'$cust'}}", BSONObj(),
+                                     "{day:1,cust:1}", false );
+                assertStreamingSort( "{_id:{d:'$day',c:'$cust'}}", fromjson( "{'_id.d':1,'_id.c':-1}" ),
+                                     "{day:1,cust:-1}", true );
+                assertStreamingSort( "{_id:{d:'$day',c:'$cust'}}", fromjson( "{'_id.c':1,'_id.d':1}" ),
+                                     "{day:1,cust:1}", false );
+                assertStreamingSort( "{_id:{d:'$day',c:'$cust'}}", fromjson( "{'_id.d':1}" ),
+                                     "{day:1,cust:1}", false );
+
+                // Anything else can't stream.
+                assertStreamingSort( "{_id:1}", BSONObj(), "{}", false );
+                assertStreamingSort( "{_id:{d:'$day',c:{$add:['$x',1]}}}", BSONObj(), "{}", false );
+                assertStreamingSort( "{_id:{d:'$day',e:'$day'}}", BSONObj(), "{}", false );
+                assertStreamingSort( "{_id:{$add:['$x',1]}}", BSONObj(), "{}", false );
+            }
+        private:
+            void assertStreamingSort( const char* groupSpec, const BSONObj& following,
+                                      const char* expectedSort, bool expectedSatisfies ) {
+                createGroup( fromjson( groupSpec ) );
+                intrusive_ptr<DocumentSourceSort> sort;
+                if ( !following.isEmpty() ) {
+                    sort = DocumentSourceSort::create( ctx(), following );
+                }
+                bool satisfies = !expectedSatisfies;
+                BSONObj streamingSort = static_cast<DocumentSourceGroup*>( group() )->
+                        getStreamingSort( sort.get(), &satisfies );
+                ASSERT_EQUALS( fromjson( expectedSort ), streamingSort );
+                ASSERT_EQUALS( expectedSatisfies, satisfies );
+            }
+        };
+
+        /** A streaming group over ordered input emits groups in the input order. */
+        class Streaming : public Base {
+        public:
+            void run() {
+                // Ordered on {d:1,c:-1} the way an index would order it: missing and null
+                // together, numbers of different types together.
+                BSONObj sourceData =
+                        fromjson( "{'':[{c:2,v:1},{d:null,c:2,v:2},{c:2,v:3},{d:null,c:1,v:4},"
+                                  "{d:1,c:3,v:5},{d:1.0,c:3,v:6},{d:NumberLong(1),c:1,v:7},"
+                                  "{d:2,c:5,v:8}]}" );
+                BSONElement sourceDataElement = sourceData.firstElement();
+                intrusive_ptr<DocumentSourceBsonArray> source =
+                        DocumentSourceBsonArray::create( &sourceDataElement, ctx() );
+
+                createGroup( fromjson( "{_id:{d:'$d',c:'$c'},n:{$sum:1},v:{$push:'$v'}}" ) );
+                DocumentSourceGroup* streaming = static_cast<DocumentSourceGroup*>( group() );
+                bool satisfies = false;
+                intrusive_ptr<DocumentSourceSort> sort =
+                        DocumentSourceSort::create( ctx(), fromjson( "{'_id.d':1,'_id.c':-1}" ) );
+                BSONObj streamingSort = streaming->getStreamingSort( sort.get(), &satisfies );
+                ASSERT( satisfies );
+                streaming->setStreaming( streamingSort );
+                streaming->setSource( source.get() );
+
+                // Within the first run {c:2} sorts before {d:null,c:2}, as $sort would order them.
+                BSONArrayBuilder results;
+                for( ; !streaming->eof(); streaming->advance() ) {
+                    results << streaming->getCurrent();
+                }
+                ASSERT_EQUALS( fromjson( "{'':[{_id:{c:2},n:2,v:[1,3]},"
+                                         "{_id:{d:null,c:2},n:1,v:[2]},"
+                                         "{_id:{d:null,c:1},n:1,v:[4]},"
+                                         "{_id:{d:1,c:3},n:2,v:[5,6]},"
+                                         "{_id:{d:1,c:1},n:1,v:[7]},"
+                                         "{_id:{d:2,c:5},n:1,v:[8]}]}" ),
+                               BSON( "" << results.arr() ) );
+            }
+        };
+
+        /** A group that absorbed an $unwind groups the elements the unwind would have passed on. */
+        class AbsorbUnwind : public Base {
+        public:
+            void run() {
+                BSONObj sourceData = fromjson( "{'':[{_id:0,a:[1,2,3]},{_id:1,a:[]},{_id:2},"
+                                               "{_id:3,a:[3,4]}]}" );
+                BSONElement sourceDataElement = sourceData.firstElement();
+                intrusive_ptr<DocumentSourceBsonArray> source =
+                        DocumentSourceBsonArray::create( &sourceDataElement, ctx() );
+
+                BSONObj unwindSpec = fromjson( "{$unwind:'$a'}" );
+                BSONElement unwindElement = unwindSpec.firstElement();
+                intrusive_ptr<DocumentSource> unwind =
+                        mongo::DocumentSourceUnwind::createFromBson( &unwindElement, ctx() );
+                BSONObj groupSpec = fromjson( "{$group:{_id:'$a',ids:{$push:'$_id'}}}" );
+                BSONElement groupElement = groupSpec.firstElement();
+                intrusive_ptr<DocumentSource> grouping =
+                        DocumentSourceGroup::createFromBson( &groupElement, ctx() );
+                DocumentSourceGroup* absorbing =
+                        static_cast<DocumentSourceGroup*>( grouping.get() );
+                ASSERT( !absorbing->absorbUnwind( source ) );
+                ASSERT( absorbing->absorbUnwind( unwind ) );
+                grouping->setSource( source.get() );
+
+                map<int, BSONObj> results;
+                for( ; !grouping->eof(); grouping->advance() ) {
+                    BSONObjBuilder bob;
+                    grouping->getCurrent()->toBson( &bob );
+                    BSONObj result = bob.obj();
+                    results[ result[ "_id" ].numberInt() ] = result;
+                }
+                ASSERT_EQUALS( 4U, results.size() );
+                ASSERT_EQUALS( fromjson( "{_id:1,ids:[0]}" ), results[ 1 ] );
+                ASSERT_EQUALS( fromjson( "{_id:2,ids:[0]}" ), results[ 2 ] );
+                ASSERT_EQUALS( fromjson( "{_id:3,ids:[0,3]}" ), results[ 3 ] );
+                ASSERT_EQUALS( fromjson( "{_id:4,ids:[3]}" ), results[ 4 ] );
+
+                BSONArrayBuilder bab;
+                grouping->addToBsonArray( &bab );
+                BSONObj stages = bab.arr();
+                ASSERT_EQUALS( 2, stages.nFields() );
+                ASSERT_EQUALS( unwindSpec, stages[ 0 ].Obj() );
+                ASSERT_EQUALS( groupSpec, stages[ 1 ].Obj() );
+            }
+        };
+
     } // namespace DocumentSourceGroup
 
     namespace DocumentSourceProject {
@@ -1106,7 +1305,52 @@ namespace DocumentSourceTests {
                 ASSERT_EQUALS( 1U, dependencies.count( "d" ) );
             }
         };
-        
+
+        /**
+         * getNextBatch() through $match and $project returns the same results as row at a time
+         * iteration, including when the two styles are interleaved.
+         */
+        class MatchProjectBatches : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 1000; ++i ) {
+                    client.insert( ns, BSON( "_id" << i << "a" << i % 3 ) );
+                }
+                createSource();
+                BSONObj matchSpec = BSON( "$match" << BSON( "a" << 0 ) );
+                BSONElement matchElement = matchSpec.firstElement();
+                intrusive_ptr<DocumentSource> match =
+                        DocumentSourceMatch::createFromBson( &matchElement, ctx() );
+                match->setSource( source() );
+                BSONObj projectSpec = BSON( "$project" << BSON( "x" << "$_id" ) );
+                BSONElement projectElement = projectSpec.firstElement();
+                intrusive_ptr<DocumentSource> project =
+                        DocumentSourceProject::createFromBson( &projectElement, ctx() );
+                project->setSource( match.get() );
+
+                vector<Document> results;
+                // Start row at a time so $match has a current Document when batching begins.
+                ASSERT( !project->eof() );
+                results.push_back( project->getCurrent() );
+                ASSERT( project->advance() );
+                for( size_t n; ( n = project->getNextBatch( &results, 7 ) ) > 0; ) {
+                    ASSERT( n <= 7U );
+                    if ( !project->eof() ) {
+                        results.push_back( project->getCurrent() );
+                        project->advance();
+                    }
+                }
+                ASSERT( project->eof() );
+                ASSERT_EQUALS( 0U, project->getNextBatch( &results, 7 ) );
+
+                ASSERT_EQUALS( 334U, results.size() );
+                for( size_t i = 0; i < results.size(); ++i ) {
+                    ASSERT_EQUALS( static_cast<int>( i * 3 ), results[ i ][ "x" ].getInt() );
+                    ASSERT( results[ i ][ "a" ].missing() );
+                }
+            }
+        };
+
     } // namespace DocumentSourceProject
 
     namespace DocumentSourceSort {
@@ -1180,7 +1424,7 @@ namespace DocumentSourceTests {
                     sort()->addToBsonArray(&arr, false);
                     ASSERT_EQUALS(arr.arr(), BSON_ARRAY(BSON("$sort" << BSON("a" << 1))));
 
-                    ASSERT(sort()->getShardSource() == NULL);
+                    ASSERT(sort()->getShardSource() != NULL);
                     ASSERT(sort()->getRouterSource() != NULL);
                 }
 
@@ -1472,7 +1716,36 @@ namespace DocumentSourceTests {
                 ASSERT_EQUALS( 1U, dependencies.count( "b.c" ) );
             }
         };
-        
+
+        /** mongos merges the shards' sorted results in sort order. */
+        class MergeShardResults : public Base {
+        public:
+            void run() {
+                createSort( BSON( "a" << -1 ) );
+
+                DocumentSourceCommandShards::ShardOutput shardOutput;
+                shardOutput[ Shard( "s0", "localhost:30000" ) ] =
+                        fromjson( "{ok:1,result:[{a:5,s:0},{a:3,s:0},{a:1,s:0}]}" );
+                shardOutput[ Shard( "s1", "localhost:30001" ) ] =
+                        fromjson( "{ok:1,result:[]}" );
+                shardOutput[ Shard( "s2", "localhost:30002" ) ] =
+                        fromjson( "{ok:1,result:[{a:6,s:2},{a:3,s:2},{a:2,s:2}]}" );
+
+                intrusive_ptr<DocumentSourceCommandShards> merger =
+                        DocumentSourceCommandShards::create( shardOutput, ctx() );
+                merger->setMergeSort( sort() );
+
+                BSONArrayBuilder bab;
+                for( bool hasNext = !merger->eof(); hasNext; hasNext = merger->advance() ) {
+                    bab << merger->getCurrent();
+                }
+                // Equal keys come out in shard order.
+                ASSERT_EQUALS( fromjson( "{'':[{a:6,s:2},{a:5,s:0},{a:3,s:0},{a:3,s:2},"
+                                         "{a:2,s:2},{a:1,s:0}]}" )[ "" ].Obj(),
+                               bab.arr() );
+            }
+        };
+
     } // namespace DocumentSourceSort
 
     namespace DocumentSourceUnwind {
@@ -1765,6 +2038,38 @@ namespace DocumentSourceTests {
             }
         };
 
+        /** A $match following the unwind is absorbed; only the elements it accepts come out. */
+        class AbsorbMatch : public Base {
+        public:
+            void run() {
+                client.insert( ns, fromjson( "{_id:0,a:[1,2,3]}" ) );
+                client.insert( ns, fromjson( "{_id:1,a:[]}" ) );
+                client.insert( ns, fromjson( "{_id:2,a:[0,4]}" ) );
+                createSource();
+                createUnwind();
+                BSONObj matchSpec = fromjson( "{$match:{a:{$gt:1}}}" );
+                BSONElement matchElement = matchSpec.firstElement();
+                ASSERT( unwind()->coalesce( DocumentSourceMatch::createFromBson( &matchElement,
+                                                                                 ctx() ) ) );
+                // Only one $match is absorbed.
+                ASSERT( !unwind()->coalesce( DocumentSourceMatch::createFromBson( &matchElement,
+                                                                                  ctx() ) ) );
+
+                BSONArrayBuilder results;
+                for( ; !unwind()->eof(); unwind()->advance() ) {
+                    results << unwind()->getCurrent();
+                }
+                ASSERT_EQUALS( fromjson( "{'':[{_id:0,a:2},{_id:0,a:3},{_id:2,a:4}]}" ),
+                               BSON( "" << results.arr() ) );
+
+                // Both stages still serialize.
+                BSONArrayBuilder bab;
+                unwind()->addToBsonArray( &bab );
+                ASSERT_EQUALS( fromjson( "{'':[{$unwind:'$a'},{$match:{a:{$gt:1}}}]}" ),
+                               BSON( "" << bab.arr() ) );
+            }
+        };
+
     } // namespace DocumentSourceUnwind
 
     namespace DocumentSourceGeoNear {
@@ -1846,6 +2151,11 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
             add<DocumentSourceGroup::ArrayConstantAccumulatorExpression>();
+            add<DocumentSourceGroup::SpillAndReduce>();
+            add<DocumentSourceGroup::SpillNotAllowed>();
+            add<DocumentSourceGroup::StreamingSort>();
+            add<DocumentSourceGroup::Streaming>();
+            add<DocumentSourceGroup::AbsorbUnwind>();
 
             add<DocumentSourceProject::EofInit>();
             add<DocumentSourceProject::AdvanceInit>();
@@ -1857,6 +2167,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceProject::InvalidSpec>();
             add<DocumentSourceProject::TwoDocuments>();
             add<DocumentSourceProject::Dependencies>();
+            add<DocumentSourceProject::MatchProjectBatches>();
 
             add<DocumentSourceSort::EofInit>();
             add<DocumentSourceSort::AdvanceInit>();
@@ -1879,6 +2190,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceSort::MissingObjectWithinArray>();
             add<DocumentSourceSort::ExtractArrayValues>();
             add<DocumentSourceSort::Dependencies>();
+            add<DocumentSourceSort::MergeShardResults>();
 
             add<DocumentSourceUnwind::EofInit>();
             add<DocumentSourceUnwind::AdvanceInit>();
@@ -1900,6 +2212,7 @@ namespace DocumentSourceTests {
             add<DocumentSourceUnwind::SeveralDocuments>();
             add<DocumentSourceUnwind::SeveralMoreDocuments>();
             add<DocumentSourceUnwind::Dependencies>();
+            add<DocumentSourceUnwind::AbsorbMatch>();
 
             add<DocumentSourceGeoNear::LimitCoalesce>();
         }
@@ -117,6 +117,24 @@ namespace DocumentTests {
             }
         };
 
+        /** Get Document values by names hashed ahead of time, with and without a hash table. */
+        class GetValueByHash {
+        public:
+            void run() {
+                const unsigned aHash = Document::hashFieldName( "a" );
+                const unsigned eHash = Document::hashFieldName( "e" );
+                Document small = fromBson( BSON( "a" << 1 << "b" << 2 ) );
+                ASSERT_EQUALS( 1, small.getField( "a", aHash ).getInt() );
+                ASSERT( small.getField( "e", eHash ).missing() );
+
+                Document big = fromBson( BSON( "a" << 1 << "b" << 2 << "c" << 3 << "d" << 4 <<
+                                               "e" << 5 ) );
+                ASSERT_EQUALS( 1, big.getField( "a", aHash ).getInt() );
+                ASSERT_EQUALS( 5, big.getField( "e", eHash ).getInt() );
+                ASSERT( big.getField( "f", Document::hashFieldName( "f" ) ).missing() );
+            }
+        };
+
         /** Get Document fields. */
         class SetField {
         public:
@@ -274,6 +292,30 @@ namespace DocumentTests {
             }
         };
 
+        /** Storage freed by one document is reused intact by the next ones. */
+        class RecycledStorage {
+        public:
+            void run() {
+                for ( int round = 0; round < 3; ++round ) {
+                    for ( int nFields = 0; nFields < 200; nFields += 7 ) {
+                        MutableDocument md( round == 1 ? nFields : 0 );
+                        for ( int i = 0; i < nFields; ++i ) {
+                            string name = str::stream() << "field" << i;
+                            md.addField( name, Value( i ) );
+                        }
+                        Document document = md.freeze();
+                        Document clonedDocument = document->clone();
+                        ASSERT_EQUALS( size_t( nFields ), clonedDocument.getFieldCount() );
+                        for ( int i = 0; i < nFields; ++i ) {
+                            string name = str::stream() << "field" << i;
+                            ASSERT_EQUALS( i, clonedDocument[ name ].getInt() );
+                        }
+                        assertRoundTrips( document );
+                    }
+                }
+            }
+        };
+
         /** FieldIterator for an empty Document. */
         class FieldIteratorEmpty {
         public:
@@ -1385,11 +1427,13 @@ namespace DocumentTests {
             add<Document::CreateFromBsonObj>();
             add<Document::AddField>();
             add<Document::GetValue>();
+            add<Document::GetValueByHash>();
             add<Document::SetField>();
             add<Document::Compare>();
             add<Document::CompareNamedNull>();
             add<Document::Clone>();
             add<Document::CloneMultipleFields>();
+            add<Document::RecycledStorage>();
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
@@ -824,6 +824,13 @@ namespace ExtSortTests {
             boost::scoped_array<int> _array;
         };
 
+        template <bool Random=true>
+        class LotsOfDataSmallFanIn : public LotsOfDataLittleMemory<Random> {
+            SortOptions adjustSortOptions(SortOptions opts) {
+                // Few enough that the spills take more than one pass to merge down
+                return LotsOfDataLittleMemory<Random>::adjustSortOptions(opts).MaxFanIn(4);
+            }
+        };
 
         template <long long Limit, bool Random=true>
         class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
@@ -880,6 +887,7 @@ namespace ExtSortTests {
             add<SorterTests::Dupes>();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/false> >();
             add<SorterTests::LotsOfDataLittleMemory</*random=*/true> >();
+            add<SorterTests::LotsOfDataSmallFanIn</*random=*/true> >();
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/false> >(); // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<1,/*random=*/true> >();  // limit=1 is special case
             add<SorterTests::LotsOfDataWithLimit<100,/*random=*/false> >(); // fits in mem
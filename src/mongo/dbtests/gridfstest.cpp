@@ -19,10 +19,15 @@
 #include "mongo/client/gridfs.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/md5.hpp"
 
+using mongo::BSONObj;
 using mongo::DBDirectClient;
+using mongo::GridFile;
+using mongo::GridFileBuilder;
 using mongo::GridFS;
 using mongo::MsgAssertionException;
+using mongo::UserException;
 
 namespace {
     DBDirectClient _client;
@@ -41,6 +46,104 @@ namespace {
         virtual ~SetChunkSizeTest() {}
     };
 
+    class Base {
+    public:
+        Base() {
+            _client.dropCollection( "gridtest.fs.files" );
+            _client.dropCollection( "gridtest.fs.chunks" );
+        }
+
+        virtual ~Base() {}
+
+    protected:
+        static std::string read( const GridFile& file ) {
+            std::stringstream out;
+            ASSERT_EQUALS( file.getContentLength(), file.write( out ) );
+            return out.str();
+        }
+
+        static std::string read( const GridFile& file, unsigned long long offset,
+                                 unsigned long long length ) {
+            std::stringstream out;
+            unsigned long long written = file.write( out, offset, length );
+            ASSERT_EQUALS( out.str().size(), written );
+            return out.str();
+        }
+    };
+
+    class BuilderTest : public Base {
+    public:
+        virtual void run() {
+            GridFS grid( _client, "gridtest" );
+            grid.setChunkSize( 5 );
+
+            // pieces that start and end in the middle of chunks, and one longer than a chunk
+            GridFileBuilder builder( &grid );
+            builder.append( "hel", 3 );
+            builder.append( "lo", 2 );
+            builder.append( " wo", 3 );
+            builder.append( "rld, this is", 12 );
+            builder.append( "", 0 );
+            builder.append( " gridfs", 7 );
+            BSONObj obj = builder.buildFile( "hello" );
+
+            const std::string expected = "hello world, this is gridfs";
+            GridFile file = grid.findFile( "hello" );
+            ASSERT( file.exists() );
+            ASSERT_EQUALS( obj["_id"].OID(), file.getFileField( "_id" ).OID() );
+            ASSERT_EQUALS( expected.size(), file.getContentLength() );
+            ASSERT_EQUALS( 6, file.getNumChunks() );
+            ASSERT_EQUALS( 6U, _client.count( "gridtest.fs.chunks" ) );
+            ASSERT_EQUALS( mongo::md5simpledigest( expected ), file.getMD5() );
+            ASSERT_EQUALS( expected, read( file ) );
+
+            grid.storeFile( expected.data(), expected.size(), "hello2" );
+            GridFile file2 = grid.findFile( "hello2" );
+            ASSERT_EQUALS( file.getMD5(), file2.getMD5() );
+            ASSERT_EQUALS( expected, read( file2 ) );
+        }
+    };
+
+    class RangeTest : public Base {
+    public:
+        virtual void run() {
+            GridFS grid( _client, "gridtest" );
+            grid.setChunkSize( 4 );
+            const std::string data = "0123456789abcdefghij";
+            grid.storeFile( data.data(), data.size(), "range" );
+            GridFile file = grid.findFile( "range" );
+
+            ASSERT_EQUALS( "0123", read( file, 0, 4 ) );
+            ASSERT_EQUALS( "3456789a", read( file, 3, 8 ) );
+            ASSERT_EQUALS( "5", read( file, 5, 1 ) );
+            ASSERT_EQUALS( "ghij", read( file, 16, 100 ) );
+            ASSERT_EQUALS( "", read( file, 20, 1 ) );
+            ASSERT_EQUALS( "", read( file, 2, 0 ) );
+            ASSERT_EQUALS( data, read( file, 0, data.size() ) );
+        }
+    };
+
+    class MD5MismatchTest : public Base {
+    public:
+        virtual void run() {
+            GridFS grid( _client, "gridtest" );
+            grid.setChunkSize( 4 );
+            const std::string data = "0123456789";
+            grid.storeFile( data.data(), data.size(), "bad" );
+            mongo::BSONObjBuilder changed;
+            changed.appendBinData( "data", 4, mongo::BinDataGeneral, "WXYZ" );
+            _client.update( "gridtest.fs.chunks", BSON( "n" << 1 ),
+                            BSON( "$set" << changed.obj() ) );
+            GridFile file = grid.findFile( "bad" );
+
+            std::stringstream out;
+            ASSERT_THROWS( file.write( out ), UserException );
+
+            // a range isn't checked
+            ASSERT_EQUALS( "0123", read( file, 0, 4 ) );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "gridfs" ) {
@@ -48,6 +151,9 @@ namespace {
 
         void setupTests() {
             add< SetChunkSizeTest >();
+            add< BuilderTest >();
+            add< RangeTest >();
+            add< MD5MismatchTest >();
         }
     } myall;
 }
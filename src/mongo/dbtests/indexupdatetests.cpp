@@ -22,6 +22,7 @@
 #include "mongo/db/btreecursor.h"
 #include "mongo/db/dbhelpers.h"
 #include "mongo/db/index/btree_based_builder.h"
+#include "mongo/db/instance.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/sort_phase_one.h"
@@ -100,6 +101,38 @@ namespace IndexUpdateTests {
         }
     };
 
+    /** addKeysToPhaseOneInParallel() sorts the keys of all documents across its threads. */
+    class AddKeysToPhaseOneInParallel : public IndexBuildBase {
+    public:
+        void run() {
+            // Enough documents for several batches per thread, inserted in descending order.
+            int32_t nDocs = 20000;
+            for( int32_t i = nDocs - 1; i >= 0; --i ) {
+                _client.insert( _ns, BSON( "a" << BSON_ARRAY( i << i + nDocs ) ) );
+            }
+            IndexDetails& id = addIndexWithInfo();
+            SortPhaseOne phaseOne;
+            ProgressMeterHolder pm (cc().curop()->setMessage("AddKeysToPhaseOneInParallel",
+                                                             "AddKeysToPhaseOneInParallel Progress",
+                                                             nDocs,
+                                                             nDocs));
+            BtreeBasedBuilder::addKeysToPhaseOneInParallel( nsdetails(_ns), _ns, id, &phaseOne,
+                                                            4, pm.get(), true,
+                                                            nsdetails(_ns)->idxNo(id) );
+            ASSERT_EQUALS( static_cast<uint64_t>( nDocs ), phaseOne.n );
+            ASSERT_EQUALS( static_cast<uint64_t>( 2 * nDocs ), phaseOne.nkeys );
+            ASSERT( phaseOne.multi );
+            // The threads' sorted keys come back merged into one sorted stream.
+            phaseOne.sorter->sort( false );
+            auto_ptr<BSONObjExternalSorter::Iterator> i = phaseOne.sorter->iterator();
+            int32_t expectedKey = 0;
+            for( ; i->more(); ++expectedKey ) {
+                ASSERT_EQUALS( expectedKey, i->next().first.firstElement().numberInt() );
+            }
+            ASSERT_EQUALS( 2 * nDocs, expectedKey );
+        }
+    };
+
     /** addKeysToPhaseOne() aborts if the current operation is killed. */
     class InterruptAddKeysToPhaseOne : public IndexBuildBase {
     public:
@@ -578,6 +611,38 @@ namespace IndexUpdateTests {
         }
     };
 
+    /** checkAndInsertBatch() inserts and indexes documents up to the first unique key error. */
+    class InsertBatchStopsAtDuplicate : public IndexBuildBase {
+    public:
+        void run() {
+            _client.ensureIndex( _ns, BSON( "a" << 1 ), true );
+            _client.ensureIndex( _ns, BSON( "b" << 1 ) );
+
+            vector<BSONObj> docs;
+            docs.push_back( BSON( "a" << 3 << "b" << BSON_ARRAY( 1 << 2 ) ) );
+            docs.push_back( BSON( "a" << 1 << "b" << 2 ) );
+            docs.push_back( BSON( "a" << 2 << "b" << 3 ) );
+            docs.push_back( BSON( "a" << 1 << "b" << 4 ) );
+            docs.push_back( BSON( "a" << 0 << "b" << 5 ) );
+
+            ASSERT_EQUALS( 3U, checkAndInsertBatch( _ns, docs ) );
+            ASSERT_EQUALS( 3U, _client.count( _ns ) );
+
+            // Each was given an _id, and indexed.
+            for ( int i = 0; i < 3; ++i ) {
+                ASSERT( !docs[ i ][ "_id" ].eoo() );
+                ASSERT_EQUALS( 1U, _client.count( _ns, BSON( "_id" << docs[ i ][ "_id" ] ) ) );
+            }
+            ASSERT_EQUALS( 1U, _client.count( _ns, BSON( "a" << 2 ) ) );
+            ASSERT_EQUALS( 2U, _client.count( _ns, BSON( "b" << 2 ) ) );
+            ASSERT( nsdetails( _ns )->isMultikey( 2 ) );
+
+            // Neither the duplicate nor anything after it went in.
+            ASSERT_EQUALS( 0U, _client.count( _ns, BSON( "b" << 4 ) ) );
+            ASSERT_EQUALS( 0U, _client.count( _ns, BSON( "a" << 0 ) ) );
+        }
+    };
+
     /**
      * Fixture class that has a basic compound index.
      */
@@ -735,6 +800,7 @@ namespace IndexUpdateTests {
 
         void setupTests() {
             add<AddKeysToPhaseOne>();
+            add<AddKeysToPhaseOneInParallel>();
             add<InterruptAddKeysToPhaseOne>( false );
             add<InterruptAddKeysToPhaseOne>( true );
             add<BuildBottomUp>();
@@ -750,6 +816,7 @@ namespace IndexUpdateTests {
             add<DirectClientEnsureIndexInterruptDisallowed>();
             add<HelpersEnsureIndexInterruptDisallowed>();
             add<IndexBuildInProgressTest>();
+            add<InsertBatchStopsAtDuplicate>();
             add<SameSpecDifferentOption>();
             add<SameSpecSameOptions>();
             add<DifferentSpecSameName>();
@@ -631,6 +631,85 @@ namespace IntervalBtreeCursorTests {
         }
     };
 
+    /** countKeys() counts every key in the interval, whole subtrees at a time where it can. */
+    class CountKeys {
+    public:
+        void run() {
+            Client::WriteContext ctx( _ns );
+            _client.dropCollection( _ns );
+            for( int32_t i = 0; i < 20000; ++i ) {
+                _client.insert( _ns, BSON( "a" << i ) );
+            }
+            _client.ensureIndex( _ns, BSON( "a" << 1 ) );
+
+            // There are subtrees to count wholesale.
+            ASSERT( nsdetails( _ns )->idx( 1 ).head.btree<V1>()->height() > 1 );
+
+            scoped_ptr<IntervalBtreeCursor> cursor( IntervalBtreeCursor::make( nsdetails( _ns ),
+                                                                               nsdetails( _ns )->idx( 1 ),
+                                                                               BSON( "" << 1000 ),
+                                                                               true,
+                                                                               BSON( "" << 15000 ),
+                                                                               false ) );
+            long long count = 0;
+            while( cursor->ok() ) {
+                long long n = cursor->countKeys( 100 );
+                ASSERT( n > 0 );
+                count += n;
+            }
+            ASSERT_EQUALS( 14000, count );
+            ASSERT_EQUALS( 14000, cursor->nscanned() );
+
+            // With no key above the upper bound the count runs to the end of the btree.
+            cursor.reset( IntervalBtreeCursor::make( nsdetails( _ns ),
+                                                     nsdetails( _ns )->idx( 1 ),
+                                                     BSON( "" << 1000 ),
+                                                     false,
+                                                     BSON( "" << 100000 ),
+                                                     true ) );
+            ASSERT_EQUALS( 18999, cursor->countKeys( 1000000 ) );
+            ASSERT( !cursor->ok() );
+        }
+    };
+
+    /** countKeys() counts the rest of a bucket in one pass, skipping its unused keys. */
+    class CountKeysInBucket {
+    public:
+        void run() {
+            Client::WriteContext ctx( _ns );
+            _client.dropCollection( _ns );
+            for( int32_t i = 0; i < 10; ++i ) {
+                _client.insert( _ns, BSON( "a" << i ) );
+            }
+            _client.ensureIndex( _ns, BSON( "a" << 1 ) );
+
+            // Mark keys at position 3 and 4 as unused.
+            nsdetails( _ns )->idx( 1 ).head.btreemod<V1>()->_k( 3 ).setUnused();
+            nsdetails( _ns )->idx( 1 ).head.btreemod<V1>()->_k( 4 ).setUnused();
+
+            // The end of the interval is past the bucket.
+            scoped_ptr<IntervalBtreeCursor> cursor( IntervalBtreeCursor::make( nsdetails( _ns ),
+                                                                               nsdetails( _ns )->idx( 1 ),
+                                                                               BSON( "" << 0 ),
+                                                                               true,
+                                                                               BSON( "" << 100 ),
+                                                                               true ) );
+            ASSERT_EQUALS( 8, cursor->countKeys( 1000 ) );
+            ASSERT( !cursor->ok() );
+            ASSERT_EQUALS( 8, cursor->nscanned() );
+
+            // The end of the interval is within the bucket.
+            cursor.reset( IntervalBtreeCursor::make( nsdetails( _ns ),
+                                                     nsdetails( _ns )->idx( 1 ),
+                                                     BSON( "" << 0 ),
+                                                     true,
+                                                     BSON( "" << 6 ),
+                                                     true ) );
+            ASSERT_EQUALS( 5, cursor->countKeys( 1000 ) );
+            ASSERT( !cursor->ok() );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "intervalbtreecursor" ) {
@@ -654,6 +733,8 @@ namespace IntervalBtreeCursorTests {
             add<UnusedKeys>();
             add<UnusedEndKey>();
             add<KeyBecomesUnusedDuringYield>();
+            add<CountKeys>();
+            add<CountKeysInBucket>();
         }
     } myall;
 
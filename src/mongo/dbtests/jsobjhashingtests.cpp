@@ -156,6 +156,46 @@ namespace JsobjHashingTests {
         }
     };
 
+    /**
+     * Scalars are hashed from one flat buffer; the digest must match feeding the same
+     * pieces to a Hasher one at a time, which is how everything else is hashed.
+     */
+    class FlatHashMatchesIncremental {
+    public:
+        void run() {
+            BSONObj objs[] = { BSON( "a" << 3 ),
+                               BSON( "a" << 3.5 ),
+                               BSON( "a" << "" ),
+                               BSON( "a" << string( 63, 'x' ) ),
+                               BSON( "a" << string( 100, 'x' ) ),
+                               BSON( "a" << true ),
+                               BSON( "a" << MINKEY ),
+                               BSONObjBuilder().genOID().obj() };
+
+            for ( size_t i = 0; i < sizeof( objs ) / sizeof( objs[0] ); i++ ) {
+                for ( HashSeed seed = 0; seed < 2; seed++ ) {
+                    BSONElement e = objs[i].firstElement();
+
+                    Hasher h( seed );
+                    int canonicalType = e.canonicalType();
+                    h.addData( &canonicalType , sizeof( canonicalType ) );
+                    if ( e.isNumber() ) {
+                        long long int n = e.safeNumberLong();
+                        h.addData( &n , sizeof( n ) );
+                    }
+                    else {
+                        h.addData( e.value() , e.valuesize() );
+                    }
+                    HashDigest d;
+                    h.finish( d );
+
+                    ASSERT_EQUALS( *reinterpret_cast< long long int * >( d ) ,
+                                   BSONElementHasher::hash64( e , seed ) );
+                }
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "jsobjhashing" ) {
@@ -163,6 +203,7 @@ namespace JsobjHashingTests {
 
         void setupTests() {
             add< BSONElementHashingTest >();
+            add< FlatHashMatchesIncremental >();
         }
     } myall;
 
@@ -18,6 +18,9 @@
  */
 
 #include "pch.h"
+
+#include <boost/thread/thread.hpp>
+
 #include "../bson/util/builder.h"
 #include "../db/jsobj.h"
 #include "../db/jsobjmanipulator.h"
@@ -264,6 +267,34 @@ namespace JsobjTests {
             }
         };
 
+        /** KeyV1::compactCompare() agrees with woCompare() and finds the first differing field. */
+        class KeyCompactCompare : public Base {
+        public:
+            void run() {
+                const Ordering ascDesc = Ordering::make( BSON( "a" << 1 << "b" << -1 ) );
+                KeyV1Owned k( BSON( "" << 5 << "" << "abc" ) );
+                KeyV1Owned same( BSON( "" << 5.0 << "" << "abc" ) );
+                KeyV1Owned second( BSON( "" << 5 << "" << "abd" ) );
+                KeyV1Owned first( BSON( "" << 4 << "" << "zzz" ) );
+                ASSERT( k.isCompactFormat() );
+
+                int field;
+                ASSERT_EQUALS( 0, k.compactCompare( same, ascDesc, &field ) );
+                ASSERT_EQUALS( 2, field );
+
+                // descending b inverts the string order
+                int x = k.compactCompare( second, ascDesc, &field );
+                ASSERT( x > 0 );
+                ASSERT_EQUALS( 1, field );
+                ASSERT_EQUALS( x > 0, k.woCompare( second, ascDesc ) > 0 );
+
+                x = k.compactCompare( first, ascDesc, &field );
+                ASSERT( x > 0 );
+                ASSERT_EQUALS( 0, field );
+                ASSERT_EQUALS( x > 0, k.woCompare( first, ascDesc ) > 0 );
+            }
+        };
+
         class MultiKeySortOrder : public Base {
         public:
             void run() {
@@ -1277,6 +1308,50 @@ namespace JsobjTests {
                 }
             }
         };
+
+        class Batch {
+        public:
+            void run() {
+                const size_t n = 1000;
+                vector<OID> batch( n );
+                OID::initBatch( &batch[0], n );
+                OID single = OID::gen();
+
+                for ( size_t i = 1; i < n; i++ ) {
+                    ASSERT( batch[i - 1] < batch[i] );
+                }
+                set<OID> distinct( batch.begin(), batch.end() );
+                ASSERT_EQUALS( n, distinct.size() );
+                ASSERT( distinct.find( single ) == distinct.end() );
+                ASSERT( batch[n - 1].asTimeT() <= single.asTimeT() );
+            }
+        };
+
+        class ThreadsUnique {
+        public:
+            void run() {
+                const int nThreads = 4;
+                vector<OID> oids[nThreads];
+                boost::thread_group threads;
+                for ( int i = 0; i < nThreads; i++ ) {
+                    threads.create_thread( boost::bind( &ThreadsUnique::gen, &oids[i] ) );
+                }
+                threads.join_all();
+
+                set<OID> distinct;
+                for ( int i = 0; i < nThreads; i++ ) {
+                    distinct.insert( oids[i].begin(), oids[i].end() );
+                }
+                ASSERT_EQUALS( static_cast<size_t>( nThreads * 10000 ), distinct.size() );
+            }
+
+        private:
+            static void gen( vector<OID>* oids ) {
+                for ( int i = 0; i < 10000; i++ ) {
+                    oids->push_back( OID::gen() );
+                }
+            }
+        };
     } // namespace OIDTests
 
 
@@ -2115,6 +2190,7 @@ namespace JsobjTests {
             add< BSONObjTests::WoSortOrder >();
             add< BSONObjTests::IsPrefixOf >();
             add< BSONObjTests::MultiKeySortOrder > ();
+            add< BSONObjTests::KeyCompactCompare > ();
             add< BSONObjTests::TimestampTest >();
             add< BSONObjTests::Nan >();
             add< BSONObjTests::AsTempObj >();
@@ -2161,6 +2237,8 @@ namespace JsobjTests {
             add< OIDTests::ToDate >();
             add< OIDTests::FromDate >();
             add< OIDTests::Seq >();
+            add< OIDTests::Batch >();
+            add< OIDTests::ThreadsUnique >();
             add< ValueStreamTests::LabelBasic >();
             add< ValueStreamTests::LabelShares >();
             add< ValueStreamTests::LabelDouble >();
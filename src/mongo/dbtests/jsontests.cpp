@@ -421,6 +421,29 @@ namespace JsonTests {
             }
         };
 
+        class StreamMatchesString {
+        public:
+            void run() {
+                char z[ 3 ] = { 'a', 'b', 'c' };
+                BSONObjBuilder b;
+                b.append( "a" , 1.0 / 3 );
+                b.appendBinData( "b" , 3 , BinDataGeneral , z );
+                b.append( "c" , BSON( "d" << BSON_ARRAY( 1 << BSON( "e" << "f" ) ) ) );
+                b.appendCodeWScope( "g" , "function(){}" , BSON( "x" << 1 ) );
+                BSONObj o = b.obj();
+
+                // written in place, and leaving the stream's formatting as it was
+                stringstream ss;
+                ss << "[";
+                o.jsonStringStream( Strict, 0, ss );
+                ss << "] ";
+                ss.width( 3 );
+                ss << 7 << " " << 1.0 / 3;
+
+                ASSERT_EQUALS( "[" + o.jsonString() + "]   7 0.333333", ss.str() );
+            }
+        };
+
     } // namespace JsonStringTests
 
     namespace FromJsonTests {
@@ -2203,6 +2226,51 @@ namespace JsonTests {
             }
         };
 
+        class IntegerBoundaryTypes : public Base {
+        public:
+            void run() {
+                Base::run();
+
+                BSONObj o = fromjson(json());
+
+                ASSERT(o["maxInt"].type() == NumberInt);
+                ASSERT(o["minInt"].type() == NumberInt);
+                ASSERT(o["overInt"].type() == NumberLong);
+                ASSERT(o["digits18"].type() == NumberLong);
+                ASSERT(o["digits19"].type() == NumberLong);
+                ASSERT(o["exponent"].type() == NumberDouble);
+
+                ASSERT(o["digits18"].numberLong() == -999999999999999999ll);
+                ASSERT(o["digits19"].numberLong() == 1000000000000000000ll);
+            }
+
+            virtual BSONObj bson() const {
+                return BSON( "maxInt" << 2147483647
+                             << "minInt" << -2147483647 - 1
+                             << "overInt" << 2147483648ll
+                             << "digits18" << -999999999999999999ll
+                             << "digits19" << 1000000000000000000ll
+                             << "exponent" << 1e3
+                           );
+            }
+            virtual string json() const {
+                return "{ \"maxInt\": 2147483647, \"minInt\":-2147483648, "
+                       "\"overInt\": 2147483648, \"digits18\": -999999999999999999, "
+                       "\"digits19\": 1000000000000000000, \"exponent\": 1e3 }";
+            }
+        };
+
+        class PlainAndEscapedStrings : public Base {
+            virtual BSONObj bson() const {
+                return BSON( "plain" << "abc def" << "single" << "it's"
+                             << "escaped" << "a\"b" << "empty" << "" );
+            }
+            virtual string json() const {
+                return "{ \"plain\" : \"abc def\", \"single\" : \"it's\", "
+                       "\"escaped\" : \"a\\\"b\", \"empty\" : '' }";
+            }
+        };
+
         class EmbeddedDatesBase : public Base  {
         public:
 
@@ -2300,6 +2368,7 @@ namespace JsonTests {
             add< JsonStringTests::TimestampTests >();
             add< JsonStringTests::NullString >();
             add< JsonStringTests::AllTypes >();
+            add< JsonStringTests::StreamMatchesString >();
 
             add< FromJsonTests::Empty >();
             add< FromJsonTests::EmptyWithSpace >();
@@ -2487,6 +2556,8 @@ namespace JsonTests {
             add< FromJsonTests::NumericLimitsBad >();
             add< FromJsonTests::NumericLimitsBad1 >();
             add< FromJsonTests::NegativeNumericTypes >();
+            add< FromJsonTests::IntegerBoundaryTypes >();
+            add< FromJsonTests::PlainAndEscapedStrings >();
             add< FromJsonTests::EmbeddedDatesFormat1 >();
             add< FromJsonTests::EmbeddedDatesFormat2 >();
             add< FromJsonTests::EmbeddedDatesFormat3 >();
@@ -79,6 +79,30 @@ namespace JSTests {
         }
     };
 
+    /** Running the same code again gets its compiled script from the cache. */
+    class ExecRepeated {
+    public:
+        void run() {
+            scoped_ptr<Scope> s;
+            s.reset( globalScriptEngine->newScope() );
+
+            s->setNumber( "n" , 0 );
+            for ( int i = 0; i < 3; ++i ) {
+                ASSERT( s->exec( "n = n + 1;" , "incr" , false , true , true ) );
+            }
+            ASSERT_EQUALS( 3 , s->getNumber( "n" ) );
+
+            // The same code under another name, or new code, still runs.
+            ASSERT( s->exec( "n = n + 1;" , "other" , false , true , true ) );
+            ASSERT( s->exec( "n = n * 2;" , "incr" , false , true , true ) );
+            ASSERT_EQUALS( 8 , s->getNumber( "n" ) );
+
+            // Compile errors are reported every time, not cached.
+            ASSERT( ! s->exec( "n = ;" , "bad" , false , false , false ) );
+            ASSERT( ! s->exec( "n = ;" , "bad" , false , false , false ) );
+        }
+    };
+
     class FalseTests {
     public:
         void run() {
@@ -2008,6 +2032,7 @@ namespace JSTests {
             add< BuiltinTests >();
             add< BasicScope >();
             add< ResetScope >();
+            add< ExecRepeated >();
             add< FalseTests >();
             add< SimpleFunctions >();
             add< ExecLogError >();
@@ -0,0 +1,313 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * Micro-benchmarks of hot path components.  Each benchmark times one small operation many
+ * times over: after a warmup, it runs kTrials timed trials and reports the median time per
+ * operation, with the fastest and slowest trials to show how noisy the numbers are, and the
+ * median CPU cycles per operation where the CPU has a cycle counter we can read.
+ *
+ * Run with "test microbench".  Builds are only comparable on the same machine.
+ */
+
+#include "mongo/pch.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+#include "mongo/db/btree.h"
+#include "mongo/db/extsort.h"
+#include "mongo/db/index/btree_based_builder.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/key.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/namespace_details.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/dbtests/dbtests.h"
+#include "mongo/util/timer.h"
+
+namespace MicroBenchmarks {
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    const bool haveCycleCounter = true;
+    inline unsigned long long readCycleCounter() { return __rdtsc(); }
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    const bool haveCycleCounter = true;
+    inline unsigned long long readCycleCounter() {
+        unsigned lo, hi;
+        __asm__ __volatile__( "rdtsc" : "=a" (lo), "=d" (hi) );
+        return ( static_cast<unsigned long long>( hi ) << 32 ) | lo;
+    }
+#else
+    const bool haveCycleCounter = false;
+    inline unsigned long long readCycleCounter() { return 0; }
+#endif
+
+    // benchmarks add their results in here so the compiler can't drop the work
+    unsigned long long dontOptimizeOut = 0;
+
+    class Benchmark {
+    public:
+        static const int kTrials = 7;
+
+        virtual ~Benchmark() { }
+
+        void run() {
+            setUp();
+
+            const unsigned long long trialMicros = DEBUG_BUILD ? 10000 : 100000;
+
+            // size batches so the time to read the clocks doesn't count
+            unsigned long long batch = 1;
+            while ( timeBatch( batch ).first < 1000 ) {
+                batch *= 2;
+            }
+
+            // warmup
+            runTrial( batch, trialMicros / 2 );
+
+            std::vector<double> nanos;
+            std::vector<double> cycles;
+            for ( int i = 0; i < kTrials; ++i ) {
+                const std::pair<double, double> trial = runTrial( batch, trialMicros );
+                nanos.push_back( trial.first );
+                cycles.push_back( trial.second );
+            }
+            std::sort( nanos.begin(), nanos.end() );
+            std::sort( cycles.begin(), cycles.end() );
+
+            cout << "microbench " << setw( 32 ) << left << name() << right << fixed
+                 << setprecision( 1 ) << setw( 12 ) << nanos[kTrials / 2] << " ns/op  ["
+                 << nanos.front() << " - " << nanos.back() << "]";
+            if ( haveCycleCounter )
+                cout << setw( 12 ) << cycles[kTrials / 2] << " cycles/op";
+            cout << endl;
+
+            tearDown();
+        }
+
+    protected:
+        virtual std::string name() = 0;
+
+        // anything to do before timing; not timed
+        virtual void setUp() { }
+
+        // the operation measured; called many times over
+        virtual void op() = 0;
+
+        virtual void tearDown() { }
+
+    private:
+        /** @return the micros and cycles 'n' calls of op() took */
+        std::pair<unsigned long long, unsigned long long> timeBatch( unsigned long long n ) {
+            mongo::Timer t;
+            const unsigned long long startCycles = readCycleCounter();
+            for ( unsigned long long i = 0; i < n; ++i )
+                op();
+            const unsigned long long elapsedCycles = readCycleCounter() - startCycles;
+            return std::make_pair( t.micros(), elapsedCycles );
+        }
+
+        /** @return the nanos and cycles per op() over batches run for at least 'micros' */
+        std::pair<double, double> runTrial( unsigned long long batch, unsigned long long micros ) {
+            unsigned long long ops = 0;
+            unsigned long long totalMicros = 0;
+            unsigned long long totalCycles = 0;
+            while ( totalMicros < micros ) {
+                const std::pair<unsigned long long, unsigned long long> t = timeBatch( batch );
+                totalMicros += t.first;
+                totalCycles += t.second;
+                ops += batch;
+            }
+            return std::make_pair( 1000.0 * totalMicros / ops,
+                                   static_cast<double>( totalCycles ) / ops );
+        }
+    };
+
+    class BSONObjBuilderSmall : public Benchmark {
+        std::string name() { return "BSONObjBuilder-4fields"; }
+        void op() {
+            BSONObjBuilder b;
+            b.append( "a", 1 );
+            b.append( "b", 3.0 );
+            b.append( "c", "qqq" );
+            b.appendBool( "d", true );
+            dontOptimizeOut += b.obj().objsize();
+        }
+    };
+
+    class KeyV1WoCompare : public Benchmark {
+    public:
+        KeyV1WoCompare() :
+            _a( BSON( "" << 1 << "" << 3.0 << "" << "qqq" ) ),
+            _b( BSON( "" << 1 << "" << 3.0 << "" << "qqqb" ) ),
+            _ordering( Ordering::make( BSON( "a" << 1 << "b" << 1 << "c" << 1 ) ) ) {
+        }
+    private:
+        std::string name() { return "KeyV1::woCompare"; }
+        void op() {
+            dontOptimizeOut += _a.woCompare( _b, _ordering );
+        }
+
+        KeyV1Owned _a;
+        KeyV1Owned _b;
+        Ordering _ordering;
+    };
+
+    /** A point lookup in a three level { a : 1 } index, which does a find() per level. */
+    class BtreeFindSingle : public Benchmark {
+        static const int kNumKeys = 100000;
+
+        static const char* ns() { return "unittests.microbench_btree"; }
+
+        std::string name() { return "BtreeBucket::findSingle"; }
+
+        void setUp() {
+            _client.dropCollection( ns() );
+            _client.ensureIndex( ns(), BSON( "a" << 1 ) );
+            for ( int i = 0; i < kNumKeys; ++i ) {
+                _client.insert( ns(), BSON( "a" << i ) );
+            }
+            _client.getLastError();
+
+            for ( int i = 0; i < 1024; ++i ) {
+                _keys.push_back( BSON( "" << ( i * 7919 ) % kNumKeys ) );
+            }
+            _next = 0;
+
+            _ctx.reset( new Client::ReadContext( ns() ) );
+            NamespaceDetails* nsd = nsdetails( ns() );
+            verify( nsd );
+            _index = &nsd->idx( nsd->findIndexByKeyPattern( BSON( "a" << 1 ) ) );
+            verify( 1 == _index->version() );
+        }
+
+        void op() {
+            const BSONObj& key = _keys[_next++ % _keys.size()];
+            const DiskLoc loc = _index->head.btree<V1>()->findSingle( *_index, _index->head, key );
+            dontOptimizeOut += loc.getOfs();
+        }
+
+        void tearDown() {
+            _ctx.reset();
+            _client.dropCollection( ns() );
+        }
+
+        DBDirectClient _client;
+        boost::scoped_ptr<Client::ReadContext> _ctx;
+        const IndexDetails* _index;
+        std::vector<BSONObj> _keys;
+        size_t _next;
+    };
+
+    class MatchesBSON : public Benchmark {
+    public:
+        MatchesBSON() :
+            _doc( BSON( "x" << "abc" << "a" << 7 << "b" << "qqq" << "c" << BSON_ARRAY( 1 << 2 ) ) ) {
+        }
+    private:
+        std::string name() { return "MatchExpression::matchesBSON"; }
+
+        void setUp() {
+            StatusWithMatchExpression parsed =
+                MatchExpressionParser::parse( BSON( "a" << BSON( "$gt" << 5 ) << "b" << "qqq" ) );
+            verify( parsed.isOK() );
+            _expression.reset( parsed.getValue() );
+        }
+
+        void op() {
+            dontOptimizeOut += _expression->matchesBSON( _doc );
+        }
+
+        BSONObj _doc;
+        boost::scoped_ptr<MatchExpression> _expression;
+    };
+
+    class DocumentFromBSON : public Benchmark {
+    public:
+        DocumentFromBSON() :
+            _bson( BSON( "a" << 1 << "b" << 3.0 << "c" << "qqq" << "d" << BSON( "e" << true ) ) ) {
+        }
+    private:
+        std::string name() { return "Document(BSONObj)"; }
+        void op() {
+            Document doc( _bson );
+            dontOptimizeOut += doc.size();
+        }
+
+        BSONObj _bson;
+    };
+
+    class MutableDocumentBuild : public Benchmark {
+        std::string name() { return "MutableDocument-4fields"; }
+        void op() {
+            MutableDocument md;
+            md.addField( "a", Value( 1 ) );
+            md.addField( "b", Value( 3.0 ) );
+            md.addField( "c", Value( "qqq" ) );
+            md.addField( "d", Value( true ) );
+            dontOptimizeOut += md.freeze().size();
+        }
+    };
+
+    /** Each op sorts 1000 keys in memory and reads them back. */
+    class SorterThousand : public Benchmark {
+    public:
+        SorterThousand() : _comparison( BtreeBasedBuilder::getComparison( 1, BSON( "a" << 1 ) ) ) {
+            for ( int i = 0; i < 1000; ++i ) {
+                _keys.push_back( BSON( "" << ( i * 7919 ) % 1000 ) );
+            }
+        }
+    private:
+        std::string name() { return "Sorter-1000keys"; }
+        void op() {
+            BSONObjExternalSorter sorter( _comparison.get() );
+            for ( size_t i = 0; i < _keys.size(); ++i ) {
+                sorter.add( _keys[i], DiskLoc( 0, static_cast<int>( i ) ), false );
+            }
+            sorter.sort( false );
+            auto_ptr<BSONObjExternalSorter::Iterator> it = sorter.iterator();
+            while ( it->more() ) {
+                dontOptimizeOut += it->next().second.getOfs();
+            }
+        }
+
+        boost::scoped_ptr<ExternalSortComparison> _comparison;
+        std::vector<BSONObj> _keys;
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "microbench" ) { }
+
+        void setupTests() {
+            add< BSONObjBuilderSmall >();
+            add< KeyV1WoCompare >();
+            add< BtreeFindSingle >();
+            add< MatchesBSON >();
+            add< DocumentFromBSON >();
+            add< MutableDocumentBuild >();
+            add< SorterThousand >();
+        }
+    } myall;
+
+}  // namespace MicroBenchmarks
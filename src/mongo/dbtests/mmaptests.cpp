@@ -17,6 +17,7 @@
  */
 
 #include "mongo/pch.h"
+#include "mongo/db/dur_commitjob.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/util/timer.h"
 #include "mongo/dbtests/dbtests.h"
@@ -104,11 +105,36 @@ namespace MMapTests {
         }
     };
 
+    /** IntentsAndDurOps merges overlapping and adjacent write intents as they are noted. */
+    class WriteIntentCoalescing {
+    public:
+        void run() {
+            char buf[1000];
+            dur::IntentsAndDurOps wi;
+            wi.insertWriteIntent( buf + 100, 10 );
+            wi.insertWriteIntent( buf + 300, 10 );
+            wi.insertWriteIntent( buf + 103, 2 );   // contained
+            wi.insertWriteIntent( buf + 90, 15 );   // overlaps the start
+            wi.insertWriteIntent( buf + 310, 5 );   // adjacent
+            ASSERT_EQUALS( 2U, wi._intents.size() );
+            ASSERT( wi._intents.begin()->start() == buf + 90 );
+            ASSERT_EQUALS( 20U, wi._intents.begin()->length() );
+            ASSERT_EQUALS( 15U, wi._intents.rbegin()->length() );
+
+            // one intent spanning both swallows them
+            wi.insertWriteIntent( buf + 50, 500 );
+            ASSERT_EQUALS( 1U, wi._intents.size() );
+            ASSERT( wi._intents.begin()->start() == buf + 50 );
+            ASSERT_EQUALS( 500U, wi._intents.begin()->length() );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "mmap" ) {}
         void setupTests() {
             add< LeakTest >();
+            add< WriteIntentCoalescing >();
         }
     } myall;
 
@@ -20,17 +20,27 @@
 // Where IndexDetails defined.
 #include "mongo/pch.h"
 
+#include <boost/filesystem/operations.hpp>
+
 #include "mongo/db/db.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/defragmenter.h"
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/db/index/hash_access_method.h"
 #include "mongo/db/index_legacy.h"
 #include "mongo/db/index_selection.h"
 #include "mongo/db/json.h"
 #include "mongo/db/storage/namespace.h"
+#include "mongo/db/storage/namespace_index.h"
 #include "mongo/db/queryutil.h"
 
 #include "dbtests.h"
 
+namespace mongo {
+    extern unsigned lenForNewNsFiles;
+    extern bool recordAllocHeadOfBucket;
+}
+
 namespace NamespaceTests {
 
     const int MinExtentSize = 4096;
@@ -1935,6 +1945,74 @@ namespace NamespaceTests {
             virtual string spec() const { return ""; }
         };
 
+        /** With recordAllocHeadOfBucket, alloc() takes the first fitting deleted list head. */
+        class AllocHeadOfBucket : public Base {
+        public:
+            AllocHeadOfBucket() : _wasSet( recordAllocHeadOfBucket ) {
+                recordAllocHeadOfBucket = true;
+            }
+            ~AllocHeadOfBucket() {
+                recordAllocHeadOfBucket = _wasSet;
+            }
+            void run() {
+                create();
+                DiskLoc expectedLocation = nsd()->allocWillBeAt( ns(), 300 );
+                DiskLoc first = nsd()->alloc( ns(), 300 );
+                ASSERT_EQUALS( expectedLocation, first );
+                ASSERT_EQUALS( 320, first.rec()->lengthWithHeaders() );
+
+                // What was split off the extent's free space is back at the head of a list, so
+                // the next record follows the first.
+                expectedLocation = nsd()->allocWillBeAt( ns(), 300 );
+                DiskLoc second = nsd()->alloc( ns(), 300 );
+                ASSERT_EQUALS( expectedLocation, second );
+                ASSERT_EQUALS( first.a(), second.a() );
+                ASSERT_EQUALS( first.getOfs() + 320, second.getOfs() );
+            }
+            virtual string spec() const { return ""; }
+        private:
+            bool _wasSet;
+        };
+
+        /** defragmentCollection() frees sparse extents, keeping their records and index entries. */
+        class DefragmentSparseExtents : public Base {
+        public:
+            void run() {
+                create();
+                for ( int i = 0; i < 60; ++i ) {
+                    BSONObj o = bigObj( true );
+                    theDataFileMgr.insert( ns(), o.objdata(), o.objsize() );
+                }
+                int extentsBefore = nExtents();
+                ASSERT( extentsBefore > 1 );
+
+                // Leave one record in each extent but the last.
+                vector<BSONObj> kept;
+                vector<DiskLoc> toDelete;
+                for ( DiskLoc ext = nsd()->firstExtent(); ext != nsd()->lastExtent();
+                      ext = ext.ext()->xnext ) {
+                    DiskLoc L = ext.ext()->firstRecord;
+                    if ( L.isNull() )
+                        continue;
+                    kept.push_back( L.obj()["_id"].wrap() );
+                    for ( int ofs = L.rec()->nextOfs(); ofs != DiskLoc::NullOfs;
+                          ofs = DiskLoc( L.a(), ofs ).rec()->nextOfs() )
+                        toDelete.push_back( DiskLoc( L.a(), ofs ) );
+                }
+                for ( unsigned i = 0; i < toDelete.size(); ++i )
+                    theDataFileMgr.deleteRecord( ns(), toDelete[ i ].rec(), toDelete[ i ] );
+                int recordsBefore = nRecords();
+
+                int freed = defragmentCollection( ns(), 50, 0 );
+                ASSERT( freed > 0 );
+                ASSERT_EQUALS( extentsBefore - freed, nExtents() );
+                ASSERT_EQUALS( recordsBefore, nRecords() );
+                for ( unsigned i = 0; i < kept.size(); ++i )
+                    ASSERT( !Helpers::findById( nsd(), kept[ i ] ).isNull() );
+            }
+            virtual string spec() const { return "{\"size\":4096,\"$nExtents\":4}"; }
+        };
+
         /** alloc() does not quantize records in capped collections. */
         class AllocCappedNotQuantized : public Base {
         public:
@@ -2201,6 +2279,57 @@ namespace NamespaceTests {
             }
         };
 
+        /** Once a capped collection loops, inserts delete old documents in batches. */
+        class CappedDeletesAhead : public Base {
+        public:
+            void run() {
+                create();
+                BSONObj b = bigObj();
+
+                // fill the extent and loop
+                int i = 0;
+                while ( !nsd()->capLooped() || nsd()->capFirstNewRecord().isNull() ) {
+                    ASSERT( !theDataFileMgr.insert( ns(), b.objdata(), b.objsize() ).isNull() );
+                    ASSERT( ++i < 100000 );
+                }
+
+                // 1/64 of the extent's worth of ~200 byte documents goes at a time
+                int deletingInserts = 0;
+                for ( int j = 0; j < 1000; j++ ) {
+                    long long before = nsd()->numRecords();
+                    ASSERT( !theDataFileMgr.insert( ns(), b.objdata(), b.objsize() ).isNull() );
+                    long long after = nsd()->numRecords();
+                    if ( after <= before ) {
+                        ++deletingInserts;
+                        ASSERT( before - after > 10 );
+                    }
+                }
+                ASSERT( deletingInserts > 0 );
+                ASSERT( deletingInserts < 100 );
+            }
+        private:
+            virtual string spec() const {
+                return "{capped:true,size:1048576,$nExtents:1}";
+            }
+        };
+
+        /** With a max, a full capped collection stays at exactly that many documents. */
+        class CappedMaxDeletesOne : public Base {
+        public:
+            void run() {
+                create();
+                BSONObj b = bigObj();
+                for ( int i = 0; i < 300; i++ ) {
+                    ASSERT( !theDataFileMgr.insert( ns(), b.objdata(), b.objsize() ).isNull() );
+                    ASSERT_EQUALS( min( i + 1, 100 ), nsd()->numRecords() );
+                }
+            }
+        private:
+            virtual string spec() const {
+                return "{capped:true,size:1048576,max:100,$nExtents:1}";
+            }
+        };
+
         // This isn't a particularly useful test, and because it doesn't clean up
         // after itself, /tmp/unittest needs to be cleared after running.
         //        class BigCollection : public Base {
@@ -2307,6 +2436,59 @@ namespace NamespaceTests {
 
     } // namespace NamespaceDetailsTests
 
+    namespace NamespaceIndexTests {
+
+        /** The .ns file grows by extension files once full, and they come back on reopening. */
+        class GrowsByExtensions {
+        public:
+            void run() {
+                Lock::GlobalWrite lk;
+                const unsigned lenBefore = lenForNewNsFiles;
+                lenForNewNsFiles = 1024 * 1024; // room for about 1600 namespaces
+                {
+                    Client::Context ctx( ns() );
+                    NamespaceIndex& ni = ctx.db()->namespaceIndex();
+                    for ( int i = 0; i < nNamespaces; i++ ) {
+                        DiskLoc loc;
+                        ni.add_ns( name( i ), loc, false );
+                    }
+                    ASSERT( ni.fileLength() > 1024 * 1024 );
+                    for ( int i = 0; i < nNamespaces; i += 3 ) {
+                        ni.kill_ns( name( i ).c_str() );
+                    }
+                    check( ni );
+                    Database::closeDatabase( db(), dbpath );
+                }
+                lenForNewNsFiles = lenBefore;
+
+                Client::Context ctx( ns() );
+                check( ctx.db()->namespaceIndex() );
+                dropDatabase( db() );
+                ASSERT( !boost::filesystem::exists( boost::filesystem::path( dbpath ) /
+                                                    ( db() + ".ns.0" ) ) );
+            }
+        private:
+            static const int nNamespaces = 4000;
+
+            static string db() { return "unittests_namespaceindex"; }
+            static string ns() { return db() + ".x"; }
+            static string name( int i ) {
+                return mongoutils::str::stream() << db() << ".c" << i;
+            }
+
+            void check( NamespaceIndex& ni ) {
+                for ( int i = 0; i < nNamespaces; i++ ) {
+                    ASSERT_EQUALS( i % 3 != 0, ni.details( name( i ) ) != 0 );
+                }
+                list<string> all;
+                ni.getNamespaces( all );
+                ASSERT_EQUALS( static_cast<size_t>( nNamespaces - ( nNamespaces + 2 ) / 3 ),
+                               all.size() );
+            }
+        };
+
+    } // namespace NamespaceIndexTests
+
     namespace NamespaceDetailsTransientTests {
         
         /** clearQueryCache() clears the query plan cache. */
@@ -2422,6 +2604,8 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::GetRecordAllocationSizePowerOf2 >();
             add< NamespaceDetailsTests::GetRecordAllocationSizePowerOf2PaddingIgnored >();
             add< NamespaceDetailsTests::AllocQuantized >();
+            add< NamespaceDetailsTests::AllocHeadOfBucket >();
+            add< NamespaceDetailsTests::DefragmentSparseExtents >();
             add< NamespaceDetailsTests::AllocCappedNotQuantized >();
             add< NamespaceDetailsTests::AllocIndexNamespaceNotQuantized >();
             add< NamespaceDetailsTests::AllocIndexNamespaceSlightlyQuantized >();
@@ -2433,11 +2617,14 @@ namespace NamespaceTests {
             add< NamespaceDetailsTests::AllocFailsWithTooSmallDeletedRecord >();
             add< NamespaceDetailsTests::TwoExtent >();
             add< NamespaceDetailsTests::TruncateCapped >();
+            add< NamespaceDetailsTests::CappedDeletesAhead >();
+            add< NamespaceDetailsTests::CappedMaxDeletesOne >();
             add< NamespaceDetailsTests::Migrate >();
             add< NamespaceDetailsTests::SwapIndexEntriesTest >();
             //            add< NamespaceDetailsTests::BigCollection >();
             add< NamespaceDetailsTests::Size >();
             add< NamespaceDetailsTests::SetIndexIsMultikey >();
+            add< NamespaceIndexTests::GrowsByExtensions >();
             add< NamespaceDetailsTransientTests::ClearQueryCache >();
             add< MissingFieldTests::BtreeIndexMissingField >();
             add< MissingFieldTests::TwoDIndexMissingField >();
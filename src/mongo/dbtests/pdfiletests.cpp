@@ -21,7 +21,9 @@
 #include "../db/pdfile.h"
 
 #include "../db/db.h"
+#include "../db/dbhelpers.h"
 #include "../db/json.h"
+#include "../db/warm_cache.h"
 
 #include "dbtests.h"
 
@@ -314,6 +316,29 @@ namespace PdfileTests {
                 ASSERT( 0 != o.getField( "a" ).date() );
             }
         };
+
+        class SeparateIndexFiles : public Base {
+        public:
+            SeparateIndexFiles() : _old( separateIndexFiles ) {
+                separateIndexFiles = true;
+            }
+            ~SeparateIndexFiles() {
+                separateIndexFiles = _old;
+            }
+            void run() {
+                BSONObj x = BSON( "a" << 1 );
+                theDataFileMgr.insertWithObjMod( ns(), x );
+                Helpers::ensureIndex( ns(), BSON( "a" << 1 ), false, "a_1" );
+
+                ASSERT( !ExtentManager::isIndexFile( nsd()->firstExtent().a() ) );
+                ASSERT_EQUALS( 2, nsd()->getCompletedIndexCount() );
+                for ( int i = 0; i < nsd()->getCompletedIndexCount(); i++ ) {
+                    ASSERT( ExtentManager::isIndexFile( nsd()->idx( i ).head.a() ) );
+                }
+            }
+        private:
+            bool _old;
+        };
     } // namespace Insert
 
     class ExtentSizing {
@@ -341,6 +366,51 @@ namespace PdfileTests {
         }
     };
 
+    class HotRegions : public Insert::Base {
+    public:
+        void run() {
+            BSONObj x = BSON( "x" << 1 );
+            theDataFileMgr.insertWithObjMod( ns(), x );
+            const DiskLoc loc = nsd()->firstRecord();
+            ASSERT( !loc.isNull() );
+
+            boost::scoped_ptr<HotRegionTracker> tracker( new HotRegionTracker() );
+            for ( int i = 0; i < 3; i++ ) {
+                tracker->noteAccess( loc.rec()->data(), false );
+            }
+
+            vector<HotRegionTracker::Region> regions;
+            tracker->takeHottest( &regions );
+            ASSERT_EQUALS( 3U, hitsCovering( regions, loc ) );
+
+            // each take halves the counts
+            tracker->takeHottest( &regions );
+            ASSERT_EQUALS( 1U, hitsCovering( regions, loc ) );
+
+            vector<HotRegionTracker::Region> loaded;
+            ASSERT( HotRegionTracker::fromBSON( HotRegionTracker::toBSON( regions ), &loaded ) );
+            ASSERT_EQUALS( regions.size(), loaded.size() );
+            ASSERT_EQUALS( 1U, hitsCovering( loaded, loc ) );
+
+            ASSERT( !HotRegionTracker::fromBSON( BSON( "version" << 2 ), &loaded ) );
+            ASSERT( loaded.empty() );
+        }
+    private:
+        static unsigned hitsCovering( const vector<HotRegionTracker::Region>& regions,
+                                      const DiskLoc& loc ) {
+            const string file = str::stream() << "unittests." << loc.a();
+            for ( size_t i = 0; i < regions.size(); i++ ) {
+                const HotRegionTracker::Region& r = regions[i];
+                if ( !r.index && str::endsWith( r.file, file ) &&
+                     r.ofs <= static_cast<unsigned>( loc.getOfs() ) &&
+                     static_cast<unsigned>( loc.getOfs() ) < r.ofs + r.len ) {
+                    return r.hits;
+                }
+            }
+            return 0;
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "pdfile" ) {}
@@ -361,7 +431,9 @@ namespace PdfileTests {
             add< ScanCapped::LastInExtent >();
             add< Insert::InsertAddId >();
             add< Insert::UpdateDate >();
+            add< Insert::SeparateIndexFiles >();
             add< ExtentSizing >();
+            add< HotRegions >();
         }
     } myall;
 
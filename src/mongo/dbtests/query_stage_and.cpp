@@ -231,6 +231,45 @@ namespace QueryStageAnd {
         }
     };
 
+    // An AND whose first child returns enough to grow the hash table many times, and whose
+    // second child mostly returns things the first didn't.
+    class AndHashLarge : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            for (int i = 0; i < 5000; ++i) {
+                insert(BSON("foo" << i << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL));
+
+            // foo <= 2000
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1));
+            params.startKey = BSON("" << 2000);
+            params.endKey = BSONObj();
+            params.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            // bar >= 1990
+            params.descriptor = getIndex(BSON("bar" << 1));
+            params.startKey = BSON("" << 1990);
+            params.endKey = BSONObj();
+            params.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            // 1990 <= foo == bar <= 2000.
+            ASSERT_EQUALS(11, countResults(ah.get()));
+        }
+    };
+
     // An AND with an index scan that returns nothing.
     class AndHashWithNothing : public QueryStageAndBase {
     public:
@@ -632,6 +671,7 @@ namespace QueryStageAnd {
         void setupTests() {
             add<AndHashInvalidation>();
             add<AndHashThreeLeaf>();
+            add<AndHashLarge>();
             add<AndHashWithNothing>();
             add<AndHashProducesNothing>();
             add<AndHashWithMatcher>();
@@ -375,6 +375,64 @@ namespace QueryStageFetch {
         }
     };
 
+    //
+    // Test that reading ahead keeps results in order and still passes fetches up.
+    //
+    class FetchStagePrefetch : public QueryStageFetchBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            WorkingSet ws;
+
+            // Add two objects to the DB.
+            insert(BSON("foo" << 5));
+            insert(BSON("foo" << 6));
+            set<DiskLoc> locs;
+            getLocs(&locs);
+            ASSERT_EQUALS(size_t(2), locs.size());
+
+            // Create a mock stage that returns a WSM for each.
+            auto_ptr<MockStage> mockStage(new MockStage(&ws));
+            for (set<DiskLoc>::const_iterator it = locs.begin(); it != locs.end(); ++it) {
+                WorkingSetMember mockMember;
+                mockMember.state = WorkingSetMember::LOC_AND_IDX;
+                mockMember.loc = *it;
+                mockStage->pushBack(mockMember);
+            }
+
+            auto_ptr<FetchStage> fetchStage(new FetchStage(&ws, mockStage.release(), NULL, 2));
+
+            // Set the fail point to return not in memory.
+            FailPointRegistry* reg = getGlobalFailPointRegistry();
+            FailPoint* fetchInMemoryFail = reg->getFailPoint("fetchInMemoryFail");
+            fetchInMemoryFail->setMode(FailPoint::alwaysOn);
+
+            WorkingSetID id;
+            PlanStage::StageState state;
+
+            // The first call only fills the lookahead.
+            state = fetchStage->work(&id);
+            ASSERT_EQUALS(PlanStage::NEED_TIME, state);
+
+            // Then each result is requested and returned in the order our child gave them.
+            for (set<DiskLoc>::const_iterator it = locs.begin(); it != locs.end(); ++it) {
+                state = fetchStage->work(&id);
+                ASSERT_EQUALS(PlanStage::NEED_FETCH, state);
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(*it, member->loc);
+                member->loc.rec()->touch();
+
+                state = fetchStage->work(&id);
+                ASSERT_EQUALS(PlanStage::ADVANCED, state);
+                ASSERT_EQUALS(WorkingSetMember::LOC_AND_UNOWNED_OBJ, ws.get(id)->state);
+            }
+
+            ASSERT_TRUE(fetchStage->isEOF());
+
+            fetchInMemoryFail->setMode(FailPoint::off);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_fetch" ) { }
@@ -385,6 +443,7 @@ namespace QueryStageFetch {
             add<FetchStageAlreadyFetched>();
             add<FetchStageInvalidation>();
             add<FetchStageFilter>();
+            add<FetchStagePrefetch>();
         }
     }  queryStageFetchAll;
 
@@ -80,12 +80,45 @@ namespace {
         }
     };
 
+    //
+    // The stats of a limit over a mock stage count each call and each result, in both stages.
+    //
+    class LimitSkipStatsTest {
+    public:
+        void run() {
+            WorkingSet ws;
+            scoped_ptr<PlanStage> limit(new LimitStage(10, &ws, getMS(&ws)));
+            ASSERT_EQUALS(10, countResults(limit.get()));
+            limit->prepareToYield();
+            limit->recoverFromYield();
+
+            scoped_ptr<PlanStageStats> stats(limit->getStats());
+            ASSERT_EQUALS("LIMIT", stats->stageType);
+            ASSERT_TRUE(stats->common.isEOF);
+            ASSERT_EQUALS(10U, stats->common.advanced);
+            ASSERT_EQUALS(1U, stats->common.yields);
+            ASSERT_EQUALS(1U, stats->common.unyields);
+
+            // The mock stage returns three stalls before every result after the first.
+            ASSERT_EQUALS(1U, stats->children.size());
+            const CommonStats& child = stats->children[0]->common;
+            ASSERT_EQUALS("MOCK", stats->children[0]->stageType);
+            ASSERT_EQUALS(10U, child.advanced);
+            ASSERT_EQUALS(2 * 10U - 1, child.needTime);
+            ASSERT_EQUALS(10U - 1, child.needFetch);
+            ASSERT_EQUALS(child.works, child.advanced + child.needTime + child.needFetch);
+            ASSERT_EQUALS(stats->common.works, child.works);
+            ASSERT_EQUALS(1U, child.yields);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_limit_skip" ) { }
 
         void setupTests() {
             add<LimitSkipBasicTest>();
+            add<LimitSkipStatsTest>();
         }
     }  queryStageLimitSkipAll;
 
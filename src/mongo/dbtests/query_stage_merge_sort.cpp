@@ -199,6 +199,67 @@ namespace QueryStageMergeSortTests {
         }
     };
 
+    // As above, but deduping by merging on DiskLoc within equal sort keys, remembering nothing.
+    class QueryStageMergeSortDupsByDiskLoc : public QueryStageMergeSortTestBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            const int N = 50;
+
+            // Two documents with each sort key, so ties have to be broken by DiskLoc.
+            for (int i = 0; i < N; ++i) {
+                insert(BSON("a" << 1 << "b" << 1 << "c" << i));
+                insert(BSON("a" << 1 << "b" << 1 << "c" << i));
+            }
+
+            BSONObj firstIndex = BSON("a" << 1 << "c" << 1);
+            BSONObj secondIndex = BSON("b" << 1 << "c" << 1);
+
+            addIndex(firstIndex);
+            addIndex(secondIndex);
+
+            SimplePlanRunner runner;
+            // Sort by c:1
+            MergeSortStageParams msparams;
+            msparams.pattern = BSON("c" << 1);
+            msparams.diskLocOrder = 1;
+            MergeSortStage* ms = new MergeSortStage(msparams, runner.getWorkingSet());
+
+            // a:1
+            IndexScanParams params;
+            params.descriptor = getIndex(firstIndex);
+            params.startKey = objWithMinKey(1);
+            params.endKey = objWithMaxKey(1);
+            params.endKeyInclusive = true;
+            params.direction = 1;
+            ms->addChild(new IndexScan(params, runner.getWorkingSet(), NULL));
+
+            // b:1
+            params.descriptor = getIndex(secondIndex);
+            ms->addChild(new IndexScan(params, runner.getWorkingSet(), NULL));
+
+            runner.setRoot(ms);
+
+            set<BSONObj> seen;
+            for (int i = 0; i < N; ++i) {
+                BSONObj first, second;
+                ASSERT(runner.getNext(&first));
+                ASSERT(runner.getNext(&second));
+                ASSERT_EQUALS(i, first["c"].numberInt());
+                ASSERT_EQUALS(i, second["c"].numberInt());
+                // Two different documents.
+                ASSERT(seen.insert(first["_id"].wrap()).second);
+                ASSERT(seen.insert(second["_id"].wrap()).second);
+            }
+
+            // Should be done now.
+            BSONObj foo;
+            ASSERT(!runner.getNext(&foo));
+            ASSERT_EQUALS(0U, ms->dedupMemUsage());
+        }
+    };
+
     // Each inserted document appears in both indices, no deduping, get each result twice.
     class QueryStageMergeSortDupsNoDedup : public QueryStageMergeSortTestBase {
     public:
@@ -528,6 +589,7 @@ namespace QueryStageMergeSortTests {
         void setupTests() {
             add<QueryStageMergeSortPrefixIndex>();
             add<QueryStageMergeSortDups>();
+            add<QueryStageMergeSortDupsByDiskLoc>();
             add<QueryStageMergeSortDupsNoDedup>();
             add<QueryStageMergeSortPrefixIndexReverse>();
             add<QueryStageMergeSortOneStageEOF>();
@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * This file tests db/exec/projection.cpp and db/exec/count.cpp.
+ */
+
+#include "mongo/db/exec/count.h"
+#include "mongo/db/exec/mock_stage.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/json.h"
+#include "mongo/dbtests/dbtests.h"
+
+using namespace mongo;
+
+namespace {
+
+    static const int N = 50;
+
+    /* A MockStage with N index results over {a: 1, b: 1} that have no DiskLoc.  Caller owns it. */
+    MockStage* getKeysMS(WorkingSet* ws) {
+        auto_ptr<MockStage> ms(new MockStage(ws));
+
+        for (int i = 0; i < N; ++i) {
+            ms->pushBack(PlanStage::NEED_TIME);
+            WorkingSetMember wsm;
+            wsm.state = WorkingSetMember::LOC_AND_IDX;
+            wsm.keyData.push_back(IndexKeyDatum(BSON("a" << 1 << "b" << 1),
+                                                BSON("" << i << "" << -i)));
+            ms->pushBack(wsm);
+        }
+
+        return ms.release();
+    }
+
+    //
+    // A projection of index key fields is built from the key without touching a document.
+    //
+    class ProjectionCovered {
+    public:
+        void run() {
+            WorkingSet ws;
+            ProjectionStage proj(fromjson("{a: 1, _id: 0}"), true, &ws, getKeysMS(&ws));
+
+            int count = 0;
+            while (!proj.isEOF()) {
+                WorkingSetID id;
+                if (PlanStage::ADVANCED != proj.work(&id)) { continue; }
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, member->state);
+                ASSERT_EQUALS(BSON("a" << count), member->obj);
+                ws.free(id);
+                ++count;
+            }
+            ASSERT_EQUALS(N, count);
+        }
+    };
+
+    //
+    // Results that aren't covered are projected from their objects.
+    //
+    class ProjectionFromObj {
+    public:
+        void run() {
+            WorkingSet ws;
+            auto_ptr<MockStage> ms(new MockStage(&ws));
+            WorkingSetMember wsm;
+            wsm.state = WorkingSetMember::OWNED_OBJ;
+            wsm.obj = fromjson("{_id: 1, a: 2, b: 3}");
+            ms->pushBack(wsm);
+
+            // Wants b, which the key doesn't have.
+            ProjectionStage proj(fromjson("{b: 1, _id: 0}"), true, &ws, ms.release());
+
+            WorkingSetID id;
+            ASSERT_EQUALS(PlanStage::ADVANCED, proj.work(&id));
+            ASSERT_EQUALS(BSON("b" << 3), ws.get(id)->obj);
+        }
+    };
+
+    //
+    // Without a loc, an index result that the projection doesn't cover fails.
+    //
+    class ProjectionNotCovered {
+    public:
+        void run() {
+            WorkingSet ws;
+            ProjectionStage notCovered(fromjson("{c: 1, _id: 0}"), true, &ws, getKeysMS(&ws));
+            WorkingSetID id;
+            ASSERT_EQUALS(PlanStage::NEED_TIME, notCovered.work(&id));
+            ASSERT_EQUALS(PlanStage::FAILURE, notCovered.work(&id));
+
+            // Nor is anything covered if the caller doesn't allow it.
+            ProjectionStage notAllowed(fromjson("{a: 1, _id: 0}"), false, &ws, getKeysMS(&ws));
+            ASSERT_EQUALS(PlanStage::NEED_TIME, notAllowed.work(&id));
+            ASSERT_EQUALS(PlanStage::FAILURE, notAllowed.work(&id));
+        }
+    };
+
+    //
+    // Count returns one result with the number of results its child produced.
+    //
+    class CountBasic {
+    public:
+        void run() {
+            WorkingSet ws;
+            CountStage count(&ws, getKeysMS(&ws));
+
+            int results = 0;
+            BSONObj countObj;
+            while (!count.isEOF()) {
+                WorkingSetID id;
+                if (PlanStage::ADVANCED != count.work(&id)) { continue; }
+                countObj = ws.get(id)->obj;
+                ws.free(id);
+                ++results;
+            }
+            ASSERT_EQUALS(1, results);
+            ASSERT_EQUALS(N, count.getCount());
+            ASSERT_EQUALS(BSON("n" << N), countObj);
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "query_stage_projection_count" ) { }
+
+        void setupTests() {
+            add<ProjectionCovered>();
+            add<ProjectionFromObj>();
+            add<ProjectionNotCovered>();
+            add<CountBasic>();
+        }
+    }  queryStageProjectionCountAll;
+
+}  // namespace
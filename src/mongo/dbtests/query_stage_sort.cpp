@@ -110,7 +110,9 @@ namespace QueryStageSortTests {
          * If extAllowed is true, sorting will use use external sorting if available.
          * If limit is not zero, we limit the output of the sort stage to 'limit' results.
          */
-        void sortAndCheck(int direction) {
+        void sortAndCheck(int direction, int limit = 0,
+                          size_t maxMemoryUsageBytes =
+                              SortStageParams::kDefaultMaxMemoryUsageBytes) {
             SimplePlanRunner runner;
             auto_ptr<MockStage> ms(new MockStage(runner.getWorkingSet()));
 
@@ -119,6 +121,8 @@ namespace QueryStageSortTests {
 
             SortStageParams params;
             params.pattern = BSON("foo" << direction);
+            params.limit = limit;
+            params.maxMemoryUsageBytes = maxMemoryUsageBytes;
 
             runner.setRoot(new SortStage(params, runner.getWorkingSet(), ms.release()));
 
@@ -127,6 +131,9 @@ namespace QueryStageSortTests {
             BSONObj last;
             ASSERT(runner.getNext(&last));
 
+            // The first result is the best of all of them.
+            ASSERT_EQUALS(direction > 0 ? 0 : numObj() - 1, last["foo"].numberInt());
+
             // Count 'last'.
             int count = 1;
 
@@ -140,8 +147,8 @@ namespace QueryStageSortTests {
                 last = current;
             }
 
-            // No limit, should get all objects back.
-            ASSERT_EQUALS(numObj(), count);
+            // Should get all objects back, or 'limit' of them.
+            ASSERT_EQUALS(0 == limit ? numObj() : std::min(limit, numObj()), count);
         }
 
         virtual int numObj() = 0;
@@ -189,6 +196,35 @@ namespace QueryStageSortTests {
         }
     };
 
+    // Sort with a limit, keeping only the best results.
+    class QueryStageSortLimit : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 10000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(1, 100);
+            sortAndCheck(-1, 100);
+            sortAndCheck(1, 1);
+            sortAndCheck(-1, 2 * numObj());
+        }
+    };
+
+    // Sort more than fits in the memory allowed, spilling through a Sorter.
+    class QueryStageSortSpill : public QueryStageSortTestBase {
+    public:
+        virtual int numObj() { return 10000; }
+
+        void run() {
+            Client::WriteContext ctx(ns());
+            fillData();
+            sortAndCheck(1, 0, 16 * 1024);
+            sortAndCheck(-1, 0, 16 * 1024);
+            sortAndCheck(1, 5000, 16 * 1024);
+        }
+    };
+
     // Invalidation of everything fed to sort.
     class QueryStageSortInvalidation : public QueryStageSortTestBase {
     public:
@@ -266,6 +302,8 @@ namespace QueryStageSortTests {
             add<QueryStageSortInc>();
             add<QueryStageSortDec>();
             add<QueryStageSortExt>();
+            add<QueryStageSortLimit>();
+            add<QueryStageSortSpill>();
             add<QueryStageSortInvalidation>();
         }
     }  queryStageSortTest;
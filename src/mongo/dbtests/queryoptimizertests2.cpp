@@ -30,6 +30,7 @@
 
 namespace mongo {
     extern void runQuery(Message& m, QueryMessage& q, Message &response );
+    extern int queryOptimizerMaxRacedPlans;
 } // namespace mongo
 
 namespace {
@@ -251,6 +252,33 @@ namespace {
             }
         };
 
+        /** With queryOptimizerMaxRacedPlans set, only the plans with the tightest bounds race. */
+        class PruneByEstimatedCost : public Base {
+        public:
+            void run() {
+                Helpers::ensureIndex( ns(), BSON( "a" << 1 ), false, "a_1" );
+                Helpers::ensureIndex( ns(), BSON( "b" << 1 ), false, "b_1" );
+                Helpers::ensureIndex( ns(), BSON( "c" << 1 ), false, "c_1" );
+                for( int i = 0; i < 300; ++i ) {
+                    BSONObj doc = BSON( "a" << i << "b" << 1 << "c" << i % 2 );
+                    theDataFileMgr.insertWithObjMod( ns(), doc );
+                }
+                BSONObj query = BSON( "a" << 5 << "b" << 1 << "c" << 1 );
+                ASSERT_EQUALS( 4, makeQps( query )->nPlans() );
+
+                queryOptimizerMaxRacedPlans = 1;
+                shared_ptr<QueryPlanSet> qps = makeQps( query );
+                ASSERT_EQUALS( 2, qps->nPlans() );
+                ASSERT_EQUALS( BSON( "a" << 1 ), qps->firstPlan()->indexKey() );
+
+                // An in order plan is kept in the race even if its bounds are wide.
+                qps = makeQps( query, BSON( "b" << 1 ) );
+                ASSERT_EQUALS( 2, qps->nPlans() );
+                ASSERT_EQUALS( BSON( "b" << 1 ), qps->firstPlan()->indexKey() );
+                queryOptimizerMaxRacedPlans = 0;
+            }
+        };
+
         class FindOne : public Base {
         public:
             void run() {
@@ -806,6 +834,7 @@ namespace {
             add<QueryPlanSetTests::Count>();
             add<QueryPlanSetTests::QueryMissingNs>();
             add<QueryPlanSetTests::UnhelpfulIndex>();
+            add<QueryPlanSetTests::PruneByEstimatedCost>();
             add<QueryPlanSetTests::FindOne>();
             add<QueryPlanSetTests::Delete>();
             add<QueryPlanSetTests::DeleteOneScan>();
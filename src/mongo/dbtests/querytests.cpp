@@ -1588,6 +1588,49 @@ namespace QueryTests {
             }
         };
 
+        /** Top level only projections give the same results whether or not the layout of a
+            document has been seen before. */
+        class TopLevelLayouts {
+        public:
+            void run() {
+                Projection m;
+                m.init( BSON( "b" << 1 << "d" << 1 ) );
+
+                BSONObj first = BSON( "_id" << 1 << "a" << 1 << "b" << 2 << "c" << 3 << "d" << 4 );
+                for ( int i = 0; i < 2; i++ ) {
+                    ASSERT_EQUALS( BSON( "_id" << 1 << "b" << 2 << "d" << 4 ),
+                                   m.transform( first ) );
+                }
+
+                // same ordinals, other names
+                ASSERT_EQUALS( BSON( "_id" << 1 << "d" << 4 ),
+                               m.transform( BSON( "_id" << 1 << "a" << 1 << "x" << 2 <<
+                                                  "c" << 3 << "d" << 4 ) ) );
+                // fields moved
+                ASSERT_EQUALS( BSON( "d" << 4 << "b" << 2 << "_id" << 1 ),
+                               m.transform( BSON( "d" << 4 << "b" << 2 << "_id" << 1 ) ) );
+                // field missing, then present past the end of the last layout
+                ASSERT_EQUALS( BSON( "_id" << 1 << "b" << 2 ),
+                               m.transform( BSON( "_id" << 1 << "a" << 1 << "b" << 2 ) ) );
+                ASSERT_EQUALS( BSON( "_id" << 1 << "b" << 2 << "d" << 4 ),
+                               m.transform( BSON( "_id" << 1 << "a" << 1 << "b" << 2 <<
+                                                  "c" << 3 << "e" << 5 << "d" << 4 ) ) );
+                // repeated field on a full pass
+                ASSERT_EQUALS( BSON( "_id" << 1 << "b" << 2 << "b" << 3 << "d" << 4 ),
+                               m.transform( BSON( "_id" << 1 << "b" << 2 << "b" << 3 <<
+                                                  "d" << 4 ) ) );
+                // back to the first layout
+                ASSERT_EQUALS( BSON( "_id" << 1 << "b" << 2 << "d" << 4 ),
+                               m.transform( first ) );
+
+                Projection noId;
+                noId.init( BSON( "_id" << 0 << "a" << 1 ) );
+                for ( int i = 0; i < 2; i++ ) {
+                    ASSERT_EQUALS( BSON( "a" << 1 ), noId.transform( first ) );
+                }
+            }
+        };
+
 
     }
     
@@ -1726,6 +1769,7 @@ namespace QueryTests {
             add< proj::K1 >();
             add< proj::K2 >();
             add< proj::K3 >();
+            add< proj::TopLevelLayouts >();
             
             add< ScanAndOrderTests::Unlimited >();
             add< ScanAndOrderTests::LimitOne >();
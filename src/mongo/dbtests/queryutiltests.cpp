@@ -291,6 +291,49 @@ namespace QueryUtilTests {
             BSONObj o1_, o2_;
         };
 
+        /** A large $in list is sorted and deduplicated, also when its bounds come cached. */
+        class LargeIn {
+        public:
+            void run() {
+                for( int pass = 0; pass < 2; ++pass ) {
+                    FieldRange range = inRange();
+                    ASSERT( range.mustBeExactMatchRepresentation() );
+                    const vector<FieldInterval>& intervals = range.intervals();
+                    ASSERT_EQUALS( static_cast<size_t>( Size ), intervals.size() );
+                    for( int i = 0; i < Size; ++i ) {
+                        ASSERT_EQUALS( i, intervals[ i ]._lower._bound.numberInt() );
+                        ASSERT( intervals[ i ].equality() );
+                    }
+                }
+                // a different list with the same length isn't mistaken for the cached one
+                BSONArrayBuilder other;
+                for( int i = 0; i < Size; ++i ) {
+                    other.append( -i );
+                }
+                BSONObj query = BSON( "a" << BSON( "$in" << other.arr() ) );
+                FieldRange range( query.firstElement().embeddedObject().firstElement(), false,
+                                  true );
+                ASSERT_EQUALS( -( Size - 1 ), range.min().numberInt() );
+                ASSERT_EQUALS( 0, range.max().numberInt() );
+            }
+        private:
+            static const int Size = 2000;
+            /**
+             * @return the range for a descending list with every value twice.  The query is
+             * gone by the time the range is used, so cached bounds must not point into it.
+             */
+            static FieldRange inRange() {
+                BSONArrayBuilder vals;
+                for( int i = Size - 1; i >= 0; --i ) {
+                    vals.append( i );
+                    vals.append( i );
+                }
+                BSONObj query = BSON( "a" << BSON( "$in" << vals.arr() ) );
+                return FieldRange( query.firstElement().embeddedObject().firstElement(), false,
+                                   true );
+            }
+        };
+
         class And : public Base {
         public:
             And() : _o1( BSON( "-" << 0 ) ), _o2( BSON( "-" << 10 ) ) {}
@@ -2891,6 +2934,7 @@ namespace QueryUtilTests {
             add<FieldRangeTests::RegexObj>();
             add<FieldRangeTests::UnhelpfulRegex>();
             add<FieldRangeTests::In>();
+            add<FieldRangeTests::LargeIn>();
             add<FieldRangeTests::And>();
             add<FieldRangeTests::SingletonOr>();
             add<FieldRangeTests::NestedSingletonOr>();
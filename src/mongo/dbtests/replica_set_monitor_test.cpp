@@ -584,6 +584,63 @@ namespace mongo_test {
         ASSERT(!host.empty());
     }
 
+    TEST(ReplSetMonitorReadPref, NearestLatencyAwareAvoidsBusyNode) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[0].addr;
+
+        nodes[0].pingTimeMillis = 1;
+        nodes[1].pingTimeMillis = 1;
+        nodes[2].pingTimeMillis = 1;
+        nodes[0].latencyMillis = 2;
+        nodes[1].latencyMillis = 2;
+        nodes[2].latencyMillis = 2;
+
+        // just as near, but swamped
+        nodes[1].inFlight = 50;
+
+        for (int i = 0; i < 100; i++) {
+            bool isPrimarySelected = true;
+            HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+                mongo::ReadPreference_Nearest, &tags, 3, &lastHost,
+                &isPrimarySelected, true);
+
+            ASSERT(!isPrimarySelected);
+            ASSERT_NOT_EQUALS("b", host.host());
+            ASSERT_EQUALS(host.host(), lastHost.host());
+        }
+    }
+
+    TEST(ReplSetMonitorReadPref, NearestLatencyAwarePrefersLocal) {
+        vector<ReplicaSetMonitor::Node> nodes =
+                NodeSetFixtures::getThreeMemberWithTags();
+        TagSet tags(TagSetFixtures::getDefaultSet());
+        HostAndPort lastHost = nodes[0].addr;
+
+        // c is the only local node even though it is the busiest
+        nodes[0].pingTimeMillis = 10;
+        nodes[1].pingTimeMillis = 20;
+        nodes[2].pingTimeMillis = 1;
+        nodes[2].inFlight = 10;
+
+        bool isPrimarySelected = true;
+        HostAndPort host = ReplicaSetMonitor::selectNode(nodes,
+            mongo::ReadPreference_Nearest, &tags, 3, &lastHost,
+            &isPrimarySelected, true);
+
+        ASSERT(!isPrimarySelected);
+        ASSERT_EQUALS("c", host.host());
+    }
+
+    TEST(ReplSetMonitorNode, NoteLatency) {
+        ReplicaSetMonitor::Node node(HostAndPort("a"), NULL);
+        node.noteLatency(8);
+        ASSERT_EQUALS(8, node.latencyMillis);
+        node.noteLatency(16);
+        ASSERT_EQUALS(10, node.latencyMillis);
+    }
+
     TEST(ReplSetMonitorReadPref, PriOnlyWithTagsNoMatch) {
         vector<ReplicaSetMonitor::Node> nodes =
                 NodeSetFixtures::getThreeMemberWithTags();
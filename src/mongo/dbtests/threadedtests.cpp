@@ -22,6 +22,7 @@
 #include "../bson/util/atomic_int.h"
 #include "../util/concurrency/mvar.h"
 #include "../util/concurrency/thread_pool.h"
+#include "../util/concurrency/work_stealing_pool.h"
 #include "../util/concurrency/list.h"
 #include "../util/timer.h"
 #include <boost/thread.hpp>
@@ -31,6 +32,7 @@
 #include "../util/concurrency/qlock.h"
 #include "dbtests.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/platform/atomic_word.h"
 
 namespace mongo { 
@@ -204,6 +206,15 @@ namespace ThreadedTests {
                             /*Lock::DBWrite x("foo");
                             Lock::DBWrite y("admin");
                             { Lock::TempRelease t; }*/
+                            Lock::CollectionWrite x("foo.a");
+                            ASSERT( Lock::isWriteLocked("foo.a") );
+                            if( sometimes ) {
+                                Lock::TempRelease t;
+                            }
+                            ASSERT( Lock::isWriteLocked("foo.b") );
+                            // nested collection lock on a different collection is a noop
+                            Lock::CollectionWrite y("foo.b");
+                            ASSERT( Lock::nested() );
                         }
                         else if( q == 3 ) {
                             Lock::DBWrite x("foo");
@@ -371,6 +382,48 @@ namespace ThreadedTests {
         }
     };
 
+    class WorkStealingPoolTest {
+        static const unsigned iterations = 10000;
+        static const unsigned nThreads = 8;
+
+        AtomicUInt32 counter;
+        void increment(unsigned n) {
+            for (unsigned i=0; i<n; i++) {
+                counter.fetchAndAdd(1);
+            }
+        }
+        void slowIncrement(unsigned millis) {
+            sleepmillis(millis);
+            counter.fetchAndAdd(1);
+        }
+
+    public:
+        void run() {
+            WorkStealingPool tp(nThreads);
+
+            for (unsigned i=0; i < iterations; i++) {
+                tp.schedule(&WorkStealingPoolTest::increment, this, 2);
+            }
+            tp.join();
+            ASSERT_EQUALS(counter.load(), iterations * 2);
+
+            // a batch whose slow tasks are all dealt to one worker, which the others steal from
+            vector<WorkStealingPool::Task> tasks;
+            for (unsigned i=0; i < nThreads * 4; i++) {
+                tasks.push_back(boost::bind(&WorkStealingPoolTest::slowIncrement, this,
+                                            i % nThreads == 0 ? 20 : 0));
+            }
+            tp.schedule(tasks);
+            tp.join();
+            ASSERT_EQUALS(tp.tasks_remaining(), 0);
+            ASSERT_EQUALS(counter.load(), iterations * 2 + nThreads * 4);
+
+            // an empty batch, and a pool that is destroyed while idle
+            tp.schedule(vector<WorkStealingPool::Task>());
+            tp.join();
+        }
+    };
+
     class LockTest {
     public:
         void run() {
@@ -893,6 +946,69 @@ namespace ThreadedTests {
         }
     };
 
+    // Microbenchmark: readers taking r for a moment each, against two writers taking W back to
+    // back.  Logs how long the acquisitions of each kind waited; readers must keep getting in
+    // between the writers rather than wait for both to run out of work.
+    class QLockContentionLatency : public ThreadedTest<10> {
+        enum { Writers = 2, RunMillis = 1000, WriteHoldMicros = 500 };
+    public:
+        QLockContentionLatency() : _stop(false) { }
+    private:
+        QLock _lock;
+        volatile bool _stop;
+        LatencyHistogram _readWaits;
+        LatencyHistogram _writeWaits;
+
+        virtual void subthread(int x) {
+            Client::initThread("qlockbench");
+            if( x == 1 ) {
+                sleepmillis(RunMillis);
+                _stop = true;
+            }
+            else if( x <= 1 + Writers ) {
+                while( !_stop ) {
+                    const unsigned long long start = curTimeMicros64();
+                    _lock.lock_W();
+                    _writeWaits.record(curTimeMicros64() - start);
+                    sleepmicros(WriteHoldMicros);
+                    _lock.unlock_W();
+                }
+            }
+            else {
+                while( !_stop ) {
+                    const unsigned long long start = curTimeMicros64();
+                    _lock.lock_r();
+                    _readWaits.record(curTimeMicros64() - start);
+                    _lock.unlock_r();
+                }
+            }
+            cc().shutdown();
+        }
+
+        virtual void validate() {
+            BSONObjBuilder b;
+            {
+                BSONObjBuilder r( b.subobjStart( "r" ) );
+                _readWaits.append( &r );
+                r.done();
+            }
+            {
+                BSONObjBuilder w( b.subobjStart( "W" ) );
+                _writeWaits.append( &w );
+                w.done();
+            }
+            const QLock::WaitStats rStats = _lock.waitStats('r');
+            b.append( "rSpinAcquisitions" , rStats.spinAcquisitions );
+            b.append( "rMaxWaitMicros" , rStats.maxWaitMicros );
+            mongo::unittest::log() << "qlock wait latencies (micros): " << b.obj() << endl;
+
+            ASSERT( _writeWaits.count() > 0 );
+            // with writers never letting up, readers only get in because each waits for just
+            // the writers queued ahead of it
+            ASSERT( _readWaits.count() > _writeWaits.count() );
+        }
+    };
+
     // Tests waiting on the TicketHolder by running many more threads than can fit into the "hotel", but only
     // max _nRooms threads should ever get in at once
     class TicketHolderWaits : public ThreadedTest<10> {
@@ -975,6 +1091,7 @@ namespace ThreadedTests {
             add< WriteLocksAreGreedy >();
             add< QLockTest >();
             add< QLockTest >();
+            add< QLockContentionLatency >();
 
             // Slack is a test to see how long it takes for another thread to pick up
             // and begin work after another relinquishes the lock.  e.g. a spin lock 
@@ -993,6 +1110,7 @@ namespace ThreadedTests {
             add< IsAtomicWordAtomic<AtomicUInt64> >();
             add< MVarTest >();
             add< ThreadPoolTest >();
+            add< WorkStealingPoolTest >();
             add< LockTest >();
 
 
@@ -0,0 +1,72 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_ptr.hpp>
+#include <sstream>
+#include <string>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/base/status.h"
+#include "mongo/logger/appender.h"
+#include "mongo/logger/async_log_writer.h"
+#include "mongo/logger/encoder.h"
+#include "mongo/logger/log_severity.h"
+
+namespace mongo {
+namespace logger {
+
+    /**
+     * Appender that encodes events on the calling thread and hands them to an AsyncLogWriter,
+     * which writes them out from its own thread.  Encoding stays here because events don't own
+     * their contents, and so that lines carry the time they were logged at.
+     *
+     * Severe events wait until they have been written, since a severe error is usually followed
+     * by the process exiting.
+     */
+    template <typename Event>
+    class AsyncAppender : public Appender<Event> {
+        MONGO_DISALLOW_COPYING(AsyncAppender);
+
+    public:
+        typedef Encoder<Event> EventEncoder;
+
+        /**
+         * Constructs an appender, that owns "encoder", but not "writer."  Caller must
+         * keep "writer" in scope at least as long as the constructed appender.
+         */
+        AsyncAppender(EventEncoder* encoder, AsyncLogWriter* writer) :
+            _encoder(encoder),
+            _writer(writer) {
+        }
+
+        virtual Status append(const Event& event) {
+            std::ostringstream os;
+            _encoder->encode(event, os);
+            std::string line = os.str();
+            _writer->write(&line);
+            if (event.getSeverity() >= LogSeverity::Severe())
+                _writer->flush();
+            return Status::OK();
+        }
+
+    private:
+        boost::scoped_ptr<EventEncoder> _encoder;
+        AsyncLogWriter* _writer;
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,239 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/logger/async_log_writer.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/thread/locks.hpp>
+#include <iostream>
+#include <set>
+
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace logger {
+
+namespace {
+    // Most lines the writer thread takes off the buffer before writing them out.
+    const size_t kMaxBatchSize = 256;
+
+    // How long the writer thread sleeps with nothing to write, at most; bounds how late it
+    // can be to notice a line whose push raced with it falling asleep.
+    const boost::posix_time::milliseconds kWriterIdleWait(10);
+
+    boost::mutex& writersMutex() {
+        static boost::mutex* mutex = new boost::mutex;
+        return *mutex;
+    }
+
+    std::set<AsyncLogWriter*>& writers() {
+        static std::set<AsyncLogWriter*>* writers = new std::set<AsyncLogWriter*>;
+        return *writers;
+    }
+
+    size_t roundUpToPowerOf2(size_t n) {
+        size_t result = 1;
+        while (result < n)
+            result <<= 1;
+        return result;
+    }
+}  // namespace
+
+    AsyncLogWriter::AsyncLogWriter(RotatableFileWriter* writer, FullPolicy policy,
+                                   size_t capacity) :
+        _writer(writer),
+        _policy(policy),
+        _capacity(roundUpToPowerOf2(std::max(capacity, size_t(2)))),
+        _slots(new Slot[_capacity]),
+        _popPosition(0),
+        _droppedReported(0) {
+
+        for (size_t i = 0; i < _capacity; ++i) {
+            _slots[i].sequence.store(i);
+        }
+        _thread = boost::thread(boost::bind(&AsyncLogWriter::_run, this));
+
+        boost::lock_guard<boost::mutex> lk(writersMutex());
+        writers().insert(this);
+    }
+
+    AsyncLogWriter::~AsyncLogWriter() {
+        {
+            boost::lock_guard<boost::mutex> lk(writersMutex());
+            writers().erase(this);
+        }
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _shutdown.store(1);
+            _wakeWriter.notify_one();
+        }
+        _thread.join();
+    }
+
+    void AsyncLogWriter::write(std::string* line) {
+        if (!_tryPush(line)) {
+            if (_policy == kDropWhenFull) {
+                _dropped.fetchAndAdd(1);
+                line->clear();
+                return;
+            }
+
+            _blocked.fetchAndAdd(1);
+            for (int attempt = 0; !_tryPush(line); ++attempt) {
+                if (attempt < 16)
+                    boost::this_thread::yield();
+                else
+                    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+            }
+        }
+
+        if (_writerAsleep.load()) {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _wakeWriter.notify_one();
+        }
+    }
+
+    void AsyncLogWriter::flush() {
+        // Lines are written in the order of the positions they were pushed at, all of them,
+        // so once the writer has written as many lines as had positions taken, everything
+        // pushed before now is out.
+        const unsigned long long target = _pushPosition.load();
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_written.load() < target) {
+            _wakeWriter.notify_one();
+            _lineWritten.timed_wait(lk, kWriterIdleWait);
+        }
+    }
+
+    void AsyncLogWriter::flushAll() {
+        boost::lock_guard<boost::mutex> lk(writersMutex());
+        for (std::set<AsyncLogWriter*>::const_iterator it = writers().begin();
+                it != writers().end(); ++it) {
+            (*it)->flush();
+        }
+    }
+
+    /*
+     * The buffer is a bounded queue in the style of Dmitry Vyukov's: every slot has a sequence
+     * number, which is the position a push may next fill it at, or that position plus one once
+     * the push has filled it.  Pushers claim a position with a compare and swap on
+     * _pushPosition, fill the slot and then publish it by moving its sequence on; the single
+     * popper takes a slot whose sequence says it's full and hands it back for the position
+     * one lap later.  Neither side ever waits for the other except when the buffer is full or
+     * empty.
+     */
+    bool AsyncLogWriter::_tryPush(std::string* line) {
+        unsigned long long position = _pushPosition.load();
+        while (true) {
+            Slot& slot = _slots[position & (_capacity - 1)];
+            const unsigned long long sequence = slot.sequence.load();
+            const long long difference = static_cast<long long>(sequence - position);
+            if (difference == 0) {
+                const unsigned long long claimed =
+                    _pushPosition.compareAndSwap(position, position + 1);
+                if (claimed == position) {
+                    slot.line.swap(*line);
+                    slot.sequence.store(position + 1);
+                    return true;
+                }
+                position = claimed;
+            }
+            else if (difference < 0) {
+                // The slot still holds the line from one lap ago: full.
+                return false;
+            }
+            else {
+                position = _pushPosition.load();
+            }
+        }
+    }
+
+    bool AsyncLogWriter::_tryPop(std::string* line) {
+        Slot& slot = _slots[_popPosition & (_capacity - 1)];
+        if (slot.sequence.load() != _popPosition + 1)
+            return false;
+        line->swap(slot.line);
+        slot.line.clear();
+        slot.sequence.store(_popPosition + _capacity);
+        ++_popPosition;
+        return true;
+    }
+
+    bool AsyncLogWriter::_hasLineToPop() const {
+        const Slot& slot = _slots[_popPosition & (_capacity - 1)];
+        return slot.sequence.load() == _popPosition + 1;
+    }
+
+    void AsyncLogWriter::_run() {
+        setThreadName("logWriter");
+        std::vector<std::string> batch;
+        std::string line;
+        while (true) {
+            // Read before draining, so that lines pushed before shutdown always get written.
+            const bool stopping = _shutdown.load();
+
+            while (batch.size() < kMaxBatchSize && _tryPop(&line)) {
+                batch.push_back(std::string());
+                batch.back().swap(line);
+            }
+            if (!batch.empty()) {
+                _writeBatch(batch);
+                batch.clear();
+                continue;
+            }
+            if (stopping)
+                return;
+
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            _writerAsleep.store(1);
+            if (!_hasLineToPop() && !_shutdown.load())
+                _wakeWriter.timed_wait(lk, kWriterIdleWait);
+            _writerAsleep.store(0);
+        }
+    }
+
+    void AsyncLogWriter::_writeBatch(const std::vector<std::string>& batch) {
+        {
+            RotatableFileWriter::Use useWriter(_writer);
+            if (useWriter.status().isOK()) {
+                std::ostream& os = useWriter.stream();
+                const unsigned long long dropped = _dropped.load();
+                if (dropped != _droppedReported) {
+                    char dateString[64];
+                    curTimeString(dateString);
+                    os << dateString << " [logWriter] " << dropped - _droppedReported <<
+                        " log lines dropped because the log buffer was full\n";
+                    _droppedReported = dropped;
+                }
+                for (std::vector<std::string>::const_iterator it = batch.begin();
+                        it != batch.end(); ++it) {
+                    os << *it;
+                }
+                os.flush();
+            }
+        }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _written.fetchAndAdd(batch.size());
+        _lineWritten.notify_all();
+    }
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,127 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/scoped_array.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+namespace logger {
+
+    class RotatableFileWriter;
+
+    /**
+     * Writes already encoded log lines to a RotatableFileWriter from a background thread, so
+     * that threads logging never wait on the file.
+     *
+     * Lines go through a bounded ring buffer that any number of threads push to without
+     * taking a lock, and that the writer thread drains in batches, taking the file's lock and
+     * flushing once per batch.  When the buffer is full, writes either wait for room or drop
+     * the line, depending on the FullPolicy; dropped lines are counted, and reported in the log
+     * once there is room again.
+     *
+     * Destroying the writer writes out everything already pushed.
+     */
+    class AsyncLogWriter {
+        MONGO_DISALLOW_COPYING(AsyncLogWriter);
+    public:
+        enum FullPolicy {
+            kBlockWhenFull,
+            kDropWhenFull
+        };
+
+        static const size_t kDefaultCapacity = 8192;
+
+        /**
+         * Starts the writer thread.  "writer" is not owned, and must outlive this object.
+         * "capacity" is the number of lines the buffer holds, and is rounded up to a power of 2.
+         */
+        AsyncLogWriter(RotatableFileWriter* writer, FullPolicy policy,
+                       size_t capacity = kDefaultCapacity);
+        ~AsyncLogWriter();
+
+        /**
+         * Queues "line" to be written, taking its contents; "line" is left empty.
+         */
+        void write(std::string* line);
+
+        /**
+         * Waits until every line queued before the call has been written.
+         */
+        void flush();
+
+        /**
+         * Flushes every AsyncLogWriter in the process.  Call before exiting without running
+         * destructors, so that the last lines logged aren't lost.
+         */
+        static void flushAll();
+
+        unsigned long long getWritten() const { return _written.load(); }
+        unsigned long long getDropped() const { return _dropped.load(); }
+        unsigned long long getBlocked() const { return _blocked.load(); }
+        size_t getCapacity() const { return _capacity; }
+
+    private:
+        struct Slot {
+            // The position this slot may be pushed at, or that plus one once it holds a line
+            // ready to pop; see _tryPush and _tryPop.
+            AtomicUInt64 sequence;
+            std::string line;
+        };
+
+        bool _tryPush(std::string* line);
+
+        // Only ever called by the writer thread.
+        bool _tryPop(std::string* line);
+        bool _hasLineToPop() const;
+
+        void _run();
+        void _writeBatch(const std::vector<std::string>& batch);
+
+        RotatableFileWriter* const _writer;
+        const FullPolicy _policy;
+        const size_t _capacity;
+        boost::scoped_array<Slot> _slots;
+
+        AtomicUInt64 _pushPosition;
+        unsigned long long _popPosition;  // Only used by the writer thread.
+
+        AtomicUInt64 _pushed;
+        AtomicUInt64 _written;
+        AtomicUInt64 _dropped;
+        AtomicUInt64 _blocked;
+        unsigned long long _droppedReported;  // Only used by the writer thread.
+
+        // Only used to put the writer thread to sleep when there is nothing to write, and to
+        // wake it and flush() callers; pushing never takes it unless the writer is asleep.
+        boost::mutex _mutex;
+        boost::condition _wakeWriter;
+        boost::condition _lineWritten;
+        AtomicUInt32 _writerAsleep;
+        AtomicUInt32 _shutdown;
+
+        boost::thread _thread;
+    };
+
+}  // namespace logger
+}  // namespace mongo
@@ -0,0 +1,142 @@
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "mongo/logger/async_log_writer.h"
+#include "mongo/logger/rotatable_file_writer.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+    using namespace mongo;
+    using namespace mongo::logger;
+
+    const std::string logFileName("LogTest_AsyncLogWriter.txt");
+
+    class AsyncLogWriterTest : public mongo::unittest::Test {
+    public:
+        AsyncLogWriterTest() {
+            unlink(logFileName.c_str());
+            RotatableFileWriter::Use writerUse(&fileWriter);
+            ASSERT_OK(writerUse.setFileName(logFileName, false));
+        }
+
+        virtual ~AsyncLogWriterTest() {
+            unlink(logFileName.c_str());
+        }
+
+        std::vector<std::string> readLines() {
+            std::vector<std::string> lines;
+            std::ifstream ifs(logFileName.c_str());
+            std::string input;
+            while (std::getline(ifs, input))
+                lines.push_back(input);
+            return lines;
+        }
+
+        RotatableFileWriter fileWriter;
+    };
+
+    void writeLines(AsyncLogWriter* writer, int thread, int count) {
+        for (int i = 0; i < count; ++i) {
+            std::ostringstream os;
+            os << thread << ' ' << i << '\n';
+            std::string line = os.str();
+            writer->write(&line);
+            ASSERT_TRUE(line.empty());
+        }
+    }
+
+    TEST_F(AsyncLogWriterTest, WritesInOrderAndFlushes) {
+        AsyncLogWriter writer(&fileWriter, AsyncLogWriter::kBlockWhenFull, 16);
+        ASSERT_EQUALS(16U, writer.getCapacity());
+        writeLines(&writer, 0, 1000);
+        writer.flush();
+        ASSERT_EQUALS(1000U, writer.getWritten());
+        ASSERT_EQUALS(0U, writer.getDropped());
+
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(1000U, lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::ostringstream expected;
+            expected << "0 " << i;
+            ASSERT_EQUALS(expected.str(), lines[i]);
+        }
+    }
+
+    TEST_F(AsyncLogWriterTest, ManyWritersBlockWhenFull) {
+        const int numThreads = 4;
+        const int linesPerThread = 2500;
+        {
+            AsyncLogWriter writer(&fileWriter, AsyncLogWriter::kBlockWhenFull, 60);
+            ASSERT_EQUALS(64U, writer.getCapacity());
+            std::vector<boost::thread*> threads;
+            for (int t = 0; t < numThreads; ++t) {
+                threads.push_back(new boost::thread(boost::bind(writeLines, &writer, t,
+                                                                linesPerThread)));
+            }
+            for (int t = 0; t < numThreads; ++t) {
+                threads[t]->join();
+                delete threads[t];
+            }
+            // Destroying the writer writes out what is still queued.
+        }
+
+        std::vector<std::string> lines = readLines();
+        ASSERT_EQUALS(static_cast<size_t>(numThreads * linesPerThread), lines.size());
+        std::vector<int> next(numThreads, 0);
+        for (size_t i = 0; i < lines.size(); ++i) {
+            std::istringstream is(lines[i]);
+            int thread;
+            int n;
+            is >> thread >> n;
+            ASSERT_EQUALS(next[thread], n);
+            ++next[thread];
+        }
+    }
+
+    TEST_F(AsyncLogWriterTest, DropWhenFullCountsDrops) {
+        const int numLines = 10000;
+        AsyncLogWriter writer(&fileWriter, AsyncLogWriter::kDropWhenFull, 2);
+        writeLines(&writer, 0, numLines);
+        writer.flush();
+        ASSERT_EQUALS(static_cast<unsigned long long>(numLines),
+                      writer.getWritten() + writer.getDropped());
+
+        // Lines that made it are in order, with a note wherever some were dropped.
+        std::vector<std::string> lines = readLines();
+        int last = -1;
+        size_t written = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (lines[i].find("log lines dropped") != std::string::npos)
+                continue;
+            std::istringstream is(lines[i]);
+            int thread;
+            int n;
+            is >> thread >> n;
+            ASSERT_LESS_THAN(last, n);
+            last = n;
+            ++written;
+        }
+        ASSERT_EQUALS(writer.getWritten(), written);
+    }
+
+}  // namespace
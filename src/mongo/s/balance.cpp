@@ -18,6 +18,8 @@
 
 #include "mongo/s/balance.h"
 
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/client/distlock.h"
 #include "mongo/db/cmdline.h"
@@ -44,79 +46,148 @@ namespace mongo {
     Balancer::~Balancer() {
     }
 
-    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+    bool Balancer::_moveChunk(const CandidateChunk& chunkInfo,
                               bool secondaryThrottle,
                               bool waitForDelete)
     {
-        int movedCount = 0;
 
-        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
-            const CandidateChunk& chunkInfo = *it->get();
+        // Changes to metadata, borked metadata, and connectivity problems should cause us to
+        // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
+        // TODO: Handle all these things more cleanly, since they're expected problems
+        try {
 
-            // Changes to metadata, borked metadata, and connectivity problems should cause us to
-            // abort this chunk move, but shouldn't cause us to abort the entire round of chunks.
-            // TODO: Handle all these things more cleanly, since they're expected problems
-            try {
+            DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
+            verify( cfg );
 
-                DBConfigPtr cfg = grid.getDBConfig( chunkInfo.ns );
-                verify( cfg );
+            // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
+            // tried to do so once.
+            ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            verify( cm );
 
-                // NOTE: We purposely do not reload metadata here, since _doBalanceRound already
-                // tried to do so once.
-                ChunkManagerPtr cm = cfg->getChunkManager( chunkInfo.ns );
+            ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
+                // likely a split happened somewhere
+                cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
                 verify( cm );
 
-                ChunkPtr c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
                 if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                    // likely a split happened somewhere
-                    cm = cfg->getChunkManager( chunkInfo.ns , true /* reload */);
-                    verify( cm );
+                    log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
+                    return false;
+                }
+            }
 
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
-                    if ( c->getMin().woCompare( chunkInfo.chunk.min ) || c->getMax().woCompare( chunkInfo.chunk.max ) ) {
-                        log() << "chunk mismatch after reload, ignoring will retry issue " << chunkInfo.chunk.toString() << endl;
-                        continue;
+            BSONObj res;
+            if (c->moveAndCommit(Shard::make(chunkInfo.to),
+                                 Chunk::MaxChunkSize,
+                                 secondaryThrottle,
+                                 waitForDelete,
+                                 res)) {
+                return true;
+            }
+
+            // the move requires acquiring the collection metadata's lock, which can fail
+            log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
+                  << " chunk: " << chunkInfo.chunk << endl;
+
+            if ( res["chunkTooBig"].trueValue() ) {
+                // reload just to be safe
+                cm = cfg->getChunkManager( chunkInfo.ns );
+                verify( cm );
+                c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+
+                log() << "forcing a split because migrate failed for size reasons" << endl;
+
+                // the donor may already have found where to cut the chunk into movable pieces
+                vector<BSONObj> splitKeys;
+                if ( res["splitKeys"].type() == Array ) {
+                    BSONObjIterator it( res["splitKeys"].Obj() );
+                    while ( it.more() ) {
+                        splitKeys.push_back( it.next().Obj().getOwned() );
                     }
                 }
 
-                BSONObj res;
-                if (c->moveAndCommit(Shard::make(chunkInfo.to),
-                                     Chunk::MaxChunkSize,
-                                     secondaryThrottle,
-                                     waitForDelete,
-                                     res)) {
-                    movedCount++;
-                    continue;
+                res = BSONObj();
+                if ( splitKeys.empty() || ! c->multiSplit( splitKeys , res ) ) {
+                    res = BSONObj();
+                    c->singleSplit( true , res );
                 }
+                log() << "forced split results: " << res << endl;
 
-                // the move requires acquiring the collection metadata's lock, which can fail
-                log() << "balancer move failed: " << res << " from: " << chunkInfo.from << " to: " << chunkInfo.to
-                      << " chunk: " << chunkInfo.chunk << endl;
+                if ( ! res["ok"].trueValue() ) {
+                    log() << "marking chunk as jumbo: " << c->toString() << endl;
+                    c->markAsJumbo();
+                    // we count this as moved so we do another round right away
+                    return true;
+                }
 
-                if ( res["chunkTooBig"].trueValue() ) {
-                    // reload just to be safe
-                    cm = cfg->getChunkManager( chunkInfo.ns );
-                    verify( cm );
-                    c = cm->findIntersectingChunk( chunkInfo.chunk.min );
+            }
+        }
+        catch( const DBException& ex ) {
+            warning() << "could not move chunk " << chunkInfo.chunk.toString()
+                      << ", continuing balancing round" << causedBy( ex ) << endl;
+        }
 
-                    log() << "forcing a split because migrate failed for size reasons" << endl;
+        return false;
+    }
 
-                    res = BSONObj();
-                    c->singleSplit( true , res );
-                    log() << "forced split results: " << res << endl;
+    namespace {
+        /**
+         * Runs one migration of a wave on its own thread, recording whether it counted as moved.
+         */
+        void moveChunkThread(const boost::function<bool()>& move, int* moved) {
+            setThreadName("BalancerMigrate");
+            try {
+                *moved = move() ? 1 : 0;
+            }
+            catch ( std::exception& e ) {
+                warning() << "balancer migration thread caught exception: " << e.what() << endl;
+            }
+        }
+    }
 
-                    if ( ! res["ok"].trueValue() ) {
-                        log() << "marking chunk as jumbo: " << c->toString() << endl;
-                        c->markAsJumbo();
-                        // we increment moveCount so we do another round right away
-                        movedCount++;
-                    }
+    int Balancer::_moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                              int maxConcurrentMigrations,
+                              bool secondaryThrottle,
+                              bool waitForDelete)
+    {
+        int movedCount = 0;
 
-                }
+        vector<const CandidateChunk*> migrations;
+        for ( vector<CandidateChunkPtr>::const_iterator it = candidateChunks->begin(); it != candidateChunks->end(); ++it ) {
+            migrations.push_back( it->get() );
+        }
+
+        vector< vector<const CandidateChunk*> > waves =
+            BalancerPolicy::groupDisjointMigrations( migrations, max( 1, maxConcurrentMigrations ) );
+
+        for ( size_t w = 0; w < waves.size(); w++ ) {
+            const vector<const CandidateChunk*>& wave = waves[w];
+
+            if ( wave.size() == 1 ) {
+                if ( _moveChunk( *wave[0], secondaryThrottle, waitForDelete ) )
+                    movedCount++;
+                continue;
+            }
+
+            LOG(1) << "running " << wave.size() << " migrations concurrently" << endl;
+
+            // no two migrations in a wave share a shard, and each is in a different collection,
+            // so neither the shards' single migration slots nor the collection locks conflict
+            vector<int> moved( wave.size(), 0 );
+            boost::thread_group threads;
+            for ( size_t i = 0; i < wave.size(); i++ ) {
+                boost::function<bool()> move = boost::bind( &Balancer::_moveChunk,
+                                                            this,
+                                                            boost::cref( *wave[i] ),
+                                                            secondaryThrottle,
+                                                            waitForDelete );
+                threads.create_thread( boost::bind( moveChunkThread, move, &moved[i] ) );
             }
-            catch( const DBException& ex ) {
-                warning() << "could not move chunk " << chunkInfo.chunk.toString()
-                          << ", continuing balancing round" << causedBy( ex ) << endl;
+            threads.join_all();
+
+            for ( size_t i = 0; i < moved.size(); i++ ) {
+                movedCount += moved[i];
             }
         }
 
@@ -189,7 +260,9 @@ namespace mongo {
         }        
     }
 
-    void Balancer::_doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks ) {
+    void Balancer::_doBalanceRound( DBClientBase& conn,
+                                    bool byLoad,
+                                    vector<CandidateChunkPtr>* candidateChunks ) {
         verify( candidateChunks );
 
         //
@@ -239,13 +312,29 @@ namespace mongo {
         for ( vector<Shard>::const_iterator it = allShards.begin(); it != allShards.end(); ++it ) {
             const Shard& s = *it;
             ShardStatus status = s.getStatus();
-            shardInfo[ s.getName() ] = ShardInfo( s.getMaxSize(),
-                                                  status.mapped(),
-                                                  s.isDraining(),
-                                                  status.hasOpsQueued(),
-                                                  s.tags(),
-                                                  status.mongoVersion()
-                                                  );
+            ShardInfo& info = shardInfo[ s.getName() ];
+            info = ShardInfo( s.getMaxSize(),
+                              status.mapped(),
+                              s.isDraining(),
+                              status.hasOpsQueued(),
+                              s.tags(),
+                              status.mongoVersion()
+                              );
+
+            // ops/sec is measured between rounds, so the first round after a restart or
+            // after the shard restarted only has memory and size to go on
+            const unsigned long long now = curTimeMillis64();
+            double opsPerSec = 0;
+            map< string, pair<long long, unsigned long long> >::const_iterator last =
+                _lastOpCounts.find( s.getName() );
+            if ( last != _lastOpCounts.end()
+                    && status.opsTotal() >= last->second.first && now > last->second.second ) {
+                opsPerSec = ( status.opsTotal() - last->second.first ) * 1000.0
+                            / ( now - last->second.second );
+            }
+            _lastOpCounts[ s.getName() ] = make_pair( status.opsTotal(), now );
+
+            info.setLoad( status.resident(), opsPerSec );
         }
 
         OCCASIONALLY warnOnMultiVersion( shardInfo );
@@ -356,7 +445,7 @@ namespace mongo {
                 continue;
             }
 
-            CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime );
+            CandidateChunk* p = _policy->balance( ns, status, _balancedLastTime, byLoad );
             if ( p ) candidateChunks->push_back( CandidateChunkPtr( p ) );
         }
     }
@@ -480,17 +569,32 @@ namespace mongo {
                         secondaryThrottle = balancerConfig[SettingsType::secondaryThrottle()].trueValue();
                     }
 
+                    int maxConcurrentMigrations =
+                        SettingsType::maxConcurrentMigrations.getDefault();
+                    if ( balancerConfig[SettingsType::maxConcurrentMigrations()].isNumber() ) {
+                        maxConcurrentMigrations =
+                            balancerConfig[SettingsType::maxConcurrentMigrations()].numberInt();
+                    }
+
+                    bool balanceByLoad = SettingsType::balanceByLoad.getDefault();
+                    if ( balancerConfig[SettingsType::balanceByLoad()].type() ) {
+                        balanceByLoad = balancerConfig[SettingsType::balanceByLoad()].trueValue();
+                    }
+
                     LOG(1) << "waitForDelete: " << waitForDelete << endl;
                     LOG(1) << "secondaryThrottle: " << secondaryThrottle << endl;
+                    LOG(1) << "maxConcurrentMigrations: " << maxConcurrentMigrations << endl;
+                    LOG(1) << "balanceByLoad: " << balanceByLoad << endl;
 
                     vector<CandidateChunkPtr> candidateChunks;
-                    _doBalanceRound( conn.conn() , &candidateChunks );
+                    _doBalanceRound( conn.conn() , balanceByLoad , &candidateChunks );
                     if ( candidateChunks.size() == 0 ) {
                         LOG(1) << "no need to move any chunk" << endl;
                         _balancedLastTime = 0;
                     }
                     else {
                         _balancedLastTime = _moveChunks(&candidateChunks,
+                                                        maxConcurrentMigrations,
                                                         secondaryThrottle,
                                                         waitForDelete );
                     }
@@ -33,7 +33,8 @@ namespace mongo {
      *
      * The balancer does act continuously but in "rounds". At a given round, it would decide if there is an imbalance by
      * checking the difference in chunks between the most and least loaded shards. It would issue a request for a chunk
-     * migration per round, if it found so.
+     * migration per collection per round, if it found so, running migrations between disjoint pairs of shards
+     * concurrently.
      */
     class Balancer : public BackgroundJob {
     public:
@@ -61,6 +62,9 @@ namespace mongo {
 
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
+
+        // per shard, the op count and time (millis) it reported last round, for ops/sec
+        map< string, pair<long long, unsigned long long> > _lastOpCounts;
         
         /**
          * Checks that the balancer can connect to all servers it needs to do its job.
@@ -76,19 +80,34 @@ namespace mongo {
          * be moved.
          *
          * @param conn is the connection with the config server(s)
+         * @param byLoad also even out shard load once chunk counts are even
          * @param candidateChunks (IN/OUT) filled with candidate chunks, one per collection, that could possibly be moved
          */
-        void _doBalanceRound( DBClientBase& conn, vector<CandidateChunkPtr>* candidateChunks );
+        void _doBalanceRound( DBClientBase& conn,
+                              bool byLoad,
+                              vector<CandidateChunkPtr>* candidateChunks );
 
         /**
-         * Issues chunk migration request, one at a time.
+         * Issues chunk migration requests.  Migrations between disjoint pairs of shards run
+         * concurrently, up to maxConcurrentMigrations at a time.
          *
-         * @param candidateChunks possible chunks to move
+         * @param candidateChunks possible chunks to move, at most one per collection
+         * @param maxConcurrentMigrations most migrations to have in flight at once
          * @param secondaryThrottle wait for secondaries to catch up before pushing more deletes
          * @param waitForDelete wait for deletes to complete after each chunk move
          * @return number of chunks effectively moved
          */
         int _moveChunks(const vector<CandidateChunkPtr>* candidateChunks,
+                        int maxConcurrentMigrations,
+                        bool secondaryThrottle,
+                        bool waitForDelete);
+
+        /**
+         * Issues a single chunk migration request.  Does not throw.
+         *
+         * @return true if the chunk moved, or was marked jumbo so another round should follow
+         */
+        bool _moveChunk(const CandidateChunk& chunkInfo,
                         bool secondaryThrottle,
                         bool waitForDelete);
 
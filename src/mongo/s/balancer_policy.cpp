@@ -30,12 +30,24 @@ namespace mongo {
         return str::stream() << min << " -->> " << max << "  on  " << tag;
     }
 
+    const double BalancerPolicy::kLoadImbalanceRatio = 1.25;
+
     DistributionStatus::DistributionStatus( const ShardInfoMap& shardInfo,
                                             const ShardToChunksMap& shardToChunksMap )
-        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ) {
+        : _shardInfo( shardInfo ), _shardChunks( shardToChunksMap ),
+          _meanSize( 0 ), _meanResidentSize( 0 ), _meanOpsPerSec( 0 ) {
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
             _shards.insert( i->first );
+            _meanSize += i->second.getCurrSize();
+            _meanResidentSize += i->second.getResidentSize();
+            _meanOpsPerSec += i->second.getOpsPerSec();
+        }
+
+        if ( ! _shardInfo.empty() ) {
+            _meanSize /= _shardInfo.size();
+            _meanResidentSize /= _shardInfo.size();
+            _meanOpsPerSec /= _shardInfo.size();
         }
     }
 
@@ -72,30 +84,39 @@ namespace mongo {
         return total;
     }
 
+    bool DistributionStatus::_canReceive( const string& shard,
+                                          const ShardInfo& info,
+                                          const string& tag ) const {
+        if ( info.isSizeMaxed() ) {
+            LOG(1) << shard << " has already reached the maximum total chunk size." << endl;
+            return false;
+        }
+
+        if ( info.isDraining() ) {
+            LOG(1) << shard << " is currently draining." << endl;
+            return false;
+        }
+
+        if ( info.hasOpsQueued() ) {
+            LOG(1) << shard << " has writebacks queued." << endl;
+            return false;
+        }
+
+        if ( ! info.hasTag( tag ) ) {
+            LOG(1) << shard << " doesn't have right tag" << endl;
+            return false;
+        }
+
+        return true;
+    }
+
     string DistributionStatus::getBestReceieverShard( const string& tag ) const {
         string best;
         unsigned minChunks = numeric_limits<unsigned>::max();
 
         for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
-            if ( i->second.isSizeMaxed() ) {
-                LOG(1) << i->first << " has already reached the maximum total chunk size." << endl;
-                continue;
-            }
-
-            if ( i->second.isDraining() ) {
-                LOG(1) << i->first << " is currently draining." << endl;
+            if ( ! _canReceive( i->first, i->second, tag ) )
                 continue;
-            }
-
-            if ( i->second.hasOpsQueued() ) {
-                LOG(1) << i->first << " has writebacks queued." << endl;
-                continue;
-            }
-
-            if ( ! i->second.hasTag( tag ) ) {
-                LOG(1) << i->first << " doesn't have right tag" << endl;
-                continue;
-            }
 
             unsigned myChunks = numberOfChunksInShard( i->first );
             if ( myChunks >= minChunks ) {
@@ -132,6 +153,60 @@ namespace mongo {
         return worst;
     }
 
+    double DistributionStatus::loadOf( const string& shard ) const {
+        const ShardInfo& info = shardInfo( shard );
+
+        double load = 0;
+        if ( _meanSize > 0 )
+            load += info.getCurrSize() / _meanSize;
+        if ( _meanResidentSize > 0 )
+            load += info.getResidentSize() / _meanResidentSize;
+        if ( _meanOpsPerSec > 0 )
+            load += info.getOpsPerSec() / _meanOpsPerSec;
+        return load;
+    }
+
+    string DistributionStatus::getMostLoadedShard( const string& tag ) const {
+        string worst;
+        double maxLoad = -1;
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+            if ( i->second.hasOpsQueued() )
+                continue;
+
+            if ( numberOfChunksInShardWithTag( i->first, tag ) == 0 )
+                continue;
+
+            double myLoad = loadOf( i->first );
+            if ( myLoad <= maxLoad )
+                continue;
+
+            worst = i->first;
+            maxLoad = myLoad;
+        }
+
+        return worst;
+    }
+
+    string DistributionStatus::getLeastLoadedReceiver( const string& tag ) const {
+        string best;
+        double minLoad = numeric_limits<double>::max();
+
+        for ( ShardInfoMap::const_iterator i = _shardInfo.begin(); i != _shardInfo.end(); ++i ) {
+            if ( ! _canReceive( i->first, i->second, tag ) )
+                continue;
+
+            double myLoad = loadOf( i->first );
+            if ( myLoad >= minLoad )
+                continue;
+
+            best = i->first;
+            minLoad = myLoad;
+        }
+
+        return best;
+    }
+
     const vector<BSONObj>& DistributionStatus::getChunks( const string& shard ) const {
         ShardToChunksMap::const_iterator i = _shardChunks.find(shard);
         verify( i != _shardChunks.end() );
@@ -211,6 +286,39 @@ namespace mongo {
         }
     }
 
+    vector< vector<const MigrateInfo*> > BalancerPolicy::groupDisjointMigrations(
+            const vector<const MigrateInfo*>& migrations,
+            size_t maxPerWave ) {
+        verify( maxPerWave > 0 );
+
+        vector< vector<const MigrateInfo*> > waves;
+        vector< set<string> > busyShards; // parallels waves
+
+        for ( size_t i = 0; i < migrations.size(); i++ ) {
+            const MigrateInfo* migration = migrations[i];
+
+            // first fit: the earliest wave with room where neither shard is busy yet
+            size_t wave = 0;
+            for ( ; wave < waves.size(); wave++ ) {
+                if ( waves[wave].size() < maxPerWave &&
+                     busyShards[wave].count( migration->from ) == 0 &&
+                     busyShards[wave].count( migration->to ) == 0 )
+                    break;
+            }
+
+            if ( wave == waves.size() ) {
+                waves.push_back( vector<const MigrateInfo*>() );
+                busyShards.push_back( set<string>() );
+            }
+
+            waves[wave].push_back( migration );
+            busyShards[wave].insert( migration->from );
+            busyShards[wave].insert( migration->to );
+        }
+
+        return waves;
+    }
+
     bool BalancerPolicy::_isJumbo( const BSONObj& chunk ) {
         if ( chunk[ChunkType::jumbo()].trueValue() ) {
             LOG(1) << "chunk: " << chunk << "is marked as jumbo" << endl;
@@ -218,15 +326,61 @@ namespace mongo {
         }
         return false;
     }
+
+    MigrateInfo* BalancerPolicy::_balanceLoad( const string& ns,
+                                               const DistributionStatus& distribution,
+                                               const string& tag,
+                                               int threshold ) {
+        string from = distribution.getMostLoadedShard( tag );
+        string to = distribution.getLeastLoadedReceiver( tag );
+        if ( from.size() == 0 || to.size() == 0 || from == to )
+            return NULL;
+
+        const double fromLoad = distribution.loadOf( from );
+        const double toLoad = distribution.loadOf( to );
+        if ( fromLoad < kLoadImbalanceRatio * toLoad )
+            return NULL;
+
+        // nothing tells us how the load splits between chunks, so say evenly; the move has to
+        // leave the receiver below where the donor is now
+        const double chunkLoad = fromLoad / distribution.numberOfChunksInShard( from );
+        if ( toLoad + chunkLoad >= fromLoad )
+            return NULL;
+
+        const int fromChunks = distribution.numberOfChunksInShardWithTag( from, tag );
+        const int toChunks = distribution.numberOfChunksInShardWithTag( to, tag );
+        if ( ( toChunks + 1 ) - ( fromChunks - 1 ) >= threshold )
+            return NULL;
+
+        const vector<BSONObj>& chunks = distribution.getChunks( from );
+        for ( unsigned j = 0; j < chunks.size(); j++ ) {
+            if ( distribution.getTagForChunk( chunks[j] ) != tag )
+                continue;
+
+            if ( _isJumbo( chunks[j] ) )
+                continue;
+
+            log() << " ns: " << ns << " going to move " << chunks[j]
+                  << " from: " << from << " (load " << fromLoad << ")"
+                  << " to: " << to << " (load " << toLoad << ")"
+                  << " tag [" << tag << "]" << endl;
+            return new MigrateInfo( ns, to, from, chunks[j] );
+        }
+
+        return NULL;
+    }
+
     MigrateInfo* BalancerPolicy::balance( const string& ns,
                                           const DistributionStatus& distribution,
-                                          int balancedLastTime ) {
+                                          int balancedLastTime,
+                                          bool byLoad ) {
 
 
         // 1) check for shards that policy require to us to move off of:
         //    draining only
         // 2) check tag policy violations
         // 3) then we make sure chunks are balanced for each tag
+        // 4) if asked to, then even out load for each tag
 
         // ----
 
@@ -322,8 +476,10 @@ namespace mongo {
 
         // 3) for each tag balance
 
+        // moves for load leave chunk counts up to the threshold apart, so it can't tighten
+        // after a busy round or the count balancing would undo them
         int threshold = 8;
-        if ( balancedLastTime || distribution.totalChunks() < 20 )
+        if ( ( balancedLastTime && ! byLoad ) || distribution.totalChunks() < 20 )
             threshold = 2;
         else if ( distribution.totalChunks() < 80 )
             threshold = 4;
@@ -397,6 +553,15 @@ namespace mongo {
             verify( false ); // should be impossible
         }
 
+        // 4) chunk counts are even, now look at load
+        if ( byLoad ) {
+            for ( unsigned i=0; i<tags.size(); i++ ) {
+                MigrateInfo* m = _balanceLoad( ns, distribution, tags[i], threshold );
+                if ( m )
+                    return m;
+            }
+        }
+
         // Everything is balanced here!
         return NULL;
     }
@@ -411,14 +576,18 @@ namespace mongo {
           _draining( draining ),
           _hasOpsQueued( opsQueued ),
           _tags( tags ),
-          _mongoVersion( mongoVersion ) {
+          _mongoVersion( mongoVersion ),
+          _residentSize( 0 ),
+          _opsPerSec( 0 ) {
     }
 
     ShardInfo::ShardInfo()
         : _maxSize( 0 ),
           _currSize( 0 ),
           _draining( false ),
-          _hasOpsQueued( false ) {
+          _hasOpsQueued( false ),
+          _residentSize( 0 ),
+          _opsPerSec( 0 ) {
     }
 
     void ShardInfo::addTag( const string& tag ) {
@@ -445,6 +614,8 @@ namespace mongo {
         ss << " currSize: " << _currSize;
         ss << " draining: " << _draining;
         ss << " hasOpsQueued: " << _hasOpsQueued;
+        ss << " residentSize: " << _residentSize;
+        ss << " opsPerSec: " << _opsPerSec;
         if ( _tags.size() > 0 ) {
             ss << "tags : ";
             for ( set<string>::const_iterator i = _tags.begin(); i != _tags.end(); ++i )
@@ -89,6 +89,20 @@ namespace mongo {
 
         string getMongoVersion() const { return _mongoVersion; }
 
+        /**
+         * Sets what the shard reported about how busy it is, for load aware balancing.
+         * @param residentSize resident memory in MB
+         * @param opsPerSec operations per second since the previous balancing round, 0 if unknown
+         */
+        void setLoad( long long residentSize, double opsPerSec ) {
+            _residentSize = residentSize;
+            _opsPerSec = opsPerSec;
+        }
+
+        long long getResidentSize() const { return _residentSize; }
+
+        double getOpsPerSec() const { return _opsPerSec; }
+
         string toString() const;
         
     private:
@@ -98,6 +112,8 @@ namespace mongo {
         bool _hasOpsQueued;
         set<string> _tags;
         string _mongoVersion;
+        long long _residentSize;
+        double _opsPerSec;
     };
     
     struct MigrateInfo {
@@ -141,6 +157,23 @@ namespace mongo {
          */
         string getMostOverloadedShard( const string& forTag ) const;
 
+        /**
+         * @return how loaded the shard is compared to the others: the sum of its data size,
+         *         resident memory and ops/sec, each divided by that metric's mean over all
+         *         shards.  Metrics no shard reported are left out.
+         */
+        double loadOf( const string& shard ) const;
+
+        /**
+         * @return the most loaded shard with chunks of the given tag, by loadOf()
+         */
+        string getMostLoadedShard( const string& forTag ) const;
+
+        /**
+         * @return the least loaded shard able to receive a chunk of the given tag, by loadOf()
+         */
+        string getLeastLoadedReceiver( const string& forTag ) const;
+
 
         // ---- basic accessors, counters, etc...
 
@@ -172,8 +205,14 @@ namespace mongo {
         void dump() const;
         
     private:
+        /** @return if the shard may receive a chunk of the given tag, logging why not */
+        bool _canReceive( const string& shard, const ShardInfo& info, const string& forTag ) const;
+
         const ShardInfoMap& _shardInfo;
         const ShardToChunksMap& _shardChunks;
+        double _meanSize;
+        double _meanResidentSize;
+        double _meanOpsPerSec;
         map<BSONObj,TagRange> _tagRanges;
         set<string> _allTags;
         set<string> _shards;
@@ -190,15 +229,44 @@ namespace mongo {
          * @param ns is the collections namepace.
          * @param DistributionStatus holds all the info about the current state of the cluster/namespace
          * @param balancedLastTime is the number of chunks effectively moved in the last round.
+         * @param byLoad once chunk counts are even, also move chunks off shards that are much
+         *        busier than others, see DistributionStatus::loadOf()
          * @returns NULL or MigrateInfo of the best move to make towards balacing the collection.
          *          caller owns the MigrateInfo instance
          */
         static MigrateInfo* balance( const string& ns,
                                      const DistributionStatus& distribution,
-                                     int balancedLastTime );
+                                     int balancedLastTime,
+                                     bool byLoad = false );
+
+        // how much more loaded than the least loaded receiver a shard must be to shed a chunk
+        static const double kLoadImbalanceRatio;
+
+        /**
+         * Splits migrations into waves that can each run concurrently: no shard is the donor or
+         * recipient of more than one migration in a wave, and a wave holds at most maxPerWave
+         * migrations.  Shards only allow one migration at a time, so this is what lets moves
+         * between disjoint pairs of shards proceed together.  Migrations keep their relative
+         * order, earlier ones going into earlier waves.
+         *
+         * @param migrations not owned, must stay valid as long as the result is used
+         */
+        static vector< vector<const MigrateInfo*> > groupDisjointMigrations(
+                const vector<const MigrateInfo*>& migrations,
+                size_t maxPerWave );
 
     private:
         static bool _isJumbo( const BSONObj& chunk );
+
+        /**
+         * @return a move of one chunk of the tag from the most to the least loaded shard, if
+         *         that lowers the higher of their two loads and leaves chunk counts within
+         *         'threshold', NULL otherwise
+         */
+        static MigrateInfo* _balanceLoad( const string& ns,
+                                          const DistributionStatus& distribution,
+                                          const string& tag,
+                                          int threshold );
     };
 
 
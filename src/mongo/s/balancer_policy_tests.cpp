@@ -41,6 +41,40 @@ namespace mongo {
             ASSERT( ShardInfo( 100LL, 110LL, false, false ).isSizeMaxed() );
         }
 
+        TEST( BalancerPolicyTests , GroupDisjointMigrationsTest ) {
+            BSONObj chunk = BSON(ChunkType::min(BSON("x" << 0)) <<
+                                 ChunkType::max(BSON("x" << 1)));
+            MigrateInfo aToB( "test.a", "shardB", "shardA", chunk );
+            MigrateInfo cToD( "test.b", "shardD", "shardC", chunk );
+            MigrateInfo bToE( "test.c", "shardE", "shardB", chunk );
+            MigrateInfo eToF( "test.d", "shardF", "shardE", chunk );
+
+            vector<const MigrateInfo*> migrations;
+            migrations.push_back( &aToB );
+            migrations.push_back( &cToD );
+            migrations.push_back( &bToE );
+            migrations.push_back( &eToF );
+
+            // shardB and shardE may each only be in one migration per wave
+            vector< vector<const MigrateInfo*> > waves =
+                BalancerPolicy::groupDisjointMigrations( migrations, 10 );
+            ASSERT_EQUALS( 2U, waves.size() );
+            ASSERT_EQUALS( 3U, waves[0].size() );
+            ASSERT_EQUALS( &aToB, waves[0][0] );
+            ASSERT_EQUALS( &cToD, waves[0][1] );
+            ASSERT_EQUALS( &eToF, waves[0][2] );
+            ASSERT_EQUALS( 1U, waves[1].size() );
+            ASSERT_EQUALS( &bToE, waves[1][0] );
+
+            // one at a time keeps the original order
+            waves = BalancerPolicy::groupDisjointMigrations( migrations, 1 );
+            ASSERT_EQUALS( 4U, waves.size() );
+            for ( size_t i = 0; i < waves.size(); i++ ) {
+                ASSERT_EQUALS( 1U, waves[i].size() );
+                ASSERT_EQUALS( migrations[i], waves[i][0] );
+            }
+        }
+
         TEST( BalancerPolicyTests , BalanceNormalTest  ) {
             // 2 chunks and 0 chunk shards
             ShardToChunksMap chunkMap;
@@ -325,6 +359,35 @@ namespace mongo {
             ASSERT_EQUALS("", d.getTagForChunk(BSON(ChunkType::min(BSON("x" << 35)))));
         }
 
+        TEST( BalancerPolicyTests, BalanceByLoad ) {
+            ShardToChunksMap chunks;
+            addShard( chunks, 15 , false );
+            addShard( chunks, 15 , true );
+
+            // same chunk counts and sizes, but shard0 takes all the traffic
+            ShardInfoMap shards;
+            shards["shard0"] = ShardInfo( 0, 100, false, false );
+            shards["shard1"] = ShardInfo( 0, 100, false, false );
+            shards["shard0"].setLoad( 100, 1000 );
+            shards["shard1"].setLoad( 100, 0 );
+
+            DistributionStatus d( shards, chunks );
+            ASSERT( d.loadOf( "shard0" ) > d.loadOf( "shard1" ) );
+            ASSERT( ! BalancerPolicy::balance( "ns", d, 0 ) );
+
+            MigrateInfo* m = BalancerPolicy::balance( "ns", d, 0, true );
+            ASSERT( m );
+            ASSERT_EQUALS( "shard0" , m->from );
+            ASSERT_EQUALS( "shard1" , m->to );
+            delete m;
+
+            // load moves may not open up a gap the chunk count balancing would then close
+            MigrateInfo first( "ns", "shard1", "shard0", chunks["shard0"][0] );
+            moveChunk( chunks, &first );
+            DistributionStatus after( shards, chunks );
+            ASSERT( ! BalancerPolicy::balance( "ns", after, 0, true ) );
+        }
+
         /**
          * Idea for this test is to set up three shards, one of which is overloaded (too much data).
          *
@@ -48,6 +48,41 @@ namespace mongo {
         return true;
     }
 
+    /**
+     * @return false if 'query' can't restrict 'path': no top level operators, no field on,
+     * above or below 'path' and no geo predicates.  Such queries go to every shard, and knowing
+     * it from the field names alone saves building a FieldRangeSet for them.
+     */
+    static bool mayConstrainPath( const BSONObj& query, const StringData& path ) {
+        BSONForEach( field, query ) {
+            StringData name( field.fieldName() );
+            if ( name[0] == '$' )
+                return true;
+
+            const StringData& shorter = name.size() < path.size() ? name : path;
+            const StringData& longer = name.size() < path.size() ? path : name;
+            if ( longer.startsWith( shorter )
+                    && ( longer.size() == shorter.size() || longer[shorter.size()] == '.' ) )
+                return true;
+
+            if ( field.type() != Object )
+                continue;
+
+            BSONForEach( op, field.embeddedObject() ) {
+                switch ( op.getGtLtOp() ) {
+                case BSONObj::opNEAR:
+                case BSONObj::opWITHIN:
+                case BSONObj::opMAX_DISTANCE:
+                case BSONObj::opGEO_INTERSECTS:
+                    return true;
+                default:
+                    break;
+                }
+            }
+        }
+        return false;
+    }
+
     // -------  Shard --------
 
     int Chunk::MaxChunkSize = 1024 * 1024 * 64;
@@ -1090,6 +1125,11 @@ namespace mongo {
     }
 
     void ChunkManager::getShardsForQuery( set<Shard>& shards , const BSONObj& query ) const {
+        if ( ! mayConstrainPath( query, _key.key().firstElementFieldName() ) ) {
+            getShardsForRange( shards, _key.globalMin(), _key.globalMax() );
+            return;
+        }
+
         // TODO Determine if the third argument to OrRangeGenerator() is necessary, see SERVER-5165.
         OrRangeGenerator org(_ns.c_str(), query, false);
 
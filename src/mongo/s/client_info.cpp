@@ -18,6 +18,7 @@
 
 #include "pch.h"
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/auth/authorization_manager_global.h"
 #include "mongo/db/auth/authorization_session.h"
 #include "mongo/db/auth/authz_session_external_state_s.h"
@@ -30,6 +31,7 @@
 #include "../db/stats/timer_stats.h"
 
 #include "../client/connpool.h"
+#include "../client/parallel.h"
 
 #include "client_info.h"
 #include "request.h"
@@ -142,9 +144,14 @@ namespace mongo {
         if ( gle["instanceIdent"].type() == String )
             ident = gle["instanceIdent"].String();
 
+        BSONObj inlineData;
+        if ( gle["writebackInline"].type() == Object )
+            inlineData = gle["writebackInline"].Obj().getOwned();
+
         all.push_back( WBInfo( WriteBackListener::ConnectionIdent( ident , cid.numberLong() ),
                                w.OID(),
-                               fromLastOperation ) );
+                               fromLastOperation,
+                               inlineData ) );
     }
 
     vector<BSONObj> ClientInfo::_handleWriteBacks( const vector<WBInfo>& all , bool fromWriteBackListener ) {
@@ -159,6 +166,13 @@ namespace mongo {
         }
 
         for ( unsigned i=0; i<all.size(); i++ ) {
+            if ( ! all[i].inlineData.isEmpty() ) {
+                // the shard handed the write back with its reply, no need to wait on the queue
+                res.push_back( WriteBackListener::replayInline( all[i].ident ,
+                                                                all[i].id ,
+                                                                all[i].inlineData ) );
+                continue;
+            }
             res.push_back( WriteBackListener::waitFor( all[i].ident , all[i].id ) );
         }
 
@@ -322,40 +336,57 @@ namespace mongo {
 
         int updatedExistingStat = 0; // 0 is none, -1 has but false, 1 has true
 
-        // hit each shard
+        // send the gle to every shard before reading any reply, so the shards wait for their
+        // writes concurrently and the whole gle costs the slowest shard rather than the sum
         vector<string> errors;
         vector<BSONObj> errorObjects;
+        OwnedPointerVector<ShardConnection> conns;
+        vector< shared_ptr<Future::CommandResult> > futures;
         for ( set<string>::iterator i = shards->begin(); i != shards->end(); i++ ) {
             string theShard = *i;
             bbb.append( theShard );
 
-            LOG(5) << "gathering a response for gle from: " << theShard << endl;
+            LOG(5) << "sending gle to: " << theShard << endl;
 
-            boost::scoped_ptr<ShardConnection> conn;
-            BSONObj res;
-            bool ok = false;
             try {
-                conn.reset( new ShardConnection( theShard , "" ) ); // constructor can throw if shard is down
-                ok = (*conn)->runCommand( dbName , options , res );
-                shardRawGLE.append( theShard , res );
+                // constructor can throw if shard is down
+                conns.mutableVector().push_back( new ShardConnection( theShard , "" ) );
             }
             catch( std::exception &e ){
+                for ( size_t j = 0; j < conns.vector().size(); j++ )
+                    conns.vector()[j]->done();
+                errmsg = str::stream() << "could not get last error from a shard " << theShard
+                                       << causedBy( e );
+                warning() << errmsg << endl;
+                return false;
+            }
 
-                // Safe to return here, since we haven't started any extra processing yet, just collecting
-                // responses.
-
-                string message =
-                        str::stream() << "could not get last error from a shard " << theShard
-                                      << causedBy( e );
+            futures.push_back( Future::spawnCommand( theShard , dbName , options , 0 ,
+                                                     conns.vector().back()->get() ) );
+        }
 
-                warning() << message << endl;
-                errmsg = message;
+        // gather the replies
+        bool gathered = true;
+        for ( size_t i = 0; i < futures.size(); i++ ) {
+            const string theShard = futures[i]->getServer();
+            ShardConnection* conn = conns.vector()[i];
 
-                if (conn)
-                    conn->done();
+            LOG(5) << "gathering a response for gle from: " << theShard << endl;
 
-                return false;
+            bool ok = futures[i]->join();
+            BSONObj res = futures[i]->result();
+            if ( res.isEmpty() ) {
+                // the command never got a reply; keep joining so no reply is left in flight
+                if ( gathered ) {
+                    errmsg = str::stream() << "could not get last error from a shard "
+                                           << theShard;
+                    warning() << errmsg << endl;
+                }
+                gathered = false;
+                conn->done();
+                continue;
             }
+            shardRawGLE.append( theShard , res );
 
             _addWriteBack( writebacks, res, true );
 
@@ -376,6 +407,11 @@ namespace mongo {
             conn->done();
         }
 
+        // Safe to return here, since we haven't started any extra processing yet, just
+        // collecting responses.
+        if ( ! gathered )
+            return false;
+
         bbb.done();
         result.append( "shardRawGLE" , shardRawGLE.obj() );
 
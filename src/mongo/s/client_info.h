@@ -111,11 +111,14 @@ namespace mongo {
 
     private:
         struct WBInfo {
-            WBInfo( const WriteBackListener::ConnectionIdent& c, OID o, bool fromLastOperation )
-                : ident( c ), id( o ), fromLastOperation( fromLastOperation ) {}
+            WBInfo( const WriteBackListener::ConnectionIdent& c, OID o, bool fromLastOperation,
+                    const BSONObj& inlineData )
+                : ident( c ), id( o ), fromLastOperation( fromLastOperation ),
+                  inlineData( inlineData ) {}
             WriteBackListener::ConnectionIdent ident;
             OID id;
             bool fromLastOperation;
+            BSONObj inlineData; // the writeback itself, if the shard handed it back
         };
 
         // for getLastError
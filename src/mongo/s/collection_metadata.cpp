@@ -90,7 +90,20 @@ namespace mongo {
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
-        metadata->fillRanges();
+
+        // Cut the chunk out of the range holding it instead of rebuilding all the ranges.
+        metadata->_rangesMap = this->_rangesMap;
+        RangeMap::iterator range = metadata->_rangesMap.upper_bound( chunk.getMin() );
+        --range;
+        const BSONObj rangeMin = range->first;
+        const BSONObj rangeMax = range->second;
+        metadata->_rangesMap.erase( range );
+        if ( rangeMin.woCompare( chunk.getMin() ) != 0 ) {
+            metadata->_rangesMap.insert( make_pair( rangeMin, chunk.getMin().getOwned() ) );
+        }
+        if ( chunk.getMax().woCompare( rangeMax ) != 0 ) {
+            metadata->_rangesMap.insert( make_pair( chunk.getMax().getOwned(), rangeMax ) );
+        }
 
         dassert(metadata->isValid());
         return metadata.release();
@@ -141,7 +154,25 @@ namespace mongo {
         metadata->_shardVersion = newShardVersion;
         metadata->_collVersion =
                 newShardVersion > _collVersion ? newShardVersion : this->_collVersion;
-        metadata->fillRanges();
+
+        // Join the chunk to the ranges next to it instead of rebuilding all the ranges.
+        metadata->_rangesMap = this->_rangesMap;
+        BSONObj rangeMin = chunk.getMin().getOwned();
+        BSONObj rangeMax = chunk.getMax().getOwned();
+        RangeMap::iterator after = metadata->_rangesMap.find( rangeMax );
+        if ( after != metadata->_rangesMap.end() ) {
+            rangeMax = after->second;
+            metadata->_rangesMap.erase( after );
+        }
+        RangeMap::iterator before = metadata->_rangesMap.lower_bound( rangeMin );
+        if ( before != metadata->_rangesMap.begin() ) {
+            --before;
+            if ( before->second.woCompare( rangeMin ) == 0 ) {
+                rangeMin = before->first;
+                metadata->_rangesMap.erase( before );
+            }
+        }
+        metadata->_rangesMap.insert( make_pair( rangeMin, rangeMax ) );
 
         dassert(metadata->isValid());
         return metadata.release();
@@ -328,7 +359,9 @@ namespace mongo {
 
         metadata->_collVersion =
                 metadata->_shardVersion > _collVersion ? metadata->_shardVersion : _collVersion;
-        metadata->fillRanges();
+
+        // Splitting doesn't change which ranges the chunks cover.
+        metadata->_rangesMap = this->_rangesMap;
 
         dassert(metadata->isValid());
         return metadata.release();
@@ -365,6 +398,32 @@ namespace mongo {
         return good;
     }
 
+    bool CollectionMetadata::keyBelongsToMe( const BSONObj& key,
+                                             BSONObj* rangeMin,
+                                             BSONObj* rangeMax ) const {
+        if ( _keyPattern.isEmpty() ) {
+            return true;
+        }
+
+        if ( _rangesMap.empty() ) {
+            return false;
+        }
+
+        RangeMap::const_iterator it = _rangesMap.upper_bound( key );
+        if ( it == _rangesMap.begin() ) {
+            return false;
+        }
+        it--;
+
+        if ( !rangeContains( it->first, it->second, key ) ) {
+            return false;
+        }
+
+        *rangeMin = it->first;
+        *rangeMax = it->second;
+        return true;
+    }
+
     bool CollectionMetadata::keyIsPending( const BSONObj& key ) const {
         // If we aren't sharded, then the key is never pending (though it belongs-to-me)
         if ( _keyPattern.isEmpty() ) {
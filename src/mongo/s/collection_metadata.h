@@ -122,6 +122,14 @@ namespace mongo {
          */
         bool keyBelongsToMe( const BSONObj& key ) const;
 
+        /**
+         * As above, and if the key belongs to us, sets the bounds of the range of adjacent owned
+         * chunks holding it, so that callers checking many keys in order can skip the lookup for
+         * the keys that follow in [*rangeMin, *rangeMax).  The bounds are left alone if the
+         * collection isn't sharded.
+         */
+        bool keyBelongsToMe( const BSONObj& key, BSONObj* rangeMin, BSONObj* rangeMax ) const;
+
         /**
          * Returns true if the document key 'key' is or has been migrated to this shard, and may
          * belong to us after a subsequent config reload.  Key must be the full shard key.
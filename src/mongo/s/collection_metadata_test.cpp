@@ -960,6 +960,23 @@ namespace {
         ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY)) );
     }
 
+    TEST_F(ThreeChunkWithRangeGapFixture, ShardOwnsDocRange) {
+        BSONObj rangeMin;
+        BSONObj rangeMax;
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 15), &rangeMin, &rangeMax) );
+        ASSERT_EQUALS( 0, rangeMin.woCompare(BSON("a" << MINKEY)) );
+        ASSERT_EQUALS( 0, rangeMax.woCompare(BSON("a" << 20)) );
+
+        ASSERT( getCollMetadata().keyBelongsToMe(BSON("a" << 30), &rangeMin, &rangeMax) );
+        ASSERT_EQUALS( 0, rangeMin.woCompare(BSON("a" << 30)) );
+        ASSERT_EQUALS( 0, rangeMax.woCompare(BSON("a" << MAXKEY)) );
+
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << 25), &rangeMin, &rangeMax) );
+        ASSERT_FALSE( getCollMetadata().keyBelongsToMe(BSON("a" << MAXKEY),
+                                                       &rangeMin,
+                                                       &rangeMax) );
+    }
+
     TEST_F(ThreeChunkWithRangeGapFixture, GetNextFromEmpty) {
         ChunkType nextChunk;
         ASSERT_FALSE( getCollMetadata().getNextChunk( BSONObj(), &nextChunk ) );
@@ -978,4 +995,70 @@ namespace {
         ChunkType nextChunk;
         ASSERT( getCollMetadata().getNextChunk(BSON("a" << 30), &nextChunk) );
     }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, ClonePlusJoinsRanges) {
+        ChunkType chunk;
+        chunk.setMin( BSON("a" << 20) );
+        chunk.setMax( BSON("a" << 30) );
+
+        string errMsg;
+        scoped_ptr<CollectionMetadata> cloned( getCollMetadata().clonePlusChunk( chunk,
+                                                                                 ChunkVersion( 1,
+                                                                                               4,
+                                                                                               OID() ),
+                                                                                 &errMsg ) );
+        ASSERT( cloned != NULL );
+        ASSERT_EQUALS( 4u, cloned->getNumChunks() );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << MINKEY)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 15)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 20)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 29)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 30)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << MAXKEY)) );
+    }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, CloneMinusCutsRange) {
+        ChunkType chunk;
+        chunk.setMin( BSON("a" << 10) );
+        chunk.setMax( BSON("a" << 20) );
+
+        string errMsg;
+        scoped_ptr<CollectionMetadata> cloned( getCollMetadata().cloneMinusChunk( chunk,
+                                                                                  ChunkVersion( 2,
+                                                                                                0,
+                                                                                                OID() ),
+                                                                                  &errMsg ) );
+        ASSERT( cloned != NULL );
+        ASSERT_EQUALS( 2u, cloned->getNumChunks() );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << MINKEY)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 9)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << 10)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << 19)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << 25)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 30)) );
+    }
+
+    TEST_F(ThreeChunkWithRangeGapFixture, CloneSplitKeepsRanges) {
+        ChunkType chunk;
+        chunk.setMin( BSON("a" << 10) );
+        chunk.setMax( BSON("a" << 20) );
+
+        vector<BSONObj> splitKeys;
+        splitKeys.push_back( BSON("a" << 15) );
+
+        string errMsg;
+        scoped_ptr<CollectionMetadata> cloned( getCollMetadata().cloneSplit( chunk,
+                                                                             splitKeys,
+                                                                             ChunkVersion( 2,
+                                                                                           0,
+                                                                                           OID() ),
+                                                                             &errMsg ) );
+        ASSERT( cloned != NULL );
+        ASSERT_EQUALS( 4u, cloned->getNumChunks() );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 5)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 15)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 19)) );
+        ASSERT_FALSE( cloned->keyBelongsToMe(BSON("a" << 20)) );
+        ASSERT( cloned->keyBelongsToMe(BSON("a" << 30)) );
+    }
 } // unnamed namespace
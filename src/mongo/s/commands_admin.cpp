@@ -786,6 +786,9 @@ namespace mongo {
                         << " { split : 'alleyinsider.blog.posts' , find : { ts : 1 } }\n"
                         << " example: - split the shard that contains the key with this as the middle \n"
                         << " { split : 'alleyinsider.blog.posts' , middle : { ts : 1 } }\n"
+                        << " example: - split at each of several keys \n"
+                        << " { split : 'alleyinsider.blog.posts' ,"
+                        << " middles : [ { ts : 1 } , { ts : 2 } ] }\n"
                         << " NOTE: this does not move move the chunks, it merely creates a logical separation \n"
                         ;
             }
@@ -820,6 +823,7 @@ namespace mongo {
                 const BSONField<BSONObj> findField("find", BSONObj());
                 const BSONField<BSONArray> boundsField("bounds", BSONArray());
                 const BSONField<BSONObj> middleField("middle", BSONObj());
+                const BSONField<BSONArray> middlesField("middles", BSONArray());
 
                 BSONObj find;
                 if (FieldParser::extract(cmdObj, findField, &find, &errmsg) ==
@@ -856,8 +860,22 @@ namespace mongo {
                     return false;
                 }
 
+                BSONArray middles;
+                if (FieldParser::extract(cmdObj, middlesField, &middles, &errmsg) ==
+                        FieldParser::FIELD_INVALID) {
+                    return false;
+                }
+
+                if (!middles.isEmpty()) {
+                    if (!find.isEmpty() || !bounds.isEmpty() || !middle.isEmpty()) {
+                        errmsg = "cannot specify middles with find, bounds or middle";
+                        return false;
+                    }
+                    return splitAtPoints(config, ns, middles, errmsg, result);
+                }
+
                 if (find.isEmpty() && bounds.isEmpty() && middle.isEmpty()) {
-                    errmsg = "need to specify find/bounds or middle";
+                    errmsg = "need to specify find/bounds, middle or middles";
                     return false;
                 }
 
@@ -925,6 +943,74 @@ namespace mongo {
                 config->getChunkManager( ns , true );
                 return true;
             }
+
+        private:
+            /**
+             * Splits 'ns' at every key in 'middles'.  The keys that fall in the same chunk go to
+             * its shard in one splitChunk, which commits all of them to the config servers at
+             * once, so pre-splitting costs a commit per existing chunk rather than per key.
+             */
+            bool splitAtPoints( DBConfigPtr config , const string& ns , const BSONArray& middles ,
+                                string& errmsg , BSONObjBuilder& result ) {
+                // Chunk::multiSplit takes fewer than this many keys at a time.
+                const size_t maxSplitPoints = 8191;
+
+                ChunkManagerPtr info = config->getChunkManager( ns );
+                const BSONObj shardKey = info->getShardKey().key();
+
+                vector<BSONObj> points;
+                BSONObjIterator it( middles );
+                while ( it.more() ) {
+                    BSONElement e = it.next();
+                    if ( e.type() != Object || !fieldsMatch( e.Obj() , shardKey ) ) {
+                        errmsg = "middles have to be objects with the same fields as the shard key";
+                        return false;
+                    }
+                    points.push_back( e.Obj().getOwned() );
+                }
+                std::sort( points.begin() , points.end() , BSONObjCmp() );
+
+                int splits = 0;
+                size_t i = 0;
+                while ( i < points.size() ) {
+                    ChunkPtr chunk = info->findIntersectingChunk( points[i] );
+
+                    vector<BSONObj> splitPoints;
+                    for ( ; i < points.size() && splitPoints.size() < maxSplitPoints; i++ ) {
+                        if ( points[i].woCompare( chunk->getMax() ) >= 0 )
+                            break;
+                        // already a chunk's bound, or a repeat
+                        if ( points[i].woCompare( chunk->getMin() ) == 0 )
+                            continue;
+                        if ( !splitPoints.empty() &&
+                             points[i].woCompare( splitPoints.back() ) == 0 )
+                            continue;
+                        splitPoints.push_back( points[i] );
+                    }
+                    if ( splitPoints.empty() )
+                        continue;
+
+                    log().stream() << "splitting: " << ns << "  shard: " << chunk
+                                   << " at " << splitPoints.size() << " keys" << endl;
+
+                    BSONObj res;
+                    if ( !chunk->multiSplit( splitPoints , res ) ) {
+                        errmsg = "split failed";
+                        result.append( "cause" , res );
+                        result.append( "splits" , splits );
+                        config->getChunkManager( ns , true );
+                        return false;
+                    }
+                    splits += splitPoints.size();
+
+                    // multiSplit reloaded the chunks
+                    info = config->getChunkManager( ns );
+                }
+
+                config->getChunkManager( ns , true );
+                result.append( "splits" , splits );
+                return true;
+            }
         } splitCollectionCmd;
 
         class MoveChunkCmd : public GridAdminCmd {
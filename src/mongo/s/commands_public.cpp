@@ -18,6 +18,8 @@
 
 #include "pch.h"
 
+#include <queue>
+
 #include "mongo/base/init.h"
 #include "mongo/client/connpool.h"
 #include "mongo/client/parallel.h"
@@ -1215,7 +1217,8 @@ namespace mongo {
                     shardArray.append(i->getName());
                 }
 
-                multimap<double, BSONObj> results; // TODO: maybe use merge-sort instead
+                // Each shard returns its results nearest first, so they are merged, not sorted
+                vector<BSONObjIterator> shardResults;
                 string nearStr;
                 double time = 0;
                 double btreelocs = 0;
@@ -1240,11 +1243,20 @@ namespace mongo {
                         objectsLoaded += res->result()["stats"]["objectsLoaded"].Number();
                     }
 
-                    BSONForEach(obj, res->result()["results"].embeddedObject()) {
-                        results.insert(make_pair(obj["dis"].Number(), obj.embeddedObject().getOwned()));
-                    }
+                    // res stays in futures, keeping the result this iterates alive
+                    shardResults.push_back(BSONObjIterator(res->result()["results"].embeddedObject()));
+                }
 
-                    // TODO: maybe shrink results if size() > limit
+                // The nearest unmerged result of each shard, by (distance, shard).  Breaking ties
+                // by shard keeps the order a stable sort of all the results would give.
+                typedef pair<double, size_t> MergeEntry;
+                priority_queue<MergeEntry, vector<MergeEntry>, greater<MergeEntry> > heap;
+                vector<BSONObj> shardHeads(shardResults.size());
+                for (size_t i = 0; i < shardResults.size(); ++i) {
+                    if (shardResults[i].more()) {
+                        shardHeads[i] = shardResults[i].next().embeddedObject();
+                        heap.push(make_pair(shardHeads[i]["dis"].Number(), i));
+                    }
                 }
 
                 result.append("ns" , fullns);
@@ -1255,11 +1267,18 @@ namespace mongo {
                 double maxDistance = 0;
                 {
                     BSONArrayBuilder sub (result.subarrayStart("results"));
-                    for (multimap<double, BSONObj>::const_iterator it(results.begin()), end(results.end()); it!= end && outCount < limit; ++it, ++outCount) {
-                        totalDistance += it->first;
-                        maxDistance = it->first; // guaranteed to be highest so far
-
-                        sub.append(it->second);
+                    for (; !heap.empty() && outCount < limit; ++outCount) {
+                        const MergeEntry nearest = heap.top();
+                        heap.pop();
+                        totalDistance += nearest.first;
+                        maxDistance = nearest.first; // guaranteed to be highest so far
+
+                        const size_t shard = nearest.second;
+                        sub.append(shardHeads[shard]);
+                        if (shardResults[shard].more()) {
+                            shardHeads[shard] = shardResults[shard].next().embeddedObject();
+                            heap.push(make_pair(shardHeads[shard]["dis"].Number(), shard));
+                        }
                     }
                     sub.done();
                 }
@@ -1853,7 +1872,14 @@ namespace mongo {
             map<Shard, BSONObj> shardResults;
             SHARDED->commandOp(dbName, shardedCommand, options, fullns, shardQuery, shardResults);
 
-            pPipeline->addInitialSource(DocumentSourceCommandShards::create(shardResults, pExpCtx));
+            intrusive_ptr<DocumentSourceCommandShards> pShardSource =
+                DocumentSourceCommandShards::create(shardResults, pExpCtx);
+
+            // The shards sorted their results, so merge them instead of sorting again
+            if (intrusive_ptr<DocumentSourceSort> pMergeSort = pPipeline->popMergeSort())
+                pShardSource->setMergeSort(pMergeSort);
+
+            pPipeline->addInitialSource(pShardSource);
 
             // Combine the shards' output and finish the pipeline
             pPipeline->stitch();
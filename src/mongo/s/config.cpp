@@ -110,8 +110,7 @@ namespace mongo {
     bool DBConfig::isSharded( const string& ns ) {
         if ( ! _shardingEnabled )
             return false;
-        scoped_lock lk( _lock );
-        return _isSharded( ns );
+        return _getRoutingEntry( ns );
     }
 
     bool DBConfig::_isSharded( const string& ns ) {
@@ -175,6 +174,7 @@ namespace mongo {
             cm->createFirstChunks( configServer.getPrimary().getConnString(),
                                    getPrimary(), initPoints, initShards );
             ci.shard( cm );
+            _publishRoutingTable_inlock();
 
             _save();
 
@@ -231,6 +231,7 @@ namespace mongo {
         }
 
         ci.unshard();
+        _publishRoutingTable_inlock();
         _save( false, true );
         return true;
     }
@@ -245,6 +246,14 @@ namespace mongo {
         manager.reset();
         primary.reset();
 
+        // The routing table has every sharded collection, so only the unsharded case needs
+        // the lock to get at the primary.
+        if ( _shardingEnabled ) {
+            manager = _getRoutingEntry( ns );
+            if ( manager )
+                return;
+        }
+
         {
             scoped_lock lk( _lock );
 
@@ -287,11 +296,60 @@ namespace mongo {
         }
     }
 
+    BSONObj DBConfig::_findNewestChunk( const string& ns ) {
+        scoped_lock lk( _newestChunkLock );
+        NewestChunkQuery& query = _newestChunkQueries[ns];
+
+        // a query already under way may have read before our caller saw the change, so we
+        // need the one after it
+        const unsigned long long target = query.finished + ( query.inProgress ? 2 : 1 );
+
+        while ( query.finished < target ) {
+            if ( query.inProgress ) {
+                _newestChunkFound.wait( lk.boost() );
+                continue;
+            }
+
+            query.inProgress = true;
+            lk.boost().unlock();
+
+            BSONObj newest;
+            try {
+                ScopedDbConnection conn(configServer.modelServer(), 30.0);
+                newest = conn->findOne(ChunkType::ConfigNS,
+                                       Query(BSON(ChunkType::ns(ns))).sort(
+                                               ChunkType::DEPRECATED_lastmod(), -1)).getOwned();
+                conn.done();
+            }
+            catch ( ... ) {
+                // let a waiter try instead
+                lk.boost().lock();
+                query.inProgress = false;
+                _newestChunkFound.notify_all();
+                throw;
+            }
+
+            lk.boost().lock();
+            query.inProgress = false;
+            query.newest = newest;
+            query.finished++;
+            _newestChunkFound.notify_all();
+        }
+
+        return query.newest;
+    }
+
     ChunkManagerPtr DBConfig::getChunkManager( const string& ns , bool shouldReload, bool forceReload ) {
         BSONObj key;
         ChunkVersion oldVersion;
         ChunkManagerPtr oldManager;
 
+        if ( ! ( shouldReload || forceReload ) ) {
+            ChunkManagerPtr manager = _getRoutingEntry( ns );
+            if ( manager )
+                return manager;
+        }
+
         {
             scoped_lock lk( _lock );
             
@@ -322,12 +380,8 @@ namespace mongo {
 
         BSONObj newest;
         if ( oldVersion.isSet() && ! forceReload ) {
-            ScopedDbConnection conn(configServer.modelServer(), 30.0);
-            newest = conn->findOne(ChunkType::ConfigNS,
-                                   Query(BSON(ChunkType::ns(ns))).sort(
-                                           ChunkType::DEPRECATED_lastmod(), -1));
-            conn.done();
-            
+            newest = _findNewestChunk( ns );
+
             if ( ! newest.isEmpty() ) {
                 ChunkVersion v = ChunkVersion::fromBSON(newest, ChunkType::DEPRECATED_lastmod());
                 if ( v.isEquivalentTo( oldVersion ) ) {
@@ -416,6 +470,7 @@ namespace mongo {
 
         if ( shouldReset ){
             ci.resetCM( temp.release() );
+            _publishRoutingTable_inlock();
         }
         
         uassert( 15883 , str::stream() << "not sharded after chunk manager reset : " << ns , ci.isSharded() );
@@ -499,6 +554,8 @@ namespace mongo {
             }
         }
 
+        _publishRoutingTable_inlock();
+
         LOG(2) << "found " << numCollsErased << " dropped collections and "
                << numCollsSharded << " sharded collections for database " << _name << endl;
 
@@ -681,6 +738,23 @@ namespace mongo {
         return true;
     }
 
+    ChunkManagerPtr DBConfig::_getRoutingEntry( const string& ns ) const {
+        RoutingTablePtr routingTable = boost::atomic_load( &_routingTable );
+        RoutingTable::const_iterator i = routingTable->find( ns );
+        if ( i == routingTable->end() )
+            return ChunkManagerPtr();
+        return i->second;
+    }
+
+    void DBConfig::_publishRoutingTable_inlock() {
+        boost::shared_ptr<RoutingTable> routingTable( new RoutingTable() );
+        for ( Collections::const_iterator i = _collections.begin(); i != _collections.end(); ++i ) {
+            if ( i->second.isSharded() )
+                (*routingTable)[i->first] = i->second.getCM();
+        }
+        boost::atomic_store( &_routingTable, RoutingTablePtr( routingTable ) );
+    }
+
     void DBConfig::getAllShards(set<Shard>& shards) const {
         scoped_lock lk( _lock );
         shards.insert(getPrimary());
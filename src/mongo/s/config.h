@@ -87,14 +87,20 @@ namespace mongo {
 
         typedef map<string,CollectionInfo> Collections;
 
+        // chunk managers of the sharded collections only
+        typedef map<string,ChunkManagerPtr> RoutingTable;
+        typedef boost::shared_ptr<const RoutingTable> RoutingTablePtr;
+
     public:
 
         DBConfig( string name )
             : _name( name ) ,
               _primary("config","") ,
               _shardingEnabled(false),
+              _routingTable( new RoutingTable() ) ,
               _lock("DBConfig") ,
-              _hitConfigServerLock( "DBConfig::_hitConfigServerLock" ) {
+              _hitConfigServerLock( "DBConfig::_hitConfigServerLock" ) ,
+              _newestChunkLock( "DBConfig::_newestChunkLock" ) {
             verify( name.size() );
         }
         virtual ~DBConfig() {}
@@ -180,6 +186,25 @@ namespace mongo {
 
         bool _dropShardedCollections( int& num, set<Shard>& allServers , string& errmsg );
 
+        /**
+         * @return the chunk manager for ns from the routing table, null if it isn't sharded.
+         * lockless
+         */
+        ChunkManagerPtr _getRoutingEntry( const string& ns ) const;
+
+        /**
+         * Rebuilds the routing table from _collections and swaps it in.  Must be called
+         * under _lock after anything that changes which chunk manager a collection has.
+         */
+        void _publishRoutingTable_inlock();
+
+        /**
+         * @return the newest chunk of 'ns' on the config server, read by a query that started
+         * after this call.  Concurrent callers share those queries, so a burst of stale routing
+         * after a migration costs about two config server round trips instead of one a thread.
+         */
+        BSONObj _findNewestChunk( const string& ns );
+
         bool _load();
         bool _reload();
         void _save( bool db = true, bool coll = true );
@@ -193,8 +218,24 @@ namespace mongo {
 
         Collections _collections;
 
+        // Immutable copy of the chunk managers in _collections, replaced as a whole rather
+        // than modified, so routed operations can look up their chunk manager without _lock.
+        // Only access through boost::atomic_load/atomic_store.
+        RoutingTablePtr _routingTable;
+
         mutable mongo::mutex _lock; // TODO: change to r/w lock ??
         mutable mongo::mutex _hitConfigServerLock;
+
+        struct NewestChunkQuery {
+            NewestChunkQuery() : finished( 0 ) , inProgress( false ) {}
+            unsigned long long finished; // how many queries for the ns have completed
+            bool inProgress;
+            BSONObj newest; // result of the last completed query
+        };
+
+        map<string,NewestChunkQuery> _newestChunkQueries;
+        mongo::mutex _newestChunkLock; // protects _newestChunkQueries
+        boost::condition _newestChunkFound;
     };
 
     class ConfigServer : public DBConfig {
@@ -131,9 +131,19 @@ namespace mongo {
         // this is important so that the id is guaranteed to be ascending 
         // that is important since mongos assumes if its seen a greater writeback
         // that all former have been processed
-        OID writebackID = writeBackManager.queueWriteBack( clientID.str() , b );
-
-        lastError.getSafe()->writeback( writebackID );
+        BSONObj queued;
+        OID writebackID = writeBackManager.queueWriteBack( clientID.str() , b , &queued );
+
+        // A mongos that asked for it gets the writeback back in its getLastError and replays it
+        // right away; the queued copy stays for the case where no getLastError follows.
+        // Large ones only go through the queue, so they can't push getLastError over the limit.
+        if ( ShardedConnectionInfo::get(false)->wantsInlineWritebacks()
+                && queued.objsize() < BSONObjMaxUserSize / 2 ) {
+            lastError.getSafe()->writeback( writebackID, queued );
+        }
+        else {
+            lastError.getSafe()->writeback( writebackID );
+        }
 
         return true;
     }
@@ -187,6 +187,16 @@ namespace mongo {
         bool waitTillNotInCriticalSection( int maxSecondsToWait );
 
     private:
+        /**
+         * Makes 'cloned' the metadata for 'ns' if 'base' still is.  The clone*() calls that make
+         * new metadata copy all of a collection's chunks, so they run without _mutex, which every
+         * operation takes to check its shard version.  Returns false if the metadata changed in
+         * the meantime, in which case the clone has to be made again from the current one.
+         */
+        bool _installClone( const string& ns,
+                            const CollectionMetadataPtr& base,
+                            const CollectionMetadataPtr& cloned );
+
         bool _enabled;
 
         string _configServer;
@@ -224,6 +234,10 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /** detach this thread's info (possibly NULL) without deleting it, and reattach it */
+        static ShardedConnectionInfo* release();
+        static void adopt( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
@@ -233,10 +247,15 @@ namespace mongo {
         void enterForceVersionOkMode() { _forceVersionOk = true; }
         void leaveForceVersionOkMode() { _forceVersionOk = false; }
 
+        /** the mongos on this connection replays stale writes from getLastError itself */
+        bool wantsInlineWritebacks() const { return _inlineWritebacks; }
+        void setInlineWritebacks( bool inlineWritebacks ) { _inlineWritebacks = inlineWritebacks; }
+
     private:
 
         OID _id;
         bool _forceVersionOk; // if this is true, then chunk version #s aren't check, and all ops are allowed
+        bool _inlineWritebacks;
 
         typedef map<string,ChunkVersion> NSVersionMap;
         NSVersionMap _versions;
@@ -54,7 +54,9 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/repl/rs_config.h"
 #include "mongo/db/repl/write_concern.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/logger/ramlog.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -62,6 +64,7 @@
 #include "mongo/s/shard.h"
 #include "mongo/s/type_chunk.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/compress.h"
 #include "mongo/util/elapsed_tracker.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/queue.h"
@@ -73,6 +76,13 @@ namespace mongo {
 
     Tee* migrateLog = RamLog::get("migrate");
 
+    // when set, a recipient asks the donor to snappy compress the batches of its initial clone
+    MONGO_EXPORT_SERVER_PARAMETER(migrateCloneCompression, bool, false);
+
+    // when set, a chunk too big to move whose documents all share one shard key value (so it
+    // can never be split) is cloned straight off the shard key index instead of being refused
+    MONGO_EXPORT_SERVER_PARAMETER(streamLargeChunkMigrations, bool, true);
+
     class MoveTimingHelper {
     public:
         MoveTimingHelper( const string& where , const string& ns , BSONObj min , BSONObj max , int total , string& cmdErrmsg )
@@ -184,7 +194,11 @@ namespace mongo {
     class MigrateFromStatus {
     public:
 
+        // number of records ahead of the clone cursor to prefetch
+        static const int CloneReadAhead = 16;
+
         MigrateFromStatus() : _mutex("MigrateFromStatus") {
+            _cloneCursorId = 0;
             _active = false;
             _inCriticalSection = false;
             _memoryUsed = 0;
@@ -215,6 +229,7 @@ namespace mongo {
             _shardKeyPattern = shardKeyPattern;
 
             verify( _cloneLocs.size() == 0 );
+            verify( _cloneCursorId == 0 );
             verify( _deleted.size() == 0 );
             verify( _reload.size() == 0 );
             verify( _memoryUsed == 0 );
@@ -235,6 +250,10 @@ namespace mongo {
                 _reload.clear();
                 _cloneLocs.clear();
             }
+            if ( _cloneCursorId ) {
+                ClientCursor::erase( _cloneCursorId );
+                _cloneCursorId = 0;
+            }
             _memoryUsed = 0;
 
             scoped_lock l(_mutex);
@@ -367,6 +386,11 @@ namespace mongo {
         /**
          * Get the disklocs that belong to the chunk migrated and sort them in _cloneLocs (to avoid seeking disk later)
          *
+         * A chunk that turns out too large to move gets 'splitKeys' in 'result' that cut it
+         * into movable pieces.  If it has none, because the whole chunk is one shard key value,
+         * it is cloned with a cursor over the shard key index instead (see
+         * streamLargeChunkMigrations) and no disklocs are kept.
+         *
          * @param maxChunkSize number of bytes beyond which a chunk's base data (no indices) is considered too large to move
          * @param errmsg filled with textual description of error if this call return false
          * @return false if approximate chunk size is too big to move or true otherwise
@@ -411,7 +435,14 @@ namespace mongo {
                 avgRecSize = 0;
                 maxRecsWhenFull = Chunk::MaxObjectPerChunk + 1;
             }
-            
+
+            // in case the chunk is too big, note a split key every half full chunk as we go,
+            // the way splitVector would; a key equal to the last one can't split, take the next
+            const unsigned long long recsPerSplit = std::max( 1ULL , maxRecsWhenFull * 100 / 130 / 2 );
+            vector<BSONObj> splitKeys;
+            BSONObj lastSplitKey;
+            bool wantSplitKey = false;
+
             // do a full traversal of the chunk and don't stop even if we think it is a large chunk
             // we want the number of records to better report, in that case
             bool isLargeChunk = false;
@@ -422,6 +453,19 @@ namespace mongo {
                     scoped_spinlock lk( _trackerLocks );
                     _cloneLocs.insert( dl );
                 }
+
+                if ( recCount == 0 || wantSplitKey ) {
+                    BSONObj key = btreeCursor->prettyKey( cc->currKey() ).extractFields( _shardKeyPattern );
+                    if ( recCount == 0 ) {
+                        lastSplitKey = key.getOwned();
+                    }
+                    else if ( key.woCompare( lastSplitKey ) != 0 ) {
+                        lastSplitKey = key.getOwned();
+                        splitKeys.push_back( lastSplitKey );
+                        wantSplitKey = false;
+                    }
+                }
+
                 cc->advance();
 
                 // we can afford to yield here because any change to the base data that we might miss is already being
@@ -431,9 +475,20 @@ namespace mongo {
                     break;
                 }
 
-                if ( ++recCount > maxRecsWhenFull ) {
+                if ( ++recCount > maxRecsWhenFull && ! isLargeChunk ) {
+                    // the disklocs won't be used, don't hold on to them for the rest of the scan
                     isLargeChunk = true;
+                    scoped_spinlock lk( _trackerLocks );
+                    _cloneLocs.clear();
                 }
+
+                if ( recCount % recsPerSplit == 0 ) {
+                    wantSplitKey = true;
+                }
+            }
+
+            if ( isLargeChunk && splitKeys.empty() && streamLargeChunkMigrations ) {
+                return _startStreamingClone( recCount * avgRecSize , errmsg );
             }
 
             if ( isLargeChunk ) {
@@ -443,6 +498,9 @@ namespace mongo {
                           << migrateLog;
                 result.appendBool( "chunkTooBig" , true );
                 result.appendNumber( "estimatedChunkSize" , (long long)(recCount * avgRecSize) );
+                if ( ! splitKeys.empty() ) {
+                    result.append( "splitKeys" , splitKeys );
+                }
                 errmsg = "chunk too big to move";
                 return false;
             }
@@ -454,12 +512,29 @@ namespace mongo {
             return true;
         }
 
-        bool clone( string& errmsg , BSONObjBuilder& result ) {
+        /**
+         * Returns the next batch of cloned documents in 'objects', or with 'compress' as a
+         * snappy compressed array in 'compressedObjects'.
+         */
+        bool clone( bool compress , string& errmsg , BSONObjBuilder& result ) {
             if ( ! _getActive() ) {
                 errmsg = "not active";
                 return false;
             }
 
+            CursorId cloneCursorId;
+            {
+                scoped_spinlock lk( _trackerLocks );
+                cloneCursorId = _cloneCursorId;
+            }
+            if ( cloneCursorId ) {
+                BSONArrayBuilder a( BSONObjMaxUserSize );
+                if ( ! _cloneStreaming( cloneCursorId , a , errmsg ) )
+                    return false;
+                _appendCloneBatch( a.arr() , compress , result );
+                return true;
+            }
+
             ElapsedTracker tracker (128, 10); // same as ClientCursor::_yieldSometimesTracker
 
             int allocSize;
@@ -482,11 +557,22 @@ namespace mongo {
                     Client::ReadContext ctx( _ns );
                     scoped_spinlock lk( _trackerLocks );
                     set<DiskLoc>::iterator i = _cloneLocs.begin();
+
+                    // ask the OS to page in records a little ahead of the one we are copying
+                    set<DiskLoc>::iterator ahead = i;
+                    for ( int n = 0; n < CloneReadAhead && ahead != _cloneLocs.end(); ++n, ++ahead )
+                        ahead->rec()->prefetch();
+
                     for ( ; i!=_cloneLocs.end(); ++i ) {
                         if (tracker.intervalHasElapsed()) // should I yield?
                             break;
                         
                         DiskLoc dl = *i;
+
+                        if ( ahead != _cloneLocs.end() ) {
+                            ahead->rec()->prefetch();
+                            ++ahead;
+                        }
                         
                         Record* r = dl.rec();
                         if ( ! r->likelyInPhysicalMemory() ) {
@@ -523,7 +609,7 @@ namespace mongo {
                 
             }
 
-            result.appendArray( "objects" , a.arr() );
+            _appendCloneBatch( a.arr() , compress , result );
             return true;
         }
 
@@ -580,6 +666,97 @@ namespace mongo {
         bool isActive() const { return _getActive(); }
 
     private:
+        /**
+         * Registers a cursor over the chunk's range of the shard key index for clone() to read
+         * from, for a chunk with too many documents to keep their disklocs.
+         * Must be called within the collection's read lock.
+         */
+        bool _startStreamingClone( long long estimatedSize , string& errmsg ) {
+            NamespaceDetails *d = nsdetails( _ns );
+            const IndexDetails *idx = d ? d->findIndexByPrefix( _shardKeyPattern , true ) : NULL;
+            if ( idx == NULL ) {
+                errmsg = "shard key index went away while scanning chunk to move";
+                return false;
+            }
+
+            KeyPattern kp( idx->keyPattern() );
+            BSONObj min = Helpers::toKeyFormat( kp.extendRangeBound( _min, false ) );
+            BSONObj max = Helpers::toKeyFormat( kp.extendRangeBound( _max, false ) );
+
+            ClientCursor* cc =
+                    new ClientCursor( QueryOption_NoCursorTimeout ,
+                            shared_ptr<Cursor>( BtreeCursor::make( d , *idx , min , max , false , 1 ) ) ,
+                            _ns );
+            ClientCursor::YieldData data;
+            verify( cc->prepareToYield( data ) );
+
+            log() << "moveChunk cloning chunk of size (approximately) " << estimatedSize
+                  << " with a single shard key value off the index"
+                  << " ns: " << _ns << " " << _min << " -> " << _max << migrateLog;
+
+            scoped_spinlock lk( _trackerLocks );
+            _cloneCursorId = cc->cursorid();
+            return true;
+        }
+
+        /**
+         * Fills 'a' with the next documents from the streaming clone cursor.  Deletes are
+         * handled by the cursor itself; documents it may miss or see twice because they were
+         * written during the clone are sent again through transferMods, as with disklocs.
+         */
+        bool _cloneStreaming( CursorId cloneCursorId , BSONArrayBuilder& a , string& errmsg ) {
+            Client::ReadContext ctx( _ns );
+            ClientCursor::Pin pin( cloneCursorId );
+            ClientCursor* cc = pin.c();
+            if ( ! cc ) {
+                errmsg = "clone cursor not found, collection or index dropped?";
+                return false;
+            }
+
+            Cursor* c = cc->c();
+            c->recoverFromYield();
+            while ( c->ok() ) {
+                BSONObj o = c->current();
+                if ( a.len() + o.objsize() + 1024 > BSONObjMaxUserSize )
+                    break;
+
+                a.append( o );
+                c->advance();
+
+                if ( ! cc->yieldSometimes( ClientCursor::WillNeed ) ) {
+                    errmsg = "clone cursor deleted on yield, collection or index dropped?";
+                    return false;
+                }
+            }
+
+            if ( ! c->ok() ) {
+                pin.release();
+                ClientCursor::erase( cloneCursorId );
+                scoped_spinlock lk( _trackerLocks );
+                _cloneCursorId = 0;
+                return true;
+            }
+
+            ClientCursor::YieldData data;
+            verify( cc->prepareToYield( data ) );
+            return true;
+        }
+
+        void _appendCloneBatch( const BSONArray& objects , bool compress , BSONObjBuilder& result ) {
+            if ( compress ) {
+                string compressed;
+                mongo::compress( objects.objdata(), objects.objsize(), &compressed );
+                // fall back if it didn't help, an incompressible batch could exceed the max size
+                if ( compressed.size() < static_cast<size_t>( objects.objsize() ) ) {
+                    result.appendBinData( "compressedObjects", compressed.size(), BinDataGeneral,
+                                          compressed.data() );
+                    return;
+                }
+            }
+
+            result.appendArray( "objects" , objects );
+        }
+
         mutable mongo::mutex _mutex; // protect _inCriticalSection and _active
         boost::condition _inCriticalSectionCV;
 
@@ -601,6 +778,9 @@ namespace mongo {
         // updates applied by 1 thread in a write lock
         set<DiskLoc> _cloneLocs;
 
+        // instead of _cloneLocs, for a chunk too large to keep them; 0 when not in use
+        CursorId _cloneCursorId;
+
         list<BSONObj> _reload; // objects that were modified that must be recloned
         list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
         long long _memoryUsed; // bytes in _reload + _deleted
@@ -679,7 +859,7 @@ namespace mongo {
             out->push_back(Privilege(AuthorizationManager::SERVER_RESOURCE_NAME, actions));
         }
         bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
-            return migrateFromStatus.clone( errmsg, result );
+            return migrateFromStatus.clone( cmdObj["compress"].trueValue(), errmsg, result );
         }
     } initialCloneCommand;
 
@@ -1420,8 +1600,124 @@ namespace mongo {
        commend to "commit"
     */
 
+    /**
+     * Fetches the batches of the initial clone from the donor on a background thread, so the
+     * next _migrateClone is on the wire while the recipient inserts the current one.
+     */
+    class MigrateCloneFetcher : boost::noncopyable {
+    public:
+        // batches received but not yet inserted
+        static const size_t MaxBatchesAhead = 2;
+
+        /**
+         * 'conn' must not be used by anyone else until stop() returns.
+         */
+        MigrateCloneFetcher( DBClientBase* conn , bool compress )
+            : _conn( conn ), _compress( compress ), _queue( MaxBatchesAhead + 1 ) {
+        }
+
+        ~MigrateCloneFetcher() {
+            stop();
+        }
+
+        void start() {
+            verify( ! _thread );
+            _thread.reset( new boost::thread( boost::bind( &MigrateCloneFetcher::run, this ) ) );
+        }
+
+        /**
+         * Waits for the next batch.  An empty batch means the clone is complete.
+         * @return false if the donor couldn't be asked, with the reason in errmsg
+         */
+        bool next( BSONObj* objects , string& errmsg ) {
+            Batch batch = _queue.blockingPop();
+            if ( ! batch.errmsg.empty() ) {
+                errmsg = batch.errmsg;
+                return false;
+            }
+            *objects = batch.objects;
+            return true;
+        }
+
+        /**
+         * Waits for the fetch thread to exit, discarding anything it fetched meanwhile.
+         */
+        void stop() {
+            if ( ! _thread )
+                return;
+
+            _stop.store( 1 );
+            Batch discard;
+            while ( ! _thread->timed_join( boost::posix_time::milliseconds( 10 ) ) )
+                _queue.tryPop( discard );
+            _thread.reset();
+        }
+
+    private:
+        struct Batch {
+            BSONObj objects;
+            string errmsg;
+        };
+
+        void run() {
+            while ( ! _stop.load() ) {
+                Batch batch;
+                try {
+                    fetch( &batch );
+                }
+                catch ( const DBException& e ) {
+                    batch.errmsg = str::stream() << "_migrateClone failed: " << e.toString();
+                }
+
+                _queue.push( batch );
+
+                if ( ! batch.errmsg.empty() || batch.objects.isEmpty() )
+                    return;
+            }
+        }
+
+        void fetch( Batch* batch ) {
+            BSONObj res;
+            // gets array of objects to copy, in disk order
+            if ( ! _conn->runCommand( "admin" ,
+                                      BSON( "_migrateClone" << 1 << "compress" << _compress ) ,
+                                      res ) ) {
+                batch->errmsg = "_migrateClone failed: ";
+                batch->errmsg += res.toString();
+                return;
+            }
+
+            // a donor that doesn't know about compression always sends 'objects'
+            BSONElement compressed = res["compressedObjects"];
+            if ( compressed.eoo() ) {
+                batch->objects = res["objects"].Obj().getOwned();
+                return;
+            }
+
+            int len;
+            const char* data = compressed.binData( len );
+            string uncompressed;
+            if ( ! uncompress( data, len, &uncompressed ) ||
+                 uncompressed.size() < 5 ||
+                 static_cast<size_t>( BSONObj( uncompressed.data() ).objsize() ) !=
+                     uncompressed.size() ) {
+                batch->errmsg = "_migrateClone failed: corrupt compressed batch";
+                return;
+            }
+            batch->objects = BSONObj( uncompressed.data() ).getOwned();
+        }
+
+        DBClientBase* const _conn;
+        const bool _compress;
+        BlockingQueue<Batch> _queue;
+        AtomicUInt32 _stop;
+        boost::scoped_ptr<boost::thread> _thread;
+    };
+
     class MigrateStatus {
     public:
+        // documents inserted per write lock during the initial clone
+        static const size_t CloneInsertGroupSize = 128;
         
         MigrateStatus() : m_active("MigrateStatus") { active = false; }
 
@@ -1571,44 +1867,59 @@ namespace mongo {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                MigrateCloneFetcher fetcher( conn.get(), migrateCloneCompression );
+                fetcher.start();
+
                 while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {  // gets array of objects to copy, in disk order
+                    BSONObj arr;
+                    if ( ! fetcher.next( &arr, errmsg ) ) {
                         state = FAIL;
-                        errmsg = "_migrateClone failed: ";
-                        errmsg += res.toString();
                         error() << errmsg << migrateLog;
+                        fetcher.stop();
                         conn.done();
                         return;
                     }
 
-                    BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
-
+                    vector<BSONObj> objects;
                     BSONObjIterator i( arr );
-                    while( i.more() ) {
-                        BSONObj o = i.next().Obj();
+                    while( i.more() )
+                        objects.push_back( i.next().Obj() );
+
+                    if ( objects.empty() )
+                        break;
+
+                    // insert under one write lock per group rather than per document
+                    size_t pos = 0;
+                    while ( pos < objects.size() ) {
+                        const size_t groupEnd = std::min( pos + CloneInsertGroupSize, objects.size() );
                         {
                             PageFaultRetryableSection pgrs;
                             while ( 1 ) {
                                 try {
                                     Client::WriteContext cx( ns );
 
-                                    BSONObj localDoc;
-                                    if ( willOverrideLocalId( o, &localDoc ) ) {
-                                        string errMsg =
-                                            str::stream() << "cannot migrate chunk, local document "
-                                                          << localDoc
-                                                          << " has same _id as cloned "
-                                                          << "remote document " << o;
+                                    // on a page fault, resume after the last document inserted
+                                    for ( ; pos < groupEnd; pos++ ) {
+                                        const BSONObj& o = objects[pos];
 
-                                        warning() << errMsg << endl;
+                                        BSONObj localDoc;
+                                        if ( willOverrideLocalId( o, &localDoc ) ) {
+                                            string errMsg =
+                                                str::stream() << "cannot migrate chunk, local document "
+                                                              << localDoc
+                                                              << " has same _id as cloned "
+                                                              << "remote document " << o;
 
-                                        // Exception will abort migration cleanly
-                                        uasserted( 16976, errMsg );
-                                    }
+                                            warning() << errMsg << endl;
+
+                                            // Exception will abort migration cleanly
+                                            uasserted( 16976, errMsg );
+                                        }
 
-                                    Helpers::upsert( ns, o, true );
+                                        Helpers::upsert( ns, o, true );
+                                        numCloned++;
+                                        clonedBytes += o.objsize();
+                                    }
                                     break;
                                 }
                                 catch ( PageFaultException& e ) {
@@ -1616,21 +1927,18 @@ namespace mongo {
                                 }
                             }
                         }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
 
-                        if ( secondaryThrottle && thisTime > 0 ) {
+                        if ( secondaryThrottle ) {
                             if ( ! waitForReplication( cc().getLastOp(), 2, 60 /* seconds to wait */ ) ) {
                                 warning() << "secondaryThrottle on, but doc insert timed out after 60 seconds, continuing" << endl;
                             }
                         }
                     }
-
-                    if ( thisTime == 0 )
-                        break;
                 }
 
+                // the fetcher is done with conn once it has handed over the empty batch
+                fetcher.stop();
+
                 timing.done(3);
             }
 
@@ -44,6 +44,73 @@
 
 namespace mongo {
 
+    namespace {
+
+        /**
+         * Remembers the chunks a splitVector scan found no split point in, along with how many
+         * keys it saw.  Each mongos estimates chunk growth from its own writes and asks on its
+         * own schedule; this lets the shard turn repeat asks away while its own insert count
+         * for the collection says the chunk can't have grown enough to split.
+         */
+        class FruitlessSplitScans {
+        public:
+            FruitlessSplitScans() : _mutex( "FruitlessSplitScans" ) {}
+
+            /**
+             * @return true if the last scan of [min, max) plus every insert into 'ns' since
+             * still can't make more than 'keyCount' keys.
+             */
+            bool stillTooSmall( const string& ns, const BSONObj& min, const BSONObj& max,
+                                long long keyCount, unsigned long long inserts ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                ScanMap::const_iterator i = _scans.find( key( ns, min, max ) );
+                if ( i == _scans.end() )
+                    return false;
+                const Scan& scan = i->second;
+
+                // the insert count restarts if the collection's transient state was reset
+                if ( inserts < scan.inserts )
+                    return false;
+                return static_cast<long long>( inserts - scan.inserts ) < keyCount - scan.keysSeen;
+            }
+
+            void record( const string& ns, const BSONObj& min, const BSONObj& max,
+                         unsigned long long inserts, long long keysSeen ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                if ( _scans.size() >= kMaxEntries )
+                    _scans.clear();
+                Scan& scan = _scans[key( ns, min, max )];
+                scan.inserts = inserts;
+                scan.keysSeen = keysSeen;
+            }
+
+            void forget( const string& ns, const BSONObj& min, const BSONObj& max ) {
+                SimpleMutex::scoped_lock lk( _mutex );
+                _scans.erase( key( ns, min, max ) );
+            }
+
+        private:
+            static const size_t kMaxEntries = 10000;
+
+            struct Scan {
+                unsigned long long inserts; // the collection's insert count before the scan
+                long long keysSeen;
+            };
+
+            typedef map<string,Scan> ScanMap;
+
+            static string key( const string& ns, const BSONObj& min, const BSONObj& max ) {
+                string k( ns );
+                k.append( min.objdata(), min.objsize() );
+                k.append( max.objdata(), max.objsize() );
+                return k;
+            }
+
+            SimpleMutex _mutex;
+            ScanMap _scans;
+        } fruitlessSplitScans;
+
+    }  // namespace
 
     class CmdMedianKey : public Command {
     public:
@@ -339,6 +406,18 @@ namespace mongo {
                     log() << "limiting split vector to " << maxChunkObjects << " (from " << keyCount << ") objects " << endl;
                     keyCount = maxChunkObjects;
                 }
+
+                const unsigned long long inserts = NamespaceDetailsTransient::get( ns ).insertCount();
+                if ( ! forceMedianSplit
+                        && fruitlessSplitScans.stillTooSmall( ns, min, max, keyCount, inserts ) ) {
+                    LOG(1) << "not enough inserts since the last lookup for chunk " << ns << " "
+                           << min << " -->> " << max << " found no split points" << endl;
+                    vector<BSONObj> emptyVector;
+                    result.append( "splitKeys" , emptyVector );
+                    return true;
+                }
+                const bool forced = forceMedianSplit;
+                bool scannedAll = true;
                 
                 //
                 // 2. Traverse the index and add the keyCount-th key to the result vector. If that key
@@ -402,6 +481,7 @@ namespace mongo {
                             // don't use the btree cursor pointer to access keys beyond this point but ok
                             // to use it for format the keys we've got already
                             cc.release();
+                            scannedAll = false;
                             break;
                         }
                     }
@@ -438,6 +518,13 @@ namespace mongo {
                 // Remove the sentinel at the beginning before returning
                 splitKeys.erase( splitKeys.begin() );
                 verify( c.get() );
+
+                if ( splitKeys.empty() && scannedAll && ! forced ) {
+                    fruitlessSplitScans.record( ns, min, max, inserts, currCount );
+                }
+                else {
+                    fruitlessSplitScans.forget( ns, min, max );
+                }
                 
                 if ( timer.millis() > cmdLine.slowMS ) {
                     warning() << "Finding the split vector for " <<  ns << " over "<< keyPattern
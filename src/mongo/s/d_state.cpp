@@ -158,48 +158,47 @@ namespace mongo {
     }
 
     void ShardingState::donateChunk( const string& ns , const BSONObj& min , const BSONObj& max , ChunkVersion version ) {
-        scoped_lock lk( _mutex );
-
-        CollectionMetadataMap::const_iterator it = _collMetadata.find( ns );
-        verify( it != _collMetadata.end() ) ;
-        CollectionMetadataPtr p = it->second;
-
-        // empty shards should have version 0
-        version =
-                ( p->getNumChunks() > 1 ) ?
-                        version : ChunkVersion( 0, 0, p->getCollVersion().epoch() );
-
         ChunkType chunk;
         chunk.setMin( min );
         chunk.setMax( max );
-        string errMsg;
 
-        CollectionMetadataPtr cloned( p->cloneMinusChunk( chunk, version, &errMsg ) );
-        // uassert to match old behavior, TODO: report errors w/o throwing
-        uassert( 16855, errMsg, NULL != cloned.get() );
-
-        // TODO: a bit dangerous to have two different zero-version states - no-metadata and
-        // no-version
-        _collMetadata[ns] = cloned;
+        CollectionMetadataPtr p;
+        CollectionMetadataPtr cloned;
+        do {
+            p = getCollectionMetadata( ns );
+            verify( p.get() );
+
+            // empty shards should have version 0
+            ChunkVersion newVersion =
+                    ( p->getNumChunks() > 1 ) ?
+                            version : ChunkVersion( 0, 0, p->getCollVersion().epoch() );
+
+            string errMsg;
+            cloned.reset( p->cloneMinusChunk( chunk, newVersion, &errMsg ) );
+            // uassert to match old behavior, TODO: report errors w/o throwing
+            uassert( 16855, errMsg, NULL != cloned.get() );
+
+            // TODO: a bit dangerous to have two different zero-version states - no-metadata and
+            // no-version
+        } while ( !_installClone( ns, p, cloned ) );
     }
 
     void ShardingState::undoDonateChunk( const string& ns , const BSONObj& min , const BSONObj& max , ChunkVersion version ) {
-        scoped_lock lk( _mutex );
-        log() << "ShardingState::undoDonateChunk acquired _mutex" << endl;
-
-        CollectionMetadataMap::const_iterator it = _collMetadata.find( ns );
-        verify( it != _collMetadata.end() ) ;
-
         ChunkType chunk;
         chunk.setMin( min );
         chunk.setMax( max );
-        string errMsg;
-
-        CollectionMetadataPtr cloned( it->second->clonePlusChunk( chunk, version, &errMsg ) );
-        // uassert to match old behavior, TODO: report errors w/o throwing
-        uassert( 16856, errMsg, NULL != cloned.get() );
 
-        _collMetadata[ns] = cloned;
+        CollectionMetadataPtr p;
+        CollectionMetadataPtr cloned;
+        do {
+            p = getCollectionMetadata( ns );
+            verify( p.get() );
+
+            string errMsg;
+            cloned.reset( p->clonePlusChunk( chunk, version, &errMsg ) );
+            // uassert to match old behavior, TODO: report errors w/o throwing
+            uassert( 16856, errMsg, NULL != cloned.get() );
+        } while ( !_installClone( ns, p, cloned ) );
     }
 
     bool ShardingState::notePending( const string& ns,
@@ -207,40 +206,41 @@ namespace mongo {
                                      const BSONObj& max,
                                      const OID& epoch,
                                      string* errMsg ) {
-        scoped_lock lk( _mutex );
-
-        CollectionMetadataMap::const_iterator it = _collMetadata.find( ns );
-        if ( it == _collMetadata.end() ) {
+        ChunkType chunk;
+        chunk.setMin( min );
+        chunk.setMax( max );
 
-            *errMsg = str::stream() << "could not note chunk " << "[" << min << "," << max << ")"
-                                    << " as pending because the local metadata for " << ns
-                                    << " has changed";
+        CollectionMetadataPtr metadata;
+        CollectionMetadataPtr cloned;
+        do {
+            metadata = getCollectionMetadata( ns );
+            if ( !metadata ) {
 
-            return false;
-        }
+                *errMsg = str::stream() << "could not note chunk "
+                                        << "[" << min << "," << max << ")"
+                                        << " as pending because the local metadata for " << ns
+                                        << " has changed";
 
-        CollectionMetadataPtr metadata = it->second;
+                return false;
+            }
 
-        // This can currently happen because drops aren't synchronized with in-migrations
-        // The idea for checking this here is that in the future we shouldn't have this problem
-        if ( metadata->getCollVersion().epoch() != epoch ) {
+            // This can currently happen because drops aren't synchronized with in-migrations
+            // The idea for checking this here is that in the future we shouldn't have this problem
+            if ( metadata->getCollVersion().epoch() != epoch ) {
 
-            *errMsg = str::stream() << "could not note chunk " << "[" << min << "," << max << ")"
-                                    << " as pending because the epoch for " << ns
-                                    << " has changed from "
-                                    << epoch << " to " << metadata->getCollVersion().epoch();
+                *errMsg = str::stream() << "could not note chunk "
+                                        << "[" << min << "," << max << ")"
+                                        << " as pending because the epoch for " << ns
+                                        << " has changed from "
+                                        << epoch << " to " << metadata->getCollVersion().epoch();
 
-            return false;
-        }
-
-        ChunkType chunk;
-        chunk.setMin( min );
-        chunk.setMax( max );
+                return false;
+            }
 
-        CollectionMetadataPtr cloned( metadata->clonePlusPending( chunk, errMsg ) );
-        if ( !cloned ) return false;
+            cloned.reset( metadata->clonePlusPending( chunk, errMsg ) );
+            if ( !cloned ) return false;
+        } while ( !_installClone( ns, metadata, cloned ) );
 
-        _collMetadata[ns] = cloned;
         return true;
     }
 
@@ -249,40 +249,40 @@ namespace mongo {
                                        const BSONObj& max,
                                        const OID& epoch,
                                        string* errMsg ) {
-        scoped_lock lk( _mutex );
-
-        CollectionMetadataMap::const_iterator it = _collMetadata.find( ns );
-        if ( it == _collMetadata.end() ) {
-
-            *errMsg = str::stream() << "no need to forget pending chunk "
-                                    << "[" << min << "," << max << ")"
-                                    << " because the local metadata for " << ns << " has changed";
+        ChunkType chunk;
+        chunk.setMin( min );
+        chunk.setMax( max );
 
-            return false;
-        }
+        CollectionMetadataPtr metadata;
+        CollectionMetadataPtr cloned;
+        do {
+            metadata = getCollectionMetadata( ns );
+            if ( !metadata ) {
 
-        CollectionMetadataPtr metadata = it->second;
+                *errMsg = str::stream() << "no need to forget pending chunk "
+                                        << "[" << min << "," << max << ")"
+                                        << " because the local metadata for " << ns
+                                        << " has changed";
 
-        // This can currently happen because drops aren't synchronized with in-migrations
-        // The idea for checking this here is that in the future we shouldn't have this problem
-        if ( metadata->getCollVersion().epoch() != epoch ) {
+                return false;
+            }
 
-            *errMsg = str::stream() << "no need to forget pending chunk "
-                                    << "[" << min << "," << max << ")"
-                                    << " because the epoch for " << ns << " has changed from "
-                                    << epoch << " to " << metadata->getCollVersion().epoch();
+            // This can currently happen because drops aren't synchronized with in-migrations
+            // The idea for checking this here is that in the future we shouldn't have this problem
+            if ( metadata->getCollVersion().epoch() != epoch ) {
 
-            return false;
-        }
+                *errMsg = str::stream() << "no need to forget pending chunk "
+                                        << "[" << min << "," << max << ")"
+                                        << " because the epoch for " << ns << " has changed from "
+                                        << epoch << " to " << metadata->getCollVersion().epoch();
 
-        ChunkType chunk;
-        chunk.setMin( min );
-        chunk.setMax( max );
+                return false;
+            }
 
-        CollectionMetadataPtr cloned( metadata->cloneMinusPending( chunk, errMsg ) );
-        if ( !cloned ) return false;
+            cloned.reset( metadata->cloneMinusPending( chunk, errMsg ) );
+            if ( !cloned ) return false;
+        } while ( !_installClone( ns, metadata, cloned ) );
 
-        _collMetadata[ns] = cloned;
         return true;
     }
 
@@ -292,21 +292,37 @@ namespace mongo {
                                     const vector<BSONObj>& splitKeys,
                                     ChunkVersion version )
     {
-        scoped_lock lk( _mutex );
-
-        CollectionMetadataMap::const_iterator it = _collMetadata.find( ns );
-        verify( it != _collMetadata.end() ) ;
-
         ChunkType chunk;
         chunk.setMin( min );
         chunk.setMax( max );
-        string errMsg;
 
-        CollectionMetadataPtr cloned( it->second->cloneSplit( chunk, splitKeys, version, &errMsg ) );
-        // uassert to match old behavior, TODO: report errors w/o throwing
-        uassert( 16857, errMsg, NULL != cloned.get() );
+        CollectionMetadataPtr p;
+        CollectionMetadataPtr cloned;
+        do {
+            p = getCollectionMetadata( ns );
+            verify( p.get() );
+
+            string errMsg;
+            cloned.reset( p->cloneSplit( chunk, splitKeys, version, &errMsg ) );
+            // uassert to match old behavior, TODO: report errors w/o throwing
+            uassert( 16857, errMsg, NULL != cloned.get() );
+        } while ( !_installClone( ns, p, cloned ) );
+    }
+
+    bool ShardingState::_installClone( const string& ns,
+                                       const CollectionMetadataPtr& base,
+                                       const CollectionMetadataPtr& cloned ) {
+        scoped_lock lk( _mutex );
 
-        _collMetadata[ns] = cloned;
+        CollectionMetadataMap::iterator it = _collMetadata.find( ns );
+        if ( it == _collMetadata.end() || it->second != base ) {
+            LOG( 1 ) << "metadata for " << ns << " changed while cloning it, cloning again"
+                     << endl;
+            return false;
+        }
+
+        it->second = cloned;
+        return true;
     }
 
     void ShardingState::resetVersion( const string& ns ) {
@@ -482,6 +498,7 @@ namespace mongo {
 
     ShardedConnectionInfo::ShardedConnectionInfo() {
         _forceVersionOk = false;
+        _inlineWritebacks = false;
         _id.clear();
     }
 
@@ -499,6 +516,15 @@ namespace mongo {
         _tl.reset();
     }
 
+    ShardedConnectionInfo* ShardedConnectionInfo::release() {
+        return _tl.release();
+    }
+
+    void ShardedConnectionInfo::adopt( ShardedConnectionInfo* info ) {
+        verify( _tl.get() == 0 );
+        _tl.reset( info );
+    }
+
     const ChunkVersion ShardedConnectionInfo::getVersion( const string& ns ) const {
         NSVersionMap::const_iterator it = _versions.find( ns );
         if ( it != _versions.end() ) {
@@ -676,6 +702,9 @@ namespace mongo {
             if ( ! checkMongosID( info , cmdObj["serverID"] , errmsg ) ) 
                 return false;
 
+            if ( cmdObj["inlineWriteback"].trueValue() )
+                info->setInlineWritebacks( true );
+
             bool authoritative = cmdObj.getBoolField( "authoritative" );
             
             // check config server is ok or enable sharding
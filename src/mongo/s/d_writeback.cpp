@@ -52,7 +52,8 @@ namespace mongo {
     WriteBackManager::~WriteBackManager() {
     }
 
-    OID WriteBackManager::queueWriteBack( const string& remote , BSONObjBuilder& b ) {
+    OID WriteBackManager::queueWriteBack( const string& remote , BSONObjBuilder& b ,
+                                          BSONObj* queued ) {
         static mongo::mutex writebackIDOrdering( "WriteBackManager::queueWriteBack id ordering" );
         
         scoped_lock lk( writebackIDOrdering );
@@ -61,7 +62,10 @@ namespace mongo {
         writebackID.initSequential();
         b.append( "id", writebackID );
         
-        getWritebackQueue( remote )->queue.push( b.obj() );
+        BSONObj op = b.obj();
+        getWritebackQueue( remote )->queue.push( op );
+        if ( queued )
+            *queued = op;
 
         return writebackID;
     }
@@ -56,13 +56,15 @@ namespace mongo {
         /*
          * @param remote server ID this operation came from
          * @param op the operation itself
+         * @param queued if not NULL, set to the queued object, id included
          *
          * Enqueues operation 'op' in server 'remote's queue. The operation will be written back to
          * remote at a later stage.
          *
          * @return the writebackId generated
          */
-        OID queueWriteBack( const string& remote , BSONObjBuilder& opBuilder );
+        OID queueWriteBack( const string& remote , BSONObjBuilder& opBuilder ,
+                            BSONObj* queued = NULL );
 
         /*
          * @param remote server ID
@@ -48,6 +48,13 @@ namespace mongo {
                  str::stream() << "invalid database name: " << database,
                  NamespaceString::validDBName( database ) );
 
+        {
+            DBConfigMapPtr loaded = boost::atomic_load( &_loadedDatabases );
+            DBConfigMap::const_iterator i = loaded->find( database );
+            if ( i != loaded->end() )
+                return i->second;
+        }
+
         scoped_lock l( _lock );
 
         DBConfigPtr& dbConfig = _databases[database];
@@ -92,7 +99,10 @@ namespace mongo {
                             if (!dbObj.isEmpty() &&
                                 dbObj[DatabaseType::name()].String() == database)
                             {
-                                if (dbConfig->load()) return dbConfig;
+                                if (dbConfig->load()) {
+                                    _publishDatabases_inlock();
+                                    return dbConfig;
+                                }
                             }
 
                             // TODO: This really shouldn't fall through, but without metadata
@@ -145,6 +155,7 @@ namespace mongo {
             }
         }
 
+        _publishDatabases_inlock();
         return dbConfig;
     }
 
@@ -152,6 +163,7 @@ namespace mongo {
         uassert( 10186 ,  "removeDB expects db name" , database.find( '.' ) == string::npos );
         scoped_lock l( _lock );
         _databases.erase( database );
+        _publishDatabases_inlock();
 
     }
 
@@ -163,6 +175,7 @@ namespace mongo {
         if( it != _databases.end() && it->second.get() == &database ){
 
             _databases.erase( it );
+            _publishDatabases_inlock();
             log() << "erased database " << database.getName() << " from local registry" << endl;
         }
         else{
@@ -589,6 +602,16 @@ namespace mongo {
     void Grid::flushConfig() {
         scoped_lock lk( _lock );
         _databases.clear();
+        _publishDatabases_inlock();
+    }
+
+    void Grid::_publishDatabases_inlock() {
+        boost::shared_ptr<DBConfigMap> loaded( new DBConfigMap() );
+        for ( DBConfigMap::const_iterator i = _databases.begin(); i != _databases.end(); ++i ) {
+            if ( i->second )
+                (*loaded)[i->first] = i->second;
+        }
+        boost::atomic_store( &_loadedDatabases, DBConfigMapPtr( loaded ) );
     }
 
     BSONObj Grid::getConfigSetting( const std::string& name ) const {
@@ -33,7 +33,7 @@ namespace mongo {
      */
     class Grid {
     public:
-        Grid() : _lock( "Grid" ) , _allowLocalShard( true ) { }
+        Grid() : _lock( "Grid" ) , _loadedDatabases( new DBConfigMap() ) , _allowLocalShard( true ) { }
 
         /**
          * gets the config the db.
@@ -122,10 +122,23 @@ namespace mongo {
         static bool _inBalancingWindow( const BSONObj& balancerDoc , const boost::posix_time::ptime& now );
 
     private:
+        typedef map<string, DBConfigPtr> DBConfigMap;
+        typedef boost::shared_ptr<const DBConfigMap> DBConfigMapPtr;
+
         mongo::mutex              _lock;            // protects _databases; TODO: change to r/w lock ??
         map<string, DBConfigPtr > _databases;       // maps ns to DBConfig's
+
+        // Immutable copy of the loaded entries of _databases, so getDBConfig can find them
+        // without _lock.  Replaced as a whole through boost::atomic_load/atomic_store.
+        DBConfigMapPtr            _loadedDatabases;
         bool                      _allowLocalShard; // can 'localhost' be used in shard addresses?
 
+        /**
+         * Rebuilds _loadedDatabases from _databases.  Must be called under _lock after
+         * _databases changes.
+         */
+        void _publishDatabases_inlock();
+
         /**
          * @param name is the chose name for the shard. Parameter is mandatory.
          * @return true if it managed to generate a shard name. May return false if (currently)
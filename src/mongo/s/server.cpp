@@ -31,6 +31,7 @@
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/logger/async_log_writer.h"
 #include "mongo/platform/process_id.h"
 #include "mongo/s/balance.h"
 #include "mongo/s/chunk.h"
@@ -373,6 +374,8 @@ static void processCommandLineOptions(const std::vector<std::string>& argv) {
     ( "configdb" , po::value<string>() , "1 or 3 comma separated config servers" )
     ( "localThreshold", po::value <int>(), "ping time (in ms) for a node to be "
                                            "considered local (default 15ms)" )
+    ( "latencyAwareReads", "choose among local nodes by observed latency and requests in "
+                           "flight instead of round robin" )
     ( "test" , "just run unit tests" )
     ( "upgrade" , "upgrade meta data version" )
     ( "chunkSize" , po::value<int>(), "maximum amount of data per chunk" )
@@ -436,6 +439,10 @@ static void processCommandLineOptions(const std::vector<std::string>& argv) {
         cmdLine.defaultLocalThresholdMillis = params["localThreshold"].as<int>();
     }
 
+    if ( params.count( "latencyAwareReads" ) ) {
+        cmdLine.latencyAwareReads = true;
+    }
+
     if ( params.count( "ipv6" ) ) {
         enableIPv6();
     }
@@ -631,5 +638,6 @@ void mongo::dbexit( ExitCode rc, const char *why ) {
           << " rc:" << rc
           << " " << ( why ? why : "" )
           << endl;
+    logger::AsyncLogWriter::flushAll();
     ::_exit(rc);
 }
@@ -397,6 +397,11 @@ namespace mongo {
     ShardStatus::ShardStatus( const Shard& shard , const BSONObj& obj )
         : _shard( shard ) {
         _mapped = obj.getFieldDotted( "mem.mapped" ).numberLong();
+        _resident = obj.getFieldDotted( "mem.resident" ).numberLong();
+        _opsTotal = 0;
+        BSONForEach( counter, obj.getObjectField( "opcounters" ) ) {
+            _opsTotal += counter.numberLong();
+        }
         _hasOpsQueued = obj["writeBacksQueued"].Bool();
         _writeLock = 0; // TODO
         _mongoVersion = obj["version"].String();
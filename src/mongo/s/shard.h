@@ -202,6 +202,16 @@ namespace mongo {
             return _mapped;
         }
 
+        /** resident memory in MB */
+        long long resident() const {
+            return _resident;
+        }
+
+        /** operations served since the shard started, from its opcounters */
+        long long opsTotal() const {
+            return _opsTotal;
+        }
+
         bool hasOpsQueued() const {
             return _hasOpsQueued;
         }
@@ -213,6 +223,8 @@ namespace mongo {
     private:
         Shard _shard;
         long long _mapped;
+        long long _resident;
+        long long _opsTotal;
         bool _hasOpsQueued;  // true if 'writebacks' are pending
         double _writeLock;
         string _mongoVersion;
@@ -196,6 +196,7 @@ namespace mongo {
                 }
 
                 if (!isConnGood) {
+                    shardConnectionPool.decrementEgressConnectionCount(addr, s->avail);
                     delete s->avail;
                     s->avail = NULL;
                 }
@@ -316,6 +317,8 @@ namespace mongo {
         void clearPool() {
             for(HostMap::iterator iter = _hosts.begin(); iter != _hosts.end(); ++iter) {
                 if (iter->second->avail != NULL) {
+                    shardConnectionPool.decrementEgressConnectionCount(iter->first,
+                                                                       iter->second->avail);
                     delete iter->second->avail;
                 }
             }
@@ -419,6 +422,7 @@ namespace mongo {
                 ClientConnections::threadInstance()->done(_addr, _conn);
             }
             else {
+                shardConnectionPool.decrementEgressConnectionCount(_addr, _conn);
                 delete _conn;
             }
 
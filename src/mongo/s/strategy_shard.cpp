@@ -28,6 +28,7 @@
 #include "mongo/db/commands.h"
 #include "mongo/db/index.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
 #include "mongo/s/client_info.h"
 #include "mongo/s/chunk.h"
@@ -42,6 +43,9 @@
 
 namespace mongo {
 
+    // Read the shard cursors of sharded queries ahead on background threads, one per shard.
+    MONGO_EXPORT_SERVER_PARAMETER(asyncShardCursors, bool, false);
+
     class ShardStrategy : public Strategy {
 
         bool _isSystemIndexes( const char* ns ) {
@@ -115,6 +119,7 @@ namespace mongo {
             }
 
             if( cursor->isSharded() ){
+                cursor->setAsyncFetch( asyncShardCursors );
                 ShardedClientCursorPtr cc (new ShardedClientCursor( q , cursor ));
 
                 BufBuilder buffer( ShardedClientCursor::INIT_REPLY_BUFFER_SIZE );
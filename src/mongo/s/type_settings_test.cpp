@@ -83,7 +83,9 @@ namespace {
                            SettingsType::balancerActiveWindow(BSON("start" << "23:00" <<
                                                                    "stop" << "6:00" )) <<
                            SettingsType::shortBalancerSleep(true) <<
-                           SettingsType::secondaryThrottle(true));
+                           SettingsType::secondaryThrottle(true) <<
+                           SettingsType::maxConcurrentMigrations(4) <<
+                           SettingsType::balanceByLoad(true));
         ASSERT(settings.parseBSON(objBalancer, &errMsg));
         ASSERT_EQUALS(errMsg, "");
         ASSERT_TRUE(settings.isValid(NULL));
@@ -93,6 +95,22 @@ namespace {
                                                                "stop" << "6:00" ));
         ASSERT_EQUALS(settings.getShortBalancerSleep(), true);
         ASSERT_EQUALS(settings.getSecondaryThrottle(), true);
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 4);
+        ASSERT_EQUALS(settings.getBalanceByLoad(), true);
+    }
+
+    TEST(Validity, MaxConcurrentMigrations) {
+        SettingsType settings;
+        string errMsg;
+        ASSERT(settings.parseBSON(BSON(SettingsType::key("balancer")), &errMsg));
+        ASSERT_TRUE(settings.isValid(NULL));
+        ASSERT_EQUALS(settings.getMaxConcurrentMigrations(), 1);
+        ASSERT_EQUALS(settings.getBalanceByLoad(), false);
+
+        ASSERT(settings.parseBSON(BSON(SettingsType::key("balancer") <<
+                                       SettingsType::maxConcurrentMigrations(0)), &errMsg));
+        ASSERT_FALSE(settings.isValid(&errMsg));
+        ASSERT_NOT_EQUALS(errMsg, "");
     }
 
     TEST(Validity, BadType) {
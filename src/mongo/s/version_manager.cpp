@@ -18,6 +18,7 @@
 
 #include "mongo/s/version_manager.h"
 
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/chunk.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/config.h"
@@ -31,6 +32,10 @@ namespace mongo {
     // Global version manager
     VersionManager versionManager;
 
+    // Have shards hand stale writes back in getLastError, for the client thread to replay,
+    // rather than only through the writeback listener.
+    MONGO_EXPORT_SERVER_PARAMETER(inlineWritebacks, bool, false);
+
     // when running in sharded mode, use chunk shard version control
     struct ConnectionShardStatus {
 
@@ -113,6 +118,8 @@ namespace mongo {
         cmdBuilder.append( "configdb" , configServer.modelServer() );
         cmdBuilder.appendOID( "serverID" , &serverID );
         cmdBuilder.appendBool( "authoritative" , true );
+        if ( inlineWritebacks )
+            cmdBuilder.appendBool( "inlineWriteback" , true );
 
         BSONObj cmd = cmdBuilder.obj();
 
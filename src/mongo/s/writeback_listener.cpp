@@ -40,6 +40,7 @@ namespace mongo {
 
     map<WriteBackListener::ConnectionIdent,WriteBackListener::WBStatus> WriteBackListener::_seenWritebacks;
     mongo::mutex WriteBackListener::_seenWritebacksLock("WriteBackListener::seen");
+    set<OID> WriteBackListener::_claimedWritebacks;
 
     WriteBackListener::WriteBackListener( const string& addr ) : _addr( addr ) {
         _name = str::stream() << "WriteBackListener-" << addr;
@@ -137,6 +138,120 @@ namespace mongo {
         throw 1; // never gets here
     }
 
+    /* static */
+    BSONObj WriteBackListener::replayInline( const ConnectionIdent& ident, const OID& oid,
+                                             const BSONObj& data ) {
+        bool claimed = false;
+        {
+            scoped_lock lk( _seenWritebacksLock );
+            if ( _seenWritebacks[ident].id < oid )
+                claimed = _claimedWritebacks.insert( oid ).second;
+        }
+
+        if ( ! claimed ) {
+            // the listener got to it first
+            return waitFor( ident, oid );
+        }
+
+        string ns = data["ns"].valuestrsafe();
+
+        int len; // not used, but needed for next call
+        Message msg( (void*)data["msg"].binData( len ) , false );
+        massert( 17001 ,  "invalid inline writeback message" , msg.header()->valid() );
+
+        DBConfigPtr db = grid.getDBConfig( ns );
+        ChunkVersion needVersion = ChunkVersion::fromBSON( data, "version" );
+
+        ChunkManagerPtr manager;
+        ShardPtr primary;
+        db->getChunkManagerOrPrimary( ns, manager, primary );
+
+        ChunkVersion currVersion;
+        if( manager ) currVersion = manager->getVersion();
+
+        LOG(1) << "replaying writeback " << oid << " inline for " << ns
+               << " needVersion : " << needVersion.toString()
+               << " mine : " << currVersion.toString() << endl;
+
+        // same reload rules as the listener, without its dedup of reloads across writebacks
+        if ( ! needVersion.isWriteCompatibleWith( currVersion ) ) {
+            if ( currVersion.isSet() && needVersion.isSet()
+                    && currVersion.hasCompatibleEpoch( needVersion ) ) {
+                db->getChunkManagerIfExists( ns, true );
+            }
+            else {
+                db->reload();
+            }
+        }
+
+        BSONObj gle;
+        int attempts = 0;
+        while ( true ) {
+            attempts++;
+
+            try {
+                Request r( msg , 0 );
+                r.init();
+
+                r.d().reservedField() |= Reserved_FromWriteback;
+
+                r.process( attempts );
+
+                ClientInfo * ci = r.getClientInfo();
+                ci->newRequest(); // this so we flip prev and cur shards
+
+                BSONObjBuilder b;
+                string errmsg;
+                if ( ! ci->getLastError( "admin", BSON( "getLastError" << 1 ), b, errmsg, true ) ) {
+                    b.appendBool( "commandFailed" , true );
+                    if( ! b.hasField( "errmsg" ) )
+                        b.append( "errmsg", errmsg );
+                }
+                gle = b.obj();
+
+                if ( gle["code"].numberInt() == 9517 ) {
+                    log() << "inline writeback failed because of stale config, retrying attempts: "
+                          << attempts << endl;
+
+                    if( attempts <= 2 ){
+                        db->getChunkManagerIfExists( ns, true );
+                    }
+                    else{
+                        versionManager.forceRemoteCheckShardVersionCB( ns );
+                        sleepsecs( attempts - 1 );
+                    }
+
+                    uassert( 17002, str::stream()
+                             << "Could not reload chunk manager after "
+                             << attempts << " attempts.", attempts <= 4 );
+
+                    continue;
+                }
+
+                ci->clearSinceLastGetError();
+            }
+            catch ( DBException& e ) {
+                error() << "error processing inline writeback: " << e << endl;
+                BSONObjBuilder b;
+                e.getInfo().append( b, "err", "code" );
+                gle = b.obj();
+            }
+
+            break;
+        }
+
+        {
+            scoped_lock lk( _seenWritebacksLock );
+            WBStatus& s = _seenWritebacks[ident];
+            if ( s.id < oid ) {
+                s.id = oid;
+                s.gle = gle;
+            }
+        }
+
+        return gle;
+    }
+
     void WriteBackListener::run() {
 
         int secsToSleep = 0;
@@ -195,6 +310,17 @@ namespace mongo {
                         warning() << "mongos/mongod version mismatch (1.7.5 is the split)" << endl;
                     }
 
+                    if ( wid.isSet() ) {
+                        scoped_lock lk( _seenWritebacksLock );
+                        if ( ! _claimedWritebacks.insert( wid ).second ) {
+                            // a getLastError already replayed it inline
+                            LOG(1) << "writeback " << wid << " was replayed inline" << endl;
+                            _claimedWritebacks.erase( wid );
+                            secsToSleep = 0;
+                            continue;
+                        }
+                    }
+
                     int len; // not used, but needed for next call
                     Message msg( (void*)data["msg"].binData( len ) , false );
                     massert( 10427 ,  "invalid writeback message" , msg.header()->valid() );
@@ -396,6 +522,7 @@ namespace mongo {
                         WBStatus& s = _seenWritebacks[cid];
                         s.id = wid;
                         s.gle = gle;
+                        _claimedWritebacks.erase( wid );
                     }
                 }
                 else if ( result["noop"].trueValue() ) {
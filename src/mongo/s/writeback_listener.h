@@ -63,6 +63,14 @@ namespace mongo {
 
         static BSONObj waitFor( const ConnectionIdent& ident, const OID& oid );
 
+        /**
+         * Replays on the calling thread a writeback that a shard handed back in getLastError,
+         * unless the listener already has it, in which case this waits for the listener.
+         * @return the getLastError of the replayed write
+         */
+        static BSONObj replayInline( const ConnectionIdent& ident, const OID& oid,
+                                     const BSONObj& data );
+
     protected:
         WriteBackListener( const string& addr );
 
@@ -84,6 +92,7 @@ namespace mongo {
 
         static mongo::mutex _seenWritebacksLock;  // protects _seenWritbacks
         static map<ConnectionIdent,WBStatus> _seenWritebacks; // connectionId -> last write back GLE
+        static set<OID> _claimedWritebacks; // writebacks being or already replayed, by either path
     };
 
     void waitForWriteback( const OID& oid );
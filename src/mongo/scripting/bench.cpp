@@ -28,6 +28,7 @@
 #include "mongo/scripting/bson_template_evaluator.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/md5.h"
+#include "mongo/util/time_support.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/version.h"
 
@@ -65,11 +66,13 @@ namespace mongo {
     void BenchRunEventCounter::reset() {
         _numEvents = 0;
         _totalTimeMicros = 0;
+        _latencies.reset();
     }
 
     void BenchRunEventCounter::updateFrom(const BenchRunEventCounter &other) {
         _numEvents += other._numEvents;
         _totalTimeMicros += other._totalTimeMicros;
+        _latencies.add(other._latencies);
     }
 
     BenchRunStats::BenchRunStats() {
@@ -87,6 +90,7 @@ namespace mongo {
         insertCounter.reset();
         deleteCounter.reset();
         queryCounter.reset();
+        commandCounter.reset();
 
         trappedErrors.clear();
     }
@@ -101,6 +105,7 @@ namespace mongo {
         insertCounter.updateFrom(other.insertCounter);
         deleteCounter.updateFrom(other.deleteCounter);
         queryCounter.updateFrom(other.queryCounter);
+        commandCounter.updateFrom(other.commandCounter);
 
         for (size_t i = 0; i < other.trappedErrors.size(); ++i)
             trappedErrors.push_back(other.trappedErrors[i]);
@@ -118,6 +123,8 @@ namespace mongo {
 
         parallel = 1;
         seconds = 1;
+        warmupSeconds = 0;
+        opsPerSecond = 0;
         hideResults = true;
         handleErrors = false;
         hideErrors = false;
@@ -155,6 +162,10 @@ namespace mongo {
             this->parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             this->seconds = args["seconds"].number();
+        if ( args["warmupSeconds"].isNumber() )
+            this->warmupSeconds = args["warmupSeconds"].number();
+        if ( args["opsPerSecond"].isNumber() )
+            this->opsPerSecond = args["opsPerSecond"].number();
         if ( ! args["hideResults"].eoo() )
             this->hideResults = args["hideResults"].trueValue();
         if ( ! args["handleErrors"].eoo() )
@@ -208,7 +219,8 @@ namespace mongo {
         : _mutex(),
           _numUnstartedWorkers( numWorkers ),
           _numActiveWorkers( 0 ),
-          _isShuttingDown( 0 ) {
+          _isShuttingDown( 0 ),
+          _isWarmingUp( 0 ) {
     }
 
     BenchRunState::~BenchRunState() {
@@ -239,6 +251,14 @@ namespace mongo {
         _isShuttingDown.set( 1 );
     }
 
+    void BenchRunState::beginWarmup() {
+        _isWarmingUp.set( 1 );
+    }
+
+    void BenchRunState::endWarmup() {
+        _isWarmingUp.set( 0 );
+    }
+
     void BenchRunState::assertFinished() {
         boost::mutex::scoped_lock lk(_mutex);
         verify(0 == _numUnstartedWorkers + _numActiveWorkers);
@@ -248,6 +268,10 @@ namespace mongo {
         return bool(_isShuttingDown.get());
     }
 
+    bool BenchRunState::isWarmingUp() {
+        return bool(_isWarmingUp.get());
+    }
+
     void BenchRunState::onWorkerStarted() {
         boost::mutex::scoped_lock lk(_mutex);
         verify( _numUnstartedWorkers > 0 );
@@ -318,12 +342,25 @@ namespace mongo {
 
         BsonTemplateEvaluator bsonTemplateEvaluator;
 
+        // in open loop, this thread's share of the rate fixes when each op is due
+        const double opIntervalMicros = _config->opsPerSecond > 0 ?
+            1000000.0 * _config->parallel / _config->opsPerSecond : 0;
+        double nextOpMicros = static_cast<double>( curTimeMicros64() );
+        bool warmingUp = _brState->isWarmingUp();
+
         while ( !shouldStop() ) {
             BSONObjIterator i( _config->ops );
             while ( i.more() ) {
 
                 if ( shouldStop() ) break;
 
+                if ( warmingUp && !_brState->isWarmingUp() ) {
+                    warmingUp = false;
+                    _stats.reset();
+                    // don't carry a backlog built up during warmup into the measurement
+                    nextOpMicros = static_cast<double>( curTimeMicros64() );
+                }
+
                 BSONElement e = i.next();
 
                 string ns = e["ns"].String();
@@ -367,12 +404,22 @@ namespace mongo {
                     }
                 }
 
+                unsigned long long startedLateMicros = 0;
+                if ( opIntervalMicros > 0 ) {
+                    const double now = static_cast<double>( curTimeMicros64() );
+                    if ( now < nextOpMicros )
+                        sleepmicros( static_cast<long long>( nextOpMicros - now ) );
+                    else
+                        startedLateMicros = static_cast<unsigned long long>( now - nextOpMicros );
+                    nextOpMicros += opIntervalMicros;
+                }
+
                 try {
                     if ( op == "findOne" ) {
 
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.findOneCounter);
+                            BenchRunEventTrace _bret(&_stats.findOneCounter, startedLateMicros);
                             result = conn->findOne( ns , fixQuery( e["query"].Obj(),
                                                                    bsonTemplateEvaluator ) );
                         }
@@ -394,8 +441,11 @@ namespace mongo {
                     else if ( op == "command" ) {
 
                         BSONObj result;
-                        conn->runCommand( ns, fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
-                                          result, e["options"].numberInt() );
+                        {
+                            BenchRunEventTrace _bret(&_stats.commandCounter, startedLateMicros);
+                            conn->runCommand( ns, fixQuery( e["command"].Obj(), bsonTemplateEvaluator ),
+                                              result, e["options"].numberInt() );
+                        }
 
                         if( check ){
                             int err = scope->invoke( scopeFunc , 0 , &result,  1000 * 60 , false );
@@ -427,12 +477,12 @@ namespace mongo {
 
                         // use special query function for exhaust query option
                         if (options & QueryOption_Exhaust) {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, startedLateMicros);
                             boost::function<void (const BSONObj&)> castedDoNothing(doNothing);
                             count =  conn->query(castedDoNothing, ns, fixedQuery, &filter, options);
                         }
                         else {
-                            BenchRunEventTrace _bret(&_stats.queryCounter);
+                            BenchRunEventTrace _bret(&_stats.queryCounter, startedLateMicros);
                             cursor = conn->query(ns, fixedQuery, limit, skip, &filter, options,
                                                  batchSize);
                             count = cursor->itcount();
@@ -468,7 +518,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
 
                         {
-                            BenchRunEventTrace _bret(&_stats.updateCounter);
+                            BenchRunEventTrace _bret(&_stats.updateCounter, startedLateMicros);
                             conn->update( ns, fixQuery( query, bsonTemplateEvaluator ), update,
                                           upsert , multi );
                             if (safe)
@@ -498,7 +548,7 @@ namespace mongo {
                         bool safe = e["safe"].trueValue();
                         BSONObj result;
                         {
-                            BenchRunEventTrace _bret(&_stats.insertCounter);
+                            BenchRunEventTrace _bret(&_stats.insertCounter, startedLateMicros);
                             conn->insert( ns, fixQuery( e["doc"].Obj(), bsonTemplateEvaluator ) );
                             if (safe)
                                 result = conn->getLastErrorDetailed();
@@ -531,7 +581,7 @@ namespace mongo {
                         BSONObj result;
 
                         {
-                            BenchRunEventTrace _bret(&_stats.deleteCounter);
+                            BenchRunEventTrace _bret(&_stats.deleteCounter, startedLateMicros);
                             conn->remove( ns, fixQuery( query, bsonTemplateEvaluator ), ! multi );
                             if (safe)
                                 result = conn->getLastErrorDetailed();
@@ -683,19 +733,31 @@ namespace mongo {
                                "required to use benchRun with auth enabled");
                  }
              }
-             // Get initial stats
-             conn->simpleCommand( "admin" , &before , "serverStatus" );
-             before = before.getOwned();
-         }
+             if ( _config->warmupSeconds > 0 ) {
+                 _brState.beginWarmup();
+             }
+             else {
+                 // Get initial stats
+                 conn->simpleCommand( "admin" , &before , "serverStatus" );
+                 before = before.getOwned();
+             }
 
-         // Start threads
-         for ( unsigned i = 0; i < _config->parallel; i++ ) {
-             BenchRunWorker *worker = new BenchRunWorker(_config.get(), &_brState);
-             worker->start();
-             _workers.push_back(worker);
-         }
+             // Start threads
+             for ( unsigned i = 0; i < _config->parallel; i++ ) {
+                 BenchRunWorker *worker = new BenchRunWorker(_config.get(), &_brState);
+                 worker->start();
+                 _workers.push_back(worker);
+             }
+
+             _brState.waitForState(BenchRunState::BRS_RUNNING);
 
-         _brState.waitForState(BenchRunState::BRS_RUNNING);
+             if ( _config->warmupSeconds > 0 ) {
+                 sleepmillis( (int)(1000.0 * _config->warmupSeconds) );
+                 conn->simpleCommand( "admin" , &before , "serverStatus" );
+                 before = before.getOwned();
+                 _brState.endWarmup();
+             }
+         }
      }
 
      void BenchRunner::stop() {
@@ -761,6 +823,16 @@ namespace mongo {
                         static_cast<double>(counter.getTotalTimeMicros()) / counter.getNumEvents());
      }
 
+     static void appendLatenciesIfAvailable(
+             BSONObjBuilder &buf, const std::string &name, const BenchRunEventCounter &counter) {
+
+         if (counter.getNumEvents() > 0) {
+             BSONObjBuilder latencies(buf.subobjStart(name));
+             counter.getLatencies().append(&latencies);
+             latencies.doneFast();
+         }
+     }
+
      BSONObj BenchRunner::finish( BenchRunner* runner ) {
 
          runner->stop();
@@ -787,6 +859,13 @@ namespace mongo {
          appendAverageMicrosIfAvailable(buf, "deleteLatencyAverageMicros", stats.deleteCounter);
          appendAverageMicrosIfAvailable(buf, "updateLatencyAverageMicros", stats.updateCounter);
          appendAverageMicrosIfAvailable(buf, "queryLatencyAverageMicros", stats.queryCounter);
+         appendAverageMicrosIfAvailable(buf, "commandLatencyAverageMicros", stats.commandCounter);
+         appendLatenciesIfAvailable(buf, "findOneLatencyMicros", stats.findOneCounter);
+         appendLatenciesIfAvailable(buf, "insertLatencyMicros", stats.insertCounter);
+         appendLatenciesIfAvailable(buf, "deleteLatencyMicros", stats.deleteCounter);
+         appendLatenciesIfAvailable(buf, "updateLatencyMicros", stats.updateCounter);
+         appendLatenciesIfAvailable(buf, "queryLatencyMicros", stats.queryCounter);
+         appendLatenciesIfAvailable(buf, "commandLatencyMicros", stats.commandCounter);
 
          {
              BSONObjIterator i( after );
@@ -26,6 +26,7 @@
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/stats/latency_histogram.h"
 #include "mongo/util/timer.h"
 
 namespace mongo {
@@ -85,6 +86,22 @@ namespace mongo {
          */
         double seconds;
 
+        /**
+         * Seconds to run the activity for before measuring starts.  Statistics gathered during
+         * warmup are thrown away, and benchStart() returns only once it is over.
+         */
+        double warmupSeconds;
+
+        /**
+         * If positive, the rate, summed over all threads, at which ops are started.  Each
+         * thread then starts its ops on a fixed schedule whether or not earlier ones are done
+         * ("open loop"), and an op's latency counts from when it was due to start, so time
+         * spent queued behind a slow op is not left out of the results.
+         *
+         * If 0, each thread starts an op as soon as the one before is done.
+         */
+        double opsPerSecond;
+
         bool hideResults;
         bool handleErrors;
         bool hideErrors;
@@ -142,6 +159,7 @@ namespace mongo {
         void countOne(unsigned long long timeMicros) {
             ++_numEvents;
             _totalTimeMicros += timeMicros;
+            _latencies.record(timeMicros);
         }
 
         /**
@@ -154,9 +172,15 @@ namespace mongo {
          */
         unsigned long long getNumEvents() const { return _numEvents; }
 
+        /**
+         * Get the distribution of the observed events' durations.
+         */
+        const LatencyHistogram &getLatencies() const { return _latencies; }
+
     private:
         unsigned long long _numEvents;
         unsigned long long _totalTimeMicros;
+        LatencyHistogram _latencies;
     };
 
     /**
@@ -170,6 +194,9 @@ namespace mongo {
      * the end of a successful event.  If an exception is thrown, the fail counter will receive the
      * event, and otherwise, the succes counter will.
      *
+     * An event that started "startedLateMicros" after it was scheduled to is counted as taking
+     * that much longer.
+     *
      * In all cases, the counter objects must outlive the trace object.
      */
     class BenchRunEventTrace : private boost::noncopyable {
@@ -178,6 +205,12 @@ namespace mongo {
             initialize(eventCounter, eventCounter, false);
         }
 
+        BenchRunEventTrace(BenchRunEventCounter *eventCounter,
+                           unsigned long long startedLateMicros) {
+            initialize(eventCounter, eventCounter, false);
+            _startedLateMicros = startedLateMicros;
+        }
+
         BenchRunEventTrace(BenchRunEventCounter *successCounter,
                            BenchRunEventCounter *failCounter,
                            bool defaultToFailure=true) {
@@ -185,7 +218,8 @@ namespace mongo {
         }
 
         ~BenchRunEventTrace() {
-            (_succeeded ? _successCounter : _failCounter)->countOne(_timer.micros());
+            (_succeeded ? _successCounter : _failCounter)->countOne(
+                    _startedLateMicros + _timer.micros());
         }
 
         void succeed() { _succeeded = true; }
@@ -198,9 +232,11 @@ namespace mongo {
             _successCounter = successCounter;
             _failCounter = failCounter;
             _succeeded = !defaultToFailure;
+            _startedLateMicros = 0;
         }
 
         Timer _timer;
+        unsigned long long _startedLateMicros;
         BenchRunEventCounter *_successCounter;
         BenchRunEventCounter *_failCounter;
         bool _succeeded;
@@ -226,6 +262,7 @@ namespace mongo {
         BenchRunEventCounter insertCounter;
         BenchRunEventCounter deleteCounter;
         BenchRunEventCounter queryCounter;
+        BenchRunEventCounter commandCounter;
 
         std::map<std::string, long long> opcounters;
         std::vector<BSONObj> trappedErrors;
@@ -263,6 +300,13 @@ namespace mongo {
         /// Check that the current state is BRS_FINISHED.
         void assertFinished();
 
+        /**
+         * Mark the workers as warming up, or as done warming up.  Workers throw away their
+         * statistics when warmup ends.
+         */
+        void beginWarmup();
+        void endWarmup();
+
         //
         // Functions called by the worker threads, through instances of BenchRunWorker.
         //
@@ -273,6 +317,9 @@ namespace mongo {
          */
         bool shouldWorkerFinish();
 
+        /// Predicate that workers call to see if they are still warming up.
+        bool isWarmingUp();
+
         /**
          * Called by each BenchRunWorker from within its thread context, immediately before it
          * starts sending requests to the configured mongo instance.
@@ -291,6 +338,7 @@ namespace mongo {
         unsigned _numUnstartedWorkers;
         unsigned _numActiveWorkers;
         AtomicUInt _isShuttingDown;
+        AtomicUInt _isWarmingUp;
     };
 
     /**
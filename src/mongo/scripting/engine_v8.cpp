@@ -90,13 +90,28 @@ namespace mongo {
                 return handle_scope.Close(realObject->Get(name));
             }
 
-            string key = toSTLString(name);
             BSONHolder* holder = unwrapHolder(scope, info.Holder());
-            if (!holder || holder->_removed.count(key))
+            if (!holder)
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
-            BSONObj obj = holder->_obj;
-            BSONElement elmt = obj.getField(key.c_str());
+            // This runs for every field a $where or map function reads, so decode short names
+            // on the stack rather than into a std::string.
+            char shortKey[64];
+            string longKey;
+            const char* key = shortKey;
+            if (name->Utf8Length() < static_cast<int>(sizeof(shortKey))) {
+                name->WriteUtf8(shortKey, sizeof(shortKey));
+            }
+            else {
+                longKey = toSTLString(name);
+                key = longKey.c_str();
+            }
+
+            if (!holder->_removed.empty() && holder->_removed.count(key))
+                return handle_scope.Close(v8::Handle<v8::Value>());
+
+            const BSONObj& obj = holder->_obj;
+            BSONElement elmt = obj.getField(key);
             if (elmt.eoo())
                 return handle_scope.Close(v8::Handle<v8::Value>());
 
@@ -539,6 +554,9 @@ namespace mongo {
             for(unsigned i = 0; i < _funcs.size(); ++i)
                 _funcs[ i ].Dispose();
             _funcs.clear();
+            for (ScriptCache::iterator it = _scriptCache.begin(); it != _scriptCache.end(); ++it)
+                it->second.Dispose();
+            _scriptCache.clear();
             _global.Dispose();
             _context.Dispose();
             // Note: This block is unnecessary since we destroy the v8 Heap (Isolate) immediately
@@ -1065,12 +1083,28 @@ namespace mongo {
         V8_SIMPLE_HEADER
         v8::TryCatch try_catch;
 
-        v8::Handle<v8::Script> script =
-                v8::Script::Compile(v8::String::New(code.rawData(), code.size()),
-                                    v8::String::New(name.c_str(), name.length()));
+        // Large scripts, like files, are seldom run twice in a scope.  Don't cache them.
+        const bool cacheable = code.size() <= kMaxCachedScriptSize;
+        string cacheKey;
+        v8::Handle<v8::Script> script;
+        if (cacheable) {
+            cacheKey.reserve(name.size() + 1 + code.size());
+            cacheKey.append(name).append(1, '\0').append(code.rawData(), code.size());
+            ScriptCache::const_iterator it = _scriptCache.find(cacheKey);
+            if (it != _scriptCache.end())
+                script = it->second;
+        }
 
-        if (checkV8ErrorState(script, try_catch, reportError, assertOnError))
-            return false;
+        if (script.IsEmpty()) {
+            script = v8::Script::Compile(v8::String::New(code.rawData(), code.size()),
+                                         v8::String::New(name.c_str(), name.length()));
+
+            if (checkV8ErrorState(script, try_catch, reportError, assertOnError))
+                return false;
+
+            if (cacheable && _scriptCache.size() < kMaxCachedScripts)
+                _scriptCache[cacheKey] = v8::Persistent<v8::Script>::New(script);
+        }
 
         if (!nativeEpilogue()) {
             _error = "JavaScript execution terminated";
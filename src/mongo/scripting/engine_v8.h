@@ -409,6 +409,14 @@ namespace mongo {
         string _error;
         vector<v8::Persistent<v8::Value> > _funcs;
 
+        // Scripts compiled by exec(), keyed by name and code, so that the setup code commands
+        // like group run on every invocation only gets compiled once per scope.  Pooled scopes
+        // keep these across uses.
+        typedef map<string, v8::Persistent<v8::Script> > ScriptCache;
+        ScriptCache _scriptCache;
+        static const size_t kMaxCachedScripts = 64;
+        static const size_t kMaxCachedScriptSize = 16 * 1024;
+
         enum ConnectState { NOT, LOCAL, EXTERNAL };
         ConnectState _connectState;
 
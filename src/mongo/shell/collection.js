@@ -53,6 +53,7 @@ DBCollection.prototype.help = function () {
     print("\tdb." + shortName + ".getIndexes()");
     print("\tdb." + shortName + ".group( { key : ..., initial: ..., reduce : ...[, cond: ...] } )");
     // print("\tdb." + shortName + ".indexStats({expandNodes: [<expanded child numbers>}, <detailed: t/f>) - output aggregate/per-depth btree bucket stats");
+    print("\tdb." + shortName + ".indexUsage( <reset> ) - how often each index was used; reset starts the counts over");
     print("\tdb." + shortName + ".insert(obj)");
     print("\tdb." + shortName + ".mapReduce( mapFunction , reduceFunction , <optional params> )");
     print("\tdb." + shortName + ".aggregate( pipeline ) - performs an aggregation on collection;"
@@ -627,6 +628,10 @@ DBCollection.prototype.indexStats = function(params) {
     return this._db.runCommand( cmd );
 }
 
+DBCollection.prototype.indexUsage = function(reset) {
+    return this._db.runCommand( { indexUsage: this.getName(), reset: !!reset } );
+}
+
 DBCollection.prototype.getIndexStats = function(params, detailed) {
     var stats = this.indexStats(params);
     if (!stats.ok) {
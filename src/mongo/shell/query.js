@@ -36,6 +36,7 @@ DBQuery.prototype.help = function () {
     print("\t._addSpecial(name, value) - http://dochub.mongodb.org/core/advancedqueries#AdvancedQueries-Metaqueryoperators")
     print("\t.batchSize(n) - sets the number of docs to return per getMore")
     print("\t.showDiskLoc() - adds a $diskLoc field to each returned object")
+    print("\t.maxTimeMS(ms) - interrupts the query once it has run for ms milliseconds")
     print("\t.min(idxDoc)")
     print("\t.max(idxDoc)")
     print("\t.comment(comment)")
@@ -282,6 +283,10 @@ DBQuery.prototype.comment = function (comment) {
     return this._addSpecial( "$comment" , comment );
 }
 
+DBQuery.prototype.maxTimeMS = function (ms) {
+    return this._addSpecial( "$maxTimeMS" , ms );
+}
+
 DBQuery.prototype.explain = function (verbose) {
     /* verbose=true --> include allPlans, oldPlan fields */
     var n = this.clone();
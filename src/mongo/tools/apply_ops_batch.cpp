@@ -0,0 +1,55 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/apply_ops_batch.h"
+
+#include "mongo/client/dbclientinterface.h"
+
+namespace mongo {
+
+    ApplyOpsBatch::ApplyOpsBatch() : _bytes(0) {
+    }
+
+    bool ApplyOpsBatch::isFull(const BSONObj& op) const {
+        if (_ops.empty()) {
+            return false;
+        }
+        return _ops.size() >= kMaxOps || _bytes + op.objsize() > kMaxBytes;
+    }
+
+    void ApplyOpsBatch::add(const BSONObj& op) {
+        _ops.push_back(op.getOwned());
+        _bytes += op.objsize();
+    }
+
+    bool ApplyOpsBatch::apply(DBClientBase& conn, BSONObj* res) {
+        BSONObjBuilder b(_bytes + 64);
+        BSONArrayBuilder ops(b.subarrayStart("applyOps"));
+        for (std::vector<BSONObj>::const_iterator it = _ops.begin(); it != _ops.end(); ++it) {
+            ops.append(*it);
+        }
+        ops.done();
+
+        _ops.clear();
+        _bytes = 0;
+
+        return conn.runCommand("admin", b.obj(), *res);
+    }
+
+}  // namespace mongo
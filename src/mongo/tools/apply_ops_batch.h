@@ -0,0 +1,69 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    class DBClientBase;
+
+    /**
+     * Gathers oplog entries being replayed in order, to send as one applyOps command rather
+     * than a command per entry.  The server applies the entries of an applyOps one after the
+     * other under the global write lock, so replaying them in batches keeps their order.
+     */
+    class ApplyOpsBatch {
+        MONGO_DISALLOW_COPYING(ApplyOpsBatch);
+    public:
+        // Most entries, and bytes of them, sent in one applyOps.
+        static const size_t kMaxOps = 1000;
+        static const int kMaxBytes = 8 * 1024 * 1024;
+
+        ApplyOpsBatch();
+
+        /**
+         * @return true if 'op' doesn't fit in with the entries gathered so far, which must be
+         *     applied first
+         */
+        bool isFull(const BSONObj& op) const;
+
+        /**
+         * Adds a copy of 'op'.
+         */
+        void add(const BSONObj& op);
+
+        bool empty() const { return _ops.empty(); }
+        size_t size() const { return _ops.size(); }
+
+        /**
+         * Applies the entries gathered with one applyOps on 'conn' and starts over.
+         *
+         * @return true if all of them applied; 'res' gets the command's reply either way
+         */
+        bool apply(DBClientBase& conn, BSONObj* res);
+
+    private:
+        std::vector<BSONObj> _ops;
+        int _bytes;
+    };
+
+}  // namespace mongo
@@ -21,19 +21,72 @@
 #include "mongo/base/initializer.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/stacktrace.h"
 #include "mongo/util/text.h"
+#include "mongo/util/time_support.h"
 
 using namespace mongo;
 using namespace std;
 
 int port = 0;
-int delay = 0;
 string destUri;
 void cleanup( int sig );
 
+/**
+ * Shapes the messages going one way through the bridge.  All connections share a direction's
+ * link, so a bandwidth cap applies to them together, as it would to a WAN link.
+ */
+class Link {
+public:
+    Link() : delay( 0 ), jitter( 0 ), kbps( 0 ), dropPercent( 0 ), _mutex( "bridgeLink" ),
+             _freeAt( 0 ) {
+    }
+
+    /**
+     * Holds a message of 'bytes' for as long as the link would take to carry it: its turn to
+     * be sent at the capped rate, then the delay and up to 'jitter' more.  Returns false if the
+     * message is to be dropped instead.
+     */
+    bool pass( int bytes, PseudoRandom& random ) {
+        if ( dropPercent > 0 && random.nextInt32( 100 ) < dropPercent )
+            return false;
+
+        long long wait = 0;
+        if ( kbps > 0 ) {
+            scoped_lock lk( _mutex );
+            const long long now = curTimeMillis64();
+            _freeAt = std::max( _freeAt, now ) + bytes * 1000LL / ( kbps * 1024LL );
+            wait = _freeAt - now;
+        }
+        wait += delay;
+        if ( jitter > 0 )
+            wait += random.nextInt32( jitter + 1 );
+        if ( wait > 0 )
+            sleepmillis( wait );
+        return true;
+    }
+
+    int delay;          // milliseconds added to every message
+    int jitter;         // at most this many milliseconds more, picked at random per message
+    int kbps;           // KB/s the link carries, 0 for no cap
+    int dropPercent;    // chance in 100 that a message is dropped
+
+private:
+    mongo::mutex _mutex;
+    long long _freeAt;  // curTimeMillis64() by which the link has sent what it was given
+};
+
+Link requests;  // client to dest
+Link replies;   // dest to client
+
+// What a dropped message does.  A discarded one goes missing, so the client waits on its
+// reply until it times out; a close takes the connection down with it, as a partition would.
+bool dropCloses = false;
+
 class Forwarder {
 public:
     Forwarder( MessagingPort &mp ) : mp_( mp ) {
@@ -43,6 +96,8 @@ public:
         string errmsg;
         while( !dest.connect( destUri, errmsg ) )
             sleepmillis( 500 );
+        PseudoRandom random( static_cast<int64_t>( curTimeMicros64() ) ^
+                             reinterpret_cast<intptr_t>( &mp_ ) );
         Message m;
         while( 1 ) {
             try {
@@ -52,7 +107,11 @@ public:
                     mp_.shutdown();
                     break;
                 }
-                sleepmillis( delay );
+                if ( !requests.pass( m.size(), random ) ) {
+                    if ( dropped() )
+                        break;
+                    continue;
+                }
 
                 int oldId = m.header()->id;
                 if ( m.operation() == dbQuery || m.operation() == dbMsg || m.operation() == dbGetMore ) {
@@ -68,14 +127,20 @@ public:
                     // nothing to reply with?
                     if ( response.empty() ) cleanup(0);
 
-                    mp_.reply( m, response, oldId );
+                    if ( replies.pass( response.size(), random ) )
+                        mp_.reply( m, response, oldId );
+                    else if ( dropped() )
+                        break;
                     while ( exhaust ) {
                         MsgData *header = response.header();
                         QueryResult *qr = (QueryResult *) header;
                         if ( qr->cursorId ) {
                             response.reset();
                             dest.port().recv( response );
-                            mp_.reply( m, response ); // m argument is ignored anyway
+                            if ( replies.pass( response.size(), random ) )
+                                mp_.reply( m, response ); // m argument is ignored anyway
+                            else if ( dropped() )
+                                break;
                         }
                         else {
                             exhaust = false;
@@ -92,6 +157,15 @@ public:
         }
     }
 private:
+    // Closes the connection if that's what a drop does, and returns whether it did.
+    bool dropped() const {
+        if ( !dropCloses )
+            return false;
+        cout << "dropping connection " << mp_.psock->remoteString() << endl;
+        mp_.shutdown();
+        return true;
+    }
+
     MessagingPort &mp_;
 };
 
@@ -138,10 +212,19 @@ inline void setupSignals() {}
 #endif
 
 void helpExit() {
-    cout << "usage mongobridge --port <port> --dest <destUri> [ --delay <ms> ]" << endl;
+    cout << "usage mongobridge --port <port> --dest <destUri> [ <shaping options> ]" << endl;
     cout << "    port: port to listen for mongo messages" << endl;
     cout << "    destUri: uri of remote mongod instance" << endl;
-    cout << "    ms: transfer delay in milliseconds (default = 0)" << endl;
+    cout << "shaping options, for requests, or for replies with the --reply prefix:" << endl;
+    cout << "    --delay <ms>, --replyDelay <ms>: transfer delay (default = 0)" << endl;
+    cout << "    --jitter <ms>, --replyJitter <ms>: random extra delay, at most ms"
+         << " (default = 0)" << endl;
+    cout << "    --kbps <n>, --replyKbps <n>: bandwidth cap in KB/s over all connections"
+         << " (default = 0, no cap)" << endl;
+    cout << "    --drop <pct>, --replyDrop <pct>: percentage of messages to drop"
+         << " (default = 0)" << endl;
+    cout << "    --dropMode <discard|close>: lose a dropped message, or close its connection"
+         << " (default = discard)" << endl;
     ::_exit( -1 );
 }
 
@@ -150,6 +233,24 @@ void check( bool b ) {
         helpExit();
 }
 
+// The setting an option shapes, or NULL if it isn't a shaping option.
+int* shapingOption( const string& opt ) {
+    if ( opt == "--delay" ) return &requests.delay;
+    if ( opt == "--jitter" ) return &requests.jitter;
+    if ( opt == "--kbps" ) return &requests.kbps;
+    if ( opt == "--drop" ) return &requests.dropPercent;
+    if ( opt == "--replyDelay" ) return &replies.delay;
+    if ( opt == "--replyJitter" ) return &replies.jitter;
+    if ( opt == "--replyKbps" ) return &replies.kbps;
+    if ( opt == "--replyDrop" ) return &replies.dropPercent;
+    return NULL;
+}
+
+void checkLink( const Link& link ) {
+    check( link.delay >= 0 && link.jitter >= 0 && link.kbps >= 0 );
+    check( link.dropPercent >= 0 && link.dropPercent <= 100 );
+}
+
 int toolMain( int argc, char **argv, char** envp ) {
     mongo::runGlobalInitializersOrDie(argc, argv, envp);
 
@@ -157,7 +258,7 @@ int toolMain( int argc, char **argv, char** envp ) {
 
     setupSignals();
 
-    check( argc == 5 || argc == 7 );
+    check( argc >= 5 && argc % 2 != 0 );
 
     for( int i = 1; i < argc; ++i ) {
         check( i % 2 != 0 );
@@ -167,14 +268,21 @@ int toolMain( int argc, char **argv, char** envp ) {
         else if ( strcmp( argv[ i ], "--dest" ) == 0 ) {
             destUri = argv[ ++i ];
         }
-        else if ( strcmp( argv[ i ], "--delay" ) == 0 ) {
-            delay = strtol( argv[ ++i ], 0, 10 );
+        else if ( strcmp( argv[ i ], "--dropMode" ) == 0 ) {
+            const string mode = argv[ ++i ];
+            check( mode == "discard" || mode == "close" );
+            dropCloses = mode == "close";
+        }
+        else if ( int* value = shapingOption( argv[ i ] ) ) {
+            *value = strtol( argv[ ++i ], 0, 10 );
         }
         else {
             check( false );
         }
     }
     check( port != 0 && !destUri.empty() );
+    checkLink( requests );
+    checkLink( replies );
 
     listener.reset( new MyListener( port ) );
     listener->initAndListen();
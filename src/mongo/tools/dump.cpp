@@ -16,17 +16,21 @@
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/convenience.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <fstream>
 #include <map>
 
 #include "mongo/base/initializer.h"
+#include "mongo/client/dbclient_rs.h"
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/db.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/text.h"
 
 using namespace mongo;
@@ -50,6 +54,8 @@ public:
         ("oplog", "Use oplog for point-in-time snapshotting" )
         ("repair", "try to recover a crashed database" )
         ("forceTableScan", "force a table scan (do not use $snapshot)" )
+        ("numParallelCollections", po::value<int>()->default_value(1),
+         "number of collections of a database to dump at once, each on its own connection" )
         ;
     }
 
@@ -91,7 +97,7 @@ public:
         ProgressMeter* _m;
     };
 
-    void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
+    void doCollection( DBClientBase& connBase, const string coll , FILE* out , ProgressMeter *m ) {
         Query q = _query;
 
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
@@ -100,8 +106,7 @@ public:
         else if ( _query.isEmpty() && !hasParam("dbpath") && !hasParam("forceTableScan") ) {
             q.snapshot();
         }
-        
-        DBClientBase& connBase = conn(true);
+
         Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
@@ -120,16 +125,21 @@ public:
     }
 
     void writeCollectionFile( const string coll , boost::filesystem::path outputFile ) {
+        writeCollectionFile( conn(true), coll, outputFile );
+    }
+
+    void writeCollectionFile( DBClientBase& connBase, const string coll ,
+                              boost::filesystem::path outputFile ) {
         log() << "\t" << coll << " to " << outputFile.string() << endl;
 
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m(conn(true).count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
+        ProgressMeter m(connBase.count(coll.c_str(), BSONObj(), QueryOption_SlaveOk));
         m.setName("Collection File Writing Progress");
         m.setUnits("objects");
 
-        doCollection(coll, f, &m);
+        doCollection(connBase, coll, f, &m);
 
         log() << "\t\t " << m.done() << " objects" << endl;
     }
@@ -169,7 +179,7 @@ public:
 
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, stdout, NULL);
+        doCollection(conn(true), coll, stdout, NULL);
     }
 
     void go( const string db , const boost::filesystem::path outdir ) {
@@ -232,15 +242,83 @@ public:
             collections.push_back(name);
         }
         
+        const int numThreads = std::min( _numParallelCollections,
+                                         static_cast<int>( collections.size() ) );
+        if ( numThreads > 1 ) {
+            ParallelDump parallel( db, outdir, collections );
+            boost::thread_group workers;
+            for ( int i = 0; i < numThreads; i++ ) {
+                workers.create_thread( boost::bind( &Dump::dumpCollections, this, &parallel ) );
+            }
+            workers.join_all();
+            uassert( 17008, parallel.firstError, parallel.firstError.empty() );
+        }
+        else {
+            for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
+                string name = *it;
+                const string filename = name.substr( db.size() + 1 );
+                writeCollectionFile( name , outdir / ( filename + ".bson" ) );
+            }
+        }
+
+        // metadata is small, write it here rather than on the workers
         for (vector<string>::iterator it = collections.begin(); it != collections.end(); ++it) {
             string name = *it;
             const string filename = name.substr( db.size() + 1 );
-            writeCollectionFile( name , outdir / ( filename + ".bson" ) );
             writeMetadataFile( name, outdir / (filename + ".metadata.json"), collectionOptions, indexes);
         }
 
     }
 
+    // The collections of one database being dumped by several threads; each takes the
+    // next one not yet taken until there are none left or one of them fails.
+    struct ParallelDump : boost::noncopyable {
+        ParallelDump( const string& db_, const boost::filesystem::path& outdir_,
+                      const vector<string>& collections_ )
+            : db( db_ ), outdir( outdir_ ), collections( collections_ ),
+              mutex( "ParallelDump" ), next( 0 ) {
+        }
+
+        const string db;
+        const boost::filesystem::path outdir;
+        const vector<string>& collections;
+
+        // protects all below
+        SimpleMutex mutex;
+        size_t next;
+        string firstError;
+    };
+
+    void dumpCollections( ParallelDump* parallel ) {
+        try {
+            scoped_ptr<DBClientBase> c( newConnection() );
+            DBClientBase* connBase = c.get();
+            if ( c->type() == ConnectionString::SET ) {
+                // as conn(true) does, read from a secondary if there is one
+                connBase = &static_cast<DBClientReplicaSet*>( c.get() )->slaveConn();
+            }
+
+            while ( true ) {
+                string name;
+                {
+                    SimpleMutex::scoped_lock lk( parallel->mutex );
+                    if ( parallel->next == parallel->collections.size() ||
+                         !parallel->firstError.empty() )
+                        return;
+                    name = parallel->collections[parallel->next++];
+                }
+                const string filename = name.substr( parallel->db.size() + 1 );
+                writeCollectionFile( *connBase, name, parallel->outdir / ( filename + ".bson" ) );
+            }
+        }
+        catch ( DBException& e ) {
+            error() << "dumping " << parallel->db << " failed: " << e.toString() << endl;
+            SimpleMutex::scoped_lock lk( parallel->mutex );
+            if ( parallel->firstError.empty() )
+                parallel->firstError = e.toString();
+        }
+    }
+
     int repair() {
         if ( ! hasParam( "dbpath" ) ){
             log() << "repair mode only works with --dbpath" << endl;
@@ -485,6 +563,10 @@ public:
 
         _usingMongos = isMongos();
 
+        // --dbpath has only the one direct client to read with
+        _numParallelCollections = hasParam( "dbpath" ) ? 1 :
+            std::max( 1, getParam( "numParallelCollections", 1 ) );
+
         boost::filesystem::path root( out );
         string db = _db;
 
@@ -538,6 +620,7 @@ public:
     }
 
     bool _usingMongos;
+    int _numParallelCollections;
     BSONObj _query;
 };
 
@@ -220,7 +220,7 @@ public:
                 for ( vector<string>::iterator i=_fields.begin(); i != _fields.end(); i++ ) {
                     if ( i != _fields.begin() )
                         out << ",";
-                    const BSONElement & e = obj.getFieldDotted(i->c_str());
+                    const BSONElement & e = obj.getFieldDotted(*i);
                     if ( ! e.eoo() ) {
                         out << csvString(e);
                     }
@@ -231,7 +231,7 @@ public:
                 if (jsonArray && num != 1)
                     out << ',';
 
-                out << obj.jsonString();
+                obj.jsonStringStream( Strict, 0, out );
 
                 if (!jsonArray)
                     out << endl;
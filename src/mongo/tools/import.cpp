@@ -17,14 +17,19 @@
 #include "mongo/pch.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/program_options.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
 #include <fstream>
 #include <iostream>
 
 #include "mongo/base/initializer.h"
 #include "mongo/db/json.h"
 #include "mongo/tools/tool.h"
+#include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/text.h"
 
 using namespace mongo;
@@ -44,6 +49,7 @@ class Import : public Tool {
     bool _upsert;
     bool _doimport;
     vector<string> _upsertFields;
+    boost::scoped_array<char> _lineBuffer;
     static const int BUF_SIZE;
 
     void csvTokenizeRow(const string& row, vector<string>& tokens) {
@@ -180,8 +186,23 @@ class Import : public Tool {
      * Returns a true if a BSONObj was successfully created and false if not.
      */
     bool parseRow(istream* in, BSONObj& o, int& numBytesRead) {
-        boost::scoped_array<char> buffer(new char[BUF_SIZE+2]);
-        char* line = buffer.get();
+        string row;
+        if (!readRow(in, row, numBytesRead)) {
+            return false;
+        }
+        parseRow(row, o);
+        return true;
+    }
+
+    /*
+     * Reads the text of one object from the input file into row, as parseRow(istream*, ...)
+     * would parse it.  Returns false if there was nothing on the line.
+     */
+    bool readRow(istream* in, string& row, int& numBytesRead) {
+        if (!_lineBuffer) {
+            _lineBuffer.reset(new char[BUF_SIZE+2]);
+        }
+        char* line = _lineBuffer.get();
 
         numBytesRead = getLine(in, line);
         line += numBytesRead;
@@ -191,24 +212,8 @@ class Import : public Tool {
         }
         numBytesRead += strlen( line );
 
-        if (_type == JSON) {
-            // Strip out trailing whitespace
-            char * end = ( line + strlen( line ) ) - 1;
-            while ( end >= line && isspace(*end) ) {
-                *end = 0;
-                end--;
-            }
-            try {
-                o = fromjson( line );
-            } catch ( MsgAssertionException& e ) {
-                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
-            }
-            return true;
-        }
-
-        vector<string> tokens;
         if (_type == CSV) {
-            string row;
+            row.clear();
             bool inside_quotes = false;
             size_t last_quote = 0;
             while (true) {
@@ -236,9 +241,38 @@ class Import : public Tool {
             }
             // now 'row' is string corresponding to one row of the CSV file
             // (which may span multiple lines) and represents one BSONObj
+        }
+        else {
+            row = line;
+        }
+        return true;
+    }
+
+    /*
+     * Parses the text of one object, as read by readRow().  Safe to call from several threads
+     * at once once the header line, if any, has been parsed.
+     */
+    void parseRow(const string& row, BSONObj& o) {
+        if (_type == JSON) {
+            // Strip out trailing whitespace
+            size_t end = row.size();
+            while ( end > 0 && isspace(row[end - 1]) ) {
+                end--;
+            }
+            try {
+                o = fromjson( row.substr( 0 , end ) );
+            } catch ( MsgAssertionException& e ) {
+                uasserted(13504, string("BSON representation of supplied JSON is too large: ") + e.what());
+            }
+            return;
+        }
+
+        vector<string> tokens;
+        if (_type == CSV) {
             csvTokenizeRow(row, tokens);
         }
         else {  // _type == TSV
+            const char* line = row.c_str();
             while (line[0] != '\t' && isspace(line[0])) { // Strip leading whitespace, but not tabs
                 line++;
             }
@@ -270,7 +304,6 @@ class Import : public Tool {
             }
         }
         o = b.obj();
-        return true;
     }
 
 public:
@@ -286,6 +319,11 @@ public:
         ("upsertFields", po::value<string>(), "comma-separated fields for the query part of the upsert. You should make sure this is indexed" )
         ("stopOnError", "stop importing at first error rather than continuing" )
         ("jsonArray", "load a json array, not one item per line. Currently limited to 16MB." )
+        ("numWorkers", po::value<int>()->default_value(1),
+         "number of threads parsing and inserting at once, each on its own connection; "
+         "not used with --jsonArray" )
+        ("unordered", "with --numWorkers, insert documents in whatever order they are parsed "
+         "rather than the order of the input" )
         ;
         add_hidden_options()
         ("noimport", "don't actually import. useful for benchmarking parser" )
@@ -309,7 +347,15 @@ public:
 
     /** @return true if ok */
     bool checkLastError() { 
-        string s = conn().getLastError();
+        if ( checkLastError( conn() ) )
+            return true;
+        lastErrorFailures++;
+        return false;
+    }
+
+    /** @return true if ok; duplicate key errors are logged but don't count */
+    bool checkLastError( DBClientBase& c ) {
+        string s = c.getLastError();
         if( !s.empty() ) { 
             if( str::contains(s,"uplicate") ) {
                 // we don't want to return an error from the mongoimport process for
@@ -317,7 +363,6 @@ public:
                 log() << s << endl;
             }
             else {
-                lastErrorFailures++;
                 log() << "error: " << s << endl;
                 return false;
             }
@@ -326,6 +371,10 @@ public:
     }
 
     void importDocument (const std::string &ns, const BSONObj& o) {
+        importDocument( conn(), ns, o );
+    }
+
+    void importDocument (DBClientBase& c, const std::string &ns, const BSONObj& o) {
         bool doUpsert = _upsert;
         BSONObjBuilder b;
         if (_upsert) {
@@ -341,13 +390,239 @@ public:
         }
 
         if (doUpsert) {
-            conn().update(ns, Query(b.obj()), o, true);
+            c.update(ns, Query(b.obj()), o, true);
         }
         else {
-            conn().insert(ns.c_str(), o);
+            c.insert(ns.c_str(), o);
+        }
+    }
+
+    // Rows handed to a worker at a time, and the most BSON sent in one insert message.
+    static const size_t kRowsPerBatch = 1000;
+    static const int kMaxInsertBytes = 16 * 1024 * 1024;
+
+    // A run of consecutive rows of the input.
+    struct RowBatch {
+        long long seq;
+        vector<string> rows;
+    };
+
+    // What the reader and the workers of a parallel import share.
+    struct ParallelImport : boost::noncopyable {
+        ParallelImport( const string& ns_, bool ordered_, size_t maxQueued_ )
+            : ns( ns_ ), ordered( ordered_ ), maxQueued( maxQueued_ ),
+              mutex( "ParallelImport" ), nextToImport( 0 ), done( false ), stop( false ),
+              rows( 0 ), errors( 0 ), lastErrorFailures( 0 ) {
+        }
+
+        const string ns;
+        const bool ordered;
+        const size_t maxQueued;
+
+        // protects all below
+        mongo::mutex mutex;
+        boost::condition changed;
+        std::deque<RowBatch*> queue;
+        long long nextToImport; // when ordered, the seq of the batch whose turn it is
+        bool done;              // the reader has queued its last batch
+        bool stop;              // give up on the rest of the input
+        long long rows;         // parsed
+        int errors;
+        unsigned long long lastErrorFailures;
+    };
+
+    /**
+     * Takes batches of rows off parallel->queue until it is drained, parses them and, unless
+     * --noimport, imports them on a connection of its own.  When ordered, a batch is only
+     * imported once the one before it is, so only the parsing overlaps.
+     */
+    void importWorker( ParallelImport* parallel ) {
+        const bool stopOnError = hasParam( "stopOnError" );
+        scoped_ptr<DBClientBase> c;
+        try {
+            if ( _doimport )
+                c.reset( newConnection() );
+        }
+        catch ( const std::exception& e ) {
+            log() << "exception:" << e.what() << endl;
+            scoped_lock lk( parallel->mutex );
+            parallel->errors++;
+            parallel->stop = true;
+            parallel->changed.notify_all();
+            return;
+        }
+
+        while ( true ) {
+            scoped_ptr<RowBatch> batch;
+            {
+                scoped_lock lk( parallel->mutex );
+                while ( parallel->queue.empty() && !parallel->done && !parallel->stop )
+                    parallel->changed.wait( lk.boost() );
+                if ( parallel->queue.empty() )
+                    return;
+                batch.reset( parallel->queue.front() );
+                parallel->queue.pop_front();
+                parallel->changed.notify_all();
+            }
+
+            vector<BSONObj> docs;
+            int errors = 0;
+            for ( vector<string>::const_iterator it = batch->rows.begin();
+                  it != batch->rows.end(); ++it ) {
+                try {
+                    BSONObj o;
+                    parseRow( *it, o );
+                    docs.push_back( o );
+                }
+                catch ( const std::exception& e ) {
+                    log() << "exception:" << e.what() << endl;
+                    errors++;
+                    if ( stopOnError )
+                        break;
+                }
+            }
+
+            if ( parallel->ordered ) {
+                scoped_lock lk( parallel->mutex );
+                while ( parallel->nextToImport != batch->seq && !parallel->stop )
+                    parallel->changed.wait( lk.boost() );
+            }
+
+            bool ok = true;
+            if ( c && !( parallel->ordered && parallel->stop ) ) {
+                try {
+                    importDocuments( *c, parallel->ns, docs, stopOnError );
+                    ok = checkLastError( *c );
+                }
+                catch ( const std::exception& e ) {
+                    log() << "exception:" << e.what() << endl;
+                    errors++;
+                }
+            }
+
+            scoped_lock lk( parallel->mutex );
+            parallel->rows += docs.size();
+            parallel->errors += errors;
+            if ( !ok )
+                parallel->lastErrorFailures++;
+            if ( stopOnError && ( errors || !ok ) )
+                parallel->stop = true;
+            parallel->nextToImport++;
+            parallel->changed.notify_all();
         }
     }
 
+    /**
+     * Inserts 'docs' in as few messages as fit, or upserts them one at a time with --upsert.
+     */
+    void importDocuments( DBClientBase& c, const string& ns, const vector<BSONObj>& docs,
+                          bool stopOnError ) {
+        if ( _upsert ) {
+            for ( vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it )
+                importDocument( c, ns, *it );
+            return;
+        }
+
+        vector<BSONObj> toInsert;
+        int bytes = 0;
+        for ( vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+            if ( !toInsert.empty() && bytes + it->objsize() > kMaxInsertBytes ) {
+                c.insert( ns, toInsert, stopOnError ? 0 : InsertOption_ContinueOnError );
+                toInsert.clear();
+                bytes = 0;
+            }
+            toInsert.push_back( *it );
+            bytes += it->objsize();
+        }
+        if ( !toInsert.empty() )
+            c.insert( ns, toInsert, stopOnError ? 0 : InsertOption_ContinueOnError );
+    }
+
+    /**
+     * Reads the input a row at a time on this thread, leaving the parsing and importing to
+     * 'numWorkers' threads, until the input ends or a worker gives up under --stopOnError.
+     *
+     * @return the number of rows parsed, header line included, as the single threaded import
+     *     counts them
+     */
+    int importParallel( istream* in, const string& ns, int numWorkers, ProgressMeter& pm,
+                        time_t start, int& errors ) {
+        ParallelImport parallel( ns, !hasParam( "unordered" ), 2 * numWorkers );
+        boost::thread_group workers;
+        for ( int i = 0; i < numWorkers; i++ ) {
+            workers.create_thread( boost::bind( &Import::importWorker, this, &parallel ) );
+        }
+
+        int num = 0;
+        int headerRows = 0;
+        int len = 0;
+        long long seq = 0;
+        auto_ptr<RowBatch> batch( new RowBatch() );
+        while ( in->rdstate() == 0 ) {
+            try {
+                string row;
+                if ( readRow( in, row, len ) ) {
+                    if ( _headerLine ) {
+                        // fills in _fields before any worker parses a row
+                        BSONObj o;
+                        parseRow( row, o );
+                        _headerLine = false;
+                        headerRows++;
+                    }
+                    else {
+                        batch->rows.push_back( row );
+                    }
+                    num++;
+                }
+            }
+            catch ( const std::exception& e ) {
+                log() << "exception:" << e.what() << endl;
+                errors++;
+
+                if (hasParam("stopOnError"))
+                    break;
+            }
+
+            if ( pm.hit( len + 1 ) ) {
+                log() << "\t\t\t" << num << "\t" << ( num / ( time(0) - start ) ) << "/second" << endl;
+            }
+
+            if ( batch->rows.size() < kRowsPerBatch )
+                continue;
+
+            batch->seq = seq++;
+            scoped_lock lk( parallel.mutex );
+            while ( parallel.queue.size() >= parallel.maxQueued && !parallel.stop )
+                parallel.changed.wait( lk.boost() );
+            if ( parallel.stop )
+                break;
+            parallel.queue.push_back( batch.release() );
+            parallel.changed.notify_all();
+            batch.reset( new RowBatch() );
+        }
+
+        {
+            scoped_lock lk( parallel.mutex );
+            if ( !batch->rows.empty() && !parallel.stop ) {
+                batch->seq = seq++;
+                parallel.queue.push_back( batch.release() );
+            }
+            parallel.done = true;
+            parallel.changed.notify_all();
+        }
+        workers.join_all();
+
+        // left behind when stopping early
+        for ( std::deque<RowBatch*>::iterator it = parallel.queue.begin();
+              it != parallel.queue.end(); ++it ) {
+            delete *it;
+        }
+
+        errors += parallel.errors;
+        lastErrorFailures += parallel.lastErrorFailures;
+        return parallel.rows + headerRows;
+    }
+
     int run() {
         string filename = getParam( "file" );
         long long fileSize = 0;
@@ -445,6 +720,7 @@ public:
         int errors = 0;
         lastErrorFailures = 0;
         int len = 0;
+        const int numWorkers = std::max( 1, getParam( "numWorkers", 1 ) );
 
         // We have to handle jsonArrays differently since we can't read line by line
         if (_type == JSON && hasParam("jsonArray")) {
@@ -531,6 +807,11 @@ public:
                 }
             }
         }
+        else if (numWorkers > 1) {
+            num = importParallel(in, ns, numWorkers, pm, start, errors);
+            // the workers checked each of their batches
+            lastNumChecked = num - 1;
+        }
         else {
             while (in->rdstate() == 0) {
                 try {
@@ -23,6 +23,7 @@
 #include "mongo/base/initializer.h"
 #include "mongo/db/json.h"
 #include "mongo/db/repl/oplogreader.h"
+#include "mongo/tools/apply_ops_batch.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/text.h"
 
@@ -68,6 +69,7 @@ public:
         r.tailingQueryGTE( ns.c_str() , start );
 
         int num = 0;
+        ApplyOpsBatch batch;
         while ( r.more() ) {
             BSONObj o = r.next();
             LOG(2) << o << endl;
@@ -86,21 +88,28 @@ public:
             if ( o["op"].String() == "n" )
                 continue;
 
-            BSONObjBuilder b( o.objsize() + 32 );
-            BSONArrayBuilder updates( b.subarrayStart( "applyOps" ) );
-            updates.append( o );
-            updates.done();
+            if ( batch.isFull( o ) )
+                applyBatch( batch, false );
+            batch.add( o );
 
-            BSONObj c = b.obj();
-            
-            BSONObj res;
-            bool ok = conn().runCommand( "admin" , c , res );
-            if ( print || ! ok )
-                log() << res << endl;
+            // don't hold on to entries while waiting for more to be written
+            if ( print || ! r.moreInCurrentBatch() )
+                applyBatch( batch, print );
         }
+        applyBatch( batch, false );
 
         return 0;
     }
+
+    void applyBatch( ApplyOpsBatch& batch, bool print ) {
+        if ( batch.empty() )
+            return;
+
+        BSONObj res;
+        bool ok = batch.apply( conn(), &res );
+        if ( print || ! ok )
+            log() << res << endl;
+    }
 };
 
 int toolMain( int argc , char** argv, char** envp ) {
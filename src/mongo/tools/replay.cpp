@@ -0,0 +1,353 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * mongoreplay: replays client traffic recorded by mongosniff --record against a server.
+ * Each recorded client connection gets a connection and a thread of its own, and its
+ * requests go out in their original order and, by default, at their original times.
+ */
+
+#include "mongo/pch.h"
+
+#include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <map>
+
+#include "mongo/base/initializer.h"
+#include "mongo/db/dbmessage.h"
+#include "mongo/db/stats/latency_histogram.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/tools/tool.h"
+#include "mongo/tools/traffic_recording.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/mongoutils/str.h"
+#include "mongo/util/text.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+using namespace mongo;
+
+namespace po = boost::program_options;
+
+namespace {
+
+    struct ReplayStats {
+        LatencyHistogram queries;
+        LatencyHistogram commands;
+        LatencyHistogram getMores;
+
+        AtomicUInt64 inserts;
+        AtomicUInt64 updates;
+        AtomicUInt64 deletes;
+        AtomicUInt64 killCursors;
+
+        // requests sent more than kLateMicros after they were due
+        AtomicUInt64 late;
+        // requests that failed, or getMores of cursors the replay doesn't have
+        AtomicUInt64 errors;
+    };
+
+    const unsigned long long kLateMicros = 10 * 1000;
+
+    /**
+     * Replays the requests of one recorded connection, in order, on a thread of its own.
+     */
+    class ReplayConnection : boost::noncopyable {
+    public:
+        static const size_t kMaxQueued = 1000;
+
+        /**
+         * Takes ownership of 'conn'.  Requests are due 'startMicros' plus their offset
+         * divided by 'speed'; if 'speed' is 0 they go as soon as the one before is done.
+         */
+        ReplayConnection( DBClientBase* conn, unsigned long long startMicros, double speed,
+                          ReplayStats* stats )
+            : _conn( conn ),
+              _startMicros( startMicros ),
+              _speed( speed ),
+              _stats( stats ),
+              _mutex( "ReplayConnection" ),
+              _finished( false ) {
+            _thread = boost::thread( boost::bind( &ReplayConnection::run, this ) );
+        }
+
+        /**
+         * Queues 'record' to be replayed; blocks while kMaxQueued are already waiting.
+         */
+        void push( const boost::shared_ptr<TrafficRecord>& record ) {
+            scoped_lock lk( _mutex );
+            while ( _queue.size() >= kMaxQueued ) {
+                _changed.wait( lk.boost() );
+            }
+            _queue.push_back( record );
+            _changed.notify_all();
+        }
+
+        /**
+         * Waits for everything queued to be replayed.
+         */
+        void finish() {
+            {
+                scoped_lock lk( _mutex );
+                _finished = true;
+                _changed.notify_all();
+            }
+            _thread.join();
+        }
+
+    private:
+        void run() {
+            while ( true ) {
+                boost::shared_ptr<TrafficRecord> record;
+                {
+                    scoped_lock lk( _mutex );
+                    while ( _queue.empty() && ! _finished ) {
+                        _changed.wait( lk.boost() );
+                    }
+                    if ( _queue.empty() )
+                        return;
+                    record = _queue.front();
+                    _queue.pop_front();
+                    _changed.notify_all();
+                }
+
+                try {
+                    replay( record.get() );
+                }
+                catch ( DBException& e ) {
+                    _stats->errors.fetchAndAdd( 1 );
+                    LOG(1) << "replay of " << opToString( record->message.operation() )
+                           << " failed" << causedBy( e ) << endl;
+                }
+            }
+        }
+
+        void waitUntilDue( const TrafficRecord& record ) {
+            if ( _speed <= 0 )
+                return;
+
+            const unsigned long long due =
+                _startMicros + static_cast<unsigned long long>( record.offsetMicros / _speed );
+            const unsigned long long now = curTimeMicros64();
+            if ( now < due )
+                sleepmicros( due - now );
+            else if ( now - due > kLateMicros )
+                _stats->late.fetchAndAdd( 1 );
+        }
+
+        void replay( TrafficRecord* record ) {
+            Message& m = record->message;
+
+            if ( m.operation() == opReply ) {
+                // the original reply to a query or getMore we replayed: its cursor is ours now
+                QueryResult* qr = reinterpret_cast<QueryResult*>( m.singleData() );
+                std::map<unsigned, long long>::iterator i =
+                    _cursorByRequest.find( qr->responseTo.get() );
+                if ( i != _cursorByRequest.end() ) {
+                    if ( qr->cursorId )
+                        _cursors[qr->cursorId] = i->second;
+                    _cursorByRequest.erase( i );
+                }
+                return;
+            }
+
+            waitUntilDue( *record );
+
+            switch ( m.operation() ) {
+            case dbGetMore: {
+                DbMessage d( m );
+                d.pullInt();
+                long long& cursorId = d.pullInt64();
+                std::map<long long, long long>::const_iterator i = _cursors.find( cursorId );
+                if ( i == _cursors.end() || 0 == i->second ) {
+                    _stats->errors.fetchAndAdd( 1 );
+                    return;
+                }
+                cursorId = i->second;
+                call( m, &_stats->getMores );
+                break;
+            }
+            case dbQuery: {
+                DbMessage d( m );
+                const bool isCommand = str::endsWith( d.getns(), ".$cmd" );
+                call( m, isCommand ? &_stats->commands : &_stats->queries );
+                break;
+            }
+            case dbInsert:
+                _conn->say( m );
+                _stats->inserts.fetchAndAdd( 1 );
+                break;
+            case dbUpdate:
+                _conn->say( m );
+                _stats->updates.fetchAndAdd( 1 );
+                break;
+            case dbDelete:
+                _conn->say( m );
+                _stats->deletes.fetchAndAdd( 1 );
+                break;
+            case dbKillCursors:
+                // the ids in it are the original ones, and cursors we don't finish time out
+                _stats->killCursors.fetchAndAdd( 1 );
+                break;
+            default:
+                LOG(1) << "not replaying " << opToString( m.operation() ) << endl;
+            }
+        }
+
+        void call( Message& m, LatencyHistogram* latencies ) {
+            const unsigned originalId = m.header()->id.get();
+
+            Message response;
+            Timer t;
+            if ( ! _conn->call( m, response, false ) ) {
+                _stats->errors.fetchAndAdd( 1 );
+                return;
+            }
+            latencies->record( t.micros() );
+
+            QueryResult* qr = reinterpret_cast<QueryResult*>( response.singleData() );
+            _cursorByRequest[originalId] =
+                ( qr->resultFlags() & ResultFlag_CursorNotFound ) ? 0 : qr->cursorId;
+        }
+
+        boost::scoped_ptr<DBClientBase> _conn;
+        const unsigned long long _startMicros;
+        const double _speed;
+        ReplayStats* _stats;
+
+        // original request id to the cursor its replay returned, until the original reply
+        // comes along; then original cursor id to replayed cursor id
+        std::map<unsigned, long long> _cursorByRequest;
+        std::map<long long, long long> _cursors;
+
+        // protects all below
+        mongo::mutex _mutex;
+        boost::condition _changed;
+        std::deque<boost::shared_ptr<TrafficRecord> > _queue;
+        bool _finished;
+
+        boost::thread _thread;
+    };
+
+    void appendLatencies( BSONObjBuilder* b, const char* name, const LatencyHistogram& h ) {
+        BSONObjBuilder sub( b->subobjStart( name ) );
+        h.append( &sub );
+        sub.doneFast();
+    }
+
+}  // namespace
+
+class Replay : public Tool {
+public:
+    Replay() : Tool( "replay", REMOTE_SERVER ) {
+        add_options()
+        ( "speed", po::value<double>()->default_value( 1.0 ),
+          "replay this many times faster than recorded, 0 for as fast as possible" )
+        ;
+        add_hidden_options()
+        ( "file", po::value<string>(), "recording to replay" )
+        ;
+        addPositionArg( "file", 1 );
+    }
+
+    virtual void printExtraHelp( ostream& out ) {
+        out << "Replay client traffic recorded by mongosniff --record.\n"
+            << "Requests are sent on connections authenticated as given here, so recorded\n"
+            << "authentication commands fail harmlessly.\n" << endl;
+    }
+
+    virtual void printExtraHelpAfter( ostream& out ) {
+        out << "\nusage: " << _name << " [options] <recording>" << endl;
+    }
+
+    int run() {
+        if ( ! hasParam( "file" ) ) {
+            log() << "need a recording to replay" << endl;
+            return -1;
+        }
+        const double speed = _params["speed"].as<double>();
+        if ( speed < 0 ) {
+            log() << "--speed can't be negative" << endl;
+            return -1;
+        }
+
+        TrafficRecordReader reader( getParam( "file" ) );
+        ReplayStats stats;
+        typedef std::map<unsigned, boost::shared_ptr<ReplayConnection> > ConnectionMap;
+        ConnectionMap connections;
+
+        Timer elapsed;
+        const unsigned long long start = curTimeMicros64();
+        while ( true ) {
+            boost::shared_ptr<TrafficRecord> record( new TrafficRecord() );
+            if ( ! reader.next( record.get() ) )
+                break;
+
+            boost::shared_ptr<ReplayConnection>& c = connections[record->connectionId];
+            if ( ! c )
+                c.reset( new ReplayConnection( newConnection(), start, speed, &stats ) );
+            c->push( record );
+        }
+
+        for ( ConnectionMap::iterator i = connections.begin(); i != connections.end(); ++i ) {
+            i->second->finish();
+        }
+
+        BSONObjBuilder b;
+        b.append( "seconds", elapsed.micros() / 1000000.0 );
+        b.append( "connections", static_cast<int>( connections.size() ) );
+        appendLatencies( &b, "queries", stats.queries );
+        appendLatencies( &b, "commands", stats.commands );
+        appendLatencies( &b, "getMores", stats.getMores );
+        b.appendNumber( "inserts", static_cast<long long>( stats.inserts.load() ) );
+        b.appendNumber( "updates", static_cast<long long>( stats.updates.load() ) );
+        b.appendNumber( "deletes", static_cast<long long>( stats.deletes.load() ) );
+        b.appendNumber( "killCursors", static_cast<long long>( stats.killCursors.load() ) );
+        b.appendNumber( "late", static_cast<long long>( stats.late.load() ) );
+        b.appendNumber( "errors", static_cast<long long>( stats.errors.load() ) );
+        cout << b.obj().jsonString( Strict, 1 ) << endl;
+
+        return 0;
+    }
+};
+
+int toolMain( int argc , char** argv, char** envp ) {
+    mongo::runGlobalInitializersOrDie(argc, argv, envp);
+    Replay t;
+    return t.main( argc , argv );
+}
+
+#if defined(_WIN32)
+// In Windows, wmain() is an alternate entry point for main(), and receives the same parameters
+// as main() but encoded in Windows Unicode (UTF-16); "wide" 16-bit wchar_t characters.  The
+// WindowsCommandLine object converts these wide character strings to a UTF-8 coded equivalent
+// and makes them available through the argv() and envp() members.  This enables toolMain()
+// to process UTF-8 encoded arguments and environment variables without regard to platform.
+int wmain(int argc, wchar_t* argvW[], wchar_t* envpW[]) {
+    WindowsCommandLine wcl(argc, argvW, envpW);
+    int exitCode = toolMain(argc, wcl.argv(), wcl.envp());
+    ::_exit(exitCode);
+}
+#else
+int main(int argc, char* argv[], char** envp) {
+    int exitCode = toolMain(argc, argv, envp);
+    ::_exit(exitCode);
+}
+#endif
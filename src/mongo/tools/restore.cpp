@@ -29,6 +29,7 @@
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/json.h"
 #include "mongo/db/namespace_string.h"
+#include "mongo/tools/apply_ops_batch.h"
 #include "mongo/tools/tool.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/stringutils.h"
@@ -58,7 +59,10 @@ public:
     scoped_ptr<OpTime> _oplogLimitTS; // for oplog replay (limit)
     int _oplogEntrySkips; // oplog entries skipped
     int _oplogEntryApplies; // oplog entries applied
-    Restore() : BSONTool( "restore" ) , _drop(false) {
+    ApplyOpsBatch _oplogBatch; // oplog entries not yet applied
+    vector<BSONObj> _batch; // documents for _curns not yet sent
+    int _batchBytes;
+    Restore() : BSONTool( "restore" ) , _drop(false) , _batchBytes(0) {
         // Default values set here will show up in help text, but will supercede any default value
         // used when calling getParam below.
         add_options()
@@ -213,6 +217,7 @@ public:
             log() << "\t Replaying oplog" << endl;
             _curns = OPLOG_SENTINEL;
             processFile( root / "oplog.bson" );
+            applyOplogBatch();
             log() << "Applied " << _oplogEntryApplies << " oplog entries out of "
                   << _oplogEntryApplies + _oplogEntrySkips << " (" << _oplogEntrySkips
                   << " skipped)." << endl;
@@ -381,6 +386,7 @@ public:
         }
 
         processFile( root );
+        flushBatch();
         if (_drop && root.leaf() == "system.users.bson") {
             // Delete any users that used to exist but weren't in the dump file
             for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
@@ -409,21 +415,10 @@ public:
                 return;
             }
 
-            string db = obj["ns"].valuestr();
-            db = db.substr(0, db.find('.'));
-
-            BSONObj cmd = BSON( "applyOps" << BSON_ARRAY( obj ) );
-            BSONObj out;
-            conn().runCommand(db, cmd, out);
+            if (_oplogBatch.isFull(obj))
+                applyOplogBatch();
+            _oplogBatch.add(obj);
             _oplogEntryApplies++;
-
-            // wait for ops to propagate to "w" nodes (doesn't warn if w used without replset)
-            if ( _w > 0 ) {
-                string err = conn().getLastError(db, false, false, _w);
-                if (!err.empty()) {
-                    error() << "Error while replaying oplog: " << err;
-                }
-            }
         }
         else if (nsToCollectionSubstring(_curns) == "system.indexes") {
             createIndex(obj, true);
@@ -438,20 +433,55 @@ public:
             _users.erase(obj["user"].String());
         }
         else {
-            conn().insert( _curns , obj );
+            // processFile reuses its buffer for the next document
+            if ( _batchBytes + obj.objsize() > BSONObjMaxUserSize )
+                flushBatch();
+            _batch.push_back( obj.getOwned() );
+            _batchBytes += obj.objsize();
+        }
+    }
 
-            // wait for insert to propagate to "w" nodes (doesn't warn if w used without replset)
-            if ( _w > 0 ) {
-                string err = conn().getLastError(_curdb, false, false, _w);
-                if (!err.empty()) {
-                    error() << err;
-                }
+    /**
+     * Sends the documents gathered for _curns as one insert message.  As with one message per
+     * document, a document that fails to insert (a duplicate _id, say) doesn't stop the rest.
+     */
+    void flushBatch() {
+        if ( _batch.empty() )
+            return;
+
+        conn().insert( _curns , _batch , InsertOption_ContinueOnError );
+        _batch.clear();
+        _batchBytes = 0;
+
+        // wait for inserts to propagate to "w" nodes (doesn't warn if w used without replset)
+        if ( _w > 0 ) {
+            string err = conn().getLastError(_curdb, false, false, _w);
+            if (!err.empty()) {
+                error() << err;
             }
         }
     }
 
 private:
 
+    void applyOplogBatch() {
+        if (_oplogBatch.empty())
+            return;
+
+        BSONObj out;
+        if (!_oplogBatch.apply(conn(), &out)) {
+            error() << "Error while replaying oplog: " << out << endl;
+        }
+
+        // wait for ops to propagate to "w" nodes (doesn't warn if w used without replset)
+        if ( _w > 0 ) {
+            string err = conn().getLastError("admin", false, false, _w);
+            if (!err.empty()) {
+                error() << "Error while replaying oplog: " << err;
+            }
+        }
+    }
+
     BSONObj parseMetadataFile(string filePath) {
         long long fileSize = boost::filesystem::file_size(filePath);
         ifstream file(filePath.c_str(), ios_base::in);
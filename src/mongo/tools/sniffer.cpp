@@ -31,7 +31,9 @@
 #undef max
 #endif
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <algorithm>
 #include <ctype.h>
 #include <errno.h>
 #include <iostream>
@@ -53,6 +55,7 @@
 #include "mongo/bson/util/builder.h"
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/dbmessage.h"
+#include "mongo/tools/traffic_recording.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/text.h"
@@ -76,6 +79,8 @@ set<int> serverPorts;
 string forwardAddress;
 bool objcheck = false;
 
+boost::scoped_ptr<mongo::TrafficRecordWriter> recorder;
+
 ostream *outPtr = &cout;
 ostream &out() { return *outPtr; }
 
@@ -158,6 +163,14 @@ map< Connection, boost::shared_ptr<DBClientConnection> > forwarder;
 map< Connection, long long > lastCursor;
 map< Connection, map< long long, long long > > mapCursor;
 
+// for --record: ids given to client connections, keyed by the client to server direction
+map< Connection, unsigned > recordedConnectionId;
+// capture time of the packet being processed, and of the first one recorded
+unsigned long long packetMicros = 0;
+unsigned long long firstRecordedMicros = 0;
+bool recordedAny = false;
+unsigned long long numRecorded = 0;
+
 void processMessage( Connection& c , Message& d );
 
 void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
@@ -185,6 +198,8 @@ void got_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *pa
 
     const u_char * payload = (const u_char*)(packet + captureHeaderSize + size_ip + size_tcp);
 
+    packetMicros = header->ts.tv_sec * 1000000ULL + header->ts.tv_usec;
+
     unsigned totalSize = ntohs(ip->ip_len);
     verify( totalSize <= header->caplen );
 
@@ -269,9 +284,39 @@ public:
     }
 };
 
+void recordMessage( const Connection& c , Message& m ) {
+    if ( !recordedAny ) {
+        recordedAny = true;
+        firstRecordedMicros = packetMicros;
+    }
+
+    const bool isReply = m.operation() == mongo::opReply;
+    const Connection client = isReply ? c.reverse() : c;
+    unsigned &id = recordedConnectionId[ client ];
+    if ( id == 0 )
+        id = recordedConnectionId.size();
+
+    int len = m.header()->len;
+    if ( isReply ) {
+        // replay only needs the reply's cursor id
+        QueryResult *qr = (QueryResult *) m.singleData();
+        len = std::min( len , (int)( qr->data() - (const char *) qr ) );
+    }
+    const unsigned long long offset =
+        packetMicros > firstRecordedMicros ? packetMicros - firstRecordedMicros : 0;
+    recorder->write( id , offset , (const char *) m.singleData() , len );
+
+    // live captures run until killed
+    if ( ++numRecorded % 100 == 0 )
+        recorder->flush();
+}
+
 void processMessage( Connection& c , Message& m ) {
     AuditingDbMessage d(m);
 
+    if ( recorder )
+        recordMessage( c , m );
+
     if ( m.operation() == mongo::opReply )
         out() << " - " << (unsigned)m.header()->responseTo;
     out() << '\n';
@@ -424,9 +469,11 @@ void processDiagLog( const char * file ) {
 
 void usage() {
     cout <<
-         "Usage: mongosniff [--help] [--forward host:port] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
+         "Usage: mongosniff [--help] [--forward host:port] [--record <filename>] [--source (NET <interface> | (FILE | DIAGLOG) <filename>)] [<port0> <port1> ... ]\n"
          "--forward       Forward all parsed request messages to mongod instance at \n"
          "                specified host:port\n"
+         "--record        Write the parsed messages, with their timing and connection,\n"
+         "                to a file for mongoreplay, instead of printing them.\n"
          "--source        Source of traffic to sniff, either a network interface or a\n"
          "                file containing previously captured packets in pcap format,\n"
          "                or a file containing output from mongod's --diaglog option.\n"
@@ -480,6 +527,11 @@ int toolMain(int argc, char **argv, char** envp) {
             else if ( arg == string( "--forward" ) ) {
                 forwardAddress = args[ ++i ];
             }
+            else if ( arg == string( "--record" ) ) {
+                uassert( 17013 , "--record needs a filename" , args.size() > i + 1 );
+                recorder.reset( new mongo::TrafficRecordWriter( args[ ++i ] ) );
+                outPtr = &nullStream;
+            }
             else if ( arg == string( "--source" ) ) {
                 uassert( 10266 ,  "can't use --source twice" , source == false );
                 uassert( 10267 ,  "source needs more args" , args.size() > i + 2);
@@ -510,6 +562,8 @@ int toolMain(int argc, char **argv, char** envp) {
 
     if ( diaglog ) {
         processDiagLog( file );
+        if ( recorder )
+            recorder->flush();
         return 0;
     }
     else if ( replay ) {
@@ -561,6 +615,9 @@ int toolMain(int argc, char **argv, char** envp) {
 
     pcap_loop(handle, 0 , got_packet, NULL);
 
+    if ( recorder )
+        recorder->flush();
+
     pcap_freecode(&fp);
     pcap_close(handle);
 
@@ -124,7 +124,7 @@ namespace mongo {
                 return e.embeddedObjectUserCheck();
             }
             BSONObj out;
-            if ( ! conn().simpleCommand( _db , &out , "serverStatus" ) ) {
+            if ( ! conn().runCommand( _db , StatUtil::serverStatusCommand() , out ) ) {
                 cout << "error: " << out << endl;
                 return BSONObj();
             }
@@ -299,7 +299,7 @@ namespace mongo {
                 while ( ++cycleNumber ) {
                     try {
                         BSONObj out;
-                        if ( conn.simpleCommand( "admin" , &out , "serverStatus" ) ) {
+                        if ( conn.runCommand( "admin" , StatUtil::serverStatusCommand() , out ) ) {
                             scoped_lock lk( state->lock );
                             state->error = "";
                             state->lastUpdate = time(0);
@@ -302,6 +302,24 @@ namespace mongo {
         _append( result , name , width , ss.str() );
     }
 
+    BSONObj StatUtil::serverStatusCommand() {
+        return BSON( "serverStatus" << 1 <<
+                     "defaultSections" << false <<
+                     "backgroundFlushing" << 1 <<
+                     "connections" << 1 <<
+                     "extra_info" << 1 <<
+                     "globalLock" << 1 <<
+                     "indexCounters" << 1 <<
+                     "locks" << 1 <<
+                     // mem is in the metric tree
+                     "metrics" << 1 <<
+                     "network" << 1 <<
+                     "opcounters" << 1 <<
+                     "opcountersRepl" << 1 <<
+                     "repl" << 1 <<
+                     "shardCursorType" << 1 );
+    }
+
     NamespaceStats StatUtil::parseServerStatusLocks( const BSONObj& serverStatus ) {
         NamespaceStats stats;
 
@@ -83,6 +83,12 @@ namespace mongo {
         void setSeconds( double seconds ) { _seconds = seconds; }
         void setAll( bool all ) { _all = all; }
 
+        /**
+         * @return the serverStatus command to poll with: it asks for just the sections
+         *     doRow() reads, which servers that don't know the option ignore
+         */
+        static BSONObj serverStatusCommand();
+
         static NamespaceStats parseServerStatusLocks( const BSONObj& serverStatus );
         static vector<NamespaceDiff> computeDiff( const NamespaceStats& prev , const NamespaceStats& current );
     private:
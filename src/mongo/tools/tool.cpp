@@ -21,6 +21,13 @@
 #include <boost/filesystem/operations.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "pcrecpp.h"
 
@@ -340,6 +347,27 @@ namespace mongo {
         return *_conn;
     }
 
+    DBClientBase* Tool::newConnection() {
+        verify( !_noconnection && _host != "DIRECT" );
+
+        string errmsg;
+        ConnectionString cs = ConnectionString::parse( _host , errmsg );
+        uassert( 17006, str::stream() << "invalid hostname [" << _host << "] " << errmsg,
+                 cs.isValid() );
+
+        auto_ptr<DBClientBase> c( cs.connect( errmsg ) );
+        uassert( 17007, str::stream() << "couldn't connect to [" << _host << "] " << errmsg,
+                 c.get() );
+
+        if ( !_username.empty() ) {
+            c->auth( BSON( saslCommandUserSourceFieldName << getAuthenticationDatabase() <<
+                           saslCommandUserFieldName << _username <<
+                           saslCommandPasswordFieldName << _password  <<
+                           saslCommandMechanismFieldName << _authenticationMechanism ) );
+        }
+        return c.release();
+    }
+
     bool Tool::isMaster() {
         if ( hasParam("dbpath") ) {
             return true;
@@ -488,71 +516,53 @@ namespace mongo {
         }
 
 
-        FILE* file = fopen( _fileName.c_str() , "rb" );
-        if ( ! file ) {
-            cerr << "error opening file: " << _fileName << " " << errnoWithDescription() << endl;
-            return 0;
-        }
+        unsigned long long processed = 0;
+
+        ProgressMeter m( fileLength );
+        m.setUnits( "bytes" );
+
+        if ( !processMappedFile( fileLength, m, &processed ) ) {
+            FILE* file = fopen( _fileName.c_str() , "rb" );
+            if ( ! file ) {
+                cerr << "error opening file: " << _fileName << " " << errnoWithDescription() << endl;
+                return 0;
+            }
 
 #ifdef POSIX_FADV_SEQUENTIAL
-        posix_fadvise(fileno(file), 0, fileLength, POSIX_FADV_SEQUENTIAL);
+            posix_fadvise(fileno(file), 0, fileLength, POSIX_FADV_SEQUENTIAL);
 #endif
 
-        if (!_quiet && logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
-            (_usesstdout ? cout : cerr ) << "\t file size: " << fileLength << endl;
-        }
+            if (!_quiet && logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
+                (_usesstdout ? cout : cerr ) << "\t file size: " << fileLength << endl;
+            }
 
-        unsigned long long read = 0;
-        unsigned long long num = 0;
-        unsigned long long processed = 0;
+            unsigned long long read = 0;
 
-        const int BUF_SIZE = BSONObjMaxUserSize + ( 1024 * 1024 );
-        boost::scoped_array<char> buf_holder(new char[BUF_SIZE]);
-        char * buf = buf_holder.get();
+            const int BUF_SIZE = BSONObjMaxUserSize + ( 1024 * 1024 );
+            boost::scoped_array<char> buf_holder(new char[BUF_SIZE]);
+            char * buf = buf_holder.get();
 
-        ProgressMeter m( fileLength );
-        m.setUnits( "bytes" );
+            while ( read < fileLength ) {
+                size_t amt = fread(buf, 1, 4, file);
+                verify( amt == 4 );
 
-        while ( read < fileLength ) {
-            size_t amt = fread(buf, 1, 4, file);
-            verify( amt == 4 );
-
-            int size = ((int*)buf)[0];
-            uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
-
-            amt = fread(buf+4, 1, size-4, file);
-            verify( amt == (size_t)( size - 4 ) );
-
-            BSONObj o( buf );
-            if ( _objcheck && ! o.valid() ) {
-                cerr << "INVALID OBJECT - going to try and print out " << endl;
-                cerr << "size: " << size << endl;
-                BSONObjIterator i(o);
-                while ( i.more() ) {
-                    BSONElement e = i.next();
-                    try {
-                        e.validate();
-                    }
-                    catch ( ... ) {
-                        cerr << "\t\t NEXT ONE IS INVALID" << endl;
-                    }
-                    cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
-                    cerr << "\t " << e << endl;
-                }
-            }
+                int size = ((int*)buf)[0];
+                uassert( 10264 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
 
-            if ( _matcher.get() == 0 || _matcher->matches( o ) ) {
-                gotObject( o );
-                processed++;
-            }
+                amt = fread(buf+4, 1, size-4, file);
+                verify( amt == (size_t)( size - 4 ) );
 
-            read += o.objsize();
-            num++;
+                BSONObj o( buf );
+                if ( processObject( o ) )
+                    processed++;
 
-            m.hit( o.objsize() );
-        }
+                read += o.objsize();
 
-        fclose( file );
+                m.hit( o.objsize() );
+            }
+
+            fclose( file );
+        }
 
         uassert( 10265 ,  "counts don't match" , m.done() == fileLength );
         if (!_quiet) {
@@ -563,4 +573,90 @@ namespace mongo {
         return processed;
     }
 
+    bool BSONTool::processObject( const BSONObj& o ) {
+        if ( _objcheck && ! o.valid() ) {
+            cerr << "INVALID OBJECT - going to try and print out " << endl;
+            cerr << "size: " << o.objsize() << endl;
+            BSONObjIterator i(o);
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                try {
+                    e.validate();
+                }
+                catch ( ... ) {
+                    cerr << "\t\t NEXT ONE IS INVALID" << endl;
+                }
+                cerr << "\t name : " << e.fieldName() << " " << e.type() << endl;
+                cerr << "\t " << e << endl;
+            }
+        }
+
+        if ( _matcher.get() == 0 || _matcher->matches( o ) ) {
+            gotObject( o );
+            return true;
+        }
+        return false;
+    }
+
+    bool BSONTool::processMappedFile( unsigned long long fileLength, ProgressMeter& m,
+                                      unsigned long long* processed ) {
+#if defined(_WIN32)
+        return false;
+#else
+        if ( fileLength > std::numeric_limits<size_t>::max() )
+            return false;
+
+        int fd = open( _fileName.c_str(), O_RDONLY );
+        if ( fd < 0 )
+            return false;
+        void* view = mmap( NULL, fileLength, PROT_READ, MAP_PRIVATE, fd, 0 );
+        close( fd );
+        if ( view == MAP_FAILED ) {
+            LOG(1) << "couldn't map " << _fileName << ", reading it instead: "
+                   << errnoWithDescription() << endl;
+            return false;
+        }
+
+        // unmapped however this returns; gotObject() can throw
+        class ViewHolder : boost::noncopyable {
+        public:
+            ViewHolder( void* view, size_t length ) : _view( view ), _length( length ) { }
+            ~ViewHolder() { munmap( _view, _length ); }
+        private:
+            void* _view;
+            size_t _length;
+        } holder( view, fileLength );
+
+#ifdef MADV_SEQUENTIAL
+        // the kernel reads ahead further, and drops what's behind sooner
+        madvise( view, fileLength, MADV_SEQUENTIAL );
+#endif
+
+        if (!_quiet && logger::globalLogDomain()->shouldLog(logger::LogSeverity::Debug(1))) {
+            (_usesstdout ? cout : cerr ) << "\t file size: " << fileLength << " (mapped)" << endl;
+        }
+
+        const char* const base = static_cast<const char*>( view );
+        unsigned long long read = 0;
+        while ( read < fileLength ) {
+            uassert( 10264, "invalid object size: file ends in the middle of an object",
+                     fileLength - read >= 4 );
+            int size;
+            memcpy( &size, base + read, sizeof( size ) );
+            uassert( 10264 , str::stream() << "invalid object size: " << size ,
+                     size >= 5 && static_cast<unsigned long long>( size ) <= fileLength - read &&
+                     size < BSONObjMaxUserSize + ( 1024 * 1024 ) );
+
+            BSONObj o( base + read );
+            if ( processObject( o ) )
+                ( *processed )++;
+
+            read += size;
+
+            m.hit( size );
+        }
+        return true;
+#endif
+    }
+
 }
@@ -105,6 +105,13 @@ namespace mongo {
 
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
 
+        /**
+         * Opens another connection to the server the tool connected to, authenticated as the
+         * first one was, for tools that work on more than one thread.  The caller owns it.
+         * Not available with --dbpath.
+         */
+        mongo::DBClientBase* newConnection();
+
         string _name;
 
         string _db;
@@ -160,6 +167,19 @@ namespace mongo {
 
         long long processFile( const boost::filesystem::path& file );
 
+    private:
+        /**
+         * Checks 'o' if asked to and hands it to gotObject() if it passes the filter.
+         * @return true if it was handed on
+         */
+        bool processObject( const BSONObj& o );
+
+        /**
+         * Reads the objects of _fileName through a read only mapping of it, in order.
+         * @return false, without having read anything, if the file couldn't be mapped
+         */
+        bool processMappedFile( unsigned long long fileLength, ProgressMeter& m,
+                                unsigned long long* processed );
     };
 
 }
@@ -0,0 +1,92 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mongo/pch.h"
+
+#include "mongo/tools/traffic_recording.h"
+
+#include <cstdlib>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    namespace {
+        const char kMagic[8] = { 'm', 'g', 'o', 't', 'r', 'a', 'f', '1' };
+
+#pragma pack(1)
+        struct RecordHeader {
+            int32_t len;
+            uint32_t connectionId;
+            uint64_t offsetMicros;
+        };
+#pragma pack()
+    }
+
+    TrafficRecordWriter::TrafficRecordWriter( const std::string& path )
+        : _out( path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc ) {
+        uassert( 17009, str::stream() << "couldn't open " << path << " for writing",
+                 _out.good() );
+        _out.write( kMagic, sizeof( kMagic ) );
+    }
+
+    void TrafficRecordWriter::write( uint32_t connectionId, uint64_t offsetMicros,
+                                     const char* data, int len ) {
+        RecordHeader header;
+        header.len = len;
+        header.connectionId = connectionId;
+        header.offsetMicros = offsetMicros;
+        _out.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+        _out.write( data, len );
+    }
+
+    TrafficRecordReader::TrafficRecordReader( const std::string& path )
+        : _path( path ),
+          _in( path.c_str(), std::ios::in | std::ios::binary ) {
+        uassert( 17010, str::stream() << "couldn't open " << path, _in.good() );
+
+        char magic[sizeof( kMagic )];
+        _in.read( magic, sizeof( magic ) );
+        uassert( 17011, str::stream() << path << " is not a traffic recording",
+                 _in.gcount() == sizeof( magic ) &&
+                 memcmp( magic, kMagic, sizeof( magic ) ) == 0 );
+    }
+
+    bool TrafficRecordReader::next( TrafficRecord* record ) {
+        RecordHeader header;
+        _in.read( reinterpret_cast<char*>( &header ), sizeof( header ) );
+        if ( _in.gcount() == 0 )
+            return false;
+        uassert( 17012, str::stream() << "truncated record in " << _path,
+                 _in.gcount() == sizeof( header ) &&
+                 header.len >= static_cast<int>( sizeof( MSGHEADER ) ) );
+
+        char* data = static_cast<char*>( malloc( header.len ) );
+        _in.read( data, header.len );
+        if ( _in.gcount() != header.len ) {
+            free( data );
+            uasserted( 17012, str::stream() << "truncated record in " << _path );
+        }
+
+        record->connectionId = header.connectionId;
+        record->offsetMicros = header.offsetMicros;
+        record->message.setData( reinterpret_cast<MsgData*>( data ), true );
+        return true;
+    }
+
+}  // namespace mongo
@@ -0,0 +1,82 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <fstream>
+#include <string>
+
+#include "mongo/platform/cstdint.h"
+#include "mongo/util/net/message.h"
+
+namespace mongo {
+
+    /**
+     * One message from a recording of client traffic, as made by mongosniff --record and
+     * replayed by mongoreplay.
+     *
+     * Requests are recorded whole.  Replies are only recorded as far as nReturned, which is
+     * all replay needs to map the original cursor ids onto the ones it gets back; their
+     * header still has the length of the original reply.
+     */
+    struct TrafficRecord {
+        // which client connection the message went over, numbered from 1 in order of each
+        // connection's first message
+        uint32_t connectionId;
+
+        // when the message was seen, counting from the first one in the recording
+        uint64_t offsetMicros;
+
+        Message message;
+    };
+
+    /**
+     * Writes a recording.  The file is a magic string, then for each message its length in
+     * the file, connection id and offset, little endian, followed by the message bytes.
+     */
+    class TrafficRecordWriter : boost::noncopyable {
+    public:
+        /** uasserts if 'path' can't be written. */
+        explicit TrafficRecordWriter( const std::string& path );
+
+        void write( uint32_t connectionId, uint64_t offsetMicros, const char* data, int len );
+
+        void flush() { _out.flush(); }
+
+    private:
+        std::ofstream _out;
+    };
+
+    class TrafficRecordReader : boost::noncopyable {
+    public:
+        /** uasserts if 'path' can't be read or isn't a recording. */
+        explicit TrafficRecordReader( const std::string& path );
+
+        /**
+         * Reads the next message into 'record', whose message must be empty.
+         *
+         * @return false at the end of the recording.  uasserts if it ends mid-record.
+         */
+        bool next( TrafficRecord* record );
+
+    private:
+        std::string _path;
+        std::ifstream _in;
+    };
+
+}  // namespace mongo
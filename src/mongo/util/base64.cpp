@@ -24,7 +24,7 @@ namespace mongo {
 
         Alphabet alphabet;
 
-        void encode( stringstream& ss , const char * data , int size ) {
+        void encode( std::ostream& ss , const char * data , int size ) {
             for ( int i=0; i<size; i+=3 ) {
                 int left = size - i;
                 const unsigned char * start = (const unsigned char*)data + i;
@@ -55,7 +55,7 @@ namespace mongo {
         extern Alphabet alphabet;
 
 
-        void encode( stringstream& ss , const char * data , int size );
+        void encode( std::ostream& ss , const char * data , int size );
         string encode( const char * data , int size );
         string encode( const string& s );
 
@@ -18,9 +18,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <boost/noncopyable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <set>
 #include "../assert_util.h"
 #include "../time_support.h"
 
@@ -60,22 +63,61 @@ namespace mongo {
         transition, all threads in the "w" state must be blocked in w_to_X().  When all threads in
         the "w" state are blocked in w_to_X(), one thread will be released in the X state.  The
         other threads remain blocked in w_to_X() until the thread in the X state calls X_to_w().
+
+        Fairness: a thread that has to wait for r, w, R or W takes a ticket, in arrival order.
+        A waiting W blocks r, w and R requests that arrived after it ("greed"), so a stream of
+        readers can't starve it; but it doesn't block those that were already waiting when it
+        came, and it doesn't go ahead of them either.  So a reader waits for at most the
+        writers queued before it, not for every writer that shows up while it waits.
+        R_to_W() still goes ahead of everyone.
+
+        Before sleeping a waiter spins for a while, in case the lock is about to be free; the
+        spin count for each mode grows when spinning pays off and shrinks when it doesn't.
+        There is no spinning on a single core, where the holder can't run meanwhile.
     */
     class QLock : boost::noncopyable {
+    public:
+        struct WaitStats {
+            WaitStats() : acquisitions(0), waits(0), spinAcquisitions(0), waitMicros(0),
+                          maxWaitMicros(0) { }
+            long long acquisitions;
+            long long waits;             // acquisitions that didn't get the lock right away
+            long long spinAcquisitions;  // waits that ended while spinning
+            long long waitMicros;
+            long long maxWaitMicros;
+        };
+
+    private:
+        enum { MinSpins = 16, MaxSpins = 4096 };
+
         struct Z { 
-            Z() : n(0) { }
+            Z() : n(0), spins(MinSpins * 4) { }
             boost::condition c;
             int n;
+            int spins;
+            WaitStats stats;
         };
         boost::mutex m;
         Z r,w,R,W,U,X;
-        int numPendingGlobalWrites;  // >0 if someone wants to acquire a write lock
+        long long lastTicket;
+        std::multiset<long long> pendingGlobalWrites;  // tickets of waiting W's; R_to_W uses 0
+        std::multiset<long long> waitingShared;        // tickets of waiting r's, w's and R's
         long long generationX;
         long long generationXExit;
-        void _lock_W();
+        const bool spinning;
         void _unlock_R();
         bool _areQueueJumpingGlobalWritesPending() const {
-            return numPendingGlobalWrites > 0;
+            return !pendingGlobalWrites.empty();
+        }
+
+        /** true if a W that arrived before 'ticket' is waiting */
+        bool _greedBlocks(long long ticket) const {
+            return !pendingGlobalWrites.empty() && *pendingGlobalWrites.begin() < ticket;
+        }
+
+        /** true if an r, w or R that arrived before 'ticket' is waiting */
+        bool _sharedWaiterAhead(long long ticket) const {
+            return !waitingShared.empty() && *waitingShared.begin() < ticket;
         }
 
         bool W_legal() const { return r.n + w.n + R.n + W.n + X.n == 0; }
@@ -83,27 +125,40 @@ namespace mongo {
         bool r_legal_ignore_greed() const { return W.n + X.n == 0; }
         bool w_legal_ignore_greed() const { return R.n + W.n + X.n == 0; }
 
-        bool R_legal() const {
-            return !_areQueueJumpingGlobalWritesPending() && R_legal_ignore_greed();
-        }
+        bool X_legal() const { return w.n + r.n + R.n + W.n == 0; }
 
-        bool w_legal() const {
-            return !_areQueueJumpingGlobalWritesPending() && w_legal_ignore_greed();
-        }
+        Z& z(char mode);
 
-        bool r_legal() const {
-            return !_areQueueJumpingGlobalWritesPending() && r_legal_ignore_greed();
-        }
+        /** whether a waiter for 'mode' holding 'ticket' may go in now */
+        bool legal(char mode, long long ticket) const;
 
-        bool X_legal() const { return w.n + r.n + R.n + W.n == 0; }
+        /**
+         * Whether 'mode' might be free, from a look at the counts without holding m; only a
+         * hint for when spinning to take m and check properly.
+         */
+        bool looksFree(char mode) const;
+
+        /**
+         * Waits, with m locked through 'lk', until a thread with 'ticket' may lock 'mode' (it
+         * should already be in pendingGlobalWrites or waitingShared), or until 'deadline'
+         * if not 0.  Spins first.
+         * @return true if it may
+         */
+        bool wait(char mode, long long ticket, boost::mutex::scoped_lock& lk,
+                  unsigned long long deadline = 0);
+
+        /** lock 'mode', waiting until 'deadline' at the most if not 0 */
+        bool lock(char mode, unsigned long long deadline = 0);
 
         void notifyWeUnlocked(char me);
         static bool i_block(char me, char them);
+        static void spinPause();
     public:
         QLock() :
-            numPendingGlobalWrites(0),
+            lastTicket(0),
             generationX(0),
-            generationXExit(0) {
+            generationXExit(0),
+            spinning(boost::thread::hardware_concurrency() > 1) {
         }
 
         void lock_r();
@@ -120,8 +175,144 @@ namespace mongo {
         void R_to_W(); // caution see notes below
         bool w_to_X();
         void X_to_w();
+
+        /** @param mode one of r, w, R or W */
+        WaitStats waitStats(char mode);
     };
 
+    inline void QLock::spinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+        asm volatile ( "pause" ::: "memory" );
+#elif defined(_WIN32)
+        YieldProcessor();
+        _ReadWriteBarrier();
+#else
+        asm volatile ( "" ::: "memory" );
+#endif
+    }
+
+    inline QLock::Z& QLock::z(char mode) {
+        switch( mode ) {
+        case 'r' : return r;
+        case 'w' : return w;
+        case 'R' : return R;
+        case 'W' : return W;
+        default  : fassertFailed(17003);
+        }
+        return W;
+    }
+
+    inline bool QLock::legal(char mode, long long ticket) const {
+        switch( mode ) {
+        case 'r' : return r_legal_ignore_greed() && !_greedBlocks(ticket);
+        case 'w' : return w_legal_ignore_greed() && !_greedBlocks(ticket);
+        case 'R' : return R_legal_ignore_greed() && !_greedBlocks(ticket);
+        case 'W' : return W_legal() && !_sharedWaiterAhead(ticket);
+        default  : fassertFailed(17004);
+        }
+        return false;
+    }
+
+    inline bool QLock::looksFree(char mode) const {
+        switch( mode ) {
+        case 'r' : return r_legal_ignore_greed();
+        case 'w' : return w_legal_ignore_greed();
+        case 'R' : return R_legal_ignore_greed();
+        default  : return W_legal();
+        }
+    }
+
+    inline bool QLock::wait(char mode, long long ticket, boost::mutex::scoped_lock& lk,
+                            unsigned long long deadline) {
+        Z& me = z(mode);
+        const unsigned long long start = curTimeMicros64();
+        bool got = false;
+
+        if ( spinning ) {
+            const int spins = me.spins;
+            lk.unlock();
+            for( int i = 0; i < spins; i++ ) {
+                spinPause();
+                if ( looksFree(mode) ) {
+                    lk.lock();
+                    if ( legal(mode, ticket) ) {
+                        got = true;
+                        break;
+                    }
+                    lk.unlock();
+                }
+            }
+            if ( !got ) {
+                lk.lock();
+            }
+            if ( got ) {
+                me.spins = std::min(static_cast<int>(MaxSpins), me.spins * 2);
+                me.stats.spinAcquisitions++;
+            }
+            else {
+                me.spins = std::max(static_cast<int>(MinSpins), me.spins / 2);
+            }
+        }
+
+        while( !got && !( got = legal(mode, ticket) ) ) {
+            if ( deadline == 0 ) {
+                me.c.wait(m);
+            }
+            else {
+                const unsigned long long now = curTimeMillis64();
+                if ( now >= deadline )
+                    break;
+                me.c.timed_wait(m, boost::posix_time::milliseconds(deadline - now));
+            }
+        }
+
+        const long long waited = curTimeMicros64() - start;
+        me.stats.waits++;
+        me.stats.waitMicros += waited;
+        me.stats.maxWaitMicros = std::max(me.stats.maxWaitMicros, waited);
+        return got;
+    }
+
+    inline bool QLock::lock(char mode, unsigned long long deadline) {
+        boost::mutex::scoped_lock lk(m);
+        Z& me = z(mode);
+
+        const bool global = mode == 'W';
+        const bool free = global ? W_legal() && waitingShared.empty()
+                                 : looksFree(mode) && !_areQueueJumpingGlobalWritesPending();
+        if ( !free ) {
+            const long long ticket = ++lastTicket;
+            std::multiset<long long>& waiting = global ? pendingGlobalWrites : waitingShared;
+            std::multiset<long long>::iterator i = waiting.insert(ticket);
+            const bool got = wait(mode, ticket, lk, deadline);
+            waiting.erase(i);
+            if ( !got ) {
+                // others may have been waiting on us
+                if ( global ) {
+                    r.c.notify_all();
+                    w.c.notify_all();
+                    R.c.notify_all();
+                }
+                else if ( W_legal() ) {
+                    W.c.notify_all();
+                }
+                return false;
+            }
+        }
+
+        me.n++;
+        me.stats.acquisitions++;
+        if ( global ) {
+            fassert( 16202, W.n == 1 );
+        }
+        return true;
+    }
+
+    inline QLock::WaitStats QLock::waitStats(char mode) {
+        boost::mutex::scoped_lock lk(m);
+        return z(mode).stats;
+    }
+
     inline bool QLock::i_block(char me, char them) {
         switch( me ) {
         case 'W' : return true;
@@ -150,9 +341,8 @@ namespace mongo {
             X.c.notify_one();
         }
         if ( W_legal() && i_block(me, 'W') ) {
-            W.c.notify_one();
-            if( _areQueueJumpingGlobalWritesPending() )
-                return;
+            // all of them: only the earliest may be allowed in
+            W.c.notify_all();
         }
         if ( R_legal_ignore_greed() && i_block(me, 'R') ) {
             R.c.notify_all();
@@ -168,63 +358,27 @@ namespace mongo {
     // "i will be reading. i promise to coordinate my activities with w's as i go with more 
     //  granular locks."
     inline void QLock::lock_r() {
-        boost::mutex::scoped_lock lk(m);
-        while( !r_legal() ) {
-            r.c.wait(m);
-        }
-        r.n++;
+        lock('r');
     }
 
     // "i will be writing. i promise to coordinate my activities with w's and r's as i go with more 
     //  granular locks."
     inline void QLock::lock_w() { 
-        boost::mutex::scoped_lock lk(m);
-        while( !w_legal() ) {
-            w.c.wait(m);
-        }
-        w.n++;
+        lock('w');
     }
 
     // "i will be reading. i will coordinate with no one. you better stop them if they
     // are writing."
     inline void QLock::lock_R() {
-        boost::mutex::scoped_lock lk(m);
-        while( ! R_legal() ) {
-            R.c.wait(m);
-        }
-        R.n++;
+        lock('R');
     }
 
     inline bool QLock::lock_R_try(int millis) {
-        unsigned long long end = curTimeMillis64() + millis;
-        boost::mutex::scoped_lock lk(m);
-        while( !R_legal() && curTimeMillis64() < end ) {
-            R.c.timed_wait(m, boost::posix_time::milliseconds(millis));
-        }
-        if ( R_legal() ) {
-            R.n++;
-            return true;
-        }
-        return false;
+        return lock('R', curTimeMillis64() + millis);
     }
 
     inline bool QLock::lock_W_try(int millis) {
-        unsigned long long end = curTimeMillis64() + millis;
-        boost::mutex::scoped_lock lk(m);
-
-        ++numPendingGlobalWrites;
-        while (!W_legal() && curTimeMillis64() < end) {
-            W.c.timed_wait(m, boost::posix_time::milliseconds(millis));
-        }
-        --numPendingGlobalWrites;
-
-        if (W_legal()) {
-            W.n++;
-            fassert( 16202, W.n == 1 );
-            return true;
-        }
-
-        return false;
+        return lock('W', curTimeMillis64() + millis);
     }
 
 
@@ -257,12 +411,12 @@ namespace mongo {
 
         U.n = 1;
 
-        ++numPendingGlobalWrites;
+        std::multiset<long long>::iterator i = pendingGlobalWrites.insert(0);
 
         while( W.n + R.n + w.n + r.n > 1 ) {
             U.c.wait(m);
         }
-        --numPendingGlobalWrites;
+        pendingGlobalWrites.erase(i);
 
         fassert(16209, R.n == 1);
         fassert(16210, W.n == 0);
@@ -317,17 +471,8 @@ namespace mongo {
     }
 
     // "i will be writing. i will coordinate with no one. you better stop them all"
-    inline void QLock::_lock_W() {
-        ++numPendingGlobalWrites;
-        while( !W_legal() ) {
-            W.c.wait(m);
-        }
-        --numPendingGlobalWrites;
-        W.n++;
-    }
     inline void QLock::lock_W() {
-        boost::mutex::scoped_lock lk(m);
-        _lock_W();
+        lock('W');
     }
 
     inline void QLock::unlock_r() {
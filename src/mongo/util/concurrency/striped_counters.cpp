@@ -0,0 +1,43 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/concurrency/striped_counters.h"
+
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    namespace {
+        struct CounterStripe {
+            CounterStripe();
+            unsigned index;
+        };
+
+        AtomicUInt32 nextCounterStripe;
+
+        CounterStripe::CounterStripe() : index( nextCounterStripe.fetchAndAdd( 1 ) ) { }
+    }
+
+    TSP_DECLARE(CounterStripe, currentCounterStripe)
+    TSP_DEFINE(CounterStripe, currentCounterStripe)
+
+    unsigned counterStripe() {
+        return currentCounterStripe.getMake()->index;
+    }
+
+}  // namespace mongo
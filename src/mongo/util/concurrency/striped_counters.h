@@ -0,0 +1,66 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/compiler.h"
+
+namespace mongo {
+
+    /**
+     * @return the stripe of a StripedCounters the calling thread counts in.  Threads are
+     *     given stripes in turn as they first count something.
+     */
+    unsigned counterStripe();
+
+    /**
+     * N 64 bit counters, each split over cache line sized stripes so that threads counting
+     * the same thing mostly write to lines of their own rather than all to one.  Adding is an
+     * uncontended atomic add; reading sums the stripes, which is for serverStatus and the
+     * like, not for every operation.
+     */
+    template< int N >
+    class StripedCounters {
+    public:
+        enum { kStripes = 32 };
+
+        void add( int which , long long n ) {
+            _stripes[ counterStripe() % kStripes ].counts[which].fetchAndAdd( n );
+        }
+
+        long long get( int which ) const {
+            long long total = 0;
+            for ( int i = 0; i < kStripes; i++ )
+                total += _stripes[i].counts[which].load();
+            return total;
+        }
+
+        /** not atomic with adds going on at the same time, which may be lost */
+        void zero() {
+            for ( int i = 0; i < kStripes; i++ )
+                for ( int j = 0; j < N; j++ )
+                    _stripes[i].counts[j].store( 0 );
+        }
+
+    private:
+        struct MONGO_COMPILER_ALIGN_TYPE( 64 ) Stripe {
+            AtomicInt64 counts[N];
+        };
+        Stripe _stripes[kStripes];
+    };
+
+}  // namespace mongo
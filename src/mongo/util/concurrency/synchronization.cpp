@@ -56,6 +56,7 @@ namespace mongo {
     void NotifyAll::waitFor(When e) {
         scoped_lock lock( _mutex );
         ++_nWaiting;
+        _waiterArrived.notify_all();
         while( _lastDone < e ) {
             _condition.wait( lock.boost() );
         }
@@ -64,12 +65,21 @@ namespace mongo {
     void NotifyAll::awaitBeyondNow() { 
         scoped_lock lock( _mutex );
         ++_nWaiting;
+        _waiterArrived.notify_all();
         When e = ++_lastReturned;
         while( _lastDone <= e ) {
             _condition.wait( lock.boost() );
         }
     }
 
+    bool NotifyAll::awaitWaiter(unsigned millis) {
+        scoped_lock lock( _mutex );
+        if( _nWaiting == 0 ) {
+            _waiterArrived.timed_wait( lock.boost(), boost::posix_time::milliseconds(millis) );
+        }
+        return _nWaiting != 0;
+    }
+
     void NotifyAll::notifyAll(When e) {
         scoped_lock lock( _mutex );
         _lastDone = e;
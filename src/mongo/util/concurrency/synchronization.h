@@ -74,9 +74,15 @@ namespace mongo {
         /** indicates how many threads are waiting for a notify. */
         unsigned nWaiting() const { return _nWaiting; }
 
+        /** blocks until some thread is waiting for a notify, or millis elapse.
+            @return true if a thread is waiting
+        */
+        bool awaitWaiter(unsigned millis);
+
     private:
         mongo::mutex _mutex;
         boost::condition _condition;
+        boost::condition _waiterArrived;
         When _lastDone;
         When _lastReturned;
         unsigned _nWaiting;
@@ -82,6 +82,7 @@ namespace mongo {
     public:
         T* get() const;
         void reset(T* v);
+        T* release();     // detach without deleting; caller takes ownership
         T* getMake() { 
             T *t = get();
             if( t == 0 )
@@ -100,6 +101,10 @@ namespace mongo {
     void TSP<T>::reset(T* v) { \
         tsp.reset(v); \
         _ ## p = v; \
+    } \
+    T* TSP<T>::release() { \
+        _ ## p = 0; \
+        return tsp.release(); \
     } 
 # else
 
@@ -114,6 +119,10 @@ namespace mongo {
         tsp.reset(v); \
         _ ## p = v; \
     } \
+    template<> T* TSP<T>::release() { \
+        _ ## p = 0; \
+        return tsp.release(); \
+    } \
     TSP<T> p;
 # endif
 
@@ -145,6 +154,12 @@ namespace mongo {
             verify( pthread_setspecific( _key, v ) == 0 ); 
         }
 
+        T* release() {
+            T* t = get();
+            verify( pthread_setspecific( _key, 0 ) == 0 );
+            return t;
+        }
+
         T* getMake() { 
             T *t = get();
             if( t == 0 ) {
@@ -167,6 +182,7 @@ namespace mongo {
     public:
         T* get() const { return tsp.get(); }
         void reset(T* v) { tsp.reset(v); }
+        T* release() { return tsp.release(); }
         T* getMake() { 
             T *t = get();
             if( t == 0 )
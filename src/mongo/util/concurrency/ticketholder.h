@@ -26,6 +26,7 @@ namespace mongo {
         TicketHolder( int num ) : _mutex("TicketHolder") {
             _outof = num;
             _num = num;
+            _waiting = 0;
         }
 
         bool tryAcquire() {
@@ -36,9 +37,14 @@ namespace mongo {
         void waitForTicket() {
             scoped_lock lk( _mutex );
 
+            if ( _tryAcquire() )
+                return;
+
+            _waiting++;
             while( ! _tryAcquire() ) {
                 _newTicket.wait( lk.boost() );
             }
+            _waiting--;
         }
 
         void release() {
@@ -67,6 +73,19 @@ namespace mongo {
             _newTicket.notify_all();
         }
 
+        /**
+         * Like resize(), but may go below the number of tickets in use; waiters then get
+         * none until enough are released to be under the new limit.
+         */
+        void setLimit( int newLimit ) {
+            {
+                scoped_lock lk( _mutex );
+                _num += newLimit - _outof;
+                _outof = newLimit;
+            }
+            _newTicket.notify_all();
+        }
+
         int available() const {
             return _num;
         }
@@ -77,13 +96,14 @@ namespace mongo {
 
         int outof() const { return _outof; }
 
+        /** threads blocked in waitForTicket() */
+        int waiting() const { return _waiting; }
+
     private:
 
         bool _tryAcquire(){
+            // _num is only negative after setLimit() took away tickets still in use
             if ( _num <= 0 ) {
-                if ( _num < 0 ) {
-                    std::cerr << "DISASTER! in TicketHolder" << std::endl;
-                }
                 return false;
             }
             _num--;
@@ -92,6 +112,7 @@ namespace mongo {
 
         int _outof;
         int _num;
+        int _waiting;
         mongo::mutex _mutex;
         boost::condition_variable_any _newTicket;
     };
@@ -0,0 +1,163 @@
+// work_stealing_pool.cpp
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "pch.h"
+
+#include "mongo/util/concurrency/work_stealing_pool.h"
+
+namespace mongo {
+
+    WorkStealingPool::WorkStealingPool(int nThreads)
+        : _mutex("WorkStealingPool"), _sleeping(0), _shutdown(false) {
+        verify(nThreads > 0);
+        for (int i = 0; i < nThreads; i++) {
+            _queues.push_back(new Queue());
+        }
+        for (int i = 0; i < nThreads; i++) {
+            _threads.create_thread(boost::bind(&WorkStealingPool::loop, this, i));
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool() {
+        join();
+        {
+            scoped_lock lk(_mutex);
+            _shutdown = true;
+            _workAvailable.notify_all();
+        }
+        _threads.join_all();
+        for (size_t i = 0; i < _queues.size(); i++) {
+            delete _queues[i];
+        }
+    }
+
+    void WorkStealingPool::join() {
+        scoped_lock lk(_mutex);
+        while (_tasksRemaining.load() != 0) {
+            _allDone.wait(lk.boost());
+        }
+    }
+
+    void WorkStealingPool::schedule(const Task& task) {
+        verify(!task.empty());
+        _tasksRemaining.fetchAndAdd(1);
+        Queue* q = _queues[_nextQueue.fetchAndAdd(1) % _queues.size()];
+        {
+            scoped_spinlock lk(q->lock);
+            q->tasks.push_back(task);
+        }
+        wake(1);
+    }
+
+    void WorkStealingPool::schedule(const std::vector<Task>& tasks) {
+        if (tasks.empty())
+            return;
+        _tasksRemaining.fetchAndAdd(tasks.size());
+        const size_t first = _nextQueue.fetchAndAdd(tasks.size());
+        for (size_t i = 0; i < _queues.size() && i < tasks.size(); i++) {
+            Queue* q = _queues[(first + i) % _queues.size()];
+            scoped_spinlock lk(q->lock);
+            for (size_t j = i; j < tasks.size(); j += _queues.size()) {
+                verify(!tasks[j].empty());
+                q->tasks.push_back(tasks[j]);
+            }
+        }
+        wake(tasks.size());
+    }
+
+    void WorkStealingPool::wake(size_t n) {
+        // A worker looks at the queues under _mutex before it sleeps, so it either sees the new
+        // tasks or is asleep by the time this gets the lock.
+        scoped_lock lk(_mutex);
+        if (_sleeping == 0)
+            return;
+        if (n == 1)
+            _workAvailable.notify_one();
+        else
+            _workAvailable.notify_all();
+    }
+
+    bool WorkStealingPool::take(size_t self, Task* task) {
+        {
+            Queue* q = _queues[self];
+            scoped_spinlock lk(q->lock);
+            if (!q->tasks.empty()) {
+                task->swap(q->tasks.front());
+                q->tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < _queues.size(); i++) {
+            Queue* q = _queues[(self + i) % _queues.size()];
+            scoped_spinlock lk(q->lock);
+            if (!q->tasks.empty()) {
+                task->swap(q->tasks.back());
+                q->tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool WorkStealingPool::anyQueued() {
+        for (size_t i = 0; i < _queues.size(); i++) {
+            scoped_spinlock lk(_queues[i]->lock);
+            if (!_queues[i]->tasks.empty())
+                return true;
+        }
+        return false;
+    }
+
+    void WorkStealingPool::taskDone() {
+        if (_tasksRemaining.subtractAndFetch(1) == 0) {
+            scoped_lock lk(_mutex);
+            _allDone.notify_all();
+        }
+    }
+
+    void WorkStealingPool::loop(size_t self) {
+        while (true) {
+            Task task;
+            if (!take(self, &task)) {
+                scoped_lock lk(_mutex);
+                while (!_shutdown && !anyQueued()) {
+                    _sleeping++;
+                    _workAvailable.wait(lk.boost());
+                    _sleeping--;
+                }
+                if (_shutdown)
+                    return;
+                continue;
+            }
+
+            try {
+                task();
+            }
+            catch (DBException& e) {
+                log() << "Unhandled DBException: " << e.toString() << endl;
+            }
+            catch (std::exception& e) {
+                log() << "Unhandled std::exception in worker thread: " << e.what() << endl;
+            }
+            catch (...) {
+                log() << "Unhandled non-exception in worker thread" << endl;
+            }
+            taskDone();
+        }
+    }
+
+} // namespace mongo
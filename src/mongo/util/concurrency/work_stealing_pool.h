@@ -0,0 +1,103 @@
+// work_stealing_pool.h
+
+/*    Copyright 2013 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/spin_lock.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+
+    /**
+     * A pool of threads like ThreadPool, for many short tasks.  Each worker has a queue of its
+     * own, which tasks are dealt out to in turn, and takes from the front of it.  A worker whose
+     * queue is empty takes from the back of another's before going to sleep, so a worker that
+     * got slow tasks doesn't hold up the rest of the batch.
+     *
+     * Workers only share a lock to go to sleep and to be woken, and schedule() only wakes one
+     * if some are asleep, so running tasks doesn't serialize on one queue's lock.  Tasks may run
+     * in any order.
+     */
+    class WorkStealingPool : boost::noncopyable {
+    public:
+        typedef threadpool::Task Task;
+
+        explicit WorkStealingPool(int nThreads = 8);
+
+        // blocks until all tasks are complete
+        ~WorkStealingPool();
+
+        // blocks until all tasks are complete.  As for ThreadPool, tasks scheduled meanwhile
+        // are waited for too.
+        void join();
+
+        void schedule(const Task& task);
+
+        /** Schedules all of 'tasks', dealing them out over the workers in one go. */
+        void schedule(const std::vector<Task>& tasks);
+
+        // Helpers that wrap schedule and boost::bind, as ThreadPool's do.
+        template<typename F, typename A>
+        void schedule(F f, A a) { schedule(Task(boost::bind(f,a))); }
+        template<typename F, typename A, typename B>
+        void schedule(F f, A a, B b) { schedule(Task(boost::bind(f,a,b))); }
+        template<typename F, typename A, typename B, typename C>
+        void schedule(F f, A a, B b, C c) { schedule(Task(boost::bind(f,a,b,c))); }
+
+        int tasks_remaining() { return _tasksRemaining.load(); }
+
+    private:
+        struct Queue {
+            SpinLock lock;
+            std::deque<Task> tasks;
+        };
+
+        void loop(size_t self);
+
+        // Takes a task off worker 'self''s queue, or steals one.  Returns false if there's none.
+        bool take(size_t self, Task* task);
+
+        bool anyQueued();
+
+        // wakes sleeping workers for 'n' new tasks
+        void wake(size_t n);
+
+        void taskDone();
+
+        std::vector<Queue*> _queues;
+        boost::thread_group _threads;
+        AtomicUInt32 _nextQueue;
+        AtomicInt32 _tasksRemaining; // queued + running
+
+        // protects the fields below and is held to sleep or wake on the conditions
+        mongo::mutex _mutex;
+        boost::condition _workAvailable;
+        boost::condition _allDone;
+        int _sleeping;
+        bool _shutdown;
+    };
+
+} // namespace mongo
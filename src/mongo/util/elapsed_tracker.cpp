@@ -20,6 +20,9 @@
 
 #include "mongo/util/elapsed_tracker.h"
 
+#include <algorithm>
+
+#include "mongo/db/lockstate.h"
 #include "mongo/util/net/listen.h"
 
 namespace mongo {
@@ -27,19 +30,35 @@ namespace mongo {
     ElapsedTracker::ElapsedTracker( int32_t hitsBetweenMarks, int32_t msBetweenMarks ) :
         _hitsBetweenMarks( hitsBetweenMarks ),
         _msBetweenMarks( msBetweenMarks ),
+        _contendedHitsBetweenMarks( std::max( 1, hitsBetweenMarks / kContendedDivisor ) ),
         _pings( 0 ),
+        _pingsAtLast( 0 ),
         _last( Listener::getElapsedTimeMillis() ) {
     }
 
     bool ElapsedTracker::intervalHasElapsed() {
-        if ( ( ++_pings % _hitsBetweenMarks ) == 0 ) {
-            _last = Listener::getElapsedTimeMillis();
+        const uint64_t sinceLast = ++_pings - _pingsAtLast;
+        const bool contended = LockState::numLockPending() > 0;
+
+        if ( contended ) {
+            if ( sinceLast >= static_cast<uint64_t>( _contendedHitsBetweenMarks ) ||
+                 Listener::getElapsedTimeMillis() - _last > _msBetweenMarks ) {
+                resetLastTime();
+                return true;
+            }
+            return false;
+        }
+
+        // nobody is waiting: stretch the intervals
+        if ( sinceLast >= static_cast<uint64_t>( _hitsBetweenMarks ) * kIdleMultiplier ) {
+            resetLastTime();
             return true;
         }
 
         long long now = Listener::getElapsedTimeMillis();
-        if ( now - _last > _msBetweenMarks ) {
+        if ( now - _last > static_cast<long long>( _msBetweenMarks ) * kIdleMultiplier ) {
             _last = now;
+            _pingsAtLast = _pings;
             return true;
         }
 
@@ -48,6 +67,7 @@ namespace mongo {
 
     void ElapsedTracker::resetLastTime() {
         _last = Listener::getElapsedTimeMillis();
+        _pingsAtLast = _pings;
     }
 
 } // namespace mongo
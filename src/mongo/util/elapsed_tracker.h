@@ -22,9 +22,20 @@
 
 namespace mongo {
 
-    /** Keep track of elapsed time. After a set amount of time, tells you to do something. */
+    /**
+     * Keep track of elapsed time. After a set amount of time, tells you to do something.
+     *
+     * Meant for deciding when a scan should yield its lock, so the triggers follow lock
+     * contention: while some thread is waiting for a lock, one goes off after a few hits
+     * (hitsBetweenMarks / kContendedDivisor); with nobody waiting, the usual ones only go off
+     * every kIdleMultiplier intervals, so long scans on an idle node still check in now and
+     * then (for killOp) without giving up their locks for nothing.
+     */
     class ElapsedTracker {
     public:
+        static const int32_t kContendedDivisor = 8;
+        static const int32_t kIdleMultiplier = 10;
+
         ElapsedTracker( int32_t hitsBetweenMarks, int32_t msBetweenMarks );
 
         /**
@@ -38,8 +49,10 @@ namespace mongo {
     private:
         const int32_t _hitsBetweenMarks;
         const int32_t _msBetweenMarks;
+        const int32_t _contendedHitsBetweenMarks;
 
         uint64_t _pings;
+        uint64_t _pingsAtLast;
 
         int64_t _last;
     };
@@ -83,8 +83,20 @@ namespace mongo {
     }
 
 
+    // Files are allocated on this many threads, so that a database which needs a file right
+    // away doesn't wait on a big preallocation for another one.
+    static const int kNumAllocatorThreads = 2;
+
     void FileAllocator::start() {
-        boost::thread t( boost::bind( &FileAllocator::run , this ) );
+        {
+            // initialize unique temporary file name counter
+            // TODO: SERVER-6055 -- Unify temporary file name selection
+            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
+            _uniqueNumber = curTimeMicros64();
+        }
+        for ( int i = 0; i < kNumAllocatorThreads; i++ ) {
+            boost::thread t( boost::bind( &FileAllocator::run , this ) );
+        }
     }
 
     void FileAllocator::requestAllocation( const string &name, long &size ) {
@@ -111,14 +123,9 @@ namespace mongo {
         }
         checkFailure();
         _pendingSize[ name ] = size;
-        if ( _pending.size() == 0 )
-            _pending.push_back( name );
-        else if ( _pending.front() != name ) {
-            _pending.remove( name );
-            list< string >::iterator i = _pending.begin();
-            ++i;
-            _pending.insert( i, name );
-        }
+        // the next free worker takes the front; one already working on name carries on
+        _pending.remove( name );
+        _pending.push_front( name );
         _pendingUpdated.notify_all();
         while( inProgress( name ) ) {
             checkFailure();
@@ -156,6 +163,29 @@ namespace mongo {
 #endif
     }
 
+#if !defined(_WIN32)
+    // Below this much per thread, zeroing a file isn't worth splitting up.
+    static const long kZeroingChunk = 64 * 1024 * 1024;
+    static const int kMaxZeroingThreads = 4;
+
+    /** Writes zeroes over [begin, end) of fd.  Sets *err to the errno of any failure. */
+    static void zeroRange( int fd, long begin, long end, int* err ) {
+        const long z = 256 * 1024;
+        const boost::scoped_array<char> buf_holder (new char[z]);
+        char* buf = buf_holder.get();
+        memset(buf, 0, z);
+        for ( long ofs = begin; ofs < end; ) {
+            const long towrite = std::min( z, end - ofs );
+            const ssize_t written = pwrite( fd, buf, towrite, ofs );
+            if ( written <= 0 ) {
+                *err = written < 0 ? errno : ENOSPC;
+                return;
+            }
+            ofs += written;
+        }
+    }
+#endif
+
     void FileAllocator::ensureLength(int fd , long size) {
 #if !defined(_WIN32)
         if (useSparseFiles(fd)) {
@@ -167,11 +197,12 @@ namespace mongo {
 #endif
 
 #if defined(__linux__)
-        int ret = posix_fallocate(fd,0,size);
-        if ( ret == 0 )
+        // Unlike posix_fallocate(), this fails rather than falling back to writing a byte per
+        // block where the filesystem can't reserve blocks.  Our own fallback below is faster.
+        if ( fallocate(fd, 0, 0, size) == 0 )
             return;
 
-        log() << "FileAllocator: posix_fallocate failed: " << errnoWithDescription( ret ) << " falling back" << endl;
+        log() << "FileAllocator: fallocate failed: " << errnoWithDescription() << " falling back" << endl;
 #endif
 
         off_t filelen = lseek( fd, 0, SEEK_END );
@@ -189,6 +220,7 @@ namespace mongo {
                      1 == write(fd, "", 1) );
             lseek(fd, 0, SEEK_SET);
 
+#if defined(_WIN32)
             const long z = 256 * 1024;
             const boost::scoped_array<char> buf_holder (new char[z]);
             char* buf = buf_holder.get();
@@ -203,6 +235,28 @@ namespace mongo {
                 uassert( 10443 , errnoWithPrefix("FileAllocator: file write failed" ), written > 0 );
                 left -= written;
             }
+#else
+            // one thread per kZeroingChunk, up to kMaxZeroingThreads, each with its own range
+            int nThreads = static_cast<int>( ( size + kZeroingChunk - 1 ) / kZeroingChunk );
+            if ( nThreads > kMaxZeroingThreads )
+                nThreads = kMaxZeroingThreads;
+            const long perThread = ( size / nThreads + 4095 ) & ~4095L;
+
+            vector<int> errors( nThreads, 0 );
+            boost::thread_group threads;
+            for ( int i = 0; i < nThreads; i++ ) {
+                const long begin = std::min( size, i * perThread );
+                const long end = std::min( size, begin + perThread );
+                threads.create_thread( boost::bind( &zeroRange, fd, begin, end, &errors[i] ) );
+            }
+            threads.join_all();
+
+            for ( int i = 0; i < nThreads; i++ ) {
+                uassert( 10443, str::stream() << "FileAllocator: file write failed: "
+                                              << errnoWithDescription( errors[i] ),
+                         errors[i] == 0 );
+            }
+#endif
         }
     }
 
@@ -233,6 +287,14 @@ namespace mongo {
         return false;
     }
 
+    // caller must hold _pendingMutex lock.
+    string FileAllocator::nextUnclaimed() const {
+        for( list< string >::const_iterator i = _pending.begin(); i != _pending.end(); ++i )
+            if ( _claimed.count( *i ) == 0 )
+                return *i;
+        return "";
+    }
+
     string FileAllocator::makeTempFileName( boost::filesystem::path root ) {
         while( 1 ) {
             boost::filesystem::path p = root / "_tmp";
@@ -256,108 +318,99 @@ namespace mongo {
 
     void FileAllocator::run( FileAllocator * fa ) {
         setThreadName( "FileAllocator" );
-        {
-            // initialize unique temporary file name counter
-            // TODO: SERVER-6055 -- Unify temporary file name selection
-            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
-            _uniqueNumber = curTimeMicros64();
-        }
         while( 1 ) {
+            string name;
+            long size;
             {
                 scoped_lock lk( fa->_pendingMutex );
-                if ( fa->_pending.size() == 0 )
+                while ( ( name = fa->nextUnclaimed() ).empty() )
                     fa->_pendingUpdated.wait( lk.boost() );
+                size = fa->_pendingSize[ name ];
+                fa->_claimed.insert( name );
             }
-            while( 1 ) {
-                string name;
-                long size;
-                {
-                    scoped_lock lk( fa->_pendingMutex );
-                    if ( fa->_pending.size() == 0 )
-                        break;
-                    name = fa->_pending.front();
-                    size = fa->_pendingSize[ name ];
-                }
 
-                string tmp;
-                long fd = 0;
-                try {
-                    log() << "allocating new datafile " << name << ", filling with zeroes..." << endl;
-                    
-                    boost::filesystem::path parent = ensureParentDirCreated(name);
-                    tmp = fa->makeTempFileName( parent );
-                    ensureParentDirCreated(tmp);
+            string tmp;
+            long fd = 0;
+            try {
+                log() << "allocating new datafile " << name << ", filling with zeroes..." << endl;
+                
+                boost::filesystem::path parent = ensureParentDirCreated(name);
+                tmp = fa->makeTempFileName( parent );
+                ensureParentDirCreated(tmp);
 
 #if defined(_WIN32)
-                    fd = _open( tmp.c_str(), _O_RDWR | _O_CREAT | O_NOATIME, _S_IREAD | _S_IWRITE );
+                fd = _open( tmp.c_str(), _O_RDWR | _O_CREAT | O_NOATIME, _S_IREAD | _S_IWRITE );
 #else
-                    fd = open(tmp.c_str(), O_CREAT | O_RDWR | O_NOATIME, S_IRUSR | S_IWUSR);
+                fd = open(tmp.c_str(), O_CREAT | O_RDWR | O_NOATIME, S_IRUSR | S_IWUSR);
 #endif
-                    if ( fd < 0 ) {
-                        log() << "FileAllocator: couldn't create " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
-                        uasserted(10439, "");
-                    }
+                if ( fd < 0 ) {
+                    log() << "FileAllocator: couldn't create " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
+                    uasserted(10439, "");
+                }
 
 #if defined(POSIX_FADV_DONTNEED)
-                    if( posix_fadvise(fd, 0, size, POSIX_FADV_DONTNEED) ) {
-                        log() << "warning: posix_fadvise fails " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
-                    }
+                if( posix_fadvise(fd, 0, size, POSIX_FADV_DONTNEED) ) {
+                    log() << "warning: posix_fadvise fails " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
+                }
 #endif
 
-                    Timer t;
+                Timer t;
 
-                    /* make sure the file is the full desired length */
-                    ensureLength( fd , size );
+                /* make sure the file is the full desired length */
+                ensureLength( fd , size );
+
+                close( fd );
+                fd = 0;
+
+                if( rename(tmp.c_str(), name.c_str()) ) {
+                    const string& errStr = errnoWithDescription();
+                    const string& errMessage = str::stream()
+                            << "error: couldn't rename " << tmp
+                            << " to " << name << ' ' << errStr;
+                    msgasserted(13653, errMessage);
+                }
+                flushMyDirectory(name);
 
+                log() << "done allocating datafile " << name << ", "
+                      << "size: " << size/1024/1024 << "MB, "
+                      << " took " << ((double)t.millis())/1000.0 << " secs"
+                      << endl;
+
+                // no longer in a failed state. allow new writers.
+                fa->_failed = false;
+            }
+            catch ( const std::exception& e ) {
+                log() << "error: failed to allocate new file: " << name
+                      << " size: " << size << ' ' << e.what()
+                      << ".  will try again in 10 seconds" << endl;
+                if ( fd > 0 )
                     close( fd );
-                    fd = 0;
-
-                    if( rename(tmp.c_str(), name.c_str()) ) {
-                        const string& errStr = errnoWithDescription();
-                        const string& errMessage = str::stream()
-                                << "error: couldn't rename " << tmp
-                                << " to " << name << ' ' << errStr;
-                        msgasserted(13653, errMessage);
-                    }
-                    flushMyDirectory(name);
-
-                    log() << "done allocating datafile " << name << ", "
-                          << "size: " << size/1024/1024 << "MB, "
-                          << " took " << ((double)t.millis())/1000.0 << " secs"
-                          << endl;
-
-                    // no longer in a failed state. allow new writers.
-                    fa->_failed = false;
+                try {
+                    if ( ! tmp.empty() )
+                        boost::filesystem::remove( tmp );
+                    boost::filesystem::remove( name );
+                } catch ( const std::exception& e ) {
+                    log() << "error removing files: " << e.what() << endl;
                 }
-                catch ( const std::exception& e ) {
-                    log() << "error: failed to allocate new file: " << name
-                          << " size: " << size << ' ' << e.what()
-                          << ".  will try again in 10 seconds" << endl;
-                    if ( fd > 0 )
-                        close( fd );
-                    try {
-                        if ( ! tmp.empty() )
-                            boost::filesystem::remove( tmp );
-                        boost::filesystem::remove( name );
-                    } catch ( const std::exception& e ) {
-                        log() << "error removing files: " << e.what() << endl;
-                    }
+                {
                     scoped_lock lk( fa->_pendingMutex );
                     fa->_failed = true;
                     // not erasing from pending
                     fa->_pendingUpdated.notify_all();
-                    
-                    
-                    sleepsecs(10);
-                    continue;
                 }
 
-                {
-                    scoped_lock lk( fa->_pendingMutex );
-                    fa->_pendingSize.erase( name );
-                    fa->_pending.pop_front();
-                    fa->_pendingUpdated.notify_all();
-                }
+                sleepsecs(10);
+                scoped_lock lk( fa->_pendingMutex );
+                fa->_claimed.erase( name );
+                continue;
+            }
+
+            {
+                scoped_lock lk( fa->_pendingMutex );
+                fa->_pendingSize.erase( name );
+                fa->_pending.remove( name );
+                fa->_claimed.erase( name );
+                fa->_pendingUpdated.notify_all();
             }
         }
     }
@@ -18,6 +18,7 @@
 #include "mongo/pch.h"
 
 #include <list>
+#include <set>
 #include <boost/filesystem/path.hpp>
 #include <boost/thread/condition.hpp>
 
@@ -56,6 +57,11 @@ namespace mongo {
         
         bool hasFailed() const;
 
+        /**
+         * Makes the new, empty file 'fd' 'size' bytes long and reading as zeroes: with
+         * fallocate where the filesystem supports it, else by writing zeroes from several
+         * threads at once.
+         */
         static void ensureLength(int fd, long size);
 
         /** @return the singleton */
@@ -74,7 +80,11 @@ namespace mongo {
         // caller must hold pendingMutex_ lock.
         bool inProgress( const string &name ) const;
 
-        /** called from the worked thread */
+        // caller must hold pendingMutex_ lock.  Returns the first pending name no other
+        // worker is allocating, or the empty string if there is none.
+        string nextUnclaimed() const;
+
+        /** called from each of the worker threads */
         static void run( FileAllocator * fa );
 
         // generate a unique name for temporary files
@@ -86,6 +96,9 @@ namespace mongo {
         std::list< string > _pending;
         mutable map< string, long > _pendingSize;
 
+        // the pending names a worker has taken up
+        std::set< string > _claimed;
+
         // unique number for temporary files
         static unsigned long long _uniqueNumber;
 
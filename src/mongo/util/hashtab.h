@@ -150,6 +150,27 @@ namespace mongo {
             return true;
         }
 
+        /**
+         * put() for a key the caller knows isn't there: takes the first free bucket on its
+         * chain without looking further for the key.
+         * @return the value stored, or 0 if too full
+         */
+        Type* putNew(const Key& k, const Type& value) {
+            const int h = k.hash();
+            int i = h % n;
+            for ( int chain = 0; chain < maxChain; chain++ ) {
+                if ( !nodes(i).inUse() ) {
+                    Node* node = getDur().writing( &nodes(i) );
+                    node->k = k;
+                    node->hash = h;
+                    node->value = value;
+                    return &nodes(i).value;
+                }
+                i = (i+1) % n;
+            }
+            return 0;
+        }
+
         typedef void (*IteratorCallback)( const Key& k , Type& v );
         void iterAll( IteratorCallback callback ) {
             for ( int i=0; i<n; i++ ) {
@@ -18,7 +18,6 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <boost/noncopyable.hpp>
-#include "mongo/platform/atomic_word.h"
 #include "mongo/base/string_data.h"
 
 namespace mongo {
@@ -68,31 +67,39 @@ namespace mongo {
         mutable unsigned counter;
     };
 
-    /// This is an alternative base class to the above ones (will replace them eventually)
+    /**
+     * This is an alternative base class to the above ones (will replace them eventually)
+     *
+     * Like IntrusiveCounterUnsigned the count is not atomic: everything reachable from an object
+     * must be used by one thread at a time.  The aggregation framework, the only user, keeps
+     * Documents and Values inside a pipeline, and a pipeline only changes threads between
+     * getMores, handed over under the ClientCursor pin, or when a parallel scan starts and joins
+     * the worker it belongs to.  Objects that will be used by several
+     * threads at once need their own synchronization.
+     */
     class RefCountable : boost::noncopyable {
     public:
         /// If false you have exclusive access to this object. This is useful for implementing COW.
         bool isShared() const {
-            // TODO: switch to unfenced read method after SERVER-6973
-            return reinterpret_cast<unsigned&>(_count) > 1;
+            return _count > 1;
         }
 
         friend void intrusive_ptr_add_ref(const RefCountable* ptr) {
-            ptr->_count.addAndFetch(1);
+            ++ptr->_count;
         };
 
         friend void intrusive_ptr_release(const RefCountable* ptr) {
-            if (ptr->_count.subtractAndFetch(1) == 0) {
+            if (--ptr->_count == 0) {
                 delete ptr; // uses subclass destructor and operator delete
             }
         };
 
     protected:
-        RefCountable() {}
+        RefCountable() : _count(0) {}
         virtual ~RefCountable() {}
 
     private:
-        mutable AtomicUInt32 _count; // default initialized to 0
+        mutable unsigned _count;
     };
 
     /// This is an immutable reference-counted string
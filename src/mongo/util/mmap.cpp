@@ -20,9 +20,11 @@
 #include "mongo/util/mmap.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mongo/db/cmdline.h"
 #include "mongo/util/concurrency/rwlock.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/map_util.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/processinfo.h"
@@ -144,14 +146,24 @@ namespace {
     void (*MongoFile::notifyPreFlush)() = nullFunc;
     void (*MongoFile::notifyPostFlush)() = nullFunc;
 
-    /*static*/ int MongoFile::flushAll( bool sync ) {
+    /*static*/ int MongoFile::flushAll( bool sync, int maxThreads ) {
         notifyPreFlush();
-        int x = _flushAll(sync);
+        int x = _flushAll(sync, maxThreads);
         notifyPostFlush();
         return x;
     }
 
-    /*static*/ int MongoFile::_flushAll( bool sync ) {
+    namespace {
+        typedef vector< boost::shared_ptr<MongoFile::Flushable> > FlushGroup;
+
+        void flushGroup( const FlushGroup* group ) {
+            for ( FlushGroup::const_iterator i = group->begin(); i != group->end(); ++i ) {
+                (*i)->flush();
+            }
+        }
+    }  // namespace
+
+    /*static*/ int MongoFile::_flushAll( bool sync, int maxThreads ) {
         if ( ! sync ) {
             int num = 0;
             LockMongoFilesShared lk;
@@ -166,27 +178,75 @@ namespace {
             return num;
         }
 
-        // want to do it sync
-        set<MongoFile*> seen;
-        while ( true ) {
-            auto_ptr<Flushable> f;
+        // want to do it sync, outside the lock
+        map<string, FlushGroup> byDirectory;
+        int num = 0;
+        {
             LockMongoFilesShared lk;
             for ( set<MongoFile*>::iterator i = mmfiles.begin(); i != mmfiles.end(); i++ ) {
                 MongoFile * mmf = *i;
                 if ( ! mmf )
                     continue;
-                if ( seen.count( mmf ) )
-                    continue;
-                f.reset( mmf->prepareFlush() );
-                seen.insert( mmf );
-                break;
+                const string dir = boost::filesystem::path( mmf->filename() ).branch_path().string();
+                byDirectory[dir].push_back( boost::shared_ptr<Flushable>( mmf->prepareFlush() ) );
+                num++;
             }
-            if ( ! f.get() )
-                break;
+        }
+
+        const int nThreads = std::min( maxThreads, (int) byDirectory.size() );
+        if ( nThreads <= 1 ) {
+            for ( map<string, FlushGroup>::const_iterator i = byDirectory.begin();
+                  i != byDirectory.end(); ++i ) {
+                flushGroup( &i->second );
+            }
+            return num;
+        }
 
-            f->flush();
+        ThreadPool pool( nThreads );
+        for ( map<string, FlushGroup>::const_iterator i = byDirectory.begin();
+              i != byDirectory.end(); ++i ) {
+            pool.schedule( flushGroup, &i->second );
         }
-        return seen.size();
+        pool.join();
+        return num;
+    }
+
+    namespace {
+        // where the next writeback() starts
+        string writebackFile;
+        unsigned long long writebackOfs = 0;
+    }  // namespace
+
+    /*static*/ unsigned long long MongoFile::writeback( unsigned long long maxBytes ) {
+        LockMongoFilesShared lk;
+        map<string,MongoFile*>::const_iterator i = pathToFile.lower_bound( writebackFile );
+        if ( i == pathToFile.end() || i->first != writebackFile ) {
+            // closed since
+            writebackOfs = 0;
+        }
+
+        unsigned long long covered = 0;
+        for ( size_t files = 0; covered < maxBytes && files <= pathToFile.size(); files++ ) {
+            if ( i == pathToFile.end() ) {
+                i = pathToFile.begin();
+                if ( i == pathToFile.end() )
+                    break;
+            }
+            const unsigned long long len = i->second->length();
+            if ( writebackOfs < len ) {
+                const unsigned long long n = std::min( maxBytes - covered, len - writebackOfs );
+                i->second->startWriteback( writebackOfs, n );
+                writebackOfs += n;
+                covered += n;
+                if ( writebackOfs < len )
+                    break;
+            }
+            ++i;
+            writebackOfs = 0;
+        }
+
+        writebackFile = i == pathToFile.end() ? string() : i->first;
+        return covered;
     }
 
     void MongoFile::created() {
@@ -31,6 +31,10 @@ namespace mongo {
         enum Advice { Sequential=1 , Random=2 };
         MAdvise(void *p, unsigned len, Advice a); 
         ~MAdvise(); // destructor resets the range to MADV_NORMAL
+
+        /** hint that [p,p+len) will be read soon so the OS can start paging it in.  doesn't
+            block or fault; a noop where unsupported. */
+        static void willNeed(const void *p, unsigned len);
     };
 
     // lock order: lock dbMutex before this if you lock both
@@ -76,7 +80,9 @@ namespace mongo {
 
         enum Options {
             SEQUENTIAL = 1, // hint - e.g. FILE_FLAG_SEQUENTIAL_SCAN on windows
-            READONLY = 2    // not contractually guaranteed, but if specified the impl has option to fault writes
+            READONLY = 2,   // not contractually guaranteed, but if specified the impl has option to fault writes
+            NUMA_INTERLEAVE = 4, // hint - spread the memory of the views over all NUMA nodes.  linux only
+            HUGEPAGES = 8   // hint - madvise the views for transparent huge pages.  linux only
         };
 
         /** @param fun is called for each MongoFile.
@@ -93,7 +99,21 @@ namespace mongo {
         static void (*notifyPreFlush)();
         static void (*notifyPostFlush)();
 
-        static int flushAll( bool sync ); // returns n flushed
+        /**
+         * @param maxThreads with sync, the directories the files are in are flushed in
+         *     parallel on up to this many threads; the files in one directory, which likely
+         *     share a device, one after the other
+         * @return n flushed
+         */
+        static int flushAll( bool sync, int maxThreads = 1 );
+        /**
+         * Starts writing back up to 'maxBytes' of the files' ranges, carrying on from where the
+         * last call stopped and going round all the files, without waiting for the writes.
+         * Only dirty pages cost I/O.  Call from one thread only.
+         * @return bytes of file covered
+         */
+        static unsigned long long writeback( unsigned long long maxBytes );
+
         static long long totalMappedLength();
         static void closeAllFiles( stringstream &message );
 
@@ -104,7 +124,7 @@ namespace mongo {
 
     private:
         string _filename;
-        static int _flushAll( bool sync ); // returns n flushed
+        static int _flushAll( bool sync, int maxThreads ); // returns n flushed
     protected:
         virtual void close() = 0;
         virtual void flush(bool sync) = 0;
@@ -114,6 +134,9 @@ namespace mongo {
          */
         virtual Flushable * prepareFlush() = 0;
 
+        /** starts writing back [ofs, ofs+len) of the file, if the platform can */
+        virtual void startWriteback( unsigned long long ofs, unsigned long long len ) { }
+
         void created(); /* subclass must call after create */
 
         /* subclass must call in destructor (or at close).
@@ -181,6 +204,9 @@ namespace mongo {
 
         void flush(bool sync);
         virtual Flushable * prepareFlush();
+#if !defined(_WIN32)
+        virtual void startWriteback( unsigned long long ofs, unsigned long long len );
+#endif
 
         long shortLength() const          { return (long) len; }
         unsigned long long length() const { return len; }
@@ -215,12 +241,22 @@ namespace mongo {
         static const unsigned NChunks = 1024 * 1024;
 #else
         void clearWritableBits(void *privateView) { }
+
+        // the NUMA_INTERLEAVE and HUGEPAGES bits we were mapped with, for the private views too
+        int _placement;
 #endif
 
     protected:
 
         /** close the current private view and open a new replacement */
         void* remapPrivateView(void *oldPrivateAddr);
+
+#if !defined(_WIN32)
+        /** replace bytes [ofs, ofs+length) of the private view, in place, with fresh pages from the
+            file. ofs must be page aligned. there is no atomic way to do this on windows
+        */
+        void remapPrivateViewRange(void *privateView, unsigned long long ofs, unsigned long long length);
+#endif
     };
 
     /** p is called from within a mutex that MongoFile uses.  so be careful not to deadlock. */
@@ -24,6 +24,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
 #include "../util/processinfo.h"
 #include "mongoutils/str.h"
 using namespace mongoutils;
@@ -40,6 +43,7 @@ namespace mongo {
         fd = 0;
         maphandle = 0;
         len = 0;
+        _placement = 0;
         created();
     }
 
@@ -67,6 +71,7 @@ namespace mongo {
 #if defined(__sunos__)
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
+    void MAdvise::willNeed(const void *, unsigned) { }
 #else
     MAdvise::MAdvise(void *p, unsigned len, Advice a) {
         
@@ -89,8 +94,38 @@ namespace mongo {
     MAdvise::~MAdvise() { 
         madvise(_p,_len,MADV_NORMAL);
     }
+    void MAdvise::willNeed(const void *p, unsigned len) {
+        void *start = (void*)((long)p & ~(g_minOSPageSizeBytes-1));
+        len += (unsigned long long)p - (unsigned long long)start;
+        // failure is harmless, we just take the fault later
+        madvise(start, len, MADV_WILLNEED);
+    }
+#endif
+
+#if defined(__linux__) && !defined(MPOL_INTERLEAVE)
+#define MPOL_INTERLEAVE 3 // from <numaif.h>, which needs libnuma installed
 #endif
 
+    /** apply the NUMA_INTERLEAVE and HUGEPAGES options to a view.  failure is harmless */
+    static void applyPlacement(void *view, unsigned long long length, int options, const string& filename) {
+#if defined(__linux__)
+        if ( options & MongoFile::NUMA_INTERLEAVE ) {
+            // all nodes; the kernel narrows this to the ones we may use
+            unsigned long nodemask = ~0UL;
+            if ( syscall( SYS_mbind, view, length, MPOL_INTERLEAVE, &nodemask, sizeof(nodemask) * 8, 0 ) ) {
+                warning() << "map: mbind(MPOL_INTERLEAVE) failed for " << filename << ' ' << errnoWithDescription() << endl;
+            }
+        }
+#if defined(MADV_HUGEPAGE)
+        if ( options & MongoFile::HUGEPAGES ) {
+            if ( madvise( view , length , MADV_HUGEPAGE ) ) {
+                warning() << "map: madvise(MADV_HUGEPAGE) failed for " << filename << ' ' << errnoWithDescription() << endl;
+            }
+        }
+#endif
+#endif
+    }
+
     void* MemoryMappedFile::map(const char *filename, unsigned long long &length, int options) {
         // length may be updated by callee.
         setFilename(filename);
@@ -133,6 +168,9 @@ namespace mongo {
         }
 #endif
 
+        _placement = options & ( NUMA_INTERLEAVE | HUGEPAGES );
+        applyPlacement( view, length, _placement, filename );
+
         views.push_back( view );
 
         return view;
@@ -169,6 +207,8 @@ namespace mongo {
             return 0;
         }
 
+        applyPlacement( x, len, _placement, filename() );
+
         views.push_back(x);
         return x;
     }
@@ -189,9 +229,28 @@ namespace mongo {
             abort();
         }
         verify( x == oldPrivateAddr );
+        // the new mapping starts out with the default policy and advice
+        applyPlacement( x, len, _placement, filename() );
         return x;
     }
 
+    void MemoryMappedFile::remapPrivateViewRange(void *privateView, unsigned long long ofs, unsigned long long length) {
+        dassert( ofs % g_minOSPageSizeBytes == 0 );
+        dassert( ofs + length <= len );
+        void *start = static_cast<char*>(privateView) + ofs;
+        void * x = mmap( start, length , PROT_READ|PROT_WRITE , MAP_PRIVATE|MAP_NORESERVE|MAP_FIXED , fd , ofs );
+        if( x == MAP_FAILED ) {
+            int err = errno;
+            error()  << "16993 Couldn't remap private view range ofs:" << ofs << " len:" << length
+                     << ' ' << errnoWithDescription(err) << endl;
+            log() << "aborting" << endl;
+            printMemInfo();
+            abort();
+        }
+        verify( x == start );
+        applyPlacement( x, length, _placement, filename() );
+    }
+
     void MemoryMappedFile::flush(bool sync) {
         if ( views.empty() || fd == 0 )
             return;
@@ -199,6 +258,19 @@ namespace mongo {
             problem() << "msync " << errnoWithDescription() << endl;
     }
 
+    void MemoryMappedFile::startWriteback( unsigned long long ofs, unsigned long long length ) {
+        if ( views.empty() || fd == 0 )
+            return;
+#if defined(__linux__)
+        // queues the dirty pages for writing and returns, blocking only if the device queue is full
+        if ( sync_file_range( fd, ofs, length, SYNC_FILE_RANGE_WRITE ) )
+            problem() << "sync_file_range " << errnoWithDescription() << endl;
+#else
+        if ( msync( static_cast<char*>( viewForFlushing() ) + ofs, length, MS_ASYNC ) )
+            problem() << "msync " << errnoWithDescription() << endl;
+#endif
+    }
+
     class PosixFlushable : public MemoryMappedFile::Flushable {
     public:
         PosixFlushable( void * view , HANDLE fd , long len )
@@ -124,18 +124,24 @@ namespace mongo {
     }
 
     MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : psock( new Socket( fd , remote ) ) , piggyBackData(0) {
-        ports.insert(this);
+        : psock( new Socket( fd , remote ) ) {
+        _init();
     }
 
     MessagingPort::MessagingPort( double timeout, logger::LogSeverity ll ) 
         : psock( new Socket( timeout, ll ) ) {
-        ports.insert(this);
-        piggyBackData = 0;
+        _init();
     }
 
     MessagingPort::MessagingPort( boost::shared_ptr<Socket> sock )
-        : psock( sock ), piggyBackData( 0 ) {
+        : psock( sock ) {
+        _init();
+    }
+
+    void MessagingPort::_init() {
+        piggyBackData = 0;
+        _readAheadStart = 0;
+        _readAheadEnd = 0;
         ports.insert(this);
     }
 
@@ -161,8 +167,7 @@ again:
             int len = -1;
 
             char *lenbuf = (char *) &len;
-            int lft = 4;
-            psock->recv( lenbuf, lft );
+            _recvBuffered( lenbuf, 4 );
 
             if ( len < 16 || len > MaxMessageSizeBytes ) { // messages must be large enough for headers
                 if ( len == -1 ) {
@@ -197,7 +202,7 @@ again:
             char *p = (char *) &md->id;
             int left = len -4;
 
-            psock->recv( p, left );
+            _recvBuffered( p, left );
 
             guard.Dismiss();
             m.setData(md, true);
@@ -214,6 +219,35 @@ again:
         }
     }
 
+    void MessagingPort::_recvBuffered( char* buf, int len ) {
+        const int buffered = _readAheadEnd - _readAheadStart;
+        if ( buffered > 0 ) {
+            const int n = std::min( buffered, len );
+            memcpy( buf, _readAhead.get() + _readAheadStart, n );
+            _readAheadStart += n;
+            buf += n;
+            len -= n;
+        }
+
+        if ( len == 0 )
+            return;
+
+        // a big message body is better read straight into place
+        if ( len >= ReadAheadBytes ) {
+            psock->recv( buf, len );
+            return;
+        }
+
+        if ( ! _readAhead )
+            _readAhead.reset( new char[ReadAheadBytes] );
+
+        _readAheadStart = 0;
+        _readAheadEnd = 0;
+        _readAheadEnd = psock->recvAtLeast( _readAhead.get(), len, ReadAheadBytes );
+        memcpy( buf, _readAhead.get(), len );
+        _readAheadStart = len;
+    }
+
     void MessagingPort::reply(Message& received, Message& response) {
         say(/*received.from, */response, received.header()->id);
     }
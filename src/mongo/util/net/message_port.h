@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <boost/scoped_array.hpp>
+
 #include "mongo/util/net/message.h"
 #include "mongo/util/net/sock.h"
 
@@ -100,6 +102,12 @@ namespace mongo {
          */
         bool recv( const Message& sent , Message& response );
 
+        /**
+         * @return true if bytes of the next message have already been read off the socket,
+         *     so waiting for the socket to become readable before the next recv could hang
+         */
+        bool hasBufferedInput() const { return _readAheadStart < _readAheadEnd; }
+
         void piggyBack( Message& toSend , int responseTo = -1 );
 
         unsigned remotePort() const { return psock->remotePort(); }
@@ -138,8 +146,20 @@ namespace mongo {
         }
 
     private:
-        
+        // small messages are read along with whatever follows them, into a buffer this big,
+        // allocated on the first recv
+        static const int ReadAheadBytes = 4096;
+
+        void _init();
+
+        /** fills 'buf' from the read ahead buffer, refilling it from the socket as needed */
+        void _recvBuffered( char* buf, int len );
+
         PiggyBackData * piggyBackData;
+
+        boost::scoped_array<char> _readAhead;
+        int _readAheadStart;
+        int _readAheadEnd;
         
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
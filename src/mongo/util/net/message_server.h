@@ -47,6 +47,33 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * Per connection state a handler keeps in thread locals (set up in connected()), once
+         * detached from the thread so that a different thread can service the connection.
+         * Deleting a detached state must free everything it holds.
+         */
+        class ConnectionState {
+        public:
+            virtual ~ConnectionState() {}
+        };
+
+        /**
+         * pooled service support.  a handler that can move its per connection state between
+         * threads returns true from supportsPooledService() and implements detachConnection()
+         * and attachConnection(); otherwise each connection gets a dedicated thread.
+         *
+         * detaches the current connection's state from this thread; the caller owns the result
+         */
+        virtual ConnectionState* detachConnection( AbstractMessagingPort* p ) { return NULL; }
+
+        /**
+         * reinstalls state returned by detachConnection() on the current thread, taking
+         * ownership of it back
+         */
+        virtual void attachConnection( AbstractMessagingPort* p , ConnectionState* state ) { }
+
+        virtual bool supportsPooledService() const { return false; }
     };
 
     class MessageServer {
@@ -54,8 +81,10 @@ namespace mongo {
         struct Options {
             int port;                   // port to bind to
             string ipList;             // addresses to bind to
+            int workerThreads;          // >0 services connections from a pool of this many
+                                        // threads, when the platform and handler allow
 
-            Options() : port(0), ipList("") {}
+            Options() : port(0), ipList(""), workerThreads(0) {}
         };
 
         virtual ~MessageServer() {}
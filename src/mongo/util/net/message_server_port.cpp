@@ -24,21 +24,30 @@
 
 #include "mongo/db/cmdline.h"
 #include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/stats/counters.h"
-#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/net/message_port.h"
 #include "mongo/util/net/message_server.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/processinfo.h"
 
 #ifdef __linux__  // TODO: consider making this ifndef _WIN32
+# include <sys/epoll.h>
 # include <sys/resource.h>
 #endif
 
 namespace mongo {
 
+    // Off by default: with it on, each connection's thread is bound to the CPUs of one NUMA
+    // node, round robin by connection id, so the memory it allocates and first touches is
+    // local to the node it runs on.
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(numaBindConnections, bool, false);
+
     class PortMessageServer : public MessageServer , public Listener {
     public:
         /**
@@ -132,9 +141,11 @@ namespace mongo {
 
         virtual bool useUnixSockets() const { return true; }
 
-    private:
+    protected:
         MessageHandler* _handler;
 
+    private:
+
         /**
          * Simple holder for threadRun parameters. Should not destroy the objects it holds -
          * it is the responsibility of the caller to take care of them.
@@ -174,6 +185,11 @@ namespace mongo {
                 setThreadName( threadName.c_str() );
             }
 
+            if ( numaBindConnections && ProcessInfo::getNumNumaNodes() > 1 ) {
+                ProcessInfo::bindCurrentThreadToNumaNode(
+                    static_cast<int>( inPort->connectionId() % ProcessInfo::getNumNumaNodes() ) );
+            }
+
             verify( inPort );
             inPort->psock->setLogLevel(logger::LogSeverity::Debug(1));
             scoped_ptr<MessagingPort> p( inPort );
@@ -245,7 +261,215 @@ namespace mongo {
     };
 
 
+#ifdef __linux__
+    /**
+     * A PortMessageServer that services connections from a fixed pool of worker threads
+     * instead of a thread per connection.  Idle connections are parked in an epoll set; when
+     * one becomes readable a worker attaches the connection's state to itself (see
+     * MessageHandler::detachConnection), reads and processes a single message, detaches the
+     * state again and re-arms the connection.
+     *
+     * A long running operation occupies its worker for its duration, so the pool should be
+     * sized for the expected number of concurrently executing operations, not connections.
+     */
+    class PooledPortMessageServer : public PortMessageServer {
+    public:
+        PooledPortMessageServer( const MessageServer::Options& opts, MessageHandler * handler ) :
+            PortMessageServer( opts, handler ),
+            _workers( opts.workerThreads ),
+            _epfd( epoll_create( 1024 ) ) {
+            if ( _epfd < 0 ) {
+                log() << "epoll_create failed: " << errnoWithDescription() << endl;
+                fassertFailed( 16983 );
+            }
+            boost::thread poller( boost::bind( &PooledPortMessageServer::pollLoop, this ) );
+        }
+
+        virtual void acceptedMP(MessagingPort * p) {
+            if ( ! Listener::globalTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << Listener::globalTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            Connection* c = new Connection( p );
+            _workers.schedule( &PooledPortMessageServer::connect, this, c );
+        }
+
+    private:
+        struct Connection : boost::noncopyable {
+            explicit Connection( MessagingPort* p ) :
+                port( p ), le( 0 ), state( 0 ), registered( false ) {}
+            ~Connection() { delete state; }
+
+            scoped_ptr<MessagingPort> port;
+            LastError* le;                              // owned while detached
+            MessageHandler::ConnectionState* state;     // owned while detached, else NULL
+            string otherSide;
+            bool registered;                                  // added to the epoll set yet
+        };
+
+        void connect( Connection* c ) {
+            c->port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+            c->le = new LastError();
+            lastError.reset( c->le );
+            try {
+                c->otherSide = c->port->psock->remoteString();
+                _handler->connected( c->port.get() );
+            }
+            catch ( const DBException& e ) {
+                log() << "DBException setting up client connection, closing: " << e << endl;
+                c->port->shutdown();
+                lastError.reset( 0 );
+                delete c;
+                Listener::globalTicketHolder.release();
+                return;
+            }
+            park( c );
+        }
+
+        /** runs on a worker once the poller has seen c become readable */
+        void service( Connection* c ) {
+            attach( c );
+
+            bool keep = false;
+            try {
+                // the port may have read the start of the next request along with this one,
+                // epoll won't report those bytes so they have to be served before parking
+                bool received;
+                do {
+                    keep = false;
+                    Message m;
+                    c->port->psock->clearCounters();
+                    received = ! inShutdown() && c->port->recv( m );
+                    if ( received ) {
+                        _handler->process( m , c->port.get() , c->le );
+                        networkCounter.hit( c->port->psock->getBytesIn() , c->port->psock->getBytesOut() );
+                        keep = true;
+                    }
+                } while ( keep && c->port->hasBufferedInput() );
+
+                if ( ! received ) {
+                    if( !cmdLine.quiet ){
+                        int conns = Listener::globalTicketHolder.used()-1;
+                        const char* word = (conns == 1 ? " connection" : " connections");
+                        log() << "end connection " << c->otherSide << " (" << conns << word << " now open)" << endl;
+                    }
+                    c->port->shutdown();
+                }
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException handling request, closing client connection: " << e << endl;
+                c->port->shutdown();
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException handling request, closing client connection: " << e << endl;
+                c->port->shutdown();
+            }
+            catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+                log() << "DBException handling request, closing client connection: " << e << endl;
+                c->port->shutdown();
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            catch ( ... ) {
+                error() << "Uncaught exception, terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+
+            if ( keep )
+                park( c );
+            else
+                close( c );
+        }
+
+        void attach( Connection* c ) {
+            lastError.reset( c->le );
+            MessageHandler::ConnectionState* state = c->state;
+            c->state = 0;
+            _handler->attachConnection( c->port.get() , state );
+        }
+
+        /** detaches c from this worker and waits for it to become readable again */
+        void park( Connection* c ) {
+            c->state = _handler->detachConnection( c->port.get() );
+            verify( c->state );
+            lastError.release();
+            setThreadName( "connworker" );
+
+            epoll_event ev;
+            memset( &ev, 0, sizeof(ev) );
+            ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+            ev.data.ptr = c;
+            int op = c->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+            c->registered = true;
+            if ( epoll_ctl( _epfd, op, c->port->psock->rawFD(), &ev ) != 0 ) {
+                log() << "epoll_ctl failed, closing client connection " << c->otherSide << ": "
+                      << errnoWithDescription() << endl;
+                attach( c );
+                c->port->shutdown();
+                close( c );
+            }
+        }
+
+        /** c must be attached to this thread */
+        void close( Connection* c ) {
+            _handler->disconnected( c->port.get() );
+            c->state = _handler->detachConnection( c->port.get() );
+            lastError.reset( 0 ); // deletes c->le
+#ifdef MONGO_SSL
+            SSLManagerInterface* manager = getSSLManager();
+            if (manager)
+                manager->cleanupThreadLocals();
+#endif
+            setThreadName( "connworker" );
+            delete c; // closing the socket also removes it from the epoll set
+            Listener::globalTicketHolder.release();
+        }
+
+        void pollLoop() {
+            setThreadName( "connpoller" );
+            const int maxEvents = 256;
+            epoll_event events[maxEvents];
+            while ( ! inShutdown() ) {
+                int n = epoll_wait( _epfd, events, maxEvents, 1000 );
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    log() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                    fassertFailed( 16984 );
+                }
+                for ( int i = 0; i < n; i++ ) {
+                    Connection* c = static_cast<Connection*>( events[i].data.ptr );
+                    _workers.schedule( &PooledPortMessageServer::service, this, c );
+                }
+            }
+        }
+
+        ThreadPool _workers;
+        const int _epfd;
+    };
+#endif
+
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+#ifdef __linux__
+        if ( opts.workerThreads > 0 ) {
+            bool usable = handler->supportsPooledService();
+#ifdef MONGO_SSL
+            // openssl may buffer data we have read off the socket, so readiness reported by
+            // epoll can't be relied upon
+            usable = usable && getSSLManager() == NULL;
+#endif
+            if ( usable )
+                return new PooledPortMessageServer( opts , handler );
+            warning() << "pooled network service not supported in this configuration, "
+                      << "using a thread per connection" << endl;
+        }
+#endif
         return new PortMessageServer( opts , handler );
     }
 
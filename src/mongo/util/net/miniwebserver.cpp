@@ -25,9 +25,12 @@
 
 namespace mongo {
 
-    MiniWebServer::MiniWebServer(const string& name, const string &ip, int port)
-        : Listener(name, ip, port, false)
-    {}
+    MiniWebServer::MiniWebServer(const string& name, const string &ip, int port,
+                                 int workerThreads)
+        : Listener(name, ip, port, false) {
+        if ( workerThreads > 0 )
+            _workers.reset( new ThreadPool( workerThreads ) );
+    }
 
     string MiniWebServer::parseURL( const char * buf ) {
         const char * urlStart = strchr( buf , ' ' );
@@ -111,6 +114,13 @@ namespace mongo {
     }
 
     void MiniWebServer::accepted(boost::shared_ptr<Socket> psock, long long connectionId ) {
+        if ( _workers )
+            _workers->schedule( &MiniWebServer::serve, this, psock );
+        else
+            serve( psock );
+    }
+
+    void MiniWebServer::serve(boost::shared_ptr<Socket> psock) {
         char buf[4096];
         int len = 0;
         try {
@@ -19,7 +19,10 @@
 
 #include "mongo/pch.h"
 
+#include <boost/scoped_ptr.hpp>
+
 #include "mongo/db/jsobj.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/net/message_port.h"
@@ -28,7 +31,12 @@ namespace mongo {
 
     class MiniWebServer : public Listener {
     public:
-        MiniWebServer(const string& name, const string &ip, int _port);
+        /**
+         * With 'workerThreads' > 0, requests are served by a pool of that many threads, so a slow
+         * page doesn't hold up the rest.  Otherwise they're served one at a time on the thread
+         * that listens, and doRequest() needn't be thread safe.
+         */
+        MiniWebServer(const string& name, const string &ip, int _port, int workerThreads = 0);
         virtual ~MiniWebServer() {}
 
         virtual void doRequest(
@@ -55,7 +63,10 @@ namespace mongo {
 
     private:
         void accepted(boost::shared_ptr<Socket> psocket, long long connectionId );
+        void serve(boost::shared_ptr<Socket> psocket);
         static bool fullReceive( const char *buf );
+
+        boost::scoped_ptr<ThreadPool> _workers;
     };
 
 } // namespace mongo
@@ -38,6 +38,7 @@
 #include "mongo/util/net/ssl_manager.h"
 #endif
 
+#include "mongo/db/server_parameters.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/value.h"
 #include "mongo/util/fail_point_service.h"
@@ -48,6 +49,10 @@
 namespace mongo {
     MONGO_FP_DECLARE(throwSockExcep);
 
+    // when positive, SO_BUSY_POLL for new connections: microseconds a blocking read spins on
+    // the device queue before sleeping, trading cpu for latency on small requests (linux only)
+    MONGO_EXPORT_SERVER_PARAMETER(netBusyPollMicros, int, 0);
+
     static bool ipv6 = false;
     void enableIPv6(bool state) { ipv6 = state; }
     bool IPv6Enabled() { return ipv6; }
@@ -123,6 +128,16 @@ namespace mongo {
 #  endif
 #endif
 
+#ifdef __linux__
+#  ifndef SO_BUSY_POLL
+#    define SO_BUSY_POLL 46
+#  endif
+        x = netBusyPollMicros;
+        if ( x > 0 && setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, (char *) &x, sizeof(x)) ) {
+            LOG(1) << "can't set SO_BUSY_POLL: " << errnoWithDescription() << endl;
+        }
+#endif
+
     }
 
 #endif
@@ -656,8 +671,13 @@ namespace mongo {
     }
 
     void Socket::recv( char * buf , int len ) {
+        recvAtLeast( buf, len, len );
+    }
+
+    int Socket::recvAtLeast( char * buf , int len , int max ) {
         int retries = 0;
-        while( len > 0 ) {
+        int got = 0;
+        while( got < len ) {
             int ret = -1;
             if (MONGO_FAIL_POINT(throwSockExcep)) {
 #if defined(_WIN32)
@@ -667,21 +687,21 @@ namespace mongo {
 #endif
             }
             else {
-                ret = unsafe_recv(buf, len);
+                ret = unsafe_recv(buf + got, max - got);
             }
             if (ret <= 0) {
-                _handleRecvError(ret, len, &retries);
+                _handleRecvError(ret, len - got, &retries);
                 continue;
             }
 
-            if ( len <= 4 && ret != len ) {
+            if ( len <= 4 && got + ret < len ) {
                 LOG(_logLevel) << "Socket recv() got " << ret <<
                     " bytes wanted len=" << len << endl;
             }
-            fassert(16508, ret <= len);
-            len -= ret;
-            buf += ret;
+            fassert(16508, ret <= max - got);
+            got += ret;
         }
+        return got;
     }
 
     int Socket::unsafe_recv( char *buf, int max ) {
@@ -207,6 +207,12 @@ namespace mongo {
 
         // recv len or throw SocketException
         void recv( char * data , int len );
+
+        /**
+         * Like recv(), but takes whatever else has already arrived too, up to 'max' bytes.
+         * @return the number of bytes read, at least 'len'
+         */
+        int recvAtLeast( char * data , int len , int max );
         int unsafe_recv( char *buf, int max );
         
         logger::LogSeverity getLogLevel() const { return _logLevel; }
@@ -218,6 +224,9 @@ namespace mongo {
 
         SockAddr localAddr() const { return _local; }
 
+        /** the underlying descriptor, for registering with a poller.  do not read or write it */
+        int rawFD() const { return _fd; }
+
         void clearCounters() { _bytesIn = 0; _bytesOut = 0; }
         long long getBytesIn() const { return _bytesIn; }
         long long getBytesOut() const { return _bytesOut; }
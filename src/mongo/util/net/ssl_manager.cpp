@@ -21,12 +21,15 @@
 
 #include <boost/thread/recursive_mutex.hpp>
 #include <boost/thread/tss.hpp>
+#include <map>
 #include <string>
 #include <vector>
 
 #include "mongo/base/init.h"
 #include "mongo/bson/util/atomic_int.h"
 #include "mongo/db/cmdline.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/concurrency/mutex.h"
 #include "mongo/util/mongoutils/str.h"
 #include "mongo/util/net/sock.h"
@@ -115,6 +118,18 @@ namespace mongo {
 
         ////////////////////////////////////////////////////////////////
 
+        // AES-GCM suites first: they are authenticated, and OpenSSL runs them on AES-NI and
+        // PCLMULQDQ where the CPU has them, which makes bulk encryption far cheaper than
+        // CBC with a separate MAC.  Everything else OpenSSL allows by default follows.
+        // Builds older than OpenSSL 1.0.1 don't know AESGCM and skip it.
+        const char* const kCipherList = "AESGCM:ALL:!aNULL:!eNULL:!EXPORT:!LOW";
+
+        // How long a server keeps a session, and so an ssl handshake can be resumed.
+        const long kSessionTimeoutSecs = 60 * 60;
+
+        // Bounds the client side cache of sessions by server address.
+        const size_t kMaxClientSessions = 1024;
+
         SimpleMutex sslManagerMtx("SSL Manager");
         SSLManagerInterface* theSSLManager = NULL;
 
@@ -168,6 +183,8 @@ namespace mongo {
                 return _clientSubjectName;
             }
 
+            virtual void appendStats(BSONObjBuilder* b) const;
+
             virtual int SSL_read(SSL* ssl, void* buf, int num);
 
             virtual int SSL_write(SSL* ssl, const void* buf, int num);
@@ -191,6 +208,37 @@ namespace mongo {
             std::string _serverSubjectName;
             std::string _clientSubjectName;
 
+            // Sessions from the last handshake with each server, by peer address, so the
+            // next connection to it can resume instead of doing the full key exchange.
+            typedef std::map<std::string, SSL_SESSION*> SessionMap;
+            mutable SimpleMutex _clientSessionsMutex;
+            SessionMap _clientSessions;
+
+            AtomicInt64 _acceptCount;
+            AtomicInt64 _acceptResumedCount;
+            AtomicInt64 _connectCount;
+            AtomicInt64 _connectResumedCount;
+            AtomicInt64 _handshakeMicros;
+            AtomicInt64 _bytesRead;
+            AtomicInt64 _bytesWritten;
+
+            /**
+             * @return the key for 'fd's peer in _clientSessions, empty if it isn't known.
+             */
+            static std::string _peerKey(int fd);
+
+            /**
+             * Hands 'ssl' the session last used with 'peer', if any.
+             */
+            void _useCachedSession(SSL* ssl, const std::string& peer);
+
+            /**
+             * Remembers the session 'ssl' just negotiated with 'peer'.
+             */
+            void _cacheSession(SSL* ssl, const std::string& peer);
+
+            void _forgetSession(const std::string& peer);
+
             /**
              * creates an SSL object to be used for this file descriptor.
              * caller must SSL_free it.
@@ -310,7 +358,8 @@ namespace mongo {
 
     SSLManager::SSLManager(const Params& params, bool isServer) :
         _validateCertificates(false),
-        _weakValidation(params.weakCertificateValidation) {
+        _weakValidation(params.weakCertificateValidation),
+        _clientSessionsMutex("SSL client sessions") {
 
         SSL_library_init();
         SSL_load_error_strings();
@@ -330,6 +379,9 @@ namespace mongo {
         if (!_initSSLContext(&_clientContext, params)) {
             uasserted(16768, "ssl initialization problem"); 
         }
+        // Sessions to reuse are kept in _clientSessions, by server; OpenSSL's own client
+        // cache is keyed by session id, which is no help in finding one for a server.
+        SSL_CTX_set_session_cache_mode(_clientContext, SSL_SESS_CACHE_OFF);
 
         // SSL client specific initialization
         if (!isServer) {
@@ -346,6 +398,11 @@ namespace mongo {
             if (!_initSSLContext(&_serverContext, params)) {
                 uasserted(16562, "ssl initialization problem"); 
             }
+            // Clients resume either by session id, from this cache, or with a session
+            // ticket, which OpenSSL issues by default.
+            SSL_CTX_set_session_cache_mode(_serverContext, SSL_SESS_CACHE_SERVER);
+            SSL_CTX_set_timeout(_serverContext, kSessionTimeoutSecs);
+            SSL_CTX_set_options(_serverContext, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
             if (!_setSubjectName(params.pemfile, _serverSubjectName)) {
                 uasserted(16942, "ssl initialization problem"); 
@@ -374,6 +431,9 @@ namespace mongo {
         if (NULL != _clientContext) {
             SSL_CTX_free(_clientContext);
         }
+        for (SessionMap::iterator i = _clientSessions.begin(); i != _clientSessions.end(); ++i) {
+            SSL_SESSION_free(i->second);
+        }
     }
 
     int SSLManager::password_cb(char *buf,int num, int rwflag,void *userdata) {
@@ -388,11 +448,17 @@ namespace mongo {
     }
 
     int SSLManager::SSL_read(SSL* ssl, void* buf, int num) {
-        return ::SSL_read(ssl, buf, num);
+        int ret = ::SSL_read(ssl, buf, num);
+        if (ret > 0)
+            _bytesRead.fetchAndAdd(ret);
+        return ret;
     }
 
     int SSLManager::SSL_write(SSL* ssl, const void* buf, int num) {
-        return ::SSL_write(ssl, buf, num);
+        int ret = ::SSL_write(ssl, buf, num);
+        if (ret > 0)
+            _bytesWritten.fetchAndAdd(ret);
+        return ret;
     }
 
     unsigned long SSLManager::ERR_get_error() {
@@ -441,6 +507,11 @@ namespace mongo {
         // Note: this is for blocking sockets only.
         SSL_CTX_set_mode(*context, SSL_MODE_AUTO_RETRY);
 
+        if (!SSL_CTX_set_cipher_list(*context, kCipherList)) {
+            warning() << "failed to set preferred SSL ciphers, using OpenSSL's defaults: " <<
+                _getSSLErrorMessage(ERR_get_error()) << endl;
+        }
+
         // Set context within which session can be reused
         int status = SSL_CTX_set_session_id_context(
             *context,
@@ -617,9 +688,23 @@ namespace mongo {
     SSL* SSLManager::connect(int fd) {
         SSL* ssl = _secure(_clientContext, fd);
         ScopeGuard guard = MakeGuard(::SSL_free, ssl);
+        const std::string peer = _peerKey(fd);
+        _useCachedSession(ssl, peer);
+
+        const unsigned long long start = curTimeMicros64();
         int ret = _ssl_connect(ssl);
-        if (ret != 1)
+        if (ret != 1) {
+            // the cached session may be what the server rejected
+            _forgetSession(peer);
             _handleSSLError(SSL_get_error(ssl, ret));
+        }
+        _handshakeMicros.fetchAndAdd(curTimeMicros64() - start);
+        _connectCount.fetchAndAdd(1);
+        if (SSL_session_reused(ssl))
+            _connectResumedCount.fetchAndAdd(1);
+        else
+            _cacheSession(ssl, peer);
+
         guard.Dismiss();
         return ssl;
     }
@@ -627,13 +712,87 @@ namespace mongo {
     SSL* SSLManager::accept(int fd) {
         SSL* ssl = _secure(_serverContext, fd);
         ScopeGuard guard = MakeGuard(::SSL_free, ssl);
+
+        const unsigned long long start = curTimeMicros64();
         int ret = SSL_accept(ssl);
         if (ret != 1)
             _handleSSLError(SSL_get_error(ssl, ret));
+        _handshakeMicros.fetchAndAdd(curTimeMicros64() - start);
+        _acceptCount.fetchAndAdd(1);
+        if (SSL_session_reused(ssl))
+            _acceptResumedCount.fetchAndAdd(1);
+
         guard.Dismiss();
         return ssl;
     }
 
+    std::string SSLManager::_peerKey(int fd) {
+        sockaddr_storage addr;
+        socklen_t len = sizeof(addr);
+        if (getpeername(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+            return "";
+        return std::string(reinterpret_cast<const char*>(&addr), len);
+    }
+
+    void SSLManager::_useCachedSession(SSL* ssl, const std::string& peer) {
+        if (peer.empty())
+            return;
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::const_iterator i = _clientSessions.find(peer);
+        if (i != _clientSessions.end())
+            SSL_set_session(ssl, i->second);
+    }
+
+    void SSLManager::_cacheSession(SSL* ssl, const std::string& peer) {
+        if (peer.empty())
+            return;
+        SSL_SESSION* session = SSL_get1_session(ssl);
+        if (NULL == session)
+            return;
+
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::iterator i = _clientSessions.find(peer);
+        if (i != _clientSessions.end()) {
+            SSL_SESSION_free(i->second);
+            i->second = session;
+            return;
+        }
+        if (_clientSessions.size() >= kMaxClientSessions) {
+            SSL_SESSION_free(_clientSessions.begin()->second);
+            _clientSessions.erase(_clientSessions.begin());
+        }
+        _clientSessions[peer] = session;
+    }
+
+    void SSLManager::_forgetSession(const std::string& peer) {
+        SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+        SessionMap::iterator i = _clientSessions.find(peer);
+        if (i != _clientSessions.end()) {
+            SSL_SESSION_free(i->second);
+            _clientSessions.erase(i);
+        }
+    }
+
+    void SSLManager::appendStats(BSONObjBuilder* b) const {
+        b->appendNumber("accepted", _acceptCount.load());
+        b->appendNumber("acceptedResumed", _acceptResumedCount.load());
+        b->appendNumber("connected", _connectCount.load());
+        b->appendNumber("connectedResumed", _connectResumedCount.load());
+        b->appendNumber("handshakeMicros", _handshakeMicros.load());
+        b->appendNumber("bytesRead", _bytesRead.load());
+        b->appendNumber("bytesWritten", _bytesWritten.load());
+        if (NULL != _serverContext) {
+            b->appendNumber("serverSessionsCached",
+                            static_cast<long long>(SSL_CTX_sess_number(_serverContext)));
+        }
+        {
+            SimpleMutex::scoped_lock lk(_clientSessionsMutex);
+            b->appendNumber("clientSessionsCached",
+                            static_cast<long long>(_clientSessions.size()));
+        }
+        b->append("cipherPreference", kCipherList);
+    }
+
     std::string SSLManager::validatePeerCertificate(const SSL* ssl) {
         if (!_validateCertificates) return "";
 
@@ -25,6 +25,8 @@
 #include <openssl/ssl.h>
 
 namespace mongo {
+    class BSONObjBuilder;
+
     class SSLManagerInterface {
     public:
         virtual ~SSLManagerInterface();
@@ -69,6 +71,11 @@ namespace mongo {
          */
         virtual std::string getClientSubjectName() = 0;
 
+        /**
+         * Appends handshake and traffic counters, for serverStatus.
+         */
+        virtual void appendStats(BSONObjBuilder* b) const = 0;
+
         /**
          * ssl.h shims
          */
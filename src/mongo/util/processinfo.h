@@ -99,6 +99,24 @@ namespace mongo {
 
         bool supported();
 
+        /**
+         * @return the number of NUMA nodes, 1 if there is no NUMA or the platform doesn't say
+         */
+        static int getNumNumaNodes();
+
+        /**
+         * Restricts the calling thread to the CPUs of NUMA node 'node', so the memory it first
+         * touches is allocated on that node.
+         * @return false if that isn't supported or failed
+         */
+        static bool bindCurrentThreadToNumaNode( int node );
+
+        /**
+         * @return bytes of memory, system wide, modified and not yet written back to disk, or
+         *     -1 if the platform doesn't say
+         */
+        static long long getSystemDirtyBytes();
+
         static bool blockCheckSupported();
 
         static bool blockInMemory(const void* start);
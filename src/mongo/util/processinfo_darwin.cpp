@@ -181,6 +181,18 @@ namespace mongo {
         return false;
     }
 
+    int ProcessInfo::getNumNumaNodes() {
+        return 1;
+    }
+
+    bool ProcessInfo::bindCurrentThreadToNumaNode( int node ) {
+        return false;
+    }
+
+    long long ProcessInfo::getSystemDirtyBytes() {
+        return -1;
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
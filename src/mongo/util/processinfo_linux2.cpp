@@ -16,6 +16,7 @@
  */
 
 #include <malloc.h>
+#include <sched.h>
 #include <iostream>
 #include <stdio.h>
 #include <unistd.h>
@@ -215,6 +216,32 @@ namespace mongo {
             return fstr;
         }
 
+        static string numaNodePath( int node, const char* file ) {
+            stringstream ss;
+            ss << "/sys/devices/system/node/node" << node << '/' << file;
+            return ss.str();
+        }
+
+        /**
+        * Get the total and free memory of a NUMA node, from lines like
+        * "Node 0 MemTotal:       32852388 kB"
+        */
+        static void getNumaNodeMemInfo( int node, long long* totalKB, long long* freeKB ) {
+            FILE* f = fopen( numaNodePath( node, "meminfo" ).c_str(), "r" );
+            if ( f == NULL )
+                return;
+            char line[256];
+            while ( fgets( line, sizeof( line ), f ) != NULL ) {
+                int n;
+                long long kb;
+                if ( sscanf( line, "Node %d MemTotal: %lld kB", &n, &kb ) == 2 )
+                    *totalKB = kb;
+                else if ( sscanf( line, "Node %d MemFree: %lld kB", &n, &kb ) == 2 )
+                    *freeKB = kb;
+            }
+            fclose( f );
+        }
+
         /**
         * Get some details about the CPU
         */
@@ -385,6 +412,20 @@ namespace mongo {
 
         LinuxProc p(_pid);
         info.appendNumber("page_faults", static_cast<long long>(p._maj_flt) );
+
+        const int nodes = getNumNumaNodes();
+        if ( nodes > 1 ) {
+            BSONArrayBuilder numa( info.subarrayStart( "numa_nodes" ) );
+            for ( int node = 0; node < nodes; node++ ) {
+                long long totalKB = 0;
+                long long freeKB = 0;
+                LinuxSysHelper::getNumaNodeMemInfo( node, &totalKB, &freeKB );
+                numa.append( BSON( "node" << node <<
+                                   "totalMB" << totalKB / 1024 <<
+                                   "freeMB" << freeKB / 1024 ) );
+            }
+            numa.done();
+        }
     }
 
     /**
@@ -451,6 +492,71 @@ namespace mongo {
         return false;
     }
 
+    static int countNumaNodes() {
+        int nodes = 0;
+        while ( boost::filesystem::exists( LinuxSysHelper::numaNodePath( nodes, "" ) ) )
+            nodes++;
+        return std::max( 1, nodes );
+    }
+
+    int ProcessInfo::getNumNumaNodes() {
+        static const int nodes = countNumaNodes();
+        return nodes;
+    }
+
+    bool ProcessInfo::bindCurrentThreadToNumaNode( int node ) {
+        // e.g. "0-7,32-39"
+        string cpus = LinuxSysHelper::readLineFromFile( LinuxSysHelper::numaNodePath( node, "cpulist" ).c_str() );
+        cpu_set_t set;
+        CPU_ZERO( &set );
+        bool any = false;
+        const char* p = cpus.c_str();
+        while ( *p ) {
+            char* end;
+            const long first = strtol( p, &end, 10 );
+            if ( end == p )
+                break;
+            long last = first;
+            p = end;
+            if ( *p == '-' ) {
+                last = strtol( p + 1, &end, 10 );
+                p = end;
+            }
+            for ( long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++ ) {
+                CPU_SET( cpu, &set );
+                any = true;
+            }
+            if ( *p == ',' )
+                p++;
+        }
+        if ( !any )
+            return false;
+
+        if ( sched_setaffinity( 0, sizeof( set ), &set ) ) {
+            LOG(1) << "sched_setaffinity to numa node " << node << " failed: "
+                   << errnoWithDescription() << endl;
+            return false;
+        }
+        return true;
+    }
+
+    long long ProcessInfo::getSystemDirtyBytes() {
+        FILE* f = fopen( "/proc/meminfo", "r" );
+        if ( f == NULL )
+            return -1;
+        long long dirty = -1;
+        char line[256];
+        while ( fgets( line, sizeof( line ), f ) != NULL ) {
+            long long kb;
+            if ( sscanf( line, "Dirty: %lld kB", &kb ) == 1 ) {
+                dirty = kb * 1024;
+                break;
+            }
+        }
+        fclose( f );
+        return dirty;
+    }
+
     bool ProcessInfo::blockCheckSupported() {
         return true;
     }
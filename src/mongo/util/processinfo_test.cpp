@@ -37,6 +37,17 @@ namespace mongo_test {
         }
     }
 
+    TEST(ProcessInfo, DirtyBytesUnknownOrCounted) {
+        ASSERT_GREATER_THAN_OR_EQUALS(ProcessInfo::getSystemDirtyBytes(), -1LL);
+#if defined(__linux__)
+        ASSERT_GREATER_THAN_OR_EQUALS(ProcessInfo::getSystemDirtyBytes(), 0LL);
+#endif
+    }
+
+    TEST(ProcessInfo, AtLeastOneNumaNode) {
+        ASSERT_GREATER_THAN_OR_EQUALS(ProcessInfo::getNumNumaNodes(), 1);
+    }
+
     const size_t PAGES = 10;
 
     TEST(ProcessInfo, BlockInMemoryDoesNotThrowIfSupported) {
@@ -21,6 +21,7 @@
 #include "mongo/platform/unordered_map.h"
 #include "mongo/util/string_map.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 #include "mongo/util/timer.h"
 
 namespace {
@@ -105,6 +106,8 @@ namespace {
         ASSERT_EQUALS( 5, m["eliot"] );
         m.erase( "eliot" );
         ASSERT( m.end() == m.find( "eliot" ) );
+        ASSERT_EQUALS( 0U, m.size() );
+        ASSERT( m.empty() );
         ASSERT_EQUALS( 0, m["eliot"] );
         m.erase( "eliot" );
         ASSERT( m.end() == m.find( "eliot" ) );
@@ -120,6 +123,37 @@ namespace {
         ASSERT_EQUALS( before, m.capacity() );
     }
 
+    TEST(StringMapTest, EraseChurn) {
+        // a small table, so probes wrap around and go over deleted buckets
+        StringMap<int> m;
+        std::map<string,int> expected;
+        PseudoRandom random( 17 );
+        for ( int i = 0; i < 20000; i++ ) {
+            const string key = mongoutils::str::stream() << "k" << random.nextInt32( 200 );
+            if ( random.nextInt32( 3 ) == 0 ) {
+                ASSERT_EQUALS( expected.erase( key ), m.erase( key ) );
+            }
+            else {
+                m[key] = i;
+                expected[key] = i;
+            }
+            ASSERT_EQUALS( expected.size(), m.size() );
+        }
+
+        for ( std::map<string,int>::const_iterator i = expected.begin();
+              i != expected.end(); ++i ) {
+            StringMap<int>::const_iterator found = m.find( i->first );
+            ASSERT( found != m.end() );
+            ASSERT_EQUALS( i->second, found->second );
+        }
+        size_t n = 0;
+        for ( StringMap<int>::const_iterator i = m.begin(); i != m.end(); ++i ) {
+            ASSERT_EQUALS( expected[i->first], i->second );
+            n++;
+        }
+        ASSERT_EQUALS( expected.size(), n );
+    }
+
     TEST( StringMapTest, Iterator1 ) {
         StringMap<int> m;
         ASSERT( m.begin() == m.end() );
@@ -18,68 +18,230 @@
 
 #include "mongo/util/touch_pages.h"
 
+#include <boost/bind.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <fcntl.h>
 #include <list>
 #include <string>
 
+#include "mongo/client/dbclientinterface.h"
+#include "mongo/db/btreecursor.h"
+#include "mongo/db/clientcursor.h"
 #include "mongo/db/curop.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/keypattern.h"
 #include "mongo/db/kill_current_op.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/database.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/file.h"
 #include "mongo/util/mmap.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
-    struct touch_location {
-        HANDLE fd;
-        int offset;
-        size_t length;
-        Extent *ext;
-    };
-        
-    void touchNs( const std::string& ns ) { 
-        std::vector< touch_location > ranges;
-        boost::scoped_ptr<LockMongoFilesShared> mongoFilesLock;
+
+    namespace {
+        // a piece of an extent; big extents are split so they spread over the threads
+        struct TouchChunk {
+            size_t nsNo;
+            DiskLoc extent;
+            int ofs;
+            int length;
+        };
+
+        struct TouchRange {
+            const char* start;
+            size_t length;
+        };
+
+        const int kTouchChunkBytes = 4 * 1024 * 1024;
+
+        // paged in per acquisition of the database lock
+        const long long kTouchBatchBytes = 64 * 1024 * 1024;
+
+        void touchRangesThread( const std::vector<TouchRange>* ranges, AtomicUInt32* next ) {
+            for ( unsigned i = next->fetchAndAdd( 1 ); i < ranges->size();
+                  i = next->fetchAndAdd( 1 ) ) {
+                touch_pages( (*ranges)[i].start, (*ranges)[i].length );
+            }
+        }
+
+        bool isOpen( Database* db, int fileNo ) {
+            ExtentManager& em = db->getExtentManager();
+            if ( ExtentManager::isIndexFile( fileNo ) ) {
+                const int n = fileNo - ExtentManager::kIndexFileBase;
+                return n < static_cast<int>( em.numIndexFiles() );
+            }
+            return fileNo < static_cast<int>( em.numFiles() );
+        }
+    }
+
+    void touchNs( const std::string& ns ) {
+        std::vector<std::string> namespaces;
+        namespaces.push_back( ns );
+        touchNamespaces( namespaces, 1 );
+    }
+
+    long long touchNamespaces( const std::vector<std::string>& namespaces, int nThreads ) {
+        verify( !namespaces.empty() );
+        nThreads = std::max( 1, nThreads );
+
+        std::vector<TouchChunk> chunks;
         {
-            Client::ReadContext ctx(ns);
-            NamespaceDetails *nsd = nsdetails(ns);
-            uassert( 16154, "namespace does not exist", nsd );
-
-            for( DiskLoc L = nsd->firstExtent(); !L.isNull(); L = L.ext()->xnext )  {
-                DataFile* mdf = cc().database()->getFile( L.a() );
-                massert( 16238, "can't fetch extent file structure", mdf );
-                touch_location tl;
-                tl.fd = mdf->getFd();
-                tl.offset = L.getOfs();
-                tl.ext = L.ext();
-                tl.length = tl.ext->length;
-
-                ranges.push_back(tl);
+            Client::ReadContext ctx( namespaces[0] );
+            for ( size_t i = 0; i < namespaces.size(); i++ ) {
+                NamespaceDetails *nsd = nsdetails( namespaces[i] );
+                uassert( 16154, "namespace does not exist", nsd );
+
+                for( DiskLoc L = nsd->firstExtent(); !L.isNull(); L = L.ext()->xnext )  {
+                    const int length = L.ext()->length;
+                    for ( int ofs = 0; ofs < length; ofs += kTouchChunkBytes ) {
+                        TouchChunk c;
+                        c.nsNo = i;
+                        c.extent = L;
+                        c.ofs = ofs;
+                        c.length = std::min( kTouchChunkBytes, length - ofs );
+                        chunks.push_back( c );
+                    }
+                }
             }
-            mongoFilesLock.reset(new LockMongoFilesShared());
         }
-        // DB read lock is dropped; no longer needed after this point.
 
-        std::string progress_msg = "touch " + ns + " extents";
+        std::string progress_msg = "touch " + namespaces[0] + " extents";
         ProgressMeterHolder pm(cc().curop()->setMessage(progress_msg.c_str(),
                                                         "Touch Progress",
-                                                        ranges.size()));
-        for ( std::vector< touch_location >::iterator it = ranges.begin(); it != ranges.end(); ++it ) {
-            touch_pages( it->fd, it->offset, it->length, it->ext );
-            pm.hit();
+                                                        chunks.size()));
+        long long bytes = 0;
+        size_t next = 0;
+        while ( next < chunks.size() ) {
+            const size_t batchStart = next;
+            std::vector<TouchRange> ranges;
+            boost::scoped_ptr<LockMongoFilesShared> mongoFilesLock;
+            {
+                Client::ReadContext ctx( namespaces[0] );
+                Database* db = cc().database();
+
+                // a namespace dropped since we listed its extents is skipped
+                std::vector<bool> exists( namespaces.size() );
+                for ( size_t i = 0; i < namespaces.size(); i++ ) {
+                    exists[i] = nsdetails( namespaces[i] ) != NULL;
+                }
+
+                long long batchBytes = 0;
+                for ( ; next < chunks.size() && batchBytes < kTouchBatchBytes; next++ ) {
+                    const TouchChunk& c = chunks[next];
+                    if ( !exists[c.nsNo] || !isOpen( db, c.extent.a() ) )
+                        continue;
+                    DataFile* mdf = db->getFile( c.extent.a() );
+                    massert( 16238, "can't fetch extent file structure", mdf );
+
+                    TouchRange r;
+                    r.start = reinterpret_cast<const char*>( mdf->getHeader() ) +
+                        c.extent.getOfs() + c.ofs;
+                    r.length = c.length;
+                    ranges.push_back( r );
+                    batchBytes += c.length;
+                }
+                mongoFilesLock.reset(new LockMongoFilesShared());
+            }
+            // DB read lock is dropped; the files stay mapped while we hold mongoFilesLock.
+
+            if ( nThreads == 1 || ranges.size() == 1 ) {
+                for ( size_t i = 0; i < ranges.size(); i++ ) {
+                    touch_pages( ranges[i].start, ranges[i].length );
+                }
+            }
+            else {
+                AtomicUInt32 nextRange;
+                boost::thread_group threads;
+                const size_t n = std::min( static_cast<size_t>( nThreads ), ranges.size() );
+                for ( size_t i = 0; i < n; i++ ) {
+                    threads.create_thread( boost::bind( touchRangesThread, &ranges,
+                                                        &nextRange ) );
+                }
+                threads.join_all();
+            }
+            mongoFilesLock.reset();
+
+            for ( size_t i = 0; i < ranges.size(); i++ ) {
+                bytes += ranges[i].length;
+            }
+            pm.hit( next - batchStart );
             killCurrentOp.checkForInterrupt(false);
         }
         pm.finished();
+        return bytes;
+    }
+
+    long long touchIndexRange( const std::string& ns, const std::string& indexName,
+                               const BSONObj& min, const BSONObj& max, bool touchDocuments ) {
+        Client::ReadContext ctx( ns );
+        NamespaceDetails *nsd = nsdetails( ns );
+        uassert( 16154, "namespace does not exist", nsd );
+        const int idxNo = nsd->findIndexByName( indexName.c_str() );
+        uassert( 17015, "index does not exist", idxNo >= 0 );
+        IndexDetails& idx = nsd->idx( idxNo );
+
+        KeyPattern keyPattern( idx.keyPattern() );
+        const BSONObj start = Helpers::toKeyFormat( keyPattern.extendRangeBound( min, false ) );
+        const BSONObj end = Helpers::toKeyFormat( keyPattern.extendRangeBound( max, true ) );
+
+        auto_ptr<ClientCursor> cc( new ClientCursor( QueryOption_NoCursorTimeout,
+                                                     shared_ptr<Cursor>( BtreeCursor::make(
+                                                         nsd, idx, start, end, true, 1 ) ),
+                                                     ns ) );
+        long long keys = 0;
+        while ( cc->ok() ) {
+            // if the document isn't in memory this pages it in with the lock released
+            if ( !cc->yieldSometimes( touchDocuments ? ClientCursor::WillNeed
+                                                     : ClientCursor::DontNeed ) ) {
+                // the collection or index went away
+                cc.release();
+                break;
+            }
+            if ( !cc->ok() )
+                break;
+            if ( touchDocuments )
+                cc->currLoc().rec()->touch();
+            keys++;
+            cc->advance();
+        }
+        return keys;
     }
 
     char _touch_pages_char_reader; // goes in .bss
   
     void touch_pages( HANDLE fd, int offset, size_t length, const Extent* ext ) {
+        touch_pages( reinterpret_cast<const char*>( ext ), length );
+    }
+
+    void touch_pages( const char* start, size_t length ) {
         // read first byte of every page, in order
-        const char *p = static_cast<const char *>(static_cast<const void *> (ext));
         for( size_t i = 0; i < length; i += g_minOSPageSizeBytes ) { 
-            _touch_pages_char_reader += p[i];
+            _touch_pages_char_reader += start[i];
+        }
+    }
+
+    unsigned long long touch_file_pages( File& f, unsigned long long offset,
+                                         unsigned long long length ) {
+        const unsigned long long fileLength = f.len();
+        if ( f.bad() || offset >= fileLength )
+            return 0;
+        length = std::min( length, fileLength - offset );
+
+        const unsigned chunk = 1024 * 1024;
+        std::vector<char> buf( static_cast<size_t>( std::min<unsigned long long>( length,
+                                                                                 chunk ) ) );
+        unsigned long long done = 0;
+        while ( done < length ) {
+            const unsigned n = static_cast<unsigned>( std::min<unsigned long long>( length - done,
+                                                                                   chunk ) );
+            f.read( offset + done, &buf[0], n );
+            if ( f.bad() )
+                break;
+            done += n;
         }
+        return done;
     }
 }
@@ -16,15 +16,41 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace mongo {
+    class BSONObj;
     class Extent;
+    class File;
 
     // Given a namespace, page in all pages associated with that namespace
     void touchNs( const std::string& ns );
 
+    // Page in the extents of 'namespaces', which must all be in one database, on up to
+    // 'nThreads' threads.  Extents are handed out in the order of 'namespaces', so list the
+    // ones wanted soonest first.  The database lock is held only while each batch of extents
+    // is looked up, not while it is paged in.
+    // Returns the number of bytes paged in.
+    long long touchNamespaces( const std::vector<std::string>& namespaces, int nThreads );
+
+    // Page in the buckets of index 'indexName' of 'ns' holding keys from 'min' to 'max', both
+    // inclusive and either of which may be empty or a prefix of the key pattern, and the
+    // documents they point to if 'touchDocuments'.  Yields the lock as a query would.
+    // Returns the number of keys walked.
+    long long touchIndexRange( const std::string& ns, const std::string& indexName,
+                               const BSONObj& min, const BSONObj& max, bool touchDocuments );
+
     // Touch a range of pages using an OS-specific method.
     // Takes a file descriptor, offset, and length, for Linux use.
     // Additionally takes an Extent pointer for use on other platforms.
     void touch_pages( HANDLE fd, int offset, size_t length, const Extent* ext );
+
+    // Touch the pages of a range of mapped memory, in order.
+    void touch_pages( const char* start, size_t length );
+
+    // Read a range of an open file into the OS page cache, without it having to be mapped.
+    // Stops at the end of the file or at the first failed read.
+    // Returns the number of bytes read.
+    unsigned long long touch_file_pages( File& f, unsigned long long offset,
+                                         unsigned long long length );
 }
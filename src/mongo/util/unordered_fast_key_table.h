@@ -46,16 +46,29 @@ namespace mongo {
 
     private:
         struct Entry {
-            Entry()
-                : used( false ), everUsed( false ) {
+            Entry() : curHash( 0 ) {
             }
 
-            bool used;
-            bool everUsed;
             size_t curHash;
             value_type data;
         };
 
+        /**
+         * Each bucket has a tag byte besides its Entry: kEmpty if it was never used, kDeleted
+         * if it was used but isn't, or kUsedBit and 7 bits of the hash of its key.  Probing
+         * goes over the tags kGroupSize at a time and only looks at the Entry of a bucket
+         * whose tag matches, so a lookup usually reads one tag word and one Entry.
+         *
+         * The tags are followed by a copy of the first kGroupSize of them, so a group can be
+         * read in one go even where it wraps around.
+         */
+        enum {
+            kEmpty = 0x00,
+            kDeleted = 0x01,
+            kUsedBit = 0x80,
+            kGroupSize = 8
+        };
+
         struct Area {
             Area( unsigned capacity, double maxProbeRatio );
             Area( const Area& other );
@@ -64,16 +77,29 @@ namespace mongo {
 
             bool transfer( Area* newArea, const UnorderedFastKeyTable& sm ) const;
 
+            bool isUsed( unsigned pos ) const { return _tags[pos] & kUsedBit; }
+
+            void setTag( unsigned pos, unsigned char tag ) {
+                for ( unsigned i = pos; i < _capacity + kGroupSize; i += _capacity )
+                    _tags[i] = tag;
+            }
+
+            static unsigned char usedTag( size_t hash ) {
+                return kUsedBit | ( ( static_cast<unsigned>( hash ) * 0x9E3779B1U ) >> 25 );
+            }
+
             void swap( Area* other ) {
                 using std::swap;
                 swap( _capacity, other->_capacity );
                 swap( _maxProbe, other->_maxProbe );
                 swap( _entries, other->_entries );
+                swap( _tags, other->_tags );
             }
 
             unsigned _capacity;
             unsigned _maxProbe;
             boost::scoped_array<Entry> _entries;
+            boost::scoped_array<unsigned char> _tags; // _capacity + kGroupSize of them
         };
 
     public:
@@ -157,7 +183,7 @@ namespace mongo {
 
             void _skip() {
                 while ( true ) {
-                    if ( _area->_entries[_position].used )
+                    if ( _area->isUsed( _position ) )
                         break;
                     if ( _position >= _max ) {
                         _position = -1;
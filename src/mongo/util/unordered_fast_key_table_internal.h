@@ -16,6 +16,9 @@
  *    limitations under the License.
  */
 
+#include <cstring>
+
+#include "mongo/platform/cstdint.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -24,17 +27,21 @@ namespace mongo {
                                                                    double maxProbeRatio)
         : _capacity( capacity ),
           _maxProbe( static_cast<unsigned>( capacity * maxProbeRatio ) ),
-          _entries( new Entry[_capacity] ) {
+          _entries( new Entry[_capacity] ),
+          _tags( new unsigned char[_capacity + kGroupSize] ) {
+        memset( _tags.get(), kEmpty, _capacity + kGroupSize );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
     inline UnorderedFastKeyTable<K_L, K_S, V, H, E, C, C_LS>::Area::Area(const Area& other )
         : _capacity( other._capacity ),
           _maxProbe( other._maxProbe ),
-          _entries( new Entry[_capacity] ) {
+          _entries( new Entry[_capacity] ),
+          _tags( new unsigned char[_capacity + kGroupSize] ) {
         for ( unsigned i = 0; i < _capacity; i++ ) {
             _entries[i] = other._entries[i];
         }
+        memcpy( _tags.get(), other._tags.get(), _capacity + kGroupSize );
     }
 
     template< typename K_L, typename K_S, typename V, typename H, typename E, typename C, typename C_LS >
@@ -46,32 +53,54 @@ namespace mongo {
         if ( firstEmpty )
             *firstEmpty = -1;
 
-        for ( unsigned probe = 0; probe < _maxProbe; probe++ ) {
-            unsigned pos = (hash + probe) % _capacity;
-
-            if ( ! _entries[pos].used ) {
-                // space is empty
-                if ( firstEmpty && *firstEmpty == -1 )
-                    *firstEmpty = pos;
-                if ( ! _entries[pos].everUsed )
-                    return -1;
-                continue;
-            }
-
-            if ( _entries[pos].curHash != hash ) {
-                // space has something else
-                continue;
+        const unsigned char tag = usedTag( hash );
+        const uint64_t lows = 0x0101010101010101ULL;
+        const uint64_t highs = 0x8080808080808080ULL;
+
+        for ( unsigned probe = 0; probe < _maxProbe; probe += kGroupSize ) {
+            const unsigned start = (hash + probe) % _capacity;
+            const unsigned n = std::min<unsigned>( kGroupSize, _maxProbe - probe );
+
+            if ( n == kGroupSize ) {
+                // skip the group if no tag in it is the one we want or free: x has a zero
+                // byte for each that is (and maybe some false positives)
+                uint64_t group;
+                memcpy( &group, &_tags[start], sizeof(group) );
+                const uint64_t x = group ^ ( lows * tag );
+                const bool anyMatch = ( x - lows ) & ~x & highs;
+                const bool anyFree = ~group & highs;
+                if ( !anyMatch && !anyFree )
+                    continue;
             }
 
-            if ( ! sm._equals(key, sm._convertor( _entries[pos].data.first ) ) ) {
-                // hashes match
-                // strings are not equals
-                continue;
+            for ( unsigned i = 0; i < n; i++ ) {
+                const unsigned pos = (start + i) % _capacity;
+                const unsigned char t = _tags[pos];
+
+                if ( ! ( t & kUsedBit ) ) {
+                    // space is empty
+                    if ( firstEmpty && *firstEmpty == -1 )
+                        *firstEmpty = pos;
+                    if ( t == kEmpty )
+                        return -1;
+                    continue;
+                }
+
+                if ( t != tag || _entries[pos].curHash != hash ) {
+                    // space has something else
+                    continue;
+                }
+
+                if ( ! sm._equals(key, sm._convertor( _entries[pos].data.first ) ) ) {
+                    // hashes match
+                    // strings are not equals
+                    continue;
+                }
+
+                // hashes and strings are equal
+                // yay!
+                return pos;
             }
-
-            // hashes and strings are equal
-            // yay!
-            return pos;
         }
         return -1;
     }
@@ -81,7 +110,7 @@ namespace mongo {
             Area* newArea,
             const UnorderedFastKeyTable& sm) const {
         for ( unsigned i = 0; i < _capacity; i++ ) {
-            if ( ! _entries[i].used )
+            if ( ! isUsed( i ) )
                 continue;
 
             int firstEmpty = -1;
@@ -96,6 +125,7 @@ namespace mongo {
             }
 
             newArea->_entries[firstEmpty] = _entries[i];
+            newArea->setTag( firstEmpty, _tags[i] );
         }
         return true;
     }
@@ -143,8 +173,7 @@ namespace mongo {
             // need to add
             if ( firstEmpty >= 0 ) {
                 _size++;
-                _area._entries[firstEmpty].used = true;
-                _area._entries[firstEmpty].everUsed = true;
+                _area.setTag( firstEmpty, Area::usedTag( hash ) );
                 _area._entries[firstEmpty].curHash = hash;
                 _area._entries[firstEmpty].data.first = _convertorOther(key);
                 return _area._entries[firstEmpty].data.second;
@@ -165,7 +194,8 @@ namespace mongo {
         if ( pos < 0 )
             return 0;
 
-        _area._entries[pos].used = false;
+        --_size;
+        _area.setTag( pos, kDeleted );
         _area._entries[pos].data.second = V();
         return 1;
     }